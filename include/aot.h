@@ -0,0 +1,113 @@
+/**
+ * Hyper Programming Language - Ahead-of-Time Native Builds
+ *
+ * Drives the native build path: Hyper source is transpiled to C, compiled
+ * with the system C compiler against the static runtime library, and the
+ * resulting executable is cached by a hash of everything that affects it.
+ * Both hypc (--native) and hyprun (--aot) build on this module.
+ */
+
+#ifndef HYP_AOT_H
+#define HYP_AOT_H
+
+#include "hyp_common.h"
+
+/* Binaries are cached under the per-user cache directory
+ * (hyp_user_cache_dir), or HYP_CACHE_DIR; the fallback, relative to the
+ * working directory, is only used when no home directory is known */
+#define HYP_AOT_CACHE_NAME "aot"
+#define HYP_AOT_DEFAULT_CACHE_DIR ".hypkg/cache/aot"
+#define HYP_AOT_DEFAULT_CC "cc"
+#define HYP_AOT_DEFAULT_CFLAGS "-O2"
+
+/* Executable suffix for the host platform */
+#ifdef _WIN32
+    #define HYP_AOT_EXE_SUFFIX ".exe"
+#else
+    #define HYP_AOT_EXE_SUFFIX ""
+#endif
+
+/* Name of the static runtime library linked into native binaries */
+#define HYP_AOT_RUNTIME_LIB "hyprt"
+
+/* AOT build context */
+typedef struct {
+    const char* cc;              /* C compiler command */
+    const char* cflags;          /* Extra compiler flags */
+    const char* cache_dir;       /* Where binaries are cached */
+    const char* include_dir;     /* Directory containing hyprt.h */
+    const char* lib_dir;         /* Directory containing the runtime library */
+    const char* profile_file;    /* Optional execution profile guiding codegen */
+    bool force;                  /* Rebuild even on a cache hit */
+    bool verbose;
+
+    /* Result of the last build */
+    bool cache_hit;
+    uint64_t key;
+
+    /* Error handling */
+    bool has_error;
+    char error_message[256];
+    char default_cache_dir[HYP_CACHE_DIR_MAX];  /* cache_dir, when it is the per-user one */
+} hyp_aot_t;
+
+/**
+ * Initialize an AOT context with defaults. Environment variables
+ * HYP_CC, HYP_CFLAGS, HYP_CACHE_DIR, HYP_INCLUDE_DIR and HYP_LIB_DIR
+ * override the built-in values.
+ * @param aot The context to initialize
+ */
+void hyp_aot_init(hyp_aot_t* aot);
+
+/**
+ * Compute the cache key for a source buffer under the current settings,
+ * including the contents of the profile file if one is set
+ * @param aot The AOT context
+ * @param source Source code
+ * @param size Source length in bytes
+ * @return 64-bit cache key
+ */
+uint64_t hyp_aot_cache_key(hyp_aot_t* aot, const char* source, size_t size);
+
+/**
+ * Compile generated C code into an executable
+ * @param aot The AOT context
+ * @param c_file Path of the C source to compile
+ * @param binary_path Path of the executable to produce
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_aot_compile_c(hyp_aot_t* aot, const char* c_file, const char* binary_path);
+
+/**
+ * Build a Hyper source file into a cached native executable
+ * @param aot The AOT context
+ * @param source_file Path of the .hxp source
+ * @param binary_path Receives the cached executable path (caller frees)
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_aot_build(hyp_aot_t* aot, const char* source_file, char** binary_path);
+
+/**
+ * Run a native executable, forwarding arguments. On POSIX systems the
+ * current process is replaced and this only returns on failure.
+ * @param binary_path Executable to run
+ * @param argc Number of program arguments
+ * @param argv Program arguments (not including the program name)
+ * @return Exit status of the program, or -1 if it could not be started
+ */
+int hyp_aot_run(const char* binary_path, int argc, char* argv[]);
+
+/**
+ * Run a native executable as a child process and wait for it, adding the
+ * collector figures it reports (see HYPRT_STATS_ENV in hyprt.h) to the
+ * metrics registry as gc.collections, gc.freed_bytes and the gc.pause
+ * histogram. For --stats, which hyp_aot_run would never get to report.
+ * @param binary_path Executable to run
+ * @param argc Number of program arguments
+ * @param argv Program arguments (not including the program name)
+ * @return Exit status of the program (128 + the signal if one killed
+ *         it), or -1 if it could not be started
+ */
+int hyp_aot_run_measured(const char* binary_path, int argc, char* argv[]);
+
+#endif /* HYP_AOT_H */
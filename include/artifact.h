@@ -0,0 +1,117 @@
+/**
+ * Hyper Programming Language - Shared Artifact Cache
+ *
+ * A content-addressed store of compiled modules that machines can share.
+ * Artifacts are keyed by a SHA-256 digest of everything that determines
+ * the output (the module source, the compiler version, the target and the
+ * code generation flags), so a hit is exactly what compiling would produce.
+ * Each stored entry starts with a line naming its key and the digest of
+ * its contents; an entry that does not match both (a damaged file, a
+ * truncated upload, something stored under the wrong name) is rejected
+ * and looked up as a miss.
+ *
+ * Two backends are supported:
+ *   - a directory, typically on a shared filesystem: /mnt/cache/hyp or
+ *     file:///mnt/cache/hyp. Artifacts are written to a unique temporary
+ *     file and renamed into place, so readers never see partial data.
+ *   - an HTTP server answering GET and PUT below a base URL:
+ *     http://cache.local:8080/hyp. 200 is a hit, 404 a miss.
+ *
+ * The cache only stores bytes; what an artifact contains is up to the
+ * caller. Lookups are safe from several threads at once, which is how
+ * builds download concurrently. A cache that stops answering is taken
+ * offline for the rest of the run (one that refuses a store is only
+ * read from) instead of failing the build.
+ */
+
+#ifndef HYP_ARTIFACT_H
+#define HYP_ARTIFACT_H
+
+#include "hyp_common.h"
+#include "transpiler.h"
+#include "hyp_thread.h"
+
+/* Environment variable naming the cache when nothing else does */
+#define HYP_ARTIFACT_ENV "HYP_ARTIFACT_CACHE"
+
+/* Seconds before an HTTP request is abandoned */
+#define HYP_ARTIFACT_TIMEOUT 10
+
+/* Largest artifact accepted from a server */
+#define HYP_ARTIFACT_MAX_SIZE ((size_t)256 * 1024 * 1024)
+
+typedef enum {
+    HYP_ARTIFACT_DIRECTORY,
+    HYP_ARTIFACT_HTTP
+} hyp_artifact_backend_t;
+
+typedef struct {
+    hyp_artifact_backend_t backend;
+    char* location;              /* Directory, or base path on the server */
+    char* host;                  /* HTTP only */
+    char* port;
+
+    /* Shared by the threads of a build */
+    hyp_mutex_t* lock;
+    bool offline;                /* Stopped answering; treat as empty */
+    bool read_only;              /* A store failed; only look up */
+    size_t hits;
+    size_t misses;
+    size_t stores;
+    size_t failures;
+    size_t rejected;             /* Entries that failed verification */
+
+    /* Error handling */
+    bool has_error;
+    char error_message[256];
+} hyp_artifact_cache_t;
+
+/**
+ * Open a cache
+ * @param cache Cache to initialize
+ * @param location Directory, file:// URL or http:// URL
+ * @return HYP_OK on success, HYP_ERROR_INVALID_ARG for unsupported URLs
+ */
+hyp_error_t hyp_artifact_cache_open(hyp_artifact_cache_t* cache, const char* location);
+
+/**
+ * Release a cache
+ * @param cache The cache
+ */
+void hyp_artifact_cache_close(hyp_artifact_cache_t* cache);
+
+/**
+ * Key for a module compiled with the given settings
+ * @param source Module source
+ * @param size Source size
+ * @param target Code generation target
+ * @param optimize Optimizations enabled
+ * @param debug Debug information enabled
+ * @param key Receives the key
+ */
+void hyp_artifact_key(const char* source, size_t size, hyp_target_t target, bool optimize, bool debug,
+                      hyp_digest_t* key);
+
+/**
+ * Fetch an artifact
+ * @param cache The cache
+ * @param key Artifact key
+ * @param data Receives the artifact (caller frees)
+ * @param size Receives its size
+ * @return HYP_OK on a hit, HYP_ERROR_NOT_FOUND on a miss (or when the
+ *         cache is offline, or the entry failed verification),
+ *         HYP_ERROR_IO if the cache failed
+ */
+hyp_error_t hyp_artifact_get(hyp_artifact_cache_t* cache, const hyp_digest_t* key, char** data, size_t* size);
+
+/**
+ * Store an artifact; concurrent stores of the same key are harmless
+ * @param cache The cache
+ * @param key Artifact key
+ * @param data Artifact bytes
+ * @param size Artifact size
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_artifact_put(hyp_artifact_cache_t* cache, const hyp_digest_t* key, const char* data, size_t size);
+
+#endif /* HYP_ARTIFACT_H */
@@ -0,0 +1,113 @@
+/**
+ * Hyper Programming Language - Binary AST Cache
+ *
+ * Parsed modules are kept on disk so that hypc, hyprun and the compiler
+ * server skip tokenizing and parsing sources they have seen before. The
+ * compact AST holds no pointers (links are offsets relative to the link
+ * itself), so an entry is the parser's slot block behind a short header
+ * and is used in place once mapped: there is nothing to decode or fix up.
+ *
+ * Entries are keyed by a hash of the source text, the compiler version
+ * and HYP_PARSER_VERSION, and live in <dir>/<key>.ast, where dir is
+ * the per-user cache directory (hyp_user_cache_dir) unless
+ * HYP_AST_CACHE names another. Sources are looked up by content, so one
+ * cache serves every project and working directory. An
+ * entry is checked before use: its header must match what this build
+ * would write (format version, node size, byte order, length), the tree
+ * must match the checksum in the header, and every link and list
+ * reachable from the root must stay inside the tree. An entry failing
+ * any check is deleted and counts as a miss, so the module is parsed
+ * again. Entries are written to a temporary file and renamed into place.
+ */
+
+#ifndef HYP_AST_CACHE_H
+#define HYP_AST_CACHE_H
+
+#include "hyp_common.h"
+#include "lexer.h"
+#include "parser.h"
+
+/* Name of the cache under the per-user cache directory */
+#define HYP_AST_CACHE_NAME "ast"
+
+/* Environment variable overriding the location; "" disables the cache */
+#define HYP_AST_CACHE_ENV "HYP_AST_CACHE"
+
+/* Cache context, shared by every module a tool loads */
+typedef struct {
+    const char* dir;             /* NULL when disabled */
+    bool force;                  /* Parse even on a hit, replacing the entry */
+    size_t jobs;                 /* Parse threads on a miss; 0 or 1 is serial */
+    hyp_out_t* messages;         /* Syntax errors go here instead of stderr, if set */
+    size_t hits;
+    size_t misses;
+    size_t stores;
+    size_t failures;             /* Entries that could not be written */
+    size_t rejected;             /* Entries that failed the checks on load */
+    char default_dir[HYP_CACHE_DIR_MAX];  /* dir, when it is the per-user one */
+} hyp_ast_cache_t;
+
+/* A module's tree, either mapped from the cache or freshly parsed */
+typedef struct {
+    hyp_ast_node_t* root;        /* Program node; read-only when cached */
+    size_t size;                 /* Bytes in the tree */
+    bool from_cache;
+    hyp_source_t file;           /* Cache entry, when loaded */
+    hyp_parser_t* parser;        /* Owner of the tree, when parsed */
+} hyp_ast_image_t;
+
+/**
+ * Initialize a cache context with the per-user location, or the one
+ * named by HYP_AST_CACHE. Without either the cache is disabled.
+ * @param cache The context to initialize
+ */
+void hyp_ast_cache_init(hyp_ast_cache_t* cache);
+
+/**
+ * Key for a source buffer under this compiler and parser version
+ * @param source Source code
+ * @param size Source length in bytes
+ * @return 64-bit key
+ */
+uint64_t hyp_ast_cache_key(const char* source, size_t size);
+
+/**
+ * Map a cached tree
+ * @param cache The cache
+ * @param key Entry key
+ * @param image Receives the tree; release with hyp_ast_image_release
+ * @return HYP_OK on a hit, HYP_ERROR_NOT_FOUND on a miss or an unusable entry
+ */
+hyp_error_t hyp_ast_cache_load(hyp_ast_cache_t* cache, uint64_t key, hyp_ast_image_t* image);
+
+/**
+ * Write a tree to the cache
+ * @param cache The cache
+ * @param key Entry key
+ * @param root Program node of a tree from hyp_parser_parse
+ * @param size Bytes in the tree (parser->tree_size)
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_ast_cache_store(hyp_ast_cache_t* cache, uint64_t key, const hyp_ast_node_t* root, size_t size);
+
+/**
+ * Tree for a source buffer: loaded from the cache when it has one,
+ * otherwise parsed with a new parser over lexer and stored. Parse errors
+ * are reported by the parser as usual.
+ * @param cache The cache, or NULL to always parse
+ * @param lexer Lexer over source, used only on a miss
+ * @param source Source code
+ * @param size Source length in bytes
+ * @param image Receives the tree; release with hyp_ast_image_release
+ * @return HYP_OK on success, HYP_ERROR_SYNTAX if the source does not parse
+ */
+hyp_error_t hyp_ast_cache_parse(hyp_ast_cache_t* cache, hyp_lexer_t* lexer,
+                                const char* source, size_t size, hyp_ast_image_t* image);
+
+/**
+ * Release a tree from hyp_ast_cache_load or hyp_ast_cache_parse
+ * @param image The tree
+ */
+void hyp_ast_image_release(hyp_ast_image_t* image);
+
+#endif /* HYP_AST_CACHE_H */
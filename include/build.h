@@ -0,0 +1,204 @@
+/**
+ * Hyper Programming Language - Project Builds
+ *
+ * Implements `hypc build`: reads the build section of a project's
+ * package.yml, expands its srcDir/include/exclude globs into a list of
+ * modules and compiles them concurrently on a pool of workers, writing
+ * one output file per module under outDir. Every module is compiled with
+ * its own lexer, parser and code generator, so workers share nothing
+ * but the (read-only) configuration.
+ *
+ * Builds are incremental. The build database (.hypkg/cache/build.db)
+ * records, for every module that compiled, a hash of its source, a hash
+ * of its interface (the top-level names it declares) and the modules it
+ * imports. A module is compiled again only if its source changed, its
+ * output is missing, or a module it imports changed its interface;
+ * everything else keeps its previous output untouched.
+ *
+ * Modules that do need compiling are first looked up in the shared
+ * artifact cache, when one is configured (build.cache in package.yml,
+ * $HYP_ARTIFACT_CACHE or --artifact-cache), and stored there once
+ * compiled. Lookups run on the build's workers, so downloads overlap.
+ */
+
+#ifndef HYP_BUILD_H
+#define HYP_BUILD_H
+
+#include "hyp_common.h"
+#include "transpiler.h"
+#include "artifact.h"
+
+#define HYP_BUILD_MANIFEST "package.yml"
+#define HYP_BUILD_DEFAULT_SRC_DIR "src"
+#define HYP_BUILD_DEFAULT_OUT_DIR "build"
+#define HYP_BUILD_DEFAULT_INCLUDE "**/*.hxp"
+#define HYP_BUILD_SOURCE_EXTENSION ".hxp"
+
+/* Build database, relative to the project root; bump the version on format changes */
+#define HYP_BUILD_DB_PATH ".hypkg/cache/build.db"
+#define HYP_BUILD_DB_MAGIC "HBUILD"
+#define HYP_BUILD_DB_VERSION 1
+
+/* Artifacts stored in the shared cache; bump the version on format changes */
+#define HYP_BUILD_ARTIFACT_MAGIC "HART"
+#define HYP_BUILD_ARTIFACT_VERSION 1
+
+/* The `build:` section of package.yml */
+typedef struct {
+    char* root;                  /* Project directory */
+    char* src_dir;               /* Relative to root */
+    char* out_dir;               /* Relative to root */
+    HYP_ARRAY(char*) include;    /* Globs over root-relative paths */
+    HYP_ARRAY(char*) exclude;
+    hyp_target_t target;         /* compiler.target */
+    bool optimize;               /* compiler.optimization other than O0 */
+    bool debug;                  /* compiler.debug */
+    char* cache;                 /* Artifact cache: directory (relative to root) or URL */
+} hyp_build_config_t;
+
+/* Build phases, timed per module */
+typedef enum {
+    HYP_BUILD_PHASE_READ,
+    HYP_BUILD_PHASE_PARSE,
+    HYP_BUILD_PHASE_CODEGEN,     /* Includes streaming the output to disk */
+    HYP_BUILD_PHASE_CACHE,       /* Artifact cache lookups and stores */
+    HYP_BUILD_PHASE_COUNT
+} hyp_build_phase_t;
+
+/* Root-relative module paths */
+typedef HYP_ARRAY(char*) hyp_build_paths_t;
+
+/* One module of the project */
+typedef struct {
+    char* source;                /* Root-relative, '/'-separated */
+    char* output;                /* Root-relative output path */
+    bool failed;
+    char* error;                 /* First error, if failed */
+    bool up_to_date;             /* Previous output reused */
+    bool from_cache;             /* Output fetched from the artifact cache */
+    size_t output_bytes;
+    double phase_time[HYP_BUILD_PHASE_COUNT];
+
+    /* Dependency information, as stored in the build database */
+    uint64_t content_hash;       /* Source text */
+    uint64_t interface_hash;     /* Top-level declarations */
+    hyp_build_paths_t imports;   /* Modules this one imports */
+
+    hyp_source_t text;           /* Source, held between checking and compiling */
+} hyp_build_unit_t;
+
+/* A module as recorded by the previous build */
+typedef struct {
+    char* source;
+    uint64_t content_hash;
+    uint64_t interface_hash;
+    size_t output_bytes;
+    hyp_build_paths_t imports;
+} hyp_build_record_t;
+
+/* Build context */
+typedef struct {
+    hyp_build_config_t config;
+    HYP_ARRAY(hyp_build_unit_t) units;
+    size_t jobs;                 /* Workers (as returned by hyp_worker_count) */
+    bool verbose;
+    bool force;                  /* Ignore the build database and compile everything */
+    const char* cache_location;  /* Overrides build.cache and $HYP_ARTIFACT_CACHE; "" disables */
+    hyp_artifact_cache_t* artifacts;    /* Open while running, NULL without a cache */
+
+    /* Previous build, sorted by source path */
+    HYP_ARRAY(hyp_build_record_t) records;
+
+    /* Results of the last run */
+    size_t failed;
+    size_t up_to_date;
+    size_t from_cache;
+    size_t cache_failures;
+    size_t cache_rejected;       /* Cached entries that failed verification */
+    double scan_time;
+    double check_time;           /* Hashing sources against the database */
+    double total_time;
+
+    /* Error handling */
+    bool has_error;
+    char error_message[256];
+} hyp_build_t;
+
+/**
+ * Load the build configuration of a project
+ * @param config Receives the configuration (defaults for anything missing)
+ * @param project Project directory, or path of its package.yml
+ * @return HYP_OK on success, HYP_ERROR_IO if the manifest cannot be read
+ */
+hyp_error_t hyp_build_config_load(hyp_build_config_t* config, const char* project);
+
+/**
+ * Free a configuration loaded with hyp_build_config_load
+ * @param config The configuration
+ */
+void hyp_build_config_destroy(hyp_build_config_t* config);
+
+/**
+ * Match a '/'-separated path against a glob. '*' and '?' stay within one
+ * path component, '**' spans any number of components.
+ * @param pattern Glob pattern
+ * @param path Path to test
+ * @return true if the whole path matches
+ */
+bool hyp_glob_match(const char* pattern, const char* path);
+
+/**
+ * Initialize a build for a project
+ * @param build The build context
+ * @param project Project directory, or path of its package.yml
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_build_init(hyp_build_t* build, const char* project);
+
+/**
+ * Expand the configured globs into the list of modules, sorted by path
+ * @param build The build context
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_build_scan(hyp_build_t* build);
+
+/**
+ * Compile every scanned module that is out of date, then update the
+ * build database
+ * @param build The build context
+ * @return HYP_OK if every module is up to date or compiled,
+ *         HYP_ERROR_SEMANTIC otherwise
+ */
+hyp_error_t hyp_build_run(hyp_build_t* build);
+
+/**
+ * Print failed modules, files per second and per-phase timings
+ * @param build The build context
+ * @param out Destination stream
+ */
+void hyp_build_print_summary(const hyp_build_t* build, FILE* out);
+
+/**
+ * Hash of the names a module exports: its top-level functions (with
+ * arity) and variables. Importers are recompiled when this changes.
+ * @param program The AST_PROGRAM node
+ * @return 64-bit hash
+ */
+uint64_t hyp_build_interface_hash(const hyp_ast_node_t* program);
+
+/**
+ * Resolve an import path against the importing module
+ * @param importer Root-relative path of the importing module
+ * @param module Path as written in the import ("./util", "../lib/x.hxp")
+ * @return Root-relative path of the imported module (caller frees), or
+ *         NULL for package imports and paths that leave the project
+ */
+char* hyp_build_resolve_import(const char* importer, const char* module);
+
+/**
+ * Release a build context
+ * @param build The build context
+ */
+void hyp_build_destroy(hyp_build_t* build);
+
+#endif /* HYP_BUILD_H */
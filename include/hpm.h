@@ -90,6 +90,12 @@ typedef struct {
     char* auth_token;
 } hpm_config_t;
 
+/* Installed package, as recorded in the lock file */
+typedef struct {
+    hyp_version_t version;
+    char* path;          /* Where it lives under the cache directory */
+} hpm_installed_t;
+
 /* Package manager context */
 typedef struct {
     hpm_config_t config;
@@ -98,14 +104,8 @@ typedef struct {
     hyp_package_t* current_package;
     hyp_arena_t* arena;
     
-    /* Installed packages cache */
-    struct {
-        char** names;
-        hyp_version_t* versions;
-        char** paths;
-        size_t count;
-        size_t capacity;
-    } installed;
+    /* Installed packages by name (names owned), from hpm_load_lock */
+    HYP_MAP(hpm_installed_t) installed;
     
     /* Error handling */
     bool has_error;
@@ -124,6 +124,12 @@ typedef struct {
 
 /* Function declarations */
 
+/**
+ * Create a package manager context with the default configuration
+ * @return New context, or NULL on failure
+ */
+hpm_context_t* hpm_create(void);
+
 /**
  * Initialize package manager context
  * @param hpm The package manager context to initialize
@@ -202,13 +208,32 @@ int hpm_search(hpm_context_t* hpm, const char* query, hyp_registry_entry_t* resu
 hyp_error_t hpm_publish(hpm_context_t* hpm, const char* package_dir);
 
 /**
- * List installed packages
+ * List the installed packages recorded in package-lock.yml
  * @param hpm The package manager context
  * @param global Whether to list global packages
  * @return HYP_OK on success, error code on failure
  */
 hyp_error_t hpm_list(hpm_context_t* hpm, bool global);
 
+/**
+ * Load the installed packages recorded in a lock file. Lines are
+ * "name: version"; blank lines, comments and section headers such as
+ * "packages:" are skipped, and a later line for a name replaces an
+ * earlier one.
+ * @param hpm The package manager context
+ * @param lock_path Path to the lock file (NULL for package-lock.yml)
+ * @return HYP_OK on success (also when there is no lock file), error code on failure
+ */
+hyp_error_t hpm_load_lock(hpm_context_t* hpm, const char* lock_path);
+
+/**
+ * Look up an installed package
+ * @param hpm The package manager context
+ * @param package_name Name of the package
+ * @return The installed package, or NULL if it is not installed
+ */
+const hpm_installed_t* hpm_find_installed(const hpm_context_t* hpm, const char* package_name);
+
 /**
  * Show package information
  * @param hpm The package manager context
@@ -28,6 +28,8 @@ typedef struct {
     bool always_spawn;
     bool quiet;
     bool yes;            /* Auto-confirm prompts */
+    bool offline;        /* Use only what is already cached */
+    bool auto_install;   /* Download packages that are missing */
     int timeout_seconds;
     char* shell;         /* Shell to use for execution */
 } hpx_config_t;
@@ -43,20 +45,23 @@ typedef struct {
     bool is_binary;      /* True if compiled binary, false if script */
 } hpx_package_info_t;
 
+/* One run in the execution history */
+typedef struct {
+    char* package;
+    char* command;
+    int exit_code;
+} hpx_history_entry_t;
+
+#define HPX_HISTORY_LIMIT 32
+
 /* Package executor context */
 typedef struct {
     hpx_config_t config;
     hpm_context_t* hpm;  /* Package manager for downloads */
     hyp_arena_t* arena;
     
-    /* Execution history */
-    struct {
-        char** packages;
-        char** commands;
-        int* exit_codes;
-        size_t count;
-        size_t capacity;
-    } history;
+    /* Execution history, oldest first; at most HPX_HISTORY_LIMIT runs */
+    HYP_DEQUE(hpx_history_entry_t) history;
     
     /* Error handling */
     bool has_error;
@@ -85,6 +90,12 @@ typedef struct {
 
 /* Function declarations */
 
+/**
+ * Create a package executor context with the default configuration
+ * @return New context, or NULL on failure
+ */
+hpx_context_t* hpx_create(void);
+
 /**
  * Initialize package executor context
  * @param hpx The package executor context to initialize
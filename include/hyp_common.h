@@ -13,6 +13,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdarg.h>
 #include <assert.h>
 
 /* Platform detection */
@@ -29,21 +30,92 @@
     #define HYP_INLINE __inline__
     #define HYP_FORCE_INLINE __attribute__((always_inline))
     #define HYP_NORETURN __attribute__((noreturn))
+    #define HYP_THREAD_LOCAL __thread
+    #define HYP_HAVE_THREAD_LOCAL
 #elif defined(_MSC_VER)
     #define HYP_INLINE __inline
     #define HYP_FORCE_INLINE __forceinline
     #define HYP_NORETURN __declspec(noreturn)
+    #define HYP_THREAD_LOCAL __declspec(thread)
+    #define HYP_HAVE_THREAD_LOCAL
 #else
     #define HYP_INLINE inline
     #define HYP_FORCE_INLINE inline
     #define HYP_NORETURN
+    #define HYP_THREAD_LOCAL     /* Shared by all threads */
 #endif
 
+/* Memory management. Heap memory comes from one allocator for the whole
+ * process, chosen at startup (hyp_mem_init, before anything has been
+ * allocated): the C library's, a size-class slab allocator, or tracking
+ * and debug allocators over the C library's. Every allocation is charged
+ * to the subsystem named by HYP_MEM_TAG, which a source file defines
+ * before including this header; the tracking and debug allocators count
+ * bytes per subsystem (see hyp_mem_stats), as does slab when a report is
+ * asked for. */
+typedef enum {
+    HYP_MEM_OTHER = 0,
+    HYP_MEM_LEXER,
+    HYP_MEM_PARSER,
+    HYP_MEM_CODEGEN,
+    HYP_MEM_RUNTIME,
+    HYP_MEM_HPM,
+    HYP_MEM_TAG_COUNT
+} hyp_mem_tag_t;
+
+#ifndef HYP_MEM_TAG
+    #define HYP_MEM_TAG HYP_MEM_OTHER
+#endif
+
+/* Environment variables read by hyp_mem_init */
+#define HYP_ALLOCATOR_ENV "HYP_ALLOCATOR"    /* libc, slab, tracking or debug */
+#define HYP_MEM_REPORT_ENV "HYP_MEM_REPORT"  /* Set: print hyp_mem_report at exit */
+
+typedef struct {
+    const char* name;
+    bool tracked;                /* Always keeps per-subsystem counts */
+    void* (*alloc)(size_t size, hyp_mem_tag_t tag);
+    void* (*calloc)(size_t count, size_t size, hyp_mem_tag_t tag);
+    void* (*realloc)(void* ptr, size_t size, hyp_mem_tag_t tag);
+    void (*free)(void* ptr);
+} hyp_allocator_t;
+
+typedef struct {
+    size_t allocations;
+    size_t reallocs;
+    size_t frees;
+    size_t bytes;                /* Bytes asked for over the whole run */
+    size_t live;                 /* Bytes allocated and not yet freed */
+    size_t peak;                 /* Most bytes live at once */
+} hyp_mem_counts_t;
+
+typedef struct {
+    const char* allocator;
+    bool tracked;                /* False: the counts below are all zero */
+    hyp_mem_counts_t tags[HYP_MEM_TAG_COUNT];
+    hyp_mem_counts_t total;
+    size_t reserved;             /* Bytes the slab allocator holds from the system */
+} hyp_mem_stats_t;
+
+void* hyp_mem_alloc(size_t size, hyp_mem_tag_t tag);
+void* hyp_mem_calloc(size_t count, size_t size, hyp_mem_tag_t tag);
+void* hyp_mem_realloc(void* ptr, size_t size, hyp_mem_tag_t tag);
+void hyp_mem_free(void* ptr);
+
+void hyp_mem_init(void);
+void hyp_mem_thread_exit(void);           /* Hands back a finishing thread's cached blocks */
+bool hyp_mem_select(const char* name);
+void hyp_mem_set_allocator(const hyp_allocator_t* allocator);
+const hyp_allocator_t* hyp_mem_allocator(void);
+const char* hyp_mem_tag_name(hyp_mem_tag_t tag);
+void hyp_mem_stats(hyp_mem_stats_t* stats);
+void hyp_mem_report(FILE* stream);
+
 /* Memory management macros */
-#define HYP_MALLOC(size) malloc(size)
-#define HYP_CALLOC(count, size) calloc(count, size)
-#define HYP_REALLOC(ptr, size) realloc(ptr, size)
-#define HYP_FREE(ptr) do { if (ptr) { free(ptr); ptr = NULL; } } while(0)
+#define HYP_MALLOC(size) hyp_mem_alloc(size, HYP_MEM_TAG)
+#define HYP_CALLOC(count, size) hyp_mem_calloc(count, size, HYP_MEM_TAG)
+#define HYP_REALLOC(ptr, size) hyp_mem_realloc(ptr, size, HYP_MEM_TAG)
+#define HYP_FREE(ptr) do { if (ptr) { hyp_mem_free(ptr); ptr = NULL; } } while(0)
 
 /* Error handling */
 typedef enum {
@@ -94,19 +166,293 @@ typedef struct {
     (arr)->capacity = 0; \
 } while(0)
 
-/* Arena allocator for fast memory management */
-typedef struct hyp_arena {
-    char* memory;
-    size_t size;
+/* Hash map from strings to values of one type: open addressing with
+ * linear probing over a power-of-two table kept at most three-quarters
+ * full. Keys are not copied and must outlive their entries. Each slot
+ * keeps its key's hash, so probes compare hashes before strings and
+ * growing never hashes a key again; removal shifts the rest of a probe
+ * run back rather than leaving tombstones. Values live in an array
+ * parallel to the slots. The hyp_map_* functions work on the untyped
+ * index, the HYP_MAP_* macros on a whole HYP_MAP(type). */
+#define HYP_MAP_NONE ((size_t)-1)
+
+typedef struct {
+    const char* key;             /* NULL: empty slot */
+    uint64_t hash;
+} hyp_map_slot_t;
+
+typedef struct {
+    hyp_map_slot_t* slots;
+    size_t count;
+    size_t capacity;
+} hyp_map_index_t;
+
+#define HYP_MAP(type) struct { \
+    hyp_map_index_t index; \
+    type* values; \
+}
+
+size_t hyp_map_find(const hyp_map_index_t* index, const char* key);
+size_t hyp_map_insert(hyp_map_index_t* index, const char* key, bool* added);
+void* hyp_map_grow(hyp_map_index_t* index, void* values, size_t value_size, hyp_mem_tag_t tag);
+void hyp_map_erase(hyp_map_index_t* index, void* values, size_t value_size, size_t slot);
+
+/* Values array with room for one more entry; unchanged if growing fails */
+static HYP_INLINE void* hyp_map_reserve(hyp_map_index_t* index, void* values, size_t value_size, hyp_mem_tag_t tag) {
+    if ((index->count + 1) * 4 <= index->capacity * 3) return values;
+    return hyp_map_grow(index, values, value_size, tag);
+}
+
+#define HYP_MAP_INIT(map) do { \
+    (map)->index.slots = NULL; \
+    (map)->index.count = 0; \
+    (map)->index.capacity = 0; \
+    (map)->values = NULL; \
+} while(0)
+
+/* Slot of key, or HYP_MAP_NONE */
+#define HYP_MAP_FIND(map, key) hyp_map_find(&(map)->index, key)
+
+/* Slot of key, adding it with an unset value if it is new (*added, if
+ * given, says which); HYP_MAP_NONE when out of memory */
+#define HYP_MAP_SLOT(map, key, added) \
+    ((map)->values = hyp_map_reserve(&(map)->index, (map)->values, sizeof(*(map)->values), HYP_MEM_TAG), \
+     hyp_map_insert(&(map)->index, key, added))
+
+#define HYP_MAP_PUT(map, key, value) do { \
+    size_t hyp_slot_ = HYP_MAP_SLOT(map, key, NULL); \
+    if (hyp_slot_ != HYP_MAP_NONE) (map)->values[hyp_slot_] = (value); \
+} while(0)
+
+#define HYP_MAP_REMOVE(map, slot) \
+    hyp_map_erase(&(map)->index, (map)->values, sizeof(*(map)->values), slot)
+
+/* Slots run from 0 to HYP_MAP_CAPACITY; unused ones have a NULL key */
+#define HYP_MAP_COUNT(map) ((map)->index.count)
+#define HYP_MAP_CAPACITY(map) ((map)->index.capacity)
+#define HYP_MAP_KEY(map, slot) ((map)->index.slots[slot].key)
+#define HYP_MAP_VALUE(map, slot) ((map)->values[slot])
+
+#define HYP_MAP_FREE(map) do { \
+    HYP_FREE((map)->index.slots); \
+    HYP_FREE((map)->values); \
+    (map)->index.count = 0; \
+    (map)->index.capacity = 0; \
+} while(0)
+
+/* Dynamic array whose first n items are stored inline, so short lists
+ * cost no allocation. Items move to the heap when the inline room runs
+ * out. The data pointer may point into the vector itself: a vector must
+ * not be copied or moved, only initialized in place. */
+#define HYP_SMALL_VECTOR(type, n) struct { \
+    type* data; \
+    size_t count; \
+    size_t capacity; \
+    type inline_data[n]; \
+}
+
+void* hyp_small_vector_grow(void* data, void* inline_data, size_t* capacity, size_t count,
+                            size_t item_size, hyp_mem_tag_t tag);
+
+#define HYP_SMALL_VECTOR_INIT(vec) do { \
+    (vec)->data = (vec)->inline_data; \
+    (vec)->count = 0; \
+    (vec)->capacity = sizeof((vec)->inline_data) / sizeof((vec)->inline_data[0]); \
+} while(0)
+
+#define HYP_SMALL_VECTOR_PUSH(vec, item) do { \
+    if ((vec)->count >= (vec)->capacity) { \
+        (vec)->data = hyp_small_vector_grow((vec)->data, (vec)->inline_data, &(vec)->capacity, \
+                                            (vec)->count, sizeof(*(vec)->data), HYP_MEM_TAG); \
+    } \
+    if ((vec)->count < (vec)->capacity) (vec)->data[(vec)->count++] = (item); \
+} while(0)
+
+#define HYP_SMALL_VECTOR_FREE(vec) do { \
+    if ((vec)->data != (vec)->inline_data) hyp_mem_free((vec)->data); \
+    HYP_SMALL_VECTOR_INIT(vec); \
+} while(0)
+
+/* Double-ended queue: a ring buffer whose capacity is a power of two.
+ * Pushing and popping at either end is constant time; items are
+ * numbered from the front. */
+#define HYP_DEQUE(type) struct { \
+    type* data; \
+    size_t head;                 /* Position of the front item */ \
+    size_t count; \
+    size_t capacity; \
+}
+
+void* hyp_deque_grow(void* data, size_t* head, size_t count, size_t* capacity,
+                     size_t item_size, hyp_mem_tag_t tag);
+
+#define HYP_DEQUE_INIT(dq) do { \
+    (dq)->data = NULL; \
+    (dq)->head = 0; \
+    (dq)->count = 0; \
+    (dq)->capacity = 0; \
+} while(0)
+
+#define HYP_DEQUE_AT(dq, i) ((dq)->data[((dq)->head + (i)) & ((dq)->capacity - 1)])
+#define HYP_DEQUE_FRONT(dq) HYP_DEQUE_AT(dq, 0)
+#define HYP_DEQUE_BACK(dq) HYP_DEQUE_AT(dq, (dq)->count - 1)
+
+#define HYP_DEQUE_RESERVE_(dq) do { \
+    if ((dq)->count >= (dq)->capacity) { \
+        (dq)->data = hyp_deque_grow((dq)->data, &(dq)->head, (dq)->count, &(dq)->capacity, \
+                                    sizeof(*(dq)->data), HYP_MEM_TAG); \
+    } \
+} while(0)
+
+#define HYP_DEQUE_PUSH_BACK(dq, item) do { \
+    HYP_DEQUE_RESERVE_(dq); \
+    if ((dq)->count < (dq)->capacity) { \
+        HYP_DEQUE_AT(dq, (dq)->count) = (item); \
+        (dq)->count++; \
+    } \
+} while(0)
+
+#define HYP_DEQUE_PUSH_FRONT(dq, item) do { \
+    HYP_DEQUE_RESERVE_(dq); \
+    if ((dq)->count < (dq)->capacity) { \
+        (dq)->head = ((dq)->head - 1) & ((dq)->capacity - 1); \
+        (dq)->data[(dq)->head] = (item); \
+        (dq)->count++; \
+    } \
+} while(0)
+
+/* Drop the front or back item; the deque must not be empty */
+#define HYP_DEQUE_POP_FRONT(dq) do { \
+    (dq)->head = ((dq)->head + 1) & ((dq)->capacity - 1); \
+    (dq)->count--; \
+} while(0)
+
+#define HYP_DEQUE_POP_BACK(dq) do { (dq)->count--; } while(0)
+
+#define HYP_DEQUE_FREE(dq) do { \
+    HYP_FREE((dq)->data); \
+    HYP_DEQUE_INIT(dq); \
+} while(0)
+
+/* Arena allocator. Memory comes from a chain of chunks whose sizes are
+ * powers of two, each new one twice the last; allocation bumps a pointer
+ * in the current chunk and moves on down the chain when it is full.
+ * Chunks are never given back before the arena is destroyed: resetting
+ * or rewinding to a mark makes them available again, in order. Marks
+ * are rewound to last-taken first; rewinding past a mark voids it. */
+#define HYP_ARENA_ALIGN 8
+
+/* Backing for chunks (hyp_arena_create_with); both are hints, and plain
+ * heap memory is used where the system does not offer them */
+#define HYP_ARENA_HUGE_PAGES 0x01  /* Ask for huge pages on chunks of 2 MB and up */
+#define HYP_ARENA_POPULATE   0x02  /* Fault chunks in as they are created */
+
+typedef struct hyp_arena_chunk {
+    struct hyp_arena_chunk* next;
+    size_t size;                 /* Bytes of memory after the header */
     size_t used;
-    struct hyp_arena* next;
+    bool mapped;                 /* From mmap rather than the heap */
+} hyp_arena_chunk_t;
+
+typedef struct hyp_arena {
+    hyp_arena_chunk_t* first;
+    hyp_arena_chunk_t* current;  /* Allocated from; those after it are free */
+    size_t next_size;            /* Size of the next chunk made */
+    unsigned flags;              /* HYP_ARENA_* */
+    hyp_mem_tag_t tag;           /* Subsystem charged for the chunks */
 } hyp_arena_t;
 
+/* A point to rewind to */
+typedef struct {
+    hyp_arena_chunk_t* chunk;
+    size_t used;
+} hyp_arena_mark_t;
+
+typedef struct {
+    size_t used;                 /* Bytes handed out, after alignment */
+    size_t wasted;               /* Bytes left unused at the end of chunks moved past */
+    size_t reserved;             /* Bytes in all chunks */
+    size_t chunks;
+} hyp_arena_stats_t;
+
 /* Function declarations */
-hyp_arena_t* hyp_arena_create(size_t size);
+hyp_arena_t* hyp_arena_create_tagged(size_t size, unsigned flags, hyp_mem_tag_t tag);
 void hyp_arena_destroy(hyp_arena_t* arena);
 void* hyp_arena_alloc(hyp_arena_t* arena, size_t size);
+char* hyp_arena_strdup(hyp_arena_t* arena, const char* str);
 void hyp_arena_reset(hyp_arena_t* arena);
+hyp_arena_mark_t hyp_arena_mark(const hyp_arena_t* arena);
+void hyp_arena_rewind(hyp_arena_t* arena, hyp_arena_mark_t mark);
+void hyp_arena_stats(const hyp_arena_t* arena, hyp_arena_stats_t* stats);
+
+/* Arenas are charged to the subsystem that creates them */
+#define hyp_arena_create(size) hyp_arena_create_tagged(size, 0, HYP_MEM_TAG)
+#define hyp_arena_create_with(size, flags) hyp_arena_create_tagged(size, flags, HYP_MEM_TAG)
+
+/* Pool of fixed-size blocks, for small headers made and dropped in large
+ * numbers. Slabs are aligned to a cache line and carved into blocks a
+ * whole slab at a time; freed blocks go on a free list, which is used
+ * first. Block sizes are rounded up to a power of two below a cache line
+ * and to whole lines above it, so no block straddles two lines. Pools
+ * take no locks: keep one per thread. Slabs are only given back when the
+ * pool is destroyed. */
+#define HYP_CACHE_LINE 64
+#define HYP_POOL_SLAB_SIZE (16 * 1024)
+
+typedef struct hyp_pool_block {
+    struct hyp_pool_block* next;
+} hyp_pool_block_t;
+
+typedef struct hyp_pool_slab {
+    struct hyp_pool_slab* next;
+    void* memory;                /* As allocated, before alignment */
+} hyp_pool_slab_t;
+
+typedef struct {
+    size_t block_size;           /* 0 until hyp_pool_init */
+    hyp_pool_block_t* free_list;
+    hyp_pool_slab_t* slabs;
+    size_t slab_count;
+    size_t live;                 /* Blocks handed out and not yet freed */
+    size_t peak;
+    size_t allocations;
+    hyp_mem_tag_t tag;
+} hyp_pool_t;
+
+typedef struct {
+    size_t block_size;
+    size_t live;
+    size_t peak;
+    size_t allocations;
+    size_t free;                 /* Blocks in slabs and not in use */
+    size_t reserved;             /* Bytes in all slabs */
+    size_t slabs;
+} hyp_pool_stats_t;
+
+void hyp_pool_init_tagged(hyp_pool_t* pool, size_t size, hyp_mem_tag_t tag);
+void hyp_pool_destroy(hyp_pool_t* pool);
+void* hyp_pool_refill(hyp_pool_t* pool);
+void hyp_pool_stats(const hyp_pool_t* pool, hyp_pool_stats_t* stats);
+
+#define hyp_pool_init(pool, size) hyp_pool_init_tagged(pool, size, HYP_MEM_TAG)
+
+static HYP_INLINE void* hyp_pool_alloc(hyp_pool_t* pool) {
+    hyp_pool_block_t* block = pool->free_list;
+    if (!block) return hyp_pool_refill(pool);
+
+    pool->free_list = block->next;
+    pool->allocations++;
+    if (++pool->live > pool->peak) pool->peak = pool->live;
+    return block;
+}
+
+static HYP_INLINE void hyp_pool_free(hyp_pool_t* pool, void* ptr) {
+    if (!ptr) return;
+    hyp_pool_block_t* block = ptr;
+    block->next = pool->free_list;
+    pool->free_list = block;
+    pool->live--;
+}
 
 /* String functions */
 hyp_string_t hyp_string_create(const char* str);
@@ -114,10 +460,118 @@ void hyp_string_destroy(hyp_string_t* str);
 void hyp_string_append(hyp_string_t* str, const char* append);
 int hyp_string_compare(const hyp_string_t* a, const hyp_string_t* b);
 
+/* Chunked output buffer for generated code. Appends take explicit lengths
+ * and never move bytes already written. With a file descriptor attached,
+ * full chunks are written out as they fill, so memory stays bounded no
+ * matter how large the output gets. */
+#define HYP_OUT_MIN_CHUNK 4096
+#define HYP_OUT_MAX_CHUNK (256 * 1024)
+
+typedef struct hyp_out_chunk {
+    struct hyp_out_chunk* next;
+    size_t length;
+    size_t capacity;
+    char data[];
+} hyp_out_chunk_t;
+
+typedef struct {
+    hyp_out_chunk_t* head;
+    hyp_out_chunk_t* tail;
+    size_t length;               /* Total bytes emitted, including flushed ones */
+    int fd;                      /* Destination, or -1 to keep everything in memory */
+    bool failed;                 /* An allocation or write failed */
+    hyp_mem_tag_t tag;           /* Subsystem charged for the chunks */
+} hyp_out_t;
+
+void hyp_out_init_tagged(hyp_out_t* out, int fd, hyp_mem_tag_t tag);
+void hyp_out_destroy(hyp_out_t* out);
+void hyp_out_write_slow(hyp_out_t* out, const char* data, size_t size);
+void hyp_out_puts(hyp_out_t* out, const char* str);
+void hyp_out_printf(hyp_out_t* out, const char* format, ...);
+void hyp_out_vprintf(hyp_out_t* out, const char* format, va_list args);
+void hyp_out_write_uint(hyp_out_t* out, uint64_t value);
+void hyp_out_write_double(hyp_out_t* out, double value);
+void hyp_out_append(hyp_out_t* out, hyp_out_t* from);
+hyp_error_t hyp_out_flush(hyp_out_t* out);
+char* hyp_out_to_string(const hyp_out_t* out, size_t* length);
+
+/* Output is charged to the subsystem that sets it up */
+#define hyp_out_init(out, fd) hyp_out_init_tagged(out, fd, HYP_MEM_TAG)
+
+static HYP_INLINE void hyp_out_write(hyp_out_t* out, const char* data, size_t size) {
+    hyp_out_chunk_t* tail = out->tail;
+    if (tail && tail->capacity - tail->length >= size) {
+        memcpy(tail->data + tail->length, data, size);
+        tail->length += size;
+        out->length += size;
+        return;
+    }
+    hyp_out_write_slow(out, data, size);
+}
+
+static HYP_INLINE void hyp_out_putc(hyp_out_t* out, char c) {
+    hyp_out_write(out, &c, 1);
+}
+
+/* Append a string literal without measuring it at run time */
+#define HYP_OUT_LITERAL(out, text) hyp_out_write((out), ("" text), sizeof(text) - 1)
+
 /* File utilities */
 char* hyp_read_file(const char* filename, size_t* size);
+
+/* Source text for the compiler. Large regular files are mapped rather
+ * than copied; pipes, standard input ("-") and small files are read.
+ * Either way data[size] is '\0', a sentinel the lexer scans up to. */
+typedef struct {
+    const char* data;
+    size_t size;
+    void* mapping;               /* Mapped region, or NULL if data was read */
+    size_t mapping_size;
+} hyp_source_t;
+
+hyp_error_t hyp_source_load(hyp_source_t* source, const char* filename);
+void hyp_source_release(hyp_source_t* source);
 hyp_error_t hyp_write_file(const char* filename, const char* content, size_t size);
+int hyp_create_file(const char* filename);            /* Truncating write-only fd, -1 on failure */
+hyp_error_t hyp_close_file(int fd);
 bool hyp_file_exists(const char* filename);
+hyp_error_t hyp_make_directory(const char* path);
+
+/* Per-user directory for one kind of cache: $XDG_CACHE_HOME/hyper/<name>,
+ * else ~/.cache/hyper/<name>; on Windows %LOCALAPPDATA%\hyper\cache\<name>.
+ * False if no home directory is known or the path does not fit. */
+#define HYP_CACHE_DIR_MAX 1024
+bool hyp_user_cache_dir(const char* name, char* buffer, size_t size);
+
+char* hyp_strdup_tagged(const char* str, hyp_mem_tag_t tag);
+#define hyp_strdup(str) hyp_strdup_tagged(str, HYP_MEM_TAG)
+
+/* Hashing (64-bit FNV-1a, used for cache keys) */
+#define HYP_HASH_SEED 0xcbf29ce484222325ULL
+uint64_t hyp_hash_bytes(const void* data, size_t size, uint64_t seed);
+uint64_t hyp_hash_string(const char* str, uint64_t seed);
+
+/* SHA-256, for keys that must not collide even when someone tries to
+ * (shared caches); hex form is HYP_DIGEST_HEX_SIZE with the NUL */
+#define HYP_DIGEST_SIZE 32
+#define HYP_DIGEST_HEX_SIZE (HYP_DIGEST_SIZE * 2 + 1)
+
+typedef struct {
+    uint8_t bytes[HYP_DIGEST_SIZE];
+} hyp_digest_t;
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;             /* Bytes hashed so far */
+    uint8_t block[64];
+    size_t used;                 /* Bytes waiting in block */
+} hyp_sha256_t;
+
+void hyp_sha256_init(hyp_sha256_t* sha);
+void hyp_sha256_update(hyp_sha256_t* sha, const void* data, size_t size);
+void hyp_sha256_final(hyp_sha256_t* sha, hyp_digest_t* digest);
+void hyp_sha256(const void* data, size_t size, hyp_digest_t* digest);
+void hyp_digest_hex(const hyp_digest_t* digest, char* hex);
 
 /* Debug and logging */
 #ifdef DEBUG
@@ -0,0 +1,105 @@
+/**
+ * Hyper Programming Language - Metrics
+ *
+ * A process-wide registry of named counters, gauges and latency
+ * histograms. Each metric is a static hyp_metric_t defined where it is
+ * updated and registered the first time it is; names are dotted, the
+ * subsystem first ("parser.nodes"), and must be unique.
+ *
+ * Counters and histograms are sharded: a thread updates the shard it was
+ * given, a cache line or more of its own, so threads never contend for
+ * one. Readers add the shards up. Gauges hold a single value, last write
+ * winning. Histograms are log-linear: every power of two of nanoseconds
+ * is split into HYP_HISTOGRAM_STEPS equal buckets, so quantiles are
+ * within 1/HYP_HISTOGRAM_STEPS of the true value.
+ *
+ * Updates cost an atomic add on an uncontended line; keep them out of
+ * inner loops and count per file, call or phase instead.
+ */
+
+#ifndef HYP_METRICS_H
+#define HYP_METRICS_H
+
+#include "hyp_common.h"
+
+/* Shards per counter or histogram; threads beyond this share them */
+#define HYP_METRIC_SHARDS 16
+#define HYP_HISTOGRAM_STEPS 8
+
+/* Value of --stats: "text" (or none) and "json" */
+#define HYP_STATS_TEXT "text"
+#define HYP_STATS_JSON "json"
+
+typedef enum {
+    HYP_METRIC_COUNTER,
+    HYP_METRIC_GAUGE,
+    HYP_METRIC_HISTOGRAM
+} hyp_metric_kind_t;
+
+typedef struct hyp_metric {
+    const char* name;
+    const char* help;
+    hyp_metric_kind_t kind;
+
+    /* Set on first update */
+    bool registered;
+    char* shards;                /* Cache-line aligned; NULL for gauges */
+    void* memory;                /* Shards as allocated */
+    int64_t gauge;
+    struct hyp_metric* next;     /* In registration order */
+} hyp_metric_t;
+
+#define HYP_METRIC_INIT(kind, name, help) { name, help, kind, false, NULL, NULL, 0, NULL }
+#define HYP_COUNTER(name, help) HYP_METRIC_INIT(HYP_METRIC_COUNTER, name, help)
+#define HYP_GAUGE(name, help) HYP_METRIC_INIT(HYP_METRIC_GAUGE, name, help)
+#define HYP_HISTOGRAM(name, help) HYP_METRIC_INIT(HYP_METRIC_HISTOGRAM, name, help)
+
+/* Updates; each registers the metric if it is new */
+void hyp_metric_add(hyp_metric_t* counter, uint64_t count);
+void hyp_metric_set(hyp_metric_t* gauge, int64_t value);
+void hyp_metric_observe(hyp_metric_t* histogram, double seconds);
+
+/* A metric as read: counters and gauges have a value, histograms a
+ * count of observations and figures in seconds */
+typedef struct {
+    const char* name;
+    const char* help;
+    hyp_metric_kind_t kind;
+    int64_t value;
+    uint64_t count;
+    double sum;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+} hyp_metric_value_t;
+
+/**
+ * Read every registered metric, in registration order. Safe while other
+ * threads update them; each figure is current as of its own read.
+ * @param values Filled with up to capacity metrics (may be NULL if 0)
+ * @param capacity Room in values
+ * @return Number of registered metrics, which may exceed capacity
+ */
+size_t hyp_metrics_snapshot(hyp_metric_value_t* values, size_t capacity);
+
+/**
+ * Read one metric by name
+ * @return False if no metric of that name has been registered
+ */
+bool hyp_metrics_find(const char* name, hyp_metric_value_t* value);
+
+/**
+ * Write every registered metric as aligned text or as one JSON object
+ * @param json True for JSON
+ */
+void hyp_metrics_write(FILE* stream, bool json);
+
+/**
+ * Write the metrics to stderr when the process exits (--stats)
+ * @param format HYP_STATS_TEXT, HYP_STATS_JSON, or NULL for text
+ * @return False if the format is unknown
+ */
+bool hyp_metrics_report_at_exit(const char* format);
+
+#endif /* HYP_METRICS_H */
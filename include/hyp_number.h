@@ -0,0 +1,44 @@
+/**
+ * Hyper Programming Language - Number Conversion
+ *
+ * Exact conversions between decimal text and doubles, shared by the
+ * lexer, the interpreter, the transpilers and libhyprt. Parsing is
+ * correctly rounded (Eisel-Lemire, with the C library only for
+ * subnormals and the rare inputs it cannot decide); formatting gives the
+ * shortest digits that read back as the same double (Schubfach), laid
+ * out the way JavaScript prints numbers: 0.1, 1e+21, 1.5e-7, NaN.
+ *
+ * The module has no dependencies beyond the C library, so programs
+ * linked against libhyprt print numbers exactly as the compiler does.
+ */
+
+#ifndef HYP_NUMBER_H
+#define HYP_NUMBER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Longest text hyp_number_format produces, with its terminator */
+#define HYP_NUMBER_BUFFER_SIZE 32
+
+/**
+ * Parse a decimal number: an optional sign, digits with an optional
+ * fraction, and an optional exponent. Stops at the first character
+ * that cannot continue the number, like strtod (but never reads hex,
+ * infinities or NaN).
+ * @param text Text to parse; it need not be NUL-terminated
+ * @param length Bytes available
+ * @param value Receives the correctly rounded value
+ * @return Bytes consumed, or 0 if text does not start with a number
+ */
+size_t hyp_number_parse(const char* text, size_t length, double* value);
+
+/**
+ * Format a number with the fewest digits that read back exactly
+ * @param value The number
+ * @param buffer At least HYP_NUMBER_BUFFER_SIZE bytes; NUL-terminated
+ * @return Length of the text
+ */
+size_t hyp_number_format(double value, char* buffer);
+
+#endif /* HYP_NUMBER_H */
@@ -67,20 +67,25 @@ struct hyp_object {
 /* Runtime function */
 struct hyp_function {
     char* name;
-    hyp_parameter_array_t parameters;
+    const hyp_ast_list_t* parameters;  /* Inside the declaration node */
     hyp_ast_node_t* body;
     struct hyp_environment* closure;
 };
 
-/* Environment for variable scoping */
+/* Variable in an environment */
+typedef struct {
+    char* name;
+    hyp_value_t value;
+} hyp_binding_t;
+
+/* Environment for variable scoping. Most scopes declare a handful of
+ * variables, which are stored inline. */
+#define HYP_ENVIRONMENT_INLINE 4
+
 typedef struct hyp_environment {
-    struct {
-        char** names;
-        hyp_value_t* values;
-        size_t count;
-        size_t capacity;
-    } variables;
+    HYP_SMALL_VECTOR(hyp_binding_t, HYP_ENVIRONMENT_INLINE) variables;
     struct hyp_environment* parent;
+    bool captured;  /* A function closes over it or a scope inside it */
 } hyp_environment_t;
 
 /* Call frame for function calls */
@@ -113,6 +118,11 @@ typedef struct {
     size_t module_path_count;
 } hyp_runtime_config_t;
 
+/* Native function, and the handlers of one event */
+typedef hyp_value_t (*hyp_native_fn_t)(hyp_runtime_t* runtime, hyp_value_t* args, size_t arg_count);
+typedef void (*hyp_event_handler_t)(hyp_value_t data);
+typedef HYP_ARRAY(hyp_event_handler_t) hyp_event_handlers_t;
+
 /* Main runtime structure */
 struct hyp_runtime {
     hyp_runtime_config_t config;
@@ -124,6 +134,10 @@ struct hyp_runtime {
     hyp_environment_t* global_env;
     hyp_environment_t* current_env;
     
+    /* Scopes that were left while a function still closed over them;
+     * they are destroyed with the runtime */
+    HYP_ARRAY(hyp_environment_t*) captured;
+    
     /* Memory management */
     hyp_arena_t* arena;
     struct {
@@ -133,37 +147,33 @@ struct hyp_runtime {
         bool* marked;
     } gc;
     
-    /* Module system */
-    struct {
-        char** names;
-        hyp_value_t* exports;
-        size_t count;
-        size_t capacity;
-    } modules;
+    /* Module system: exports by module name (names owned) */
+    HYP_MAP(hyp_value_t) modules;
     
-    /* Built-in functions */
-    struct {
-        const char** names;
-        hyp_value_t (**functions)(hyp_runtime_t*, hyp_value_t*, size_t);
-        size_t count;
-    } builtins;
+    /* Built-in functions by name */
+    HYP_MAP(hyp_native_fn_t) builtins;
     
     /* Error handling */
     bool has_error;
     char error_message[256];
     hyp_ast_node_t* error_location;
     
+    /* Control flow: set by a return statement, cleared by the caller */
+    bool returning;
+    hyp_value_t return_value;
+    
+    /* What main returned, as a process exit status (0 unless a number) */
+    int exit_status;
+    
+    /* Execution profile being recorded, if any (see profile.h) */
+    struct hyp_profile* profile;
+    
     /* Bytecode execution (if in bytecode mode) */
     hyp_bytecode_t* bytecode;
     size_t pc;  /* Program counter */
     
-    /* Event system */
-    struct {
-        void** handlers;
-        char** event_names;
-        size_t count;
-        size_t capacity;
-    } events;
+    /* Event system: handlers by event name (names owned) */
+    HYP_MAP(hyp_event_handlers_t) events;
 };
 
 /* Function declarations */
@@ -220,6 +230,8 @@ hyp_value_t hyp_value_native_function(const char* name, hyp_value_t (*fn)(hyp_ru
 bool hyp_value_is_truthy(hyp_value_t value);
 bool hyp_value_equals(hyp_value_t a, hyp_value_t b);
 char* hyp_value_to_string(hyp_value_t value);
+hyp_value_t hyp_value_binary_op(hyp_runtime_t* runtime, hyp_binary_op_t op, hyp_value_t left, hyp_value_t right);
+hyp_value_t hyp_value_unary_op(hyp_runtime_t* runtime, hyp_unary_op_t op, hyp_value_t operand);
 void hyp_value_print(hyp_value_t value);
 void hyp_value_free(hyp_value_t value);
 
@@ -250,6 +262,7 @@ hyp_value_t hyp_stack_peek(hyp_runtime_t* runtime, size_t offset);
 
 /* Function call operations */
 hyp_value_t hyp_runtime_call_function(hyp_runtime_t* runtime, hyp_function_t* function, hyp_value_t* args, size_t arg_count);
+hyp_value_t hyp_runtime_call_global(hyp_runtime_t* runtime, const char* name, hyp_value_t* args, size_t arg_count);
 hyp_value_t hyp_runtime_call_native(hyp_runtime_t* runtime, hyp_value_t (*fn)(hyp_runtime_t*, hyp_value_t*, size_t), hyp_value_t* args, size_t arg_count);
 
 /* AST evaluation */
@@ -275,6 +288,16 @@ void hyp_gc_mark_object(hyp_runtime_t* runtime, hyp_object_t* object);
 void hyp_gc_sweep(hyp_runtime_t* runtime);
 void hyp_gc_collect(hyp_runtime_t* runtime);
 
+/* Pools behind object, environment and function headers; they belong to
+ * the calling thread */
+typedef struct {
+    hyp_pool_stats_t objects;
+    hyp_pool_stats_t environments;
+    hyp_pool_stats_t functions;
+} hyp_runtime_pool_stats_t;
+
+void hyp_runtime_pool_stats(hyp_runtime_pool_stats_t* stats);
+
 /* AST execution */
 hyp_error_t hyp_runtime_execute_ast(hyp_runtime_t* runtime, hyp_ast_node_t* ast);
 
@@ -285,7 +308,7 @@ void hyp_runtime_clear_error(hyp_runtime_t* runtime);
 
 /* Event system */
 void hyp_runtime_emit_event(hyp_runtime_t* runtime, const char* event_name, hyp_value_t data);
-void hyp_runtime_on_event(hyp_runtime_t* runtime, const char* event_name, void (*handler)(hyp_value_t));
+void hyp_runtime_on_event(hyp_runtime_t* runtime, const char* event_name, hyp_event_handler_t handler);
 
 /* Module system */
 hyp_error_t hyp_runtime_register_module(hyp_runtime_t* runtime, const char* name, hyp_value_t exports);
@@ -0,0 +1,81 @@
+/**
+ * Hyper Programming Language - Worker Threads
+ *
+ * A small portable layer over pthreads and Win32 threads. Work is handed
+ * out as indices: hyp_parallel_for runs a task for every index on a
+ * fixed set of workers, each pulling the next unclaimed index, so uneven
+ * items balance themselves. The calling thread is worker 0.
+ */
+
+#ifndef HYP_THREAD_H
+#define HYP_THREAD_H
+
+#include "hyp_common.h"
+
+/* Upper bound on workers, whatever the machine reports */
+#define HYP_MAX_WORKERS 64
+
+/* Functions one thread can have run when it exits */
+#define HYP_THREAD_EXIT_HOOKS 8
+
+/**
+ * Task run for one work item
+ * @param context Shared context passed to hyp_parallel_for
+ * @param index Item index, in [0, count)
+ * @param worker Worker running the item, in [0, workers); lets tasks keep
+ *               per-worker state without locking
+ */
+typedef void (*hyp_task_fn_t)(void* context, size_t index, size_t worker);
+
+/**
+ * Number of online processors
+ * @return Processor count, at least 1
+ */
+size_t hyp_cpu_count(void);
+
+/**
+ * Resolve a requested worker count: 0 means one per processor
+ * @param requested Requested count
+ * @return Count between 1 and HYP_MAX_WORKERS
+ */
+size_t hyp_worker_count(size_t requested);
+
+/**
+ * Run task for every index in [0, count) and wait for all of them.
+ * With one worker (or one item) everything runs on the calling thread,
+ * and if threads cannot be started the caller picks up their share.
+ * @param count Number of items
+ * @param workers Number of workers (as returned by hyp_worker_count)
+ * @param task Task to run
+ * @param context Passed to every task
+ */
+void hyp_parallel_for(size_t count, size_t workers, hyp_task_fn_t task, void* context);
+
+/**
+ * Monotonic wall-clock time, for timing parallel work (clock() would
+ * add up the CPU time of every thread)
+ * @return Seconds since an arbitrary fixed point
+ */
+double hyp_wall_time(void);
+
+/**
+ * Run fn when the calling thread exits, to release what it keeps in
+ * thread-local storage; the thread's allocator cache is handed back
+ * after the last one. Covers every thread that ends normally, not just
+ * hyp_parallel_for workers, but not the main thread, whose memory goes
+ * with the process. Registering the same function again does nothing.
+ * @param fn Function to run, on the exiting thread
+ * @return true if fn will run, false without thread-local storage or
+ *         once HYP_THREAD_EXIT_HOOKS functions are registered
+ */
+bool hyp_thread_at_exit(void (*fn)(void));
+
+/* Mutex */
+typedef struct hyp_mutex hyp_mutex_t;
+
+hyp_mutex_t* hyp_mutex_create(void);
+void hyp_mutex_lock(hyp_mutex_t* mutex);
+void hyp_mutex_unlock(hyp_mutex_t* mutex);
+void hyp_mutex_destroy(hyp_mutex_t* mutex);
+
+#endif /* HYP_THREAD_H */
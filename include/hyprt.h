@@ -0,0 +1,347 @@
+/**
+ * Hyper Programming Language - Native Runtime Library (libhyprt)
+ *
+ * Small runtime linked into natively compiled Hyper programs. Unlike
+ * hyp_runtime.h it has no dependency on the lexer, parser or interpreter:
+ * it only provides value boxing, strings, arrays, objects with shapes,
+ * a mark-sweep collector and the builtin functions. Hot paths (boxing,
+ * truthiness, numeric operators) are static inline so they compile into
+ * the generated code; everything else lives in src/hyprt/hyprt.c.
+ */
+
+#ifndef HYP_HYPRT_H
+#define HYP_HYPRT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define HYPRT_LIKELY(x) __builtin_expect(!!(x), 1)
+    #define HYPRT_UNLIKELY(x) __builtin_expect(!!(x), 0)
+    #define HYPRT_NORETURN __attribute__((noreturn))
+    #define HYPRT_HOT __attribute__((hot))
+    #define HYPRT_COLD __attribute__((cold))
+#else
+    #define HYPRT_LIKELY(x) (x)
+    #define HYPRT_UNLIKELY(x) (x)
+    #define HYPRT_NORETURN
+    #define HYPRT_HOT
+    #define HYPRT_COLD
+#endif
+
+/* Value types */
+typedef enum {
+    HYPRT_NULL,
+    HYPRT_BOOLEAN,
+    HYPRT_NUMBER,
+    HYPRT_STRING,
+    HYPRT_ARRAY,
+    HYPRT_OBJECT
+} hyprt_type_t;
+
+/* Operators handled by the generic (slow) path */
+typedef enum {
+    HYPRT_OP_ADD,
+    HYPRT_OP_SUB,
+    HYPRT_OP_MUL,
+    HYPRT_OP_DIV,
+    HYPRT_OP_MOD,
+    HYPRT_OP_LT,
+    HYPRT_OP_LE,
+    HYPRT_OP_GT,
+    HYPRT_OP_GE,
+    HYPRT_OP_POW,
+    HYPRT_OP_BITWISE_AND,
+    HYPRT_OP_BITWISE_OR,
+    HYPRT_OP_BITWISE_XOR,
+    HYPRT_OP_LEFT_SHIFT,
+    HYPRT_OP_RIGHT_SHIFT
+} hyprt_op_t;
+
+/* Header shared by every heap object */
+typedef struct hyprt_gc_header {
+    struct hyprt_gc_header* next;
+    uint8_t type;
+    uint8_t marked;
+    uint8_t pinned;              /* Literals and interned keys are never freed */
+} hyprt_gc_header_t;
+
+typedef struct hyprt_string hyprt_string_t;
+typedef struct hyprt_array hyprt_array_t;
+typedef struct hyprt_object hyprt_object_t;
+typedef struct hyprt_shape hyprt_shape_t;
+
+/* Boxed value */
+typedef struct {
+    uint8_t type;
+    union {
+        bool boolean;
+        double number;
+        hyprt_string_t* string;
+        hyprt_array_t* array;
+        hyprt_object_t* object;
+        hyprt_gc_header_t* ref;
+    } as;
+} hyprt_value_t;
+
+struct hyprt_string {
+    hyprt_gc_header_t gc;
+    size_t length;
+    uint32_t hash;
+    bool interned;
+    char data[];
+};
+
+struct hyprt_array {
+    hyprt_gc_header_t gc;
+    size_t count;
+    size_t capacity;
+    hyprt_value_t* items;
+};
+
+/* Objects store values in slots; the shape maps keys to slot indices */
+struct hyprt_object {
+    hyprt_gc_header_t gc;
+    hyprt_shape_t* shape;
+    hyprt_value_t* slots;
+    size_t capacity;
+};
+
+extern bool hyprt_gc_requested;
+
+/* Lifecycle; stack_base is the address of a local in main() */
+void hyprt_init(int argc, char* argv[], void* stack_base);
+int hyprt_shutdown(hyprt_value_t result);
+
+/* Errors are fatal in compiled code */
+HYPRT_NORETURN void hyprt_panic(const char* format, ...);
+
+/* Boxing */
+static inline hyprt_value_t hyprt_null(void) {
+    hyprt_value_t value;
+    value.type = HYPRT_NULL;
+    value.as.ref = NULL;
+    return value;
+}
+
+static inline hyprt_value_t hyprt_boolean(bool boolean) {
+    hyprt_value_t value;
+    value.type = HYPRT_BOOLEAN;
+    value.as.boolean = boolean;
+    return value;
+}
+
+static inline hyprt_value_t hyprt_number(double number) {
+    hyprt_value_t value;
+    value.type = HYPRT_NUMBER;
+    value.as.number = number;
+    return value;
+}
+
+static inline hyprt_value_t hyprt_ref(hyprt_type_t type, void* ref) {
+    hyprt_value_t value;
+    value.type = (uint8_t)type;
+    value.as.ref = (hyprt_gc_header_t*)ref;
+    return value;
+}
+
+static inline bool hyprt_truthy(hyprt_value_t value) {
+    switch (value.type) {
+        case HYPRT_NULL: return false;
+        case HYPRT_BOOLEAN: return value.as.boolean;
+        case HYPRT_NUMBER: return value.as.number != 0.0 && value.as.number == value.as.number;
+        case HYPRT_STRING: return value.as.string->length > 0;
+        default: return true;
+    }
+}
+
+/* Operators: numeric fast path inline, everything else out of line */
+hyprt_value_t hyprt_binary_slow(hyprt_op_t op, hyprt_value_t left, hyprt_value_t right);
+bool hyprt_equals(hyprt_value_t left, hyprt_value_t right);
+hyprt_value_t hyprt_unary_slow(char op, hyprt_value_t operand);
+
+#define HYPRT_BOTH_NUMBERS(a, b) ((a).type == HYPRT_NUMBER && (b).type == HYPRT_NUMBER)
+
+static inline hyprt_value_t hyprt_add(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return hyprt_number(a.as.number + b.as.number);
+    return hyprt_binary_slow(HYPRT_OP_ADD, a, b);
+}
+
+static inline hyprt_value_t hyprt_sub(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return hyprt_number(a.as.number - b.as.number);
+    return hyprt_binary_slow(HYPRT_OP_SUB, a, b);
+}
+
+static inline hyprt_value_t hyprt_mul(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return hyprt_number(a.as.number * b.as.number);
+    return hyprt_binary_slow(HYPRT_OP_MUL, a, b);
+}
+
+static inline hyprt_value_t hyprt_div(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b) && b.as.number != 0.0)) return hyprt_number(a.as.number / b.as.number);
+    return hyprt_binary_slow(HYPRT_OP_DIV, a, b);
+}
+
+static inline hyprt_value_t hyprt_mod(hyprt_value_t a, hyprt_value_t b) {
+    return hyprt_binary_slow(HYPRT_OP_MOD, a, b);
+}
+
+/* Power and the bitwise operators (on 32-bit integers) are rare enough
+ * to always go out of line */
+static inline hyprt_value_t hyprt_pow(hyprt_value_t a, hyprt_value_t b) {
+    return hyprt_binary_slow(HYPRT_OP_POW, a, b);
+}
+
+static inline hyprt_value_t hyprt_bitwise_and(hyprt_value_t a, hyprt_value_t b) {
+    return hyprt_binary_slow(HYPRT_OP_BITWISE_AND, a, b);
+}
+
+static inline hyprt_value_t hyprt_bitwise_or(hyprt_value_t a, hyprt_value_t b) {
+    return hyprt_binary_slow(HYPRT_OP_BITWISE_OR, a, b);
+}
+
+static inline hyprt_value_t hyprt_bitwise_xor(hyprt_value_t a, hyprt_value_t b) {
+    return hyprt_binary_slow(HYPRT_OP_BITWISE_XOR, a, b);
+}
+
+static inline hyprt_value_t hyprt_left_shift(hyprt_value_t a, hyprt_value_t b) {
+    return hyprt_binary_slow(HYPRT_OP_LEFT_SHIFT, a, b);
+}
+
+static inline hyprt_value_t hyprt_right_shift(hyprt_value_t a, hyprt_value_t b) {
+    return hyprt_binary_slow(HYPRT_OP_RIGHT_SHIFT, a, b);
+}
+
+static inline hyprt_value_t hyprt_lt(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return hyprt_boolean(a.as.number < b.as.number);
+    return hyprt_binary_slow(HYPRT_OP_LT, a, b);
+}
+
+static inline hyprt_value_t hyprt_le(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return hyprt_boolean(a.as.number <= b.as.number);
+    return hyprt_binary_slow(HYPRT_OP_LE, a, b);
+}
+
+static inline hyprt_value_t hyprt_gt(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return hyprt_boolean(a.as.number > b.as.number);
+    return hyprt_binary_slow(HYPRT_OP_GT, a, b);
+}
+
+static inline hyprt_value_t hyprt_ge(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return hyprt_boolean(a.as.number >= b.as.number);
+    return hyprt_binary_slow(HYPRT_OP_GE, a, b);
+}
+
+static inline hyprt_value_t hyprt_eq(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return hyprt_boolean(a.as.number == b.as.number);
+    return hyprt_boolean(hyprt_equals(a, b));
+}
+
+static inline hyprt_value_t hyprt_ne(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return hyprt_boolean(a.as.number != b.as.number);
+    return hyprt_boolean(!hyprt_equals(a, b));
+}
+
+/* Comparisons yielding a C bool, used for conditions the compiler knows
+ * are numeric so the result is never boxed */
+static inline bool hyprt_lt_bool(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return a.as.number < b.as.number;
+    return hyprt_binary_slow(HYPRT_OP_LT, a, b).as.boolean;
+}
+
+static inline bool hyprt_le_bool(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return a.as.number <= b.as.number;
+    return hyprt_binary_slow(HYPRT_OP_LE, a, b).as.boolean;
+}
+
+static inline bool hyprt_gt_bool(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return a.as.number > b.as.number;
+    return hyprt_binary_slow(HYPRT_OP_GT, a, b).as.boolean;
+}
+
+static inline bool hyprt_ge_bool(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return a.as.number >= b.as.number;
+    return hyprt_binary_slow(HYPRT_OP_GE, a, b).as.boolean;
+}
+
+static inline bool hyprt_eq_bool(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return a.as.number == b.as.number;
+    return hyprt_equals(a, b);
+}
+
+static inline bool hyprt_ne_bool(hyprt_value_t a, hyprt_value_t b) {
+    if (HYPRT_LIKELY(HYPRT_BOTH_NUMBERS(a, b))) return a.as.number != b.as.number;
+    return !hyprt_equals(a, b);
+}
+
+static inline hyprt_value_t hyprt_not(hyprt_value_t a) {
+    return hyprt_boolean(!hyprt_truthy(a));
+}
+
+static inline hyprt_value_t hyprt_negate(hyprt_value_t a) {
+    if (HYPRT_LIKELY(a.type == HYPRT_NUMBER)) return hyprt_number(-a.as.number);
+    return hyprt_unary_slow('-', a);
+}
+
+static inline hyprt_value_t hyprt_plus(hyprt_value_t a) {
+    if (HYPRT_LIKELY(a.type == HYPRT_NUMBER)) return a;
+    return hyprt_unary_slow('+', a);
+}
+
+static inline hyprt_value_t hyprt_bitwise_not(hyprt_value_t a) {
+    return hyprt_unary_slow('~', a);
+}
+
+/* The new value of x for ++x, x++, --x and x-- */
+static inline hyprt_value_t hyprt_increment(hyprt_value_t a) {
+    if (HYPRT_LIKELY(a.type == HYPRT_NUMBER)) return hyprt_number(a.as.number + 1);
+    return hyprt_unary_slow('+', a);
+}
+
+static inline hyprt_value_t hyprt_decrement(hyprt_value_t a) {
+    if (HYPRT_LIKELY(a.type == HYPRT_NUMBER)) return hyprt_number(a.as.number - 1);
+    return hyprt_unary_slow('-', a);
+}
+
+/* Strings */
+hyprt_value_t hyprt_string_new(const char* data, size_t length);
+hyprt_value_t hyprt_string_literal(const char* data, size_t length);
+hyprt_value_t hyprt_to_string(hyprt_value_t value);
+
+/* Arrays */
+hyprt_value_t hyprt_array_of(size_t count, const hyprt_value_t* items);
+void hyprt_array_push(hyprt_value_t array, hyprt_value_t value);
+
+/* Objects; keys are interned strings from hyprt_string_literal */
+hyprt_value_t hyprt_object_of(size_t count, const hyprt_value_t* keys, const hyprt_value_t* values);
+hyprt_value_t hyprt_get_member(hyprt_value_t object, hyprt_value_t key);
+hyprt_value_t hyprt_set_member(hyprt_value_t object, hyprt_value_t key, hyprt_value_t value);
+
+/* Indexing for arrays, strings and objects */
+hyprt_value_t hyprt_get_index(hyprt_value_t object, hyprt_value_t index);
+hyprt_value_t hyprt_set_index(hyprt_value_t object, hyprt_value_t index, hyprt_value_t value);
+
+/* Garbage collection: globals are registered roots, the C stack is
+ * scanned conservatively, and the heap is traced precisely. */
+void hyprt_gc_root(hyprt_value_t* slot);
+void hyprt_gc_collect(void);
+
+/* If this environment variable names a file, the collector's figures are
+ * written to it at exit, one "name value" line each: gc.collections,
+ * gc.freed_bytes, and gc.pause_ns once per collection. hyprun --stats
+ * reads them into its metrics. */
+#define HYPRT_STATS_ENV "HYPRT_STATS"
+
+/* Collection is only triggered at safepoints (function entry, loop back-edges) */
+static inline void hyprt_safepoint(void) {
+    if (HYPRT_UNLIKELY(hyprt_gc_requested)) hyprt_gc_collect();
+}
+
+/* Builtins */
+hyprt_value_t hyprt_builtin_print(const hyprt_value_t* args, size_t arg_count);
+hyprt_value_t hyprt_builtin_typeof(const hyprt_value_t* args, size_t arg_count);
+hyprt_value_t hyprt_builtin_len(const hyprt_value_t* args, size_t arg_count);
+hyprt_value_t hyprt_builtin_parse_number(const hyprt_value_t* args, size_t arg_count);
+
+#endif /* HYP_HYPRT_H */
@@ -10,6 +10,7 @@
 #define HYP_LEXER_H
 
 #include "hyp_common.h"
+#include <stddef.h>
 
 /* Token types for the Hyper language */
 typedef enum {
@@ -67,6 +68,7 @@ typedef enum {
     TOKEN_MINUS_ASSIGN,  /* -= */
     TOKEN_MUL_ASSIGN,    /* *= */
     TOKEN_DIV_ASSIGN,    /* /= */
+    TOKEN_POWER_ASSIGN,  /* **= */
     TOKEN_EQUAL,         /* == */
     TOKEN_NOT_EQUAL,     /* != */
     TOKEN_LESS,          /* < */
@@ -142,8 +144,40 @@ typedef struct {
     } value;
 } hyp_token_t;
 
-/* Token array */
-typedef HYP_ARRAY(hyp_token_t) hyp_token_array_t;
+/* Value of a literal token, kept beside the token array */
+typedef struct {
+    uint32_t token;              /* Index of the token */
+    union {
+        double number;           /* TOKEN_NUMBER */
+        const char* message;     /* TOKEN_ERROR */
+    } value;
+} hyp_token_literal_t;
+
+/* All tokens of a source as parallel arrays: 9 bytes a token instead of
+ * a hyp_token_t's 72. Token offsets are relative to a base kept per
+ * block of tokens, so an edit moves the tokens after it by moving later
+ * blocks' bases; read them with hyp_token_start. Lines and columns are
+ * found on demand with hyp_lexer_location. */
+#define HYP_TOKEN_BLOCK_SHIFT 8
+#define HYP_TOKEN_BLOCK (1u << HYP_TOKEN_BLOCK_SHIFT)
+
+typedef struct {
+    uint8_t* types;              /* hyp_token_type_t */
+    uint32_t* starts;            /* Offset of the token from its block's base */
+    uint32_t* lengths;
+    uint32_t* bases;             /* Offset each block's starts are relative to */
+    size_t count;
+    size_t capacity;
+    
+    /* Number values and error messages, in token order */
+    HYP_ARRAY(hyp_token_literal_t) literals;
+} hyp_token_array_t;
+
+/* Offset of token index in the source */
+static inline size_t hyp_token_start(const hyp_token_array_t* tokens, size_t index) {
+    /* Wraps like the subtraction that made it */
+    return (uint32_t)(tokens->bases[index >> HYP_TOKEN_BLOCK_SHIFT] + tokens->starts[index]);
+}
 
 /* Lexer state */
 typedef struct {
@@ -152,14 +186,32 @@ typedef struct {
     size_t current;
     size_t line;
     size_t column;
-    hyp_token_array_t tokens;
+    hyp_token_array_t tokens;    /* Filled by hyp_lexer_tokenize */
     hyp_arena_t* arena;  /* For memory management */
+    
+    /* Offsets where lines start, built on the first location lookup */
+    size_t first_line;
+    uint32_t* line_starts;
+    size_t line_count;
+    size_t line_cursor;          /* Line of the last lookup */
     bool has_error;
     char error_message[256];
     int jsx_depth;       /* Track JSX nesting depth */
     bool in_jsx;         /* Track if we're inside JSX */
+    bool has_jsx;        /* JSX was seen, so tokens depend on those before them */
 } hyp_lexer_t;
 
+/* Tokens replaced by hyp_lexer_edit: the old tokens first to
+ * first + removed became first to first + inserted, and every token
+ * after them moved by the size of the edit */
+typedef struct {
+    size_t first;
+    size_t removed;
+    size_t inserted;
+    size_t end;                  /* Offset of the end of the edit in the new source */
+    ptrdiff_t lines;             /* Change in the number of lines */
+} hyp_token_edit_t;
+
 /* Keyword lookup table entry */
 typedef struct {
     const char* keyword;
@@ -178,12 +230,51 @@ typedef struct {
 hyp_error_t hyp_lexer_init(hyp_lexer_t* lexer, const char* source, hyp_arena_t* arena);
 
 /**
- * Tokenize the entire source code
+ * Tokenize the entire source code into lexer->tokens. Error tokens are
+ * kept (with their message in the literal table); the last token is
+ * always TOKEN_EOF.
  * @param lexer The lexer instance
- * @return HYP_OK on success, error code on failure
+ * @return HYP_OK on success, HYP_ERROR_MEMORY, or HYP_ERROR_INVALID_ARG
+ *         for sources of 4 GB or more
  */
 hyp_error_t hyp_lexer_tokenize(hyp_lexer_t* lexer);
 
+/**
+ * Find the literal value of a token
+ * @param lexer The lexer instance
+ * @param index Token index
+ * @return The literal, or NULL if the token has none
+ */
+const hyp_token_literal_t* hyp_lexer_token_literal(const hyp_lexer_t* lexer, size_t index);
+
+/**
+ * Bring the tokens up to date with an edit of the source, rescanning
+ * only from just before the edit to the first token that is unchanged
+ * (one the old scan also started at, the edit's size later). Sources
+ * with JSX in them are rescanned whole.
+ * @param lexer A lexer that has tokenized the source before the edit
+ * @param source The edited source, with a '\0' at source[length]
+ * @param length Its length in bytes
+ * @param offset Where the edit starts
+ * @param removed Bytes of the old source replaced at offset...
+ * @param inserted ...by this many bytes of the new one
+ * @param edit Receives the tokens that changed
+ * @return HYP_OK on success, HYP_ERROR_INVALID_ARG if the edit does not
+ *         fit the source, or HYP_ERROR_MEMORY
+ */
+hyp_error_t hyp_lexer_edit(hyp_lexer_t* lexer, const char* source, size_t length,
+                           size_t offset, size_t removed, size_t inserted, hyp_token_edit_t* edit);
+
+/**
+ * Line and column of a source offset. Lookups that move forward through
+ * the source, as a parser's do, take constant time.
+ * @param lexer The lexer instance
+ * @param offset Offset in the source
+ * @param line Receives the line number
+ * @param column Receives the column number
+ */
+void hyp_lexer_location(hyp_lexer_t* lexer, size_t offset, size_t* line, size_t* column);
+
 /**
  * Get the next token from the source
  * @param lexer The lexer instance
@@ -304,12 +395,94 @@ void hyp_token_free(hyp_token_t* token);
  */
 hyp_lexer_t* hyp_lexer_create(const char* source, const char* filename);
 
+/**
+ * Create a lexer over source text of known length, which need not be
+ * NUL-terminated within it but must have a '\0' at source[length]
+ * @param source The source code to tokenize
+ * @param length Its length in bytes
+ * @param filename The filename for error reporting
+ * @return New lexer instance, or NULL on failure
+ */
+hyp_lexer_t* hyp_lexer_create_with_length(const char* source, size_t length, const char* filename);
+
 /**
  * Destroy lexer and free resources
  * @param lexer The lexer to destroy
  */
 void hyp_lexer_destroy(hyp_lexer_t* lexer);
 
+/**
+ * Point an existing lexer at new source text, as if freshly created
+ * @param lexer The lexer
+ * @param source Source text, with a '\0' at source[length]
+ * @param length Its length in bytes
+ * @param line Line number of the first line of source
+ */
+void hyp_lexer_reset(hyp_lexer_t* lexer, const char* source, size_t length, size_t line);
+
+/* Source read in batches of whole top-level declarations, so a file
+ * can be compiled without holding all of it in memory. A batch ends
+ * after a ';' or '}' outside brackets, strings and comments, where the
+ * next word starts a new statement (so "} else" is never split). */
+typedef struct {
+    FILE* file;
+    char* buffer;
+    size_t length;               /* Bytes held */
+    size_t capacity;
+    size_t batch_size;           /* Batches end at the first boundary past this */
+    size_t line;                 /* Line the next batch starts on */
+    bool at_end;                 /* Everything has been read */
+    bool has_error;
+    
+    /* Splitter state; positions are offsets into buffer */
+    size_t start;                /* Start of the next batch */
+    size_t scanned;              /* Bytes examined so far */
+    size_t boundary;             /* End of the last complete declaration */
+    size_t candidate;            /* Possible boundary, if the next word allows it (0: none) */
+    int depth;                   /* Open brackets */
+    char quote;                  /* Delimiter of the string being scanned, or 0 */
+    bool escaped;
+    bool line_comment;
+    bool block_comment;
+    
+    bool terminated;             /* The current batch was NUL-terminated... */
+    size_t terminator;           /* ...at this offset, */
+    char saved;                  /* replacing this byte */
+} hyp_source_reader_t;
+
+/**
+ * Open a file for batched reading
+ * @param reader Reader to initialize
+ * @param filename File to read
+ * @param batch_size Preferred batch size in bytes (0 for a default)
+ * @return HYP_OK on success, HYP_ERROR_IO if the file cannot be opened
+ */
+hyp_error_t hyp_source_reader_open(hyp_source_reader_t* reader, const char* filename, size_t batch_size);
+
+/**
+ * Read the next batch. The text stays valid until the next call.
+ * @param reader The reader
+ * @param text Receives the NUL-terminated batch
+ * @param length Receives its length
+ * @param line Receives the line number the batch starts on
+ * @return HYP_OK with a batch, HYP_ERROR_NOT_FOUND at the end of the
+ *         file, HYP_ERROR_IO or HYP_ERROR_MEMORY on failure
+ */
+hyp_error_t hyp_source_reader_next(hyp_source_reader_t* reader, const char** text, size_t* length, size_t* line);
+
+/**
+ * Start again from the beginning of the file
+ * @param reader The reader
+ * @return HYP_OK on success, HYP_ERROR_IO on failure
+ */
+hyp_error_t hyp_source_reader_rewind(hyp_source_reader_t* reader);
+
+/**
+ * Close the file and free the buffer
+ * @param reader The reader
+ */
+void hyp_source_reader_close(hyp_source_reader_t* reader);
+
 /* Character classification helpers */
 HYP_INLINE bool hyp_is_alpha(char c) {
     return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
@@ -2,8 +2,8 @@
  * Hyper Programming Language - Parser
  * 
  * The parser builds an Abstract Syntax Tree (AST) from the token stream
- * produced by the lexer. It implements a recursive descent parser for
- * the Hyper language grammar.
+ * produced by the lexer. Statements are parsed by recursive descent and
+ * expressions by precedence climbing over a table of binding powers.
  */
 
 #ifndef HYP_PARSER_H
@@ -100,7 +100,9 @@ typedef enum {
     ASSIGN_ADD,
     ASSIGN_SUB,
     ASSIGN_MUL,
-    ASSIGN_DIV
+    ASSIGN_DIV,
+    ASSIGN_MOD,
+    ASSIGN_POW
 } hyp_assign_op_t;
 
 /* Type information */
@@ -111,43 +113,56 @@ typedef struct {
     struct hyp_type* element_type;  /* For arrays */
 } hyp_type_t;
 
-/* Parameter for function declarations */
-typedef struct {
-    char* name;
-    hyp_type_t* type;
-    hyp_ast_node_t* default_value;
-} hyp_parameter_t;
+/* Bump whenever the tree layout or what the parser builds changes, so
+ * trees cached by another version are never used */
+#define HYP_PARSER_VERSION 1
 
-/* Array of parameters */
-typedef HYP_ARRAY(hyp_parameter_t) hyp_parameter_array_t;
+/*
+ * Compact AST. A tree is one contiguous block of 32-byte slots owned by
+ * the parser: the nodes, with child lists and strings packed between
+ * them. Links are 32-bit offsets in bytes from the link itself to
+ * its target, 0 meaning none, so the block holds no pointers and can be
+ * copied or written out as it is. Read links with the accessors below;
+ * a link copied out of its node no longer points anywhere.
+ */
+typedef int32_t hyp_ast_ref_t;    /* Link to a node */
+typedef int32_t hyp_ast_text_t;   /* Link to a NUL-terminated string */
 
-/* Array of AST nodes */
-typedef HYP_ARRAY(hyp_ast_node_t*) hyp_ast_node_array_t;
+/* A run of count entries; what an entry holds depends on the list */
+typedef struct {
+    int32_t items;                /* Link to the first entry */
+    uint32_t count;
+} hyp_ast_list_t;
 
-/* Object literal property */
+/* Entry of a function's parameter list */
 typedef struct {
-    char* key;
-    hyp_ast_node_t* value;
-} hyp_object_property_t;
+    hyp_ast_text_t name;
+    hyp_ast_ref_t default_value;
+} hyp_parameter_t;
 
-/* Array of object properties */
-typedef HYP_ARRAY(hyp_object_property_t) hyp_object_property_array_t;
+/* Entry of an object literal's property list */
+typedef struct {
+    hyp_ast_text_t key;
+    hyp_ast_ref_t value;
+} hyp_object_property_t;
 
-/* Match case */
+/* Entry of a match statement's case list */
 typedef struct {
-    hyp_ast_node_t* pattern;
-    hyp_ast_node_t* guard;  /* Optional guard condition */
-    hyp_ast_node_t* body;
+    hyp_ast_ref_t pattern;
+    hyp_ast_ref_t guard;  /* Optional guard condition */
+    hyp_ast_ref_t body;
 } hyp_match_case_t;
 
-/* Array of match cases */
-typedef HYP_ARRAY(hyp_match_case_t) hyp_match_case_array_t;
+/* Node flags */
+#define HYP_AST_ASYNC    0x01  /* Function declaration is async */
+#define HYP_AST_EXPORTED 0x02  /* Function declaration is exported */
 
-/* AST node structure */
+/* AST node structure; every member of the union fits in 16 bytes */
 struct hyp_ast_node {
-    hyp_ast_node_type_t type;
-    size_t line;
-    size_t column;
+    uint16_t type;                /* hyp_ast_node_type_t */
+    uint16_t flags;               /* HYP_AST_* */
+    uint32_t line;
+    uint32_t column;
     
     union {
         /* Literals */
@@ -156,7 +171,7 @@ struct hyp_ast_node {
         } number;
         
         struct {
-            char* value;
+            hyp_ast_text_t value;
         } string;
         
         struct {
@@ -164,167 +179,220 @@ struct hyp_ast_node {
         } boolean;
         
         struct {
-            char* name;
+            hyp_ast_text_t name;
         } identifier;
         
         /* Binary operation */
         struct {
             hyp_binary_op_t op;
-            hyp_ast_node_t* left;
-            hyp_ast_node_t* right;
+            hyp_ast_ref_t left;
+            hyp_ast_ref_t right;
         } binary_op;
         
         /* Unary operation */
         struct {
             hyp_unary_op_t op;
-            hyp_ast_node_t* operand;
+            hyp_ast_ref_t operand;
             bool is_postfix;
         } unary_op;
         
         /* Assignment */
         struct {
             hyp_assign_op_t op;
-            hyp_ast_node_t* target;
-            hyp_ast_node_t* value;
+            hyp_ast_ref_t target;
+            hyp_ast_ref_t value;
         } assignment;
         
-        /* Function call */
+        /* Function call; arguments are node links */
         struct {
-            hyp_ast_node_t* callee;
-            hyp_ast_node_array_t arguments;
+            hyp_ast_ref_t callee;
+            hyp_ast_list_t arguments;
         } call;
         
         /* Member access (obj.member) */
         struct {
-            hyp_ast_node_t* object;
-            char* member;
+            hyp_ast_ref_t object;
+            hyp_ast_text_t member;
         } member_access;
         
         /* Index access (obj[index]) */
         struct {
-            hyp_ast_node_t* object;
-            hyp_ast_node_t* index;
+            hyp_ast_ref_t object;
+            hyp_ast_ref_t index;
         } index_access;
         
         /* Conditional (ternary) operator */
         struct {
-            hyp_ast_node_t* condition;
-            hyp_ast_node_t* then_expr;
-            hyp_ast_node_t* else_expr;
+            hyp_ast_ref_t condition;
+            hyp_ast_ref_t then_expr;
+            hyp_ast_ref_t else_expr;
         } conditional;
         
-        /* Array literal */
+        /* Array literal; elements are node links */
         struct {
-            hyp_ast_node_array_t elements;
+            hyp_ast_list_t elements;
         } array_literal;
         
-        /* Object literal */
+        /* Object literal; properties are hyp_object_property_t */
         struct {
-            hyp_object_property_array_t properties;
+            hyp_ast_list_t properties;
         } object_literal;
         
-        /* Lambda function */
+        /* Lambda function; parameters are hyp_parameter_t */
         struct {
-            hyp_parameter_array_t parameters;
-            hyp_ast_node_t* body;
-            hyp_type_t* return_type;
+            hyp_ast_list_t parameters;
+            hyp_ast_ref_t body;
         } lambda;
         
         /* Expression statement */
         struct {
-            hyp_ast_node_t* expression;
+            hyp_ast_ref_t expression;
         } expression_stmt;
         
         /* Variable declaration */
         struct {
-            char* name;
-            hyp_type_t* type;
-            hyp_ast_node_t* initializer;
+            hyp_ast_text_t name;
+            hyp_ast_ref_t initializer;
             bool is_const;
         } variable_decl;
         
-        /* Function declaration */
+        /* Function declaration; parameters are hyp_parameter_t */
         struct {
-            char* name;
-            hyp_parameter_array_t parameters;
-            hyp_type_t* return_type;
-            hyp_ast_node_t* body;
-            bool is_async;
-            bool is_exported;
+            hyp_ast_text_t name;
+            hyp_ast_list_t parameters;
+            hyp_ast_ref_t body;
         } function_decl;
         
         /* If statement */
         struct {
-            hyp_ast_node_t* condition;
-            hyp_ast_node_t* then_stmt;
-            hyp_ast_node_t* else_stmt;
+            hyp_ast_ref_t condition;
+            hyp_ast_ref_t then_stmt;
+            hyp_ast_ref_t else_stmt;
         } if_stmt;
         
         /* While statement */
         struct {
-            hyp_ast_node_t* condition;
-            hyp_ast_node_t* body;
+            hyp_ast_ref_t condition;
+            hyp_ast_ref_t body;
         } while_stmt;
         
         /* For statement */
         struct {
-            hyp_ast_node_t* init;
-            hyp_ast_node_t* condition;
-            hyp_ast_node_t* update;
-            hyp_ast_node_t* body;
+            hyp_ast_ref_t init;
+            hyp_ast_ref_t condition;
+            hyp_ast_ref_t update;
+            hyp_ast_ref_t body;
         } for_stmt;
         
         /* Return statement */
         struct {
-            hyp_ast_node_t* value;
+            hyp_ast_ref_t value;
         } return_stmt;
         
-        /* Block statement */
+        /* Block statement; statements are node links */
         struct {
-            hyp_ast_node_array_t statements;
+            hyp_ast_list_t statements;
         } block_stmt;
         
-        /* Import statement */
+        /* Import statement; imports are identifier node links */
         struct {
-            char* module;
-            char* alias;
-            hyp_ast_node_array_t imports;  /* Specific imports */
+            hyp_ast_text_t module;
+            hyp_ast_text_t alias;
+            hyp_ast_list_t imports;  /* Specific imports */
         } import_stmt;
         
         /* Export statement */
         struct {
-            hyp_ast_node_t* declaration;
+            hyp_ast_ref_t declaration;
         } export_stmt;
         
-        /* Match statement */
+        /* Match statement; cases are hyp_match_case_t */
         struct {
-            hyp_ast_node_t* expression;
-            hyp_match_case_array_t cases;
+            hyp_ast_ref_t expression;
+            hyp_ast_list_t cases;
         } match_stmt;
         
         /* Try statement */
         struct {
-            hyp_ast_node_t* try_block;
-            char* catch_variable;
-            hyp_ast_node_t* catch_block;
-            hyp_ast_node_t* finally_block;
+            hyp_ast_ref_t try_block;
+            hyp_ast_text_t catch_variable;
+            hyp_ast_ref_t catch_block;
+            hyp_ast_ref_t finally_block;
         } try_stmt;
         
-        /* Program (root node) */
+        /* Program (root node); statements are node links */
         struct {
-            hyp_ast_node_array_t statements;
+            hyp_ast_list_t statements;
         } program;
     };
 };
 
+/* Follow a link; NULL for none */
+static inline hyp_ast_node_t* hyp_ast_get(const hyp_ast_ref_t* ref) {
+    return *ref ? (hyp_ast_node_t*)((const char*)ref + *ref) : NULL;
+}
+
+static inline const char* hyp_ast_text(const hyp_ast_text_t* text) {
+    return *text ? (const char*)text + *text : NULL;
+}
+
+/* First entry of a list, to be cast to the list's entry type */
+static inline const void* hyp_ast_items(const hyp_ast_list_t* list) {
+    return (const char*)&list->items + list->items;
+}
+
+/* Entry i of a list of node links */
+static inline hyp_ast_node_t* hyp_ast_list_at(const hyp_ast_list_t* list, size_t i) {
+    return hyp_ast_get((const hyp_ast_ref_t*)hyp_ast_items(list) + i);
+}
+
+#define HYP_AST_CHILD(node, field) hyp_ast_get(&(node)->field)
+#define HYP_AST_TEXT(node, field) hyp_ast_text(&(node)->field)
+#define HYP_AST_AT(node, field, i) hyp_ast_list_at(&(node)->field, (i))
+
+/* Entries of parameter, property and case lists */
+#define HYP_AST_PARAMETERS(list) ((const hyp_parameter_t*)hyp_ast_items(list))
+#define HYP_AST_PROPERTIES(list) ((const hyp_object_property_t*)hyp_ast_items(list))
+#define HYP_AST_CASES(list) ((const hyp_match_case_t*)hyp_ast_items(list))
+
+/* A top-level statement as an incremental parser records it: its
+ * tokens and the slots it took. Its parse may also have looked at the
+ * token before it and the one after. */
+typedef struct {
+    uint32_t first_token;
+    uint32_t end_token;          /* One past its last token */
+    uint32_t first_slot;
+    uint32_t end_slot;
+    uint32_t node;               /* Its slot, 0 if it did not parse */
+    bool had_error;
+    bool panic;                  /* It began in panic mode, its errors unreported */
+} hyp_parser_decl_t;
+
 /* Parser state */
 struct hyp_parser {
     hyp_lexer_t* lexer;
-    hyp_token_t current;
-    hyp_token_t previous;
-    hyp_arena_t* arena;
+    size_t current;              /* Indexes into lexer->tokens */
+    size_t previous;
     bool had_error;
     bool panic_mode;
+    
+    /* The tree, in slots; both buffers are kept for reuse */
+    hyp_ast_node_t* slots;
+    uint32_t slot_count;
+    uint32_t slot_capacity;
+    HYP_ARRAY(uint32_t) entries;  /* Slots of list entries being collected */
+    size_t tree_size;             /* Bytes in the last tree parsed */
+    
+    /* Incremental mode: where each top-level statement is, and a bit
+     * per slot telling nodes from lists and strings */
+    bool incremental;
+    HYP_ARRAY(hyp_parser_decl_t) decls;
+    uint64_t* node_marks;
+    
+    /* Threads for large sources; 0 or 1 is serial. Workers hold their
+     * error messages in `messages` until they are known to stand. */
+    size_t jobs;
+    hyp_out_t* messages;
 };
 
 /* Function declarations */
@@ -346,26 +414,55 @@ hyp_parser_t* hyp_parser_create(hyp_lexer_t* lexer);
 hyp_error_t hyp_parser_init(hyp_parser_t* parser, hyp_token_array_t* tokens, hyp_arena_t* arena);
 
 /**
- * Parse tokens into an AST
+ * Reuse a parser for another lexer, keeping its tree buffer. Trees
+ * returned earlier become invalid.
+ * @param parser The parser
+ * @param lexer The lexer to read from next
+ */
+void hyp_parser_reset(hyp_parser_t* parser, hyp_lexer_t* lexer);
+
+/**
+ * Parse tokens into an AST. The tree lives in the parser until it is
+ * reset or destroyed; parser->tree_size gives its size.
+ *
+ * With parser->jobs above 1, a large source is split before `let`,
+ * `const` and `func` tokens outside any brackets, and the pieces are
+ * parsed at once on worker threads. A piece is kept only if the
+ * statements before it ended exactly where it began, in the same error
+ * state; otherwise it is parsed again in turn. The tree and the errors
+ * reported are the same as a serial parse's, byte for byte.
+ * Incremental parsers always parse serially.
  * @param parser The parser instance
  * @return Root AST node (program), or NULL on error
  */
 hyp_ast_node_t* hyp_parser_parse(hyp_parser_t* parser);
 
+/**
+ * Keep what hyp_parser_update needs from the next parse on
+ * @param parser The parser
+ * @return HYP_OK on success, HYP_ERROR_MEMORY on failure
+ */
+hyp_error_t hyp_parser_set_incremental(hyp_parser_t* parser);
+
+/**
+ * Bring the tree up to date after hyp_lexer_edit. Top-level statements
+ * whose tokens the edit did not reach are kept where they are, their
+ * line numbers moved; parsing starts at the first statement that saw a
+ * changed token and stops at the first old statement it lines up with
+ * that starts on a line after the edit. New statements go after the
+ * tree's slots, which are compacted once mostly unused. The tree stays
+ * at the same address unless compacted or grown.
+ * @param parser An incremental parser that parsed the source before the edit
+ * @param edit The tokens hyp_lexer_edit changed
+ * @return Root AST node (program), or NULL if the source has errors;
+ *         the parser can be updated again either way
+ */
+hyp_ast_node_t* hyp_parser_update(hyp_parser_t* parser, const hyp_token_edit_t* edit);
+
 /* Parsing functions for different constructs */
 hyp_ast_node_t* hyp_parse_program(hyp_parser_t* parser);
 hyp_ast_node_t* hyp_parse_statement(hyp_parser_t* parser);
 hyp_ast_node_t* hyp_parse_expression(hyp_parser_t* parser);
-hyp_ast_node_t* hyp_parse_assignment(hyp_parser_t* parser);
-hyp_ast_node_t* hyp_parse_conditional(hyp_parser_t* parser);
-hyp_ast_node_t* hyp_parse_logical_or(hyp_parser_t* parser);
-hyp_ast_node_t* hyp_parse_logical_and(hyp_parser_t* parser);
-hyp_ast_node_t* hyp_parse_equality(hyp_parser_t* parser);
-hyp_ast_node_t* hyp_parse_comparison(hyp_parser_t* parser);
-hyp_ast_node_t* hyp_parse_term(hyp_parser_t* parser);
-hyp_ast_node_t* hyp_parse_factor(hyp_parser_t* parser);
-hyp_ast_node_t* hyp_parse_unary(hyp_parser_t* parser);
-hyp_ast_node_t* hyp_parse_postfix(hyp_parser_t* parser);
 hyp_ast_node_t* hyp_parse_primary(hyp_parser_t* parser);
 
 /* Statement parsing */
@@ -392,18 +489,8 @@ hyp_token_t* hyp_parser_advance(hyp_parser_t* parser);
 bool hyp_parser_is_at_end(hyp_parser_t* parser);
 hyp_token_t* hyp_parser_consume(hyp_parser_t* parser, hyp_token_type_t type, const char* message);
 
-/* AST node creation */
-hyp_ast_node_t* hyp_ast_create_node(hyp_parser_t* parser, hyp_ast_node_type_t type);
-hyp_ast_node_t* hyp_ast_create_number(hyp_parser_t* parser, double value);
-hyp_ast_node_t* hyp_ast_create_string(hyp_parser_t* parser, const char* value);
-hyp_ast_node_t* hyp_ast_create_boolean(hyp_parser_t* parser, bool value);
-hyp_ast_node_t* hyp_ast_create_identifier(hyp_parser_t* parser, const char* name);
-hyp_ast_node_t* hyp_ast_create_binary_op(hyp_parser_t* parser, hyp_binary_op_t op, hyp_ast_node_t* left, hyp_ast_node_t* right);
-hyp_ast_node_t* hyp_ast_create_unary_op(hyp_parser_t* parser, hyp_unary_op_t op, hyp_ast_node_t* operand, bool is_postfix);
-
 /* Type parsing */
 hyp_type_t* hyp_parse_type(hyp_parser_t* parser);
-hyp_parameter_t hyp_parse_parameter(hyp_parser_t* parser);
 
 /* Error handling */
 void hyp_parser_error(hyp_parser_t* parser, const char* message);
@@ -411,7 +498,6 @@ void hyp_parser_synchronize(hyp_parser_t* parser);
 
 /* AST utilities */
 void hyp_ast_print(hyp_ast_node_t* node, int indent);
-void hyp_ast_free(hyp_ast_node_t* node);
 const char* hyp_ast_node_type_name(hyp_ast_node_type_t type);
 
 /* Parser cleanup */
@@ -0,0 +1,174 @@
+/**
+ * Hyper Programming Language - Execution Profiles
+ *
+ * Profiles connect the interpreter and the compiler: hyprun records how a
+ * program actually behaves (branch biases, loop trip counts, call-site
+ * targets and the operand types seen by operators) and hypc uses that to
+ * guide inlining, specialisation, block layout and branch hints in the
+ * C backend.
+ *
+ * Every record belongs to a top-level function and is identified by its
+ * position within that function. Functions are matched by name and by a
+ * structural hash of their body, so editing one function (or comments and
+ * whitespace anywhere) only invalidates that function's data.
+ */
+
+#ifndef HYP_PROFILE_H
+#define HYP_PROFILE_H
+
+#include "hyp_common.h"
+#include "parser.h"
+
+/* First line of every profile file; bump the number on format changes */
+#define HYP_PROFILE_MAGIC "HPROF"
+#define HYP_PROFILE_VERSION 1
+
+/* Name used for top-level statements outside any function */
+#define HYP_PROFILE_MODULE_NAME "<module>"
+
+/* Operand type bits recorded for operator sites */
+#define HYP_PROFILE_TYPE_NUMBER  0x1u
+#define HYP_PROFILE_TYPE_STRING  0x2u
+#define HYP_PROFILE_TYPE_BOOLEAN 0x4u
+#define HYP_PROFILE_TYPE_OTHER   0x8u
+
+/* Minimum samples before a site is trusted, and the bias that counts as "likely" */
+#define HYP_PROFILE_MIN_SAMPLES 16
+#define HYP_PROFILE_BIAS_PERCENT 90
+
+typedef struct {
+    uint64_t taken;
+    uint64_t not_taken;
+} hyp_profile_branch_t;
+
+typedef struct {
+    uint64_t entries;
+    uint64_t iterations;
+} hyp_profile_loop_t;
+
+typedef struct {
+    uint64_t count;
+    char* target;                /* Most recently resolved callee name */
+} hyp_profile_call_t;
+
+typedef struct {
+    uint64_t count;
+    uint32_t types;              /* HYP_PROFILE_TYPE_* bits of both operands */
+} hyp_profile_operands_t;
+
+/* Profile data for one function */
+typedef struct {
+    char* name;
+    uint64_t hash;
+    uint64_t calls;
+    size_t node_count;           /* Body size, used for inlining decisions */
+    bool matched;                /* Loaded data matches the current source */
+    HYP_ARRAY(hyp_profile_branch_t) branches;
+    HYP_ARRAY(hyp_profile_loop_t) loops;
+    HYP_ARRAY(hyp_profile_call_t) call_sites;
+    HYP_ARRAY(hyp_profile_operands_t) operands;
+} hyp_profile_function_t;
+
+/* Kinds of profiled sites */
+typedef enum {
+    HYP_SITE_FUNCTION,
+    HYP_SITE_BRANCH,
+    HYP_SITE_LOOP,
+    HYP_SITE_CALL,
+    HYP_SITE_OPERANDS
+} hyp_profile_site_kind_t;
+
+/* Maps an AST node to its record */
+typedef struct {
+    const hyp_ast_node_t* node;
+    uint32_t function;
+    uint32_t index;
+    hyp_profile_site_kind_t kind;
+} hyp_profile_site_t;
+
+typedef struct hyp_profile {
+    HYP_ARRAY(hyp_profile_function_t) functions;
+
+    /* Open-addressing map from AST node to site */
+    hyp_profile_site_t* sites;
+    size_t site_count;
+    size_t site_capacity;
+
+    /* Error handling */
+    bool has_error;
+    char error_message[256];
+} hyp_profile_t;
+
+/**
+ * Create an empty profile
+ * @return New profile, or NULL on failure
+ */
+hyp_profile_t* hyp_profile_create(void);
+
+/**
+ * Load a profile written by hyp_profile_write
+ * @param filename Profile file
+ * @param profile Receives the loaded profile
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_profile_load(const char* filename, hyp_profile_t** profile);
+
+/**
+ * Write a profile to disk
+ * @param profile The profile
+ * @param filename Output file
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_profile_write(hyp_profile_t* profile, const char* filename);
+
+/**
+ * Attach a profile to a parsed program. Functions present in the profile
+ * whose hash matches keep their data; new functions start empty.
+ * @param profile The profile
+ * @param program The AST_PROGRAM node
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_profile_bind(hyp_profile_t* profile, hyp_ast_node_t* program);
+
+/**
+ * Structural hash of a function, stable across whitespace and comment edits
+ * @param function An AST_FUNCTION_DECL node
+ * @return 64-bit hash
+ */
+uint64_t hyp_profile_function_hash(const hyp_ast_node_t* function);
+
+/* Recording (called by the interpreter; the profile must be bound) */
+void hyp_profile_record_call(hyp_profile_t* profile, const hyp_ast_node_t* body);
+void hyp_profile_record_branch(hyp_profile_t* profile, const hyp_ast_node_t* node, bool taken);
+void hyp_profile_record_loop(hyp_profile_t* profile, const hyp_ast_node_t* node, uint64_t iterations);
+void hyp_profile_record_call_site(hyp_profile_t* profile, const hyp_ast_node_t* node, const char* target);
+void hyp_profile_record_operands(hyp_profile_t* profile, const hyp_ast_node_t* node, uint32_t types);
+
+/* Queries (used by the code generator) */
+
+/**
+ * Branch bias of an if/while node
+ * @return 1 if the condition is almost always true, -1 if almost always
+ *         false, 0 if unknown or mixed
+ */
+int hyp_profile_branch_bias(const hyp_profile_t* profile, const hyp_ast_node_t* node);
+
+/**
+ * Operand types seen at an operator site
+ * @return HYP_PROFILE_TYPE_* bits, or 0 if the site was never executed
+ */
+uint32_t hyp_profile_operand_types(const hyp_profile_t* profile, const hyp_ast_node_t* node);
+
+/**
+ * Profile data for a function by name
+ * @return The function's data, or NULL if unknown or stale
+ */
+const hyp_profile_function_t* hyp_profile_function(const hyp_profile_t* profile, const char* name);
+
+/**
+ * Destroy a profile
+ * @param profile The profile to destroy
+ */
+void hyp_profile_destroy(hyp_profile_t* profile);
+
+#endif /* HYP_PROFILE_H */
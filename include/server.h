@@ -0,0 +1,133 @@
+/**
+ * Hyper Programming Language - Compiler Server
+ *
+ * `hypc --server` keeps parsed modules warm between compilations. Thin
+ * clients (`hypc --client ...`) send compile requests over a local UNIX
+ * socket and the server answers from its cache of ASTs and interface
+ * summaries, so a request for an unchanged module skips process start-up,
+ * reading and parsing. File changes are picked up with inotify on Linux
+ * (elsewhere, and for files that cannot be watched, sources are re-hashed
+ * on every request). The cache is bounded: the least recently used modules
+ * are evicted once it holds more than its memory limit.
+ *
+ * Requests and responses are short line-oriented texts. A request is a
+ * command line ("compile", "stats" or "shutdown") followed by
+ * "key value" lines; the client closes its side when done. A response
+ * starts with "ok" or "error <message>". The lines after an error are
+ * diagnostics (syntax errors), which the client prints before the
+ * message, just as a local compilation would.
+ */
+
+#ifndef HYP_SERVER_H
+#define HYP_SERVER_H
+
+#include "hyp_common.h"
+#include "parser.h"
+#include "ast_cache.h"
+#include "build.h"
+
+/* Socket used when neither --socket nor $HYP_SERVER_SOCKET is given */
+#define HYP_SERVER_DEFAULT_SOCKET ".hypkg/hypc.sock"
+
+/* Default bound on cached modules, in bytes */
+#define HYP_SERVER_DEFAULT_MEMORY ((size_t)256 * 1024 * 1024)
+
+/* Largest request accepted */
+#define HYP_SERVER_MAX_REQUEST 8192
+
+/* A parsed module kept between requests */
+typedef struct hyp_server_module {
+    char* path;                  /* Absolute path, the cache key */
+    hyp_ast_image_t image;       /* Owns the AST, parsed or mapped from the AST cache */
+    hyp_ast_node_t* ast;
+    uint64_t content_hash;
+    uint64_t interface_hash;     /* As computed by hyp_build_interface_hash */
+    hyp_build_paths_t imports;   /* Absolute paths of imported modules */
+    size_t memory;               /* Bytes held, counted against the limit */
+    int watch;                   /* inotify watch, or -1 to re-hash on use */
+
+    struct hyp_server_module* newer;   /* LRU list, most recent first */
+    struct hyp_server_module* older;
+    struct hyp_server_module* next;    /* Hash bucket chain */
+} hyp_server_module_t;
+
+/* Server state */
+typedef struct {
+    char* socket_path;
+    size_t memory_limit;
+    bool verbose;
+    int listen_fd;
+    int watch_fd;                /* inotify instance, or -1 */
+
+    /* Module cache */
+    hyp_server_module_t** buckets;
+    size_t bucket_count;
+    size_t module_count;
+    size_t memory_used;
+    hyp_server_module_t* newest;
+    hyp_server_module_t* oldest;
+    hyp_ast_cache_t ast_cache;   /* On disk, for modules not yet in memory */
+
+    /* Statistics */
+    uint64_t requests;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t invalidations;
+    uint64_t evictions;
+
+    bool running;
+
+    /* Error handling */
+    bool has_error;
+    char error_message[256];
+} hyp_server_t;
+
+/**
+ * Socket path to use: the given one, $HYP_SERVER_SOCKET or the default
+ * @param requested Path from the command line, or NULL
+ * @return Socket path (not owned by the caller)
+ */
+const char* hyp_server_socket_path(const char* requested);
+
+/**
+ * Create the listening socket. Fails if another server already answers
+ * on it; a socket file left behind by a dead server is replaced.
+ * @param server Server to initialize
+ * @param socket_path Socket path
+ * @param memory_limit Cache bound in bytes (0 for the default)
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_server_init(hyp_server_t* server, const char* socket_path, size_t memory_limit);
+
+/**
+ * Serve requests until a shutdown request, SIGINT or SIGTERM
+ * @param server The server
+ * @return HYP_OK on a clean shutdown, error code on failure
+ */
+hyp_error_t hyp_server_run(hyp_server_t* server);
+
+/**
+ * Close the socket, remove it and free every cached module
+ * @param server The server
+ */
+void hyp_server_destroy(hyp_server_t* server);
+
+/**
+ * Send a request to a running server and wait for its response
+ * @param socket_path Socket path
+ * @param request Request text
+ * @param response Receives the response text (caller frees)
+ * @return HYP_OK on success, HYP_ERROR_NOT_FOUND if no server is
+ *         listening, HYP_ERROR_IO on other failures
+ */
+hyp_error_t hyp_server_send(const char* socket_path, const char* request, char** response);
+
+/**
+ * Absolute form of a path, so client and server agree whatever their
+ * working directories. Existing paths are also canonicalized.
+ * @param path A path
+ * @return Absolute path (caller frees), or NULL on failure
+ */
+char* hyp_server_absolute_path(const char* path);
+
+#endif /* HYP_SERVER_H */
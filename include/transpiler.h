@@ -21,26 +21,71 @@ typedef enum {
     TARGET_LLVM_IR
 } hyp_target_t;
 
+/* Symbol kinds tracked by the code generator */
+typedef enum {
+    HYP_SYMBOL_GLOBAL,
+    HYP_SYMBOL_LOCAL,
+    HYP_SYMBOL_FUNCTION,
+    HYP_SYMBOL_IMPORT            /* Imported name or module alias */
+} hyp_symbol_kind_t;
+
+/* Names to their positions in a table */
+typedef HYP_MAP(uint32_t) hyp_name_index_t;
+
+struct hyp_profile;
+
 /* Code generation context */
 typedef struct {
     hyp_target_t target;
-    hyp_string_t output;
+    hyp_out_t output;            /* Chunked; streamed to a file descriptor if one is set */
+    char* output_text;           /* Contiguous copy made by hyp_codegen_get_output */
     int indent_level;
     bool optimize;
     bool debug_info;
-    hyp_arena_t* arena;
+    hyp_arena_t* arena;          /* Strings kept for one generation; cleared between them if owned */
+    bool owns_arena;
     
     /* Symbol table for variable tracking */
     struct {
         char** names;
         hyp_type_t** types;
+        hyp_symbol_kind_t* kinds;
+        size_t* arities;         /* Parameter count for functions */
         size_t count;
         size_t capacity;
     } symbols;
     
+    /* String literals and property keys (C target literal table) */
+    HYP_ARRAY(const char*) literals;
+    size_t literal_base;         /* hyp_str index of literals[0] */
+    
+    /* Hash indexes over the literal table and the top-level symbols.
+     * Both tables are filled before any function body is generated and
+     * are read-only afterwards, so workers can share them. */
+    hyp_name_index_t literal_index;
+    hyp_name_index_t global_index;
+    size_t global_count;
+    
+    /* Threads generating C function bodies (0 or 1: serial) */
+    size_t jobs;
+    bool is_worker;
+    
+    /* Nesting depth of short-circuit temporaries (C target) */
+    int temp_depth;
+    int temp_max;
+    
+    /* Streaming generation: top-level names outlive the batch ASTs */
+    HYP_ARRAY(char*) stream_names;
+    size_t stream_inits;         /* hyp_init_<n> functions emitted */
+    size_t stream_strings;       /* hyp_strings_<n> functions emitted */
+    bool stream_defining;        /* Declarations done, globals indexed */
+    
+    /* Execution profile guiding -O (bound to the AST being generated) */
+    const struct hyp_profile* profile;
+    
     /* Function context */
     struct {
-        char* current_function;
+        const char* current_function;
         hyp_type_t* return_type;
         bool in_loop;
         int loop_depth;
@@ -58,6 +103,8 @@ typedef struct {
     bool debug_info;
     bool minify;
     const char* output_file;
+    const struct hyp_profile* profile;  /* Optional; only used with optimize */
+    size_t jobs;                 /* Code generation threads; 0 or 1 is serial */
     const char* include_paths[16];
     size_t include_count;
 } hyp_codegen_options_t;
@@ -81,6 +128,40 @@ hyp_error_t hyp_codegen_init(hyp_codegen_t* codegen, const hyp_codegen_options_t
  */
 hyp_error_t hyp_codegen_generate(hyp_codegen_t* codegen, hyp_ast_node_t* ast);
 
+/**
+ * Generate a program handed over in batches of top-level declarations,
+ * for sources too large to hold as one AST (C target only). Feed every
+ * batch to hyp_codegen_stream_declare, then every batch again, in the
+ * same order, to hyp_codegen_stream_define; only top-level names are
+ * kept between calls, so each batch may be freed once its call returns.
+ * @param codegen The code generator instance
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_codegen_stream_begin(hyp_codegen_t* codegen);
+
+/**
+ * Declare the top-level functions and globals of a batch
+ * @param codegen The code generator instance
+ * @param batch AST_PROGRAM node holding the batch
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_codegen_stream_declare(hyp_codegen_t* codegen, hyp_ast_node_t* batch);
+
+/**
+ * Generate the definitions and top-level statements of a batch
+ * @param codegen The code generator instance
+ * @param batch AST_PROGRAM node holding the batch
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_codegen_stream_define(hyp_codegen_t* codegen, hyp_ast_node_t* batch);
+
+/**
+ * Finish a streamed program and flush it
+ * @param codegen The code generator instance
+ * @return HYP_OK on success, error code on failure
+ */
+hyp_error_t hyp_codegen_stream_end(hyp_codegen_t* codegen);
+
 /**
  * Get the generated code
  * @param codegen The code generator instance
@@ -88,6 +169,22 @@ hyp_error_t hyp_codegen_generate(hyp_codegen_t* codegen, hyp_ast_node_t* ast);
  */
 const char* hyp_codegen_get_output(hyp_codegen_t* codegen);
 
+/**
+ * Get the number of bytes generated (including any already streamed)
+ * @param codegen The code generator instance
+ * @return Output size in bytes
+ */
+size_t hyp_codegen_get_output_length(hyp_codegen_t* codegen);
+
+/**
+ * Stream generated code to a file descriptor instead of keeping it in
+ * memory. Must be called before hyp_codegen_generate; afterwards
+ * hyp_codegen_get_output returns NULL.
+ * @param codegen The code generator instance
+ * @param fd Open, writable file descriptor, or -1 to buffer in memory
+ */
+void hyp_codegen_set_output_fd(hyp_codegen_t* codegen, int fd);
+
 /* Code generation for different AST nodes */
 hyp_error_t hyp_codegen_program(hyp_codegen_t* codegen, hyp_ast_node_t* node);
 hyp_error_t hyp_codegen_statement(hyp_codegen_t* codegen, hyp_ast_node_t* node);
@@ -156,7 +253,7 @@ char* hyp_escape_string_js(const char* str);
 
 /* Name mangling for C output */
 char* hyp_mangle_name(const char* name);
-char* hyp_mangle_function_name(const char* name, hyp_parameter_array_t* params);
+char* hyp_mangle_function_name(const char* name, const hyp_ast_list_t* params);
 
 /* Optimization passes */
 hyp_error_t hyp_optimize_ast(hyp_ast_node_t* ast);
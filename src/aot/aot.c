@@ -0,0 +1,427 @@
+/**
+ * Hyper Programming Language - Ahead-of-Time Native Builds Implementation
+ *
+ * Transpiles to C, invokes the system compiler and caches executables
+ * under a content hash so unchanged programs start without recompiling.
+ */
+
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L    /* mkstemp */
+#endif
+
+#include "../../include/aot.h"
+#include "../../include/lexer.h"
+#include "../../include/parser.h"
+#include "../../include/ast_cache.h"
+#include "../../include/transpiler.h"
+#include "../../include/profile.h"
+#include "../../include/hyp_metrics.h"
+#include "../../include/hyprt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <unistd.h>
+    #include <sys/wait.h>
+#endif
+
+/* Build-time locations of the runtime headers and library (set by CMake) */
+#ifndef HYP_AOT_INCLUDE_DIR
+    #define HYP_AOT_INCLUDE_DIR "include"
+#endif
+#ifndef HYP_AOT_LIB_DIR
+    #define HYP_AOT_LIB_DIR "build/lib"
+#endif
+
+static void aot_error(hyp_aot_t* aot, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(aot->error_message, sizeof(aot->error_message), format, args);
+    va_end(args);
+    aot->has_error = true;
+}
+
+static const char* env_or(const char* name, const char* fallback) {
+    const char* value = getenv(name);
+    return (value && *value) ? value : fallback;
+}
+
+void hyp_aot_init(hyp_aot_t* aot) {
+    if (!aot) return;
+
+    memset(aot, 0, sizeof(hyp_aot_t));
+    aot->cc = env_or("HYP_CC", HYP_AOT_DEFAULT_CC);
+    aot->cflags = env_or("HYP_CFLAGS", HYP_AOT_DEFAULT_CFLAGS);
+    aot->cache_dir = HYP_AOT_DEFAULT_CACHE_DIR;
+    if (hyp_user_cache_dir(HYP_AOT_CACHE_NAME, aot->default_cache_dir, sizeof(aot->default_cache_dir))) {
+        aot->cache_dir = aot->default_cache_dir;
+    }
+    aot->cache_dir = env_or("HYP_CACHE_DIR", aot->cache_dir);
+    aot->include_dir = env_or("HYP_INCLUDE_DIR", HYP_AOT_INCLUDE_DIR);
+    aot->lib_dir = env_or("HYP_LIB_DIR", HYP_AOT_LIB_DIR);
+}
+
+uint64_t hyp_aot_cache_key(hyp_aot_t* aot, const char* source, size_t size) {
+    /* Everything that can change the produced binary goes into the key */
+    uint64_t key = hyp_hash_bytes(source, size, HYP_HASH_SEED);
+    key = hyp_hash_string(HYP_VERSION_STRING, key);
+    key = hyp_hash_string(aot->cc, key);
+    key = hyp_hash_string(aot->cflags, key);
+
+    /* A new profile changes code layout and hints */
+    if (aot->profile_file) {
+        size_t profile_size;
+        char* profile = hyp_read_file(aot->profile_file, &profile_size);
+        if (profile) {
+            key = hyp_hash_bytes(profile, profile_size, key);
+            HYP_FREE(profile);
+        }
+    }
+
+    /* A rebuilt runtime library invalidates every cached binary */
+    char lib_path[1024];
+    snprintf(lib_path, sizeof(lib_path), "%s/lib%s.a", aot->lib_dir, HYP_AOT_RUNTIME_LIB);
+
+    struct stat st;
+    if (stat(lib_path, &st) == 0) {
+        uint64_t stamp[2] = { (uint64_t)st.st_size, (uint64_t)st.st_mtime };
+        key = hyp_hash_bytes(stamp, sizeof(stamp), key);
+    }
+
+    return key;
+}
+
+/* Reserve a name beside path that no other build (thread or process) can
+ * pick, as directory_put does for artifacts. Names made by adding a
+ * suffix to it are private too, for as long as the reserved file exists.
+ * The caller removes the file and frees the name. */
+static char* reserve_name(const char* path) {
+    char* name = HYP_MALLOC(strlen(path) + 40);
+    if (!name) return NULL;
+
+#ifdef _WIN32
+    sprintf(name, "%s.%lu.%lu", path, (unsigned long)GetCurrentProcessId(),
+            (unsigned long)GetCurrentThreadId());
+    int fd = hyp_create_file(name);
+#else
+    sprintf(name, "%s.XXXXXX", path);
+    int fd = mkstemp(name);
+#endif
+    if (fd < 0) {
+        HYP_FREE(name);
+        return NULL;
+    }
+    hyp_close_file(fd);
+    return name;
+}
+
+hyp_error_t hyp_aot_compile_c(hyp_aot_t* aot, const char* c_file, const char* binary_path) {
+    if (!aot || !c_file || !binary_path) return HYP_ERROR_INVALID_ARG;
+
+    /* Compile to a name of our own and rename, so neither readers nor a
+     * concurrent build of the same program ever see a partial binary */
+    char* reserved = reserve_name(binary_path);
+    if (!reserved) {
+        aot_error(aot, "Could not create a temporary file beside '%s'", binary_path);
+        return HYP_ERROR_IO;
+    }
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp%s", reserved, HYP_AOT_EXE_SUFFIX);
+
+    char command[4096];
+    int length = snprintf(command, sizeof(command),
+                          "%s %s -I\"%s\" -o \"%s\" \"%s\" -L\"%s\" -l%s -lm",
+                          aot->cc, aot->cflags, aot->include_dir, temp_path, c_file,
+                          aot->lib_dir, HYP_AOT_RUNTIME_LIB);
+    if (length < 0 || (size_t)length >= sizeof(command)) {
+        aot_error(aot, "Compiler command line too long");
+        remove(reserved);
+        HYP_FREE(reserved);
+        return HYP_ERROR_INVALID_ARG;
+    }
+
+    if (aot->verbose) {
+        printf("Compiling: %s\n", command);
+    }
+
+    fflush(stdout);
+    hyp_error_t result = HYP_OK;
+    int status = system(command);
+    if (status != 0) {
+        remove(temp_path);
+        aot_error(aot, "C compiler failed (exit status %d): %s", status, command);
+        result = HYP_ERROR_RUNTIME;
+    } else {
+#ifdef _WIN32
+        /* rename() does not replace an existing file on Windows */
+        remove(binary_path);
+#endif
+        if (rename(temp_path, binary_path) != 0) {
+            remove(temp_path);
+            aot_error(aot, "Could not move compiled binary to '%s'", binary_path);
+            result = HYP_ERROR_IO;
+        }
+    }
+
+    remove(reserved);
+    HYP_FREE(reserved);
+    return result;
+}
+
+/* Transpile a source buffer to C, streaming the result into c_path */
+static hyp_error_t transpile_to_c(hyp_aot_t* aot, const hyp_source_t* source, const char* filename, const char* c_path) {
+    hyp_lexer_t* lexer = hyp_lexer_create_with_length(source->data, source->size, filename);
+    if (!lexer) {
+        aot_error(aot, "Could not create lexer");
+        return HYP_ERROR_MEMORY;
+    }
+
+    /* A tree cached by hypc or an interpreted run saves the parse */
+    hyp_ast_cache_t ast_cache;
+    hyp_ast_cache_init(&ast_cache);
+    ast_cache.force = aot->force;
+
+    hyp_ast_image_t image;
+    hyp_error_t parsed = hyp_ast_cache_parse(&ast_cache, lexer, source->data, source->size, &image);
+    if (parsed == HYP_ERROR_MEMORY) {
+        aot_error(aot, "Could not create parser");
+        hyp_lexer_destroy(lexer);
+        return HYP_ERROR_MEMORY;
+    }
+
+    hyp_error_t result = HYP_ERROR_SEMANTIC;
+    hyp_ast_node_t* ast = image.root;
+    if (parsed != HYP_OK) {
+        aot_error(aot, "Parsing '%s' failed", filename);
+    } else {
+        hyp_codegen_options_t codegen_opts = { .target = TARGET_C };
+        hyp_codegen_t codegen;
+
+        /* A profile implies an optimized build; an unusable one is skipped */
+        hyp_profile_t* profile = NULL;
+        if (aot->profile_file) {
+            if (hyp_profile_load(aot->profile_file, &profile) != HYP_OK ||
+                hyp_profile_bind(profile, ast) != HYP_OK) {
+                fprintf(stderr, "Warning: Could not use profile '%s'\n", aot->profile_file);
+                hyp_profile_destroy(profile);
+                profile = NULL;
+            }
+            codegen_opts.optimize = true;
+            codegen_opts.profile = profile;
+        }
+
+        int fd = -1;
+        if (hyp_codegen_init(&codegen, &codegen_opts, NULL) != HYP_OK) {
+            aot_error(aot, "Could not initialize code generator");
+        } else if ((fd = hyp_create_file(c_path)) < 0) {
+            aot_error(aot, "Could not write '%s'", c_path);
+            result = HYP_ERROR_IO;
+            hyp_codegen_destroy(&codegen);
+        } else {
+            hyp_codegen_set_output_fd(&codegen, fd);
+            result = hyp_codegen_generate(&codegen, ast);
+            if (hyp_close_file(fd) != HYP_OK && result == HYP_OK) {
+                result = HYP_ERROR_IO;
+            }
+            if (result == HYP_ERROR_IO) {
+                aot_error(aot, "Could not write '%s'", c_path);
+            } else if (result != HYP_OK) {
+                aot_error(aot, "%s: %s", filename,
+                          codegen.has_error ? codegen.error_message : "code generation failed");
+            }
+            hyp_codegen_destroy(&codegen);
+        }
+        hyp_profile_destroy(profile);
+    }
+
+    hyp_ast_image_release(&image);
+    hyp_lexer_destroy(lexer);
+    return result;
+}
+
+hyp_error_t hyp_aot_build(hyp_aot_t* aot, const char* source_file, char** binary_path) {
+    if (!aot || !source_file || !binary_path) return HYP_ERROR_INVALID_ARG;
+
+    *binary_path = NULL;
+    aot->has_error = false;
+    aot->cache_hit = false;
+
+    hyp_source_t source;
+    if (hyp_source_load(&source, source_file) != HYP_OK) {
+        aot_error(aot, "Could not read file '%s'", source_file);
+        return HYP_ERROR_IO;
+    }
+
+    aot->key = hyp_aot_cache_key(aot, source.data, source.size);
+
+    size_t path_size = strlen(aot->cache_dir) + 32;
+    char* path = HYP_MALLOC(path_size);
+    if (!path) {
+        hyp_source_release(&source);
+        return HYP_ERROR_MEMORY;
+    }
+    snprintf(path, path_size, "%s/%016llx%s", aot->cache_dir, (unsigned long long)aot->key, HYP_AOT_EXE_SUFFIX);
+
+    hyp_error_t result = HYP_OK;
+    char* reserved = NULL;
+    char* c_path = NULL;
+
+    if (!aot->force && hyp_file_exists(path)) {
+        aot->cache_hit = true;
+        if (aot->verbose) {
+            printf("AOT cache hit: %s\n", path);
+        }
+        goto done;
+    }
+
+    result = hyp_make_directory(aot->cache_dir);
+    if (result != HYP_OK) {
+        aot_error(aot, "Could not create cache directory '%s'", aot->cache_dir);
+        goto done;
+    }
+
+    /* Concurrent builds of the same program each write their own C file */
+    reserved = reserve_name(path);
+    c_path = reserved ? HYP_MALLOC(strlen(reserved) + 3) : NULL;
+    if (!c_path) {
+        aot_error(aot, "Could not create a temporary file in '%s'", aot->cache_dir);
+        result = HYP_ERROR_IO;
+        goto done;
+    }
+    sprintf(c_path, "%s.c", reserved);
+
+    result = transpile_to_c(aot, &source, source_file, c_path);
+    if (result == HYP_OK) {
+        result = hyp_aot_compile_c(aot, c_path, path);
+    }
+
+    /* The C file is only kept around for debugging failed builds */
+    if (result == HYP_OK) {
+        remove(c_path);
+    }
+
+done:
+    if (reserved) remove(reserved);
+    HYP_FREE(reserved);
+    hyp_source_release(&source);
+    HYP_FREE(c_path);
+    if (result != HYP_OK) {
+        HYP_FREE(path);
+        return result;
+    }
+
+    *binary_path = path;
+    return HYP_OK;
+}
+
+int hyp_aot_run(const char* binary_path, int argc, char* argv[]) {
+    if (!binary_path) return -1;
+
+    char** args = HYP_MALLOC(sizeof(char*) * (size_t)(argc + 2));
+    if (!args) return -1;
+
+    args[0] = (char*)binary_path;
+    for (int i = 0; i < argc; i++) {
+        args[i + 1] = argv[i];
+    }
+    args[argc + 1] = NULL;
+
+    fflush(stdout);
+    fflush(stderr);
+
+#ifdef _WIN32
+    intptr_t status = _spawnv(_P_WAIT, binary_path, (const char* const*)args);
+    HYP_FREE(args);
+    return (int)status;
+#else
+    execv(binary_path, args);
+
+    /* Only reached if exec failed */
+    HYP_FREE(args);
+    return -1;
+#endif
+}
+
+/* Collections in the native program, reported by libhyprt */
+static hyp_metric_t metric_gc_collections = HYP_COUNTER("gc.collections", "Collections in the native program");
+static hyp_metric_t metric_gc_freed = HYP_COUNTER("gc.freed_bytes", "Bytes freed by collections in the native program");
+static hyp_metric_t metric_gc_pause = HYP_HISTOGRAM("gc.pause", "Time the native program stopped to collect");
+
+static void record_gc_stats(const char* path) {
+    hyp_metric_add(&metric_gc_collections, 0);
+    hyp_metric_add(&metric_gc_freed, 0);
+
+    FILE* file = fopen(path, "r");
+    if (!file) return;
+
+    char name[64];
+    unsigned long long value;
+    while (fscanf(file, "%63s %llu", name, &value) == 2) {
+        if (strcmp(name, "gc.collections") == 0) {
+            hyp_metric_add(&metric_gc_collections, value);
+        } else if (strcmp(name, "gc.freed_bytes") == 0) {
+            hyp_metric_add(&metric_gc_freed, value);
+        } else if (strcmp(name, "gc.pause_ns") == 0) {
+            hyp_metric_observe(&metric_gc_pause, (double)value / 1e9);
+        }
+    }
+    fclose(file);
+}
+
+int hyp_aot_run_measured(const char* binary_path, int argc, char* argv[]) {
+    if (!binary_path) return -1;
+
+    /* The program writes its figures to a name of our own beside it */
+    char* stats_path = reserve_name(binary_path);
+    char** args = HYP_MALLOC(sizeof(char*) * (size_t)(argc + 2));
+    if (!stats_path || !args) {
+        if (stats_path) remove(stats_path);
+        HYP_FREE(stats_path);
+        HYP_FREE(args);
+        return -1;
+    }
+
+    args[0] = (char*)binary_path;
+    for (int i = 0; i < argc; i++) {
+        args[i + 1] = argv[i];
+    }
+    args[argc + 1] = NULL;
+
+    fflush(stdout);
+    fflush(stderr);
+
+    int status;
+#ifdef _WIN32
+    _putenv_s(HYPRT_STATS_ENV, stats_path);
+    status = (int)_spawnv(_P_WAIT, binary_path, (const char* const*)args);
+    _putenv_s(HYPRT_STATS_ENV, "");
+#else
+    pid_t child = fork();
+    if (child == 0) {
+        setenv(HYPRT_STATS_ENV, stats_path, 1);
+        execv(binary_path, args);
+        _exit(127);
+    }
+
+    int wait_status;
+    if (child < 0 || waitpid(child, &wait_status, 0) != child) {
+        status = -1;
+    } else if (WIFEXITED(wait_status)) {
+        status = WEXITSTATUS(wait_status);
+    } else {
+        status = WIFSIGNALED(wait_status) ? 128 + WTERMSIG(wait_status) : -1;
+    }
+#endif
+
+    if (status >= 0) record_gc_stats(stats_path);
+    remove(stats_path);
+    HYP_FREE(stats_path);
+    HYP_FREE(args);
+    return status;
+}
@@ -0,0 +1,546 @@
+/**
+ * Hyper Programming Language - Shared Artifact Cache Implementation
+ */
+
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L    /* getaddrinfo, mkstemp */
+#endif
+
+#include "../../include/artifact.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <io.h>
+#else
+    #include <errno.h>
+    #include <netdb.h>
+    #include <unistd.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/time.h>
+#endif
+
+/* Bump when the key derivation changes, so old artifacts are never reused */
+#define HYP_ARTIFACT_KEY_VERSION 2
+
+/* Every entry starts with "hyp-artifact <key> <digest of the rest>\n" */
+#define HYP_ARTIFACT_MAGIC "hyp-artifact "
+#define HYP_ARTIFACT_HEADER_SIZE (sizeof(HYP_ARTIFACT_MAGIC) - 1 + HYP_DIGEST_SIZE * 4 + 2)
+
+static void artifact_error(hyp_artifact_cache_t* cache, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(cache->error_message, sizeof(cache->error_message), format, args);
+    va_end(args);
+    cache->has_error = true;
+}
+
+/* Copy of the first length bytes of text */
+static char* copy_range(const char* text, size_t length) {
+    char* copy = HYP_MALLOC(length + 1);
+    if (!copy) return NULL;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/* Split "host[:port][/path]" (host may be a bracketed IPv6 literal) */
+static hyp_error_t parse_http_location(hyp_artifact_cache_t* cache, const char* rest) {
+    const char* host = rest;
+    const char* host_end;
+    const char* after;
+
+    if (*host == '[') {
+        host++;
+        host_end = strchr(host, ']');
+        if (!host_end) return HYP_ERROR_INVALID_ARG;
+        after = host_end + 1;
+    } else {
+        host_end = host + strcspn(host, ":/");
+        after = host_end;
+    }
+    if (host_end == host) return HYP_ERROR_INVALID_ARG;
+
+    const char* port = "80";
+    size_t port_length = 2;
+    if (*after == ':') {
+        port = after + 1;
+        port_length = strcspn(port, "/");
+        if (port_length == 0) return HYP_ERROR_INVALID_ARG;
+        after = port + port_length;
+    }
+    if (*after && *after != '/') return HYP_ERROR_INVALID_ARG;
+
+    /* Keep the base path without its trailing slashes; keys are appended as "/<key>" */
+    size_t path_length = strlen(after);
+    while (path_length > 0 && after[path_length - 1] == '/') path_length--;
+
+    cache->host = copy_range(host, (size_t)(host_end - host));
+    cache->port = copy_range(port, port_length);
+    cache->location = copy_range(after, path_length);
+    if (!cache->host || !cache->port || !cache->location) return HYP_ERROR_MEMORY;
+    return HYP_OK;
+}
+
+hyp_error_t hyp_artifact_cache_open(hyp_artifact_cache_t* cache, const char* location) {
+    if (!cache || !location || !*location) return HYP_ERROR_INVALID_ARG;
+
+    memset(cache, 0, sizeof(hyp_artifact_cache_t));
+
+    hyp_error_t result;
+    if (strncmp(location, "http://", 7) == 0) {
+#ifdef _WIN32
+        artifact_error(cache, "HTTP artifact caches are not supported on this platform");
+        return HYP_ERROR_INVALID_ARG;
+#else
+        cache->backend = HYP_ARTIFACT_HTTP;
+        result = parse_http_location(cache, location + 7);
+        if (result == HYP_ERROR_INVALID_ARG) {
+            artifact_error(cache, "Invalid artifact cache URL '%s'", location);
+        }
+#endif
+    } else if (strstr(location, "://") && strncmp(location, "file://", 7) != 0) {
+        artifact_error(cache, "Unsupported artifact cache '%s' (use a directory or an http:// URL)", location);
+        return HYP_ERROR_INVALID_ARG;
+    } else {
+        cache->backend = HYP_ARTIFACT_DIRECTORY;
+        if (strncmp(location, "file://", 7) == 0) location += 7;
+        cache->location = hyp_strdup(location);
+        result = cache->location ? HYP_OK : HYP_ERROR_MEMORY;
+    }
+
+    if (result == HYP_OK) {
+        cache->lock = hyp_mutex_create();
+        if (!cache->lock) result = HYP_ERROR_MEMORY;
+    }
+    if (result != HYP_OK) {
+        if (!cache->has_error) artifact_error(cache, "Out of memory");
+        hyp_artifact_cache_close(cache);
+        cache->has_error = true;
+    }
+    return result;
+}
+
+void hyp_artifact_cache_close(hyp_artifact_cache_t* cache) {
+    if (!cache) return;
+
+    HYP_FREE(cache->location);
+    HYP_FREE(cache->host);
+    HYP_FREE(cache->port);
+    if (cache->lock) {
+        hyp_mutex_destroy(cache->lock);
+        cache->lock = NULL;
+    }
+}
+
+void hyp_artifact_key(const char* source, size_t size, hyp_target_t target, bool optimize, bool debug,
+                      hyp_digest_t* key) {
+    /* Fixed-width fields, so no two inputs produce the same byte stream */
+    uint8_t settings[12] = { HYP_ARTIFACT_KEY_VERSION, (uint8_t)target, optimize, debug };
+    uint64_t source_size = size;
+    for (int i = 0; i < 8; i++) {
+        settings[4 + i] = (uint8_t)(source_size >> (i * 8));
+    }
+
+    hyp_sha256_t sha;
+    hyp_sha256_init(&sha);
+    hyp_sha256_update(&sha, HYP_VERSION_STRING, strlen(HYP_VERSION_STRING) + 1);
+    hyp_sha256_update(&sha, settings, sizeof(settings));
+    hyp_sha256_update(&sha, source, size);
+    hyp_sha256_final(&sha, key);
+}
+
+/* Entry for data: the header line followed by the data */
+static char* artifact_seal(const hyp_digest_t* key, const char* data, size_t size, size_t* sealed_size) {
+    char* sealed = HYP_MALLOC(HYP_ARTIFACT_HEADER_SIZE + size + 1);
+    if (!sealed) return NULL;
+
+    hyp_digest_t digest;
+    hyp_sha256(data, size, &digest);
+    char key_hex[HYP_DIGEST_HEX_SIZE];
+    char digest_hex[HYP_DIGEST_HEX_SIZE];
+    hyp_digest_hex(key, key_hex);
+    hyp_digest_hex(&digest, digest_hex);
+
+    sprintf(sealed, "%s%s %s\n", HYP_ARTIFACT_MAGIC, key_hex, digest_hex);
+    if (size > 0) memcpy(sealed + HYP_ARTIFACT_HEADER_SIZE, data, size);
+    *sealed_size = HYP_ARTIFACT_HEADER_SIZE + size;
+    return sealed;
+}
+
+/* Check an entry against its key and strip the header in place */
+static bool artifact_unseal(const hyp_digest_t* key, char* data, size_t* size) {
+    if (*size < HYP_ARTIFACT_HEADER_SIZE) return false;
+
+    size_t payload_size = *size - HYP_ARTIFACT_HEADER_SIZE;
+    hyp_digest_t digest;
+    hyp_sha256(data + HYP_ARTIFACT_HEADER_SIZE, payload_size, &digest);
+
+    char expected[HYP_ARTIFACT_HEADER_SIZE + 1];
+    char key_hex[HYP_DIGEST_HEX_SIZE];
+    char digest_hex[HYP_DIGEST_HEX_SIZE];
+    hyp_digest_hex(key, key_hex);
+    hyp_digest_hex(&digest, digest_hex);
+    sprintf(expected, "%s%s %s\n", HYP_ARTIFACT_MAGIC, key_hex, digest_hex);
+    if (memcmp(data, expected, HYP_ARTIFACT_HEADER_SIZE) != 0) return false;
+
+    memmove(data, data + HYP_ARTIFACT_HEADER_SIZE, payload_size);
+    data[payload_size] = '\0';
+    *size = payload_size;
+    return true;
+}
+
+/* Statistics and the offline switch are shared by every worker */
+static bool artifact_offline(hyp_artifact_cache_t* cache) {
+    hyp_mutex_lock(cache->lock);
+    bool offline = cache->offline;
+    hyp_mutex_unlock(cache->lock);
+    return offline;
+}
+
+static bool artifact_read_only(hyp_artifact_cache_t* cache) {
+    hyp_mutex_lock(cache->lock);
+    bool read_only = cache->offline || cache->read_only;
+    hyp_mutex_unlock(cache->lock);
+    return read_only;
+}
+
+static void artifact_count(hyp_artifact_cache_t* cache, size_t* counter, bool* disable) {
+    hyp_mutex_lock(cache->lock);
+    (*counter)++;
+    if (disable) *disable = true;
+    hyp_mutex_unlock(cache->lock);
+}
+
+/* Directory backend: <dir>/<first two hex digits>/<key> */
+static char* artifact_path(const hyp_artifact_cache_t* cache, const hyp_digest_t* key, bool parent_only) {
+    size_t length = strlen(cache->location);
+    char* path = HYP_MALLOC(length + HYP_DIGEST_HEX_SIZE + 5);
+    if (!path) return NULL;
+
+    char name[HYP_DIGEST_HEX_SIZE];
+    hyp_digest_hex(key, name);
+    if (parent_only) {
+        sprintf(path, "%s/%.2s", cache->location, name);
+    } else {
+        sprintf(path, "%s/%.2s/%s", cache->location, name, name);
+    }
+    return path;
+}
+
+static hyp_error_t directory_get(hyp_artifact_cache_t* cache, const hyp_digest_t* key, char** data, size_t* size) {
+    char* path = artifact_path(cache, key, false);
+    if (!path) return HYP_ERROR_MEMORY;
+
+    *data = hyp_read_file(path, size);
+    HYP_FREE(path);
+    return *data ? HYP_OK : HYP_ERROR_NOT_FOUND;
+}
+
+static hyp_error_t directory_put(hyp_artifact_cache_t* cache, const hyp_digest_t* key, const char* data, size_t size) {
+    char* parent = artifact_path(cache, key, true);
+    char* path = artifact_path(cache, key, false);
+    char* temp_path = path ? HYP_MALLOC(strlen(path) + 40) : NULL;
+    if (!parent || !temp_path) {
+        HYP_FREE(parent);
+        HYP_FREE(path);
+        HYP_FREE(temp_path);
+        return HYP_ERROR_MEMORY;
+    }
+
+    hyp_error_t result = hyp_make_directory(parent);
+    HYP_FREE(parent);
+
+    /* A name no other writer (thread, process or machine) can pick, so
+     * each one renames a complete file of its own into place */
+    int fd = -1;
+    if (result == HYP_OK) {
+#ifdef _WIN32
+        sprintf(temp_path, "%s.%lu.%lu.tmp", path, (unsigned long)GetCurrentProcessId(),
+                (unsigned long)GetCurrentThreadId());
+        fd = hyp_create_file(temp_path);
+#else
+        sprintf(temp_path, "%s.XXXXXX", path);
+        fd = mkstemp(temp_path);
+        if (fd >= 0) fchmod(fd, 0644);    /* mkstemp keeps other users out of a shared cache */
+#endif
+    }
+
+    if (fd < 0) {
+        result = HYP_ERROR_IO;
+    } else {
+        size_t written = 0;
+        while (written < size) {
+#ifdef _WIN32
+            int count = _write(fd, data + written, (unsigned int)(size - written));
+#else
+            ssize_t count = write(fd, data + written, size - written);
+            if (count < 0 && errno == EINTR) continue;
+#endif
+            if (count <= 0) break;
+            written += (size_t)count;
+        }
+        if (hyp_close_file(fd) != HYP_OK || written != size) {
+            result = HYP_ERROR_IO;
+        } else if (rename(temp_path, path) != 0) {
+            /* Windows refuses to replace a file; an artifact already in
+             * place has the same contents */
+            result = hyp_file_exists(path) ? HYP_OK : HYP_ERROR_IO;
+        }
+        if (result != HYP_OK || hyp_file_exists(temp_path)) {
+            remove(temp_path);
+        }
+    }
+
+    HYP_FREE(path);
+    HYP_FREE(temp_path);
+    return result;
+}
+
+#ifndef _WIN32
+
+/* HTTP backend: one HTTP/1.0 request per connection, so the server
+ * closing the connection marks the end of the response */
+static int http_connect(const hyp_artifact_cache_t* cache) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* addresses;
+    if (getaddrinfo(cache->host, cache->port, &hints, &addresses) != 0) return -1;
+
+    int fd = -1;
+    for (struct addrinfo* address = addresses; address; address = address->ai_next) {
+        fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) continue;
+
+        struct timeval timeout = { HYP_ARTIFACT_TIMEOUT, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) break;
+
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    return fd;
+}
+
+static bool http_send_all(int fd, const char* data, size_t size) {
+#ifdef MSG_NOSIGNAL
+    int flags = MSG_NOSIGNAL;    /* A server hanging up must not raise SIGPIPE */
+#else
+    int flags = 0;
+#endif
+    while (size > 0) {
+        ssize_t count = send(fd, data, size, flags);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        data += count;
+        size -= (size_t)count;
+    }
+    return true;
+}
+
+/* Value of a header in the NUL-terminated header block, or NULL */
+static const char* http_header(const char* headers, const char* name) {
+    size_t length = strlen(name);
+    for (const char* line = strstr(headers, "\r\n"); line; line = strstr(line, "\r\n")) {
+        line += 2;
+        size_t i = 0;
+        while (i < length && line[i] && (line[i] | 0x20) == (name[i] | 0x20)) i++;
+        if (i == length && line[i] == ':') {
+            const char* value = line + i + 1;
+            while (*value == ' ' || *value == '\t') value++;
+            return value;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Send one request and read the whole response
+ * @return HTTP status, or -1 if the server could not be reached or
+ *         answered with something other than a complete response
+ */
+static int http_request(hyp_artifact_cache_t* cache, const char* method, const hyp_digest_t* key,
+                        const char* body, size_t body_size, char** response_body, size_t* response_size) {
+    int fd = http_connect(cache);
+    if (fd < 0) return -1;
+
+    char name[HYP_DIGEST_HEX_SIZE];
+    hyp_digest_hex(key, name);
+
+    char header[1024];
+    int header_length = snprintf(header, sizeof(header),
+                                 "%s %s/%s HTTP/1.0\r\n"
+                                 "Host: %s:%s\r\n"
+                                 "User-Agent: hypc/%s\r\n"
+                                 "Content-Type: application/octet-stream\r\n"
+                                 "Content-Length: %zu\r\n"
+                                 "\r\n",
+                                 method, cache->location, name,
+                                 cache->host, cache->port, HYP_VERSION_STRING, body_size);
+    if (header_length < 0 || (size_t)header_length >= sizeof(header) ||
+        !http_send_all(fd, header, (size_t)header_length) ||
+        (body_size > 0 && !http_send_all(fd, body, body_size))) {
+        close(fd);
+        return -1;
+    }
+
+    /* Read until the server closes the connection */
+    size_t capacity = 16384;
+    size_t length = 0;
+    char* response = HYP_MALLOC(capacity + 1);
+    bool complete = response != NULL;
+    while (complete) {
+        if (length == capacity) {
+            if (capacity >= HYP_ARTIFACT_MAX_SIZE) {
+                complete = false;
+                break;
+            }
+            capacity *= 2;
+            char* grown = HYP_REALLOC(response, capacity + 1);
+            if (!grown) {
+                complete = false;
+                break;
+            }
+            response = grown;
+        }
+        ssize_t count = recv(fd, response + length, capacity - length, 0);
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0) complete = false;    /* Includes timeouts */
+        if (count <= 0) break;
+        length += (size_t)count;
+    }
+    close(fd);
+
+    int status = -1;
+    char* body_start = NULL;
+    if (complete) {
+        response[length] = '\0';
+        body_start = strstr(response, "\r\n\r\n");
+        if (!body_start || sscanf(response, "HTTP/%*d.%*d %d", &status) != 1) status = -1;
+    }
+    if (status < 0) {
+        HYP_FREE(response);
+        return -1;
+    }
+
+    *body_start = '\0';
+    body_start += 4;
+    size_t size = length - (size_t)(body_start - response);
+
+    /* A body shorter than announced means the transfer was cut off */
+    const char* announced = http_header(response, "Content-Length");
+    if (announced && strtoull(announced, NULL, 10) != (unsigned long long)size) {
+        HYP_FREE(response);
+        return -1;
+    }
+
+    if (response_body) {
+        memmove(response, body_start, size);
+        response[size] = '\0';
+        *response_body = response;
+        *response_size = size;
+    } else {
+        HYP_FREE(response);
+    }
+    return status;
+}
+
+static hyp_error_t http_get(hyp_artifact_cache_t* cache, const hyp_digest_t* key, char** data, size_t* size) {
+    char* body = NULL;
+    size_t body_size = 0;
+    int status = http_request(cache, "GET", key, NULL, 0, &body, &body_size);
+
+    if (status == 200) {
+        *data = body;
+        *size = body_size;
+        return HYP_OK;
+    }
+    HYP_FREE(body);
+    return status == 404 ? HYP_ERROR_NOT_FOUND : HYP_ERROR_IO;
+}
+
+static hyp_error_t http_put(hyp_artifact_cache_t* cache, const hyp_digest_t* key, const char* data, size_t size) {
+    int status = http_request(cache, "PUT", key, data, size, NULL, NULL);
+    return status >= 200 && status < 300 ? HYP_OK : HYP_ERROR_IO;
+}
+
+#endif /* !_WIN32 */
+
+hyp_error_t hyp_artifact_get(hyp_artifact_cache_t* cache, const hyp_digest_t* key, char** data, size_t* size) {
+    if (!cache || !data || !size) return HYP_ERROR_INVALID_ARG;
+
+    *data = NULL;
+    *size = 0;
+    if (artifact_offline(cache)) return HYP_ERROR_NOT_FOUND;
+
+    hyp_error_t result;
+#ifndef _WIN32
+    if (cache->backend == HYP_ARTIFACT_HTTP) {
+        result = http_get(cache, key, data, size);
+    } else
+#endif
+    {
+        result = directory_get(cache, key, data, size);
+    }
+
+    if (result == HYP_OK && !artifact_unseal(key, *data, size)) {
+        /* Damaged or stored under the wrong key: never use it, and drop
+         * it from a directory so the next store replaces it */
+        HYP_FREE(*data);
+        *data = NULL;
+        *size = 0;
+        if (cache->backend == HYP_ARTIFACT_DIRECTORY) {
+            char* path = artifact_path(cache, key, false);
+            if (path) remove(path);
+            HYP_FREE(path);
+        }
+        artifact_count(cache, &cache->rejected, NULL);
+        result = HYP_ERROR_NOT_FOUND;
+    }
+
+    if (result == HYP_OK) {
+        artifact_count(cache, &cache->hits, NULL);
+    } else if (result == HYP_ERROR_NOT_FOUND) {
+        artifact_count(cache, &cache->misses, NULL);
+    } else {
+        artifact_count(cache, &cache->failures, &cache->offline);
+    }
+    return result;
+}
+
+hyp_error_t hyp_artifact_put(hyp_artifact_cache_t* cache, const hyp_digest_t* key, const char* data, size_t size) {
+    if (!cache || (!data && size > 0)) return HYP_ERROR_INVALID_ARG;
+    if (artifact_read_only(cache)) return HYP_ERROR_IO;
+
+    size_t sealed_size;
+    char* sealed = artifact_seal(key, data, size, &sealed_size);
+    if (!sealed) return HYP_ERROR_MEMORY;
+
+    hyp_error_t result;
+#ifndef _WIN32
+    if (cache->backend == HYP_ARTIFACT_HTTP) {
+        result = http_put(cache, key, sealed, sealed_size);
+    } else
+#endif
+    {
+        result = directory_put(cache, key, sealed, sealed_size);
+    }
+    HYP_FREE(sealed);
+
+    if (result == HYP_OK) {
+        artifact_count(cache, &cache->stores, NULL);
+    } else {
+        /* Typically a read-only share; lookups may still hit */
+        artifact_count(cache, &cache->failures, &cache->read_only);
+    }
+    return result;
+}
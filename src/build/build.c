@@ -0,0 +1,1318 @@
+/**
+ * Hyper Programming Language - Project Builds Implementation
+ */
+
+#include "../../include/build.h"
+#include "../../include/lexer.h"
+#include "../../include/parser.h"
+#include "../../include/hyp_thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <dirent.h>
+#endif
+
+static void build_error(hyp_build_t* build, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(build->error_message, sizeof(build->error_message), format, args);
+    va_end(args);
+    build->has_error = true;
+}
+
+/* Join two path pieces with a '/' (either may be empty) */
+static char* path_join(const char* a, const char* b) {
+    size_t a_length = strlen(a);
+    size_t b_length = strlen(b);
+    char* path = HYP_MALLOC(a_length + b_length + 2);
+    if (!path) return NULL;
+
+    memcpy(path, a, a_length);
+    size_t length = a_length;
+    if (a_length > 0 && b_length > 0 && a[a_length - 1] != '/') {
+        path[length++] = '/';
+    }
+    memcpy(path + length, b, b_length + 1);
+    return path;
+}
+
+static bool is_directory(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0) return false;
+#ifdef _WIN32
+    return (st.st_mode & _S_IFDIR) != 0;
+#else
+    return S_ISDIR(st.st_mode);
+#endif
+}
+
+/* Drop "./" prefixes and trailing slashes; "." becomes "" */
+static char* normalize_relative(const char* path) {
+    while (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) path += 2;
+    if (strcmp(path, ".") == 0) path = "";
+
+    char* result = hyp_strdup(path);
+    if (!result) return NULL;
+
+    size_t length = strlen(result);
+    while (length > 0 && (result[length - 1] == '/' || result[length - 1] == '\\')) {
+        result[--length] = '\0';
+    }
+    return result;
+}
+
+/* Manifest reading
+ *
+ * package.yml only uses block-style YAML: mappings nested by indentation,
+ * "- item" sequences and plain or quoted scalars. The reader reports
+ * every scalar with the dotted path of its key (e.g. "build.srcDir");
+ * sequence items are reported with the path of the sequence.
+ */
+#define YAML_MAX_DEPTH 16
+#define YAML_MAX_KEY 64
+
+typedef void (*yaml_value_fn_t)(void* context, const char* path, const char* value, bool list_item);
+
+/* Trim and remove a trailing comment and matching quotes, in place */
+static char* yaml_scalar(char* text) {
+    while (*text == ' ' || *text == '\t') text++;
+
+    char quote = (*text == '"' || *text == '\'') ? *text : '\0';
+    if (quote) {
+        char* end = strchr(text + 1, quote);
+        if (end) {
+            *end = '\0';
+            return text + 1;
+        }
+    }
+
+    for (char* p = text; *p; p++) {
+        if (*p == '#' && (p == text || p[-1] == ' ' || p[-1] == '\t')) {
+            *p = '\0';
+            break;
+        }
+    }
+
+    size_t length = strlen(text);
+    while (length > 0 && (text[length - 1] == ' ' || text[length - 1] == '\t' || text[length - 1] == '\r')) {
+        text[--length] = '\0';
+    }
+    return text;
+}
+
+static void yaml_read(char* text, yaml_value_fn_t callback, void* context) {
+    struct {
+        int indent;
+        char key[YAML_MAX_KEY];
+    } stack[YAML_MAX_DEPTH];
+    int depth = 0;
+    char path[YAML_MAX_DEPTH * YAML_MAX_KEY];
+
+    char* line = text;
+    while (line && *line) {
+        char* next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+
+        int indent = 0;
+        while (line[indent] == ' ') indent++;
+        char* content = line + indent;
+
+        if (*content == '\0' || *content == '#' || *content == '\r') {
+            line = next;
+            continue;
+        }
+
+        /* Sequence items belong to the innermost key above them */
+        bool list_item = content[0] == '-' && (content[1] == ' ' || content[1] == '\0');
+        while (depth > 0 && (list_item ? stack[depth - 1].indent > indent : stack[depth - 1].indent >= indent)) {
+            depth--;
+        }
+
+        path[0] = '\0';
+        for (int i = 0; i < depth; i++) {
+            if (i > 0) strcat(path, ".");
+            strcat(path, stack[i].key);
+        }
+
+        if (list_item) {
+            callback(context, path, yaml_scalar(content + 1), true);
+            line = next;
+            continue;
+        }
+
+        /* "key: value" or "key:" opening a nested mapping */
+        char* colon = NULL;
+        char quote = '\0';
+        for (char* p = content; *p; p++) {
+            if (quote) {
+                if (*p == quote) quote = '\0';
+            } else if (*p == '"' || *p == '\'') {
+                quote = *p;
+            } else if (*p == ':' && (p[1] == ' ' || p[1] == '\0' || p[1] == '\r')) {
+                colon = p;
+                break;
+            }
+        }
+        if (!colon) {
+            line = next;
+            continue;
+        }
+
+        *colon = '\0';
+        char* key = yaml_scalar(content);
+        char* value = yaml_scalar(colon + 1);
+
+        if (*value == '\0') {
+            if (depth < YAML_MAX_DEPTH) {
+                stack[depth].indent = indent;
+                snprintf(stack[depth].key, YAML_MAX_KEY, "%s", key);
+                depth++;
+            }
+        } else {
+            size_t length = strlen(path);
+            snprintf(path + length, sizeof(path) - length, "%s%s", length ? "." : "", key);
+            callback(context, path, value, false);
+        }
+
+        line = next;
+    }
+}
+
+static void config_replace(char** field, const char* value) {
+    char* copy = normalize_relative(value);
+    if (!copy) return;
+    HYP_FREE(*field);
+    *field = copy;
+}
+
+static void config_value(void* context, const char* path, const char* value, bool list_item) {
+    hyp_build_config_t* config = context;
+
+    if (list_item) {
+        char* copy = hyp_strdup(value);
+        if (!copy) return;
+        if (strcmp(path, "build.include") == 0) {
+            HYP_ARRAY_PUSH(&config->include, copy);
+        } else if (strcmp(path, "build.exclude") == 0) {
+            HYP_ARRAY_PUSH(&config->exclude, copy);
+        } else {
+            HYP_FREE(copy);
+        }
+        return;
+    }
+
+    if (strcmp(path, "build.srcDir") == 0) {
+        config_replace(&config->src_dir, value);
+    } else if (strcmp(path, "build.outDir") == 0) {
+        config_replace(&config->out_dir, value);
+    } else if (strcmp(path, "build.cache") == 0) {
+        char* copy = hyp_strdup(value);
+        if (copy) {
+            HYP_FREE(config->cache);
+            config->cache = copy;
+        }
+    } else if (strcmp(path, "build.compiler.target") == 0) {
+        if (strcmp(value, "js") == 0 || strcmp(value, "javascript") == 0) {
+            config->target = TARGET_JAVASCRIPT;
+        } else {
+            config->target = TARGET_C;
+        }
+    } else if (strcmp(path, "build.compiler.optimization") == 0) {
+        config->optimize = strcmp(value, "O0") != 0 && strcmp(value, "none") != 0;
+    } else if (strcmp(path, "build.compiler.debug") == 0) {
+        config->debug = strcmp(value, "true") == 0;
+    }
+}
+
+hyp_error_t hyp_build_config_load(hyp_build_config_t* config, const char* project) {
+    if (!config || !project) return HYP_ERROR_INVALID_ARG;
+
+    memset(config, 0, sizeof(hyp_build_config_t));
+    HYP_ARRAY_INIT(&config->include);
+    HYP_ARRAY_INIT(&config->exclude);
+    config->target = TARGET_C;
+
+    /* Accept either the project directory or its manifest */
+    char* manifest;
+    if (is_directory(project)) {
+        config->root = hyp_strdup(project);
+        manifest = path_join(project, HYP_BUILD_MANIFEST);
+    } else {
+        manifest = hyp_strdup(project);
+        const char* slash = strrchr(project, '/');
+        const char* backslash = strrchr(project, '\\');
+        if (backslash > slash) slash = backslash;
+        if (slash) {
+            config->root = HYP_MALLOC((size_t)(slash - project) + 1);
+            if (config->root) {
+                memcpy(config->root, project, (size_t)(slash - project));
+                config->root[slash - project] = '\0';
+            }
+        } else {
+            config->root = hyp_strdup(".");
+        }
+    }
+
+    config->src_dir = hyp_strdup(HYP_BUILD_DEFAULT_SRC_DIR);
+    config->out_dir = hyp_strdup(HYP_BUILD_DEFAULT_OUT_DIR);
+    if (!manifest || !config->root || !config->src_dir || !config->out_dir) {
+        HYP_FREE(manifest);
+        return HYP_ERROR_MEMORY;
+    }
+
+    size_t size;
+    char* text = hyp_read_file(manifest, &size);
+    HYP_FREE(manifest);
+    if (!text) return HYP_ERROR_IO;
+
+    yaml_read(text, config_value, config);
+    HYP_FREE(text);
+    return HYP_OK;
+}
+
+void hyp_build_config_destroy(hyp_build_config_t* config) {
+    if (!config) return;
+
+    for (size_t i = 0; i < config->include.count; i++) HYP_FREE(config->include.data[i]);
+    for (size_t i = 0; i < config->exclude.count; i++) HYP_FREE(config->exclude.data[i]);
+    HYP_ARRAY_FREE(&config->include);
+    HYP_ARRAY_FREE(&config->exclude);
+    HYP_FREE(config->root);
+    HYP_FREE(config->src_dir);
+    HYP_FREE(config->out_dir);
+    HYP_FREE(config->cache);
+}
+
+bool hyp_glob_match(const char* pattern, const char* path) {
+    while (*pattern) {
+        if (pattern[0] == '*' && pattern[1] == '*') {
+            pattern += 2;
+            if (*pattern == '/') {
+                /* "**" followed by '/' matches zero or more whole components */
+                pattern++;
+                for (;;) {
+                    if (hyp_glob_match(pattern, path)) return true;
+                    path = strchr(path, '/');
+                    if (!path) return false;
+                    path++;
+                }
+            }
+            for (;; path++) {
+                if (hyp_glob_match(pattern, path)) return true;
+                if (!*path) return false;
+            }
+        }
+
+        if (*pattern == '*') {
+            pattern++;
+            for (;; path++) {
+                if (hyp_glob_match(pattern, path)) return true;
+                if (!*path || *path == '/') return false;
+            }
+        }
+
+        if (!*path) return false;
+        if (*pattern == '?') {
+            if (*path == '/') return false;
+        } else if (*pattern != *path) {
+            return false;
+        }
+        pattern++;
+        path++;
+    }
+    return *path == '\0';
+}
+
+hyp_error_t hyp_build_init(hyp_build_t* build, const char* project) {
+    if (!build || !project) return HYP_ERROR_INVALID_ARG;
+
+    memset(build, 0, sizeof(hyp_build_t));
+    HYP_ARRAY_INIT(&build->units);
+    HYP_ARRAY_INIT(&build->records);
+    build->jobs = hyp_worker_count(0);
+
+    hyp_error_t result = hyp_build_config_load(&build->config, project);
+    if (result == HYP_ERROR_IO) {
+        build_error(build, "Could not read %s in '%s'", HYP_BUILD_MANIFEST, project);
+    } else if (result != HYP_OK) {
+        build_error(build, "Could not load the build configuration");
+    }
+    return result;
+}
+
+/* Project scanning */
+static bool build_selects(const hyp_build_config_t* config, const char* path) {
+    size_t length = strlen(path);
+    size_t extension = strlen(HYP_BUILD_SOURCE_EXTENSION);
+    if (length <= extension || strcmp(path + length - extension, HYP_BUILD_SOURCE_EXTENSION) != 0) {
+        return false;
+    }
+
+    bool included = config->include.count == 0 && hyp_glob_match(HYP_BUILD_DEFAULT_INCLUDE, path);
+    for (size_t i = 0; i < config->include.count && !included; i++) {
+        included = hyp_glob_match(config->include.data[i], path);
+    }
+    if (!included) return false;
+
+    for (size_t i = 0; i < config->exclude.count; i++) {
+        if (hyp_glob_match(config->exclude.data[i], path)) return false;
+    }
+    return true;
+}
+
+static hyp_error_t build_add_unit(hyp_build_t* build, const char* source) {
+    const hyp_build_config_t* config = &build->config;
+
+    /* Output mirrors the layout under srcDir */
+    const char* relative = source;
+    size_t src_length = strlen(config->src_dir);
+    if (src_length > 0) relative += src_length + 1;
+
+    const char* extension;
+    switch (config->target) {
+        case TARGET_JAVASCRIPT: extension = ".js"; break;
+        default: extension = ".c"; break;
+    }
+
+    size_t stem = strlen(relative) - strlen(HYP_BUILD_SOURCE_EXTENSION);
+    size_t out_length = strlen(config->out_dir);
+    char* output = HYP_MALLOC(out_length + 1 + stem + strlen(extension) + 1);
+    char* copy = hyp_strdup(source);
+    if (!output || !copy) {
+        HYP_FREE(output);
+        HYP_FREE(copy);
+        return HYP_ERROR_MEMORY;
+    }
+    sprintf(output, "%s%s%.*s%s", config->out_dir, out_length ? "/" : "", (int)stem, relative, extension);
+
+    hyp_build_unit_t unit;
+    memset(&unit, 0, sizeof(unit));
+    unit.source = copy;
+    unit.output = output;
+    HYP_ARRAY_PUSH(&build->units, unit);
+    return HYP_OK;
+}
+
+/* Walk a root-relative directory, adding every selected module */
+static hyp_error_t build_scan_directory(hyp_build_t* build, const char* relative) {
+    char* directory = path_join(build->config.root, relative);
+    if (!directory) return HYP_ERROR_MEMORY;
+
+    hyp_error_t result = HYP_OK;
+
+#ifdef _WIN32
+    char* pattern = path_join(directory, "*");
+    WIN32_FIND_DATAA entry;
+    HANDLE handle = pattern ? FindFirstFileA(pattern, &entry) : INVALID_HANDLE_VALUE;
+    HYP_FREE(pattern);
+    if (handle == INVALID_HANDLE_VALUE) {
+        HYP_FREE(directory);
+        return HYP_ERROR_IO;
+    }
+    do {
+        const char* name = entry.cFileName;
+#else
+    DIR* dir = opendir(directory);
+    if (!dir) {
+        HYP_FREE(directory);
+        return HYP_ERROR_IO;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        const char* name = entry->d_name;
+#endif
+        /* Skips ".", ".." and hidden directories such as .hypkg */
+        if (name[0] == '.') continue;
+
+        char* child = path_join(relative, name);
+        char* full = child ? path_join(build->config.root, child) : NULL;
+        if (!child || !full) {
+            HYP_FREE(child);
+            HYP_FREE(full);
+            result = HYP_ERROR_MEMORY;
+            break;
+        }
+
+        if (is_directory(full)) {
+            result = build_scan_directory(build, child);
+        } else if (build_selects(&build->config, child)) {
+            result = build_add_unit(build, child);
+        }
+        HYP_FREE(child);
+        HYP_FREE(full);
+        if (result == HYP_ERROR_MEMORY) break;
+#ifdef _WIN32
+    } while (FindNextFileA(handle, &entry));
+    FindClose(handle);
+#else
+    }
+    closedir(dir);
+#endif
+
+    HYP_FREE(directory);
+    return result;
+}
+
+static int compare_units(const void* a, const void* b) {
+    return strcmp(((const hyp_build_unit_t*)a)->source, ((const hyp_build_unit_t*)b)->source);
+}
+
+hyp_error_t hyp_build_scan(hyp_build_t* build) {
+    if (!build) return HYP_ERROR_INVALID_ARG;
+
+    double started = hyp_wall_time();
+
+    char* src = path_join(build->config.root, build->config.src_dir);
+    bool exists = src && is_directory(src);
+    HYP_FREE(src);
+    if (!exists) {
+        build_error(build, "Source directory '%s' does not exist", build->config.src_dir);
+        return HYP_ERROR_IO;
+    }
+
+    hyp_error_t result = build_scan_directory(build, build->config.src_dir);
+    if (result != HYP_OK) {
+        build_error(build, "Could not scan '%s'", build->config.src_dir);
+        return result;
+    }
+
+    /* Workers finish in any order; results are reported in path order */
+    if (build->units.count > 1) {
+        qsort(build->units.data, build->units.count, sizeof(hyp_build_unit_t), compare_units);
+    }
+
+    build->scan_time = hyp_wall_time() - started;
+    return HYP_OK;
+}
+
+/* Compilation */
+static void unit_fail(hyp_build_unit_t* unit, const char* format, ...) {
+    if (unit->failed) return;
+
+    char message[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    unit->failed = true;
+    unit->error = hyp_strdup(message);
+}
+
+/* Create the directory that will hold a file */
+static hyp_error_t make_parent_directory(const char* path) {
+    const char* slash = strrchr(path, '/');
+    if (!slash || slash == path) return HYP_OK;
+
+    char* parent = HYP_MALLOC((size_t)(slash - path) + 1);
+    if (!parent) return HYP_ERROR_MEMORY;
+    memcpy(parent, path, (size_t)(slash - path));
+    parent[slash - path] = '\0';
+
+    hyp_error_t result = hyp_make_directory(parent);
+    HYP_FREE(parent);
+    return result;
+}
+
+/* Generate one parsed module into its output file */
+static void build_generate(hyp_build_t* build, hyp_build_unit_t* unit, hyp_ast_node_t* ast) {
+    const hyp_build_config_t* config = &build->config;
+
+    char* output = path_join(config->root, unit->output);
+    if (!output) {
+        unit_fail(unit, "out of memory");
+        return;
+    }
+
+    int fd = make_parent_directory(output) == HYP_OK ? hyp_create_file(output) : -1;
+    if (fd < 0) {
+        unit_fail(unit, "could not create '%s'", unit->output);
+        HYP_FREE(output);
+        return;
+    }
+
+    hyp_codegen_options_t options = {
+        .target = config->target,
+        .optimize = config->optimize,
+        .debug_info = config->debug
+    };
+    hyp_codegen_t codegen;
+    hyp_error_t result = hyp_codegen_init(&codegen, &options, NULL);
+    if (result == HYP_OK) {
+        hyp_codegen_set_output_fd(&codegen, fd);
+        result = hyp_codegen_generate(&codegen, ast);
+        unit->output_bytes = hyp_codegen_get_output_length(&codegen);
+        if (result != HYP_OK) {
+            unit_fail(unit, "%s", codegen.has_error ? codegen.error_message : "code generation failed");
+        }
+        hyp_codegen_destroy(&codegen);
+    } else {
+        unit_fail(unit, "could not initialize code generator");
+    }
+
+    if (hyp_close_file(fd) != HYP_OK) {
+        unit_fail(unit, "could not write '%s'", unit->output);
+    }
+    if (unit->failed) {
+        remove(output);
+    }
+    HYP_FREE(output);
+}
+
+/* Dependency information */
+static void paths_clear(hyp_build_paths_t* paths) {
+    for (size_t i = 0; i < paths->count; i++) HYP_FREE(paths->data[i]);
+    paths->count = 0;
+}
+
+static void paths_free(hyp_build_paths_t* paths) {
+    paths_clear(paths);
+    HYP_ARRAY_FREE(paths);
+}
+
+static bool paths_add(hyp_build_paths_t* paths, const char* path) {
+    for (size_t i = 0; i < paths->count; i++) {
+        if (strcmp(paths->data[i], path) == 0) return true;
+    }
+    char* copy = hyp_strdup(path);
+    if (!copy) return false;
+    HYP_ARRAY_PUSH(paths, copy);
+    return true;
+}
+
+uint64_t hyp_build_interface_hash(const hyp_ast_node_t* program) {
+    uint64_t hash = HYP_HASH_SEED;
+    if (!program || program->type != AST_PROGRAM) return hash;
+
+    for (size_t i = 0; i < program->program.statements.count; i++) {
+        const hyp_ast_node_t* stmt = HYP_AST_AT(program, program.statements, i);
+        if (stmt->type == AST_FUNCTION_DECL) {
+            uint64_t arity = stmt->function_decl.parameters.count;
+            hash = hyp_hash_string("fn", hash);
+            hash = hyp_hash_string(HYP_AST_TEXT(stmt, function_decl.name), hash);
+            hash = hyp_hash_bytes(&arity, sizeof(arity), hash);
+        } else if (stmt->type == AST_VARIABLE_DECL) {
+            hash = hyp_hash_string(stmt->variable_decl.is_const ? "const" : "let", hash);
+            hash = hyp_hash_string(HYP_AST_TEXT(stmt, variable_decl.name), hash);
+        }
+    }
+    return hash;
+}
+
+char* hyp_build_resolve_import(const char* importer, const char* module) {
+    if (!importer || !module) return NULL;
+
+    /* Only relative imports name modules of this project */
+    if (strncmp(module, "./", 2) != 0 && strncmp(module, "../", 3) != 0) return NULL;
+
+    const char* slash = strrchr(importer, '/');
+    size_t length = slash ? (size_t)(slash - importer) : 0;
+    size_t extension = strlen(HYP_BUILD_SOURCE_EXTENSION);
+    char* path = HYP_MALLOC(length + strlen(module) + extension + 2);
+    if (!path) return NULL;
+    memcpy(path, importer, length);
+
+    for (const char* part = module; *part; ) {
+        const char* end = strchr(part, '/');
+        size_t part_length = end ? (size_t)(end - part) : strlen(part);
+
+        if (part_length == 2 && part[0] == '.' && part[1] == '.') {
+            if (length == 0) {
+                HYP_FREE(path);
+                return NULL;
+            }
+            while (length > 0 && path[length - 1] != '/') length--;
+            if (length > 0) length--;
+        } else if (part_length > 0 && !(part_length == 1 && part[0] == '.')) {
+            if (length > 0) path[length++] = '/';
+            memcpy(path + length, part, part_length);
+            length += part_length;
+        }
+
+        part += part_length;
+        if (*part == '/') part++;
+    }
+    path[length] = '\0';
+
+    if (length == 0) {
+        HYP_FREE(path);
+        return NULL;
+    }
+    if (length <= extension || strcmp(path + length - extension, HYP_BUILD_SOURCE_EXTENSION) != 0) {
+        memcpy(path + length, HYP_BUILD_SOURCE_EXTENSION, extension + 1);
+    }
+    return path;
+}
+
+static bool build_collect_imports(hyp_build_unit_t* unit, const hyp_ast_node_t* program) {
+    paths_clear(&unit->imports);
+
+    for (size_t i = 0; i < program->program.statements.count; i++) {
+        const hyp_ast_node_t* stmt = HYP_AST_AT(program, program.statements, i);
+        if (stmt->type != AST_IMPORT_STMT || !HYP_AST_TEXT(stmt, import_stmt.module)) continue;
+
+        char* path = hyp_build_resolve_import(unit->source, HYP_AST_TEXT(stmt, import_stmt.module));
+        if (!path) continue;
+        bool added = paths_add(&unit->imports, path);
+        HYP_FREE(path);
+        if (!added) return false;
+    }
+    return true;
+}
+
+/* Build database
+ *
+ * Line-oriented text, written in path order after every build:
+ *
+ *   HBUILD <version>
+ *   config <hash>
+ *   unit <content-hash> <interface-hash> <output-bytes> <source>
+ *   import <source>
+ *   end
+ *
+ * The config hash covers the compiler version and every setting that
+ * changes generated code; a database written under other settings is
+ * ignored. Modules that failed are left out so they are retried. */
+
+static uint64_t build_config_hash(const hyp_build_t* build) {
+    const hyp_build_config_t* config = &build->config;
+    uint64_t settings[3] = { (uint64_t)config->target, config->optimize, config->debug };
+
+    uint64_t hash = hyp_hash_string(HYP_VERSION_STRING, HYP_HASH_SEED);
+    hash = hyp_hash_bytes(settings, sizeof(settings), hash);
+    hash = hyp_hash_string(config->src_dir, hash);
+    hash = hyp_hash_string(config->out_dir, hash);
+    return hash;
+}
+
+static void build_clear_records(hyp_build_t* build) {
+    for (size_t i = 0; i < build->records.count; i++) {
+        HYP_FREE(build->records.data[i].source);
+        paths_free(&build->records.data[i].imports);
+    }
+    build->records.count = 0;
+}
+
+static int compare_records(const void* a, const void* b) {
+    return strcmp(((const hyp_build_record_t*)a)->source, ((const hyp_build_record_t*)b)->source);
+}
+
+static const hyp_build_record_t* build_find_record(const hyp_build_t* build, const char* source) {
+    if (build->records.count == 0) return NULL;
+
+    hyp_build_record_t key;
+    key.source = (char*)source;
+    return bsearch(&key, build->records.data, build->records.count, sizeof(hyp_build_record_t), compare_records);
+}
+
+static const hyp_build_unit_t* build_find_unit(const hyp_build_t* build, const char* source) {
+    if (build->units.count == 0) return NULL;
+
+    hyp_build_unit_t key;
+    key.source = (char*)source;
+    return bsearch(&key, build->units.data, build->units.count, sizeof(hyp_build_unit_t), compare_units);
+}
+
+/* A missing, stale or damaged database just means a full build */
+static void build_db_load(hyp_build_t* build) {
+    char* path = path_join(build->config.root, HYP_BUILD_DB_PATH);
+    size_t size;
+    char* text = path ? hyp_read_file(path, &size) : NULL;
+    HYP_FREE(path);
+    if (!text) return;
+
+    bool valid = false;
+    int line_number = 0;
+    hyp_build_record_t* record = NULL;
+
+    char* line = text;
+    while (line && *line) {
+        char* next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        size_t length = strlen(line);
+        if (length > 0 && line[length - 1] == '\r') line[--length] = '\0';
+        line_number++;
+
+        unsigned long long content, interface, config;
+        size_t bytes;
+        int version = 0;
+        int offset = 0;
+
+        if (line_number == 1) {
+            char magic[16];
+            if (sscanf(line, "%15s %d", magic, &version) != 2 ||
+                strcmp(magic, HYP_BUILD_DB_MAGIC) != 0 || version != HYP_BUILD_DB_VERSION) {
+                break;
+            }
+        } else if (line_number == 2) {
+            if (sscanf(line, "config %llx", &config) != 1 || config != build_config_hash(build)) break;
+            valid = true;
+        } else if (sscanf(line, "unit %llx %llx %zu %n", &content, &interface, &bytes, &offset) == 3 && offset > 0) {
+            hyp_build_record_t entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.source = hyp_strdup(line + offset);
+            entry.content_hash = content;
+            entry.interface_hash = interface;
+            entry.output_bytes = bytes;
+            HYP_ARRAY_INIT(&entry.imports);
+            if (!entry.source) {
+                valid = false;
+                break;
+            }
+            HYP_ARRAY_PUSH(&build->records, entry);
+            record = &build->records.data[build->records.count - 1];
+        } else if (strncmp(line, "import ", 7) == 0 && record) {
+            if (!paths_add(&record->imports, line + 7)) {
+                valid = false;
+                break;
+            }
+        } else if (strcmp(line, "end") == 0) {
+            record = NULL;
+        }
+
+        line = next;
+    }
+    HYP_FREE(text);
+
+    if (!valid) {
+        build_clear_records(build);
+        return;
+    }
+    if (build->records.count > 1) {
+        qsort(build->records.data, build->records.count, sizeof(hyp_build_record_t), compare_records);
+    }
+}
+
+static hyp_error_t build_db_save(hyp_build_t* build) {
+    char* path = path_join(build->config.root, HYP_BUILD_DB_PATH);
+    char* temp_path = path ? HYP_MALLOC(strlen(path) + 5) : NULL;
+    if (!temp_path) {
+        HYP_FREE(path);
+        return HYP_ERROR_MEMORY;
+    }
+    sprintf(temp_path, "%s.tmp", path);
+
+    /* Write to a temporary name so an interrupted build leaves the old database intact */
+    FILE* file = make_parent_directory(path) == HYP_OK ? fopen(temp_path, "w") : NULL;
+    if (!file) {
+        HYP_FREE(path);
+        HYP_FREE(temp_path);
+        return HYP_ERROR_IO;
+    }
+
+    fprintf(file, "%s %d\n", HYP_BUILD_DB_MAGIC, HYP_BUILD_DB_VERSION);
+    fprintf(file, "config %016llx\n", (unsigned long long)build_config_hash(build));
+    for (size_t i = 0; i < build->units.count; i++) {
+        const hyp_build_unit_t* unit = &build->units.data[i];
+        if (unit->failed) continue;
+
+        fprintf(file, "unit %016llx %016llx %zu %s\n", (unsigned long long)unit->content_hash,
+                (unsigned long long)unit->interface_hash, unit->output_bytes, unit->source);
+        for (size_t j = 0; j < unit->imports.count; j++) {
+            fprintf(file, "import %s\n", unit->imports.data[j]);
+        }
+        fprintf(file, "end\n");
+    }
+
+    bool failed = ferror(file) != 0;
+    if (fclose(file) != 0) failed = true;
+#ifdef _WIN32
+    if (!failed) remove(path);
+#endif
+    if (failed || rename(temp_path, path) != 0) {
+        remove(temp_path);
+        failed = true;
+    }
+
+    HYP_FREE(path);
+    HYP_FREE(temp_path);
+    return failed ? HYP_ERROR_IO : HYP_OK;
+}
+
+/* Checking: hash every source and keep the outputs of unchanged modules */
+static void build_check_task(void* context, size_t index, size_t worker) {
+    hyp_build_t* build = context;
+    hyp_build_unit_t* unit = &build->units.data[index];
+    (void)worker;
+
+    double started = hyp_wall_time();
+    char* path = path_join(build->config.root, unit->source);
+    bool loaded = path && hyp_source_load(&unit->text, path) == HYP_OK;
+    HYP_FREE(path);
+    unit->phase_time[HYP_BUILD_PHASE_READ] = hyp_wall_time() - started;
+    if (!loaded) {
+        unit_fail(unit, "could not read file");
+        return;
+    }
+    unit->content_hash = hyp_hash_bytes(unit->text.data, unit->text.size, HYP_HASH_SEED);
+
+    const hyp_build_record_t* record = build_find_record(build, unit->source);
+    if (!record || record->content_hash != unit->content_hash) return;
+
+    /* An output deleted or edited since the last build is regenerated */
+    char* output = path_join(build->config.root, unit->output);
+    struct stat st;
+    bool intact = output && stat(output, &st) == 0 && (size_t)st.st_size == record->output_bytes;
+    HYP_FREE(output);
+    if (!intact) return;
+
+    for (size_t i = 0; i < record->imports.count; i++) {
+        if (!paths_add(&unit->imports, record->imports.data[i])) {
+            paths_clear(&unit->imports);
+            return;
+        }
+    }
+    unit->up_to_date = true;
+    unit->interface_hash = record->interface_hash;
+    unit->output_bytes = record->output_bytes;
+    unit->phase_time[HYP_BUILD_PHASE_READ] = 0.0;
+    hyp_source_release(&unit->text);
+}
+
+/* Did a module imported by an up-to-date unit change its interface? */
+static bool build_imports_changed(const hyp_build_t* build, const hyp_build_unit_t* unit) {
+    for (size_t i = 0; i < unit->imports.count; i++) {
+        const char* path = unit->imports.data[i];
+        const hyp_build_unit_t* import = build_find_unit(build, path);
+        const hyp_build_record_t* record = build_find_record(build, path);
+
+        if (!import) {
+            /* Removed since the last build */
+            if (record) return true;
+            continue;
+        }
+        if (import->up_to_date) continue;
+        if (import->failed || !record || import->interface_hash != record->interface_hash) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Shared artifacts
+ *
+ * An artifact is a module's output plus what the build database needs
+ * to know about it, so a hit skips parsing altogether:
+ *
+ *   HART <version>
+ *   interface <interface-hash>
+ *   import <module>          (as written in the source)
+ *   data <bytes>
+ *   <output>
+ *
+ * Imports are stored unresolved because the key covers the source text
+ * only; the same module may sit elsewhere in another project. */
+
+/* Text buffer for the artifact header */
+typedef HYP_ARRAY(char) build_text_t;
+
+static bool text_append(build_text_t* text, const char* data, size_t size) {
+    if (text->count + size > text->capacity) {
+        size_t capacity = text->capacity ? text->capacity : 256;
+        while (capacity < text->count + size) capacity *= 2;
+        char* grown = HYP_REALLOC(text->data, capacity);
+        if (!grown) return false;
+        text->data = grown;
+        text->capacity = capacity;
+    }
+    memcpy(text->data + text->count, data, size);
+    text->count += size;
+    return true;
+}
+
+static char* build_artifact_encode(const hyp_ast_node_t* program, uint64_t interface_hash,
+                                   const char* output, size_t output_size, size_t* size) {
+    build_text_t text;
+    HYP_ARRAY_INIT(&text);
+
+    char line[64];
+    int length = snprintf(line, sizeof(line), "%s %d\ninterface %016llx\n", HYP_BUILD_ARTIFACT_MAGIC,
+                          HYP_BUILD_ARTIFACT_VERSION, (unsigned long long)interface_hash);
+    bool ok = text_append(&text, line, (size_t)length);
+
+    for (size_t i = 0; ok && i < program->program.statements.count; i++) {
+        const hyp_ast_node_t* stmt = HYP_AST_AT(program, program.statements, i);
+        if (stmt->type != AST_IMPORT_STMT) continue;
+        const char* module = HYP_AST_TEXT(stmt, import_stmt.module);
+        if (!module || strchr(module, '\n')) continue;
+
+        ok = text_append(&text, "import ", 7) &&
+             text_append(&text, module, strlen(module)) &&
+             text_append(&text, "\n", 1);
+    }
+
+    length = snprintf(line, sizeof(line), "data %zu\n", output_size);
+    ok = ok && text_append(&text, line, (size_t)length) && text_append(&text, output, output_size);
+    if (!ok) {
+        HYP_ARRAY_FREE(&text);
+        return NULL;
+    }
+    *size = text.count;
+    return text.data;
+}
+
+/* Fill the unit from an artifact; returns the output within data, or
+ * NULL if the artifact is damaged or from another format version */
+static const char* build_artifact_decode(hyp_build_unit_t* unit, char* data, size_t size, size_t* output_size) {
+    char* end = data + size;
+    char* line = data;
+    int line_number = 0;
+
+    paths_clear(&unit->imports);
+    while (line < end) {
+        char* next = memchr(line, '\n', (size_t)(end - line));
+        if (!next) break;
+        *next++ = '\0';
+        line_number++;
+
+        unsigned long long interface;
+        size_t bytes;
+        int version = 0;
+
+        if (line_number == 1) {
+            char magic[16];
+            if (sscanf(line, "%15s %d", magic, &version) != 2 ||
+                strcmp(magic, HYP_BUILD_ARTIFACT_MAGIC) != 0 || version != HYP_BUILD_ARTIFACT_VERSION) {
+                break;
+            }
+        } else if (sscanf(line, "interface %llx", &interface) == 1) {
+            unit->interface_hash = interface;
+        } else if (strncmp(line, "import ", 7) == 0) {
+            char* path = hyp_build_resolve_import(unit->source, line + 7);
+            bool added = !path || paths_add(&unit->imports, path);
+            HYP_FREE(path);
+            if (!added) break;
+        } else if (sscanf(line, "data %zu", &bytes) == 1) {
+            if (bytes != (size_t)(end - next)) break;
+            *output_size = bytes;
+            return next;
+        } else {
+            break;
+        }
+        line = next;
+    }
+
+    paths_clear(&unit->imports);
+    return NULL;
+}
+
+/* Replace a file in one step, so readers never see half of it */
+static hyp_error_t write_file_atomic(const char* path, const char* data, size_t size) {
+    char* temp_path = HYP_MALLOC(strlen(path) + 5);
+    if (!temp_path) return HYP_ERROR_MEMORY;
+    sprintf(temp_path, "%s.tmp", path);
+
+    hyp_error_t result = make_parent_directory(path);
+    if (result == HYP_OK) result = hyp_write_file(temp_path, data, size);
+#ifdef _WIN32
+    if (result == HYP_OK) remove(path);
+#endif
+    if (result == HYP_OK && rename(temp_path, path) != 0) result = HYP_ERROR_IO;
+    if (result != HYP_OK) remove(temp_path);
+
+    HYP_FREE(temp_path);
+    return result;
+}
+
+/* Take the unit's output from the cache; false on a miss */
+static bool build_fetch(hyp_build_t* build, hyp_build_unit_t* unit, const hyp_digest_t* key) {
+    char* data;
+    size_t size;
+    if (hyp_artifact_get(build->artifacts, key, &data, &size) != HYP_OK) return false;
+
+    size_t output_size = 0;
+    const char* output = build_artifact_decode(unit, data, size, &output_size);
+    char* path = output ? path_join(build->config.root, unit->output) : NULL;
+    bool fetched = path && write_file_atomic(path, output, output_size) == HYP_OK;
+    HYP_FREE(path);
+    HYP_FREE(data);
+
+    if (fetched) {
+        unit->from_cache = true;
+        unit->output_bytes = output_size;
+    } else {
+        paths_clear(&unit->imports);
+    }
+    return fetched;
+}
+
+/* Share a freshly compiled unit; failures only cost the next machine a compile */
+static void build_store(hyp_build_t* build, hyp_build_unit_t* unit, const hyp_digest_t* key,
+                        const hyp_ast_node_t* ast) {
+    char* path = path_join(build->config.root, unit->output);
+    size_t output_size;
+    char* output = path ? hyp_read_file(path, &output_size) : NULL;
+    HYP_FREE(path);
+    if (!output) return;
+
+    size_t size;
+    char* artifact = build_artifact_encode(ast, unit->interface_hash, output, output_size, &size);
+    HYP_FREE(output);
+    if (!artifact) return;
+
+    hyp_artifact_put(build->artifacts, key, artifact, size);
+    HYP_FREE(artifact);
+}
+
+/* The units compiled by one hyp_parallel_for pass */
+typedef struct {
+    hyp_build_t* build;
+    size_t* units;
+} build_pass_t;
+
+static void build_unit_task(void* context, size_t index, size_t worker) {
+    build_pass_t* pass = context;
+    hyp_build_t* build = pass->build;
+    hyp_build_unit_t* unit = &build->units.data[pass->units[index]];
+    (void)worker;
+
+    /* Units rebuilt for their imports dropped their source after checking */
+    double read_done = hyp_wall_time();
+    if (!unit->text.data) {
+        char* path = path_join(build->config.root, unit->source);
+        bool loaded = path && hyp_source_load(&unit->text, path) == HYP_OK;
+        HYP_FREE(path);
+        double now = hyp_wall_time();
+        unit->phase_time[HYP_BUILD_PHASE_READ] += now - read_done;
+        read_done = now;
+        if (!loaded) {
+            unit_fail(unit, "could not read file");
+            return;
+        }
+    }
+
+    hyp_digest_t key;
+    if (build->artifacts) {
+        hyp_artifact_key(unit->text.data, unit->text.size, build->config.target,
+                         build->config.optimize, build->config.debug, &key);
+        bool fetched = build_fetch(build, unit, &key);
+        double now = hyp_wall_time();
+        unit->phase_time[HYP_BUILD_PHASE_CACHE] += now - read_done;
+        read_done = now;
+
+        if (fetched) {
+            if (build->verbose) {
+                printf("  %s -> %s (%zu bytes, cached)\n", unit->source, unit->output, unit->output_bytes);
+            }
+            hyp_source_release(&unit->text);
+            return;
+        }
+    }
+
+    /* Every module gets its own lexer, parser and generator (and so its own arenas) */
+    hyp_lexer_t* lexer = hyp_lexer_create_with_length(unit->text.data, unit->text.size, unit->source);
+    hyp_parser_t* parser = lexer ? hyp_parser_create(lexer) : NULL;
+    hyp_ast_node_t* ast = parser ? hyp_parser_parse(parser) : NULL;
+    double parse_done = hyp_wall_time();
+    unit->phase_time[HYP_BUILD_PHASE_PARSE] = parse_done - read_done;
+
+    if (!parser) {
+        unit_fail(unit, "out of memory");
+    } else if (!ast || parser->had_error) {
+        unit_fail(unit, "parsing failed");
+    } else if (!build_collect_imports(unit, ast)) {
+        unit_fail(unit, "out of memory");
+    } else {
+        unit->interface_hash = hyp_build_interface_hash(ast);
+        build_generate(build, unit, ast);
+        double generate_done = hyp_wall_time();
+        unit->phase_time[HYP_BUILD_PHASE_CODEGEN] = generate_done - parse_done;
+
+        if (build->artifacts && !unit->failed) {
+            build_store(build, unit, &key, ast);
+            unit->phase_time[HYP_BUILD_PHASE_CACHE] += hyp_wall_time() - generate_done;
+        }
+    }
+
+    if (build->verbose && !unit->failed) {
+        printf("  %s -> %s (%zu bytes)\n", unit->source, unit->output, unit->output_bytes);
+    }
+
+    hyp_parser_destroy(parser);
+    hyp_lexer_destroy(lexer);
+    hyp_source_release(&unit->text);
+}
+
+/* The cache named by --artifact-cache, $HYP_ARTIFACT_CACHE or build.cache,
+ * in that order; a directory in package.yml is relative to the project */
+static hyp_error_t build_open_artifacts(hyp_build_t* build, hyp_artifact_cache_t* artifacts) {
+    build->artifacts = NULL;
+    build->cache_failures = 0;
+    build->cache_rejected = 0;
+
+    const char* location = build->cache_location;
+    if (!location) location = getenv(HYP_ARTIFACT_ENV);
+    char* resolved = NULL;
+    if (!location && build->config.cache) {
+        location = build->config.cache;
+        bool absolute = location[0] == '/' || location[0] == '\\' || (location[0] && location[1] == ':');
+        if (!strstr(location, "://") && !absolute) {
+            resolved = path_join(build->config.root, location);
+            location = resolved;
+        }
+    }
+    if (!location || !*location) {
+        HYP_FREE(resolved);
+        return HYP_OK;
+    }
+
+    hyp_error_t result = hyp_artifact_cache_open(artifacts, location);
+    HYP_FREE(resolved);
+    if (result != HYP_OK) {
+        build_error(build, "%s", artifacts->error_message);
+        return result;
+    }
+    build->artifacts = artifacts;
+    return HYP_OK;
+}
+
+static void build_close_artifacts(hyp_build_t* build) {
+    if (!build->artifacts) return;
+
+    build->cache_failures = build->artifacts->failures;
+    build->cache_rejected = build->artifacts->rejected;
+    hyp_artifact_cache_close(build->artifacts);
+    build->artifacts = NULL;
+}
+
+hyp_error_t hyp_build_run(hyp_build_t* build) {
+    if (!build) return HYP_ERROR_INVALID_ARG;
+
+    double started = hyp_wall_time();
+    size_t count = build->units.count;
+
+    hyp_artifact_cache_t artifacts;
+    hyp_error_t result = build_open_artifacts(build, &artifacts);
+    if (result != HYP_OK) return result;
+
+    build_clear_records(build);
+    if (!build->force) {
+        build_db_load(build);
+    }
+
+    hyp_parallel_for(count, build->jobs, build_check_task, build);
+    build->check_time = hyp_wall_time() - started;
+
+    build_pass_t pass = { build, HYP_MALLOC((count ? count : 1) * sizeof(size_t)) };
+    if (!pass.units) {
+        build_close_artifacts(build);
+        build_error(build, "Out of memory");
+        return HYP_ERROR_MEMORY;
+    }
+
+    /* First the modules that changed, then those importing a changed interface */
+    size_t pending = 0;
+    for (size_t i = 0; i < count; i++) {
+        const hyp_build_unit_t* unit = &build->units.data[i];
+        if (!unit->up_to_date && !unit->failed) pass.units[pending++] = i;
+    }
+    hyp_parallel_for(pending, build->jobs, build_unit_task, &pass);
+
+    pending = 0;
+    for (size_t i = 0; i < count; i++) {
+        hyp_build_unit_t* unit = &build->units.data[i];
+        if (unit->up_to_date && build_imports_changed(build, unit)) pass.units[pending++] = i;
+    }
+    for (size_t i = 0; i < pending; i++) {
+        build->units.data[pass.units[i]].up_to_date = false;
+    }
+    hyp_parallel_for(pending, build->jobs, build_unit_task, &pass);
+    HYP_FREE(pass.units);
+    build_close_artifacts(build);
+
+    build->failed = 0;
+    build->up_to_date = 0;
+    build->from_cache = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (build->units.data[i].failed) build->failed++;
+        if (build->units.data[i].up_to_date) build->up_to_date++;
+        if (build->units.data[i].from_cache) build->from_cache++;
+    }
+
+    result = build_db_save(build);
+    build->total_time = hyp_wall_time() - started + build->scan_time;
+    if (result != HYP_OK) {
+        build_error(build, "Could not write %s", HYP_BUILD_DB_PATH);
+        return result;
+    }
+    return build->failed ? HYP_ERROR_SEMANTIC : HYP_OK;
+}
+
+void hyp_build_print_summary(const hyp_build_t* build, FILE* out) {
+    static const char* phase_names[HYP_BUILD_PHASE_COUNT] = { "read", "parse", "codegen", "cache" };
+
+    double phases[HYP_BUILD_PHASE_COUNT] = { 0 };
+    size_t bytes = 0;
+    for (size_t i = 0; i < build->units.count; i++) {
+        const hyp_build_unit_t* unit = &build->units.data[i];
+        if (unit->failed) {
+            fprintf(out, "%s: error: %s\n", unit->source, unit->error ? unit->error : "failed");
+        }
+        for (int phase = 0; phase < HYP_BUILD_PHASE_COUNT; phase++) {
+            phases[phase] += unit->phase_time[phase];
+        }
+        bytes += unit->output_bytes;
+    }
+
+    size_t count = build->units.count;
+    size_t compiled = count - build->up_to_date;
+    fprintf(out, "Compiled %zu of %zu modules", compiled - build->failed, count);
+    if (build->up_to_date > 0 && build->from_cache > 0) {
+        fprintf(out, " (%zu up to date, %zu from cache)", build->up_to_date, build->from_cache);
+    } else if (build->up_to_date > 0) {
+        fprintf(out, " (%zu up to date)", build->up_to_date);
+    } else if (build->from_cache > 0) {
+        fprintf(out, " (%zu from cache)", build->from_cache);
+    }
+    fprintf(out, " into %s in %.3f s on %zu worker%s",
+            *build->config.out_dir ? build->config.out_dir : ".",
+            build->total_time, build->jobs, build->jobs == 1 ? "" : "s");
+    if (build->total_time > 0.0) {
+        fprintf(out, " (%.1f files/s)", (double)count / build->total_time);
+    }
+    fprintf(out, "\n");
+
+    /* Phase times add up the time every worker spent in each phase, over
+     * the modules actually compiled */
+    fprintf(out, "  %-8s %9.3f s\n", "scan", build->scan_time);
+    fprintf(out, "  %-8s %9.3f s\n", "check", build->check_time);
+    for (int phase = 0; phase < HYP_BUILD_PHASE_COUNT; phase++) {
+        fprintf(out, "  %-8s %9.3f s", phase_names[phase], phases[phase]);
+        if (compiled > 0) {
+            fprintf(out, "  %8.3f ms/file", phases[phase] * 1000.0 / (double)compiled);
+        }
+        fprintf(out, "\n");
+    }
+    fprintf(out, "  %-8s %9zu bytes\n", "output", bytes);
+    if (build->cache_failures > 0) {
+        fprintf(out, "warning: the artifact cache failed %zu request%s; continued without it\n",
+                build->cache_failures, build->cache_failures == 1 ? "" : "s");
+    }
+    if (build->cache_rejected > 0) {
+        fprintf(out, "warning: %zu artifact cache entr%s failed verification and %s recompiled\n",
+                build->cache_rejected, build->cache_rejected == 1 ? "y" : "ies",
+                build->cache_rejected == 1 ? "was" : "were");
+    }
+}
+
+void hyp_build_destroy(hyp_build_t* build) {
+    if (!build) return;
+
+    for (size_t i = 0; i < build->units.count; i++) {
+        HYP_FREE(build->units.data[i].source);
+        HYP_FREE(build->units.data[i].output);
+        HYP_FREE(build->units.data[i].error);
+        hyp_source_release(&build->units.data[i].text);
+        paths_free(&build->units.data[i].imports);
+    }
+    HYP_ARRAY_FREE(&build->units);
+    build_clear_records(build);
+    HYP_ARRAY_FREE(&build->records);
+    hyp_build_config_destroy(&build->config);
+}
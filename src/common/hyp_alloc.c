@@ -0,0 +1,666 @@
+/**
+ * Hyper Programming Language - Allocators
+ *
+ * The allocator behind HYP_MALLOC and friends. libc passes straight
+ * through and counts nothing. The others put a 16-byte header in front
+ * of every block recording its size and the subsystem that asked for it,
+ * so frees and reallocs are charged to the right subsystem whoever makes
+ * them:
+ *
+ *   slab      Blocks of up to SLAB_MAX_BLOCK bytes (header included) come
+ *             from size classes carved out of 64 KB slabs, four classes
+ *             per power of two; freed blocks are reused, the thread's own
+ *             first. Larger blocks come from the C library. Counted only
+ *             when $HYP_MEM_REPORT is set.
+ *   tracking  The C library's allocator, counted.
+ *   debug     Counted, with guard bytes after every block, fill patterns
+ *             on allocation and free, and a check of the header and the
+ *             guard on every free and realloc; a bad block aborts.
+ *
+ * The parser and code generator allocate from several threads, so
+ * counters are updated atomically. Slab threads keep a small cache of
+ * blocks per class and only lock the class to trade blocks in batches.
+ */
+
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "../../include/hyp_common.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+/* Counters */
+
+#if defined(__GNUC__)
+    #define MEM_ADD(counter, n) __atomic_add_fetch(&(counter), (size_t)(n), __ATOMIC_RELAXED)
+    #define MEM_SUB(counter, n) __atomic_sub_fetch(&(counter), (size_t)(n), __ATOMIC_RELAXED)
+#elif defined(_MSC_VER) && defined(_WIN64)
+    #define MEM_ADD(counter, n) ((size_t)InterlockedExchangeAdd64((volatile LONG64*)&(counter), (LONG64)(n)) + (size_t)(n))
+    #define MEM_SUB(counter, n) ((size_t)InterlockedExchangeAdd64((volatile LONG64*)&(counter), -(LONG64)(n)) - (size_t)(n))
+#else
+    /* Counts may be off when several threads allocate at once */
+    #define MEM_ADD(counter, n) ((counter) += (size_t)(n))
+    #define MEM_SUB(counter, n) ((counter) -= (size_t)(n))
+#endif
+
+static hyp_mem_counts_t mem_counts[HYP_MEM_TAG_COUNT];
+static hyp_mem_counts_t mem_total;
+static size_t mem_reserved;
+
+/* Counting costs a few atomic operations per call: tracking and debug
+ * always count, slab only when a report was asked for */
+static bool mem_counting;
+static bool mem_report;
+
+static void raise_peak(size_t* peak, size_t live) {
+#if defined(__GNUC__)
+    size_t seen = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (live > seen &&
+           !__atomic_compare_exchange_n(peak, &seen, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+#else
+    if (live > *peak) *peak = live;
+#endif
+}
+
+static void count_alloc(hyp_mem_tag_t tag, size_t size) {
+    if (!mem_counting) return;
+    hyp_mem_counts_t* counts = &mem_counts[tag];
+    MEM_ADD(counts->allocations, 1);
+    MEM_ADD(counts->bytes, size);
+    raise_peak(&counts->peak, MEM_ADD(counts->live, size));
+
+    MEM_ADD(mem_total.allocations, 1);
+    MEM_ADD(mem_total.bytes, size);
+    raise_peak(&mem_total.peak, MEM_ADD(mem_total.live, size));
+}
+
+static void count_free(hyp_mem_tag_t tag, size_t size) {
+    if (!mem_counting) return;
+    MEM_ADD(mem_counts[tag].frees, 1);
+    MEM_SUB(mem_counts[tag].live, size);
+    MEM_ADD(mem_total.frees, 1);
+    MEM_SUB(mem_total.live, size);
+}
+
+/* A block of old_size bytes now holds new_size */
+static void count_realloc(hyp_mem_tag_t tag, size_t old_size, size_t new_size) {
+    if (!mem_counting) return;
+    hyp_mem_counts_t* counts = &mem_counts[tag];
+    MEM_ADD(counts->reallocs, 1);
+    MEM_ADD(mem_total.reallocs, 1);
+    if (new_size > old_size) {
+        size_t grown = new_size - old_size;
+        MEM_ADD(counts->bytes, grown);
+        raise_peak(&counts->peak, MEM_ADD(counts->live, grown));
+        MEM_ADD(mem_total.bytes, grown);
+        raise_peak(&mem_total.peak, MEM_ADD(mem_total.live, grown));
+    } else {
+        MEM_SUB(counts->live, old_size - new_size);
+        MEM_SUB(mem_total.live, old_size - new_size);
+    }
+}
+
+/* Block headers */
+
+#define MEM_LIVE 0x48797041u     /* check of a block in use */
+#define MEM_DEAD 0x64656164u     /* check of a freed debug block */
+#define MEM_LARGE 0xffffu        /* kind of a block from the C library */
+
+typedef union {
+    struct {
+        size_t size;             /* Bytes asked for */
+        uint16_t tag;
+        uint16_t kind;           /* Slab class, or MEM_LARGE */
+        uint32_t check;
+    } info;
+    char align[16];
+} mem_header_t;
+
+#define HEADER(ptr) ((mem_header_t*)(ptr) - 1)
+
+static void* header_init(mem_header_t* header, size_t size, hyp_mem_tag_t tag, unsigned kind) {
+    header->info.size = size;
+    header->info.tag = (uint16_t)tag;
+    header->info.kind = (uint16_t)kind;
+    header->info.check = MEM_LIVE;
+    return header + 1;
+}
+
+static bool size_overflows(size_t count, size_t size, size_t extra) {
+    if (size && count > SIZE_MAX / size) return true;
+    return count * size > SIZE_MAX - extra;
+}
+
+/* libc */
+
+static void* libc_alloc(size_t size, hyp_mem_tag_t tag) {
+    (void)tag;
+    return malloc(size);
+}
+
+static void* libc_calloc(size_t count, size_t size, hyp_mem_tag_t tag) {
+    (void)tag;
+    return calloc(count, size);
+}
+
+static void* libc_realloc(void* ptr, size_t size, hyp_mem_tag_t tag) {
+    (void)tag;
+    return realloc(ptr, size);
+}
+
+static void libc_free(void* ptr) {
+    free(ptr);
+}
+
+static const hyp_allocator_t libc_allocator = {
+    "libc", false, libc_alloc, libc_calloc, libc_realloc, libc_free
+};
+
+/* tracking */
+
+static void* tracking_alloc(size_t size, hyp_mem_tag_t tag) {
+    if (size > SIZE_MAX - sizeof(mem_header_t)) return NULL;
+    mem_header_t* header = malloc(sizeof(mem_header_t) + size);
+    if (!header) return NULL;
+    count_alloc(tag, size);
+    return header_init(header, size, tag, MEM_LARGE);
+}
+
+static void* tracking_calloc(size_t count, size_t size, hyp_mem_tag_t tag) {
+    if (size_overflows(count, size, sizeof(mem_header_t))) return NULL;
+    mem_header_t* header = calloc(1, sizeof(mem_header_t) + count * size);
+    if (!header) return NULL;
+    count_alloc(tag, count * size);
+    return header_init(header, count * size, tag, MEM_LARGE);
+}
+
+static void* tracking_realloc(void* ptr, size_t size, hyp_mem_tag_t tag) {
+    if (!ptr) return tracking_alloc(size, tag);
+    if (size > SIZE_MAX - sizeof(mem_header_t)) return NULL;
+
+    mem_header_t* header = HEADER(ptr);
+    size_t old_size = header->info.size;
+    header = realloc(header, sizeof(mem_header_t) + size);
+    if (!header) return NULL;
+
+    header->info.size = size;
+    count_realloc((hyp_mem_tag_t)header->info.tag, old_size, size);
+    return header + 1;
+}
+
+static void tracking_free(void* ptr) {
+    if (!ptr) return;
+    mem_header_t* header = HEADER(ptr);
+    count_free((hyp_mem_tag_t)header->info.tag, header->info.size);
+    free(header);
+}
+
+static const hyp_allocator_t tracking_allocator = {
+    "tracking", true, tracking_alloc, tracking_calloc, tracking_realloc, tracking_free
+};
+
+/* debug */
+
+#define DEBUG_GUARD 16
+#define DEBUG_GUARD_BYTE 0xfd
+#define DEBUG_ALLOC_BYTE 0xcd
+#define DEBUG_FREE_BYTE 0xdd
+
+HYP_NORETURN static void debug_fail(const void* ptr, const char* problem) {
+    fprintf(stderr, "hyp debug allocator: %s at %p\n", problem, ptr);
+    fflush(stderr);
+    abort();
+}
+
+static mem_header_t* debug_check(void* ptr) {
+    mem_header_t* header = HEADER(ptr);
+    if (header->info.check == MEM_DEAD) debug_fail(ptr, "block freed twice");
+    if (header->info.check != MEM_LIVE || header->info.tag >= HYP_MEM_TAG_COUNT) {
+        debug_fail(ptr, "pointer not from the allocator, or header overwritten");
+    }
+
+    const unsigned char* guard = (const unsigned char*)ptr + header->info.size;
+    for (size_t i = 0; i < DEBUG_GUARD; i++) {
+        if (guard[i] != DEBUG_GUARD_BYTE) debug_fail(ptr, "write past the end of the block");
+    }
+    return header;
+}
+
+/* An uncounted block */
+static void* debug_block(size_t size, hyp_mem_tag_t tag, int fill) {
+    if (size > SIZE_MAX - sizeof(mem_header_t) - DEBUG_GUARD) return NULL;
+    mem_header_t* header = malloc(sizeof(mem_header_t) + size + DEBUG_GUARD);
+    if (!header) return NULL;
+
+    unsigned char* ptr = header_init(header, size, tag, MEM_LARGE);
+    memset(ptr, fill, size);
+    memset(ptr + size, DEBUG_GUARD_BYTE, DEBUG_GUARD);
+    return ptr;
+}
+
+static void debug_release(void* ptr, mem_header_t* header) {
+    memset(ptr, DEBUG_FREE_BYTE, header->info.size);
+    header->info.check = MEM_DEAD;
+    free(header);
+}
+
+static void* debug_alloc(size_t size, hyp_mem_tag_t tag) {
+    void* ptr = debug_block(size, tag, DEBUG_ALLOC_BYTE);
+    if (ptr) count_alloc(tag, size);
+    return ptr;
+}
+
+static void* debug_calloc(size_t count, size_t size, hyp_mem_tag_t tag) {
+    if (size_overflows(count, size, sizeof(mem_header_t) + DEBUG_GUARD)) return NULL;
+    void* ptr = debug_block(count * size, tag, 0);
+    if (ptr) count_alloc(tag, count * size);
+    return ptr;
+}
+
+static void debug_free(void* ptr) {
+    if (!ptr) return;
+    mem_header_t* header = debug_check(ptr);
+    count_free((hyp_mem_tag_t)header->info.tag, header->info.size);
+    debug_release(ptr, header);
+}
+
+/* Always moves the block, so stale pointers to the old one show up */
+static void* debug_realloc(void* ptr, size_t size, hyp_mem_tag_t tag) {
+    if (!ptr) return debug_alloc(size, tag);
+    mem_header_t* header = debug_check(ptr);
+    size_t old_size = header->info.size;
+
+    hyp_mem_tag_t owner = (hyp_mem_tag_t)header->info.tag;
+
+    void* copy = debug_block(size, owner, DEBUG_ALLOC_BYTE);
+    if (!copy) return NULL;
+    memcpy(copy, ptr, old_size < size ? old_size : size);
+    debug_release(ptr, header);
+    count_realloc(owner, old_size, size);
+    return copy;
+}
+
+static const hyp_allocator_t debug_allocator = {
+    "debug", true, debug_alloc, debug_calloc, debug_realloc, debug_free
+};
+
+/* slab */
+
+#define SLAB_SIZE (64 * 1024)
+#define SLAB_MAX_BLOCK 4096      /* Largest block from a slab, header included */
+#define SLAB_CLASSES 27
+#define SLAB_STEP 16             /* Block sizes are multiples of this */
+
+/* Block sizes: multiples of 16 up to 128, then four per power of two */
+static const uint16_t slab_block_sizes[SLAB_CLASSES] = {
+    32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256, 320, 384, 448, 512,
+    640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+    2560, 3072, 3584, 4096
+};
+
+typedef struct slab_block {
+    struct slab_block* next;
+} slab_block_t;
+
+/* Threads keep up to SLAB_CACHE_MAX freed blocks per class and trade
+ * them with the class SLAB_BATCH at a time, so most calls take no lock.
+ * Without thread-local storage every call goes to the class. */
+#define SLAB_CACHE_MAX 64
+#define SLAB_BATCH 32
+
+/* Blocks a thread holds on to, per class */
+typedef struct {
+    slab_block_t* blocks;
+    size_t count;
+} slab_cache_t;
+
+typedef struct {
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+    slab_block_t* free_list;
+    char* unused;                /* Not yet handed out in the newest slab */
+    char* unused_end;
+} slab_class_t;
+
+static slab_class_t slab_classes[SLAB_CLASSES];
+
+static uint8_t slab_class_of[SLAB_MAX_BLOCK / SLAB_STEP + 1];  /* By block size / SLAB_STEP, rounded up */
+
+static void slab_init(void) {
+    unsigned class_index = 0;
+    for (size_t i = 0; i <= SLAB_MAX_BLOCK / SLAB_STEP; i++) {
+        while (slab_block_sizes[class_index] < i * SLAB_STEP) class_index++;
+        slab_class_of[i] = (uint8_t)class_index;
+    }
+    for (size_t i = 0; i < SLAB_CLASSES; i++) {
+#ifdef _WIN32
+        InitializeCriticalSection(&slab_classes[i].lock);
+#else
+        pthread_mutex_init(&slab_classes[i].lock, NULL);
+#endif
+    }
+}
+
+static void slab_lock(slab_class_t* slab_class) {
+#ifdef _WIN32
+    EnterCriticalSection(&slab_class->lock);
+#else
+    pthread_mutex_lock(&slab_class->lock);
+#endif
+}
+
+static void slab_unlock(slab_class_t* slab_class) {
+#ifdef _WIN32
+    LeaveCriticalSection(&slab_class->lock);
+#else
+    pthread_mutex_unlock(&slab_class->lock);
+#endif
+}
+
+/* Moves up to SLAB_BATCH blocks from the class to a thread's cache,
+ * carving them from the newest slab once the free list runs dry. Slabs
+ * are never given back; their blocks are reused through the free list. */
+static void slab_refill(unsigned class_index, slab_cache_t* cache) {
+    slab_class_t* slab_class = &slab_classes[class_index];
+    size_t block_size = slab_block_sizes[class_index];
+
+    slab_lock(slab_class);
+    while (cache->count < SLAB_BATCH) {
+        slab_block_t* block = slab_class->free_list;
+        if (block) {
+            slab_class->free_list = block->next;
+        } else {
+            if ((size_t)(slab_class->unused_end - slab_class->unused) < block_size) {
+                char* slab = malloc(SLAB_SIZE);
+                if (!slab) break;
+                MEM_ADD(mem_reserved, SLAB_SIZE);
+                slab_class->unused = slab;
+                slab_class->unused_end = slab + SLAB_SIZE - SLAB_SIZE % block_size;
+            }
+            block = (slab_block_t*)slab_class->unused;
+            slab_class->unused += block_size;
+        }
+        block->next = cache->blocks;
+        cache->blocks = block;
+        cache->count++;
+    }
+    slab_unlock(slab_class);
+}
+
+/* Moves count blocks from a thread's cache back to the class */
+static void slab_drain(unsigned class_index, slab_cache_t* cache, size_t count) {
+    if (count == 0 || !cache->blocks) return;
+
+    slab_block_t* first = cache->blocks;
+    slab_block_t* last = first;
+    for (size_t i = 1; i < count && last->next; i++) last = last->next;
+    cache->blocks = last->next;
+    cache->count = cache->blocks ? cache->count - count : 0;
+
+    slab_class_t* slab_class = &slab_classes[class_index];
+    slab_lock(slab_class);
+    last->next = slab_class->free_list;
+    slab_class->free_list = first;
+    slab_unlock(slab_class);
+}
+
+#ifdef HYP_HAVE_THREAD_LOCAL
+static HYP_THREAD_LOCAL slab_cache_t slab_caches[SLAB_CLASSES];
+
+/* A block of the class, or NULL when no slab can be had */
+static void* slab_take(unsigned class_index) {
+    slab_cache_t* cache = &slab_caches[class_index];
+    if (!cache->blocks) slab_refill(class_index, cache);
+
+    slab_block_t* block = cache->blocks;
+    if (!block) return NULL;
+    cache->blocks = block->next;
+    cache->count--;
+    return block;
+}
+
+static void slab_give(unsigned class_index, void* block) {
+    slab_cache_t* cache = &slab_caches[class_index];
+    ((slab_block_t*)block)->next = cache->blocks;
+    cache->blocks = block;
+    if (++cache->count > SLAB_CACHE_MAX) slab_drain(class_index, cache, SLAB_BATCH);
+}
+#else
+static void* slab_take(unsigned class_index) {
+    slab_cache_t cache = { NULL, SLAB_BATCH - 1 };
+    slab_refill(class_index, &cache);
+    return cache.blocks;
+}
+
+static void slab_give(unsigned class_index, void* block) {
+    slab_cache_t cache = { block, 1 };
+    ((slab_block_t*)block)->next = NULL;
+    slab_drain(class_index, &cache, 1);
+}
+#endif
+
+/* An uncounted block */
+static void* slab_block(size_t size, hyp_mem_tag_t tag) {
+    if (size <= SLAB_MAX_BLOCK - sizeof(mem_header_t)) {
+        unsigned class_index = slab_class_of[(size + sizeof(mem_header_t) + SLAB_STEP - 1) / SLAB_STEP];
+        mem_header_t* header = slab_take(class_index);
+        return header ? header_init(header, size, tag, class_index) : NULL;
+    }
+
+    if (size > SIZE_MAX - sizeof(mem_header_t)) return NULL;
+    mem_header_t* header = malloc(sizeof(mem_header_t) + size);
+    if (!header) return NULL;
+    MEM_ADD(mem_reserved, sizeof(mem_header_t) + size);
+    return header_init(header, size, tag, MEM_LARGE);
+}
+
+static void slab_release(mem_header_t* header) {
+    if (header->info.kind == MEM_LARGE) {
+        MEM_SUB(mem_reserved, sizeof(mem_header_t) + header->info.size);
+        free(header);
+    } else {
+        slab_give(header->info.kind, header);
+    }
+}
+
+static void* slab_alloc(size_t size, hyp_mem_tag_t tag) {
+    void* ptr = slab_block(size, tag);
+    if (ptr) count_alloc(tag, size);
+    return ptr;
+}
+
+static void* slab_calloc(size_t count, size_t size, hyp_mem_tag_t tag) {
+    if (size_overflows(count, size, sizeof(mem_header_t))) return NULL;
+    void* ptr = slab_alloc(count * size, tag);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+static void slab_free(void* ptr) {
+    if (!ptr) return;
+    mem_header_t* header = HEADER(ptr);
+    count_free((hyp_mem_tag_t)header->info.tag, header->info.size);
+    slab_release(header);
+}
+
+static void* slab_realloc(void* ptr, size_t size, hyp_mem_tag_t tag) {
+    if (!ptr) return slab_alloc(size, tag);
+    mem_header_t* header = HEADER(ptr);
+    hyp_mem_tag_t owner = (hyp_mem_tag_t)header->info.tag;
+    size_t old_size = header->info.size;
+
+    /* Stays put while it fits its block; large blocks stay large */
+    if (header->info.kind != MEM_LARGE &&
+        size <= slab_block_sizes[header->info.kind] - sizeof(mem_header_t)) {
+        header->info.size = size;
+        count_realloc(owner, old_size, size);
+        return ptr;
+    }
+    if (header->info.kind == MEM_LARGE && size > SLAB_MAX_BLOCK - sizeof(mem_header_t)) {
+        if (size > SIZE_MAX - sizeof(mem_header_t)) return NULL;
+        header = realloc(header, sizeof(mem_header_t) + size);
+        if (!header) return NULL;
+        if (size > old_size) {
+            MEM_ADD(mem_reserved, size - old_size);
+        } else {
+            MEM_SUB(mem_reserved, old_size - size);
+        }
+        header->info.size = size;
+        count_realloc(owner, old_size, size);
+        return header + 1;
+    }
+
+    /* Moves between a slab class and the C library, or between classes */
+    void* copy = slab_block(size, owner);
+    if (!copy) return NULL;
+    memcpy(copy, ptr, old_size < size ? old_size : size);
+    slab_release(header);
+    count_realloc(owner, old_size, size);
+    return copy;
+}
+
+static const hyp_allocator_t slab_allocator = {
+    "slab", false, slab_alloc, slab_calloc, slab_realloc, slab_free
+};
+
+/* Selection */
+
+static const hyp_allocator_t* mem_allocator = &libc_allocator;
+
+void* hyp_mem_alloc(size_t size, hyp_mem_tag_t tag) {
+    return mem_allocator->alloc(size, tag);
+}
+
+void* hyp_mem_calloc(size_t count, size_t size, hyp_mem_tag_t tag) {
+    return mem_allocator->calloc(count, size, tag);
+}
+
+void* hyp_mem_realloc(void* ptr, size_t size, hyp_mem_tag_t tag) {
+    return mem_allocator->realloc(ptr, size, tag);
+}
+
+void hyp_mem_free(void* ptr) {
+    mem_allocator->free(ptr);
+}
+
+bool hyp_mem_select(const char* name) {
+    static const hyp_allocator_t* const allocators[] = {
+        &libc_allocator, &slab_allocator, &tracking_allocator, &debug_allocator
+    };
+
+    for (size_t i = 0; i < sizeof(allocators) / sizeof(allocators[0]); i++) {
+        if (strcmp(name, allocators[i]->name) == 0) {
+            hyp_mem_set_allocator(allocators[i]);
+            return true;
+        }
+    }
+    return false;
+}
+
+void hyp_mem_set_allocator(const hyp_allocator_t* allocator) {
+    static bool slab_ready = false;
+    if (allocator == &slab_allocator && !slab_ready) {
+        slab_init();
+        slab_ready = true;
+    }
+    mem_allocator = allocator ? allocator : &libc_allocator;
+    mem_counting = mem_allocator == &tracking_allocator || mem_allocator == &debug_allocator ||
+                   (mem_allocator == &slab_allocator && mem_report);
+}
+
+void hyp_mem_thread_exit(void) {
+#ifdef HYP_HAVE_THREAD_LOCAL
+    if (mem_allocator != &slab_allocator) return;
+    for (unsigned i = 0; i < SLAB_CLASSES; i++) {
+        slab_drain(i, &slab_caches[i], slab_caches[i].count);
+    }
+#endif
+}
+
+const hyp_allocator_t* hyp_mem_allocator(void) {
+    return mem_allocator;
+}
+
+static void mem_report_at_exit(void) {
+    hyp_mem_report(stderr);
+}
+
+void hyp_mem_init(void) {
+    const char* report = getenv(HYP_MEM_REPORT_ENV);
+    if (report && *report) {
+        mem_report = true;
+        atexit(mem_report_at_exit);
+    }
+
+    const char* name = getenv(HYP_ALLOCATOR_ENV);
+    if (name && *name && !hyp_mem_select(name)) {
+        fprintf(stderr, "Warning: Unknown allocator '%s' in %s (libc, slab, tracking, debug); using libc\n",
+                name, HYP_ALLOCATOR_ENV);
+    }
+}
+
+/* Statistics */
+
+const char* hyp_mem_tag_name(hyp_mem_tag_t tag) {
+    switch (tag) {
+        case HYP_MEM_LEXER: return "lexer";
+        case HYP_MEM_PARSER: return "parser";
+        case HYP_MEM_CODEGEN: return "codegen";
+        case HYP_MEM_RUNTIME: return "runtime";
+        case HYP_MEM_HPM: return "hpm";
+        default: return "other";
+    }
+}
+
+void hyp_mem_stats(hyp_mem_stats_t* stats) {
+    memset(stats, 0, sizeof(hyp_mem_stats_t));
+    stats->allocator = mem_allocator->name;
+    stats->tracked = mem_counting;
+    if (!stats->tracked) return;
+
+    memcpy(stats->tags, mem_counts, sizeof(mem_counts));
+    stats->total = mem_total;
+    stats->reserved = mem_reserved;
+}
+
+static void report_counts(FILE* stream, const char* name, const hyp_mem_counts_t* counts) {
+    fprintf(stream, "  %-10s %10zu %9zu %10zu %12.1f %10.1f %10.1f\n", name,
+            counts->allocations, counts->reallocs, counts->frees,
+            counts->bytes / 1024.0, counts->live / 1024.0, counts->peak / 1024.0);
+}
+
+void hyp_mem_report(FILE* stream) {
+    hyp_mem_stats_t stats;
+    hyp_mem_stats(&stats);
+
+    fprintf(stream, "Memory (%s allocator)\n", stats.allocator);
+    if (!stats.tracked) {
+        fprintf(stream, "  Not counted; set %s=tracking (or slab, debug) and %s for figures\n",
+                HYP_ALLOCATOR_ENV, HYP_MEM_REPORT_ENV);
+        return;
+    }
+
+    fprintf(stream, "  %-10s %10s %9s %10s %12s %10s %10s\n",
+            "subsystem", "allocs", "reallocs", "frees", "asked KB", "live KB", "peak KB");
+    for (int i = 1; i <= HYP_MEM_TAG_COUNT; i++) {
+        /* Other last */
+        hyp_mem_tag_t tag = (hyp_mem_tag_t)(i % HYP_MEM_TAG_COUNT);
+        if (stats.tags[tag].allocations == 0) continue;
+        report_counts(stream, hyp_mem_tag_name(tag), &stats.tags[tag]);
+    }
+    report_counts(stream, "total", &stats.total);
+
+    if (stats.reserved) {
+        fprintf(stream, "  Held from the system: %.1f KB\n", stats.reserved / 1024.0);
+    }
+}
@@ -5,66 +5,423 @@
  * used across all modules of the Hyper language system.
  */
 
+#ifndef _WIN32
+#define _DEFAULT_SOURCE      /* MAP_ANONYMOUS, madvise */
+#endif
+
 #include "../../include/hyp_common.h"
+#include "../../include/hyp_number.h"
 #include <stdarg.h>
+#include <errno.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
 
 /* Arena allocator implementation */
-hyp_arena_t* hyp_arena_create(size_t size) {
-    hyp_arena_t* arena = HYP_MALLOC(sizeof(hyp_arena_t));
+
+/* Chunk sizes, headers included. Chunks stop doubling at
+ * ARENA_MAX_GROWTH; a larger request gets a chunk of its own size. */
+#define ARENA_MIN_CHUNK 1024
+#define ARENA_MAX_GROWTH (64u * 1024 * 1024)
+#define ARENA_MIN_MAPPED (64u * 1024)    /* Smaller chunks are not worth a system call */
+#define ARENA_HUGE_PAGE (2u * 1024 * 1024)
+#define ARENA_HEADER ((sizeof(hyp_arena_chunk_t) + HYP_ARENA_ALIGN - 1) & ~(size_t)(HYP_ARENA_ALIGN - 1))
+
+#define CHUNK_MEMORY(chunk) ((char*)(chunk) + ARENA_HEADER)
+
+/* Smallest size class of at least size bytes; 0 if there is none */
+static size_t arena_size_class(size_t size) {
+    size_t total = ARENA_MIN_CHUNK;
+    while (total < size) {
+        if (total > SIZE_MAX / 2) return 0;
+        total *= 2;
+    }
+    return total;
+}
+
+static hyp_arena_chunk_t* arena_chunk_create(size_t total, unsigned flags, hyp_mem_tag_t tag) {
+    hyp_arena_chunk_t* chunk = NULL;
+    bool mapped = false;
+    
+#ifndef _WIN32
+    if (flags && total >= ARENA_MIN_MAPPED) {
+        /* Huge pages must be asked for before the pages are touched */
+        bool huge = (flags & HYP_ARENA_HUGE_PAGES) && total >= ARENA_HUGE_PAGE;
+        int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+        if ((flags & HYP_ARENA_POPULATE) && !huge) map_flags |= MAP_POPULATE;
+#endif
+        void* base = mmap(NULL, total, PROT_READ | PROT_WRITE, map_flags, -1, 0);
+        if (base != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+            if (huge) madvise(base, total, MADV_HUGEPAGE);
+#endif
+            if (huge && (flags & HYP_ARENA_POPULATE)) {
+                for (size_t i = 0; i < total; i += 4096) ((volatile char*)base)[i] = 0;
+            }
+            chunk = base;
+            mapped = true;
+        }
+    }
+#else
+    (void)flags;
+#endif
+    
+    if (!chunk) {
+        chunk = hyp_mem_alloc(total, tag);
+        if (!chunk) return NULL;
+    }
+    
+    chunk->next = NULL;
+    chunk->size = total - ARENA_HEADER;
+    chunk->used = 0;
+    chunk->mapped = mapped;
+    return chunk;
+}
+
+static void arena_chunk_destroy(hyp_arena_chunk_t* chunk) {
+#ifndef _WIN32
+    if (chunk->mapped) {
+        munmap(chunk, chunk->size + ARENA_HEADER);
+        return;
+    }
+#endif
+    HYP_FREE(chunk);
+}
+
+hyp_arena_t* hyp_arena_create_tagged(size_t size, unsigned flags, hyp_mem_tag_t tag) {
+    size_t total = size <= SIZE_MAX - ARENA_HEADER ? arena_size_class(size + ARENA_HEADER) : 0;
+    if (!total) return NULL;
+    
+    hyp_arena_t* arena = hyp_mem_alloc(sizeof(hyp_arena_t), tag);
     if (!arena) return NULL;
     
-    arena->memory = HYP_MALLOC(size);
-    if (!arena->memory) {
+    arena->first = arena_chunk_create(total, flags, tag);
+    if (!arena->first) {
         HYP_FREE(arena);
         return NULL;
     }
     
-    arena->size = size;
-    arena->used = 0;
-    arena->next = NULL;
-    
+    arena->current = arena->first;
+    arena->next_size = total < ARENA_MAX_GROWTH ? total * 2 : total;
+    arena->flags = flags;
+    arena->tag = tag;
     return arena;
 }
 
 void hyp_arena_destroy(hyp_arena_t* arena) {
-    while (arena) {
-        hyp_arena_t* next = arena->next;
-        HYP_FREE(arena->memory);
-        HYP_FREE(arena);
-        arena = next;
+    if (!arena) return;
+    
+    hyp_arena_chunk_t* chunk = arena->first;
+    while (chunk) {
+        hyp_arena_chunk_t* next = chunk->next;
+        arena_chunk_destroy(chunk);
+        chunk = next;
     }
+    HYP_FREE(arena);
+}
+
+/* Make the first free chunk with room for size bytes current, creating
+ * one if none has room. It is moved up to follow the old current chunk;
+ * free chunks that were too small stay free after it. */
+static hyp_arena_chunk_t* arena_next_chunk(hyp_arena_t* arena, size_t size) {
+    hyp_arena_chunk_t* current = arena->current;
+    hyp_arena_chunk_t* before = current;
+    hyp_arena_chunk_t* chunk = current->next;
+    while (chunk && chunk->size < size) {
+        before = chunk;
+        chunk = chunk->next;
+    }
+    
+    if (chunk) {
+        before->next = chunk->next;
+    } else {
+        size_t total = arena->next_size;
+        if (total - ARENA_HEADER < size) {
+            total = size <= SIZE_MAX - ARENA_HEADER ? arena_size_class(size + ARENA_HEADER) : 0;
+            if (!total) return NULL;
+        }
+        
+        chunk = arena_chunk_create(total, arena->flags, arena->tag);
+        if (!chunk) return NULL;
+        if (arena->next_size < ARENA_MAX_GROWTH) arena->next_size *= 2;
+    }
+    
+    chunk->used = 0;
+    chunk->next = current->next;
+    current->next = chunk;
+    arena->current = chunk;
+    return chunk;
 }
 
 void* hyp_arena_alloc(hyp_arena_t* arena, size_t size) {
-    if (!arena) return NULL;
+    if (!arena || size > SIZE_MAX - HYP_ARENA_ALIGN) return NULL;
     
-    /* Align to 8-byte boundary */
-    size = (size + 7) & ~7;
+    size = (size + HYP_ARENA_ALIGN - 1) & ~(size_t)(HYP_ARENA_ALIGN - 1);
     
-    /* Check if current arena has enough space */
-    if (arena->used + size > arena->size) {
-        /* Create new arena if needed */
-        size_t new_size = arena->size * 2;
-        if (new_size < size) new_size = size * 2;
-        
-        hyp_arena_t* new_arena = hyp_arena_create(new_size);
-        if (!new_arena) return NULL;
-        
-        new_arena->next = arena->next;
-        arena->next = new_arena;
-        arena = new_arena;
+    hyp_arena_chunk_t* chunk = arena->current;
+    if (chunk->size - chunk->used < size) {
+        chunk = arena_next_chunk(arena, size);
+        if (!chunk) return NULL;
     }
     
-    void* ptr = arena->memory + arena->used;
-    arena->used += size;
+    void* ptr = CHUNK_MEMORY(chunk) + chunk->used;
+    chunk->used += size;
     return ptr;
 }
 
+char* hyp_arena_strdup(hyp_arena_t* arena, const char* str) {
+    if (!str) return NULL;
+    
+    size_t size = strlen(str) + 1;
+    char* copy = hyp_arena_alloc(arena, size);
+    if (copy) memcpy(copy, str, size);
+    return copy;
+}
+
 void hyp_arena_reset(hyp_arena_t* arena) {
-    while (arena) {
-        arena->used = 0;
-        arena = arena->next;
+    if (!arena) return;
+    
+    /* Every chunk is kept, to be filled again in order */
+    arena->current = arena->first;
+    arena->first->used = 0;
+}
+
+hyp_arena_mark_t hyp_arena_mark(const hyp_arena_t* arena) {
+    hyp_arena_mark_t mark = { NULL, 0 };
+    if (arena) {
+        mark.chunk = arena->current;
+        mark.used = arena->current->used;
     }
+    return mark;
+}
+
+void hyp_arena_rewind(hyp_arena_t* arena, hyp_arena_mark_t mark) {
+    if (!arena) return;
+    if (!mark.chunk) {
+        hyp_arena_reset(arena);
+        return;
+    }
+    
+    /* Chunks after the marked one become free */
+    arena->current = mark.chunk;
+    arena->current->used = mark.used;
+}
+
+void hyp_arena_stats(const hyp_arena_t* arena, hyp_arena_stats_t* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(hyp_arena_stats_t));
+    if (!arena) return;
+    
+    bool free_chunk = false;
+    for (const hyp_arena_chunk_t* chunk = arena->first; chunk; chunk = chunk->next) {
+        stats->chunks++;
+        stats->reserved += chunk->size;
+        if (free_chunk) continue;
+        
+        stats->used += chunk->used;
+        if (chunk == arena->current) {
+            free_chunk = true;
+        } else {
+            stats->wasted += chunk->size - chunk->used;
+        }
+    }
+}
+
+/* Pool implementation */
+
+/* Blocks per slab; the first line of a slab holds its header */
+#define POOL_SLAB_BLOCKS(pool) ((HYP_POOL_SLAB_SIZE - HYP_CACHE_LINE) / (pool)->block_size)
+
+void hyp_pool_init_tagged(hyp_pool_t* pool, size_t size, hyp_mem_tag_t tag) {
+    size_t block_size = sizeof(hyp_pool_block_t);
+    while (block_size < size && block_size < HYP_CACHE_LINE) block_size *= 2;
+    if (block_size < size) {
+        block_size = (size + HYP_CACHE_LINE - 1) & ~(size_t)(HYP_CACHE_LINE - 1);
+    }
+    assert(block_size <= HYP_POOL_SLAB_SIZE - HYP_CACHE_LINE);
+    
+    memset(pool, 0, sizeof(hyp_pool_t));
+    pool->block_size = block_size;
+    pool->tag = tag;
+}
+
+void hyp_pool_destroy(hyp_pool_t* pool) {
+    if (!pool) return;
+    
+    hyp_pool_slab_t* slab = pool->slabs;
+    while (slab) {
+        hyp_pool_slab_t* next = slab->next;
+        hyp_mem_free(slab->memory);
+        slab = next;
+    }
+    memset(pool, 0, sizeof(hyp_pool_t));
+}
+
+/* Called with the free list empty: carves a new slab into free blocks
+ * and hands out the first */
+void* hyp_pool_refill(hyp_pool_t* pool) {
+    void* memory = hyp_mem_alloc(HYP_POOL_SLAB_SIZE + HYP_CACHE_LINE - 1, pool->tag);
+    if (!memory) return NULL;
+    
+    uintptr_t aligned = ((uintptr_t)memory + HYP_CACHE_LINE - 1) & ~(uintptr_t)(HYP_CACHE_LINE - 1);
+    hyp_pool_slab_t* slab = (hyp_pool_slab_t*)aligned;
+    slab->memory = memory;
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->slab_count++;
+    
+    /* Linked in address order, so a fresh slab is handed out front to back */
+    char* blocks = (char*)slab + HYP_CACHE_LINE;
+    size_t count = POOL_SLAB_BLOCKS(pool);
+    for (size_t i = 1; i < count; i++) {
+        hyp_pool_block_t* block = (hyp_pool_block_t*)(blocks + i * pool->block_size);
+        block->next = i + 1 < count ? (hyp_pool_block_t*)(blocks + (i + 1) * pool->block_size) : NULL;
+    }
+    pool->free_list = count > 1 ? (hyp_pool_block_t*)(blocks + pool->block_size) : NULL;
+    
+    pool->allocations++;
+    if (++pool->live > pool->peak) pool->peak = pool->live;
+    return blocks;
+}
+
+void hyp_pool_stats(const hyp_pool_t* pool, hyp_pool_stats_t* stats) {
+    memset(stats, 0, sizeof(hyp_pool_stats_t));
+    if (!pool->block_size) return;
+    
+    stats->block_size = pool->block_size;
+    stats->live = pool->live;
+    stats->peak = pool->peak;
+    stats->allocations = pool->allocations;
+    stats->slabs = pool->slab_count;
+    stats->reserved = pool->slab_count * HYP_POOL_SLAB_SIZE;
+    stats->free = pool->slab_count * POOL_SLAB_BLOCKS(pool) - pool->live;
+}
+
+/* Container implementation */
+
+#define MAP_MIN_CAPACITY 16
+
+size_t hyp_map_find(const hyp_map_index_t* index, const char* key) {
+    if (!index->count || !key) return HYP_MAP_NONE;
+
+    uint64_t hash = hyp_hash_string(key, HYP_HASH_SEED);
+    size_t mask = index->capacity - 1;
+    for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+        const hyp_map_slot_t* slot = &index->slots[i];
+        if (!slot->key) return HYP_MAP_NONE;
+        if (slot->hash == hash && strcmp(slot->key, key) == 0) return i;
+    }
+}
+
+/* Needs room for one more key (hyp_map_reserve) if key is new */
+size_t hyp_map_insert(hyp_map_index_t* index, const char* key, bool* added) {
+    if (added) *added = false;
+    if (!key || !index->capacity) return HYP_MAP_NONE;
+
+    uint64_t hash = hyp_hash_string(key, HYP_HASH_SEED);
+    size_t mask = index->capacity - 1;
+    size_t i = (size_t)hash & mask;
+    for (; index->slots[i].key; i = (i + 1) & mask) {
+        if (index->slots[i].hash == hash && strcmp(index->slots[i].key, key) == 0) return i;
+    }
+
+    if ((index->count + 1) * 4 > index->capacity * 3) return HYP_MAP_NONE;
+    index->slots[i].key = key;
+    index->slots[i].hash = hash;
+    index->count++;
+    if (added) *added = true;
+    return i;
+}
+
+/* Double the table, moving every entry to its slot in the new one */
+void* hyp_map_grow(hyp_map_index_t* index, void* values, size_t value_size, hyp_mem_tag_t tag) {
+    size_t capacity = index->capacity ? index->capacity * 2 : MAP_MIN_CAPACITY;
+    hyp_map_slot_t* slots = hyp_mem_calloc(capacity, sizeof(hyp_map_slot_t), tag);
+    char* new_values = hyp_mem_alloc(capacity * value_size, tag);
+    if (!slots || !new_values) {
+        hyp_mem_free(slots);
+        hyp_mem_free(new_values);
+        return values;
+    }
+
+    for (size_t i = 0; i < index->capacity; i++) {
+        if (!index->slots[i].key) continue;
+        size_t slot = (size_t)index->slots[i].hash & (capacity - 1);
+        while (slots[slot].key) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = index->slots[i];
+        memcpy(new_values + slot * value_size, (char*)values + i * value_size, value_size);
+    }
+
+    hyp_mem_free(index->slots);
+    hyp_mem_free(values);
+    index->slots = slots;
+    index->capacity = capacity;
+    return new_values;
+}
+
+void hyp_map_erase(hyp_map_index_t* index, void* values, size_t value_size, size_t slot) {
+    if (slot >= index->capacity || !index->slots[slot].key) return;
+
+    size_t mask = index->capacity - 1;
+    size_t hole = slot;
+    for (size_t i = (slot + 1) & mask; index->slots[i].key; i = (i + 1) & mask) {
+        /* An entry whose home lies cyclically in (hole, i] stays put */
+        size_t home = (size_t)index->slots[i].hash & mask;
+        bool stays = hole <= i ? (hole < home && home <= i) : (hole < home || home <= i);
+        if (stays) continue;
+
+        index->slots[hole] = index->slots[i];
+        memcpy((char*)values + hole * value_size, (char*)values + i * value_size, value_size);
+        hole = i;
+    }
+    index->slots[hole].key = NULL;
+    index->count--;
+}
+
+/* Called when a small vector is full: moves it to the heap, or doubles it there */
+void* hyp_small_vector_grow(void* data, void* inline_data, size_t* capacity, size_t count,
+                            size_t item_size, hyp_mem_tag_t tag) {
+    size_t new_capacity = *capacity ? *capacity * 2 : 8;
+    void* grown;
+    if (data == inline_data) {
+        grown = hyp_mem_alloc(new_capacity * item_size, tag);
+        if (grown) memcpy(grown, data, count * item_size);
+    } else {
+        grown = hyp_mem_realloc(data, new_capacity * item_size, tag);
+    }
+    if (!grown) return data;
+
+    *capacity = new_capacity;
+    return grown;
+}
+
+/* Called when a deque is full: doubles it, unwrapping the items to start at 0 */
+void* hyp_deque_grow(void* data, size_t* head, size_t count, size_t* capacity,
+                     size_t item_size, hyp_mem_tag_t tag) {
+    size_t new_capacity = *capacity ? *capacity * 2 : 8;
+    char* grown = hyp_mem_alloc(new_capacity * item_size, tag);
+    if (!grown) return data;
+
+    if (count) {
+        size_t first = *capacity - *head < count ? *capacity - *head : count;
+        memcpy(grown, (char*)data + *head * item_size, first * item_size);
+        memcpy(grown + first * item_size, data, (count - first) * item_size);
+    }
+    hyp_mem_free(data);
+    *head = 0;
+    *capacity = new_capacity;
+    return grown;
 }
 
 /* String utilities implementation */
@@ -172,6 +529,141 @@ char* hyp_read_file(const char* filename, size_t* size) {
     return buffer;
 }
 
+/* Source loading. Mapping costs page-table setup and faults that copying
+ * a small file does not, so only files from this size up are mapped. */
+#define HYP_SOURCE_MAP_THRESHOLD (64 * 1024)
+
+#ifdef _WIN32
+#define SOURCE_READ(fd, buffer, size) _read((fd), (buffer), (unsigned int)(size))
+#define SOURCE_CLOSE(fd) _close(fd)
+#else
+#define SOURCE_READ(fd, buffer, size) read((fd), (buffer), (size))
+#define SOURCE_CLOSE(fd) close(fd)
+#endif
+
+/* Read fd to its end; size_hint is the expected size, 0 if unknown */
+static hyp_error_t read_source(hyp_source_t* source, int fd, size_t size_hint) {
+    /* Room past the expected size to see the end without growing */
+    size_t capacity = (size_hint ? size_hint : 64 * 1024) + 2;
+    char* buffer = HYP_MALLOC(capacity);
+    if (!buffer) return HYP_ERROR_MEMORY;
+    
+    size_t length = 0;
+    for (;;) {
+        if (capacity - length < 2) {
+            char* grown = HYP_REALLOC(buffer, capacity * 2);
+            if (!grown) {
+                HYP_FREE(buffer);
+                return HYP_ERROR_MEMORY;
+            }
+            buffer = grown;
+            capacity *= 2;
+        }
+        
+        long count = (long)SOURCE_READ(fd, buffer + length, capacity - length - 1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            HYP_FREE(buffer);
+            return HYP_ERROR_IO;
+        }
+        if (count == 0) break;
+        length += (size_t)count;
+    }
+    
+    buffer[length] = '\0';
+    source->data = buffer;
+    source->size = length;
+    source->mapping = NULL;
+    source->mapping_size = 0;
+    return HYP_OK;
+}
+
+#ifndef _WIN32
+/* Map size bytes of fd followed by at least one zero byte: the file is
+ * mapped over the start of an anonymous reservation a page longer than
+ * it needs, so the sentinel is the zero fill of the last page. */
+static bool map_source(hyp_source_t* source, int fd, size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mapping_size = (size / page + 1) * page;
+    
+    void* base = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return false;
+    
+    if (mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, mapping_size);
+        return false;
+    }
+    
+#ifdef MADV_SEQUENTIAL
+    /* The lexer reads it once, front to back */
+    madvise(base, size, MADV_SEQUENTIAL);
+#endif
+    
+    source->data = base;
+    source->size = size;
+    source->mapping = base;
+    source->mapping_size = mapping_size;
+    return true;
+}
+#endif
+
+hyp_error_t hyp_source_load(hyp_source_t* source, const char* filename) {
+    if (!source || !filename) return HYP_ERROR_INVALID_ARG;
+    memset(source, 0, sizeof(*source));
+    
+    if (strcmp(filename, "-") == 0) {
+#ifdef _WIN32
+        _setmode(0, _O_BINARY);
+#endif
+        return read_source(source, 0, 0);
+    }
+    
+#ifdef _WIN32
+    int fd = _open(filename, _O_RDONLY | _O_BINARY);
+#else
+    int fd = open(filename, O_RDONLY);
+#endif
+    if (fd < 0) return errno == ENOENT ? HYP_ERROR_NOT_FOUND : HYP_ERROR_IO;
+    
+    /* Pipes and devices report no useful size; read those to the end */
+    struct stat info;
+    size_t size_hint = 0;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        size_hint = (size_t)info.st_size;
+    }
+    
+#ifndef _WIN32
+    if (size_hint >= HYP_SOURCE_MAP_THRESHOLD && map_source(source, fd, size_hint)) {
+        /* The mapping stays valid once the descriptor is closed */
+        close(fd);
+        return HYP_OK;
+    }
+#endif
+    
+    hyp_error_t error = read_source(source, fd, size_hint);
+    SOURCE_CLOSE(fd);
+    return error;
+}
+
+void hyp_source_release(hyp_source_t* source) {
+    if (!source) return;
+    
+#ifndef _WIN32
+    if (source->mapping) {
+        munmap(source->mapping, source->mapping_size);
+    } else {
+        hyp_mem_free((void*)source->data);
+    }
+#else
+    hyp_mem_free((void*)source->data);
+#endif
+    
+    source->data = NULL;
+    source->size = 0;
+    source->mapping = NULL;
+    source->mapping_size = 0;
+}
+
 hyp_error_t hyp_write_file(const char* filename, const char* content, size_t size) {
     FILE* file = fopen(filename, "wb");
     if (!file) return HYP_ERROR_IO;
@@ -182,6 +674,22 @@ hyp_error_t hyp_write_file(const char* filename, const char* content, size_t siz
     return (bytes_written == size) ? HYP_OK : HYP_ERROR_IO;
 }
 
+int hyp_create_file(const char* filename) {
+#ifdef _WIN32
+    return _open(filename, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+}
+
+hyp_error_t hyp_close_file(int fd) {
+#ifdef _WIN32
+    return _close(fd) == 0 ? HYP_OK : HYP_ERROR_IO;
+#else
+    return close(fd) == 0 ? HYP_OK : HYP_ERROR_IO;
+#endif
+}
+
 bool hyp_file_exists(const char* filename) {
     FILE* file = fopen(filename, "r");
     if (file) {
@@ -189,4 +697,468 @@ bool hyp_file_exists(const char* filename) {
         return true;
     }
     return false;
-}
\ No newline at end of file
+}
+hyp_error_t hyp_make_directory(const char* path) {
+    if (!path || !*path) return HYP_ERROR_INVALID_ARG;
+    
+    size_t length = strlen(path);
+    char* buffer = HYP_MALLOC(length + 1);
+    if (!buffer) return HYP_ERROR_MEMORY;
+    memcpy(buffer, path, length + 1);
+    
+    /* Create each intermediate component, then the full path */
+    for (size_t i = 1; i <= length; i++) {
+        if (i < length && buffer[i] != '/' && buffer[i] != '\\') continue;
+        
+        char saved = buffer[i];
+        buffer[i] = '\0';
+#ifdef _WIN32
+        int status = _mkdir(buffer);
+#else
+        int status = mkdir(buffer, 0755);
+#endif
+        if (status != 0 && errno != EEXIST) {
+            HYP_FREE(buffer);
+            return HYP_ERROR_IO;
+        }
+        buffer[i] = saved;
+    }
+    
+    HYP_FREE(buffer);
+    return HYP_OK;
+}
+
+bool hyp_user_cache_dir(const char* name, char* buffer, size_t size) {
+    int length = -1;
+#ifdef _WIN32
+    const char* local = getenv("LOCALAPPDATA");
+    if (local && *local) length = snprintf(buffer, size, "%s\\hyper\\cache\\%s", local, name);
+#else
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    /* The XDG spec ignores relative paths */
+    if (xdg && xdg[0] == '/') {
+        length = snprintf(buffer, size, "%s/hyper/%s", xdg, name);
+    } else if (home && *home) {
+        length = snprintf(buffer, size, "%s/.cache/hyper/%s", home, name);
+    }
+#endif
+    return length > 0 && (size_t)length < size;
+}
+
+char* hyp_strdup_tagged(const char* str, hyp_mem_tag_t tag) {
+    if (!str) return NULL;
+    
+    size_t length = strlen(str);
+    char* copy = hyp_mem_alloc(length + 1, tag);
+    if (copy) {
+        memcpy(copy, str, length + 1);
+    }
+    return copy;
+}
+
+/* Hashing implementation */
+uint64_t hyp_hash_bytes(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = data;
+    uint64_t hash = seed;
+    
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    
+    return hash;
+}
+
+uint64_t hyp_hash_string(const char* str, uint64_t seed) {
+    if (!str) return seed;
+    return hyp_hash_bytes(str, strlen(str), seed);
+}
+
+/* SHA-256 (FIPS 180-4) */
+static const uint32_t sha256_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define SHA256_ROTATE(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(hyp_sha256_t* sha, const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+               (uint32_t)block[i * 4 + 2] << 8 | (uint32_t)block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = SHA256_ROTATE(w[i - 15], 7) ^ SHA256_ROTATE(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = SHA256_ROTATE(w[i - 2], 17) ^ SHA256_ROTATE(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = sha->state[0], b = sha->state[1], c = sha->state[2], d = sha->state[3];
+    uint32_t e = sha->state[4], f = sha->state[5], g = sha->state[6], h = sha->state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t s1 = SHA256_ROTATE(e, 6) ^ SHA256_ROTATE(e, 11) ^ SHA256_ROTATE(e, 25);
+        uint32_t choice = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + choice + sha256_constants[i] + w[i];
+        uint32_t s0 = SHA256_ROTATE(a, 2) ^ SHA256_ROTATE(a, 13) ^ SHA256_ROTATE(a, 22);
+        uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + majority;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    sha->state[0] += a;
+    sha->state[1] += b;
+    sha->state[2] += c;
+    sha->state[3] += d;
+    sha->state[4] += e;
+    sha->state[5] += f;
+    sha->state[6] += g;
+    sha->state[7] += h;
+}
+
+void hyp_sha256_init(hyp_sha256_t* sha) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(sha->state, initial, sizeof(initial));
+    sha->length = 0;
+    sha->used = 0;
+}
+
+void hyp_sha256_update(hyp_sha256_t* sha, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    sha->length += size;
+
+    if (sha->used > 0) {
+        size_t take = 64 - sha->used < size ? 64 - sha->used : size;
+        memcpy(sha->block + sha->used, bytes, take);
+        sha->used += take;
+        bytes += take;
+        size -= take;
+        if (sha->used < 64) return;
+        sha256_block(sha, sha->block);
+        sha->used = 0;
+    }
+    for (; size >= 64; bytes += 64, size -= 64) {
+        sha256_block(sha, bytes);
+    }
+    memcpy(sha->block, bytes, size);
+    sha->used = size;
+}
+
+void hyp_sha256_final(hyp_sha256_t* sha, hyp_digest_t* digest) {
+    uint64_t bits = sha->length * 8;
+
+    /* 0x80, zeros up to 56 bytes into a block, then the length in bits */
+    sha->block[sha->used++] = 0x80;
+    if (sha->used > 56) {
+        memset(sha->block + sha->used, 0, 64 - sha->used);
+        sha256_block(sha, sha->block);
+        sha->used = 0;
+    }
+    memset(sha->block + sha->used, 0, 56 - sha->used);
+    for (int i = 0; i < 8; i++) {
+        sha->block[56 + i] = (uint8_t)(bits >> (56 - i * 8));
+    }
+    sha256_block(sha, sha->block);
+
+    for (int i = 0; i < 8; i++) {
+        digest->bytes[i * 4] = (uint8_t)(sha->state[i] >> 24);
+        digest->bytes[i * 4 + 1] = (uint8_t)(sha->state[i] >> 16);
+        digest->bytes[i * 4 + 2] = (uint8_t)(sha->state[i] >> 8);
+        digest->bytes[i * 4 + 3] = (uint8_t)sha->state[i];
+    }
+}
+
+void hyp_sha256(const void* data, size_t size, hyp_digest_t* digest) {
+    hyp_sha256_t sha;
+    hyp_sha256_init(&sha);
+    hyp_sha256_update(&sha, data, size);
+    hyp_sha256_final(&sha, digest);
+}
+
+void hyp_digest_hex(const hyp_digest_t* digest, char* hex) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < HYP_DIGEST_SIZE; i++) {
+        hex[i * 2] = digits[digest->bytes[i] >> 4];
+        hex[i * 2 + 1] = digits[digest->bytes[i] & 15];
+    }
+    hex[HYP_DIGEST_SIZE * 2] = '\0';
+}
+
+/* Chunked output implementation */
+void hyp_out_init_tagged(hyp_out_t* out, int fd, hyp_mem_tag_t tag) {
+    out->head = NULL;
+    out->tail = NULL;
+    out->length = 0;
+    out->fd = fd;
+    out->failed = false;
+    out->tag = tag;
+}
+
+void hyp_out_destroy(hyp_out_t* out) {
+    if (!out) return;
+    
+    hyp_out_chunk_t* chunk = out->head;
+    while (chunk) {
+        hyp_out_chunk_t* next = chunk->next;
+        HYP_FREE(chunk);
+        chunk = next;
+    }
+    out->head = NULL;
+    out->tail = NULL;
+}
+
+static bool out_write_fd(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int written = _write(fd, data, (unsigned int)(size > 0x40000000 ? 0x40000000 : size));
+#else
+        ssize_t written = write(fd, data, size);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+/* Write buffered chunks to the file descriptor, keeping one for reuse */
+hyp_error_t hyp_out_flush(hyp_out_t* out) {
+    if (!out) return HYP_ERROR_INVALID_ARG;
+    if (out->fd < 0) return out->failed ? HYP_ERROR_IO : HYP_OK;
+    
+    hyp_out_chunk_t* chunk = out->head;
+    while (chunk) {
+        hyp_out_chunk_t* next = chunk->next;
+        if (!out->failed && chunk->length > 0 && !out_write_fd(out->fd, chunk->data, chunk->length)) {
+            out->failed = true;
+        }
+        if (chunk != out->tail) {
+            HYP_FREE(chunk);
+        }
+        chunk = next;
+    }
+    
+    out->head = out->tail;
+    if (out->tail) {
+        out->tail->length = 0;
+    }
+    return out->failed ? HYP_ERROR_IO : HYP_OK;
+}
+
+static bool out_grow(hyp_out_t* out, size_t size) {
+    /* Streaming output reuses one large chunk; in-memory output grows
+     * geometrically so small buffers stay small */
+    if (out->fd >= 0 && out->tail) {
+        if (hyp_out_flush(out) != HYP_OK) return false;
+        if (out->tail->capacity >= size) return true;
+    }
+    
+    size_t capacity = out->fd >= 0 ? HYP_OUT_MAX_CHUNK :
+                      out->tail ? out->tail->capacity * 2 : HYP_OUT_MIN_CHUNK;
+    if (capacity > HYP_OUT_MAX_CHUNK) capacity = HYP_OUT_MAX_CHUNK;
+    if (capacity < size) capacity = size;
+    
+    hyp_out_chunk_t* chunk = hyp_mem_alloc(sizeof(hyp_out_chunk_t) + capacity, out->tag);
+    if (!chunk) {
+        out->failed = true;
+        return false;
+    }
+    chunk->next = NULL;
+    chunk->length = 0;
+    chunk->capacity = capacity;
+    
+    if (out->fd >= 0 && out->tail) {
+        /* Replace the (flushed) chunk that was too small */
+        HYP_FREE(out->tail);
+        out->head = NULL;
+        out->tail = NULL;
+    }
+    if (out->tail) {
+        out->tail->next = chunk;
+    } else {
+        out->head = chunk;
+    }
+    out->tail = chunk;
+    return true;
+}
+
+void hyp_out_write_slow(hyp_out_t* out, const char* data, size_t size) {
+    if (out->failed) return;
+    
+    /* Fill the current chunk first so chunks stay dense */
+    hyp_out_chunk_t* tail = out->tail;
+    if (tail && tail->length < tail->capacity) {
+        size_t part = tail->capacity - tail->length;
+        if (part > size) part = size;
+        memcpy(tail->data + tail->length, data, part);
+        tail->length += part;
+        out->length += part;
+        data += part;
+        size -= part;
+    }
+    
+    while (size > 0) {
+        size_t want = size < HYP_OUT_MAX_CHUNK ? size : HYP_OUT_MAX_CHUNK;
+        if (!out_grow(out, want)) return;
+        
+        tail = out->tail;
+        size_t part = tail->capacity - tail->length;
+        if (part > size) part = size;
+        memcpy(tail->data + tail->length, data, part);
+        tail->length += part;
+        out->length += part;
+        data += part;
+        size -= part;
+    }
+}
+
+void hyp_out_puts(hyp_out_t* out, const char* str) {
+    if (str) {
+        hyp_out_write(out, str, strlen(str));
+    }
+}
+
+void hyp_out_vprintf(hyp_out_t* out, const char* format, va_list args) {
+    if (out->failed) return;
+    
+    /* Format straight into the free space of the current chunk; only
+     * output that does not fit is measured and formatted again */
+    hyp_out_chunk_t* tail = out->tail;
+    size_t space = tail ? tail->capacity - tail->length : 0;
+    
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(space ? tail->data + tail->length : NULL, space, format, copy);
+    va_end(copy);
+    if (length < 0) {
+        out->failed = true;
+        return;
+    }
+    
+    if ((size_t)length < space) {
+        tail->length += (size_t)length;
+        out->length += (size_t)length;
+        return;
+    }
+    
+    char* buffer = HYP_MALLOC((size_t)length + 1);
+    if (!buffer) {
+        out->failed = true;
+        return;
+    }
+    vsnprintf(buffer, (size_t)length + 1, format, args);
+    hyp_out_write(out, buffer, (size_t)length);
+    HYP_FREE(buffer);
+}
+
+void hyp_out_printf(hyp_out_t* out, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    hyp_out_vprintf(out, format, args);
+    va_end(args);
+}
+
+void hyp_out_write_uint(hyp_out_t* out, uint64_t value) {
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[sizeof(digits) - 1 - count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    hyp_out_write(out, digits + sizeof(digits) - count, count);
+}
+
+void hyp_out_write_double(hyp_out_t* out, double value) {
+    /* Integral values are by far the most common in source code; zero is
+     * checked by bits so -0 keeps its sign */
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if (bits == 0 || (value >= 1.0 && value < 1e15 && value == (double)(uint64_t)value)) {
+        hyp_out_write_uint(out, (uint64_t)value);
+        return;
+    }
+    
+    /* Written as expressions valid in both C and JavaScript: the
+     * overflowing product is infinity in either, and 0/0 is NaN */
+    if (value != value) {
+        hyp_out_puts(out, "(0.0 / 0.0)");
+        return;
+    }
+    if (value - value != 0.0) {
+        hyp_out_puts(out, value < 0 ? "-(1e308 * 10)" : "(1e308 * 10)");
+        return;
+    }
+    
+    char buffer[HYP_NUMBER_BUFFER_SIZE];
+    size_t length = hyp_number_format(value, buffer);
+    hyp_out_write(out, buffer, length);
+    
+    /* Large integers need a '.' to stay floating-point constants in C */
+    if (strspn(buffer, "-0123456789") == length) {
+        HYP_OUT_LITERAL(out, ".0");
+    }
+}
+
+/* Move all chunks of an in-memory buffer to the end of another */
+void hyp_out_append(hyp_out_t* out, hyp_out_t* from) {
+    if (!out || !from || !from->head) return;
+    
+    if (out->fd >= 0 || out->failed) {
+        for (hyp_out_chunk_t* chunk = from->head; chunk; chunk = chunk->next) {
+            hyp_out_write(out, chunk->data, chunk->length);
+        }
+        hyp_out_destroy(from);
+    } else {
+        if (out->tail) {
+            out->tail->next = from->head;
+        } else {
+            out->head = from->head;
+        }
+        out->tail = from->tail;
+        out->length += from->length;
+        from->head = NULL;
+        from->tail = NULL;
+    }
+    
+    if (from->failed) out->failed = true;
+    from->length = 0;
+}
+
+char* hyp_out_to_string(const hyp_out_t* out, size_t* length) {
+    size_t size = 0;
+    for (hyp_out_chunk_t* chunk = out->head; chunk; chunk = chunk->next) {
+        size += chunk->length;
+    }
+    
+    char* text = HYP_MALLOC(size + 1);
+    if (!text) return NULL;
+    
+    size_t offset = 0;
+    for (hyp_out_chunk_t* chunk = out->head; chunk; chunk = chunk->next) {
+        memcpy(text + offset, chunk->data, chunk->length);
+        offset += chunk->length;
+    }
+    text[size] = '\0';
+    
+    if (length) *length = size;
+    return text;
+}
@@ -0,0 +1,398 @@
+/**
+ * Hyper Programming Language - Metrics Implementation
+ *
+ * Registration takes a lock once per metric; updates after that only
+ * touch the calling thread's shard. Memory figures from hyp_mem_stats
+ * are published as mem.* gauges whenever the metrics are read.
+ */
+
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "../../include/hyp_metrics.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+/* Atomics */
+
+#if defined(__GNUC__)
+    #define METRIC_ADD(counter, n) __atomic_add_fetch(&(counter), (uint64_t)(n), __ATOMIC_RELAXED)
+    #define METRIC_LOAD(value) __atomic_load_n(&(value), __ATOMIC_RELAXED)
+    #define METRIC_STORE(value, n) __atomic_store_n(&(value), (n), __ATOMIC_RELAXED)
+    #define METRIC_PUBLISH(flag) __atomic_store_n(&(flag), true, __ATOMIC_RELEASE)
+    #define METRIC_PUBLISHED(flag) __atomic_load_n(&(flag), __ATOMIC_ACQUIRE)
+#elif defined(_MSC_VER) && defined(_WIN64)
+    #define METRIC_ADD(counter, n) InterlockedExchangeAdd64((volatile LONG64*)&(counter), (LONG64)(n))
+    #define METRIC_LOAD(value) (value)
+    #define METRIC_STORE(value, n) InterlockedExchange64((volatile LONG64*)&(value), (LONG64)(n))
+    #define METRIC_PUBLISH(flag) do { MemoryBarrier(); (flag) = true; } while (0)
+    #define METRIC_PUBLISHED(flag) (*(volatile bool*)&(flag))
+#else
+    /* Counts may be off when several threads share a shard */
+    #define METRIC_ADD(counter, n) ((counter) += (uint64_t)(n))
+    #define METRIC_LOAD(value) (value)
+    #define METRIC_STORE(value, n) ((value) = (n))
+    #define METRIC_PUBLISH(flag) ((flag) = true)
+    #define METRIC_PUBLISHED(flag) (flag)
+#endif
+
+/* Histogram buckets. Values below HYP_HISTOGRAM_STEPS nanoseconds get a
+ * bucket each; above that, each power of two gets HYP_HISTOGRAM_STEPS.
+ * The last bucket takes everything from 2^HISTOGRAM_MAX_EXPONENT ns
+ * (about 73 minutes) up. */
+#define HISTOGRAM_STEP_BITS 3
+#define HISTOGRAM_MAX_EXPONENT 42
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_EXPONENT - HISTOGRAM_STEP_BITS + 1) * HYP_HISTOGRAM_STEPS + 1)
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum;                /* Nanoseconds */
+    uint64_t max;
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+} histogram_shard_t;
+
+#define SHARD_STRIDE(kind) ((kind) == HYP_METRIC_COUNTER ? HYP_CACHE_LINE : \
+    (sizeof(histogram_shard_t) + HYP_CACHE_LINE - 1) & ~(size_t)(HYP_CACHE_LINE - 1))
+#define SHARD(metric, index) ((metric)->shards + (index) * SHARD_STRIDE((metric)->kind))
+
+static unsigned floor_log2(uint64_t x) {
+#if defined(__GNUC__)
+    return 63u - (unsigned)__builtin_clzll(x);
+#else
+    unsigned log = 0;
+    while (x >>= 1) log++;
+    return log;
+#endif
+}
+
+static size_t bucket_of(uint64_t ns) {
+    if (ns < HYP_HISTOGRAM_STEPS) return (size_t)ns;
+    unsigned exponent = floor_log2(ns);
+    if (exponent >= HISTOGRAM_MAX_EXPONENT) return HISTOGRAM_BUCKETS - 1;
+    return (exponent - HISTOGRAM_STEP_BITS + 1) * HYP_HISTOGRAM_STEPS +
+           (size_t)((ns >> (exponent - HISTOGRAM_STEP_BITS)) & (HYP_HISTOGRAM_STEPS - 1));
+}
+
+/* Middle of a bucket, in nanoseconds */
+static double bucket_middle(size_t bucket) {
+    if (bucket < HYP_HISTOGRAM_STEPS) return (double)bucket;
+    unsigned exponent = (unsigned)(bucket / HYP_HISTOGRAM_STEPS) + HISTOGRAM_STEP_BITS - 1;
+    double width = (double)((uint64_t)1 << (exponent - HISTOGRAM_STEP_BITS));
+    return (HYP_HISTOGRAM_STEPS + bucket % HYP_HISTOGRAM_STEPS) * width + width / 2;
+}
+
+/* Registry */
+
+static hyp_metric_t* metrics_first;
+static hyp_metric_t* metrics_last;
+static size_t metrics_count;
+
+#ifdef _WIN32
+static SRWLOCK metrics_lock = SRWLOCK_INIT;
+#define REGISTRY_LOCK() AcquireSRWLockExclusive(&metrics_lock)
+#define REGISTRY_UNLOCK() ReleaseSRWLockExclusive(&metrics_lock)
+#else
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+#define REGISTRY_LOCK() pthread_mutex_lock(&metrics_lock)
+#define REGISTRY_UNLOCK() pthread_mutex_unlock(&metrics_lock)
+#endif
+
+/* A metric whose shards cannot be allocated is still listed, and reads
+ * as zero; its updates are dropped */
+static void metric_register(hyp_metric_t* metric) {
+    REGISTRY_LOCK();
+    if (!metric->registered) {
+        if (metric->kind != HYP_METRIC_GAUGE) {
+            size_t size = HYP_METRIC_SHARDS * SHARD_STRIDE(metric->kind);
+            metric->memory = hyp_mem_calloc(1, size + HYP_CACHE_LINE - 1, HYP_MEM_OTHER);
+            if (metric->memory) {
+                uintptr_t aligned = ((uintptr_t)metric->memory + HYP_CACHE_LINE - 1) &
+                                    ~(uintptr_t)(HYP_CACHE_LINE - 1);
+                metric->shards = (char*)aligned;
+            }
+        }
+
+        metric->next = NULL;
+        if (metrics_last) {
+            metrics_last->next = metric;
+        } else {
+            metrics_first = metric;
+        }
+        metrics_last = metric;
+        metrics_count++;
+        METRIC_PUBLISH(metric->registered);
+    }
+    REGISTRY_UNLOCK();
+}
+
+static bool metric_ready(hyp_metric_t* metric) {
+    if (!METRIC_PUBLISHED(metric->registered)) metric_register(metric);
+    return metric->kind == HYP_METRIC_GAUGE || metric->shards != NULL;
+}
+
+/* Shard of the calling thread, handed out round robin */
+#ifdef HYP_HAVE_THREAD_LOCAL
+static HYP_THREAD_LOCAL unsigned thread_shard;   /* Shard plus one; 0 until assigned */
+#endif
+static uint64_t shards_assigned;
+
+static size_t current_shard(void) {
+#ifdef HYP_HAVE_THREAD_LOCAL
+    if (!thread_shard) {
+        thread_shard = (unsigned)(METRIC_ADD(shards_assigned, 1) % HYP_METRIC_SHARDS) + 1;
+    }
+    return thread_shard - 1;
+#else
+    return 0;
+#endif
+}
+
+/* Updates */
+
+void hyp_metric_add(hyp_metric_t* counter, uint64_t count) {
+    if (!counter || counter->kind != HYP_METRIC_COUNTER || !metric_ready(counter)) return;
+    uint64_t* value = (uint64_t*)SHARD(counter, current_shard());
+    METRIC_ADD(*value, count);
+}
+
+void hyp_metric_set(hyp_metric_t* gauge, int64_t value) {
+    if (!gauge || gauge->kind != HYP_METRIC_GAUGE || !metric_ready(gauge)) return;
+    METRIC_STORE(gauge->gauge, value);
+}
+
+void hyp_metric_observe(hyp_metric_t* histogram, double seconds) {
+    if (!histogram || histogram->kind != HYP_METRIC_HISTOGRAM || !metric_ready(histogram)) return;
+
+    uint64_t ns = seconds > 0.0 ? (uint64_t)(seconds * 1e9 + 0.5) : 0;
+    histogram_shard_t* shard = (histogram_shard_t*)SHARD(histogram, current_shard());
+    METRIC_ADD(shard->count, 1);
+    METRIC_ADD(shard->sum, ns);
+    METRIC_ADD(shard->buckets[bucket_of(ns)], 1);
+
+    /* Threads sharing a shard may race here; a lost maximum is harmless */
+    if (ns > METRIC_LOAD(shard->max)) METRIC_STORE(shard->max, ns);
+}
+
+/* Reading */
+
+static hyp_metric_t mem_live = HYP_GAUGE("mem.live_bytes", "Heap bytes allocated and not yet freed");
+static hyp_metric_t mem_peak = HYP_GAUGE("mem.peak_bytes", "Most heap bytes live at once");
+static hyp_metric_t mem_allocations = HYP_GAUGE("mem.allocations", "Heap allocations so far");
+static hyp_metric_t mem_reserved = HYP_GAUGE("mem.reserved_bytes", "Bytes the slab allocator holds from the system");
+
+/* Publish figures kept elsewhere; memory is only counted by some allocators */
+static void metrics_collect(void) {
+    hyp_mem_stats_t stats;
+    hyp_mem_stats(&stats);
+    if (!stats.tracked) return;
+
+    hyp_metric_set(&mem_live, (int64_t)stats.total.live);
+    hyp_metric_set(&mem_peak, (int64_t)stats.total.peak);
+    hyp_metric_set(&mem_allocations, (int64_t)stats.total.allocations);
+    if (stats.reserved) hyp_metric_set(&mem_reserved, (int64_t)stats.reserved);
+}
+
+/* Smallest observation at or above the given fraction of all of them */
+static double histogram_quantile(const uint64_t* buckets, uint64_t count, double fraction, double max) {
+    if (!count) return 0.0;
+    double exact = fraction * (double)count;
+    uint64_t rank = (uint64_t)exact;
+    if ((double)rank < exact || rank == 0) rank++;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            double value = bucket_middle(i) / 1e9;
+            return value < max ? value : max;
+        }
+    }
+    return max;
+}
+
+static void metric_read(const hyp_metric_t* metric, hyp_metric_value_t* value) {
+    memset(value, 0, sizeof(hyp_metric_value_t));
+    value->name = metric->name;
+    value->help = metric->help;
+    value->kind = metric->kind;
+
+    if (metric->kind == HYP_METRIC_GAUGE) {
+        value->value = METRIC_LOAD(metric->gauge);
+        return;
+    }
+    if (!metric->shards) return;
+
+    if (metric->kind == HYP_METRIC_COUNTER) {
+        uint64_t total = 0;
+        for (size_t i = 0; i < HYP_METRIC_SHARDS; i++) {
+            total += METRIC_LOAD(*(uint64_t*)SHARD(metric, i));
+        }
+        value->value = (int64_t)total;
+        return;
+    }
+
+    /* Summing the shards into a scratch histogram */
+    uint64_t* buckets = hyp_mem_calloc(HISTOGRAM_BUCKETS, sizeof(uint64_t), HYP_MEM_OTHER);
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    for (size_t i = 0; i < HYP_METRIC_SHARDS; i++) {
+        histogram_shard_t* shard = (histogram_shard_t*)SHARD(metric, i);
+        value->count += METRIC_LOAD(shard->count);
+        sum += METRIC_LOAD(shard->sum);
+        uint64_t shard_max = METRIC_LOAD(shard->max);
+        if (shard_max > max) max = shard_max;
+        if (buckets) {
+            for (size_t b = 0; b < HISTOGRAM_BUCKETS; b++) buckets[b] += METRIC_LOAD(shard->buckets[b]);
+        }
+    }
+
+    value->sum = sum / 1e9;
+    value->max = max / 1e9;
+    if (buckets) {
+        /* The buckets were read after the counts, so may hold a few more */
+        uint64_t count = 0;
+        for (size_t b = 0; b < HISTOGRAM_BUCKETS; b++) count += buckets[b];
+        value->p50 = histogram_quantile(buckets, count, 0.50, value->max);
+        value->p90 = histogram_quantile(buckets, count, 0.90, value->max);
+        value->p99 = histogram_quantile(buckets, count, 0.99, value->max);
+        hyp_mem_free(buckets);
+    }
+}
+
+/* The registry only grows, and a metric is linked complete, so a list
+ * walked from a count taken under the lock needs no lock itself */
+static hyp_metric_t* metrics_list(size_t* count) {
+    REGISTRY_LOCK();
+    hyp_metric_t* first = metrics_first;
+    *count = metrics_count;
+    REGISTRY_UNLOCK();
+    return first;
+}
+
+size_t hyp_metrics_snapshot(hyp_metric_value_t* values, size_t capacity) {
+    metrics_collect();
+
+    size_t count;
+    hyp_metric_t* metric = metrics_list(&count);
+    for (size_t i = 0; i < count && i < capacity; i++, metric = metric->next) {
+        metric_read(metric, &values[i]);
+    }
+    return count;
+}
+
+bool hyp_metrics_find(const char* name, hyp_metric_value_t* value) {
+    if (!name || !value) return false;
+    metrics_collect();
+
+    size_t count;
+    hyp_metric_t* metric = metrics_list(&count);
+    for (size_t i = 0; i < count; i++, metric = metric->next) {
+        if (strcmp(metric->name, name) == 0) {
+            metric_read(metric, value);
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Writing */
+
+static const char* kind_name(hyp_metric_kind_t kind) {
+    switch (kind) {
+        case HYP_METRIC_COUNTER: return "counter";
+        case HYP_METRIC_GAUGE: return "gauge";
+        default: return "histogram";
+    }
+}
+
+static void write_json_string(FILE* stream, const char* str) {
+    fputc('"', stream);
+    for (; *str; str++) {
+        unsigned char c = (unsigned char)*str;
+        if (c == '"' || c == '\\') {
+            fprintf(stream, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(stream, "\\u%04x", c);
+        } else {
+            fputc(c, stream);
+        }
+    }
+    fputc('"', stream);
+}
+
+static void write_json(FILE* stream, const hyp_metric_value_t* values, size_t count) {
+    fprintf(stream, "{\"metrics\":[");
+    for (size_t i = 0; i < count; i++) {
+        const hyp_metric_value_t* value = &values[i];
+        fprintf(stream, "%s\n  {\"name\":", i ? "," : "");
+        write_json_string(stream, value->name);
+        fprintf(stream, ",\"kind\":\"%s\",\"help\":", kind_name(value->kind));
+        write_json_string(stream, value->help ? value->help : "");
+        if (value->kind == HYP_METRIC_HISTOGRAM) {
+            fprintf(stream, ",\"count\":%llu,\"sum\":%.9g,\"p50\":%.9g,\"p90\":%.9g,\"p99\":%.9g,\"max\":%.9g}",
+                    (unsigned long long)value->count, value->sum, value->p50, value->p90, value->p99, value->max);
+        } else {
+            fprintf(stream, ",\"value\":%lld}", (long long)value->value);
+        }
+    }
+    fprintf(stream, "\n]}\n");
+}
+
+static void write_text(FILE* stream, const hyp_metric_value_t* values, size_t count) {
+    fprintf(stream, "Metrics\n");
+    for (size_t i = 0; i < count; i++) {
+        const hyp_metric_value_t* value = &values[i];
+        if (value->kind == HYP_METRIC_HISTOGRAM) {
+            fprintf(stream, "  %-28s %10llu calls  p50 %9.3f  p90 %9.3f  p99 %9.3f  max %9.3f ms\n",
+                    value->name, (unsigned long long)value->count, value->p50 * 1e3,
+                    value->p90 * 1e3, value->p99 * 1e3, value->max * 1e3);
+        } else {
+            fprintf(stream, "  %-28s %10lld\n", value->name, (long long)value->value);
+        }
+    }
+}
+
+void hyp_metrics_write(FILE* stream, bool json) {
+    size_t count = hyp_metrics_snapshot(NULL, 0);
+    hyp_metric_value_t* values = count ? hyp_mem_alloc(count * sizeof(hyp_metric_value_t), HYP_MEM_OTHER) : NULL;
+    if (count && !values) return;
+    /* Metrics registered since the count are left for next time */
+    size_t registered = hyp_metrics_snapshot(values, count);
+    if (registered < count) count = registered;
+
+    if (json) {
+        write_json(stream, values, count);
+    } else {
+        write_text(stream, values, count);
+    }
+    hyp_mem_free(values);
+}
+
+static bool metrics_json;
+
+static void metrics_report_at_exit(void) {
+    hyp_metrics_write(stderr, metrics_json);
+}
+
+bool hyp_metrics_report_at_exit(const char* format) {
+    static bool registered = false;
+
+    if (format && strcmp(format, HYP_STATS_JSON) == 0) {
+        metrics_json = true;
+    } else if (!format || strcmp(format, HYP_STATS_TEXT) == 0) {
+        metrics_json = false;
+    } else {
+        return false;
+    }
+
+    if (!registered) {
+        atexit(metrics_report_at_exit);
+        registered = true;
+    }
+    return true;
+}
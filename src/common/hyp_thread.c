@@ -0,0 +1,263 @@
+/**
+ * Hyper Programming Language - Worker Threads Implementation
+ */
+
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "../../include/hyp_thread.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+    #include <time.h>
+#endif
+
+struct hyp_mutex {
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+};
+
+hyp_mutex_t* hyp_mutex_create(void) {
+    hyp_mutex_t* mutex = HYP_MALLOC(sizeof(hyp_mutex_t));
+    if (!mutex) return NULL;
+
+#ifdef _WIN32
+    InitializeCriticalSection(&mutex->lock);
+#else
+    if (pthread_mutex_init(&mutex->lock, NULL) != 0) {
+        HYP_FREE(mutex);
+        return NULL;
+    }
+#endif
+    return mutex;
+}
+
+void hyp_mutex_lock(hyp_mutex_t* mutex) {
+#ifdef _WIN32
+    EnterCriticalSection(&mutex->lock);
+#else
+    pthread_mutex_lock(&mutex->lock);
+#endif
+}
+
+void hyp_mutex_unlock(hyp_mutex_t* mutex) {
+#ifdef _WIN32
+    LeaveCriticalSection(&mutex->lock);
+#else
+    pthread_mutex_unlock(&mutex->lock);
+#endif
+}
+
+void hyp_mutex_destroy(hyp_mutex_t* mutex) {
+    if (!mutex) return;
+
+#ifdef _WIN32
+    DeleteCriticalSection(&mutex->lock);
+#else
+    pthread_mutex_destroy(&mutex->lock);
+#endif
+    HYP_FREE(mutex);
+}
+
+size_t hyp_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (size_t)info.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+#else
+    return 1;
+#endif
+}
+
+double hyp_wall_time(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#endif
+}
+
+#ifdef HYP_HAVE_THREAD_LOCAL
+/* One key for the process; a thread gives it a value on registering
+ * its first hook, so the key's destructor runs when the thread exits */
+static HYP_THREAD_LOCAL void (*exit_hooks[HYP_THREAD_EXIT_HOOKS])(void);
+static HYP_THREAD_LOCAL size_t exit_hook_count;
+
+static void run_exit_hooks(void) {
+    while (exit_hook_count > 0) {
+        exit_hooks[--exit_hook_count]();
+    }
+    hyp_mem_thread_exit();
+}
+
+#ifdef _WIN32
+static DWORD exit_key = FLS_OUT_OF_INDEXES;
+static INIT_ONCE exit_key_once = INIT_ONCE_STATIC_INIT;
+
+static VOID WINAPI exit_key_destructor(PVOID value) {
+    (void)value;
+    run_exit_hooks();
+}
+
+static BOOL CALLBACK exit_key_create(PINIT_ONCE once, PVOID parameter, PVOID* context) {
+    (void)once;
+    (void)parameter;
+    (void)context;
+    exit_key = FlsAlloc(exit_key_destructor);
+    return TRUE;
+}
+
+static bool exit_key_set(void) {
+    InitOnceExecuteOnce(&exit_key_once, exit_key_create, NULL, NULL);
+    return exit_key != FLS_OUT_OF_INDEXES && FlsSetValue(exit_key, exit_hooks);
+}
+#else
+static pthread_key_t exit_key;
+static bool exit_key_ready;
+static pthread_once_t exit_key_once = PTHREAD_ONCE_INIT;
+
+static void exit_key_destructor(void* value) {
+    (void)value;
+    run_exit_hooks();
+}
+
+static void exit_key_create(void) {
+    exit_key_ready = pthread_key_create(&exit_key, exit_key_destructor) == 0;
+}
+
+static bool exit_key_set(void) {
+    pthread_once(&exit_key_once, exit_key_create);
+    return exit_key_ready && pthread_setspecific(exit_key, exit_hooks) == 0;
+}
+#endif
+
+bool hyp_thread_at_exit(void (*fn)(void)) {
+    for (size_t i = 0; i < exit_hook_count; i++) {
+        if (exit_hooks[i] == fn) return true;
+    }
+    if (exit_hook_count == HYP_THREAD_EXIT_HOOKS) return false;
+    if (exit_hook_count == 0 && !exit_key_set()) return false;
+
+    exit_hooks[exit_hook_count++] = fn;
+    return true;
+}
+#else
+bool hyp_thread_at_exit(void (*fn)(void)) {
+    (void)fn;
+    return false;
+}
+#endif
+
+size_t hyp_worker_count(size_t requested) {
+    size_t count = requested ? requested : hyp_cpu_count();
+    if (count > HYP_MAX_WORKERS) count = HYP_MAX_WORKERS;
+    return count ? count : 1;
+}
+
+/* State shared by the workers of one hyp_parallel_for call */
+typedef struct {
+    hyp_task_fn_t task;
+    void* context;
+    size_t count;
+    size_t next;                 /* Next unclaimed index, guarded by lock */
+    hyp_mutex_t* lock;
+} parallel_state_t;
+
+typedef struct {
+    parallel_state_t* state;
+    size_t worker;
+} worker_arg_t;
+
+static void run_worker(parallel_state_t* state, size_t worker) {
+    for (;;) {
+        hyp_mutex_lock(state->lock);
+        size_t index = state->next;
+        if (index < state->count) state->next++;
+        hyp_mutex_unlock(state->lock);
+
+        if (index >= state->count) return;
+        state->task(state->context, index, worker);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_main(LPVOID arg) {
+    worker_arg_t* worker = arg;
+    run_worker(worker->state, worker->worker);
+    hyp_mem_thread_exit();
+    return 0;
+}
+#else
+static void* worker_main(void* arg) {
+    worker_arg_t* worker = arg;
+    run_worker(worker->state, worker->worker);
+    hyp_mem_thread_exit();
+    return NULL;
+}
+#endif
+
+void hyp_parallel_for(size_t count, size_t workers, hyp_task_fn_t task, void* context) {
+    if (!task || count == 0) return;
+    if (workers > count) workers = count;
+    if (workers > HYP_MAX_WORKERS) workers = HYP_MAX_WORKERS;
+
+    parallel_state_t state = { task, context, count, 0, NULL };
+    if (workers > 1) {
+        state.lock = hyp_mutex_create();
+    }
+    if (!state.lock) {
+        for (size_t i = 0; i < count; i++) {
+            task(context, i, 0);
+        }
+        return;
+    }
+
+    worker_arg_t args[HYP_MAX_WORKERS];
+#ifdef _WIN32
+    HANDLE threads[HYP_MAX_WORKERS];
+#else
+    pthread_t threads[HYP_MAX_WORKERS];
+#endif
+
+    /* Worker ids stay dense even if some threads fail to start */
+    size_t started = 0;
+    for (size_t i = 1; i < workers; i++) {
+        args[started].state = &state;
+        args[started].worker = started + 1;
+#ifdef _WIN32
+        threads[started] = CreateThread(NULL, 0, worker_main, &args[started], 0, NULL);
+        if (!threads[started]) break;
+#else
+        if (pthread_create(&threads[started], NULL, worker_main, &args[started]) != 0) break;
+#endif
+        started++;
+    }
+
+    run_worker(&state, 0);
+
+    for (size_t i = 0; i < started; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+
+    hyp_mutex_destroy(state.lock);
+}
@@ -5,6 +5,8 @@
  * Handles package installation, dependency resolution, and manifest management.
  */
 
+#define HYP_MEM_TAG HYP_MEM_HPM
+
 #include "../../include/hpm.h"
 #include "../../include/hyp_common.h"
 #include <stdio.h>
@@ -94,50 +96,38 @@ static char* join_path(const char* base, const char* path) {
 }
 
 /* Package version functions */
-hyp_version_t* hyp_package_version_create(const char* version_string) {
-    if (!version_string) return NULL;
-    
-    hyp_version_t* version = HYP_MALLOC(sizeof(hyp_version_t));
-    if (!version) return NULL;
+hyp_version_t hpm_parse_version(const char* version_str) {
+    hyp_version_t version;
+    memset(&version, 0, sizeof(hyp_version_t));
+    if (!version_str) return version;
     
-    /* Parse semantic version (major.minor.patch) */
-    version->major = 0;
-    version->minor = 0;
-    version->patch = 0;
-    version->prerelease = NULL;
-    version->build = NULL;
+    char* version_copy = hyp_strdup(version_str);
+    if (!version_copy) return version;
     
-    char* version_copy = HYP_MALLOC(strlen(version_string) + 1);
-    if (!version_copy) {
-        HYP_FREE(version);
-        return NULL;
-    }
-    strcpy(version_copy, version_string);
-    
-    /* Parse major version */
+    /* Parse semantic version (major.minor.patch[-prerelease][+build]) */
     char* token = strtok(version_copy, ".");
     if (token) {
-        version->major = (uint32_t)atoi(token);
+        version.major = atoi(token);
         
         /* Parse minor version */
         token = strtok(NULL, ".");
         if (token) {
-            version->minor = (uint32_t)atoi(token);
+            version.minor = atoi(token);
             
             /* Parse patch version */
             token = strtok(NULL, "-+");
             if (token) {
-                version->patch = (uint32_t)atoi(token);
+                version.patch = atoi(token);
                 
                 /* Parse prerelease */
                 token = strtok(NULL, "+");
                 if (token) {
-                    version->prerelease = hyp_string_create(token);
+                    version.prerelease = hyp_strdup(token);
                     
                     /* Parse build metadata */
                     token = strtok(NULL, "");
                     if (token) {
-                        version->build = hyp_string_create(token);
+                        version.build = hyp_strdup(token);
                     }
                 }
             }
@@ -148,20 +138,16 @@ hyp_version_t* hyp_package_version_create(const char* version_string) {
     return version;
 }
 
-void hyp_package_version_destroy(hyp_version_t* version) {
+void hpm_version_free(hyp_version_t* version) {
     if (!version) return;
     
-    if (version->prerelease) {
-        hyp_string_destroy(version->prerelease);
-    }
-    if (version->build) {
-        hyp_string_destroy(version->build);
-    }
-    
-    HYP_FREE(version);
+    HYP_FREE(version->prerelease);
+    HYP_FREE(version->build);
+    version->prerelease = NULL;
+    version->build = NULL;
 }
 
-int hyp_package_version_compare(hyp_version_t* a, hyp_version_t* b) {
+int hpm_version_compare(const hyp_version_t* a, const hyp_version_t* b) {
     if (!a || !b) return 0;
     
     /* Compare major version */
@@ -183,86 +169,102 @@ int hyp_package_version_compare(hyp_version_t* a, hyp_version_t* b) {
     if (a->prerelease && !b->prerelease) return -1;
     if (!a->prerelease && b->prerelease) return 1;
     if (a->prerelease && b->prerelease) {
-        return strcmp(a->prerelease->chars, b->prerelease->chars);
+        return strcmp(a->prerelease, b->prerelease);
     }
     
     return 0; /* Equal */
 }
 
-/* Package dependency functions */
-hyp_package_dependency_t* hyp_package_dependency_create(const char* name, const char* version_spec) {
-    if (!name) return NULL;
+char* hpm_version_to_string(const hyp_version_t* version) {
+    if (!version) return NULL;
     
-    hyp_package_dependency_t* dep = HYP_MALLOC(sizeof(hyp_package_dependency_t));
-    if (!dep) return NULL;
+    size_t size = 3 * 12 + 3 +
+                  (version->prerelease ? strlen(version->prerelease) + 1 : 0) +
+                  (version->build ? strlen(version->build) + 1 : 0);
+    char* text = HYP_MALLOC(size);
+    if (!text) return NULL;
     
-    dep->name = hyp_string_create(name);
-    dep->version_spec = version_spec ? hyp_string_create(version_spec) : NULL;
-    dep->optional = false;
-    dep->dev_only = false;
+    snprintf(text, size, "%d.%d.%d%s%s%s%s", version->major, version->minor, version->patch,
+             version->prerelease ? "-" : "", version->prerelease ? version->prerelease : "",
+             version->build ? "+" : "", version->build ? version->build : "");
+    return text;
+}
+
+/* Package manifest functions */
+hyp_package_t* hpm_create_package(const char* name, const char* version) {
+    hyp_package_t* package = HYP_MALLOC(sizeof(hyp_package_t));
+    if (!package) return NULL;
+    
+    memset(package, 0, sizeof(hyp_package_t));
+    package->name = name ? hyp_strdup(name) : NULL;
+    package->version = hpm_parse_version(version);
     
-    if (!dep->name) {
-        hyp_package_dependency_destroy(dep);
+    if (name && !package->name) {
+        hpm_package_free(package);
         return NULL;
     }
     
-    return dep;
+    return package;
 }
 
-void hyp_package_dependency_destroy(hyp_package_dependency_t* dep) {
-    if (!dep) return;
+void hpm_package_add_dependency(hyp_package_t* package, const char* name, const char* version_spec, bool is_dev) {
+    if (!package || !name) return;
+    
+    hyp_dependency_t** list = is_dev ? &package->dev_dependencies : &package->dependencies;
+    size_t* count = is_dev ? &package->dev_dependency_count : &package->dependency_count;
     
-    if (dep->name) hyp_string_destroy(dep->name);
-    if (dep->version_spec) hyp_string_destroy(dep->version_spec);
+    hyp_dependency_t* grown = HYP_REALLOC(*list, (*count + 1) * sizeof(hyp_dependency_t));
+    if (!grown) return;
+    *list = grown;
     
-    HYP_FREE(dep);
+    hyp_dependency_t* dep = &grown[*count];
+    memset(dep, 0, sizeof(hyp_dependency_t));
+    dep->name = hyp_strdup(name);
+    dep->version_spec = version_spec ? hyp_strdup(version_spec) : NULL;
+    dep->is_dev = is_dev;
+    if (!dep->name) return;
+    
+    (*count)++;
 }
 
-/* Package manifest functions */
-hyp_package_manifest_t* hyp_package_manifest_create(void) {
-    hyp_package_manifest_t* manifest = HYP_MALLOC(sizeof(hyp_package_manifest_t));
-    if (!manifest) return NULL;
-    
-    manifest->name = NULL;
-    manifest->version = NULL;
-    manifest->description = NULL;
-    manifest->author = NULL;
-    manifest->license = NULL;
-    manifest->homepage = NULL;
-    manifest->repository = NULL;
-    manifest->main = NULL;
-    manifest->dependencies = NULL;
-    manifest->dependency_count = 0;
-    manifest->scripts = NULL;
-    manifest->script_count = 0;
-    
-    return manifest;
+static void free_dependencies(hyp_dependency_t* deps, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        HYP_FREE(deps[i].name);
+        HYP_FREE(deps[i].version_spec);
+        HYP_FREE(deps[i].source);
+    }
+    HYP_FREE(deps);
 }
 
-void hyp_package_manifest_destroy(hyp_package_manifest_t* manifest) {
-    if (!manifest) return;
-    
-    if (manifest->name) hyp_string_destroy(manifest->name);
-    if (manifest->version) hyp_package_version_destroy(manifest->version);
-    if (manifest->description) hyp_string_destroy(manifest->description);
-    if (manifest->author) hyp_string_destroy(manifest->author);
-    if (manifest->license) hyp_string_destroy(manifest->license);
-    if (manifest->homepage) hyp_string_destroy(manifest->homepage);
-    if (manifest->repository) hyp_string_destroy(manifest->repository);
-    if (manifest->main) hyp_string_destroy(manifest->main);
-    
-    for (size_t i = 0; i < manifest->dependency_count; i++) {
-        hyp_package_dependency_destroy(manifest->dependencies[i]);
+void hpm_package_free(hyp_package_t* package) {
+    if (!package) return;
+    
+    HYP_FREE(package->name);
+    hpm_version_free(&package->version);
+    HYP_FREE(package->description);
+    HYP_FREE(package->author);
+    HYP_FREE(package->license);
+    HYP_FREE(package->homepage);
+    HYP_FREE(package->repository);
+    HYP_FREE(package->main);
+    HYP_FREE(package->cli);
+    HYP_FREE(package->web);
+    
+    free_dependencies(package->dependencies, package->dependency_count);
+    free_dependencies(package->dev_dependencies, package->dev_dependency_count);
+    
+    for (size_t i = 0; i < package->script_count; i++) {
+        HYP_FREE(package->scripts[i].name);
+        HYP_FREE(package->scripts[i].command);
     }
-    HYP_FREE(manifest->dependencies);
+    HYP_FREE(package->scripts);
     
-    for (size_t i = 0; i < manifest->script_count; i++) {
-        if (manifest->scripts[i].name) hyp_string_destroy(manifest->scripts[i].name);
-        if (manifest->scripts[i].command) hyp_string_destroy(manifest->scripts[i].command);
-    }
-    HYP_FREE(manifest->scripts);
+    for (size_t i = 0; i < package->keyword_count; i++) HYP_FREE(package->keywords[i]);
+    HYP_FREE(package->keywords);
+    for (size_t i = 0; i < package->file_count; i++) HYP_FREE(package->files[i]);
+    HYP_FREE(package->files);
     
-    HYP_FREE(manifest);
+    HYP_FREE(package);
 }
 
 /* HPM context functions */
@@ -270,8 +272,10 @@ hpm_context_t* hpm_create(void) {
     hpm_context_t* hpm = HYP_MALLOC(sizeof(hpm_context_t));
     if (!hpm) return NULL;
     
-    hpm->config.registry_url = strdup(DEFAULT_REGISTRY_URL);
-    hpm->config.cache_dir = strdup(DEFAULT_CACHE_DIR);
+    memset(hpm, 0, sizeof(hpm_context_t));
+    HYP_MAP_INIT(&hpm->installed);
+    hpm->config.registry_url = hyp_strdup(DEFAULT_REGISTRY_URL);
+    hpm->config.cache_dir = hyp_strdup(DEFAULT_CACHE_DIR);
     hpm->config.offline_mode = false;
     /* Config initialized */
     
@@ -285,7 +289,7 @@ hpm_context_t* hpm_create(void) {
     }
     
     /* Create cache directory if it doesn't exist */
-    create_directory(hpm->config.cache_dir->chars);
+    create_directory(hpm->config.cache_dir);
     
     return hpm;
 }
@@ -293,11 +297,20 @@ hpm_context_t* hpm_create(void) {
 void hpm_destroy(hpm_context_t* hpm) {
     if (!hpm) return;
     
-    if (hpm->config.registry_url) free(hpm->config.registry_url);
-    if (hpm->config.cache_dir) free(hpm->config.cache_dir);
-    if (hpm->current_package) free(hpm->current_package);
-    if (hpm->project_root) free(hpm->project_root);
-    if (hpm->hypkg_dir) free(hpm->hypkg_dir);
+    HYP_FREE(hpm->config.registry_url);
+    HYP_FREE(hpm->config.cache_dir);
+    HYP_FREE(hpm->current_package);
+    HYP_FREE(hpm->project_root);
+    HYP_FREE(hpm->hypkg_dir);
+    
+    for (size_t i = 0; i < HYP_MAP_CAPACITY(&hpm->installed); i++) {
+        if (!HYP_MAP_KEY(&hpm->installed, i)) continue;
+        hpm_installed_t* installed = &HYP_MAP_VALUE(&hpm->installed, i);
+        hyp_mem_free((char*)HYP_MAP_KEY(&hpm->installed, i));
+        hpm_version_free(&installed->version);
+        HYP_FREE(installed->path);
+    }
+    HYP_MAP_FREE(&hpm->installed);
     
     HYP_FREE(hpm);
 }
@@ -309,7 +322,7 @@ hyp_package_t* hpm_load_manifest(hpm_context_t* hpm, const char* manifest_path)
     const char* path = manifest_path ? manifest_path : MANIFEST_FILENAME;
     
     /* Check if manifest file exists */
-    if (!hyp_file_exists(manifest_path)) {
+    if (!hyp_file_exists(path)) {
         hpm->has_error = true;
         strcpy(hpm->error_message, "package.yml not found");
         return NULL;
@@ -317,7 +330,7 @@ hyp_package_t* hpm_load_manifest(hpm_context_t* hpm, const char* manifest_path)
     
     /* TODO: Implement YAML parsing */
     /* For now, create a basic package */
-    hpm->current_package = malloc(sizeof(hyp_package_t));
+    hpm->current_package = HYP_MALLOC(sizeof(hyp_package_t));
     if (!hpm->current_package) {
         hpm->has_error = true;
         strcpy(hpm->error_message, "Failed to create package");
@@ -332,6 +345,7 @@ hyp_package_t* hpm_load_manifest(hpm_context_t* hpm, const char* manifest_path)
 
 hyp_error_t hpm_save_manifest(hpm_context_t* hpm, const hyp_package_t* package, const char* manifest_path) {
     if (!hpm || !hpm->current_package) return HYP_ERROR_INVALID_ARG;
+    (void)package;
     
     const char* path = manifest_path ? manifest_path : MANIFEST_FILENAME;
     
@@ -368,6 +382,7 @@ hyp_error_t hpm_save_manifest(hpm_context_t* hpm, const hyp_package_t* package,
 /* Package operations */
 hyp_error_t hpm_install(hpm_context_t* hpm, const char* package_name, const hpm_install_options_t* options) {
     if (!hpm || !package_name) return HYP_ERROR_INVALID_ARG;
+    (void)options;
     
     printf("Installing package: %s\n", package_name);
     
@@ -387,6 +402,7 @@ hyp_error_t hpm_install(hpm_context_t* hpm, const char* package_name, const hpm_
 
 hyp_error_t hpm_remove(hpm_context_t* hpm, const char* package_name, bool remove_from_manifest) {
     if (!hpm || !package_name) return HYP_ERROR_INVALID_ARG;
+    (void)remove_from_manifest;
     
     printf("Removing package: %s\n", package_name);
     
@@ -413,13 +429,12 @@ hyp_error_t hpm_update(hpm_context_t* hpm, const char* package_name) {
 
 hyp_error_t hpm_init_package(hpm_context_t* hpm, const char* package_name, bool interactive) {
     if (!hpm) return HYP_ERROR_INVALID_ARG;
+    (void)interactive;
     
     /* Create new package */
-    if (hpm->current_package) {
-        free(hpm->current_package);
-    }
+    HYP_FREE(hpm->current_package);
     
-    hpm->current_package = malloc(sizeof(hyp_package_t));
+    hpm->current_package = HYP_MALLOC(sizeof(hyp_package_t));
     if (!hpm->current_package) {
         hpm->has_error = true;
         strcpy(hpm->error_message, "Failed to create package");
@@ -469,23 +484,153 @@ void hpm_clear_error(hpm_context_t* hpm) {
     hpm->error_message[0] = '\0';
 }
 
-/* Placeholder implementations for remaining functions */
-int hpm_search(hpm_context_t* hpm, const char* query, hyp_registry_entry_t* results, size_t max_results) {
+/* Error for an operation that does not exist yet */
+static hyp_error_t not_implemented(hpm_context_t* hpm, const char* what) {
+    if (hpm) {
+        hpm->has_error = true;
+        snprintf(hpm->error_message, sizeof(hpm->error_message), "%s not yet implemented", what);
+    }
     return HYP_ERROR_RUNTIME;
 }
 
-hyp_error_t hpm_publish(hpm_context_t* hpm, const char* package_dir) {
-    return HYP_ERROR_RUNTIME;
+/* Installed packages */
+static hyp_error_t record_installed(hpm_context_t* hpm, const char* name, const char* version) {
+    char* path = join_path(hpm->config.cache_dir, name);
+    if (!path) return HYP_ERROR_MEMORY;
+    
+    size_t slot = HYP_MAP_FIND(&hpm->installed, name);
+    if (slot == HYP_MAP_NONE) {
+        char* key = hyp_strdup(name);
+        slot = key ? HYP_MAP_SLOT(&hpm->installed, key, NULL) : HYP_MAP_NONE;
+        if (slot == HYP_MAP_NONE) {
+            HYP_FREE(key);
+            HYP_FREE(path);
+            return HYP_ERROR_MEMORY;
+        }
+    } else {
+        hpm_version_free(&HYP_MAP_VALUE(&hpm->installed, slot).version);
+        HYP_FREE(HYP_MAP_VALUE(&hpm->installed, slot).path);
+    }
+    
+    HYP_MAP_VALUE(&hpm->installed, slot).version = hpm_parse_version(version);
+    HYP_MAP_VALUE(&hpm->installed, slot).path = path;
+    return HYP_OK;
+}
+
+hyp_error_t hpm_load_lock(hpm_context_t* hpm, const char* lock_path) {
+    if (!hpm) return HYP_ERROR_INVALID_ARG;
+    
+    const char* path = lock_path ? lock_path : LOCK_FILENAME;
+    if (!hyp_file_exists(path)) return HYP_OK;
+    
+    size_t size;
+    char* text = hyp_read_file(path, &size);
+    if (!text) {
+        hpm->has_error = true;
+        snprintf(hpm->error_message, sizeof(hpm->error_message), "Could not read %s", path);
+        return HYP_ERROR_IO;
+    }
+    
+    /* Not strtok: hpm_parse_version uses it */
+    hyp_error_t result = HYP_OK;
+    char* next = text;
+    while (*next && result == HYP_OK) {
+        char* line = next;
+        next += strcspn(next, "\r\n");
+        if (*next) *next++ = '\0';
+        
+        line += strspn(line, " \t");
+        char* colon = strchr(line, ':');
+        if (*line == '#' || !colon || colon == line) continue;
+        
+        char* name_end = colon;
+        while (name_end > line && (name_end[-1] == ' ' || name_end[-1] == '\t')) name_end--;
+        *name_end = '\0';
+        char* version = colon + 1;
+        version += strspn(version, " \t\"'");
+        version[strcspn(version, " \t\"'#")] = '\0';
+        if (!*version) continue;
+        
+        result = record_installed(hpm, line, version);
+    }
+    HYP_FREE(text);
+    
+    if (result != HYP_OK) {
+        hpm->has_error = true;
+        strcpy(hpm->error_message, "Out of memory");
+    }
+    return result;
+}
+
+const hpm_installed_t* hpm_find_installed(const hpm_context_t* hpm, const char* package_name) {
+    if (!hpm || !package_name) return NULL;
+    
+    size_t slot = HYP_MAP_FIND(&hpm->installed, package_name);
+    return slot == HYP_MAP_NONE ? NULL : &HYP_MAP_VALUE(&hpm->installed, slot);
+}
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
 }
 
 hyp_error_t hpm_list(hpm_context_t* hpm, bool global) {
-    return HYP_ERROR_RUNTIME;
+    if (!hpm) return HYP_ERROR_INVALID_ARG;
+    if (global) return not_implemented(hpm, "Listing global packages");
+    
+    hyp_error_t result = hpm_load_lock(hpm, NULL);
+    if (result != HYP_OK) return result;
+    
+    size_t count = HYP_MAP_COUNT(&hpm->installed);
+    if (count == 0) {
+        printf("No packages installed\n");
+        return HYP_OK;
+    }
+    
+    /* By name, not in table order */
+    const char** names = HYP_MALLOC(count * sizeof(const char*));
+    if (!names) {
+        hpm->has_error = true;
+        strcpy(hpm->error_message, "Out of memory");
+        return HYP_ERROR_MEMORY;
+    }
+    size_t named = 0;
+    for (size_t i = 0; i < HYP_MAP_CAPACITY(&hpm->installed); i++) {
+        if (HYP_MAP_KEY(&hpm->installed, i)) names[named++] = HYP_MAP_KEY(&hpm->installed, i);
+    }
+    qsort(names, count, sizeof(const char*), compare_names);
+    
+    for (size_t i = 0; i < count; i++) {
+        const hpm_installed_t* installed = hpm_find_installed(hpm, names[i]);
+        char* version = hpm_version_to_string(&installed->version);
+        printf("%s@%s  %s\n", names[i], version ? version : "?", installed->path);
+        HYP_FREE(version);
+    }
+    HYP_FREE(names);
+    return HYP_OK;
+}
+
+/* Placeholder implementations for remaining functions */
+int hpm_search(hpm_context_t* hpm, const char* query, hyp_registry_entry_t* results, size_t max_results) {
+    (void)query;
+    (void)results;
+    (void)max_results;
+    not_implemented(hpm, "Package search");
+    return -1;
+}
+
+hyp_error_t hpm_publish(hpm_context_t* hpm, const char* package_dir) {
+    (void)package_dir;
+    return not_implemented(hpm, "Publishing");
 }
 
 hyp_error_t hpm_info(hpm_context_t* hpm, const char* package_name) {
-    return HYP_ERROR_RUNTIME;
+    (void)package_name;
+    return not_implemented(hpm, "Package information");
 }
 
 hyp_error_t hpm_run_script(hpm_context_t* hpm, const char* script_name, char** args, size_t arg_count) {
-    return HYP_ERROR_RUNTIME;
-}
\ No newline at end of file
+    (void)script_name;
+    (void)args;
+    (void)arg_count;
+    return not_implemented(hpm, "Running scripts");
+}
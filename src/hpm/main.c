@@ -5,8 +5,12 @@
  * Handles package installation, dependency management, and project initialization.
  */
 
+#define HYP_MEM_TAG HYP_MEM_HPM
+
 #include "../../include/hpm.h"
 #include "../../include/hyp_common.h"
+#include "../../include/hyp_metrics.h"
+#include "../../include/hyp_thread.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -34,6 +38,11 @@
                 options->force = true;
             } else if (strcmp(argv[i], "--offline") == 0) {
                 options->offline = true;
+            } else if (strcmp(argv[i], "--stats") == 0) {
+                options->stats = true;
+            } else if (strncmp(argv[i], "--stats=", 8) == 0) {
+                options->stats = true;
+                options->stats_format = argv[i] + 8;
             } else if (strcmp(argv[i], "--registry") == 0 && i + 1 < argc) {
                 options->registry_url = argv[++i];
             } else if (argv[i][0] != '-') {
@@ -82,6 +91,8 @@ typedef struct {
     bool offline;
     bool force;
     char* registry_url;
+    bool stats;
+    const char* stats_format;
 } hpm_options_t;
 
 /* Print usage information */
@@ -105,6 +116,7 @@ static void print_usage(const char* program_name) {
     printf("      --offline           Work in offline mode\n");
     printf("  -f, --force             Force operation\n");
     printf("      --registry <url>    Use custom registry\n");
+    printf("      --stats[=json]      Print metrics to stderr on exit\n");
     printf("  -h, --help              Show this help message\n");
     printf("      --version           Show version information\n\n");
     printf("Examples:\n");
@@ -185,6 +197,7 @@ static bool parse_arguments(int argc, char* argv[], hpm_options_t* options) {
         {"registry", required_argument, 0, 1001},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 1002},
+        {"stats", optional_argument, 0, 1003},
         {0, 0, 0, 0}
     };
     
@@ -241,6 +254,10 @@ static bool parse_arguments(int argc, char* argv[], hpm_options_t* options) {
             case 1002: /* --version */
                 options->command = HPM_CMD_VERSION;
                 return true;
+            case 1003: /* --stats[=format] */
+                options->stats = true;
+                options->stats_format = optarg;
+                break;
             case '?':
                 return false;
             default:
@@ -362,19 +379,13 @@ static int execute_update(hpm_context_t* hpm, hpm_options_t* options) {
 }
 
 static int execute_list(hpm_context_t* hpm, hpm_options_t* options) {
+    (void)options;
     hyp_error_t result = hpm_list(hpm, false);
     if (result != HYP_OK) {
         fprintf(stderr, "Error: %s\n", hpm_get_error(hpm));
         return 1;
     }
     
-    if (package_count == 0) {
-        printf("No packages installed\n");
-    } else {
-        printf("Installed packages (%zu):\n", package_count);
-        /* TODO: Print package list */
-    }
-    
     return 0;
 }
 
@@ -390,7 +401,7 @@ static int execute_search(hpm_context_t* hpm, hpm_options_t* options) {
     if (result_count == 0) {
         printf("No packages found for '%s'\n", options->package_name);
     } else {
-        printf("Found %zu package(s) for '%s':\n", result_count, options->package_name);
+        printf("Found %d package(s) for '%s':\n", result_count, options->package_name);
         /* TODO: Print search results */
     }
     
@@ -433,16 +444,28 @@ static int execute_run(hpm_context_t* hpm, hpm_options_t* options) {
     return 0;
 }
 
+static hyp_metric_t metric_commands = HYP_COUNTER("hpm.commands", "Commands run");
+static hyp_metric_t metric_command = HYP_HISTOGRAM("hpm.command", "Time to run a command");
+static hyp_metric_t metric_failures = HYP_COUNTER("hpm.failures", "Commands that failed");
+
 /* Main entry point */
 int main(int argc, char* argv[]) {
     hpm_options_t options;
     
+    /* Pick the allocator ($HYP_ALLOCATOR) before anything is allocated */
+    hyp_mem_init();
+    
     /* Parse command-line arguments */
     if (!parse_arguments(argc, argv, &options)) {
         print_usage(argv[0]);
         return 1;
     }
     
+    if (options.stats && !hyp_metrics_report_at_exit(options.stats_format)) {
+        fprintf(stderr, "Error: Unknown stats format '%s'\n", options.stats_format);
+        return 1;
+    }
+    
     /* Handle special commands */
     if (options.command == HPM_CMD_HELP) {
         print_usage(argv[0]);
@@ -466,14 +489,13 @@ int main(int argc, char* argv[]) {
     hpm->config.offline_mode = options.offline;
     
     if (options.registry_url) {
-        if (hpm->config.registry_url) {
-            hyp_string_destroy(hpm->config.registry_url);
-        }
-        hpm->config.registry_url = hyp_string_create(options.registry_url);
+        HYP_FREE(hpm->config.registry_url);
+        hpm->config.registry_url = hyp_strdup(options.registry_url);
     }
     
     /* Execute command */
     int result = 0;
+    double started = hyp_wall_time();
     
     switch (options.command) {
         case HPM_CMD_INIT:
@@ -509,6 +531,10 @@ int main(int argc, char* argv[]) {
             break;
     }
     
+    hyp_metric_observe(&metric_command, hyp_wall_time() - started);
+    hyp_metric_add(&metric_commands, 1);
+    if (result != 0) hyp_metric_add(&metric_failures, 1);
+    
     /* Cleanup */
     if (options.package_name && options.version_spec) {
         HYP_FREE(options.package_name);
@@ -37,14 +37,12 @@ hpx_context_t* hpx_create(void) {
     hpx->config.always_spawn = false;
     hpx->config.quiet = false;
     hpx->config.yes = false;
+    hpx->config.offline = false;
+    hpx->config.auto_install = true;
     hpx->config.timeout_seconds = 300;
     
     /* Initialize history */
-    hpx->history.capacity = 32;
-    hpx->history.count = 0;
-    hpx->history.packages = HYP_MALLOC(sizeof(char*) * hpx->history.capacity);
-    hpx->history.commands = HYP_MALLOC(sizeof(char*) * hpx->history.capacity);
-    hpx->history.exit_codes = HYP_MALLOC(sizeof(int) * hpx->history.capacity);
+    HYP_DEQUE_INIT(&hpx->history);
     
     hpx->has_error = false;
     hpx->error_message[0] = '\0';
@@ -62,15 +60,8 @@ void hpx_destroy(hpx_context_t* hpx) {
     if (hpx->config.shell) HYP_FREE(hpx->config.shell);
     
     /* Cleanup history */
-    if (hpx->history.packages) {
-        for (size_t i = 0; i < hpx->history.count; i++) {
-            if (hpx->history.packages[i]) HYP_FREE(hpx->history.packages[i]);
-            if (hpx->history.commands[i]) HYP_FREE(hpx->history.commands[i]);
-        }
-        HYP_FREE(hpx->history.packages);
-        HYP_FREE(hpx->history.commands);
-        HYP_FREE(hpx->history.exit_codes);
-    }
+    hpx_clear_history(hpx);
+    HYP_DEQUE_FREE(&hpx->history);
     
     HYP_FREE(hpx);
 }
@@ -123,6 +114,7 @@ void hpx_package_spec_free(hpx_package_spec_t* spec) {
 /* Check if package is executable */
 bool hpx_is_executable(hpx_context_t* hpx, const char* package_name, hpx_package_info_t* info) {
     if (!hpx || !package_name) return false;
+    (void)info;
     
     /* TODO: Implement actual executable check */
     return true;
@@ -149,7 +141,7 @@ hyp_error_t hpx_get_package_info(hpx_context_t* hpx, const char* package_name, c
     info->is_binary = false;
     info->command_count = 0;
     
-    return HYP_ERROR_NONE;
+    return HYP_OK;
 }
 
 /* Initialize HPX context */
@@ -182,7 +174,7 @@ hyp_error_t hpx_init(hpx_context_t* hpx, const hpx_config_t* config) {
         }
     }
     
-    return HYP_ERROR_NONE;
+    return HYP_OK;
 }
 
 /* Resolve package path */
@@ -198,7 +190,7 @@ hyp_error_t hpx_resolve_package(hpx_context_t* hpx, const char* package_spec, ch
         strcpy(*resolved_path, "/path/to/package");
     }
     
-    return HYP_ERROR_NONE;
+    return HYP_OK;
 }
 
 /* Download package to temp */
@@ -208,18 +200,23 @@ hyp_error_t hpx_download_temp(hpx_context_t* hpx, const char* package_name, cons
         return HYP_ERROR_INVALID_ARG;
     }
     
+    (void)version;
+    
     /* TODO: Implement package download */
     *temp_path = HYP_MALLOC(256);
     if (*temp_path) {
         strcpy(*temp_path, "/path/to/downloaded/package");
     }
     
-    return HYP_ERROR_NONE;
+    return HYP_OK;
 }
 
 /* Execute local executable */
 hyp_error_t hpx_execute_local(hpx_context_t* hpx, const char* executable_path, char** args, size_t arg_count, const hpx_exec_options_t* options, hpx_exec_result_t* result) {
     if (!hpx || !executable_path || !result) return HYP_ERROR_INVALID_ARG;
+    (void)args;
+    (void)arg_count;
+    (void)options;
     
     /* TODO: Implement local execution */
     memset(result, 0, sizeof(hpx_exec_result_t));
@@ -230,12 +227,15 @@ hyp_error_t hpx_execute_local(hpx_context_t* hpx, const char* executable_path, c
         strcpy(result->stdout_output, "Execution completed successfully");
     }
     
-    return HYP_ERROR_NONE;
+    return HYP_OK;
 }
 
 /* Execute package */
 hyp_error_t hpx_execute(hpx_context_t* hpx, const char* package_name, char** args, size_t arg_count, const hpx_exec_options_t* options, hpx_exec_result_t* result) {
     if (!hpx || !package_name || !result) return HYP_ERROR_INVALID_ARG;
+    (void)args;
+    (void)arg_count;
+    (void)options;
     
     /* TODO: Implement package execution */
     memset(result, 0, sizeof(hpx_exec_result_t));
@@ -246,11 +246,11 @@ hyp_error_t hpx_execute(hpx_context_t* hpx, const char* package_name, char** arg
         strcpy(result->stdout_output, "Package executed successfully");
     }
     
-    return HYP_ERROR_NONE;
+    return HYP_OK;
 }
 
-/* Execute package */
-hyp_error_t hpx_execute_package(hpx_context_t* hpx, const char* package_spec, const hpx_exec_options_t* options, hpx_exec_result_t* result) {
+/* Execute a command of a package */
+hyp_error_t hpx_execute_command(hpx_context_t* hpx, const char* package_spec, const char* command, char** args, size_t arg_count, const hpx_exec_options_t* options, hpx_exec_result_t* result) {
     if (!hpx || !package_spec || !result) {
         if (hpx) hpx_error(hpx, "Invalid arguments");
         return HYP_ERROR_INVALID_ARG;
@@ -259,93 +259,87 @@ hyp_error_t hpx_execute_package(hpx_context_t* hpx, const char* package_spec, co
     memset(result, 0, sizeof(hpx_exec_result_t));
     
     /* Parse package specification */
-    hpx_package_spec_t parsed;
-    hyp_error_t parse_result = parse_package_spec(package_spec, &parsed);
-    if (parse_result != HYP_OK) {
+    hpx_package_spec_t parsed = hpx_parse_package_spec(package_spec);
+    if (!parsed.name) {
         hpx_error(hpx, "Failed to parse package specification");
-        return parse_result;
-    }
-    
-    /* Check if package is executable */
-    bool is_executable;
-    hyp_error_t check_result = hpx_is_executable(hpx, package_spec, &is_executable);
-    if (check_result != HYP_OK) {
-        free_package_spec(&parsed);
-        return check_result;
+        return HYP_ERROR_MEMORY;
     }
     
-    if (!is_executable) {
+    if (!hpx_is_executable(hpx, parsed.name, NULL)) {
         hpx_error(hpx, "Package is not executable");
-        free_package_spec(&parsed);
-        return HYP_ERROR_NOT_EXECUTABLE;
+        hpx_package_spec_free(&parsed);
+        return HYP_ERROR_RUNTIME;
     }
     
     /* Download package if needed */
-    hyp_string_t* package_path;
-    hyp_error_t download_result = hpx_download_package(hpx, package_spec, &package_path);
+    char* package_path = NULL;
+    hyp_error_t download_result = hpx_download_temp(hpx, parsed.name, parsed.version, &package_path);
     if (download_result != HYP_OK) {
-        free_package_spec(&parsed);
+        hpx_package_spec_free(&parsed);
         return download_result;
     }
     
     /* Execute package */
-    /* TODO: Implement hpx_execute_local_script function */
-    result->exit_code = 0;
-    result->stdout_output = NULL;
-    result->stderr_output = NULL;
-    result->execution_time = 0.0;
-    result->timed_out = false;
+    hyp_error_t exec_result = hpx_execute_local(hpx, package_path, args, arg_count, options, result);
     
     /* Add to execution history */
-    if (hpx->history.count < hpx->history.capacity) {
-        /* TODO: Implement proper history storage */
-        hpx->history.count++;
+    if (exec_result == HYP_OK) {
+        hpx_add_to_history(hpx, package_spec, command, result->exit_code);
     }
     
     /* Cleanup */
-    hyp_string_destroy(package_path);
-    free_package_spec(&parsed);
+    HYP_FREE(package_path);
+    hpx_package_spec_free(&parsed);
     
     return exec_result;
 }
 
+void hpx_exec_result_free(hpx_exec_result_t* result) {
+    if (!result) return;
+    
+    HYP_FREE(result->stdout_output);
+    HYP_FREE(result->stderr_output);
+    memset(result, 0, sizeof(hpx_exec_result_t));
+}
+
 /* List available commands */
-hyp_error_t hpx_list_commands(hpx_context_t* hpx, const char* package_spec, hyp_string_t*** commands, size_t* command_count) {
-    if (!hpx || !package_spec || !commands || !command_count) {
+hyp_error_t hpx_list_commands(hpx_context_t* hpx, const char* package_name, char*** commands, size_t* command_count) {
+    if (!hpx || !package_name || !commands || !command_count) {
         if (hpx) hpx_error(hpx, "Invalid arguments");
         return HYP_ERROR_INVALID_ARG;
     }
     
     /* TODO: Implement command listing */
-    *command_count = 2;
-    *commands = HYP_MALLOC(sizeof(hyp_string_t*) * 2);
+    static const char* const known[] = { "build", "start" };
+    size_t count = sizeof(known) / sizeof(known[0]);
+    *commands = HYP_MALLOC(sizeof(char*) * count);
     if (!*commands) {
         hpx_error(hpx, "Out of memory");
         return HYP_ERROR_MEMORY;
     }
     
-    (*commands)[0] = HYP_MALLOC(sizeof(hyp_string_t));
-    (*commands)[1] = HYP_MALLOC(sizeof(hyp_string_t));
-    if (!(*commands)[0] || !(*commands)[1]) {
-        if ((*commands)[0]) HYP_FREE((*commands)[0]);
-        if ((*commands)[1]) HYP_FREE((*commands)[1]);
-        HYP_FREE(*commands);
-        return HYP_ERROR_MEMORY;
+    for (size_t i = 0; i < count; i++) {
+        (*commands)[i] = hyp_strdup(known[i]);
+        if (!(*commands)[i]) {
+            while (i > 0) HYP_FREE((*commands)[--i]);
+            HYP_FREE(*commands);
+            hpx_error(hpx, "Out of memory");
+            return HYP_ERROR_MEMORY;
+        }
     }
-    *(*commands)[0] = hyp_string_create("build");
-    *(*commands)[1] = hyp_string_create("start");
+    *command_count = count;
     
     return HYP_OK;
 }
 
 /* Show help */
-hyp_error_t hpx_show_help(hpx_context_t* hpx, const char* package_spec) {
+hyp_error_t hpx_show_help(hpx_context_t* hpx, const char* package_name, const char* command) {
     if (!hpx) {
         return HYP_ERROR_INVALID_ARG;
     }
     
-    if (package_spec) {
-        printf("Help for package: %s\n", package_spec);
+    if (package_name) {
+        printf("Help for package: %s%s%s\n", package_name, command ? " " : "", command ? command : "");
         /* TODO: Show package-specific help */
     } else {
         printf("HPX - Hyper Package Executor\n");
@@ -360,7 +354,9 @@ hyp_error_t hpx_show_help(hpx_context_t* hpx, const char* package_spec) {
 }
 
 /* Create project from template */
-hyp_error_t hpx_create_project_from_template(hpx_context_t* hpx, const char* template_spec, const char* project_name, const char* target_dir) {
+hyp_error_t hpx_create_from_template(hpx_context_t* hpx, const char* template_spec, const char* project_name, const char* target_dir, char** options) {
+    (void)target_dir;
+    (void)options;
     if (!hpx || !template_spec || !project_name) {
         if (hpx) hpx_error(hpx, "Invalid arguments");
         return HYP_ERROR_INVALID_ARG;
@@ -395,6 +391,61 @@ hyp_error_t hpx_get_execution_history(hpx_context_t* hpx, hpx_exec_result_t** hi
     return HYP_OK;
 }
 
+/* Record a run, dropping the oldest once the history is full */
+hyp_error_t hpx_add_to_history(hpx_context_t* hpx, const char* package, const char* command, int exit_code) {
+    if (!hpx || !package) return HYP_ERROR_INVALID_ARG;
+    
+    hpx_history_entry_t entry;
+    entry.package = hyp_strdup(package);
+    entry.command = command ? hyp_strdup(command) : NULL;
+    entry.exit_code = exit_code;
+    if (!entry.package || (command && !entry.command)) {
+        HYP_FREE(entry.package);
+        HYP_FREE(entry.command);
+        return HYP_ERROR_MEMORY;
+    }
+    
+    if (hpx->history.count >= HPX_HISTORY_LIMIT) {
+        HYP_FREE(HYP_DEQUE_FRONT(&hpx->history).package);
+        HYP_FREE(HYP_DEQUE_FRONT(&hpx->history).command);
+        HYP_DEQUE_POP_FRONT(&hpx->history);
+    }
+    
+    size_t count = hpx->history.count;
+    HYP_DEQUE_PUSH_BACK(&hpx->history, entry);
+    if (hpx->history.count == count) {
+        HYP_FREE(entry.package);
+        HYP_FREE(entry.command);
+        return HYP_ERROR_MEMORY;
+    }
+    return HYP_OK;
+}
+
+/* Print the most recent runs, newest last; a limit of 0 shows them all */
+hyp_error_t hpx_show_history(hpx_context_t* hpx, size_t limit) {
+    if (!hpx) return HYP_ERROR_INVALID_ARG;
+    
+    size_t count = hpx->history.count;
+    size_t first = limit && limit < count ? count - limit : 0;
+    for (size_t i = first; i < count; i++) {
+        const hpx_history_entry_t* entry = &HYP_DEQUE_AT(&hpx->history, i);
+        printf("%zu  %s%s%s  (exit %d)\n", i + 1, entry->package,
+               entry->command ? " " : "", entry->command ? entry->command : "", entry->exit_code);
+    }
+    return HYP_OK;
+}
+
+hyp_error_t hpx_clear_history(hpx_context_t* hpx) {
+    if (!hpx) return HYP_ERROR_INVALID_ARG;
+    
+    while (hpx->history.count) {
+        HYP_FREE(HYP_DEQUE_FRONT(&hpx->history).package);
+        HYP_FREE(HYP_DEQUE_FRONT(&hpx->history).command);
+        HYP_DEQUE_POP_FRONT(&hpx->history);
+    }
+    return HYP_OK;
+}
+
 /* Add search path */
 hyp_error_t hpx_add_search_path(hpx_context_t* hpx, const char* path) {
     if (!hpx || !path) {
@@ -7,9 +7,31 @@
 
 #include "../../include/hpx.h"
 #include "../../include/hyp_common.h"
+#include "../../include/hyp_metrics.h"
+#include "../../include/hyp_thread.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+
+/* CLI options */
+typedef struct {
+    char* package_spec;
+    char* command;
+    char** args;
+    int arg_count;
+    bool verbose;
+    bool offline;
+    bool no_install;
+    bool clear_cache;
+    bool show_help;
+    bool show_version;
+    bool list_commands;
+    char* working_dir;
+    int timeout;
+    bool stats;
+    const char* stats_format;
+} hpx_options_t;
+
 #ifdef _WIN32
     // Windows doesn't have getopt.h, we'll use a simple alternative
     char* optarg = NULL;
@@ -42,6 +64,11 @@
                 options->no_install = true;
             } else if (strcmp(argv[i], "--clear-cache") == 0) {
                 options->clear_cache = true;
+            } else if (strcmp(argv[i], "--stats") == 0) {
+                options->stats = true;
+            } else if (strncmp(argv[i], "--stats=", 8) == 0) {
+                options->stats = true;
+                options->stats_format = argv[i] + 8;
             } else if (argv[i][0] != '-') {
                 if (!options->package_spec) {
                     options->package_spec = argv[i];
@@ -58,23 +85,6 @@
 
 #define HPX_VERSION "0.1.0"
 
-/* CLI options */
-typedef struct {
-    char* package_spec;
-    char* command;
-    char** args;
-    int arg_count;
-    bool verbose;
-    bool offline;
-    bool no_install;
-    bool clear_cache;
-    bool show_help;
-    bool show_version;
-    bool list_commands;
-    char* working_dir;
-    int timeout;
-} hpx_options_t;
-
 /* Print usage information */
 static void print_usage(const char* program_name) {
     printf("Hyper Programming Language Package Executor (hpx) v%s\n\n", HPX_VERSION);
@@ -94,6 +104,7 @@ static void print_usage(const char* program_name) {
     printf("  -l, --list-commands     List available commands for package\n");
     printf("  -C, --directory <dir>   Change to directory before execution\n");
     printf("  -t, --timeout <sec>     Set execution timeout in seconds\n");
+    printf("      --stats[=json]      Print metrics to stderr on exit\n");
     printf("  -h, --help              Show this help message\n");
     printf("      --version           Show version information\n\n");
     printf("Examples:\n");
@@ -127,6 +138,7 @@ static bool parse_arguments(int argc, char* argv[], hpx_options_t* options) {
         {"timeout", required_argument, 0, 't'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 1003},
+        {"stats", optional_argument, 0, 1004},
         {0, 0, 0, 0}
     };
     
@@ -175,6 +187,10 @@ static bool parse_arguments(int argc, char* argv[], hpx_options_t* options) {
             case 1003: /* --version */
                 options->show_version = true;
                 return true;
+            case 1004: /* --stats[=format] */
+                options->stats = true;
+                options->stats_format = optarg;
+                break;
             case '?':
                 return false;
             default:
@@ -231,7 +247,7 @@ static int execute_list_commands(hpx_context_t* hpx, hpx_options_t* options) {
         printf("Listing commands for package: %s\n", options->package_spec);
     }
     
-    hyp_string_t** commands;
+    char** commands;
     size_t command_count;
     
     hyp_error_t result = hpx_list_commands(hpx, options->package_spec, &commands, &command_count);
@@ -245,11 +261,11 @@ static int execute_list_commands(hpx_context_t* hpx, hpx_options_t* options) {
     } else {
         printf("Available commands for '%s':\n", options->package_spec);
         for (size_t i = 0; i < command_count; i++) {
-            printf("  %s\n", commands[i]->data);
-            hyp_string_destroy(commands[i]);
+            printf("  %s\n", commands[i]);
+            HYP_FREE(commands[i]);
         }
-        HYP_FREE(commands);
     }
+    HYP_FREE(commands);
     
     return 0;
 }
@@ -262,14 +278,7 @@ static int execute_package(hpx_context_t* hpx, hpx_options_t* options) {
     }
     
     /* Check if package is executable */
-    bool is_executable;
-    hyp_error_t check_result = hpx_is_executable(hpx, options->package_spec, &is_executable);
-    if (check_result != HYP_OK) {
-        fprintf(stderr, "Error: %s\n", hpx_get_error(hpx));
-        return 1;
-    }
-    
-    if (!is_executable) {
+    if (!hpx_is_executable(hpx, options->package_spec, NULL)) {
         fprintf(stderr, "Error: Package '%s' is not executable\n", options->package_spec);
         return 1;
     }
@@ -278,13 +287,10 @@ static int execute_package(hpx_context_t* hpx, hpx_options_t* options) {
     hpx_exec_options_t exec_options;
     memset(&exec_options, 0, sizeof(hpx_exec_options_t));
     
-    exec_options.command = options->command;
-    exec_options.args = options->args;
-    exec_options.arg_count = options->arg_count;
-    exec_options.working_directory = options->working_dir;
-    exec_options.timeout_seconds = options->timeout;
+    exec_options.working_dir = options->working_dir;
+    exec_options.timeout = options->timeout;
     exec_options.capture_output = true;
-    exec_options.inherit_environment = true;
+    exec_options.inherit_env = true;
     
     if (options->verbose) {
         printf("Executing package: %s\n", options->package_spec);
@@ -302,7 +308,8 @@ static int execute_package(hpx_context_t* hpx, hpx_options_t* options) {
     
     /* Execute package */
     hpx_exec_result_t result;
-    hyp_error_t exec_result = hpx_execute_package(hpx, options->package_spec, &exec_options, &result);
+    hyp_error_t exec_result = hpx_execute_command(hpx, options->package_spec, options->command,
+                                                  options->args, (size_t)options->arg_count, &exec_options, &result);
     
     if (exec_result != HYP_OK) {
         fprintf(stderr, "Error: %s\n", hpx_get_error(hpx));
@@ -310,26 +317,22 @@ static int execute_package(hpx_context_t* hpx, hpx_options_t* options) {
     }
     
     /* Print output */
-    if (result.output && result.output->data) {
-        printf("%s", result.output->data);
+    if (result.stdout_output) {
+        printf("%s", result.stdout_output);
     }
     
-    if (result.error_message && result.error_message->data) {
-        fprintf(stderr, "%s", result.error_message->data);
+    if (result.stderr_output) {
+        fprintf(stderr, "%s", result.stderr_output);
     }
     
     if (options->verbose) {
-        printf("\nExecution completed in %lu ms\n", result.execution_time_ms);
+        printf("\nExecution completed in %.0f ms\n", result.execution_time * 1000.0);
         printf("Exit code: %d\n", result.exit_code);
     }
     
-    /* Cleanup result */
-    if (result.package_spec) hyp_string_destroy(result.package_spec);
-    if (result.command) hyp_string_destroy(result.command);
-    if (result.output) hyp_string_destroy(result.output);
-    if (result.error_message) hyp_string_destroy(result.error_message);
-    
-    return result.exit_code;
+    int exit_code = result.exit_code;
+    hpx_exec_result_free(&result);
+    return exit_code;
 }
 
 /* Check if package spec looks like a template */
@@ -374,7 +377,7 @@ static int execute_template(hpx_context_t* hpx, hpx_options_t* options) {
         printf("Target directory: %s\n", target_dir);
     }
     
-    hyp_error_t result = hpx_create_project_from_template(hpx, options->package_spec, project_name, target_dir);
+    hyp_error_t result = hpx_create_from_template(hpx, options->package_spec, project_name, target_dir, NULL);
     if (result != HYP_OK) {
         fprintf(stderr, "Error: %s\n", hpx_get_error(hpx));
         return 1;
@@ -384,16 +387,28 @@ static int execute_template(hpx_context_t* hpx, hpx_options_t* options) {
     return 0;
 }
 
+static hyp_metric_t metric_commands = HYP_COUNTER("hpx.commands", "Commands run");
+static hyp_metric_t metric_command = HYP_HISTOGRAM("hpx.command", "Time to run a command");
+static hyp_metric_t metric_failures = HYP_COUNTER("hpx.failures", "Commands that failed");
+
 /* Main entry point */
 int main(int argc, char* argv[]) {
     hpx_options_t options;
     
+    /* Pick the allocator ($HYP_ALLOCATOR) before anything is allocated */
+    hyp_mem_init();
+    
     /* Parse command-line arguments */
     if (!parse_arguments(argc, argv, &options)) {
         print_usage(argv[0]);
         return 1;
     }
     
+    if (options.stats && !hyp_metrics_report_at_exit(options.stats_format)) {
+        fprintf(stderr, "Error: Unknown stats format '%s'\n", options.stats_format);
+        return 1;
+    }
+    
     /* Handle special commands */
     if (options.show_help) {
         print_usage(argv[0]);
@@ -413,13 +428,13 @@ int main(int argc, char* argv[]) {
     }
     
     /* Configure HPX */
-    hpx->config.verbose = options.verbose;
-    hpx->config.offline_mode = options.offline;
+    hpx->config.offline = options.offline;
     hpx->config.auto_install = !options.no_install;
     hpx->config.timeout_seconds = options.timeout;
     
     /* Execute command */
     int result = 0;
+    double started = hyp_wall_time();
     
     if (options.clear_cache) {
         result = execute_clear_cache(hpx, &options);
@@ -431,6 +446,10 @@ int main(int argc, char* argv[]) {
         result = execute_package(hpx, &options);
     }
     
+    hyp_metric_observe(&metric_command, hyp_wall_time() - started);
+    hyp_metric_add(&metric_commands, 1);
+    if (result != 0) hyp_metric_add(&metric_failures, 1);
+    
     /* Cleanup */
     hpx_destroy(hpx);
     return result;
@@ -7,11 +7,20 @@
 
 #include "../../include/lexer.h"
 #include "../../include/parser.h"
+#include "../../include/ast_cache.h"
 #include "../../include/transpiler.h"
 #include "../../include/hyp_common.h"
+#include "../../include/hyp_number.h"
+#include "../../include/aot.h"
+#include "../../include/profile.h"
+#include "../../include/hyp_thread.h"
+#include "../../include/hyp_metrics.h"
+#include "../../include/build.h"
+#include "../../include/server.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #ifdef _WIN32
     // Windows doesn't have getopt.h, we'll use a simple alternative
     char* optarg = NULL;
@@ -40,6 +49,8 @@ typedef struct {
     char* input_file;
     char* output_file;
     hyp_target_t target;
+    bool target_set;
+    bool build;
     bool verbose;
     bool debug;
     bool optimize;
@@ -47,8 +58,53 @@ typedef struct {
     bool show_version;
     bool show_ast;
     bool show_tokens;
+    bool native;
+    bool force;
+    bool server;
+    bool client;
+    bool server_stats;
+    bool server_stop;
+    bool stream;
+    bool lex_bench;
+    bool parse_bench;
+    bool ast_bench;
+    bool edit_bench;
+    bool number_bench;
+    char* socket_path;
+    size_t server_memory;
+    char* artifact_cache;
+    char* cc;
+    char* cflags;
+    char* profile_file;
+    size_t jobs;
+    bool stats;
+    char* stats_format;          /* --stats=<format>; NULL for text */
 } hypc_options_t;
 
+/* Parse a --server-memory value in megabytes */
+static bool parse_megabytes(const char* value, size_t* bytes) {
+    char* end;
+    unsigned long megabytes = strtoul(value, &end, 10);
+    if (end == value || *end != '\0' || megabytes == 0) {
+        fprintf(stderr, "Error: Invalid memory size '%s'\n", value);
+        return false;
+    }
+    *bytes = (size_t)megabytes * 1024 * 1024;
+    return true;
+}
+
+/* Parse a -j value; 0 means one thread per processor */
+static bool parse_jobs(const char* value, size_t* jobs) {
+    char* end;
+    unsigned long count = strtoul(value, &end, 10);
+    if (end == value || *end != '\0') {
+        fprintf(stderr, "Error: Invalid job count '%s'\n", value);
+        return false;
+    }
+    *jobs = hyp_worker_count((size_t)count);
+    return true;
+}
+
 #ifdef _WIN32
 /* Simple argument parsing for Windows */
 static bool parse_args_win32(int argc, char* argv[], hypc_options_t* options) {
@@ -69,10 +125,54 @@ static bool parse_args_win32(int argc, char* argv[], hypc_options_t* options) {
             options->show_ast = true;
         } else if (strcmp(argv[i], "--show-tokens") == 0) {
             options->show_tokens = true;
+        } else if (strcmp(argv[i], "--native") == 0) {
+            options->native = true;
+        } else if (strcmp(argv[i], "--force") == 0) {
+            options->force = true;
+        } else if (strcmp(argv[i], "--server") == 0) {
+            options->server = true;
+        } else if (strcmp(argv[i], "--client") == 0) {
+            options->client = true;
+        } else if (strcmp(argv[i], "--server-stats") == 0) {
+            options->server_stats = true;
+        } else if (strcmp(argv[i], "--server-stop") == 0) {
+            options->server_stop = true;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            options->stream = true;
+        } else if (strcmp(argv[i], "--lex-bench") == 0) {
+            options->lex_bench = true;
+        } else if (strcmp(argv[i], "--parse-bench") == 0) {
+            options->parse_bench = true;
+        } else if (strcmp(argv[i], "--ast-bench") == 0) {
+            options->ast_bench = true;
+        } else if (strcmp(argv[i], "--edit-bench") == 0) {
+            options->edit_bench = true;
+        } else if (strcmp(argv[i], "--number-bench") == 0) {
+            options->number_bench = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            options->stats = true;
+        } else if (strncmp(argv[i], "--stats=", 8) == 0) {
+            options->stats = true;
+            options->stats_format = argv[i] + 8;
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            options->socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--server-memory") == 0 && i + 1 < argc) {
+            if (!parse_megabytes(argv[++i], &options->server_memory)) return 0;
+        } else if (strcmp(argv[i], "--artifact-cache") == 0 && i + 1 < argc) {
+            options->artifact_cache = argv[++i];
+        } else if (strcmp(argv[i], "--cc") == 0 && i + 1 < argc) {
+            options->cc = argv[++i];
+        } else if (strcmp(argv[i], "--cflags") == 0 && i + 1 < argc) {
+            options->cflags = argv[++i];
+        } else if (strncmp(argv[i], "--use-profile=", 14) == 0) {
+            options->profile_file = argv[i] + 14;
+        } else if ((strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) && i + 1 < argc) {
+            if (!parse_jobs(argv[++i], &options->jobs)) return 0;
         } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
             options->output_file = argv[++i];
         } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
             i++;
+            options->target_set = true;
             if (strcmp(argv[i], "c") == 0) {
                 options->target = TARGET_C;
             } else if (strcmp(argv[i], "js") == 0) {
@@ -83,6 +183,8 @@ static bool parse_args_win32(int argc, char* argv[], hypc_options_t* options) {
                 fprintf(stderr, "Error: Unknown target '%s'\n", argv[i]);
                 return 0;
             }
+        } else if (strcmp(argv[i], "build") == 0 && !options->build && !options->input_file) {
+            options->build = true;
         } else if (argv[i][0] != '-') {
             options->input_file = argv[i];
         }
@@ -94,15 +196,45 @@ static bool parse_args_win32(int argc, char* argv[], hypc_options_t* options) {
 /* Print usage information */
 static void print_usage(const char* program_name) {
     printf("Hyper Programming Language Compiler (hypc) v%s\n\n", HYPC_VERSION);
-    printf("Usage: %s [options] <input-file>\n\n", program_name);
+    printf("Usage: %s [options] <input-file>\n", program_name);
+    printf("       %s build [options] [project-dir]\n\n", program_name);
     printf("Options:\n");
     printf("  -o, --output <file>     Output file (default: auto-generated)\n");
     printf("  -t, --target <target>   Target language (c, js, bytecode, asm, llvm)\n");
     printf("  -O, --optimize          Enable optimizations\n");
     printf("  -v, --verbose           Verbose output\n");
     printf("  -d, --debug             Debug mode\n");
+    printf("  -j, --jobs <n>          Parse and generate code on n threads (0: one per processor)\n");
     printf("      --show-ast          Print AST and exit\n");
     printf("      --show-tokens       Print tokens and exit\n");
+    printf("      --lex-bench         Measure tokenization throughput and exit\n");
+    printf("      --parse-bench       Measure parsing throughput, also on -j threads, and C\n");
+    printf("                          generation over the tree, and exit\n");
+    printf("      --ast-bench         Compare loading cached syntax trees of the file and its\n");
+    printf("                          imports with parsing them, and exit\n");
+    printf("      --edit-bench        Measure updating the syntax tree after small edits\n");
+    printf("                          against parsing again, and exit\n");
+    printf("      --number-bench      Measure number parsing and formatting throughput and exit\n");
+    printf("      --native            Build a native executable via the C target\n");
+    printf("      --stream            Compile one top-level declaration at a time to bound\n");
+    printf("                          memory on huge generated sources (C target)\n");
+    printf("      --force             Rebuild everything, ignoring build, AOT and AST caches\n");
+    printf("      --server            Run a compiler server that keeps parsed modules in memory\n");
+    printf("      --client            Compile through a running server\n");
+    printf("      --socket <path>     Server socket (default: $HYP_SERVER_SOCKET or %s)\n", HYP_SERVER_DEFAULT_SOCKET);
+    printf("      --server-memory <mb>\n");
+    printf("                          Bound on the server's module cache (default: %zu)\n",
+           HYP_SERVER_DEFAULT_MEMORY / (1024 * 1024));
+    printf("      --server-stats      Print the server's cache statistics\n");
+    printf("      --server-stop       Shut the server down\n");
+    printf("      --artifact-cache <dir|url>\n");
+    printf("                          Share build outputs through a directory or HTTP server\n");
+    printf("                          (default: $%s or build.cache; \"\" disables)\n", HYP_ARTIFACT_ENV);
+    printf("      --cc <compiler>     C compiler for --native (default: $HYP_CC or cc)\n");
+    printf("      --cflags <flags>    C compiler flags for --native (default: $HYP_CFLAGS or -O2)\n");
+    printf("      --use-profile=<file>\n");
+    printf("                          Guide -O with a profile from hyprun --write-profile\n");
+    printf("      --stats[=json]      Print lexer, parser and codegen metrics to stderr on exit\n");
     printf("  -h, --help              Show this help message\n");
     printf("      --version           Show version information\n\n");
     printf("Targets:\n");
@@ -111,10 +243,24 @@ static void print_usage(const char* program_name) {
     printf("  bytecode                Compile to bytecode\n");
     printf("  asm, assembly           Compile to assembly\n");
     printf("  llvm                    Generate LLVM IR\n\n");
+    printf("Environment:\n");
+    printf("  %-23s Allocator: libc (default), slab, tracking or debug\n", HYP_ALLOCATOR_ENV);
+    printf("  %-23s If set, print memory use by subsystem at exit\n", HYP_MEM_REPORT_ENV);
+    printf("  %-23s Parsed-module cache (default: $XDG_CACHE_HOME/hyper/%s or\n", HYP_AST_CACHE_ENV,
+           HYP_AST_CACHE_NAME);
+    printf("  %-23s ~/.cache/hyper/%s; \"\" disables)\n", "", HYP_AST_CACHE_NAME);
+    printf("  %-23s Native binary cache (default: $XDG_CACHE_HOME/hyper/%s or\n", "HYP_CACHE_DIR",
+           HYP_AOT_CACHE_NAME);
+    printf("  %-23s ~/.cache/hyper/%s)\n\n", "", HYP_AOT_CACHE_NAME);
     printf("Examples:\n");
     printf("  %s build src/main.hxp\n", program_name);
+    printf("  %s build -j 8 my-project\n", program_name);
     printf("  %s transpile src/app.hxp --target js -o app.js\n", program_name);
     printf("  %s --show-ast src/test.hxp\n", program_name);
+    printf("  %s --native src/main.hxp -o app\n", program_name);
+    printf("  %s -O --use-profile=app.hprof --native src/main.hxp -o app\n", program_name);
+    printf("  %s --server &\n", program_name);
+    printf("  %s --client src/main.hxp -o main.c\n", program_name);
 }
 
 /* Print version information */
@@ -191,10 +337,30 @@ static bool parse_arguments(int argc, char* argv[], hypc_options_t* options) {
         {"optimize", no_argument, 0, 'O'},
         {"verbose", no_argument, 0, 'v'},
         {"debug", no_argument, 0, 'd'},
+        {"jobs", required_argument, 0, 'j'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 1000},
         {"show-ast", no_argument, 0, 1001},
         {"show-tokens", no_argument, 0, 1002},
+        {"native", no_argument, 0, 1003},
+        {"cc", required_argument, 0, 1004},
+        {"cflags", required_argument, 0, 1005},
+        {"use-profile", required_argument, 0, 1006},
+        {"force", no_argument, 0, 1007},
+        {"server", no_argument, 0, 1008},
+        {"client", no_argument, 0, 1009},
+        {"socket", required_argument, 0, 1010},
+        {"server-memory", required_argument, 0, 1011},
+        {"server-stats", no_argument, 0, 1012},
+        {"server-stop", no_argument, 0, 1013},
+        {"artifact-cache", required_argument, 0, 1014},
+        {"stream", no_argument, 0, 1015},
+        {"lex-bench", no_argument, 0, 1016},
+        {"number-bench", no_argument, 0, 1017},
+        {"parse-bench", no_argument, 0, 1018},
+        {"ast-bench", no_argument, 0, 1019},
+        {"edit-bench", no_argument, 0, 1020},
+        {"stats", optional_argument, 0, 1021},
         {0, 0, 0, 0}
     };
     
@@ -210,13 +376,14 @@ static bool parse_arguments(int argc, char* argv[], hypc_options_t* options) {
     int c;
     int option_index = 0;
     
-    while ((c = getopt_long(argc, argv, "o:t:Ovdh", long_options, &option_index)) != -1) {
+    while ((c = getopt_long(argc, argv, "o:t:Ovdj:h", long_options, &option_index)) != -1) {
         switch (c) {
             case 'o':
                 options->output_file = optarg;
                 break;
             case 't':
                 options->target = parse_target(optarg);
+                options->target_set = true;
                 break;
             case 'O':
                 options->optimize = true;
@@ -227,6 +394,9 @@ static bool parse_arguments(int argc, char* argv[], hypc_options_t* options) {
             case 'd':
                 options->debug = true;
                 break;
+            case 'j':
+                if (!parse_jobs(optarg, &options->jobs)) return false;
+                break;
             case 'h':
                 options->show_help = true;
                 return true;
@@ -239,6 +409,64 @@ static bool parse_arguments(int argc, char* argv[], hypc_options_t* options) {
             case 1002: /* --show-tokens */
                 options->show_tokens = true;
                 break;
+            case 1003: /* --native */
+                options->native = true;
+                break;
+            case 1004: /* --cc */
+                options->cc = optarg;
+                break;
+            case 1005: /* --cflags */
+                options->cflags = optarg;
+                break;
+            case 1006: /* --use-profile */
+                options->profile_file = optarg;
+                break;
+            case 1007: /* --force */
+                options->force = true;
+                break;
+            case 1008: /* --server */
+                options->server = true;
+                break;
+            case 1009: /* --client */
+                options->client = true;
+                break;
+            case 1010: /* --socket */
+                options->socket_path = optarg;
+                break;
+            case 1011: /* --server-memory */
+                if (!parse_megabytes(optarg, &options->server_memory)) return false;
+                break;
+            case 1012: /* --server-stats */
+                options->server_stats = true;
+                break;
+            case 1013: /* --server-stop */
+                options->server_stop = true;
+                break;
+            case 1014: /* --artifact-cache */
+                options->artifact_cache = optarg;
+                break;
+            case 1015: /* --stream */
+                options->stream = true;
+                break;
+            case 1016: /* --lex-bench */
+                options->lex_bench = true;
+                break;
+            case 1017: /* --number-bench */
+                options->number_bench = true;
+                break;
+            case 1018: /* --parse-bench */
+                options->parse_bench = true;
+                break;
+            case 1019: /* --ast-bench */
+                options->ast_bench = true;
+                break;
+            case 1020: /* --edit-bench */
+                options->edit_bench = true;
+                break;
+            case 1021: /* --stats[=format] */
+                options->stats = true;
+                options->stats_format = optarg;
+                break;
             case '?':
                 return false;
             default:
@@ -246,17 +474,65 @@ static bool parse_arguments(int argc, char* argv[], hypc_options_t* options) {
         }
     }
     
-    /* Get input file */
+    /* Get input file (or project, after "build") */
+    if (optind < argc && strcmp(argv[optind], "build") == 0) {
+        options->build = true;
+        optind++;
+    }
     if (optind < argc) {
         options->input_file = argv[optind];
-    } else if (!options->show_help && !options->show_version) {
+    } else if (!options->show_help && !options->show_version && !options->build &&
+               !options->server && !options->server_stats && !options->server_stop &&
+               !options->number_bench) {
         fprintf(stderr, "Error: No input file specified\n");
         return false;
     }
 #endif
     
-    /* Validate input file for both platforms */
-    if (!options->input_file && !options->show_help && !options->show_version) {
+    /* Profiles only guide the optimizer */
+    if (options->profile_file && !options->optimize) {
+        fprintf(stderr, "Warning: --use-profile has no effect without -O\n");
+        options->profile_file = NULL;
+    }
+    
+    /* Streaming never holds the whole program, which only the C target
+     * can generate piecewise and a profile would need to bind to; native
+     * builds go through the AOT cache, which keys on the whole program */
+    if (options->stream) {
+        if (options->target != TARGET_C) {
+            fprintf(stderr, "Error: --stream only supports the C target\n");
+            return false;
+        }
+        if (options->native) {
+            fprintf(stderr, "Error: --stream cannot be combined with --native\n");
+            return false;
+        }
+        if (options->profile_file) {
+            fprintf(stderr, "Warning: --use-profile is ignored with --stream\n");
+            options->profile_file = NULL;
+        }
+    }
+    
+    /* "hypc build" takes a project (default: the current directory);
+     * "hypc build file.hxp" compiles a single file as before */
+    if (options->build) {
+        if (!options->input_file) {
+            options->input_file = ".";
+        } else {
+            size_t length = strlen(options->input_file);
+            size_t extension = strlen(HYP_BUILD_SOURCE_EXTENSION);
+            if (length > extension &&
+                strcmp(options->input_file + length - extension, HYP_BUILD_SOURCE_EXTENSION) == 0) {
+                options->build = false;
+            }
+        }
+    }
+    
+    /* Validate input file for both platforms; server commands and the
+     * number benchmark take none */
+    if (!options->input_file && !options->show_help && !options->show_version &&
+        !options->server && !options->server_stats && !options->server_stop &&
+        !options->number_bench) {
         fprintf(stderr, "Error: No input file specified\n");
         return false;
     }
@@ -276,14 +552,18 @@ static void print_ast_node(hyp_ast_node_t* node, int indent) {
         case AST_BLOCK_STMT:
             printf("Block\n");
             for (size_t i = 0; i < node->block_stmt.statements.count; i++) {
-                print_ast_node(node->block_stmt.statements.data[i], indent + 1);
+                print_ast_node(HYP_AST_AT(node, block_stmt.statements, i), indent + 1);
             }
             break;
         case AST_NUMBER:
-            printf("Number: %.17g\n", node->number.value);
+            {
+                char number[HYP_NUMBER_BUFFER_SIZE];
+                hyp_number_format(node->number.value, number);
+                printf("Number: %s\n", number);
+            }
             break;
         case AST_STRING:
-            printf("String: \"%s\"\n", node->string.value ? node->string.value : "");
+            printf("String: \"%s\"\n", HYP_AST_TEXT(node, string.value) ? HYP_AST_TEXT(node, string.value) : "");
             break;
         case AST_BOOLEAN:
             printf("Boolean: %s\n", node->boolean.value ? "true" : "false");
@@ -292,23 +572,23 @@ static void print_ast_node(hyp_ast_node_t* node, int indent) {
             printf("Null\n");
             break;
         case AST_IDENTIFIER:
-            printf("Identifier: %s\n", node->identifier.name ? node->identifier.name : "<unknown>");
+            printf("Identifier: %s\n", HYP_AST_TEXT(node, identifier.name) ? HYP_AST_TEXT(node, identifier.name) : "<unknown>");
             break;
         case AST_BINARY_OP:
             printf("Binary: %d\n", node->binary_op.op);
-            print_ast_node(node->binary_op.left, indent + 1);
-            print_ast_node(node->binary_op.right, indent + 1);
+            print_ast_node(HYP_AST_CHILD(node, binary_op.left), indent + 1);
+            print_ast_node(HYP_AST_CHILD(node, binary_op.right), indent + 1);
             break;
         case AST_FUNCTION_DECL:
-            printf("Function: %s\n", node->function_decl.name ? node->function_decl.name : "<anonymous>");
-            print_ast_node(node->function_decl.body, indent + 1);
+            printf("Function: %s\n", HYP_AST_TEXT(node, function_decl.name) ? HYP_AST_TEXT(node, function_decl.name) : "<anonymous>");
+            print_ast_node(HYP_AST_CHILD(node, function_decl.body), indent + 1);
             break;
         case AST_VARIABLE_DECL:
             printf("VarDecl: %s (%s)\n", 
-                   node->variable_decl.name ? node->variable_decl.name : "<unknown>",
+                   HYP_AST_TEXT(node, variable_decl.name) ? HYP_AST_TEXT(node, variable_decl.name) : "<unknown>",
                    node->variable_decl.is_const ? "const" : "let");
-            if (node->variable_decl.initializer) {
-                print_ast_node(node->variable_decl.initializer, indent + 1);
+            if (HYP_AST_CHILD(node, variable_decl.initializer)) {
+                print_ast_node(HYP_AST_CHILD(node, variable_decl.initializer), indent + 1);
             }
             break;
         default:
@@ -317,6 +597,653 @@ static void print_ast_node(hyp_ast_node_t* node, int indent) {
     }
 }
 
+/* Tokenize a source repeatedly and report the lexer's throughput, on
+ * average and for the fastest pass (the least disturbed by other load) */
+static int bench_lexer(hypc_options_t* options, hyp_lexer_t* lexer, const char* source, size_t size) {
+    /* Enough passes for about 256 MB, but at least three */
+    size_t passes = size ? (256u * 1024 * 1024) / size : 3;
+    if (passes < 3) passes = 3;
+    
+    size_t tokens = 0;
+    double elapsed = 0.0;
+    double best = 0.0;
+    for (size_t pass = 0; pass < passes; pass++) {
+        double started = hyp_wall_time();
+        hyp_lexer_reset(lexer, source, size, 1);
+        hyp_token_t token;
+        do {
+            token = hyp_lexer_next_token(lexer);
+            tokens++;
+        } while (token.type != TOKEN_EOF && token.type != TOKEN_ERROR);
+        double time = hyp_wall_time() - started;
+        
+        if (token.type == TOKEN_ERROR) {
+            fprintf(stderr, "Error: %.*s at line %zu, column %zu\n",
+                    (int)token.lexeme.length, token.lexeme.data, token.line, token.column);
+            return 1;
+        }
+        elapsed += time;
+        if (pass == 0 || time < best) best = time;
+    }
+    
+    double megabytes = (double)size / (1024.0 * 1024.0);
+    printf("Lexed %s: %zu bytes, %zu tokens, %zu passes in %.3f s\n",
+           options->input_file, size, tokens / passes, passes, elapsed);
+    if (elapsed > 0.0 && best > 0.0) {
+        printf("%.1f MB/s, %.1f M tokens/s (best pass: %.1f MB/s)\n",
+               megabytes * (double)passes / elapsed, (double)tokens / 1e6 / elapsed, megabytes / best);
+    }
+    return 0;
+}
+
+/* Parse the source repeatedly, tokenizing included, and report the
+ * throughput; expression-dense files exercise the precedence climber */
+/* Time parsing on options->jobs threads against the serial passes just
+ * made, whose tree the parser still holds; both trees must match */
+static int bench_parser_parallel(hypc_options_t* options, hyp_parser_t* parser, hyp_lexer_t* lexer,
+                                 const char* source, size_t size, size_t passes, double serial_best) {
+    size_t tree_size = parser->tree_size;
+    void* serial_tree = HYP_MALLOC(tree_size);
+    if (!serial_tree) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+    memcpy(serial_tree, parser->slots, tree_size);
+    
+    parser->jobs = options->jobs;
+    double elapsed = 0.0;
+    double best = 0.0;
+    for (size_t pass = 0; pass < passes; pass++) {
+        double started = hyp_wall_time();
+        hyp_lexer_reset(lexer, source, size, 1);
+        hyp_parser_reset(parser, lexer);
+        hyp_ast_node_t* ast = hyp_parser_parse(parser);
+        double time = hyp_wall_time() - started;
+        
+        if (!ast || parser->had_error) {
+            fprintf(stderr, "Error: Parsing failed\n");
+            HYP_FREE(serial_tree);
+            return 1;
+        }
+        elapsed += time;
+        if (pass == 0 || time < best) best = time;
+    }
+    parser->jobs = 0;
+    
+    bool same = parser->tree_size == tree_size && memcmp(serial_tree, parser->slots, tree_size) == 0;
+    HYP_FREE(serial_tree);
+    
+    double megabytes = (double)size / (1024.0 * 1024.0);
+    printf("%zu threads: %.1f MB/s (best pass: %.1f MB/s), %.2fx the serial best pass\n",
+           options->jobs, elapsed > 0.0 ? megabytes * (double)passes / elapsed : 0.0,
+           best > 0.0 ? megabytes / best : 0.0, best > 0.0 ? serial_best / best : 0.0);
+    if (!same) {
+        fprintf(stderr, "Error: Parallel parse built a different tree\n");
+        return 1;
+    }
+    return 0;
+}
+
+/* Generate C from the tree repeatedly, in memory; code generation visits
+ * every node, so this times a full traversal of the tree layout */
+static void bench_traversal(hyp_ast_node_t* ast, size_t passes) {
+    hyp_codegen_options_t codegen_opts = { .target = TARGET_C };
+    size_t output_size = 0;
+    double elapsed = 0.0;
+    double best = 0.0;
+    for (size_t pass = 0; pass < passes; pass++) {
+        hyp_codegen_t codegen;
+        if (hyp_codegen_init(&codegen, &codegen_opts, NULL) != HYP_OK) {
+            printf("Codegen: could not initialize the code generator\n");
+            return;
+        }
+        double started = hyp_wall_time();
+        hyp_error_t result = hyp_codegen_generate(&codegen, ast);
+        double time = hyp_wall_time() - started;
+        output_size = hyp_codegen_get_output_length(&codegen);
+        if (result != HYP_OK) {
+            printf("Codegen: skipped (%s)\n", codegen.error_message);
+            hyp_codegen_destroy(&codegen);
+            return;
+        }
+        hyp_codegen_destroy(&codegen);
+        elapsed += time;
+        if (pass == 0 || time < best) best = time;
+    }
+    
+    printf("Codegen (C): %zu bytes, %.3f ms per pass (best pass: %.3f ms)\n",
+           output_size, elapsed * 1000.0 / (double)passes, best * 1000.0);
+}
+
+static int bench_parser(hypc_options_t* options, hyp_parser_t* parser, hyp_lexer_t* lexer,
+                        const char* source, size_t size) {
+    /* Enough passes for about 64 MB, but at least three */
+    size_t passes = size ? (64u * 1024 * 1024) / size : 3;
+    if (passes < 3) passes = 3;
+    
+    size_t tokens = 0;
+    size_t tree_size = 0;
+    double elapsed = 0.0;
+    double best = 0.0;
+    hyp_ast_node_t* ast = NULL;
+    for (size_t pass = 0; pass < passes; pass++) {
+        double started = hyp_wall_time();
+        hyp_lexer_reset(lexer, source, size, 1);
+        hyp_parser_reset(parser, lexer);
+        ast = hyp_parser_parse(parser);
+        double time = hyp_wall_time() - started;
+        
+        if (!ast || parser->had_error) {
+            fprintf(stderr, "Error: Parsing failed\n");
+            return 1;
+        }
+        tokens = lexer->tokens.count;
+        tree_size = parser->tree_size;
+        elapsed += time;
+        if (pass == 0 || time < best) best = time;
+    }
+    
+    double megabytes = (double)size / (1024.0 * 1024.0);
+    printf("Parsed %s: %zu bytes, %zu tokens, %zu passes in %.3f s\n",
+           options->input_file, size, tokens, passes, elapsed);
+    if (elapsed > 0.0 && best > 0.0) {
+        printf("%.1f MB/s, %.1f M tokens/s (best pass: %.1f MB/s)\n",
+               megabytes * (double)passes / elapsed, (double)tokens * (double)passes / 1e6 / elapsed,
+               megabytes / best);
+    }
+    printf("Tree: %zu bytes, %.1f bytes per token\n",
+           tree_size, tokens ? (double)tree_size / (double)tokens : 0.0);
+    bench_traversal(ast, passes);
+    
+    if (options->jobs > 1) {
+        return bench_parser_parallel(options, parser, lexer, source, size, passes, best);
+    }
+    return 0;
+}
+
+/* Read one byte of every page of a tree, so a mapped one is loaded */
+static volatile size_t touched;
+
+static void touch_tree(const hyp_ast_node_t* root, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)root;
+    size_t sum = 0;
+    for (size_t i = 0; i < size; i += 4096) sum += bytes[i];
+    touched += sum;
+}
+
+/* Load a module the way a tool does: read the source, then map its
+ * cached tree, or parse it when cache is NULL */
+static bool bench_load_module(hyp_ast_cache_t* cache, const char* path) {
+    hyp_source_t source;
+    if (hyp_source_load(&source, path) != HYP_OK) return false;
+    
+    hyp_ast_image_t image;
+    hyp_lexer_t* lexer = NULL;
+    hyp_error_t result;
+    if (cache) {
+        result = hyp_ast_cache_load(cache, hyp_ast_cache_key(source.data, source.size), &image);
+    } else {
+        lexer = hyp_lexer_create_with_length(source.data, source.size, path);
+        result = lexer ? hyp_ast_cache_parse(NULL, lexer, source.data, source.size, &image)
+                       : HYP_ERROR_MEMORY;
+    }
+    
+    if (result == HYP_OK) {
+        touch_tree(image.root, image.size);
+        hyp_ast_image_release(&image);
+    }
+    hyp_lexer_destroy(lexer);
+    hyp_source_release(&source);
+    return result == HYP_OK;
+}
+
+/* Fill the AST cache with the file and the modules it imports, directly
+ * or not, then time loading them all from the cache against parsing
+ * them again; both sides read the source, as a tool would to find the key */
+static int bench_ast_cache(hypc_options_t* options) {
+    hyp_ast_cache_t cache;
+    hyp_ast_cache_init(&cache);
+    if (!cache.dir) {
+        fprintf(stderr, "Error: The AST cache is disabled (%s is empty)\n", HYP_AST_CACHE_ENV);
+        return 1;
+    }
+    
+    HYP_ARRAY(char*) modules;
+    HYP_ARRAY_INIT(&modules);
+    HYP_ARRAY(char*) parsed;
+    HYP_ARRAY_INIT(&parsed);
+    HYP_ARRAY_PUSH(&modules, hyp_strdup(options->input_file));
+    
+    size_t source_bytes = 0;
+    size_t tree_bytes = 0;
+    int status = 0;
+    for (size_t i = 0; i < modules.count && status == 0; i++) {
+        const char* path = modules.data[i];
+        hyp_source_t source;
+        if (hyp_source_load(&source, path) != HYP_OK) {
+            fprintf(stderr, "Skipping %s: could not read it\n", path);
+            continue;
+        }
+        
+        hyp_lexer_t* lexer = hyp_lexer_create_with_length(source.data, source.size, path);
+        hyp_parser_t* parser = lexer ? hyp_parser_create(lexer) : NULL;
+        hyp_ast_node_t* ast = parser ? hyp_parser_parse(parser) : NULL;
+        if (!ast || parser->had_error) {
+            fprintf(stderr, "Skipping %s: parsing failed\n", path);
+        } else {
+            /* What comes back must be the very tree that was stored */
+            uint64_t key = hyp_ast_cache_key(source.data, source.size);
+            hyp_ast_image_t image;
+            if (hyp_ast_cache_store(&cache, key, ast, parser->tree_size) != HYP_OK ||
+                hyp_ast_cache_load(&cache, key, &image) != HYP_OK) {
+                fprintf(stderr, "Error: Could not cache %s in %s\n", path, cache.dir);
+                status = 1;
+            } else {
+                if (image.size != parser->tree_size || memcmp(image.root, ast, image.size) != 0) {
+                    fprintf(stderr, "Error: Cached tree of %s differs from the parsed one\n", path);
+                    status = 1;
+                }
+                hyp_ast_image_release(&image);
+            }
+            
+            HYP_ARRAY_PUSH(&parsed, hyp_strdup(path));
+            source_bytes += source.size;
+            tree_bytes += parser->tree_size;
+            
+            for (size_t j = 0; j < ast->program.statements.count; j++) {
+                const hyp_ast_node_t* stmt = HYP_AST_AT(ast, program.statements, j);
+                if (stmt->type != AST_IMPORT_STMT) continue;
+                
+                char* import = hyp_build_resolve_import(path, HYP_AST_TEXT(stmt, import_stmt.module));
+                if (!import) continue;
+                bool known = false;
+                for (size_t k = 0; k < modules.count && !known; k++) {
+                    known = strcmp(modules.data[k], import) == 0;
+                }
+                if (known) {
+                    HYP_FREE(import);
+                } else {
+                    HYP_ARRAY_PUSH(&modules, import);
+                }
+            }
+        }
+        
+        hyp_parser_destroy(parser);
+        hyp_lexer_destroy(lexer);
+        hyp_source_release(&source);
+    }
+    
+    if (status == 0 && parsed.count == 0) {
+        fprintf(stderr, "Error: No module could be parsed\n");
+        status = 1;
+    }
+    
+    if (status == 0) {
+        /* Enough passes for about 64 MB of source, but at least three */
+        size_t passes = (64u * 1024 * 1024) / (source_bytes ? source_bytes : 1);
+        if (passes < 3) passes = 3;
+        
+        double best_parse = 0.0;
+        double best_load = 0.0;
+        for (size_t pass = 0; pass < passes && status == 0; pass++) {
+            for (int cached = 0; cached < 2 && status == 0; cached++) {
+                double started = hyp_wall_time();
+                for (size_t i = 0; i < parsed.count; i++) {
+                    if (!bench_load_module(cached ? &cache : NULL, parsed.data[i])) {
+                        status = 1;
+                        break;
+                    }
+                }
+                
+                double time = hyp_wall_time() - started;
+                double* best = cached ? &best_load : &best_parse;
+                if (pass == 0 || time < *best) *best = time;
+            }
+        }
+        
+        if (status != 0) {
+            fprintf(stderr, "Error: A module changed or left the cache during the benchmark\n");
+        } else {
+            double megabytes = (double)source_bytes / (1024.0 * 1024.0);
+            printf("%zu modules: %zu bytes of source, %zu bytes of trees, best of %zu passes\n",
+                   parsed.count, source_bytes, tree_bytes, passes);
+            printf("Parse:  %8.3f ms (%.1f MB/s)\n", best_parse * 1000.0,
+                   best_parse > 0.0 ? megabytes / best_parse : 0.0);
+            printf("Cached: %8.3f ms (%.1f MB/s), %.1fx faster\n", best_load * 1000.0,
+                   best_load > 0.0 ? megabytes / best_load : 0.0,
+                   best_load > 0.0 ? best_parse / best_load : 0.0);
+        }
+    }
+    
+    for (size_t i = 0; i < modules.count; i++) HYP_FREE(modules.data[i]);
+    for (size_t i = 0; i < parsed.count; i++) HYP_FREE(parsed.data[i]);
+    HYP_ARRAY_FREE(&modules);
+    HYP_ARRAY_FREE(&parsed);
+    return status;
+}
+
+/* Whether an incrementally updated tree has the statements a full parse
+ * builds: each statement's slots are self-contained, so they must match
+ * byte for byte wherever they ended up */
+static bool same_statements(const hyp_parser_t* updated, const hyp_parser_t* parsed) {
+    if (updated->decls.count != parsed->decls.count || updated->had_error != parsed->had_error) return false;
+    
+    for (size_t i = 0; i < parsed->decls.count; i++) {
+        const hyp_parser_decl_t* a = &updated->decls.data[i];
+        const hyp_parser_decl_t* b = &parsed->decls.data[i];
+        uint32_t length = b->end_slot - b->first_slot;
+        if (a->first_token != b->first_token || a->end_token != b->end_token ||
+            a->had_error != b->had_error || a->panic != b->panic ||
+            a->end_slot - a->first_slot != length || (a->node == 0) != (b->node == 0) ||
+            (b->node && a->node - a->first_slot != b->node - b->first_slot) ||
+            memcmp(updated->slots + a->first_slot, parsed->slots + b->first_slot,
+                   length * sizeof(hyp_ast_node_t)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Replace removed bytes at offset of a NUL-terminated buffer with text */
+static void edit_text(char* buffer, size_t* length, size_t offset, size_t removed, const char* text) {
+    size_t inserted = strlen(text);
+    memmove(buffer + offset + inserted, buffer + offset + removed, *length - offset - removed + 1);
+    memcpy(buffer + offset, text, inserted);
+    *length = *length - removed + inserted;
+}
+
+/* Next value of a xorshift generator */
+static uint64_t next_random(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/* Start of a random token other than the end of input, or of a random
+ * identifier */
+static size_t random_token(const hyp_lexer_t* lexer, uint64_t* random, bool identifier) {
+    size_t token;
+    do {
+        token = (size_t)(next_random(random) % lexer->tokens.count);
+    } while (lexer->tokens.types[token] == TOKEN_EOF ||
+             (identifier && lexer->tokens.types[token] != TOKEN_IDENTIFIER));
+    return token;
+}
+
+/* Simulate typing with edits in pairs, the second undoing the first:
+ * append a character to an identifier, break a line before one, type a
+ * quote, comment opener or bracket before a token, or delete a run of
+ * tokens (across lines, sometimes stopping inside a token). The source
+ * may have errors, and delimiters add more until they are removed. Each
+ * edit is applied with hyp_lexer_edit and hyp_parser_update and timed
+ * against parsing the whole file; the tree, including which statements
+ * have errors, is checked against a full parse after every edit for
+ * small sources and every so often for large ones. */
+static int bench_edits(hypc_options_t* options, const char* source, size_t size) {
+    enum { EDITS = 4000, CHECK_EVERY = 97, CHECK_ALL_BELOW = 64 * 1024, MAX_RUN = 12 };
+    static const char* const delimiters[] = { "\"", "'", "/*", "//", "{", "}", "(", ")", "[", "]" };
+    
+    size_t capacity = size + 16;
+    char* buffer = HYP_MALLOC(capacity);
+    char* deleted = HYP_MALLOC(size + 1);
+    if (!buffer || !deleted) {
+        HYP_FREE(buffer);
+        HYP_FREE(deleted);
+        return 1;
+    }
+    memcpy(buffer, source, size);
+    buffer[size] = '\0';
+    size_t length = size;
+    
+    hyp_lexer_t* lexer = hyp_lexer_create_with_length(buffer, length, options->input_file);
+    hyp_parser_t* parser = lexer ? hyp_parser_create(lexer) : NULL;
+    hyp_lexer_t* check_lexer = hyp_lexer_create_with_length(buffer, length, options->input_file);
+    hyp_parser_t* check_parser = check_lexer ? hyp_parser_create(check_lexer) : NULL;
+    if (!parser || !check_parser ||
+        hyp_parser_set_incremental(parser) != HYP_OK || hyp_parser_set_incremental(check_parser) != HYP_OK) {
+        fprintf(stderr, "Error: Could not create parser\n");
+        hyp_parser_destroy(parser);
+        hyp_parser_destroy(check_parser);
+        hyp_lexer_destroy(lexer);
+        hyp_lexer_destroy(check_lexer);
+        HYP_FREE(buffer);
+        HYP_FREE(deleted);
+        return 1;
+    }
+    
+    /* Syntax errors are expected; keep their messages off the terminal */
+    hyp_out_t messages;
+    hyp_out_init(&messages, -1);
+    parser->messages = &messages;
+    check_parser->messages = &messages;
+    
+    /* The full parse to beat, best of three */
+    double full = 0.0;
+    for (int pass = 0; pass < 3; pass++) {
+        double started = hyp_wall_time();
+        hyp_lexer_reset(lexer, buffer, length, 1);
+        hyp_parser_reset(parser, lexer);
+        hyp_parser_parse(parser);
+        double time = hyp_wall_time() - started;
+        if (pass == 0 || time < full) full = time;
+    }
+    
+    int status = 0;
+    if (parser->slot_count == 0) {
+        fprintf(stderr, "Error: Parsing failed\n");
+        status = 1;
+    }
+    size_t errors = 0;
+    for (size_t i = 0; i < parser->decls.count; i++) errors += parser->decls.data[i].had_error;
+    
+    size_t check_every = size < CHECK_ALL_BELOW ? 1 : CHECK_EVERY;
+    uint64_t random = 0x9E3779B97F4A7C15ull;
+    double total = 0.0;
+    double worst = 0.0;
+    size_t edits = 0;
+    size_t checks = 0;
+    size_t offset = 0;
+    size_t run = 0;
+    const char* typed = "";
+    while (status == 0 && edits < EDITS) {
+        /* Choose each pair of edits from the unedited source */
+        size_t step = edits % 2;
+        size_t kind = edits / 2 % 8;
+        if (step == 0) {
+            size_t token = random_token(lexer, &random, kind < 4);
+            offset = hyp_token_start(&lexer->tokens, token);
+            if (kind < 3) {
+                offset += lexer->tokens.lengths[token];
+                typed = "x";
+            } else if (kind == 3) {
+                typed = "\n";
+            } else if (kind < 6) {
+                typed = delimiters[next_random(&random) % (sizeof(delimiters) / sizeof(delimiters[0]))];
+            } else {
+                /* Up to the end of a later token, or one byte short of it */
+                size_t last = token + next_random(&random) % MAX_RUN;
+                if (last >= lexer->tokens.count - 1) last = lexer->tokens.count - 2;
+                size_t end = hyp_token_start(&lexer->tokens, last) + lexer->tokens.lengths[last];
+                if (end > offset + 1 && next_random(&random) % 2) end--;
+                run = end - offset;
+                memcpy(deleted, buffer + offset, run);
+                deleted[run] = '\0';
+            }
+        }
+        
+        size_t removed;
+        const char* text;
+        if (kind < 6) {
+            removed = step ? strlen(typed) : 0;
+            text = step ? "" : typed;
+        } else {
+            removed = step ? 0 : run;
+            text = step ? deleted : "";
+        }
+        
+        edit_text(buffer, &length, offset, removed, text);
+        double started = hyp_wall_time();
+        hyp_token_edit_t edit;
+        bool updated = hyp_lexer_edit(lexer, buffer, length, offset, removed, strlen(text), &edit) == HYP_OK &&
+                       (hyp_parser_update(parser, &edit) != NULL || parser->had_error);
+        double time = hyp_wall_time() - started;
+        edits++;
+        
+        if (!updated) {
+            fprintf(stderr, "Error: Updating the tree failed after %zu edits\n", edits);
+            status = 1;
+            break;
+        }
+        total += time;
+        if (time > worst) worst = time;
+        
+        if (edits % check_every == 0 || edits == EDITS) {
+            hyp_lexer_reset(check_lexer, buffer, length, 1);
+            hyp_parser_reset(check_parser, check_lexer);
+            hyp_parser_parse(check_parser);
+            checks++;
+            if (check_parser->slot_count == 0 || !same_statements(parser, check_parser)) {
+                fprintf(stderr, "Error: After %zu edits the tree differs from a full parse\n", edits);
+                status = 1;
+            }
+        }
+        
+        hyp_out_destroy(&messages);
+        hyp_out_init(&messages, -1);
+    }
+    
+    if (status == 0) {
+        double average = total / (double)edits;
+        printf("Edited %s: %zu bytes, %zu lines, %zu top-level statements (%zu with errors)\n",
+               options->input_file, size, lexer->line_count, parser->decls.count, errors);
+        printf("Full parse: %8.3f ms\n", full * 1000.0);
+        printf("Update:     %8.3f ms on average, %.3f ms at worst over %zu edits (%.0fx faster)\n",
+               average * 1000.0, worst * 1000.0, edits, average > 0.0 ? full / average : 0.0);
+        printf("Tree: %zu bytes; matched a full parse %zu times\n", parser->tree_size, checks);
+    }
+    
+    hyp_parser_destroy(parser);
+    hyp_parser_destroy(check_parser);
+    hyp_lexer_destroy(lexer);
+    hyp_lexer_destroy(check_lexer);
+    hyp_out_destroy(&messages);
+    HYP_FREE(buffer);
+    HYP_FREE(deleted);
+    return status;
+}
+
+/* Time one conversion over every sample, keeping the fastest of a few
+ * passes; the kinds of number are measured separately because integers,
+ * short decimals and arbitrary doubles take different paths */
+typedef enum {
+    NUMBER_FORMAT,
+    NUMBER_FORMAT_LIBC,
+    NUMBER_PARSE,
+    NUMBER_PARSE_LIBC
+} number_bench_op_t;
+
+/* Keeps the parsed values live so the parse loops are not optimized out */
+static volatile double number_bench_sink;
+
+static double bench_number_pass(number_bench_op_t op, const double* values, char* texts,
+                                size_t* lengths, size_t count) {
+    double best = 0.0;
+    for (int pass = 0; pass < 5; pass++) {
+        double sum = 0.0;
+        double started = hyp_wall_time();
+        for (size_t i = 0; i < count; i++) {
+            char* text = texts + i * HYP_NUMBER_BUFFER_SIZE;
+            double value = 0.0;
+            switch (op) {
+                case NUMBER_FORMAT:
+                    lengths[i] = hyp_number_format(values[i], text);
+                    break;
+                case NUMBER_FORMAT_LIBC:
+                    lengths[i] = (size_t)snprintf(text, HYP_NUMBER_BUFFER_SIZE, "%.17g", values[i]);
+                    break;
+                case NUMBER_PARSE:
+                    hyp_number_parse(text, lengths[i], &value);
+                    break;
+                case NUMBER_PARSE_LIBC:
+                    value = strtod(text, NULL);
+                    break;
+            }
+            sum += value;
+        }
+        double time = hyp_wall_time() - started;
+        number_bench_sink = sum;
+        if (pass == 0 || time < best) best = time;
+    }
+    return best;
+}
+
+/* Compare the shared number conversions with the C library's %.17g and
+ * strtod, and check that every formatted number reads back exactly */
+static int bench_numbers(void) {
+    enum { SAMPLES = 1 << 20 };
+    static const char* kinds[] = { "integers", "decimals", "doubles" };
+    double* values = HYP_MALLOC(SAMPLES * sizeof(double));
+    char* texts = HYP_MALLOC((size_t)SAMPLES * HYP_NUMBER_BUFFER_SIZE);
+    size_t* lengths = HYP_MALLOC(SAMPLES * sizeof(size_t));
+    if (!values || !texts || !lengths) {
+        fprintf(stderr, "Error: Out of memory\n");
+        HYP_FREE(values);
+        HYP_FREE(texts);
+        HYP_FREE(lengths);
+        return 1;
+    }
+    
+    printf("%-10s %12s %12s %12s %12s\n", "", "format", "%.17g", "parse", "strtod");
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    size_t mismatches = 0;
+    for (int kind = 0; kind < 3; kind++) {
+        for (size_t i = 0; i < SAMPLES; i++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            if (kind == 0) {
+                values[i] = (double)(state % 100000000u);
+            } else if (kind == 1) {
+                values[i] = (double)(state % 1000000u) / 1000.0;
+            } else {
+                /* Random bits, skipping infinities and NaN */
+                uint64_t bits = state;
+                if (((bits >> 52) & 0x7FF) == 0x7FF) bits ^= (uint64_t)1 << 62;
+                memcpy(&values[i], &bits, sizeof(double));
+            }
+        }
+        
+        double format_libc = bench_number_pass(NUMBER_FORMAT_LIBC, values, texts, lengths, SAMPLES);
+        double parse_libc = bench_number_pass(NUMBER_PARSE_LIBC, values, texts, lengths, SAMPLES);
+        double format = bench_number_pass(NUMBER_FORMAT, values, texts, lengths, SAMPLES);
+        double parse = bench_number_pass(NUMBER_PARSE, values, texts, lengths, SAMPLES);
+        
+        size_t bytes = 0;
+        for (size_t i = 0; i < SAMPLES; i++) {
+            double value = 0.0;
+            bytes += lengths[i];
+            size_t used = hyp_number_parse(texts + i * HYP_NUMBER_BUFFER_SIZE, lengths[i], &value);
+            if (used != lengths[i] || memcmp(&value, &values[i], sizeof(double)) != 0) {
+                /* -0 prints as "0", as in JavaScript */
+                if (!(value == 0.0 && values[i] == 0.0)) mismatches++;
+            }
+        }
+        
+        double millions = (double)SAMPLES / 1e6;
+        printf("%-10s %8.1f M/s %8.1f M/s %8.1f M/s %8.1f M/s  (%.1f bytes each, parse %.0f MB/s)\n",
+               kinds[kind], millions / format, millions / format_libc, millions / parse,
+               millions / parse_libc, (double)bytes / SAMPLES,
+               (double)bytes / (1024.0 * 1024.0) / parse);
+    }
+    printf("%d numbers formatted and parsed back, %zu mismatches\n", 3 * SAMPLES, mismatches);
+    
+    HYP_FREE(values);
+    HYP_FREE(texts);
+    HYP_FREE(lengths);
+    return mismatches ? 1 : 0;
+}
+
 /* Main compilation function */
 static int compile_file(hypc_options_t* options) {
     if (options->verbose) {
@@ -324,22 +1251,28 @@ static int compile_file(hypc_options_t* options) {
                options->input_file);
     }
     
-    /* Read source file */
-    size_t source_size;
-    char* source = hyp_read_file(options->input_file, &source_size);
-    if (!source) {
+    /* Load source file; the lexer works on it in place */
+    hyp_source_t source;
+    if (hyp_source_load(&source, options->input_file) != HYP_OK) {
         fprintf(stderr, "Error: Could not read file '%s'\n", options->input_file);
         return 1;
     }
     
     /* Create lexer */
-    hyp_lexer_t* lexer = hyp_lexer_create(source, options->input_file);
+    hyp_lexer_t* lexer = hyp_lexer_create_with_length(source.data, source.size, options->input_file);
     if (!lexer) {
         fprintf(stderr, "Error: Could not create lexer\n");
-        HYP_FREE(source);
+        hyp_source_release(&source);
         return 1;
     }
     
+    if (options->lex_bench) {
+        int status = bench_lexer(options, lexer, source.data, source.size);
+        hyp_lexer_destroy(lexer);
+        hyp_source_release(&source);
+        return status;
+    }
+    
     /* Show tokens if requested */
     if (options->show_tokens) {
         printf("Tokens for %s:\n", options->input_file);
@@ -350,31 +1283,44 @@ static int compile_file(hypc_options_t* options) {
         } while (token.type != TOKEN_EOF && token.type != TOKEN_ERROR);
         
         hyp_lexer_destroy(lexer);
-        HYP_FREE(source);
+        hyp_source_release(&source);
         return 0;
     }
     
-    /* Create parser */
-    hyp_parser_t* parser = hyp_parser_create(lexer);
-    if (!parser) {
-        fprintf(stderr, "Error: Could not create parser\n");
+    if (options->edit_bench) {
+        int status = bench_edits(options, source.data, source.size);
         hyp_lexer_destroy(lexer);
-        HYP_FREE(source);
-        return 1;
+        hyp_source_release(&source);
+        return status;
     }
     
-    /* Parse source */
-    hyp_ast_node_t* ast = hyp_parser_parse(parser);
-    if (!ast || parser->had_error) {
-        fprintf(stderr, "Error: Parsing failed\n");
+    if (options->parse_bench) {
+        hyp_parser_t* parser = hyp_parser_create(lexer);
+        int status = parser ? bench_parser(options, parser, lexer, source.data, source.size) : 1;
         hyp_parser_destroy(parser);
         hyp_lexer_destroy(lexer);
-        HYP_FREE(source);
+        hyp_source_release(&source);
+        return status;
+    }
+    
+    /* Parse source, or map the tree cached by an earlier run */
+    hyp_ast_cache_t ast_cache;
+    hyp_ast_cache_init(&ast_cache);
+    ast_cache.force = options->force;
+    ast_cache.jobs = options->jobs;
+    
+    hyp_ast_image_t image;
+    hyp_error_t parsed = hyp_ast_cache_parse(&ast_cache, lexer, source.data, source.size, &image);
+    if (parsed != HYP_OK) {
+        fprintf(stderr, parsed == HYP_ERROR_SYNTAX ? "Error: Parsing failed\n" : "Error: Could not create parser\n");
+        hyp_lexer_destroy(lexer);
+        hyp_source_release(&source);
         return 1;
     }
+    hyp_ast_node_t* ast = image.root;
     
     if (options->verbose) {
-        printf("Parsing completed successfully\n");
+        printf("Parsing completed successfully%s\n", image.from_cache ? " (cached)" : "");
     }
     
     /* Show AST if requested */
@@ -382,113 +1328,488 @@ static int compile_file(hypc_options_t* options) {
         printf("AST for %s:\n", options->input_file);
         print_ast_node(ast, 0);
         
-        hyp_parser_destroy(parser);
+        hyp_ast_image_release(&image);
         hyp_lexer_destroy(lexer);
-        HYP_FREE(source);
+        hyp_source_release(&source);
         return 0;
     }
     
+    /* Load the execution profile; a missing or stale one only costs the hints */
+    hyp_profile_t* profile = NULL;
+    if (options->profile_file) {
+        if (hyp_profile_load(options->profile_file, &profile) != HYP_OK ||
+            hyp_profile_bind(profile, ast) != HYP_OK) {
+            fprintf(stderr, "Warning: Could not use profile '%s'\n", options->profile_file);
+            hyp_profile_destroy(profile);
+            profile = NULL;
+        } else if (options->verbose) {
+            printf("Using profile %s\n", options->profile_file);
+        }
+    }
+    
     /* Create code generator */
     hyp_codegen_options_t codegen_opts = {
         .target = options->target,
         .optimize = options->optimize,
-        .debug_info = options->debug
+        .debug_info = options->debug,
+        .profile = profile,
+        .jobs = options->jobs
     };
     
     hyp_codegen_t codegen;
     hyp_error_t result = hyp_codegen_init(&codegen, &codegen_opts, NULL);
     if (result != HYP_OK) {
         fprintf(stderr, "Error: Could not initialize code generator\n");
-        hyp_parser_destroy(parser);
+        hyp_profile_destroy(profile);
+        hyp_ast_image_release(&image);
         hyp_lexer_destroy(lexer);
-        HYP_FREE(source);
+        hyp_source_release(&source);
         return 1;
     }
     
+    /* Determine output file */
+    char* output_file = options->output_file;
+    bool free_output_file = false;
+    
+    if (!output_file) {
+        output_file = generate_output_filename(options->input_file, options->target);
+        free_output_file = true;
+        
+        if (!output_file) {
+            fprintf(stderr, "Error: Could not generate output filename\n");
+            hyp_profile_destroy(profile);
+            hyp_codegen_destroy(&codegen);
+            hyp_ast_image_release(&image);
+            hyp_lexer_destroy(lexer);
+            hyp_source_release(&source);
+            return 1;
+        }
+    }
+    
+    /* Generated code is streamed to the file as it is produced */
+    int output_fd = hyp_create_file(output_file);
+    if (output_fd < 0) {
+        fprintf(stderr, "Error: Could not open output file '%s'\n", output_file);
+        if (free_output_file) HYP_FREE(output_file);
+        hyp_profile_destroy(profile);
+        hyp_codegen_destroy(&codegen);
+        hyp_ast_image_release(&image);
+        hyp_lexer_destroy(lexer);
+        hyp_source_release(&source);
+        return 1;
+    }
+    hyp_codegen_set_output_fd(&codegen, output_fd);
+    
     /* Generate code */
+    double started = hyp_wall_time();
     result = hyp_codegen_generate(&codegen, ast);
+    double elapsed = hyp_wall_time() - started;
+    hyp_profile_destroy(profile);
+    codegen.profile = NULL;
+    
+    if (hyp_close_file(output_fd) != HYP_OK && result == HYP_OK) {
+        result = HYP_ERROR_IO;
+    }
     if (result != HYP_OK) {
-        fprintf(stderr, "Error: Code generation failed\n");
+        if (result == HYP_ERROR_IO) {
+            fprintf(stderr, "Error: Could not write output file '%s'\n", output_file);
+        } else {
+            fprintf(stderr, "Error: Code generation failed: %s\n",
+                    codegen.has_error ? codegen.error_message : "unknown error");
+        }
+        remove(output_file);
+        if (free_output_file) HYP_FREE(output_file);
         hyp_codegen_destroy(&codegen);
-        hyp_parser_destroy(parser);
+        hyp_ast_image_release(&image);
         hyp_lexer_destroy(lexer);
-        HYP_FREE(source);
+        hyp_source_release(&source);
         return 1;
     }
     
     if (options->verbose) {
+        size_t bytes = hyp_codegen_get_output_length(&codegen);
         printf("Code generation completed successfully\n");
+        printf("Generated %zu bytes in %.3f s", bytes, elapsed);
+        if (elapsed > 0.0) {
+            printf(" (%.1f MB/s)", (double)bytes / (1024.0 * 1024.0) / elapsed);
+        }
+        printf("\n");
+        printf("Output written to %s\n", output_file);
     }
     
-    /* Determine output file */
-    char* output_file = options->output_file;
-    bool free_output_file = false;
+    /* Cleanup */
+    if (free_output_file) HYP_FREE(output_file);
+    hyp_codegen_destroy(&codegen);
+    hyp_ast_image_release(&image);
+    hyp_lexer_destroy(lexer);
+    hyp_source_release(&source);
     
-    if (!output_file) {
-        output_file = generate_output_filename(options->input_file, options->target);
-        free_output_file = true;
-        
-        if (!output_file) {
-            fprintf(stderr, "Error: Could not generate output filename\n");
-            hyp_codegen_destroy(&codegen);
-        hyp_parser_destroy(parser);
+    return 0;
+}
+
+/* Compile a file one batch of top-level declarations at a time (--stream).
+ * Every batch is parsed twice: once to declare its names, once to define
+ * them, so only the names are kept between batches and memory stays
+ * proportional to the largest declaration instead of the whole file. */
+static int compile_file_streaming(hypc_options_t* options) {
+    if (options->verbose) {
+        printf("Compiling %s (streaming)...\n", options->input_file);
+    }
+    
+    hyp_source_reader_t reader;
+    if (hyp_source_reader_open(&reader, options->input_file, 0) != HYP_OK) {
+        fprintf(stderr, "Error: Could not read file '%s'\n", options->input_file);
+        return 1;
+    }
+    
+    /* One lexer and parser serve every batch */
+    hyp_lexer_t* lexer = hyp_lexer_create("", options->input_file);
+    hyp_parser_t* parser = lexer ? hyp_parser_create(lexer) : NULL;
+    if (!parser) {
+        fprintf(stderr, "Error: Could not create parser\n");
         hyp_lexer_destroy(lexer);
-        HYP_FREE(source);
+        hyp_source_reader_close(&reader);
         return 1;
     }
+    
+    hyp_codegen_options_t codegen_opts = {
+        .target = options->target,
+        .optimize = options->optimize,
+        .debug_info = options->debug,
+        .jobs = options->jobs
+    };
+    
+    hyp_codegen_t codegen;
+    if (hyp_codegen_init(&codegen, &codegen_opts, NULL) != HYP_OK) {
+        fprintf(stderr, "Error: Could not initialize code generator\n");
+        hyp_parser_destroy(parser);
+        hyp_lexer_destroy(lexer);
+        hyp_source_reader_close(&reader);
+        return 1;
     }
     
-    /* Write output file */
-    /* Write output to file */
-     FILE* output = fopen(output_file, "w");
-     if (!output) {
-         fprintf(stderr, "Error: Could not open output file '%s'\n", output_file);
-         result = HYP_ERROR_IO;
-     } else {
-         const char* generated_code = hyp_codegen_get_output(&codegen);
-         if (generated_code) {
-             fputs(generated_code, output);
-             fclose(output);
-             result = HYP_OK;
-         } else {
-             fclose(output);
-             result = HYP_ERROR_RUNTIME;
-         }
-     }
-    if (result != HYP_OK) {
-        fprintf(stderr, "Error: Could not write output file '%s'\n", output_file);
+    char* output_file = options->output_file;
+    bool free_output_file = false;
+    if (!output_file) {
+        output_file = generate_output_filename(options->input_file, options->target);
+        free_output_file = true;
+    }
+    int output_fd = output_file ? hyp_create_file(output_file) : -1;
+    if (output_fd < 0) {
+        fprintf(stderr, "Error: Could not open output file '%s'\n", output_file ? output_file : "");
         if (free_output_file) HYP_FREE(output_file);
         hyp_codegen_destroy(&codegen);
         hyp_parser_destroy(parser);
         hyp_lexer_destroy(lexer);
-        HYP_FREE(source);
+        hyp_source_reader_close(&reader);
         return 1;
     }
+    hyp_codegen_set_output_fd(&codegen, output_fd);
     
-    if (options->verbose) {
+    double started = hyp_wall_time();
+    size_t batches = 0;
+    size_t largest = 0;
+    bool parse_failed = false;
+    hyp_error_t result = hyp_codegen_stream_begin(&codegen);
+    
+    for (int pass = 0; pass < 2 && result == HYP_OK; pass++) {
+        if (pass == 1 && hyp_source_reader_rewind(&reader) != HYP_OK) {
+            result = HYP_ERROR_IO;
+            break;
+        }
+        
+        const char* text;
+        size_t length;
+        size_t line;
+        hyp_error_t next;
+        while ((next = hyp_source_reader_next(&reader, &text, &length, &line)) == HYP_OK) {
+            hyp_lexer_reset(lexer, text, length, line);
+            hyp_parser_reset(parser, lexer);
+            
+            hyp_ast_node_t* batch = hyp_parser_parse(parser);
+            if (!batch || parser->had_error) {
+                parse_failed = true;
+                result = HYP_ERROR_SYNTAX;
+                break;
+            }
+            
+            result = pass == 0 ? hyp_codegen_stream_declare(&codegen, batch)
+                               : hyp_codegen_stream_define(&codegen, batch);
+            if (result != HYP_OK) break;
+            
+            if (pass == 0) {
+                batches++;
+                if (length > largest) largest = length;
+            }
+        }
+        if (result == HYP_OK && next != HYP_ERROR_NOT_FOUND) {
+            fprintf(stderr, "Error: Could not read file '%s'\n", options->input_file);
+            result = HYP_ERROR_IO;
+        }
+    }
+    
+    if (result == HYP_OK) {
+        result = hyp_codegen_stream_end(&codegen);
+    }
+    double elapsed = hyp_wall_time() - started;
+    
+    if (hyp_close_file(output_fd) != HYP_OK && result == HYP_OK) {
+        result = HYP_ERROR_IO;
+    }
+    if (result != HYP_OK) {
+        if (parse_failed) {
+            fprintf(stderr, "Error: Parsing failed\n");
+        } else if (result == HYP_ERROR_IO) {
+            fprintf(stderr, "Error: Could not write output file '%s'\n", output_file);
+        } else {
+            fprintf(stderr, "Error: Code generation failed: %s\n",
+                    codegen.has_error ? codegen.error_message : "unknown error");
+        }
+        remove(output_file);
+    } else if (options->verbose) {
+        size_t bytes = hyp_codegen_get_output_length(&codegen);
+        printf("Compiled %zu batches (largest %zu bytes)\n", batches, largest);
+        printf("Generated %zu bytes in %.3f s", bytes, elapsed);
+        if (elapsed > 0.0) {
+            printf(" (%.1f MB/s)", (double)bytes / (1024.0 * 1024.0) / elapsed);
+        }
+        printf("\n");
         printf("Output written to %s\n", output_file);
     }
     
-    /* Cleanup */
     if (free_output_file) HYP_FREE(output_file);
     hyp_codegen_destroy(&codegen);
     hyp_parser_destroy(parser);
     hyp_lexer_destroy(lexer);
-    HYP_FREE(source);
+    hyp_source_reader_close(&reader);
+    return result == HYP_OK ? 0 : 1;
+}
+
+/* Build a native executable through the AOT cache */
+static int compile_native(hypc_options_t* options) {
+    hyp_aot_t aot;
+    hyp_aot_init(&aot);
+    aot.verbose = options->verbose;
+    aot.force = options->force;
+    if (options->cc) aot.cc = options->cc;
+    if (options->cflags) aot.cflags = options->cflags;
+    aot.profile_file = options->profile_file;
+    
+    char* binary_path = NULL;
+    if (hyp_aot_build(&aot, options->input_file, &binary_path) != HYP_OK) {
+        fprintf(stderr, "Error: %s\n", aot.error_message);
+        return 1;
+    }
     
+    /* Default output: input name without its extension */
+    char* output_file = options->output_file;
+    bool free_output_file = false;
+    if (!output_file) {
+        output_file = generate_output_filename(options->input_file, TARGET_C);
+        if (!output_file) {
+            HYP_FREE(binary_path);
+            return 1;
+        }
+        output_file[strlen(output_file) - 2] = '\0';
+        free_output_file = true;
+    }
+    
+    size_t size;
+    char* binary = hyp_read_file(binary_path, &size);
+    hyp_error_t result = binary ? hyp_write_file(output_file, binary, size) : HYP_ERROR_IO;
+    HYP_FREE(binary);
+    
+    if (result != HYP_OK) {
+        fprintf(stderr, "Error: Could not write output file '%s'\n", output_file);
+    } else {
+#ifndef _WIN32
+        chmod(output_file, 0755);
+#endif
+        if (options->verbose) {
+            printf("%s %s (%s)\n", aot.cache_hit ? "Cached" : "Built", output_file, binary_path);
+        }
+    }
+    
+    if (free_output_file) HYP_FREE(output_file);
+    HYP_FREE(binary_path);
+    return result == HYP_OK ? 0 : 1;
+}
+
+/* Build every out-of-date module of a project on a pool of workers */
+static int build_project(hypc_options_t* options) {
+    hyp_build_t build;
+    if (hyp_build_init(&build, options->input_file) != HYP_OK) {
+        fprintf(stderr, "Error: %s\n", build.error_message);
+        hyp_build_destroy(&build);
+        return 1;
+    }
+    
+    /* Command-line flags override the manifest */
+    if (options->target_set) build.config.target = options->target;
+    if (options->optimize) build.config.optimize = true;
+    if (options->debug) build.config.debug = true;
+    if (options->jobs) build.jobs = options->jobs;
+    build.verbose = options->verbose;
+    build.force = options->force;
+    build.cache_location = options->artifact_cache;
+    
+    if (hyp_build_scan(&build) != HYP_OK) {
+        fprintf(stderr, "Error: %s\n", build.error_message);
+        hyp_build_destroy(&build);
+        return 1;
+    }
+    
+    if (options->verbose) {
+        printf("Building %zu module%s from %s/%s\n", build.units.count, build.units.count == 1 ? "" : "s",
+               build.config.root, build.config.src_dir);
+    }
+    
+    hyp_error_t result = hyp_build_run(&build);
+    if (build.total_time > 0.0) {
+        /* Otherwise the build failed before compiling anything */
+        hyp_build_print_summary(&build, result == HYP_OK ? stdout : stderr);
+    }
+    if (build.has_error) {
+        fprintf(stderr, "Error: %s\n", build.error_message);
+    }
+    hyp_build_destroy(&build);
+    return result == HYP_OK ? 0 : 1;
+}
+
+/* Serve compile requests until stopped */
+static int run_server(hypc_options_t* options) {
+    const char* socket_path = hyp_server_socket_path(options->socket_path);
+    
+    hyp_server_t server;
+    if (hyp_server_init(&server, socket_path, options->server_memory) != HYP_OK) {
+        fprintf(stderr, "Error: %s\n", server.error_message);
+        hyp_server_destroy(&server);
+        return 1;
+    }
+    server.verbose = options->verbose;
+    
+    printf("hypc server listening on %s (cache limit %zu MB)\n", socket_path,
+           server.memory_limit / (1024 * 1024));
+    fflush(stdout);
+    
+    hyp_error_t result = hyp_server_run(&server);
+    if (result != HYP_OK) {
+        fprintf(stderr, "Error: %s\n", server.error_message);
+    }
+    hyp_server_destroy(&server);
+    return result == HYP_OK ? 0 : 1;
+}
+
+/* Send a request to the server; prints the response body and returns its status line */
+static int server_request(hypc_options_t* options, const char* request, char** response) {
+    const char* socket_path = hyp_server_socket_path(options->socket_path);
+    hyp_error_t result = hyp_server_send(socket_path, request, response);
+    if (result == HYP_ERROR_NOT_FOUND) {
+        fprintf(stderr, "Error: No compiler server on '%s' (start one with hypc --server)\n", socket_path);
+        return 1;
+    }
+    if (result != HYP_OK) {
+        fprintf(stderr, "Error: Could not talk to the compiler server on '%s'\n", socket_path);
+        return 1;
+    }
+    if (strncmp(*response, "error ", 6) == 0) {
+        /* Diagnostics follow the message but are printed first, as a
+         * local compilation prints them */
+        char* newline = strchr(*response, '\n');
+        if (newline) {
+            *newline = '\0';
+            fputs(newline + 1, stderr);
+        }
+        fprintf(stderr, "Error: %s\n", *response + 6);
+        return 1;
+    }
     return 0;
 }
 
+/* --server-stats and --server-stop */
+static int server_command(hypc_options_t* options) {
+    char* response = NULL;
+    int status = server_request(options, options->server_stop ? "shutdown\n" : "stats\n", &response);
+    if (status == 0 && options->server_stats) {
+        /* Skip the "ok" line */
+        const char* body = strchr(response, '\n');
+        printf("%s", body ? body + 1 : "");
+    }
+    HYP_FREE(response);
+    return status;
+}
+
+/* Compile through a running server */
+static int compile_remote(hypc_options_t* options) {
+    if (options->native || options->show_ast || options->show_tokens) {
+        fprintf(stderr, "Error: --client only generates source output\n");
+        return 1;
+    }
+    
+    char* output_file = options->output_file ? hyp_strdup(options->output_file)
+                                             : generate_output_filename(options->input_file, options->target);
+    char* input = hyp_server_absolute_path(options->input_file);
+    char* output = output_file ? hyp_server_absolute_path(output_file) : NULL;
+    char* profile = options->profile_file ? hyp_server_absolute_path(options->profile_file) : NULL;
+    HYP_FREE(output_file);
+    if (!input || !output || (options->profile_file && !profile)) {
+        fprintf(stderr, "Error: Could not resolve paths\n");
+        HYP_FREE(input);
+        HYP_FREE(output);
+        HYP_FREE(profile);
+        return 1;
+    }
+    
+    char request[HYP_SERVER_MAX_REQUEST];
+    int length = snprintf(request, sizeof(request),
+                          "compile\nversion %s\ninput %s\noutput %s\ntarget %d\noptimize %d\ndebug %d\njobs %zu\n%s%s%s",
+                          HYP_VERSION_STRING, input, output, (int)options->target, options->optimize ? 1 : 0,
+                          options->debug ? 1 : 0, options->jobs,
+                          profile ? "profile " : "", profile ? profile : "", profile ? "\n" : "");
+    HYP_FREE(input);
+    HYP_FREE(profile);
+    if (length < 0 || (size_t)length >= sizeof(request)) {
+        fprintf(stderr, "Error: Request too long\n");
+        HYP_FREE(output);
+        return 1;
+    }
+    
+    double started = hyp_wall_time();
+    char* response = NULL;
+    int status = server_request(options, request, &response);
+    if (status == 0 && options->verbose) {
+        size_t bytes = 0;
+        char cache[16] = "";
+        double server_ms = 0.0;
+        sscanf(response, "ok %zu %15s %lf", &bytes, cache, &server_ms);
+        printf("Generated %zu bytes (%s) in %.3f ms, %.3f ms round trip\n", bytes,
+               strcmp(cache, "hit") == 0 ? "cached AST" : "parsed", server_ms,
+               (hyp_wall_time() - started) * 1000.0);
+        printf("Output written to %s\n", output);
+    }
+    HYP_FREE(response);
+    HYP_FREE(output);
+    return status;
+}
+
 /* Main entry point */
 int main(int argc, char* argv[]) {
     hypc_options_t options;
     
+    /* Pick the allocator ($HYP_ALLOCATOR) before anything is allocated */
+    hyp_mem_init();
+    
     /* Parse command-line arguments */
     if (!parse_arguments(argc, argv, &options)) {
         print_usage(argv[0]);
         return 1;
     }
     
+    if (options.stats && !hyp_metrics_report_at_exit(options.stats_format)) {
+        fprintf(stderr, "Error: Unknown stats format '%s'\n", options.stats_format);
+        return 1;
+    }
+    
     /* Handle special options */
     if (options.show_help) {
         print_usage(argv[0]);
@@ -500,6 +1821,32 @@ int main(int argc, char* argv[]) {
         return 0;
     }
     
+    if (options.number_bench) {
+        return bench_numbers();
+    }
+    
     /* Compile the file */
+    if (options.server) {
+        return run_server(&options);
+    }
+    if (options.server_stats || options.server_stop) {
+        return server_command(&options);
+    }
+    if (options.client) {
+        return compile_remote(&options);
+    }
+    if (options.build) {
+        return build_project(&options);
+    }
+    if (options.native) {
+        return compile_native(&options);
+    }
+    if (options.ast_bench) {
+        return bench_ast_cache(&options);
+    }
+    if (options.stream && !options.show_ast && !options.show_tokens && !options.lex_bench &&
+        !options.parse_bench && !options.edit_bench) {
+        return compile_file_streaming(&options);
+    }
     return compile_file(&options);
 }
\ No newline at end of file
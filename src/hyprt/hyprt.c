@@ -0,0 +1,769 @@
+/**
+ * Hyper Programming Language - Native Runtime Library Implementation
+ *
+ * Out-of-line parts of libhyprt: heap allocation and mark-sweep
+ * collection, string interning, object shapes, and the builtins.
+ */
+
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L    /* clock_gettime */
+#endif
+
+#include "../../include/hyprt.h"
+#include "../../include/hyp_number.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <setjmp.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#define HYPRT_INITIAL_GC_THRESHOLD (1024 * 1024)
+
+/* Hidden class: each shape adds one key to its parent */
+struct hyprt_shape {
+    hyprt_shape_t* parent;
+    hyprt_string_t* key;         /* Interned; NULL for the root shape */
+    size_t count;                /* Number of keys, and slot index + 1 of key */
+    hyprt_shape_t** transitions;
+    size_t transition_count;
+    size_t transition_capacity;
+};
+
+/* Global state */
+bool hyprt_gc_requested = false;
+
+static struct {
+    hyprt_gc_header_t* objects;
+    size_t object_count;
+    size_t bytes_allocated;
+    void* stack_base;
+    size_t next_gc;
+
+    hyprt_value_t** roots;
+    size_t root_count;
+    size_t root_capacity;
+
+    hyprt_gc_header_t** gray;
+    size_t gray_count;
+    size_t gray_capacity;
+
+    hyprt_string_t** interned;
+    size_t interned_count;
+    size_t interned_capacity;
+
+    hyprt_shape_t root_shape;
+
+    /* Collector figures for HYPRT_STATS_ENV; pauses only kept if it is set */
+    const char* stats_path;
+    uint64_t collections;
+    uint64_t freed_bytes;
+    uint64_t* pauses;
+    size_t pause_count;
+    size_t pause_capacity;
+} heap;
+
+void hyprt_panic(const char* format, ...) {
+    va_list args;
+
+    fflush(stdout);
+    fprintf(stderr, "Runtime error: ");
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+static void* checked_realloc(void* ptr, size_t size) {
+    void* result = realloc(ptr, size);
+    if (!result && size > 0) hyprt_panic("Out of memory");
+    return result;
+}
+
+/* Allocation */
+static void* gc_allocate(size_t size, hyprt_type_t type) {
+    hyprt_gc_header_t* header = checked_realloc(NULL, size);
+
+    header->type = (uint8_t)type;
+    header->marked = 0;
+    header->pinned = 0;
+    header->next = heap.objects;
+    heap.objects = header;
+    heap.object_count++;
+
+    heap.bytes_allocated += size;
+    if (heap.bytes_allocated > heap.next_gc) {
+        hyprt_gc_requested = true;
+    }
+
+    return header;
+}
+
+static uint64_t monotonic_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static void write_stats(void) {
+    FILE* file = fopen(heap.stats_path, "w");
+    if (!file) return;
+
+    fprintf(file, "gc.collections %llu\n", (unsigned long long)heap.collections);
+    fprintf(file, "gc.freed_bytes %llu\n", (unsigned long long)heap.freed_bytes);
+    for (size_t i = 0; i < heap.pause_count; i++) {
+        fprintf(file, "gc.pause_ns %llu\n", (unsigned long long)heap.pauses[i]);
+    }
+    fclose(file);
+}
+
+void hyprt_init(int argc, char* argv[], void* stack_base) {
+    (void)argc;
+    (void)argv;
+
+    memset(&heap, 0, sizeof(heap));
+    heap.next_gc = HYPRT_INITIAL_GC_THRESHOLD;
+    heap.stack_base = stack_base;
+
+    const char* stats_path = getenv(HYPRT_STATS_ENV);
+    if (stats_path && *stats_path) {
+        heap.stats_path = stats_path;
+        atexit(write_stats);
+    }
+}
+
+int hyprt_shutdown(hyprt_value_t result) {
+    fflush(stdout);
+    return result.type == HYPRT_NUMBER ? (int)result.as.number : 0;
+}
+
+/* Strings */
+static uint32_t hash_bytes(const char* data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static hyprt_string_t* string_allocate(const char* data, size_t length, uint32_t hash) {
+    hyprt_string_t* string = gc_allocate(sizeof(hyprt_string_t) + length + 1, HYPRT_STRING);
+    string->length = length;
+    string->hash = hash;
+    string->interned = false;
+    if (length > 0) memcpy(string->data, data, length);
+    string->data[length] = '\0';
+    return string;
+}
+
+hyprt_value_t hyprt_string_new(const char* data, size_t length) {
+    return hyprt_ref(HYPRT_STRING, string_allocate(data, length, hash_bytes(data, length)));
+}
+
+/* Open-addressing set of interned strings */
+static hyprt_string_t** intern_find_slot(const char* data, size_t length, uint32_t hash) {
+    size_t mask = heap.interned_capacity - 1;
+    size_t index = hash & mask;
+
+    while (heap.interned[index]) {
+        hyprt_string_t* candidate = heap.interned[index];
+        if (candidate->hash == hash && candidate->length == length &&
+            memcmp(candidate->data, data, length) == 0) {
+            break;
+        }
+        index = (index + 1) & mask;
+    }
+
+    return &heap.interned[index];
+}
+
+static void intern_grow(void) {
+    hyprt_string_t** old = heap.interned;
+    size_t old_capacity = heap.interned_capacity;
+
+    heap.interned_capacity = old_capacity ? old_capacity * 2 : 64;
+    heap.interned = checked_realloc(NULL, heap.interned_capacity * sizeof(hyprt_string_t*));
+    memset(heap.interned, 0, heap.interned_capacity * sizeof(hyprt_string_t*));
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i]) {
+            *intern_find_slot(old[i]->data, old[i]->length, old[i]->hash) = old[i];
+        }
+    }
+    free(old);
+}
+
+static hyprt_string_t* intern_lookup(const char* data, size_t length, uint32_t hash) {
+    if (heap.interned_count == 0) return NULL;
+    return *intern_find_slot(data, length, hash);
+}
+
+hyprt_value_t hyprt_string_literal(const char* data, size_t length) {
+    if ((heap.interned_count + 1) * 2 > heap.interned_capacity) {
+        intern_grow();
+    }
+
+    uint32_t hash = hash_bytes(data, length);
+    hyprt_string_t** slot = intern_find_slot(data, length, hash);
+    if (!*slot) {
+        hyprt_string_t* string = string_allocate(data, length, hash);
+        string->interned = true;
+        string->gc.pinned = 1;
+        *slot = string;
+        heap.interned_count++;
+    }
+
+    return hyprt_ref(HYPRT_STRING, *slot);
+}
+
+/* buffer holds at least HYP_NUMBER_BUFFER_SIZE bytes */
+static int format_number(char* buffer, double number) {
+    return (int)hyp_number_format(number, buffer);
+}
+
+hyprt_value_t hyprt_to_string(hyprt_value_t value) {
+    char buffer[64];
+    const char* text;
+
+    switch (value.type) {
+        case HYPRT_STRING:
+            return value;
+        case HYPRT_NULL:
+            text = "null";
+            break;
+        case HYPRT_BOOLEAN:
+            text = value.as.boolean ? "true" : "false";
+            break;
+        case HYPRT_NUMBER:
+            format_number(buffer, value.as.number);
+            text = buffer;
+            break;
+        case HYPRT_ARRAY:
+            text = "[Array]";
+            break;
+        case HYPRT_OBJECT:
+            text = "[Object]";
+            break;
+        default:
+            text = "[Unknown]";
+            break;
+    }
+
+    return hyprt_string_new(text, strlen(text));
+}
+
+static hyprt_value_t concat(hyprt_value_t left, hyprt_value_t right) {
+    hyprt_string_t* a = hyprt_to_string(left).as.string;
+    hyprt_string_t* b = hyprt_to_string(right).as.string;
+    size_t length = a->length + b->length;
+
+    hyprt_string_t* result = gc_allocate(sizeof(hyprt_string_t) + length + 1, HYPRT_STRING);
+    memcpy(result->data, a->data, a->length);
+    memcpy(result->data + a->length, b->data, b->length);
+    result->data[length] = '\0';
+    result->length = length;
+    result->hash = hash_bytes(result->data, length);
+    result->interned = false;
+
+    return hyprt_ref(HYPRT_STRING, result);
+}
+
+/* Operators */
+bool hyprt_equals(hyprt_value_t left, hyprt_value_t right) {
+    if (left.type != right.type) return false;
+
+    switch (left.type) {
+        case HYPRT_NULL: return true;
+        case HYPRT_BOOLEAN: return left.as.boolean == right.as.boolean;
+        case HYPRT_NUMBER: return left.as.number == right.as.number;
+        case HYPRT_STRING:
+            return left.as.string == right.as.string ||
+                   (left.as.string->length == right.as.string->length &&
+                    left.as.string->hash == right.as.string->hash &&
+                    memcmp(left.as.string->data, right.as.string->data, left.as.string->length) == 0);
+        default:
+            return left.as.ref == right.as.ref;
+    }
+}
+
+/* Bitwise operators work on 32-bit integers, wrapping as the interpreter does */
+static int32_t to_int32(double number) {
+    if (!isfinite(number)) return 0;
+    double wrapped = fmod(trunc(number), 4294967296.0);
+    if (wrapped < 0) wrapped += 4294967296.0;
+    return (int32_t)(uint32_t)wrapped;
+}
+
+hyprt_value_t hyprt_binary_slow(hyprt_op_t op, hyprt_value_t left, hyprt_value_t right) {
+    if (op == HYPRT_OP_ADD && (left.type == HYPRT_STRING || right.type == HYPRT_STRING)) {
+        return concat(left, right);
+    }
+
+    if (!HYPRT_BOTH_NUMBERS(left, right)) {
+        hyprt_panic("Invalid operands for binary operator");
+    }
+
+    double a = left.as.number;
+    double b = right.as.number;
+
+    switch (op) {
+        case HYPRT_OP_ADD: return hyprt_number(a + b);
+        case HYPRT_OP_SUB: return hyprt_number(a - b);
+        case HYPRT_OP_MUL: return hyprt_number(a * b);
+        case HYPRT_OP_DIV:
+            if (b == 0.0) hyprt_panic("Division by zero");
+            return hyprt_number(a / b);
+        case HYPRT_OP_MOD:
+            if (b == 0.0) hyprt_panic("Division by zero");
+            return hyprt_number(fmod(a, b));
+        case HYPRT_OP_LT: return hyprt_boolean(a < b);
+        case HYPRT_OP_LE: return hyprt_boolean(a <= b);
+        case HYPRT_OP_GT: return hyprt_boolean(a > b);
+        case HYPRT_OP_GE: return hyprt_boolean(a >= b);
+        case HYPRT_OP_POW: return hyprt_number(pow(a, b));
+        case HYPRT_OP_BITWISE_AND: return hyprt_number(to_int32(a) & to_int32(b));
+        case HYPRT_OP_BITWISE_OR: return hyprt_number(to_int32(a) | to_int32(b));
+        case HYPRT_OP_BITWISE_XOR: return hyprt_number(to_int32(a) ^ to_int32(b));
+        case HYPRT_OP_LEFT_SHIFT:
+            return hyprt_number((int32_t)((uint32_t)to_int32(a) << (to_int32(b) & 31)));
+        case HYPRT_OP_RIGHT_SHIFT: {
+            /* Arithmetic shift, without relying on >> of a negative int */
+            int32_t value = to_int32(a);
+            int shift = to_int32(b) & 31;
+            return hyprt_number(value >= 0 ? value >> shift : ~(~value >> shift));
+        }
+    }
+
+    hyprt_panic("Unknown binary operator: %d", (int)op);
+}
+
+hyprt_value_t hyprt_unary_slow(char op, hyprt_value_t operand) {
+    if (op == '~' && operand.type == HYPRT_NUMBER) {
+        return hyprt_number(~to_int32(operand.as.number));
+    }
+    hyprt_panic("Invalid operand for unary operator '%c'", op);
+}
+
+/* Arrays */
+static void array_reserve(hyprt_array_t* array, size_t capacity) {
+    if (capacity <= array->capacity) return;
+
+    size_t new_capacity = array->capacity ? array->capacity * 2 : 8;
+    if (new_capacity < capacity) new_capacity = capacity;
+
+    array->items = checked_realloc(array->items, new_capacity * sizeof(hyprt_value_t));
+    heap.bytes_allocated += (new_capacity - array->capacity) * sizeof(hyprt_value_t);
+    array->capacity = new_capacity;
+}
+
+hyprt_value_t hyprt_array_of(size_t count, const hyprt_value_t* items) {
+    hyprt_array_t* array = gc_allocate(sizeof(hyprt_array_t), HYPRT_ARRAY);
+    array->count = 0;
+    array->capacity = 0;
+    array->items = NULL;
+
+    array_reserve(array, count);
+    if (count > 0) memcpy(array->items, items, count * sizeof(hyprt_value_t));
+    array->count = count;
+
+    return hyprt_ref(HYPRT_ARRAY, array);
+}
+
+void hyprt_array_push(hyprt_value_t value, hyprt_value_t item) {
+    if (value.type != HYPRT_ARRAY) hyprt_panic("push expects an array");
+
+    hyprt_array_t* array = value.as.array;
+    array_reserve(array, array->count + 1);
+    array->items[array->count++] = item;
+}
+
+/* Shapes */
+static hyprt_shape_t* shape_transition(hyprt_shape_t* shape, hyprt_string_t* key) {
+    for (size_t i = 0; i < shape->transition_count; i++) {
+        if (shape->transitions[i]->key == key) {
+            return shape->transitions[i];
+        }
+    }
+
+    hyprt_shape_t* child = checked_realloc(NULL, sizeof(hyprt_shape_t));
+    memset(child, 0, sizeof(hyprt_shape_t));
+    child->parent = shape;
+    child->key = key;
+    child->count = shape->count + 1;
+
+    if (shape->transition_count == shape->transition_capacity) {
+        shape->transition_capacity = shape->transition_capacity ? shape->transition_capacity * 2 : 4;
+        shape->transitions = checked_realloc(shape->transitions,
+                                             shape->transition_capacity * sizeof(hyprt_shape_t*));
+    }
+    shape->transitions[shape->transition_count++] = child;
+
+    return child;
+}
+
+/* Returns the slot index of key, or -1 */
+static long shape_lookup(hyprt_shape_t* shape, hyprt_string_t* key) {
+    for (; shape->key; shape = shape->parent) {
+        if (shape->key == key) {
+            return (long)shape->count - 1;
+        }
+    }
+    return -1;
+}
+
+/* Map any string to its interned copy (NULL if it was never interned) */
+static hyprt_string_t* key_for(hyprt_value_t key, bool create) {
+    if (key.type != HYPRT_STRING) {
+        hyprt_panic("Object keys must be strings");
+    }
+
+    hyprt_string_t* string = key.as.string;
+    if (string->interned) return string;
+    if (create) return hyprt_string_literal(string->data, string->length).as.string;
+    return intern_lookup(string->data, string->length, string->hash);
+}
+
+hyprt_value_t hyprt_object_of(size_t count, const hyprt_value_t* keys, const hyprt_value_t* values) {
+    hyprt_object_t* object = gc_allocate(sizeof(hyprt_object_t), HYPRT_OBJECT);
+    object->shape = &heap.root_shape;
+    object->slots = NULL;
+    object->capacity = 0;
+
+    hyprt_value_t result = hyprt_ref(HYPRT_OBJECT, object);
+    for (size_t i = 0; i < count; i++) {
+        hyprt_set_member(result, keys[i], values[i]);
+    }
+
+    return result;
+}
+
+hyprt_value_t hyprt_get_member(hyprt_value_t value, hyprt_value_t key) {
+    if (value.type != HYPRT_OBJECT) {
+        hyprt_panic("Cannot read property of non-object");
+    }
+
+    hyprt_string_t* interned = key_for(key, false);
+    if (!interned) return hyprt_null();
+
+    hyprt_object_t* object = value.as.object;
+    long index = shape_lookup(object->shape, interned);
+    return index >= 0 ? object->slots[index] : hyprt_null();
+}
+
+hyprt_value_t hyprt_set_member(hyprt_value_t value, hyprt_value_t key, hyprt_value_t item) {
+    if (value.type != HYPRT_OBJECT) {
+        hyprt_panic("Cannot set property of non-object");
+    }
+
+    hyprt_string_t* interned = key_for(key, true);
+    hyprt_object_t* object = value.as.object;
+
+    long index = shape_lookup(object->shape, interned);
+    if (index < 0) {
+        object->shape = shape_transition(object->shape, interned);
+        index = (long)object->shape->count - 1;
+
+        if (object->shape->count > object->capacity) {
+            size_t new_capacity = object->capacity ? object->capacity * 2 : 4;
+            object->slots = checked_realloc(object->slots, new_capacity * sizeof(hyprt_value_t));
+            heap.bytes_allocated += (new_capacity - object->capacity) * sizeof(hyprt_value_t);
+            object->capacity = new_capacity;
+        }
+    }
+
+    object->slots[index] = item;
+    return item;
+}
+
+/* Indexing */
+static size_t array_index(hyprt_value_t index) {
+    if (index.type != HYPRT_NUMBER || index.as.number < 0 ||
+        index.as.number != floor(index.as.number)) {
+        hyprt_panic("Array index must be a non-negative integer");
+    }
+    return (size_t)index.as.number;
+}
+
+hyprt_value_t hyprt_get_index(hyprt_value_t value, hyprt_value_t index) {
+    switch (value.type) {
+        case HYPRT_ARRAY: {
+            size_t i = array_index(index);
+            return i < value.as.array->count ? value.as.array->items[i] : hyprt_null();
+        }
+        case HYPRT_STRING: {
+            size_t i = array_index(index);
+            if (i >= value.as.string->length) return hyprt_null();
+            return hyprt_string_new(value.as.string->data + i, 1);
+        }
+        case HYPRT_OBJECT:
+            return hyprt_get_member(value, index);
+        default:
+            hyprt_panic("Value is not indexable");
+    }
+}
+
+hyprt_value_t hyprt_set_index(hyprt_value_t value, hyprt_value_t index, hyprt_value_t item) {
+    switch (value.type) {
+        case HYPRT_ARRAY: {
+            hyprt_array_t* array = value.as.array;
+            size_t i = array_index(index);
+            if (i == array->count) {
+                hyprt_array_push(value, item);
+            } else if (i < array->count) {
+                array->items[i] = item;
+            } else {
+                hyprt_panic("Array index %zu out of bounds (length %zu)", i, array->count);
+            }
+            return item;
+        }
+        case HYPRT_OBJECT:
+            return hyprt_set_member(value, index, item);
+        default:
+            hyprt_panic("Value does not support index assignment");
+    }
+}
+
+/* Garbage collection */
+void hyprt_gc_root(hyprt_value_t* slot) {
+    if (heap.root_count == heap.root_capacity) {
+        heap.root_capacity = heap.root_capacity ? heap.root_capacity * 2 : 16;
+        heap.roots = checked_realloc(heap.roots, heap.root_capacity * sizeof(hyprt_value_t*));
+    }
+    heap.roots[heap.root_count++] = slot;
+}
+
+static void mark_value(hyprt_value_t value) {
+    if (value.type < HYPRT_STRING || !value.as.ref) return;
+
+    hyprt_gc_header_t* header = value.as.ref;
+    if (header->marked) return;
+    header->marked = 1;
+
+    /* Strings have no children; containers are traced from the gray stack */
+    if (header->type == HYPRT_STRING) return;
+
+    if (heap.gray_count == heap.gray_capacity) {
+        heap.gray_capacity = heap.gray_capacity ? heap.gray_capacity * 2 : 64;
+        heap.gray = checked_realloc(heap.gray, heap.gray_capacity * sizeof(hyprt_gc_header_t*));
+    }
+    heap.gray[heap.gray_count++] = header;
+}
+
+static void trace_references(void) {
+    while (heap.gray_count > 0) {
+        hyprt_gc_header_t* header = heap.gray[--heap.gray_count];
+
+        if (header->type == HYPRT_ARRAY) {
+            hyprt_array_t* array = (hyprt_array_t*)header;
+            for (size_t i = 0; i < array->count; i++) {
+                mark_value(array->items[i]);
+            }
+        } else if (header->type == HYPRT_OBJECT) {
+            hyprt_object_t* object = (hyprt_object_t*)header;
+            for (size_t i = 0; i < object->shape->count; i++) {
+                mark_value(object->slots[i]);
+            }
+        }
+    }
+}
+
+static size_t object_size(hyprt_gc_header_t* header) {
+    switch (header->type) {
+        case HYPRT_STRING:
+            return sizeof(hyprt_string_t) + ((hyprt_string_t*)header)->length + 1;
+        case HYPRT_ARRAY:
+            return sizeof(hyprt_array_t) + ((hyprt_array_t*)header)->capacity * sizeof(hyprt_value_t);
+        case HYPRT_OBJECT:
+            return sizeof(hyprt_object_t) + ((hyprt_object_t*)header)->capacity * sizeof(hyprt_value_t);
+        default:
+            return 0;
+    }
+}
+
+static void free_object(hyprt_gc_header_t* header) {
+    heap.bytes_allocated -= object_size(header);
+    heap.object_count--;
+
+    if (header->type == HYPRT_ARRAY) {
+        free(((hyprt_array_t*)header)->items);
+    } else if (header->type == HYPRT_OBJECT) {
+        free(((hyprt_object_t*)header)->slots);
+    }
+    free(header);
+}
+
+static int compare_addresses(const void* a, const void* b) {
+    uintptr_t x = *(const uintptr_t*)a;
+    uintptr_t y = *(const uintptr_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Treat every aligned word on the C stack that equals an object address
+ * as a reference. The scan reads whole frames, redzones included, so a
+ * runtime built with AddressSanitizer must not check it. */
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline, no_sanitize_address))
+#endif
+static void scan_stack(void) {
+    size_t count = heap.object_count;
+    uintptr_t* addresses = checked_realloc(NULL, (count ? count : 1) * sizeof(uintptr_t));
+
+    size_t n = 0;
+    for (hyprt_gc_header_t* header = heap.objects; header; header = header->next) {
+        addresses[n++] = (uintptr_t)header;
+    }
+    qsort(addresses, n, sizeof(uintptr_t), compare_addresses);
+
+    volatile uintptr_t marker = 0;
+    uintptr_t low = (uintptr_t)&marker;
+    uintptr_t high = (uintptr_t)heap.stack_base;
+    if (low > high) {
+        uintptr_t swap = low;
+        low = high;
+        high = swap;
+    }
+
+    low &= ~(uintptr_t)(sizeof(uintptr_t) - 1);
+    for (uintptr_t cursor = low; cursor < high; cursor += sizeof(uintptr_t)) {
+        uintptr_t word = *(uintptr_t*)cursor;
+        if (bsearch(&word, addresses, n, sizeof(uintptr_t), compare_addresses)) {
+            hyprt_value_t value = hyprt_ref((hyprt_type_t)((hyprt_gc_header_t*)word)->type, (void*)word);
+            mark_value(value);
+        }
+    }
+
+    free(addresses);
+}
+
+void hyprt_gc_collect(void) {
+    hyprt_gc_requested = false;
+    if (!heap.stack_base) return;
+
+    uint64_t started = monotonic_ns();
+    size_t bytes_before = heap.bytes_allocated;
+
+    /* Spill callee-saved registers onto the stack so the scan sees them */
+    jmp_buf registers;
+    setjmp(registers);
+
+    for (size_t i = 0; i < heap.root_count; i++) {
+        mark_value(*heap.roots[i]);
+    }
+    scan_stack();
+    trace_references();
+
+    hyprt_gc_header_t** link = &heap.objects;
+    while (*link) {
+        hyprt_gc_header_t* header = *link;
+        if (header->marked || header->pinned) {
+            header->marked = 0;
+            link = &header->next;
+        } else {
+            *link = header->next;
+            free_object(header);
+        }
+    }
+
+    heap.next_gc = heap.bytes_allocated * 2;
+    if (heap.next_gc < HYPRT_INITIAL_GC_THRESHOLD) {
+        heap.next_gc = HYPRT_INITIAL_GC_THRESHOLD;
+    }
+
+    heap.collections++;
+    heap.freed_bytes += bytes_before - heap.bytes_allocated;
+    if (heap.stats_path) {
+        if (heap.pause_count == heap.pause_capacity) {
+            heap.pause_capacity = heap.pause_capacity ? heap.pause_capacity * 2 : 16;
+            heap.pauses = checked_realloc(heap.pauses, heap.pause_capacity * sizeof(uint64_t));
+        }
+        heap.pauses[heap.pause_count++] = monotonic_ns() - started;
+    }
+}
+
+/* Builtins */
+static void print_value(hyprt_value_t value) {
+    char buffer[64];
+
+    switch (value.type) {
+        case HYPRT_STRING:
+            fwrite(value.as.string->data, 1, value.as.string->length, stdout);
+            break;
+        case HYPRT_NUMBER: {
+            int length = format_number(buffer, value.as.number);
+            fwrite(buffer, 1, (size_t)length, stdout);
+            break;
+        }
+        default: {
+            hyprt_string_t* string = hyprt_to_string(value).as.string;
+            fwrite(string->data, 1, string->length, stdout);
+            break;
+        }
+    }
+}
+
+hyprt_value_t hyprt_builtin_print(const hyprt_value_t* args, size_t arg_count) {
+    for (size_t i = 0; i < arg_count; i++) {
+        if (i > 0) fputc(' ', stdout);
+        print_value(args[i]);
+    }
+    fputc('\n', stdout);
+    return hyprt_null();
+}
+
+hyprt_value_t hyprt_builtin_typeof(const hyprt_value_t* args, size_t arg_count) {
+    if (arg_count != 1) hyprt_panic("typeof expects exactly 1 argument");
+
+    static const char* names[] = { "null", "boolean", "number", "string", "array", "object" };
+    const char* name = args[0].type <= HYPRT_OBJECT ? names[args[0].type] : "unknown";
+    return hyprt_string_literal(name, strlen(name));
+}
+
+hyprt_value_t hyprt_builtin_parse_number(const hyprt_value_t* args, size_t arg_count) {
+    if (arg_count != 1) hyprt_panic("parseNumber expects exactly 1 argument");
+    if (args[0].type == HYPRT_NUMBER) return args[0];
+    if (args[0].type != HYPRT_STRING) hyprt_panic("parseNumber can only be called on strings or numbers");
+
+    const char* text = args[0].as.string->data;
+    size_t length = args[0].as.string->length;
+    while (length > 0 && (*text == ' ' || *text == '\t' || *text == '\n' || *text == '\r')) {
+        text++;
+        length--;
+    }
+    while (length > 0 && (text[length - 1] == ' ' || text[length - 1] == '\t' ||
+                          text[length - 1] == '\n' || text[length - 1] == '\r')) {
+        length--;
+    }
+
+    double value;
+    if (length == 0 || hyp_number_parse(text, length, &value) != length) {
+        value = NAN;
+    }
+    return hyprt_number(value);
+}
+
+hyprt_value_t hyprt_builtin_len(const hyprt_value_t* args, size_t arg_count) {
+    if (arg_count != 1) hyprt_panic("len expects exactly 1 argument");
+
+    switch (args[0].type) {
+        case HYPRT_STRING: return hyprt_number((double)args[0].as.string->length);
+        case HYPRT_ARRAY: return hyprt_number((double)args[0].as.array->count);
+        case HYPRT_OBJECT: return hyprt_number((double)args[0].as.object->shape->count);
+        default:
+            hyprt_panic("len can only be called on strings, arrays, or objects");
+    }
+}
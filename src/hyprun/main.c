@@ -8,7 +8,12 @@
 #include "../../include/hyp_runtime.h"
 #include "../../include/lexer.h"
 #include "../../include/parser.h"
+#include "../../include/ast_cache.h"
 #include "../../include/hyp_common.h"
+#include "../../include/aot.h"
+#include "../../include/profile.h"
+#include "../../include/hyp_thread.h"
+#include "../../include/hyp_metrics.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -24,7 +29,17 @@ typedef struct {
     bool show_version;
     bool interpret_mode;
     bool bytecode_mode;
+    bool aot_mode;
     char* module_path;
+    char* profile_file;          /* --write-profile output */
+    bool alloc_bench;
+    bool container_bench;
+    bool stats;
+    const char* stats_format;    /* --stats=<format>; NULL for text */
+    
+    /* Arguments after "--" are passed to the program */
+    int program_argc;
+    char** program_argv;
 } hyprun_options_t;
 
 /* Print usage information */
@@ -34,6 +49,14 @@ static void print_usage(const char* program_name) {
     printf("Options:\n");
     printf("  -i, --interpret         Interpret source code directly\n");
     printf("  -b, --bytecode          Execute bytecode file\n");
+    printf("      --aot               Build a cached native binary and run it\n");
+    printf("      --write-profile=<file>\n");
+    printf("                          Interpret and record an execution profile for hypc\n");
+    printf("      --alloc-bench       Interpret, then report how the runtime's object pools\n");
+    printf("                          were used and compare their speed with the heap\n");
+    printf("      --container-bench   Time the hash map, small vector and deque against\n");
+    printf("                          the linear tables they replace (no input file)\n");
+    printf("      --stats[=json]      Print metrics to stderr on exit\n");
     printf("  -m, --module-path <dir> Add module search path\n");
     printf("  -v, --verbose           Verbose output\n");
     printf("  -d, --debug             Debug mode\n");
@@ -43,9 +66,12 @@ static void print_usage(const char* program_name) {
     printf("  .hxp                    Hyper source code (requires --interpret)\n");
     printf("  .hyb                    Hyper bytecode\n");
     printf("  .c                      Transpiled C code (compile and run)\n\n");
+    printf("Arguments after -- are passed to the program (native modes only).\n\n");
     printf("Examples:\n");
     printf("  %s program.hyb\n", program_name);
     printf("  %s --interpret src/main.hxp\n", program_name);
+    printf("  %s app.hxp --aot -- arg1 arg2\n", program_name);
+    printf("  %s --write-profile=app.hprof app.hxp\n", program_name);
     printf("  %s --debug --verbose app.hyb\n", program_name);
 }
 
@@ -97,6 +123,33 @@ static bool parse_arguments(int argc, char* argv[], hyprun_options_t* options) {
             options->interpret_mode = true;
         } else if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--bytecode") == 0) {
             options->bytecode_mode = true;
+        } else if (strcmp(argv[i], "--aot") == 0) {
+            options->aot_mode = true;
+        } else if (strncmp(argv[i], "--write-profile=", 16) == 0) {
+            options->profile_file = argv[i] + 16;
+            options->interpret_mode = true;
+        } else if (strcmp(argv[i], "--write-profile") == 0) {
+            if (i + 1 < argc) {
+                options->profile_file = argv[++i];
+                options->interpret_mode = true;
+            } else {
+                fprintf(stderr, "Error: --write-profile requires a file name\n");
+                return false;
+            }
+        } else if (strcmp(argv[i], "--alloc-bench") == 0) {
+            options->alloc_bench = true;
+            options->interpret_mode = true;
+        } else if (strcmp(argv[i], "--container-bench") == 0) {
+            options->container_bench = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            options->stats = true;
+        } else if (strncmp(argv[i], "--stats=", 8) == 0) {
+            options->stats = true;
+            options->stats_format = argv[i] + 8;
+        } else if (strcmp(argv[i], "--") == 0) {
+            options->program_argc = argc - i - 1;
+            options->program_argv = argv + i + 1;
+            break;
         } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
             options->verbose = true;
         } else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--debug") == 0) {
@@ -123,7 +176,8 @@ static bool parse_arguments(int argc, char* argv[], hyprun_options_t* options) {
     }
     
     /* Check if input file is required */
-    if (!options->input_file && !options->show_help && !options->show_version) {
+    if (!options->input_file && !options->show_help && !options->show_version &&
+        !options->container_bench) {
         fprintf(stderr, "Error: No input file specified\n");
         return false;
     }
@@ -131,6 +185,215 @@ static bool parse_arguments(int argc, char* argv[], hyprun_options_t* options) {
     return true;
 }
 
+/* --alloc-bench: allocation churn through a pool and through the heap,
+ * replacing a pseudo-random one of BENCH_WINDOW live blocks each time */
+#define BENCH_ALLOCATIONS 4000000
+#define BENCH_WINDOW 1024
+
+static double bench_churn(hyp_pool_t* pool, size_t size) {
+    void* window[BENCH_WINDOW] = { 0 };
+    uint32_t state = 1;
+    
+    double start = hyp_wall_time();
+    for (size_t i = 0; i < BENCH_ALLOCATIONS; i++) {
+        state = state * 1664525u + 1013904223u;
+        size_t slot = state >> 22;
+        if (pool) {
+            hyp_pool_free(pool, window[slot]);
+            window[slot] = hyp_pool_alloc(pool);
+        } else {
+            HYP_FREE(window[slot]);
+            window[slot] = HYP_MALLOC(size);
+        }
+        if (window[slot]) *(volatile char*)window[slot] = 0;
+    }
+    double elapsed = hyp_wall_time() - start;
+    
+    for (size_t i = 0; i < BENCH_WINDOW; i++) {
+        if (pool) {
+            hyp_pool_free(pool, window[i]);
+        } else {
+            HYP_FREE(window[i]);
+        }
+    }
+    return elapsed;
+}
+
+static void print_pool_stats(const char* name, const hyp_pool_stats_t* stats) {
+    double used = stats->reserved ? 100.0 * stats->peak * stats->block_size / stats->reserved : 0.0;
+    printf("  %-13s %5zu %11zu %9zu %8zu %6zu %9.1f %8.1f%%\n", name, stats->block_size,
+           stats->allocations, stats->peak, stats->live, stats->slabs,
+           stats->reserved / 1024.0, used);
+}
+
+static void report_allocation(double seconds) {
+    hyp_runtime_pool_stats_t stats;
+    hyp_runtime_pool_stats(&stats);
+    
+    printf("\nExecution: %.2f ms\n", seconds * 1000.0);
+    printf("  %-13s %5s %11s %9s %8s %6s %9s %9s\n", "pool", "block", "allocations",
+           "peak live", "live", "slabs", "slab KB", "at peak");
+    print_pool_stats("objects", &stats.objects);
+    print_pool_stats("environments", &stats.environments);
+    print_pool_stats("functions", &stats.functions);
+    
+    hyp_pool_t pool;
+    hyp_pool_init(&pool, sizeof(hyp_environment_t));
+    double pooled = bench_churn(&pool, sizeof(hyp_environment_t));
+    hyp_pool_destroy(&pool);
+    double heap = bench_churn(NULL, sizeof(hyp_environment_t));
+    
+    printf("\nChurn of %d environment headers, %d live:\n", BENCH_ALLOCATIONS, BENCH_WINDOW);
+    printf("  pool            %8.1f M/s\n", BENCH_ALLOCATIONS / pooled / 1e6);
+    printf("  heap (%-8s) %8.1f M/s\n", hyp_mem_allocator()->name, BENCH_ALLOCATIONS / heap / 1e6);
+}
+
+/* --container-bench: each container against the hand-rolled table it
+ * replaced, on the same work */
+#define BENCH_NAME_LENGTH sizeof("name_18446744073709551615")  /* Any size_t */
+#define BENCH_SCOPES 2000000
+#define BENCH_BINDINGS 3
+#define BENCH_QUEUE_OPS 4000000
+#define BENCH_QUEUE_LIMIT 32
+
+static volatile size_t bench_sink;
+static void* volatile bench_escape;     /* Keeps the compiler from eliding the work */
+
+static void print_rates(const char* label, size_t operations, const double times[2]) {
+    printf("  %-20s %9.1f %9.1f  M/s\n", label,
+           times[0] > 0.0 ? operations / times[0] / 1e6 : 0.0,
+           times[1] > 0.0 ? operations / times[1] / 1e6 : 0.0);
+}
+
+/* Name lookups in a table of `count` names: linear strcmp scan, as the
+ * symbol and environment tables did, against HYP_MAP */
+static void bench_lookups(size_t count) {
+    char* text = HYP_MALLOC(count * BENCH_NAME_LENGTH);
+    const char** names = HYP_MALLOC(count * sizeof(char*));
+    HYP_MAP(size_t) map;
+    HYP_MAP_INIT(&map);
+    if (!text || !names) {
+        HYP_FREE(text);
+        HYP_FREE(names);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        snprintf(text + i * BENCH_NAME_LENGTH, BENCH_NAME_LENGTH, "name_%zu", i);
+        names[i] = text + i * BENCH_NAME_LENGTH;
+        HYP_MAP_PUT(&map, names[i], i);
+    }
+    
+    /* Enough lookups for the linear scan to take a measurable time */
+    size_t lookups = 8000000 / count;
+    if (lookups < 100000) lookups = 100000;
+    
+    double times[2];
+    for (int hashed = 0; hashed < 2; hashed++) {
+        uint32_t state = 1;
+        size_t found = 0;
+        double start = hyp_wall_time();
+        for (size_t i = 0; i < lookups; i++) {
+            state = state * 1664525u + 1013904223u;
+            const char* name = names[state % count];
+            if (hashed) {
+                size_t slot = HYP_MAP_FIND(&map, name);
+                if (slot != HYP_MAP_NONE) found += HYP_MAP_VALUE(&map, slot);
+            } else {
+                for (size_t k = 0; k < count; k++) {
+                    if (strcmp(names[k], name) == 0) {
+                        found += k;
+                        break;
+                    }
+                }
+            }
+        }
+        times[hashed] = hyp_wall_time() - start;
+        bench_sink = found;
+    }
+    
+    char label[sizeof("lookup, 18446744073709551615 names")];
+    snprintf(label, sizeof(label), "lookup, %zu names", count);
+    print_rates(label, lookups, times);
+    
+    HYP_MAP_FREE(&map);
+    HYP_FREE(names);
+    HYP_FREE(text);
+}
+
+/* Scopes binding a few variables: HYP_ARRAY against HYP_SMALL_VECTOR */
+static void bench_scopes(void) {
+    double times[2];
+    for (int small = 0; small < 2; small++) {
+        size_t total = 0;
+        double start = hyp_wall_time();
+        for (size_t i = 0; i < BENCH_SCOPES; i++) {
+            hyp_binding_t binding = { NULL, hyp_value_number((double)i) };
+            if (small) {
+                HYP_SMALL_VECTOR(hyp_binding_t, HYP_ENVIRONMENT_INLINE) vars;
+                HYP_SMALL_VECTOR_INIT(&vars);
+                for (size_t k = 0; k < BENCH_BINDINGS; k++) HYP_SMALL_VECTOR_PUSH(&vars, binding);
+                bench_escape = vars.data;
+                total += vars.count;
+                HYP_SMALL_VECTOR_FREE(&vars);
+            } else {
+                HYP_ARRAY(hyp_binding_t) vars;
+                HYP_ARRAY_INIT(&vars);
+                for (size_t k = 0; k < BENCH_BINDINGS; k++) HYP_ARRAY_PUSH(&vars, binding);
+                bench_escape = vars.data;
+                total += vars.count;
+                HYP_ARRAY_FREE(&vars);
+            }
+        }
+        times[small] = hyp_wall_time() - start;
+        bench_sink = total;
+    }
+    
+    print_rates("scope of 3 names", BENCH_SCOPES, times);
+}
+
+/* A bounded history: an array shifted down when full, against HYP_DEQUE */
+static void bench_history(void) {
+    double times[2];
+    for (int ring = 0; ring < 2; ring++) {
+        HYP_ARRAY(size_t) array;
+        HYP_ARRAY_INIT(&array);
+        HYP_DEQUE(size_t) deque;
+        HYP_DEQUE_INIT(&deque);
+        
+        double start = hyp_wall_time();
+        for (size_t i = 0; i < BENCH_QUEUE_OPS; i++) {
+            if (ring) {
+                if (deque.count >= BENCH_QUEUE_LIMIT) HYP_DEQUE_POP_FRONT(&deque);
+                HYP_DEQUE_PUSH_BACK(&deque, i);
+            } else {
+                if (array.count >= BENCH_QUEUE_LIMIT) {
+                    memmove(array.data, array.data + 1, (array.count - 1) * sizeof(size_t));
+                    array.count--;
+                }
+                HYP_ARRAY_PUSH(&array, i);
+            }
+        }
+        times[ring] = hyp_wall_time() - start;
+        bench_sink = ring ? HYP_DEQUE_FRONT(&deque) : array.data[0];
+        
+        HYP_ARRAY_FREE(&array);
+        HYP_DEQUE_FREE(&deque);
+    }
+    
+    print_rates("history of 32 runs", BENCH_QUEUE_OPS, times);
+}
+
+static int bench_containers(void) {
+    printf("Containers (heap: %s)\n", hyp_mem_allocator()->name);
+    printf("  %-20s %9s %9s\n", "", "linear", "container");
+    bench_lookups(8);
+    bench_lookups(64);
+    bench_lookups(1024);
+    bench_scopes();
+    bench_history();
+    return 0;
+}
+
 /* Execute Hyper source code by interpreting */
 static int execute_source_code(hyprun_options_t* options) {
     if (options->verbose) {
@@ -142,16 +405,15 @@ static int execute_source_code(hyprun_options_t* options) {
         printf("Reading file: %s\n", options->input_file);
     }
     
-    size_t source_size;
-    char* source = hyp_read_file(options->input_file, &source_size);
-    if (!source) {
+    hyp_source_t source;
+    if (hyp_source_load(&source, options->input_file) != HYP_OK) {
         fprintf(stderr, "Error: Could not read file %s\n", options->input_file);
         return 1;
     }
     
     if (options->verbose) {
-        printf("File read successfully, length: %zu\n", source_size);
-        printf("First 100 characters: %.100s\n", source);
+        printf("File read successfully, length: %zu\n", source.size);
+        printf("First 100 characters: %.100s\n", source.data);
     }
     
     /* Create lexer */
@@ -159,10 +421,10 @@ static int execute_source_code(hyprun_options_t* options) {
         printf("Creating lexer...\n");
     }
     
-    hyp_lexer_t* lexer = hyp_lexer_create(source, options->input_file);
+    hyp_lexer_t* lexer = hyp_lexer_create_with_length(source.data, source.size, options->input_file);
     if (!lexer) {
         fprintf(stderr, "Error: Could not create lexer\n");
-        HYP_FREE(source);
+        hyp_source_release(&source);
         return 1;
     }
     
@@ -170,42 +432,29 @@ static int execute_source_code(hyprun_options_t* options) {
         printf("Lexer created successfully\n");
     }
     
-    /* Create parser */
-    if (options->verbose) {
-        printf("Creating parser...\n");
-    }
-    
-    hyp_parser_t* parser = hyp_parser_create(lexer);
-    if (!parser) {
-        fprintf(stderr, "Error: Could not create parser\n");
-        hyp_lexer_destroy(lexer);
-        HYP_FREE(source);
-        return 1;
-    }
-    
-    if (options->verbose) {
-        printf("Parser created successfully\n");
-    }
-    
-    /* Parse source */
+    /* Parse source, or map the tree cached by an earlier run */
     if (options->verbose) {
         printf("Starting to parse source code...\n");
     }
     
-    hyp_ast_node_t* ast = hyp_parser_parse(parser);
-    if (!ast || parser->had_error) {
-        fprintf(stderr, "Error: Parsing failed\n");
-        hyp_parser_destroy(parser);
+    hyp_ast_cache_t ast_cache;
+    hyp_ast_cache_init(&ast_cache);
+    
+    hyp_ast_image_t image;
+    hyp_error_t parsed = hyp_ast_cache_parse(&ast_cache, lexer, source.data, source.size, &image);
+    if (parsed != HYP_OK) {
+        fprintf(stderr, parsed == HYP_ERROR_SYNTAX ? "Error: Parsing failed\n" : "Error: Could not create parser\n");
         hyp_lexer_destroy(lexer);
-        HYP_FREE(source);
+        hyp_source_release(&source);
         return 1;
     }
+    hyp_ast_node_t* ast = image.root;
     
     if (options->verbose) {
-        printf("Parsing completed successfully\n");
+        printf("Parsing completed successfully%s\n", image.from_cache ? " (cached)" : "");
         printf("AST root type: %d\n", ast->type);
         if (ast->type == AST_PROGRAM) {
-            printf("Program has %zu statements\n", ast->program.statements.count);
+            printf("Program has %u statements\n", ast->program.statements.count);
         }
     }
     
@@ -213,36 +462,78 @@ static int execute_source_code(hyprun_options_t* options) {
     hyp_runtime_t* runtime = hyp_runtime_create();
     if (!runtime) {
         fprintf(stderr, "Error: Could not create runtime\n");
-        hyp_parser_destroy(parser);
+        hyp_ast_image_release(&image);
         hyp_lexer_destroy(lexer);
-        HYP_FREE(source);
+        hyp_source_release(&source);
         return 1;
     }
     
+    /* Profiling is attached before execution so module code is recorded too */
+    if (options->profile_file) {
+        runtime->profile = hyp_profile_create();
+        if (!runtime->profile || hyp_profile_bind(runtime->profile, ast) != HYP_OK) {
+            fprintf(stderr, "Error: Could not set up profiling\n");
+            hyp_profile_destroy(runtime->profile);
+            hyp_runtime_destroy(runtime);
+            hyp_ast_image_release(&image);
+            hyp_lexer_destroy(lexer);
+            hyp_source_release(&source);
+            return 1;
+        }
+    }
+    
     /* Execute AST */
+    double start = hyp_wall_time();
     hyp_error_t result = hyp_runtime_execute_ast(runtime, ast);
+    double elapsed = hyp_wall_time() - start;
+    
+    /* A partial profile from a failed run is still worth keeping */
+    if (runtime->profile) {
+        if (hyp_profile_write(runtime->profile, options->profile_file) != HYP_OK) {
+            fprintf(stderr, "Error: %s\n", runtime->profile->error_message);
+            if (result == HYP_OK) result = HYP_ERROR_IO;
+        } else if (options->verbose) {
+            printf("Profile written to %s\n", options->profile_file);
+        }
+        hyp_profile_destroy(runtime->profile);
+        runtime->profile = NULL;
+    }
+    
+    if (result == HYP_ERROR_IO) {
+        hyp_runtime_destroy(runtime);
+        hyp_ast_image_release(&image);
+        hyp_lexer_destroy(lexer);
+        hyp_source_release(&source);
+        return 1;
+    }
     if (result != HYP_OK) {
         const char* error = hyp_runtime_get_error(runtime);
         fprintf(stderr, "Runtime error: %s\n", error ? error : "Unknown error");
         
         hyp_runtime_destroy(runtime);
-        hyp_parser_destroy(parser);
+        hyp_ast_image_release(&image);
         hyp_lexer_destroy(lexer);
-        HYP_FREE(source);
+        hyp_source_release(&source);
         return 1;
     }
     
     if (options->verbose) {
         printf("Execution completed successfully\n");
     }
+    if (options->alloc_bench) {
+        report_allocation(elapsed);
+    }
+    
+    /* Exit as a native build of the program would, with main's result */
+    int status = runtime->exit_status;
     
     /* Cleanup */
     hyp_runtime_destroy(runtime);
-    hyp_parser_destroy(parser);
+    hyp_ast_image_release(&image);
     hyp_lexer_destroy(lexer);
-    HYP_FREE(source);
+    hyp_source_release(&source);
     
-    return 0;
+    return status;
 }
 
 /* Execute Hyper bytecode */
@@ -256,15 +547,76 @@ static int execute_bytecode(hyprun_options_t* options) {
     return 1;
 }
 
+/* Run a native binary, reporting launch failures */
+static int run_native(hyprun_options_t* options, const char* binary_path) {
+    if (options->verbose) {
+        printf("Running native binary: %s\n", binary_path);
+    }
+    
+    /* --stats waits for the program, so its collector figures make the report */
+    int status = options->stats ?
+        hyp_aot_run_measured(binary_path, options->program_argc, options->program_argv) :
+        hyp_aot_run(binary_path, options->program_argc, options->program_argv);
+    if (status < 0) {
+        fprintf(stderr, "Error: Could not execute '%s'\n", binary_path);
+        return 1;
+    }
+    return status;
+}
+
+/* Build Hyper source ahead of time (or reuse the cached binary) and run it */
+static int execute_aot(hyprun_options_t* options) {
+    hyp_aot_t aot;
+    hyp_aot_init(&aot);
+    aot.verbose = options->verbose;
+    
+    char* binary_path = NULL;
+    if (hyp_aot_build(&aot, options->input_file, &binary_path) != HYP_OK) {
+        fprintf(stderr, "Error: %s\n", aot.error_message);
+        return 1;
+    }
+    
+    int status = run_native(options, binary_path);
+    HYP_FREE(binary_path);
+    return status;
+}
+
 /* Compile and execute C code */
 static int execute_c_code(hyprun_options_t* options) {
     if (options->verbose) {
         printf("Compiling and executing C code: %s\n", options->input_file);
     }
     
-    /* TODO: Implement C compilation and execution */
-    fprintf(stderr, "Error: C code execution not yet implemented\n");
-    return 1;
+    hyp_aot_t aot;
+    hyp_aot_init(&aot);
+    aot.verbose = options->verbose;
+    
+    hyp_error_t result = hyp_make_directory(aot.cache_dir);
+    if (result != HYP_OK) {
+        fprintf(stderr, "Error: Could not create cache directory '%s'\n", aot.cache_dir);
+        return 1;
+    }
+    
+    /* C sources are cached by content just like AOT builds */
+    hyp_source_t source;
+    if (hyp_source_load(&source, options->input_file) != HYP_OK) {
+        fprintf(stderr, "Error: Could not read file %s\n", options->input_file);
+        return 1;
+    }
+    uint64_t key = hyp_aot_cache_key(&aot, source.data, source.size);
+    hyp_source_release(&source);
+    
+    char binary_path[1024];
+    snprintf(binary_path, sizeof(binary_path), "%s/c-%016llx%s", aot.cache_dir,
+             (unsigned long long)key, HYP_AOT_EXE_SUFFIX);
+    
+    if (!hyp_file_exists(binary_path) &&
+        hyp_aot_compile_c(&aot, options->input_file, binary_path) != HYP_OK) {
+        fprintf(stderr, "Error: %s\n", aot.error_message);
+        return 1;
+    }
+    
+    return run_native(options, binary_path);
 }
 
 /* Main execution function */
@@ -283,6 +635,19 @@ static int execute_file(hyprun_options_t* options) {
     /* Determine execution mode based on file type and options */
     file_type_t file_type = get_file_type(options->input_file);
     
+    if (options->aot_mode && options->profile_file) {
+        fprintf(stderr, "Error: --write-profile records through the interpreter and cannot be combined with --aot\n");
+        return 1;
+    }
+    
+    if (options->aot_mode) {
+        if (file_type != FILE_TYPE_HYPER_SOURCE) {
+            fprintf(stderr, "Error: --aot can only be used with .hxp files\n");
+            return 1;
+        }
+        return execute_aot(options);
+    }
+    
     if (options->interpret_mode) {
         if (file_type != FILE_TYPE_HYPER_SOURCE) {
             fprintf(stderr, "Error: --interpret can only be used with .hxp files\n");
@@ -302,7 +667,7 @@ static int execute_file(hyprun_options_t* options) {
     /* Auto-detect based on file extension */
     switch (file_type) {
         case FILE_TYPE_HYPER_SOURCE:
-            fprintf(stderr, "Error: .hxp files require --interpret flag\n");
+            fprintf(stderr, "Error: .hxp files require --interpret or --aot\n");
             return 1;
             
         case FILE_TYPE_HYPER_BYTECODE:
@@ -313,7 +678,7 @@ static int execute_file(hyprun_options_t* options) {
             
         default:
             fprintf(stderr, "Error: Unknown file type for '%s'\n", options->input_file);
-            fprintf(stderr, "Supported extensions: .hxp (with --interpret), .hyb, .c\n");
+            fprintf(stderr, "Supported extensions: .hxp (with --interpret or --aot), .hyb, .c\n");
             return 1;
     }
 }
@@ -322,12 +687,20 @@ static int execute_file(hyprun_options_t* options) {
 int main(int argc, char* argv[]) {
     hyprun_options_t options;
     
+    /* Pick the allocator ($HYP_ALLOCATOR) before anything is allocated */
+    hyp_mem_init();
+    
     /* Parse command-line arguments */
     if (!parse_arguments(argc, argv, &options)) {
         print_usage(argv[0]);
         return 1;
     }
     
+    if (options.stats && !hyp_metrics_report_at_exit(options.stats_format)) {
+        fprintf(stderr, "Error: Unknown stats format '%s'\n", options.stats_format);
+        return 1;
+    }
+    
     /* Handle special options */
     if (options.show_help) {
         print_usage(argv[0]);
@@ -339,6 +712,10 @@ int main(int argc, char* argv[]) {
         return 0;
     }
     
+    if (options.container_bench) {
+        return bench_containers();
+    }
+    
     /* Execute the file */
     return execute_file(&options);
 }
\ No newline at end of file
@@ -5,75 +5,353 @@
  * Handles keywords, identifiers, literals, operators, and punctuation.
  */
 
+#define HYP_MEM_TAG HYP_MEM_LEXER
+
 #include "../../include/lexer.h"
 #include "../../include/hyp_common.h"
-#include <ctype.h>
+#include "../../include/hyp_number.h"
+#include "../../include/hyp_metrics.h"
+#include "../../include/hyp_thread.h"
 #include <string.h>
 
-/* Keyword lookup table */
+/* Metrics, per tokenized source */
+static hyp_metric_t metric_tokenize = HYP_HISTOGRAM("lexer.tokenize", "Time to tokenize a source");
+static hyp_metric_t metric_bytes = HYP_COUNTER("lexer.bytes", "Source bytes tokenized");
+static hyp_metric_t metric_tokens = HYP_COUNTER("lexer.tokens", "Tokens produced, EOF included");
+static hyp_metric_t metric_edits = HYP_COUNTER("lexer.edits", "Edits rescanned in place");
+
+/* Character classes, indexed by byte. Unlike <ctype.h> they do not
+ * depend on the locale; bytes outside ASCII belong to no class. */
+#define CHAR_SPACE       0x01    /* ' ', '\t', '\r' and '\n' */
+#define CHAR_LETTER      0x02
+#define CHAR_DIGIT       0x04
+#define CHAR_IDENT       0x08    /* Letters, digits and '_' */
+#define CHAR_IDENT_START 0x10    /* Letters and '_' */
+
+#define S CHAR_SPACE
+#define L (CHAR_LETTER | CHAR_IDENT | CHAR_IDENT_START)
+#define D (CHAR_DIGIT | CHAR_IDENT)
+#define U (CHAR_IDENT | CHAR_IDENT_START)
+static const uint8_t char_class[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, S, S, 0, 0, S, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    S, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    D, D, D, D, D, D, D, D, D, D, 0, 0, 0, 0, 0, 0,
+    0, L, L, L, L, L, L, L, L, L, L, L, L, L, L, L,
+    L, L, L, L, L, L, L, L, L, L, L, 0, 0, 0, 0, U,
+    0, L, L, L, L, L, L, L, L, L, L, L, L, L, L, L,
+    L, L, L, L, L, L, L, L, L, L, L, 0, 0, 0, 0, 0
+};
+#undef S
+#undef L
+#undef D
+#undef U
+
+#define CHAR_IS(c, class) ((char_class[(unsigned char)(c)] & (class)) != 0)
+
+/* Bulk scanners. Runs of whitespace, identifier characters, comment and
+ * string contents are crossed a vector at a time: 32 bytes with AVX2,
+ * 16 with SSE2 (every x86-64 has it), byte by byte elsewhere. Each one
+ * stops at the first interesting byte, and always at a NUL, which ends
+ * the input; the ones that can cross lines count the newlines on the way
+ * with a popcount of the newline mask. Vector loads never reach past end
+ * (the terminating NUL). Most runs in real code are a few bytes long (a
+ * space, a short name), so the first LEX_SHORT_RUN bytes are checked one
+ * at a time and only longer runs go wide. */
+#define LEX_SHORT_RUN 16
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define LEX_VECTOR_SIZE 32
+    typedef __m256i lex_vector_t;
+    #define VEC_LOAD(p) _mm256_loadu_si256((const __m256i*)(const void*)(p))
+    #define VEC_SPLAT(c) _mm256_set1_epi8((char)(c))
+    #define VEC_EQ(a, b) _mm256_cmpeq_epi8((a), (b))
+    #define VEC_GT(a, b) _mm256_cmpgt_epi8((a), (b))
+    #define VEC_OR(a, b) _mm256_or_si256((a), (b))
+    #define VEC_AND(a, b) _mm256_and_si256((a), (b))
+    #define VEC_MASK(v) ((uint32_t)_mm256_movemask_epi8(v))
+    #define VEC_FULL 0xFFFFFFFFu
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define LEX_VECTOR_SIZE 16
+    typedef __m128i lex_vector_t;
+    #define VEC_LOAD(p) _mm_loadu_si128((const __m128i*)(const void*)(p))
+    #define VEC_SPLAT(c) _mm_set1_epi8((char)(c))
+    #define VEC_EQ(a, b) _mm_cmpeq_epi8((a), (b))
+    #define VEC_GT(a, b) _mm_cmpgt_epi8((a), (b))
+    #define VEC_OR(a, b) _mm_or_si128((a), (b))
+    #define VEC_AND(a, b) _mm_and_si128((a), (b))
+    #define VEC_MASK(v) ((uint32_t)_mm_movemask_epi8(v))
+    #define VEC_FULL 0xFFFFu
+#endif
+
+#if defined(__GNUC__)
+    #define LEX_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+    #define LEX_NOINLINE __declspec(noinline)
+#else
+    #define LEX_NOINLINE
+#endif
+
+#ifdef LEX_VECTOR_SIZE
+#ifdef _MSC_VER
+#include <intrin.h>
+
+static int mask_first(uint32_t mask) {
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+}
+
+static int mask_last(uint32_t mask) {
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return (int)index;
+}
+
+static int mask_count(uint32_t mask) {
+    return (int)__popcnt(mask);
+}
+#else
+/* Index of the lowest and highest set bit, and the number of set bits */
+#define mask_first(mask) __builtin_ctz(mask)
+#define mask_last(mask) (31 - __builtin_clz(mask))
+#define mask_count(mask) __builtin_popcount(mask)
+#endif
+
+/* Bits for the first count bytes of a vector (count > 0) */
+#define VEC_BELOW(count) (VEC_FULL >> (LEX_VECTOR_SIZE - (count)))
+
+/* Move a line and column position over length bytes of a vector, given
+ * the mask of newlines among them */
+static void move_over(uint32_t newlines, int length, size_t* line, size_t* column) {
+    if (newlines) {
+        *line += (size_t)mask_count(newlines);
+        *column = (size_t)(length - mask_last(newlines));
+    } else {
+        *column += (size_t)length;
+    }
+}
+#endif
+
+/* Move a line and column position over one byte */
+#define MOVE_OVER_BYTE(c, line, column) \
+    do { \
+        if ((c) == '\n') { \
+            (line)++; \
+            (column) = 1; \
+        } else { \
+            (column)++; \
+        } \
+    } while (0)
+
+/* The long-run halves of the scanners below. Kept out of line so that
+ * the short-run checks do not pay for setting up vector constants. */
+static LEX_NOINLINE const char* skip_blank_wide(const char* p, const char* end, size_t* line, size_t* column) {
+#ifdef LEX_VECTOR_SIZE
+    const lex_vector_t space = VEC_SPLAT(' ');
+    const lex_vector_t tab = VEC_SPLAT('\t');
+    const lex_vector_t cr = VEC_SPLAT('\r');
+    const lex_vector_t lf = VEC_SPLAT('\n');
+    while (end - p >= LEX_VECTOR_SIZE) {
+        lex_vector_t v = VEC_LOAD(p);
+        lex_vector_t newline = VEC_EQ(v, lf);
+        lex_vector_t blank = VEC_OR(VEC_OR(VEC_EQ(v, space), VEC_EQ(v, tab)), VEC_OR(VEC_EQ(v, cr), newline));
+        uint32_t newlines = VEC_MASK(newline);
+        uint32_t other = ~VEC_MASK(blank) & VEC_FULL;
+        if (other) {
+            int length = mask_first(other);
+            if (length) move_over(newlines & VEC_BELOW(length), length, line, column);
+            return p + length;
+        }
+        move_over(newlines, LEX_VECTOR_SIZE, line, column);
+        p += LEX_VECTOR_SIZE;
+    }
+#else
+    (void)end;
+#endif
+    for (; CHAR_IS(*p, CHAR_SPACE); p++) MOVE_OVER_BYTE(*p, *line, *column);
+    return p;
+}
+
+static LEX_NOINLINE const char* find_non_ident_wide(const char* p, const char* end) {
+#ifdef LEX_VECTOR_SIZE
+    /* Signed compares: bytes above 0x7F are negative and match nothing */
+    const lex_vector_t case_bit = VEC_SPLAT(0x20);
+    const lex_vector_t before_a = VEC_SPLAT('a' - 1);
+    const lex_vector_t after_z = VEC_SPLAT('z' + 1);
+    const lex_vector_t before_0 = VEC_SPLAT('0' - 1);
+    const lex_vector_t after_9 = VEC_SPLAT('9' + 1);
+    const lex_vector_t underscore = VEC_SPLAT('_');
+    while (end - p >= LEX_VECTOR_SIZE) {
+        lex_vector_t v = VEC_LOAD(p);
+        lex_vector_t lower = VEC_OR(v, case_bit);
+        lex_vector_t letter = VEC_AND(VEC_GT(lower, before_a), VEC_GT(after_z, lower));
+        lex_vector_t digit = VEC_AND(VEC_GT(v, before_0), VEC_GT(after_9, v));
+        lex_vector_t ident = VEC_OR(VEC_OR(letter, digit), VEC_EQ(v, underscore));
+        uint32_t other = ~VEC_MASK(ident) & VEC_FULL;
+        if (other) return p + mask_first(other);
+        p += LEX_VECTOR_SIZE;
+    }
+#else
+    (void)end;
+#endif
+    while (CHAR_IS(*p, CHAR_IDENT)) p++;
+    return p;
+}
+
+static LEX_NOINLINE const char* scan_to_wide(const char* p, const char* end, char a, char b,
+                                             size_t* line, size_t* column) {
+#ifdef LEX_VECTOR_SIZE
+    const lex_vector_t first = VEC_SPLAT(a);
+    const lex_vector_t second = VEC_SPLAT(b);
+    const lex_vector_t nul = VEC_SPLAT(0);
+    const lex_vector_t lf = VEC_SPLAT('\n');
+    while (end - p >= LEX_VECTOR_SIZE) {
+        lex_vector_t v = VEC_LOAD(p);
+        uint32_t found = VEC_MASK(VEC_OR(VEC_OR(VEC_EQ(v, first), VEC_EQ(v, second)), VEC_EQ(v, nul)));
+        uint32_t newlines = VEC_MASK(VEC_EQ(v, lf));
+        if (found) {
+            int length = mask_first(found);
+            if (length) move_over(newlines & VEC_BELOW(length), length, line, column);
+            return p + length;
+        }
+        move_over(newlines, LEX_VECTOR_SIZE, line, column);
+        p += LEX_VECTOR_SIZE;
+    }
+#else
+    (void)end;
+#endif
+    for (; *p != a && *p != b && *p != '\0'; p++) MOVE_OVER_BYTE(*p, *line, *column);
+    return p;
+}
+
+/* First byte that cannot continue an identifier */
+static const char* find_non_ident(const char* p, const char* end) {
+    for (int i = 0; i < LEX_SHORT_RUN; i++, p++) {
+        if (!CHAR_IS(*p, CHAR_IDENT)) return p;
+    }
+    return find_non_ident_wide(p, end);
+}
+
+/* First byte equal to a or b, or the NUL that ends the input, moving
+ * the line and column over the bytes before it */
+static const char* scan_to(const char* p, const char* end, char a, char b, size_t* line, size_t* column) {
+    /* Counted in locals: a byte read through p could alias *line */
+    size_t lines = *line;
+    size_t columns = *column;
+    for (int i = 0; i < LEX_SHORT_RUN; i++, p++) {
+        if (*p == a || *p == b || *p == '\0') {
+            *line = lines;
+            *column = columns;
+            return p;
+        }
+        MOVE_OVER_BYTE(*p, lines, columns);
+    }
+    *line = lines;
+    *column = columns;
+    return scan_to_wide(p, end, a, b, line, column);
+}
+
+/* Keyword table. Each keyword sits in the slot given by keyword_hash,
+ * a perfect hash over the keywords (no two share a slot), so a lookup
+ * is one hash and at most one comparison. The hash must be re-derived
+ * whenever a keyword is added. */
+#define KEYWORD_SLOTS 64
+#define KEYWORD_MIN_LENGTH 2
+#define KEYWORD_MAX_LENGTH 8
+
 static const struct {
     const char* keyword;
+    size_t length;
     hyp_token_type_t type;
-} keywords[] = {
-    {"let", TOKEN_LET},
-    {"const", TOKEN_CONST},
-    {"fn", TOKEN_FUNC},
-    {"if", TOKEN_IF},
-    {"else", TOKEN_ELSE},
-    {"while", TOKEN_WHILE},
-    {"for", TOKEN_FOR},
-    {"in", TOKEN_IN},
-    {"return", TOKEN_RETURN},
-    {"break", TOKEN_BREAK},
-    {"continue", TOKEN_CONTINUE},
-    {"match", TOKEN_MATCH},
-    {"case", TOKEN_CASE},
-    {"default", TOKEN_DEFAULT},
-    {"struct", TOKEN_STRUCT},
-    {"enum", TOKEN_ENUM},
-    {"import", TOKEN_IMPORT},
-    {"export", TOKEN_EXPORT},
-    {"module", TOKEN_MODULE},
-    {"true", TOKEN_TRUE},
-    {"false", TOKEN_FALSE},
-    {"null", TOKEN_NULL},
-    {"and", TOKEN_AND},
-    {"or", TOKEN_OR},
-    {"not", TOKEN_NOT},
-    {"async", TOKEN_ASYNC},
-    {"await", TOKEN_AWAIT},
-    {"try", TOKEN_TRY},
-    {"catch", TOKEN_CATCH},
-    {"finally", TOKEN_FINALLY},
-    {"throw", TOKEN_THROW},
-    {"state", TOKEN_STATE}
+} keywords[KEYWORD_SLOTS] = {
+    [0] = {"while", 5, TOKEN_WHILE},
+    [1] = {"break", 5, TOKEN_BREAK},
+    [6] = {"module", 6, TOKEN_MODULE},
+    [8] = {"not", 3, TOKEN_NOT},
+    [11] = {"enum", 4, TOKEN_ENUM},
+    [13] = {"async", 5, TOKEN_ASYNC},
+    [14] = {"fn", 2, TOKEN_FUNC},
+    [16] = {"import", 6, TOKEN_IMPORT},
+    [17] = {"await", 5, TOKEN_AWAIT},
+    [19] = {"const", 5, TOKEN_CONST},
+    [20] = {"let", 3, TOKEN_LET},
+    [21] = {"if", 2, TOKEN_IF},
+    [22] = {"continue", 8, TOKEN_CONTINUE},
+    [23] = {"match", 5, TOKEN_MATCH},
+    [25] = {"try", 3, TOKEN_TRY},
+    [26] = {"true", 4, TOKEN_TRUE},
+    [29] = {"in", 2, TOKEN_IN},
+    [32] = {"for", 3, TOKEN_FOR},
+    [36] = {"case", 4, TOKEN_CASE},
+    [37] = {"catch", 5, TOKEN_CATCH},
+    [41] = {"else", 4, TOKEN_ELSE},
+    [47] = {"null", 4, TOKEN_NULL},
+    [48] = {"default", 7, TOKEN_DEFAULT},
+    [49] = {"throw", 5, TOKEN_THROW},
+    [52] = {"false", 5, TOKEN_FALSE},
+    [53] = {"return", 6, TOKEN_RETURN},
+    [54] = {"and", 3, TOKEN_AND},
+    [55] = {"export", 6, TOKEN_EXPORT},
+    [56] = {"state", 5, TOKEN_STATE},
+    [57] = {"struct", 6, TOKEN_STRUCT},
+    [62] = {"finally", 7, TOKEN_FINALLY},
+    [63] = {"or", 2, TOKEN_OR}
 };
 
-#define KEYWORD_COUNT (sizeof(keywords) / sizeof(keywords[0]))
+static size_t keyword_hash(const char* start, size_t length) {
+    return ((unsigned char)start[0] * 5u + (unsigned char)start[1] * 17u + length) & (KEYWORD_SLOTS - 1);
+}
+
+/* Check if identifier is a keyword */
+static hyp_token_type_t check_keyword(const char* start, size_t length) {
+    if (length < KEYWORD_MIN_LENGTH || length > KEYWORD_MAX_LENGTH) return TOKEN_IDENTIFIER;
+    
+    size_t slot = keyword_hash(start, length);
+    if (keywords[slot].length == length && memcmp(start, keywords[slot].keyword, length) == 0) {
+        return keywords[slot].type;
+    }
+    return TOKEN_IDENTIFIER;
+}
+
+hyp_token_type_t hyp_lexer_lookup_keyword(const char* text) {
+    return text ? check_keyword(text, strlen(text)) : TOKEN_IDENTIFIER;
+}
 
 /* Initialize lexer */
 hyp_lexer_t* hyp_lexer_create(const char* source, const char* filename) {
     if (!source) return NULL;
+    return hyp_lexer_create_with_length(source, strlen(source), filename);
+}
+
+hyp_lexer_t* hyp_lexer_create_with_length(const char* source, size_t length, const char* filename) {
+    (void)filename;
+    if (!source) return NULL;
     
     hyp_lexer_t* lexer = HYP_MALLOC(sizeof(hyp_lexer_t));
     if (!lexer) return NULL;
     
     lexer->source = source;
-    lexer->source_length = strlen(source);
+    lexer->source_length = length;
     lexer->current = 0;
     lexer->line = 1;
     lexer->column = 1;
     lexer->jsx_depth = 0; /* Track JSX nesting depth */
     lexer->in_jsx = false; /* Track if we're inside JSX */
+    lexer->has_jsx = false;
     lexer->has_error = false;
     lexer->error_message[0] = '\0';
     
     /* Initialize token array */
-    lexer->tokens.data = NULL;
-    lexer->tokens.count = 0;
-    lexer->tokens.capacity = 0;
+    memset(&lexer->tokens, 0, sizeof(lexer->tokens));
+    lexer->first_line = 1;
+    lexer->line_starts = NULL;
+    lexer->line_count = 0;
+    lexer->line_cursor = 0;
     
-    lexer->arena = hyp_arena_create(8192); /* 8KB arena for tokens */
+    lexer->arena = hyp_arena_create(8192); /* Scratch space for edits */
     
     if (!lexer->arena) {
         HYP_FREE(lexer);
@@ -90,12 +368,280 @@ void hyp_lexer_destroy(hyp_lexer_t* lexer) {
         hyp_arena_destroy(lexer->arena);
     }
     
+    HYP_FREE(lexer->tokens.types);
+    HYP_FREE(lexer->tokens.starts);
+    HYP_FREE(lexer->tokens.bases);
+    HYP_FREE(lexer->tokens.lengths);
+    HYP_ARRAY_FREE(&lexer->tokens.literals);
+    HYP_FREE(lexer->line_starts);
     HYP_FREE(lexer);
 }
 
+void hyp_lexer_reset(hyp_lexer_t* lexer, const char* source, size_t length, size_t line) {
+    if (!lexer || !source) return;
+    
+    lexer->source = source;
+    lexer->source_length = length;
+    lexer->current = 0;
+    lexer->line = line;
+    lexer->column = 1;
+    lexer->jsx_depth = 0;
+    lexer->in_jsx = false;
+    lexer->has_jsx = false;
+    lexer->has_error = false;
+    lexer->error_message[0] = '\0';
+    lexer->tokens.count = 0;
+    lexer->tokens.literals.count = 0;
+    lexer->first_line = line;
+    lexer->line_count = 0;
+    lexer->line_cursor = 0;
+    hyp_arena_reset(lexer->arena);
+}
+
+/* Batched source reading */
+#define HYP_SOURCE_BATCH_SIZE (64 * 1024)
+#define HYP_SOURCE_READ_SIZE (64 * 1024)
+
+/* Words that continue the statement before them */
+static bool continues_statement(const char* word, size_t length) {
+    switch (check_keyword(word, length)) {
+        case TOKEN_ELSE:
+        case TOKEN_CATCH:
+        case TOKEN_FINALLY:
+        case TOKEN_AND:
+        case TOKEN_OR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Advance the splitter over the buffered bytes. Stops early (returning
+ * false) when it needs to see bytes that have not been read yet. */
+static bool reader_scan(hyp_source_reader_t* reader) {
+    const char* buffer = reader->buffer;
+    
+    while (reader->scanned < reader->length) {
+        size_t i = reader->scanned;
+        char c = buffer[i];
+        bool has_next = i + 1 < reader->length;
+        
+        if (reader->line_comment) {
+            if (c == '\n') reader->line_comment = false;
+            reader->scanned++;
+            continue;
+        }
+        if (reader->block_comment) {
+            if (c == '*') {
+                if (!has_next && !reader->at_end) return false;
+                if (has_next && buffer[i + 1] == '/') {
+                    reader->block_comment = false;
+                    reader->scanned++;
+                }
+            }
+            reader->scanned++;
+            continue;
+        }
+        if (reader->quote) {
+            if (reader->escaped) {
+                reader->escaped = false;
+            } else if (c == '\\') {
+                reader->escaped = true;
+            } else if (c == reader->quote) {
+                reader->quote = 0;
+            }
+            reader->scanned++;
+            continue;
+        }
+        
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            reader->scanned++;
+            continue;
+        }
+        if (c == '/') {
+            if (!has_next && !reader->at_end) return false;
+            if (has_next && (buffer[i + 1] == '/' || buffer[i + 1] == '*')) {
+                reader->line_comment = buffer[i + 1] == '/';
+                reader->block_comment = buffer[i + 1] == '*';
+                reader->scanned += 2;
+                continue;
+            }
+        }
+        
+        /* The first significant character after a possible boundary
+         * decides it: a new statement starts with a word */
+        if (reader->candidate) {
+            if (CHAR_IS(c, CHAR_IDENT_START) || c == '$') {
+                size_t end = i;
+                while (end < reader->length && (CHAR_IS(buffer[end], CHAR_IDENT) || buffer[end] == '$')) end++;
+                if (end == reader->length && !reader->at_end) return false;
+                if (!continues_statement(buffer + i, end - i)) {
+                    reader->boundary = reader->candidate;
+                }
+            }
+            reader->candidate = 0;
+        }
+        
+        switch (c) {
+            case '"':
+            case '\'':
+                reader->quote = c;
+                break;
+            case '(':
+            case '[':
+            case '{':
+                reader->depth++;
+                break;
+            case ')':
+            case ']':
+            case '}':
+                if (reader->depth > 0) reader->depth--;
+                break;
+            default:
+                break;
+        }
+        if (reader->depth == 0 && (c == ';' || c == '}')) {
+            reader->candidate = i + 1;
+        }
+        reader->scanned++;
+    }
+    return true;
+}
+
+/* Drop the batches already handed out */
+static void reader_compact(hyp_source_reader_t* reader) {
+    size_t start = reader->start;
+    if (start == 0) return;
+    
+    memmove(reader->buffer, reader->buffer + start, reader->length - start);
+    reader->length -= start;
+    reader->scanned -= start;
+    reader->boundary = reader->boundary > start ? reader->boundary - start : 0;
+    reader->candidate = reader->candidate > start ? reader->candidate - start : 0;
+    reader->start = 0;
+}
+
+/* Append the next piece of the file; sets at_end once it is exhausted */
+static hyp_error_t reader_fill(hyp_source_reader_t* reader) {
+    /* One byte is always kept free for the batch terminator */
+    if (reader->capacity - reader->length < HYP_SOURCE_READ_SIZE + 1) {
+        size_t capacity = reader->capacity ? reader->capacity * 2 : HYP_SOURCE_READ_SIZE * 2;
+        while (capacity - reader->length < HYP_SOURCE_READ_SIZE + 1) capacity *= 2;
+        char* buffer = HYP_REALLOC(reader->buffer, capacity);
+        if (!buffer) return HYP_ERROR_MEMORY;
+        reader->buffer = buffer;
+        reader->capacity = capacity;
+    }
+    
+    size_t count = fread(reader->buffer + reader->length, 1, HYP_SOURCE_READ_SIZE, reader->file);
+    reader->length += count;
+    if (count < HYP_SOURCE_READ_SIZE) {
+        if (ferror(reader->file)) return HYP_ERROR_IO;
+        reader->at_end = true;
+    }
+    return HYP_OK;
+}
+
+static void reader_restart(hyp_source_reader_t* reader) {
+    reader->length = 0;
+    reader->line = 1;
+    reader->at_end = false;
+    reader->has_error = false;
+    reader->start = 0;
+    reader->scanned = 0;
+    reader->boundary = 0;
+    reader->candidate = 0;
+    reader->depth = 0;
+    reader->quote = 0;
+    reader->escaped = false;
+    reader->line_comment = false;
+    reader->block_comment = false;
+    reader->terminated = false;
+}
+
+hyp_error_t hyp_source_reader_open(hyp_source_reader_t* reader, const char* filename, size_t batch_size) {
+    if (!reader || !filename) return HYP_ERROR_INVALID_ARG;
+    
+    memset(reader, 0, sizeof(hyp_source_reader_t));
+    reader->file = fopen(filename, "rb");
+    if (!reader->file) return HYP_ERROR_IO;
+    
+    reader->batch_size = batch_size ? batch_size : HYP_SOURCE_BATCH_SIZE;
+    reader_restart(reader);
+    return HYP_OK;
+}
+
+hyp_error_t hyp_source_reader_next(hyp_source_reader_t* reader, const char** text, size_t* length, size_t* line) {
+    if (!reader || !reader->file || !text || !length || !line) return HYP_ERROR_INVALID_ARG;
+    if (reader->has_error) return HYP_ERROR_IO;
+    
+    /* Undo the previous batch's terminator and forget that batch */
+    if (reader->terminated) {
+        reader->buffer[reader->terminator] = reader->saved;
+        reader->terminated = false;
+    }
+    reader_compact(reader);
+    
+    for (;;) {
+        bool complete = reader_scan(reader);
+        if (reader->boundary >= reader->batch_size) break;
+        if (reader->at_end && complete) {
+            /* Whatever follows the last boundary is the final declaration */
+            reader->boundary = reader->length;
+            break;
+        }
+        
+        hyp_error_t result = reader_fill(reader);
+        if (result != HYP_OK) {
+            reader->has_error = true;
+            return result;
+        }
+    }
+    
+    if (reader->boundary == 0) return HYP_ERROR_NOT_FOUND;
+    
+    size_t end = reader->boundary;
+    reader->terminated = true;
+    reader->terminator = end;
+    reader->saved = reader->buffer[end];
+    reader->buffer[end] = '\0';
+    
+    *text = reader->buffer;
+    *length = end;
+    *line = reader->line;
+    
+    for (const char* c = reader->buffer; (c = memchr(c, '\n', (size_t)(reader->buffer + end - c))) != NULL; c++) {
+        reader->line++;
+    }
+    reader->start = end;
+    reader->boundary = 0;
+    return HYP_OK;
+}
+
+hyp_error_t hyp_source_reader_rewind(hyp_source_reader_t* reader) {
+    if (!reader || !reader->file) return HYP_ERROR_INVALID_ARG;
+    
+    clearerr(reader->file);
+    if (fseek(reader->file, 0, SEEK_SET) != 0) return HYP_ERROR_IO;
+    reader_restart(reader);
+    return HYP_OK;
+}
+
+void hyp_source_reader_close(hyp_source_reader_t* reader) {
+    if (!reader) return;
+    
+    if (reader->file) {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+    HYP_FREE(reader->buffer);
+    reader->capacity = 0;
+    reader->length = 0;
+}
+
 /* Character utilities */
 static bool is_at_end(hyp_lexer_t* lexer) {
-    return lexer->current >= lexer->source_length || lexer->source[lexer->current] == '\0';
+    return lexer->current >= lexer->source_length;
 }
 
 static char advance(hyp_lexer_t* lexer) {
@@ -144,7 +690,7 @@ static hyp_token_t make_token(hyp_lexer_t* lexer, hyp_token_type_t type, size_t
     return token;
 }
 
-static hyp_token_t error_token(hyp_lexer_t* lexer, const char* message) {
+static hyp_token_t error_token(hyp_lexer_t* lexer, const char* message, size_t start_pos) {
     hyp_token_t token;
     token.type = TOKEN_ERROR;
     token.lexeme.data = (char*)message;
@@ -152,71 +698,99 @@ static hyp_token_t error_token(hyp_lexer_t* lexer, const char* message) {
     token.lexeme.capacity = 0;
     token.line = lexer->line;
     token.column = lexer->column;
-    token.position = lexer->current;
+    token.position = start_pos;
     
     return token;
 }
 
-/* Skip whitespace and comments */
+/* Skip a line or block comment starting at p */
+static const char* skip_comment(const char* p, const char* end, size_t* line, size_t* column) {
+    if (p[1] == '/') {
+        for (;;) {
+            p = scan_to(p, end, '\n', '\n', line, column);
+            if (p >= end || *p == '\n') return p;
+            /* A NUL byte in the comment */
+            p++;
+            (*column)++;
+        }
+    }
+    
+    p += 2;
+    *column += 2;
+    for (;;) {
+        p = scan_to(p, end, '*', '*', line, column);
+        if (p >= end) return p;
+        p++;
+        (*column)++;
+        if (p[-1] == '*' && *p == '/') {
+            (*column)++;
+            return p + 1;
+        }
+    }
+}
+
+/* Skip whitespace and comments. This and the other hot scanners use the
+ * bulk scanners above instead of calling advance() per byte. Short runs
+ * are handled inline on local copies of the line and column; the bulk
+ * scanners work on the lexer's own. */
 static void skip_whitespace(hyp_lexer_t* lexer) {
+    const char* source = lexer->source;
+    const char* end = source + lexer->source_length;
+    const char* p = source + lexer->current;
+    size_t line = lexer->line;
+    size_t column = lexer->column;
+    
     for (;;) {
-        char c = peek(lexer);
-        switch (c) {
-            case ' ':
-            case '\r':
-            case '\t':
-                advance(lexer);
+        /* Usually one space, or a newline and some indentation */
+        const char* run = p;
+        while (CHAR_IS(*p, CHAR_SPACE)) {
+            MOVE_OVER_BYTE(*p, line, column);
+            if (++p - run == LEX_SHORT_RUN) {
+                lexer->line = line;
+                lexer->column = column;
+                p = skip_blank_wide(p, end, &lexer->line, &lexer->column);
+                line = lexer->line;
+                column = lexer->column;
                 break;
-            case '\n':
-                advance(lexer);
-                break;
-            case '/':
-                if (peek_next(lexer) == '/') {
-                    /* Line comment */
-                    while (peek(lexer) != '\n' && !is_at_end(lexer)) {
-                        advance(lexer);
-                    }
-                } else if (peek_next(lexer) == '*') {
-                    /* Block comment */
-                    advance(lexer); /* / */
-                    advance(lexer); /* * */
-                    
-                    while (!is_at_end(lexer)) {
-                        if (peek(lexer) == '*' && peek_next(lexer) == '/') {
-                            advance(lexer); /* * */
-                            advance(lexer); /* / */
-                            break;
-                        }
-                        advance(lexer);
-                    }
-                } else {
-                    return;
-                }
-                break;
-            default:
-                return;
+            }
         }
+        
+        if (p[0] != '/' || (p[1] != '/' && p[1] != '*')) break;
+        lexer->line = line;
+        lexer->column = column;
+        p = skip_comment(p, end, &lexer->line, &lexer->column);
+        line = lexer->line;
+        column = lexer->column;
     }
+    
+    lexer->current = (size_t)(p - source);
+    lexer->line = line;
+    lexer->column = column;
 }
 
-/* Scan string literal */
+/* Scan string literal; multi-line strings are allowed */
 static hyp_token_t scan_string(hyp_lexer_t* lexer, char quote, size_t start) {
-    while (peek(lexer) != quote && !is_at_end(lexer)) {
-        if (peek(lexer) == '\n') {
-            /* Multi-line strings allowed */
-        }
-        if (peek(lexer) == '\\') {
-            advance(lexer); /* Skip escape character */
-            if (!is_at_end(lexer)) {
-                advance(lexer); /* Skip escaped character */
-            }
-        } else {
-            advance(lexer);
+    const char* source = lexer->source;
+    const char* end = source + lexer->source_length;
+    const char* p = source + lexer->current;
+    
+    for (;;) {
+        p = scan_to(p, end, quote, '\\', &lexer->line, &lexer->column);
+        if (p >= end || *p == quote) break;
+        if (*p == '\\') {
+            /* Skip the escape character and the one it escapes */
+            p++;
+            lexer->column++;
+            if (p >= end) break;
         }
+        /* The escaped character, or a NUL byte in the string */
+        MOVE_OVER_BYTE(*p, lexer->line, lexer->column);
+        p++;
     }
+    lexer->current = (size_t)(p - source);
     
     if (is_at_end(lexer)) {
-        return error_token(lexer, "Unterminated string");
+        return error_token(lexer, "Unterminated string", start);
     }
     
     /* Closing quote */
@@ -224,18 +798,23 @@ static hyp_token_t scan_string(hyp_lexer_t* lexer, char quote, size_t start) {
     return make_token(lexer, TOKEN_STRING, start);
 }
 
+/* Advance over a run of digits */
+static void skip_digits(hyp_lexer_t* lexer) {
+    const char* p = lexer->source + lexer->current;
+    const char* end = p;
+    while (CHAR_IS(*end, CHAR_DIGIT)) end++;
+    lexer->current += (size_t)(end - p);
+    lexer->column += (size_t)(end - p);
+}
+
 /* Scan number literal */
 static hyp_token_t scan_number(hyp_lexer_t* lexer, size_t start) {
-    while (isdigit(peek(lexer))) {
-        advance(lexer);
-    }
+    skip_digits(lexer);
     
     /* Look for decimal part */
-    if (peek(lexer) == '.' && isdigit(peek_next(lexer))) {
+    if (peek(lexer) == '.' && CHAR_IS(peek_next(lexer), CHAR_DIGIT)) {
         advance(lexer); /* . */
-        while (isdigit(peek(lexer))) {
-            advance(lexer);
-        }
+        skip_digits(lexer);
     }
     
     /* Look for exponent */
@@ -244,30 +823,20 @@ static hyp_token_t scan_number(hyp_lexer_t* lexer, size_t start) {
         if (peek(lexer) == '+' || peek(lexer) == '-') {
             advance(lexer);
         }
-        while (isdigit(peek(lexer))) {
-            advance(lexer);
-        }
+        skip_digits(lexer);
     }
     
-    return make_token(lexer, TOKEN_NUMBER, start);
-}
-
-/* Check if identifier is a keyword */
-static hyp_token_type_t check_keyword(const char* start, size_t length) {
-    for (size_t i = 0; i < KEYWORD_COUNT; i++) {
-        if (strlen(keywords[i].keyword) == length &&
-            memcmp(start, keywords[i].keyword, length) == 0) {
-            return keywords[i].type;
-        }
-    }
-    return TOKEN_IDENTIFIER;
+    hyp_token_t token = make_token(lexer, TOKEN_NUMBER, start);
+    hyp_number_parse(lexer->source + start, lexer->current - start, &token.value.number);
+    return token;
 }
 
 /* Scan identifier or keyword */
 static hyp_token_t scan_identifier(hyp_lexer_t* lexer, size_t start) {
-    while (isalnum(peek(lexer)) || peek(lexer) == '_') {
-        advance(lexer);
-    }
+    const char* p = lexer->source + lexer->current;
+    const char* end = find_non_ident(p, lexer->source + lexer->source_length);
+    lexer->current += (size_t)(end - p);
+    lexer->column += (size_t)(end - p);
     
     hyp_token_type_t type = check_keyword(lexer->source + start, 
                                          lexer->current - start);
@@ -276,7 +845,7 @@ static hyp_token_t scan_identifier(hyp_lexer_t* lexer, size_t start) {
 
 /* Scan JSX tag name or attribute */
 static hyp_token_t scan_jsx_identifier(hyp_lexer_t* lexer, size_t start) {
-    while (isalnum(peek(lexer)) || peek(lexer) == '_' || peek(lexer) == '-') {
+    while (CHAR_IS(peek(lexer), CHAR_IDENT) || peek(lexer) == '-') {
         advance(lexer);
     }
     return make_token(lexer, TOKEN_JSX_ATTRIBUTE, start);
@@ -326,12 +895,12 @@ hyp_token_t hyp_lexer_scan_token(hyp_lexer_t* lexer) {
     char c = advance(lexer);
     
     /* JSX text content */
-    if (lexer->in_jsx && !isalpha(c) && c != '<' && c != '{' && c != '}' && c != '>' && c != '/') {
+    if (lexer->in_jsx && !CHAR_IS(c, CHAR_LETTER) && c != '<' && c != '{' && c != '}' && c != '>' && c != '/') {
         return scan_jsx_text(lexer, start);
     }
     
     /* Identifiers and keywords */
-    if (isalpha(c) || c == '_') {
+    if (CHAR_IS(c, CHAR_IDENT_START)) {
         if (lexer->in_jsx) {
             return scan_jsx_identifier(lexer, start);
         }
@@ -339,7 +908,7 @@ hyp_token_t hyp_lexer_scan_token(hyp_lexer_t* lexer) {
     }
     
     /* Numbers */
-    if (isdigit(c)) {
+    if (CHAR_IS(c, CHAR_DIGIT)) {
         return scan_number(lexer, start);
     }
     
@@ -384,7 +953,7 @@ hyp_token_t hyp_lexer_scan_token(hyp_lexer_t* lexer) {
                 return make_token(lexer, TOKEN_LEFT_SHIFT, start);
             } else if (match(lexer, '/')) {
                 return make_token(lexer, TOKEN_JSX_END_TAG, start);
-            } else if (isalpha(peek(lexer))) {
+            } else if (CHAR_IS(peek(lexer), CHAR_LETTER)) {
                 /* Potential JSX tag */
                 lexer->in_jsx = true;
                 lexer->jsx_depth++;
@@ -418,7 +987,7 @@ hyp_token_t hyp_lexer_scan_token(hyp_lexer_t* lexer) {
             if (match(lexer, '=')) {
                 return make_token(lexer, TOKEN_MUL_ASSIGN, start);
             } else if (match(lexer, '*')) {
-                return make_token(lexer, TOKEN_POWER, start);
+                return make_token(lexer, match(lexer, '=') ? TOKEN_POWER_ASSIGN : TOKEN_POWER, start);
             }
             return make_token(lexer, TOKEN_STAR, start);
         case '/':
@@ -447,13 +1016,15 @@ hyp_token_t hyp_lexer_scan_token(hyp_lexer_t* lexer) {
                 return make_token(lexer, TOKEN_OR, start);
             } else if (match(lexer, '=')) {
                 return make_token(lexer, TOKEN_OR_EQUAL, start);
+            } else if (match(lexer, '>')) {
+                return make_token(lexer, TOKEN_PIPE, start);
             }
-            return make_token(lexer, TOKEN_PIPE, start);
+            return make_token(lexer, TOKEN_BITWISE_OR, start);
         case '^':
             return make_token(lexer, match(lexer, '=') ? TOKEN_XOR_EQUAL : TOKEN_CARET, start);
     }
     
-    return error_token(lexer, "Unexpected character");
+    return error_token(lexer, "Unexpected character", start);
 }
 
 /* Utility functions */
@@ -499,6 +1070,484 @@ hyp_token_t hyp_lexer_next_token(hyp_lexer_t* lexer) {
     return hyp_lexer_scan_token(lexer);
 }
 
+/* Whole-source tokenization */
+
+/* Grow scratch arrays in an arena, copying what they hold */
+static bool grow_scratch_tokens(hyp_token_array_t* tokens, size_t capacity, hyp_arena_t* arena) {
+    size_t blocks = (capacity >> HYP_TOKEN_BLOCK_SHIFT) + 1;
+    uint8_t* types = hyp_arena_alloc(arena, capacity * sizeof(uint8_t));
+    uint32_t* starts = hyp_arena_alloc(arena, capacity * sizeof(uint32_t));
+    uint32_t* lengths = hyp_arena_alloc(arena, capacity * sizeof(uint32_t));
+    uint32_t* bases = hyp_arena_alloc(arena, blocks * sizeof(uint32_t));
+    if (!types || !starts || !lengths || !bases) return false;
+    
+    if (tokens->capacity) {
+        memcpy(types, tokens->types, tokens->count * sizeof(uint8_t));
+        memcpy(starts, tokens->starts, tokens->count * sizeof(uint32_t));
+        memcpy(lengths, tokens->lengths, tokens->count * sizeof(uint32_t));
+        memcpy(bases, tokens->bases, ((tokens->capacity >> HYP_TOKEN_BLOCK_SHIFT) + 1) * sizeof(uint32_t));
+    }
+    
+    tokens->types = types;
+    tokens->starts = starts;
+    tokens->lengths = lengths;
+    tokens->bases = bases;
+    tokens->capacity = capacity;
+    return true;
+}
+
+static bool grow_tokens(hyp_token_array_t* tokens, size_t capacity, hyp_arena_t* scratch) {
+    if (scratch) return grow_scratch_tokens(tokens, capacity, scratch);
+    
+    uint8_t* types = HYP_REALLOC(tokens->types, capacity * sizeof(uint8_t));
+    if (!types) return false;
+    tokens->types = types;
+    
+    uint32_t* starts = HYP_REALLOC(tokens->starts, capacity * sizeof(uint32_t));
+    if (!starts) return false;
+    tokens->starts = starts;
+    
+    uint32_t* lengths = HYP_REALLOC(tokens->lengths, capacity * sizeof(uint32_t));
+    if (!lengths) return false;
+    tokens->lengths = lengths;
+    
+    uint32_t* bases = HYP_REALLOC(tokens->bases, ((capacity >> HYP_TOKEN_BLOCK_SHIFT) + 1) * sizeof(uint32_t));
+    if (!bases) return false;
+    tokens->bases = bases;
+    
+    tokens->capacity = capacity;
+    return true;
+}
+
+/* Append a token just scanned (it ends at lexer->current); the arrays
+ * of a scratch array live in the arena given */
+static bool push_token(hyp_token_array_t* tokens, const hyp_lexer_t* lexer, const hyp_token_t* token,
+                       hyp_arena_t* scratch) {
+    if (tokens->count == tokens->capacity &&
+        !grow_tokens(tokens, tokens->capacity ? tokens->capacity * 2 : 64, scratch)) {
+        return false;
+    }
+    
+    size_t index = tokens->count++;
+    uint32_t* base = &tokens->bases[index >> HYP_TOKEN_BLOCK_SHIFT];
+    if (index % HYP_TOKEN_BLOCK == 0) *base = (uint32_t)token->position;
+    tokens->types[index] = (uint8_t)token->type;
+    tokens->starts[index] = (uint32_t)token->position - *base;
+    tokens->lengths[index] = (uint32_t)(lexer->current - token->position);
+    
+    if (token->type == TOKEN_NUMBER || token->type == TOKEN_ERROR) {
+        hyp_token_literal_t literal;
+        literal.token = (uint32_t)index;
+        if (token->type == TOKEN_NUMBER) {
+            literal.value.number = token->value.number;
+        } else {
+            literal.value.message = token->lexeme.data;
+        }
+        HYP_ARRAY_PUSH(&tokens->literals, literal);
+    }
+    return true;
+}
+
+hyp_error_t hyp_lexer_tokenize(hyp_lexer_t* lexer) {
+    if (!lexer) return HYP_ERROR_INVALID_ARG;
+    
+    hyp_token_array_t* tokens = &lexer->tokens;
+    tokens->count = 0;
+    tokens->literals.count = 0;
+    lexer->has_jsx = false;
+    
+    if (lexer->source_length >= UINT32_MAX) {
+        lexer->has_error = true;
+        snprintf(lexer->error_message, sizeof(lexer->error_message),
+                 "Source too large to tokenize (%zu bytes); compile it with --stream", lexer->source_length);
+        return HYP_ERROR_INVALID_ARG;
+    }
+    
+    double started = hyp_wall_time();
+    
+    /* Typical code has a token every four or five bytes */
+    size_t expected = lexer->source_length / 4 + 16;
+    if (tokens->capacity < expected && !grow_tokens(tokens, expected, NULL)) {
+        return HYP_ERROR_MEMORY;
+    }
+    
+    for (;;) {
+        hyp_token_t token = hyp_lexer_scan_token(lexer);
+        if (!push_token(tokens, lexer, &token, NULL)) return HYP_ERROR_MEMORY;
+        if (lexer->in_jsx) lexer->has_jsx = true;
+        
+        if (token.type == TOKEN_EOF) break;
+    }
+    
+    hyp_metric_observe(&metric_tokenize, hyp_wall_time() - started);
+    hyp_metric_add(&metric_bytes, lexer->source_length);
+    hyp_metric_add(&metric_tokens, tokens->count);
+    return HYP_OK;
+}
+
+/* First of count ascending offsets that is greater than offset */
+static size_t offsets_after(const uint32_t* offsets, size_t count, size_t offset) {
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (offsets[middle] <= offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/* First token from index first on that starts after offset */
+static size_t tokens_after(const hyp_token_array_t* tokens, size_t first, size_t offset) {
+    size_t low = first;
+    size_t high = tokens->count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (hyp_token_start(tokens, middle) <= offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/* First literal of a token at or after index */
+static size_t literals_from(const hyp_token_array_t* tokens, size_t index) {
+    size_t low = 0;
+    size_t high = tokens->literals.count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (tokens->literals.data[middle].token < index) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/* Update the line index for an edit, if it has been built: drop the
+ * lines that started inside the removed text, add those of the inserted
+ * text and move the rest */
+static bool edit_lines(hyp_lexer_t* lexer, const char* source, size_t offset,
+                       size_t removed, size_t inserted, ptrdiff_t* lines) {
+    *lines = 0;
+    if (lexer->line_count == 0) return true;
+    
+    size_t added = 0;
+    for (const char* p = source + offset; (p = memchr(p, '\n', (size_t)(source + offset + inserted - p))) != NULL; p++) {
+        added++;
+    }
+    
+    size_t count = lexer->line_count;
+    size_t low = offsets_after(lexer->line_starts, count, offset);
+    size_t high = offsets_after(lexer->line_starts, count, offset + removed);
+    size_t new_count = count - (high - low) + added;
+    
+    if (new_count > count) {
+        uint32_t* grown = HYP_REALLOC(lexer->line_starts, new_count * sizeof(uint32_t));
+        if (!grown) return false;
+        lexer->line_starts = grown;
+    }
+    
+    uint32_t* starts = lexer->line_starts;
+    uint32_t delta = (uint32_t)(inserted - removed);  /* Wraps for deletions */
+    memmove(starts + low + added, starts + high, (count - high) * sizeof(uint32_t));
+    for (size_t i = low + added; i < new_count; i++) {
+        starts[i] += delta;
+    }
+    
+    size_t line = low;
+    for (const char* p = source + offset; (p = memchr(p, '\n', (size_t)(source + offset + inserted - p))) != NULL; p++) {
+        starts[line++] = (uint32_t)(p + 1 - source);
+    }
+    
+    lexer->line_count = new_count;
+    lexer->line_cursor = 0;
+    *lines = (ptrdiff_t)added - (ptrdiff_t)(high - low);
+    return true;
+}
+
+/* Replace old tokens first..end with the rescanned ones, moving the
+ * tokens after them by delta bytes */
+static bool splice_tokens(hyp_token_array_t* tokens, size_t first, size_t end,
+                          const hyp_token_array_t* scanned, uint32_t delta) {
+    size_t count = tokens->count;
+    size_t inserted = scanned->count;
+    size_t new_count = count - (end - first) + inserted;
+    if (new_count > tokens->capacity && !grow_tokens(tokens, new_count + new_count / 2, NULL)) {
+        return false;
+    }
+    
+    if (inserted == end - first) {
+        /* Nothing changes block: move the rest of the edit's block, then
+         * the later blocks by their bases */
+        size_t block = end >> HYP_TOKEN_BLOCK_SHIFT;
+        size_t block_end = (block + 1) << HYP_TOKEN_BLOCK_SHIFT;
+        for (size_t i = end; i < count && i < block_end; i++) {
+            tokens->starts[i] += delta;
+        }
+        for (size_t i = block + 1; i <= (count - 1) >> HYP_TOKEN_BLOCK_SHIFT; i++) {
+            tokens->bases[i] += delta;
+        }
+    } else {
+        /* Tokens after the edit move to other blocks, so they are made
+         * absolute while they move; blocks starting after first are
+         * then based at 0 */
+        size_t tail = count - end;
+        for (size_t i = end; i < count; i++) {
+            tokens->starts[i] = (uint32_t)hyp_token_start(tokens, i) + delta;
+        }
+        memmove(tokens->types + first + inserted, tokens->types + end, tail * sizeof(uint8_t));
+        memmove(tokens->starts + first + inserted, tokens->starts + end, tail * sizeof(uint32_t));
+        memmove(tokens->lengths + first + inserted, tokens->lengths + end, tail * sizeof(uint32_t));
+        
+        size_t block = (first + HYP_TOKEN_BLOCK - 1) >> HYP_TOKEN_BLOCK_SHIFT;
+        for (size_t i = block; i <= (new_count - 1) >> HYP_TOKEN_BLOCK_SHIFT; i++) {
+            tokens->bases[i] = 0;
+        }
+        for (size_t i = first + inserted; i < new_count; i++) {
+            tokens->starts[i] -= tokens->bases[i >> HYP_TOKEN_BLOCK_SHIFT];
+        }
+    }
+    
+    for (size_t i = 0; i < inserted; i++) {
+        tokens->starts[first + i] = (uint32_t)hyp_token_start(scanned, i) -
+                                    tokens->bases[(first + i) >> HYP_TOKEN_BLOCK_SHIFT];
+    }
+    if (inserted) {
+        memcpy(tokens->types + first, scanned->types, inserted * sizeof(uint8_t));
+        memcpy(tokens->lengths + first, scanned->lengths, inserted * sizeof(uint32_t));
+    }
+    tokens->count = new_count;
+    
+    /* Literals likewise; theirs are numbered from 0 */
+    size_t low = literals_from(tokens, first);
+    size_t high = literals_from(tokens, end);
+    size_t added = scanned->literals.count;
+    size_t literal_count = tokens->literals.count - (high - low) + added;
+    if (literal_count > tokens->literals.capacity) {
+        hyp_token_literal_t* grown = HYP_REALLOC(tokens->literals.data, literal_count * sizeof(hyp_token_literal_t));
+        if (!grown) return false;
+        tokens->literals.data = grown;
+        tokens->literals.capacity = literal_count;
+    }
+    
+    hyp_token_literal_t* literals = tokens->literals.data;
+    if (added != high - low || inserted != end - first) {
+        memmove(literals + low + added, literals + high, (tokens->literals.count - high) * sizeof(hyp_token_literal_t));
+        for (size_t i = low + added; i < literal_count; i++) {
+            literals[i].token = (uint32_t)(literals[i].token - end + first + inserted);
+        }
+    }
+    for (size_t i = 0; i < added; i++) {
+        literals[low + i] = scanned->literals.data[i];
+        literals[low + i].token += (uint32_t)first;
+    }
+    tokens->literals.count = literal_count;
+    return true;
+}
+
+/* Scan the whole new source, replacing every token */
+static hyp_error_t rescan_all(hyp_lexer_t* lexer, hyp_token_edit_t* edit) {
+    size_t count = lexer->tokens.count;
+    
+    lexer->current = 0;
+    lexer->jsx_depth = 0;
+    lexer->in_jsx = false;
+    hyp_error_t result = hyp_lexer_tokenize(lexer);
+    
+    edit->first = 0;
+    edit->removed = count;
+    edit->inserted = lexer->tokens.count;
+    return result;
+}
+
+hyp_error_t hyp_lexer_edit(hyp_lexer_t* lexer, const char* source, size_t length,
+                           size_t offset, size_t removed, size_t inserted, hyp_token_edit_t* edit) {
+    if (!lexer || !source || !edit) return HYP_ERROR_INVALID_ARG;
+    
+    size_t old_length = lexer->source_length;
+    if (offset > old_length || removed > old_length - offset ||
+        length != old_length - removed + inserted) {
+        return HYP_ERROR_INVALID_ARG;
+    }
+    
+    memset(edit, 0, sizeof(hyp_token_edit_t));
+    edit->end = offset + inserted;
+    
+    bool indexed = edit_lines(lexer, source, offset, removed, inserted, &edit->lines);
+    if (!indexed) lexer->line_count = 0;
+    lexer->source = source;
+    lexer->source_length = length;
+    lexer->has_error = false;
+    
+    /* Without the old line numbers nothing old can be kept */
+    hyp_token_array_t* tokens = &lexer->tokens;
+    if (!indexed || tokens->count == 0 || lexer->has_jsx || length >= UINT32_MAX) {
+        return rescan_all(lexer, edit);
+    }
+    
+    /* Start two tokens before the edit: the token it touches may grow,
+     * and the one before that may have looked a character into it */
+    size_t count = tokens->count;
+    size_t first = tokens_after(tokens, 0, offset == 0 ? 0 : offset - 1);
+    first = first > 2 ? first - 2 : 0;
+    
+    /* Old tokens from this one on start past the edit */
+    size_t old = tokens_after(tokens, first, offset + removed == 0 ? 0 : offset + removed - 1);
+    ptrdiff_t delta = (ptrdiff_t)inserted - (ptrdiff_t)removed;
+    
+    /* The new tokens are scanned into scratch space in the arena */
+    hyp_token_array_t scanned;
+    memset(&scanned, 0, sizeof(scanned));
+    HYP_ARRAY_INIT(&scanned.literals);
+    hyp_arena_mark_t mark = hyp_arena_mark(lexer->arena);
+    
+    /* An edit before the first token may be in a comment ahead of it */
+    lexer->current = first ? hyp_token_start(tokens, first) : 0;
+    lexer->jsx_depth = 0;
+    lexer->in_jsx = false;
+    
+    hyp_error_t result = HYP_OK;
+    size_t end = count;
+    for (;;) {
+        hyp_token_t token = hyp_lexer_scan_token(lexer);
+        if (lexer->in_jsx) {
+            result = HYP_ERROR_NOT_FOUND;
+            break;
+        }
+        
+        /* Caught up with an old token: the rest is as it was */
+        if (token.position >= edit->end) {
+            while (old < count && (ptrdiff_t)hyp_token_start(tokens, old) + delta < (ptrdiff_t)token.position) old++;
+            if (old < count && (ptrdiff_t)hyp_token_start(tokens, old) + delta == (ptrdiff_t)token.position) {
+                end = old;
+                break;
+            }
+        }
+        
+        if (!push_token(&scanned, lexer, &token, lexer->arena)) {
+            result = HYP_ERROR_MEMORY;
+            break;
+        }
+        if (token.type == TOKEN_EOF) break;
+    }
+    
+    if (result == HYP_OK && !splice_tokens(tokens, first, end, &scanned, (uint32_t)delta)) {
+        result = HYP_ERROR_MEMORY;
+    }
+    if (result == HYP_OK) {
+        edit->first = first;
+        edit->removed = end - first;
+        edit->inserted = scanned.count;
+        hyp_metric_add(&metric_edits, 1);
+    }
+    
+    hyp_arena_rewind(lexer->arena, mark);
+    HYP_ARRAY_FREE(&scanned.literals);
+    
+    /* JSX, or a failure part way through a splice */
+    return result == HYP_OK ? HYP_OK : rescan_all(lexer, edit);
+}
+
+const hyp_token_literal_t* hyp_lexer_token_literal(const hyp_lexer_t* lexer, size_t index) {
+    if (!lexer) return NULL;
+    
+    /* Literals are pushed in token order */
+    const hyp_token_literal_t* literals = lexer->tokens.literals.data;
+    size_t low = 0;
+    size_t high = lexer->tokens.literals.count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (literals[middle].token < index) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    
+    if (low < lexer->tokens.literals.count && literals[low].token == index) {
+        return &literals[low];
+    }
+    return NULL;
+}
+
+/* Record where every line of the source starts */
+static bool index_lines(hyp_lexer_t* lexer) {
+    size_t capacity = 64;
+    uint32_t* starts = HYP_REALLOC(lexer->line_starts, capacity * sizeof(uint32_t));
+    if (!starts) return false;
+    
+    size_t count = 0;
+    starts[count++] = 0;
+    
+    const char* p = lexer->source;
+    const char* end = lexer->source + lexer->source_length;
+    while ((p = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+        p++;
+        if (count == capacity) {
+            uint32_t* grown = HYP_REALLOC(starts, capacity * 2 * sizeof(uint32_t));
+            if (!grown) {
+                lexer->line_starts = starts;
+                return false;
+            }
+            starts = grown;
+            capacity *= 2;
+        }
+        starts[count++] = (uint32_t)(p - lexer->source);
+    }
+    
+    lexer->line_starts = starts;
+    lexer->line_count = count;
+    lexer->line_cursor = 0;
+    return true;
+}
+
+void hyp_lexer_location(hyp_lexer_t* lexer, size_t offset, size_t* line, size_t* column) {
+    *line = 0;
+    *column = 0;
+    if (!lexer) return;
+    
+    if (lexer->line_count == 0 && !index_lines(lexer)) return;
+    
+    const uint32_t* starts = lexer->line_starts;
+    size_t count = lexer->line_count;
+    size_t index = lexer->line_cursor;
+    
+    if (starts[index] <= offset) {
+        /* Usually the same line or one of the next few */
+        size_t steps = 0;
+        while (index + 1 < count && starts[index + 1] <= offset && steps < 8) {
+            index++;
+            steps++;
+        }
+    }
+    
+    if (starts[index] > offset || (index + 1 < count && starts[index + 1] <= offset)) {
+        /* Find the last line starting at or before offset */
+        size_t low = 0;
+        size_t high = count;
+        while (high - low > 1) {
+            size_t middle = low + (high - low) / 2;
+            if (starts[middle] <= offset) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        index = low;
+    }
+    
+    lexer->line_cursor = index;
+    *line = lexer->first_line + index;
+    *column = offset - starts[index] + 1;
+}
+
 void hyp_token_print(const hyp_token_t* token) {
     if (!token) return;
     
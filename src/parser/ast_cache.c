@@ -0,0 +1,456 @@
+/**
+ * Hyper Programming Language - Binary AST Cache Implementation
+ */
+
+#define HYP_MEM_TAG HYP_MEM_PARSER
+
+#include "../../include/ast_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Entry header; the tree follows it, so the header size (two slots)
+ * keeps the slots as aligned as the mapping itself */
+#define AST_CACHE_MAGIC "HYPAST\r\n"
+
+/* Bump when the header or the checks on load change */
+#define AST_CACHE_FORMAT 2
+
+typedef struct {
+    char magic[8];
+    uint32_t format;             /* AST_CACHE_FORMAT, in host byte order */
+    uint32_t version;            /* HYP_PARSER_VERSION */
+    uint32_t node_size;          /* sizeof(hyp_ast_node_t) */
+    uint32_t reserved;
+    uint64_t key;
+    uint64_t size;               /* Bytes of tree after the header */
+    uint64_t checksum;           /* tree_checksum of those bytes */
+    uint8_t padding[16];
+} ast_cache_header_t;
+
+void hyp_ast_cache_init(hyp_ast_cache_t* cache) {
+    memset(cache, 0, sizeof(hyp_ast_cache_t));
+
+    const char* dir = getenv(HYP_AST_CACHE_ENV);
+    if (!dir) {
+        bool known = hyp_user_cache_dir(HYP_AST_CACHE_NAME, cache->default_dir, sizeof(cache->default_dir));
+        dir = known ? cache->default_dir : "";
+    }
+    cache->dir = *dir ? dir : NULL;
+}
+
+uint64_t hyp_ast_cache_key(const char* source, size_t size) {
+    uint64_t settings[2] = { HYP_PARSER_VERSION, sizeof(hyp_ast_node_t) };
+
+    uint64_t hash = hyp_hash_string(HYP_VERSION_STRING, HYP_HASH_SEED);
+    hash = hyp_hash_bytes(settings, sizeof(settings), hash);
+    return hyp_hash_bytes(source, size, hash);
+}
+
+/* <dir>/<key>.ast */
+static char* entry_path(const hyp_ast_cache_t* cache, uint64_t key, const char* suffix) {
+    size_t size = strlen(cache->dir) + strlen(suffix) + 24;
+    char* path = HYP_MALLOC(size);
+    if (!path) return NULL;
+
+    snprintf(path, size, "%s/%016llx.ast%s", cache->dir, (unsigned long long)key, suffix);
+    return path;
+}
+
+/* Multiply-xor over 64-bit words in four independent lanes, so checking
+ * runs near memory speed; it detects damage, not tampering */
+static uint64_t tree_checksum(const void* data, size_t size) {
+    const unsigned char* bytes = data;
+    uint64_t lanes[4] = { HYP_HASH_SEED, HYP_HASH_SEED + 1, HYP_HASH_SEED + 2, HYP_HASH_SEED + 3 };
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; lane++) {
+            uint64_t word;
+            memcpy(&word, bytes + i + lane * 8, sizeof(word));
+            uint64_t mixed = lanes[lane] ^ word;
+            lanes[lane] = ((mixed << 29) | (mixed >> 35)) * 0x100000001b3ULL;
+        }
+    }
+
+    uint64_t hash = hyp_hash_bytes(bytes + i, size - i, HYP_HASH_SEED);
+    hash = hyp_hash_bytes(lanes, sizeof(lanes), hash);
+    return hyp_hash_bytes(&size, sizeof(size), hash);
+}
+
+/* Walk of a loaded tree, following every link once; a damaged entry
+ * could otherwise send readers anywhere in memory */
+typedef struct {
+    const char* base;
+    size_t size;
+    uint64_t* visited;           /* One bit per slot */
+    size_t cursor;               /* Slots are checked in order up to here */
+    uint32_t* pending;           /* Slots before the cursor still to check */
+    size_t pending_count;
+} tree_check_t;
+
+/* Bytes from the start of the tree to the target of the link at at */
+static int64_t link_offset(const tree_check_t* check, const int32_t* at) {
+    return (int64_t)((const char*)at - check->base) + *at;
+}
+
+static bool check_node_link(tree_check_t* check, const hyp_ast_ref_t* ref) {
+    if (!*ref) return true;
+
+    int64_t offset = link_offset(check, ref);
+    if (offset < 0 || offset % (int64_t)sizeof(hyp_ast_node_t) != 0 ||
+        (uint64_t)offset + sizeof(hyp_ast_node_t) > check->size) {
+        return false;
+    }
+
+    /* Every node has one parent; a second link to it (a cycle, which
+     * would never end a walk, or a shared subtree) means damage */
+    size_t slot = (size_t)offset / sizeof(hyp_ast_node_t);
+    if ((check->visited[slot / 64] >> (slot % 64)) & 1) return false;
+    check->visited[slot / 64] |= (uint64_t)1 << (slot % 64);
+    if (slot < check->cursor) {
+        check->pending[check->pending_count++] = (uint32_t)slot;
+    }
+    return true;
+}
+
+static bool check_text(const tree_check_t* check, const hyp_ast_text_t* text) {
+    if (!*text) return true;
+
+    int64_t offset = link_offset(check, text);
+    if (offset < 0 || (uint64_t)offset >= check->size) return false;
+    /* Strings are short; a plain loop beats a call to memchr */
+    for (const char* c = check->base + offset; c < check->base + check->size; c++) {
+        if (!*c) return true;
+    }
+    return false;
+}
+
+/* First entry of a list of count entries of entry_size bytes, or NULL if
+ * they do not all lie inside the tree */
+static const char* check_list(const tree_check_t* check, const hyp_ast_list_t* list, size_t entry_size) {
+    int64_t offset = link_offset(check, &list->items);
+    if (list->count == 0) return check->base;
+    if (offset < 0 || offset % (int64_t)sizeof(int32_t) != 0 || (uint64_t)offset > check->size ||
+        (uint64_t)list->count * entry_size > check->size - (uint64_t)offset) {
+        return NULL;
+    }
+    return check->base + offset;
+}
+
+static bool check_node_list(tree_check_t* check, const hyp_ast_list_t* list) {
+    const hyp_ast_ref_t* refs = (const hyp_ast_ref_t*)check_list(check, list, sizeof(hyp_ast_ref_t));
+    if (!refs) return false;
+    for (uint32_t i = 0; i < list->count; i++) {
+        if (!check_node_link(check, &refs[i])) return false;
+    }
+    return true;
+}
+
+static bool check_parameters(tree_check_t* check, const hyp_ast_list_t* list) {
+    const hyp_parameter_t* parameters =
+        (const hyp_parameter_t*)check_list(check, list, sizeof(hyp_parameter_t));
+    if (!parameters) return false;
+    for (uint32_t i = 0; i < list->count; i++) {
+        if (!check_text(check, &parameters[i].name) ||
+            !check_node_link(check, &parameters[i].default_value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool check_node(tree_check_t* check, const hyp_ast_node_t* node) {
+    switch ((hyp_ast_node_type_t)node->type) {
+        case AST_NUMBER:
+        case AST_BOOLEAN:
+        case AST_NULL:
+        case AST_BREAK_STMT:
+        case AST_CONTINUE_STMT:
+        case AST_TYPE_DECL:
+        case AST_STRUCT_DECL:
+        case AST_ENUM_DECL:
+            return true;
+        case AST_STRING:
+            return check_text(check, &node->string.value);
+        case AST_IDENTIFIER:
+            return check_text(check, &node->identifier.name);
+        case AST_BINARY_OP:
+            return (unsigned)node->binary_op.op <= BINOP_PIPE &&
+                   check_node_link(check, &node->binary_op.left) &&
+                   check_node_link(check, &node->binary_op.right);
+        case AST_UNARY_OP:
+            return (unsigned)node->unary_op.op <= UNOP_DECREMENT &&
+                   check_node_link(check, &node->unary_op.operand);
+        case AST_ASSIGNMENT:
+            return (unsigned)node->assignment.op <= ASSIGN_POW &&
+                   check_node_link(check, &node->assignment.target) &&
+                   check_node_link(check, &node->assignment.value);
+        case AST_CALL:
+            return check_node_link(check, &node->call.callee) &&
+                   check_node_list(check, &node->call.arguments);
+        case AST_MEMBER_ACCESS:
+            return check_node_link(check, &node->member_access.object) &&
+                   check_text(check, &node->member_access.member);
+        case AST_INDEX_ACCESS:
+            return check_node_link(check, &node->index_access.object) &&
+                   check_node_link(check, &node->index_access.index);
+        case AST_CONDITIONAL:
+            return check_node_link(check, &node->conditional.condition) &&
+                   check_node_link(check, &node->conditional.then_expr) &&
+                   check_node_link(check, &node->conditional.else_expr);
+        case AST_ARRAY_LITERAL:
+            return check_node_list(check, &node->array_literal.elements);
+        case AST_OBJECT_LITERAL: {
+            const hyp_ast_list_t* list = &node->object_literal.properties;
+            const hyp_object_property_t* properties =
+                (const hyp_object_property_t*)check_list(check, list, sizeof(hyp_object_property_t));
+            if (!properties) return false;
+            for (uint32_t i = 0; i < list->count; i++) {
+                if (!check_text(check, &properties[i].key) || !check_node_link(check, &properties[i].value)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case AST_LAMBDA:
+            return check_parameters(check, &node->lambda.parameters) &&
+                   check_node_link(check, &node->lambda.body);
+        case AST_EXPRESSION_STMT:
+            return check_node_link(check, &node->expression_stmt.expression);
+        case AST_VARIABLE_DECL:
+            return check_text(check, &node->variable_decl.name) &&
+                   check_node_link(check, &node->variable_decl.initializer);
+        case AST_FUNCTION_DECL:
+            return check_text(check, &node->function_decl.name) &&
+                   check_parameters(check, &node->function_decl.parameters) &&
+                   check_node_link(check, &node->function_decl.body);
+        case AST_IF_STMT:
+            return check_node_link(check, &node->if_stmt.condition) &&
+                   check_node_link(check, &node->if_stmt.then_stmt) &&
+                   check_node_link(check, &node->if_stmt.else_stmt);
+        case AST_WHILE_STMT:
+            return check_node_link(check, &node->while_stmt.condition) &&
+                   check_node_link(check, &node->while_stmt.body);
+        case AST_FOR_STMT:
+            return check_node_link(check, &node->for_stmt.init) &&
+                   check_node_link(check, &node->for_stmt.condition) &&
+                   check_node_link(check, &node->for_stmt.update) &&
+                   check_node_link(check, &node->for_stmt.body);
+        case AST_RETURN_STMT:
+            return check_node_link(check, &node->return_stmt.value);
+        case AST_BLOCK_STMT:
+            return check_node_list(check, &node->block_stmt.statements);
+        case AST_IMPORT_STMT:
+            return check_text(check, &node->import_stmt.module) &&
+                   check_text(check, &node->import_stmt.alias) &&
+                   check_node_list(check, &node->import_stmt.imports);
+        case AST_EXPORT_STMT:
+            return check_node_link(check, &node->export_stmt.declaration);
+        case AST_MATCH_STMT: {
+            const hyp_ast_list_t* list = &node->match_stmt.cases;
+            const hyp_match_case_t* cases =
+                (const hyp_match_case_t*)check_list(check, list, sizeof(hyp_match_case_t));
+            if (!cases || !check_node_link(check, &node->match_stmt.expression)) return false;
+            for (uint32_t i = 0; i < list->count; i++) {
+                if (!check_node_link(check, &cases[i].pattern) || !check_node_link(check, &cases[i].guard) ||
+                    !check_node_link(check, &cases[i].body)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case AST_TRY_STMT:
+            return check_node_link(check, &node->try_stmt.try_block) &&
+                   check_text(check, &node->try_stmt.catch_variable) &&
+                   check_node_link(check, &node->try_stmt.catch_block) &&
+                   check_node_link(check, &node->try_stmt.finally_block);
+        case AST_PROGRAM:
+            return check_node_list(check, &node->program.statements);
+    }
+    return false;    /* Not a node type this build knows */
+}
+
+/* Whether every link reachable from the root stays inside the tree and
+ * every node, list and string it reaches is well formed */
+static bool tree_valid(const hyp_ast_node_t* root, size_t size) {
+    size_t slots = size / sizeof(hyp_ast_node_t);
+    if (slots > UINT32_MAX || root->type != AST_PROGRAM) return false;
+
+    tree_check_t check;
+    check.base = (const char*)root;
+    check.size = size;
+    check.visited = HYP_CALLOC((slots + 63) / 64, sizeof(uint64_t));
+    check.cursor = 0;
+    check.pending = HYP_MALLOC(slots * sizeof(uint32_t));
+    check.pending_count = 0;
+    bool valid = check.visited && check.pending;
+
+    /* Most links point forward, so sweeping the slots in order reads the
+     * tree front to back; a link back behind the sweep is checked at once */
+    if (valid) check.visited[0] = 1;
+    for (size_t word = 0; valid && word < (slots + 63) / 64; word++) {
+        for (size_t bit = 0; valid && bit < 64; bit++) {
+            if (!((check.visited[word] >> bit) & 1)) continue;
+            check.cursor = word * 64 + bit + 1;
+            valid = check_node(&check, &root[word * 64 + bit]);
+            while (valid && check.pending_count > 0) {
+                valid = check_node(&check, &root[check.pending[--check.pending_count]]);
+            }
+        }
+    }
+
+    HYP_FREE(check.visited);
+    HYP_FREE(check.pending);
+    return valid;
+}
+
+/* Whether a file of file_size bytes starting with header is the entry
+ * this build would have written for key, intact */
+static bool entry_valid(const ast_cache_header_t* header, size_t file_size, uint64_t key) {
+    if (file_size < sizeof(ast_cache_header_t) + sizeof(hyp_ast_node_t)) return false;
+    if (memcmp(header->magic, AST_CACHE_MAGIC, sizeof(header->magic)) != 0) return false;
+    if (header->format != AST_CACHE_FORMAT || header->version != HYP_PARSER_VERSION ||
+        header->node_size != sizeof(hyp_ast_node_t)) {
+        return false;
+    }
+    if (header->key != key) return false;
+
+    /* A short file is a write that never finished */
+    if (header->size != file_size - sizeof(ast_cache_header_t)) return false;
+    if (header->size % sizeof(hyp_ast_node_t) != 0) return false;
+
+    const hyp_ast_node_t* root = (const hyp_ast_node_t*)(header + 1);
+    if (tree_checksum(root, (size_t)header->size) != header->checksum) return false;
+    return tree_valid(root, (size_t)header->size);
+}
+
+hyp_error_t hyp_ast_cache_load(hyp_ast_cache_t* cache, uint64_t key, hyp_ast_image_t* image) {
+    if (!cache || !image) return HYP_ERROR_INVALID_ARG;
+    memset(image, 0, sizeof(hyp_ast_image_t));
+    if (!cache->dir) return HYP_ERROR_NOT_FOUND;
+
+    char* path = entry_path(cache, key, "");
+    if (!path) return HYP_ERROR_MEMORY;
+
+    /* Large entries are mapped; the tree is then used where it lies */
+    hyp_source_t file;
+    hyp_error_t result = hyp_source_load(&file, path);
+    HYP_FREE(path);
+
+    if (result == HYP_OK) {
+        const ast_cache_header_t* header = (const ast_cache_header_t*)file.data;
+        if (!entry_valid(header, file.size, key)) {
+            /* Damaged, or written by another build: drop it so the
+             * caller's parse replaces it */
+            hyp_source_release(&file);
+            char* stale = entry_path(cache, key, "");
+            if (stale) remove(stale);
+            HYP_FREE(stale);
+            cache->rejected++;
+            result = HYP_ERROR_NOT_FOUND;
+        } else {
+            image->root = (hyp_ast_node_t*)(header + 1);
+            image->size = (size_t)header->size;
+            image->from_cache = true;
+            image->file = file;
+        }
+    }
+
+    if (result == HYP_OK) {
+        cache->hits++;
+    } else {
+        cache->misses++;
+    }
+    return result == HYP_OK ? HYP_OK : HYP_ERROR_NOT_FOUND;
+}
+
+hyp_error_t hyp_ast_cache_store(hyp_ast_cache_t* cache, uint64_t key, const hyp_ast_node_t* root, size_t size) {
+    if (!cache || !root || size < sizeof(hyp_ast_node_t)) return HYP_ERROR_INVALID_ARG;
+    if (!cache->dir) return HYP_OK;
+
+    hyp_error_t result = hyp_make_directory(cache->dir);
+    if (result != HYP_OK) return result;
+
+    char* path = entry_path(cache, key, "");
+    char* temp_path = entry_path(cache, key, ".tmp");
+    if (!path || !temp_path) {
+        HYP_FREE(path);
+        HYP_FREE(temp_path);
+        return HYP_ERROR_MEMORY;
+    }
+
+    ast_cache_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, AST_CACHE_MAGIC, sizeof(header.magic));
+    header.format = AST_CACHE_FORMAT;
+    header.version = HYP_PARSER_VERSION;
+    header.node_size = sizeof(hyp_ast_node_t);
+    header.key = key;
+    header.size = size;
+    header.checksum = tree_checksum(root, size);
+
+    /* Written aside and renamed, so readers never see half an entry */
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) {
+        result = HYP_ERROR_IO;
+    } else {
+        bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                       fwrite(root, 1, size, file) == size;
+        if (fclose(file) != 0 || !written) result = HYP_ERROR_IO;
+    }
+#ifdef _WIN32
+    /* rename() does not replace an existing file on Windows */
+    if (result == HYP_OK) remove(path);
+#endif
+    if (result == HYP_OK && rename(temp_path, path) != 0) result = HYP_ERROR_IO;
+    if (result != HYP_OK) remove(temp_path);
+
+    if (result == HYP_OK) cache->stores++;
+    HYP_FREE(path);
+    HYP_FREE(temp_path);
+    return result;
+}
+
+hyp_error_t hyp_ast_cache_parse(hyp_ast_cache_t* cache, hyp_lexer_t* lexer,
+                                const char* source, size_t size, hyp_ast_image_t* image) {
+    if (!lexer || !image) return HYP_ERROR_INVALID_ARG;
+    memset(image, 0, sizeof(hyp_ast_image_t));
+
+    bool cached = cache && cache->dir;
+    uint64_t key = cached ? hyp_ast_cache_key(source, size) : 0;
+    if (cached && !cache->force && hyp_ast_cache_load(cache, key, image) == HYP_OK) {
+        return HYP_OK;
+    }
+
+    hyp_parser_t* parser = hyp_parser_create(lexer);
+    if (!parser) return HYP_ERROR_MEMORY;
+    parser->jobs = cache ? cache->jobs : 0;
+    parser->messages = cache ? cache->messages : NULL;
+
+    hyp_ast_node_t* root = hyp_parser_parse(parser);
+    if (!root || parser->had_error) {
+        hyp_parser_destroy(parser);
+        return HYP_ERROR_SYNTAX;
+    }
+
+    image->root = root;
+    image->size = parser->tree_size;
+    image->parser = parser;
+
+    /* The cache only saves time; failing to fill it is not an error */
+    if (cached && hyp_ast_cache_store(cache, key, root, image->size) != HYP_OK) {
+        cache->failures++;
+    }
+    return HYP_OK;
+}
+
+void hyp_ast_image_release(hyp_ast_image_t* image) {
+    if (!image) return;
+
+    if (image->from_cache) {
+        hyp_source_release(&image->file);
+    }
+    hyp_parser_destroy(image->parser);
+    memset(image, 0, sizeof(hyp_ast_image_t));
+}
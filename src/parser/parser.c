@@ -2,62 +2,106 @@
  * Hyper Programming Language - Parser Implementation
  * 
  * Builds Abstract Syntax Tree (AST) from tokens produced by the lexer.
- * Implements recursive descent parsing for the Hyper language grammar.
+ * Statements are parsed by recursive descent; expressions by precedence
+ * climbing (Pratt) over a table of binding powers.
  */
 
+#define HYP_MEM_TAG HYP_MEM_PARSER
+
 #include "../../include/parser.h"
 #include "../../include/lexer.h"
 #include "../../include/hyp_common.h"
+#include "../../include/hyp_thread.h"
+#include "../../include/hyp_metrics.h"
+#include <stdarg.h>
+#include <stddef.h>
 #include <string.h>
 
 /* Parser implementation */
 
+/* Metrics, per parse or update */
+static hyp_metric_t metric_parse = HYP_HISTOGRAM("parser.parse", "Time to parse a source");
+static hyp_metric_t metric_nodes = HYP_COUNTER("parser.nodes", "Syntax tree slots built");
+static hyp_metric_t metric_errors = HYP_COUNTER("parser.failures", "Parses that reported syntax errors");
+static hyp_metric_t metric_update = HYP_HISTOGRAM("parser.update", "Time to update a tree after an edit");
+
+/* Nodes are named by slot while the tree is built, since the slot
+ * buffer moves as it grows; slot 0 holds the program node, so 0 doubles
+ * as "no node". */
+typedef uint32_t slot_t;
+
 /* Forward declarations */
-static hyp_ast_node_t* parse_expression(hyp_parser_t* parser);
-static hyp_ast_node_t* parse_statement(hyp_parser_t* parser);
-static hyp_ast_node_t* parse_declaration(hyp_parser_t* parser);
+static slot_t parse_expression(hyp_parser_t* parser);
+static slot_t parse_statement(hyp_parser_t* parser);
+static slot_t parse_declaration(hyp_parser_t* parser);
+
+/* Token access; tokens are indexes into the lexer's token arrays */
+#define TOKEN_TYPE(parser, index) ((hyp_token_type_t)(parser)->lexer->tokens.types[index])
+#define TOKEN_START(parser, index) hyp_token_start(&(parser)->lexer->tokens, (index))
+#define TOKEN_TEXT(parser, index) ((parser)->lexer->source + TOKEN_START(parser, index))
+#define TOKEN_LENGTH(parser, index) ((size_t)(parser)->lexer->tokens.lengths[index])
 
 /* Error handling */
-static void error_at(hyp_parser_t* parser, hyp_token_t* token, const char* message) {
+static void report(hyp_parser_t* parser, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (parser->messages) {
+        hyp_out_vprintf(parser->messages, format, args);
+    } else {
+        vfprintf(stderr, format, args);
+    }
+    va_end(args);
+}
+
+static void error_at(hyp_parser_t* parser, size_t token, const char* message) {
     if (parser->panic_mode) return;
     parser->panic_mode = true;
     
-    fprintf(stderr, "[line %zu:%zu] Error", token->line, token->column);
+    size_t line, column;
+    hyp_lexer_location(parser->lexer, TOKEN_START(parser, token), &line, &column);
+    report(parser, "[line %zu:%zu] Error", line, column);
     
-    if (token->type == TOKEN_EOF) {
-        fprintf(stderr, " at end");
-    } else if (token->type == TOKEN_ERROR) {
+    if (TOKEN_TYPE(parser, token) == TOKEN_EOF) {
+        report(parser, " at end");
+    } else if (TOKEN_TYPE(parser, token) == TOKEN_ERROR) {
         /* Nothing */
     } else {
-        fprintf(stderr, " at '%.*s'", (int)token->lexeme.length, token->lexeme.data);
+        report(parser, " at '%.*s'", (int)TOKEN_LENGTH(parser, token), TOKEN_TEXT(parser, token));
     }
     
-    fprintf(stderr, ": %s\n", message);
+    report(parser, ": %s\n", message);
     parser->had_error = true;
 }
 
 static void error(hyp_parser_t* parser, const char* message) {
-    error_at(parser, &parser->previous, message);
+    error_at(parser, parser->previous, message);
 }
 
 static void error_at_current(hyp_parser_t* parser, const char* message) {
-    error_at(parser, &parser->current, message);
+    error_at(parser, parser->current, message);
 }
 
 /* Token management */
+static void skip_error_tokens(hyp_parser_t* parser) {
+    /* The last token is always TOKEN_EOF */
+    while (TOKEN_TYPE(parser, parser->current) == TOKEN_ERROR) {
+        const hyp_token_literal_t* literal = hyp_lexer_token_literal(parser->lexer, parser->current);
+        error_at_current(parser, literal ? literal->value.message : "Invalid token");
+        parser->current++;
+    }
+}
+
 static void advance(hyp_parser_t* parser) {
     parser->previous = parser->current;
     
-    for (;;) {
-        parser->current = hyp_lexer_next_token(parser->lexer);
-        if (parser->current.type != TOKEN_ERROR) break;
-        
-        error_at_current(parser, parser->current.lexeme.data);
+    if (parser->current + 1 < parser->lexer->tokens.count) {
+        parser->current++;
+        skip_error_tokens(parser);
     }
 }
 
 static bool check(hyp_parser_t* parser, hyp_token_type_t type) {
-    return parser->current.type == type;
+    return TOKEN_TYPE(parser, parser->current) == type;
 }
 
 static bool match(hyp_parser_t* parser, hyp_token_type_t type) {
@@ -67,7 +111,7 @@ static bool match(hyp_parser_t* parser, hyp_token_type_t type) {
 }
 
 static void consume(hyp_parser_t* parser, hyp_token_type_t type, const char* message) {
-    if (parser->current.type == type) {
+    if (check(parser, type)) {
         advance(parser);
         return;
     }
@@ -75,36 +119,180 @@ static void consume(hyp_parser_t* parser, hyp_token_type_t type, const char* mes
     error_at_current(parser, message);
 }
 
-/* AST node creation helpers */
-static hyp_ast_node_t* create_node(hyp_parser_t* parser, hyp_ast_node_type_t type) {
-    hyp_ast_node_t* node = hyp_arena_alloc(parser->arena, sizeof(hyp_ast_node_t));
-    if (!node) return NULL;
+/* Tokenize the lexer's source and point at its first token */
+static void load_tokens(hyp_parser_t* parser) {
+    parser->current = 0;
+    parser->previous = 0;
+    
+    if (hyp_lexer_tokenize(parser->lexer) != HYP_OK) {
+        fprintf(stderr, "Error: %s\n", parser->lexer->has_error ?
+                parser->lexer->error_message : "Out of memory while tokenizing");
+        parser->had_error = true;
+        return;
+    }
+    
+    skip_error_tokens(parser);
+}
+
+/* Tree construction */
+#define NODE(parser, slot) (&(parser)->slots[slot])
+#define SLOT_SIZE sizeof(hyp_ast_node_t)
+
+/* Make room for count more slots */
+static bool reserve_slots(hyp_parser_t* parser, size_t count) {
+    size_t needed = (size_t)parser->slot_count + count;
+    if (needed <= parser->slot_capacity) return true;
+    
+    size_t capacity = parser->slot_capacity ? parser->slot_capacity : 256;
+    while (capacity < needed) capacity *= 2;
+    
+    /* Links are 32-bit byte offsets, so a tree must stay under 2 GB */
+    hyp_ast_node_t* slots = capacity <= INT32_MAX / SLOT_SIZE ?
+        HYP_REALLOC(parser->slots, capacity * SLOT_SIZE) : NULL;
+    if (!slots) {
+        error_at_current(parser, "Out of memory while building the syntax tree");
+        return false;
+    }
     
-    memset(node, 0, sizeof(hyp_ast_node_t));
-    node->type = type;
-    node->line = parser->previous.line;
-    node->column = parser->previous.column;
+    parser->slots = slots;
     
-    return node;
+    if (parser->incremental) {
+        size_t words = parser->slot_capacity / 64;
+        uint64_t* marks = HYP_REALLOC(parser->node_marks, capacity / 64 * sizeof(uint64_t));
+        if (!marks) {
+            error_at_current(parser, "Out of memory while building the syntax tree");
+            return false;
+        }
+        memset(marks + words, 0, (capacity / 64 - words) * sizeof(uint64_t));
+        parser->node_marks = marks;
+    }
+    
+    parser->slot_capacity = (uint32_t)capacity;
+    return true;
+}
+
+/* Take count zeroed slots; 0 if out of memory */
+static slot_t alloc_slots(hyp_parser_t* parser, size_t count) {
+    if (!reserve_slots(parser, count)) return 0;
+    
+    slot_t slot = parser->slot_count;
+    parser->slot_count += (uint32_t)count;
+    memset(NODE(parser, slot), 0, count * SLOT_SIZE);
+    return slot;
+}
+
+/* Point the link at byte offset `field` of slot `from` to slot `to`, or
+ * to nothing when `to` is 0 */
+static void set_link(hyp_parser_t* parser, slot_t from, size_t field, slot_t to) {
+    int32_t* link = (int32_t*)((char*)NODE(parser, from) + field);
+    *link = to ? (int32_t)((char*)NODE(parser, to) - (char*)link) : 0;
 }
 
-static char* copy_string(hyp_parser_t* parser, const char* start, size_t length) {
-    char* str = hyp_arena_alloc(parser->arena, length + 1);
-    if (!str) return NULL;
+#define LINK(parser, from, field, to) \
+    set_link((parser), (from), offsetof(hyp_ast_node_t, field), (to))
+
+/* Node marks, kept in incremental mode */
+#define MARKED(marks, slot) (((marks)[(slot) / 64] >> ((slot) % 64)) & 1)
+#define MARK(marks, slot) ((marks)[(slot) / 64] |= (uint64_t)1 << ((slot) % 64))
+
+/* AST node creation helpers */
+static slot_t create_node(hyp_parser_t* parser, hyp_ast_node_type_t type) {
+    slot_t slot = alloc_slots(parser, 1);
+    if (!slot) return 0;
+    
+    hyp_ast_node_t* node = NODE(parser, slot);
+    size_t line, column;
+    hyp_lexer_location(parser->lexer, TOKEN_START(parser, parser->previous), &line, &column);
+    node->type = (uint16_t)type;
+    node->line = (uint32_t)line;
+    node->column = (uint32_t)column;
+    
+    if (parser->node_marks) MARK(parser->node_marks, slot);
+    return slot;
+}
+
+static slot_t copy_string(hyp_parser_t* parser, const char* start, size_t length) {
+    slot_t slot = alloc_slots(parser, (length + SLOT_SIZE) / SLOT_SIZE);
+    if (!slot) return 0;
     
-    memcpy(str, start, length);
-    str[length] = '\0';
-    return str;
+    /* The slots come zeroed, so the text is already terminated */
+    memcpy(NODE(parser, slot), start, length);
+    return slot;
 }
 
+/* Copy a quoted string literal, stripping the quotes and decoding escapes */
+static slot_t copy_string_literal(hyp_parser_t* parser, const char* start, size_t length) {
+    if (length < 2) return copy_string(parser, start, 0);
+    
+    slot_t slot = alloc_slots(parser, (length - 2 + SLOT_SIZE) / SLOT_SIZE);
+    if (!slot) return 0;
+    
+    char* str = (char*)NODE(parser, slot);
+    size_t out = 0;
+    for (size_t i = 1; i < length - 1; i++) {
+        char c = start[i];
+        if (c == '\\' && i + 1 < length - 1) {
+            c = start[++i];
+            switch (c) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                default: break; /* \\, \", \' and unknown escapes map to themselves */
+            }
+        }
+        str[out++] = c;
+    }
+    return slot;
+}
+
+/* The text of the token just consumed */
+static slot_t copy_previous(hyp_parser_t* parser) {
+    return copy_string(parser, TOKEN_TEXT(parser, parser->previous), TOKEN_LENGTH(parser, parser->previous));
+}
+
+/* List entries are collected on parser->entries while the list is
+ * parsed, then written out as one run after the nodes they link to.
+ * Nested lists stack their entries above the outer list's. */
+static size_t list_begin(hyp_parser_t* parser) {
+    return parser->entries.count;
+}
+
+static void list_push(hyp_parser_t* parser, slot_t slot) {
+    HYP_ARRAY_PUSH(&parser->entries, slot);
+}
+
+/* Store the entries pushed since start in the list at byte offset
+ * `field` of slot owner, each entry being `width` links */
+static void list_end(hyp_parser_t* parser, slot_t owner, size_t field, size_t start, size_t width) {
+    size_t links = parser->entries.count - start;
+    slot_t run = links ? alloc_slots(parser, (links * sizeof(int32_t) + SLOT_SIZE - 1) / SLOT_SIZE) : 0;
+    
+    if (run) {
+        int32_t* items = (int32_t*)NODE(parser, run);
+        for (size_t i = 0; i < links; i++) {
+            slot_t to = parser->entries.data[start + i];
+            items[i] = to ? (int32_t)((char*)NODE(parser, to) - (char*)&items[i]) : 0;
+        }
+        
+        hyp_ast_list_t* list = (hyp_ast_list_t*)((char*)NODE(parser, owner) + field);
+        list->items = (int32_t)((char*)items - (char*)&list->items);
+        list->count = (uint32_t)(links / width);
+    }
+    
+    parser->entries.count = start;
+}
+
+#define LIST_END(parser, owner, field, start, width) \
+    list_end((parser), (owner), offsetof(hyp_ast_node_t, field), (start), (width))
+
 /* Synchronization for error recovery */
 static void synchronize(hyp_parser_t* parser) {
     parser->panic_mode = false;
     
-    while (parser->current.type != TOKEN_EOF) {
-        if (parser->previous.type == TOKEN_SEMICOLON) return;
+    while (TOKEN_TYPE(parser, parser->current) != TOKEN_EOF) {
+        if (TOKEN_TYPE(parser, parser->previous) == TOKEN_SEMICOLON) return;
         
-        switch (parser->current.type) {
+        switch (TOKEN_TYPE(parser, parser->current)) {
             case TOKEN_FUNC:
             case TOKEN_LET:
             case TOKEN_CONST:
@@ -112,6 +300,7 @@ static void synchronize(hyp_parser_t* parser) {
             case TOKEN_WHILE:
             case TOKEN_FOR:
             case TOKEN_RETURN:
+            case TOKEN_IMPORT:
                 return;
             default:
                 break;
@@ -122,382 +311,428 @@ static void synchronize(hyp_parser_t* parser) {
 }
 
 /* Expression parsing */
-static hyp_ast_node_t* parse_primary(hyp_parser_t* parser) {
+static slot_t parse_primary(hyp_parser_t* parser) {
     if (match(parser, TOKEN_BOOLEAN)) {
-        hyp_ast_node_t* node = create_node(parser, AST_BOOLEAN);
+        slot_t node = create_node(parser, AST_BOOLEAN);
+        if (node) {
+            NODE(parser, node)->boolean.value = TOKEN_TEXT(parser, parser->previous)[0] == 't';
+        }
+        return node;
+    }
+    
+    if (match(parser, TOKEN_TRUE) || match(parser, TOKEN_FALSE)) {
+        slot_t node = create_node(parser, AST_BOOLEAN);
         if (node) {
-            node->boolean.value = parser->previous.value.boolean;
+            NODE(parser, node)->boolean.value = TOKEN_TYPE(parser, parser->previous) == TOKEN_TRUE;
         }
         return node;
     }
     
+    if (match(parser, TOKEN_NULL)) {
+        return create_node(parser, AST_NULL);
+    }
+    
     if (match(parser, TOKEN_NUMBER)) {
-        hyp_ast_node_t* node = create_node(parser, AST_NUMBER);
+        slot_t node = create_node(parser, AST_NUMBER);
         if (node) {
-            node->number.value = parser->previous.value.number;
+            const hyp_token_literal_t* literal = hyp_lexer_token_literal(parser->lexer, parser->previous);
+            NODE(parser, node)->number.value = literal ? literal->value.number : 0;
         }
         return node;
     }
     
     if (match(parser, TOKEN_STRING)) {
-        hyp_ast_node_t* node = create_node(parser, AST_STRING);
+        slot_t node = create_node(parser, AST_STRING);
         if (node) {
-            node->string.value = copy_string(parser, parser->previous.lexeme.data, parser->previous.lexeme.length);
+            LINK(parser, node, string.value, copy_string_literal(parser,
+                 TOKEN_TEXT(parser, parser->previous), TOKEN_LENGTH(parser, parser->previous)));
         }
         return node;
     }
     
     if (match(parser, TOKEN_IDENTIFIER)) {
-        hyp_ast_node_t* node = create_node(parser, AST_IDENTIFIER);
+        slot_t node = create_node(parser, AST_IDENTIFIER);
         if (node) {
-            node->identifier.name = copy_string(parser, 
-                parser->previous.lexeme.data, parser->previous.lexeme.length);
+            LINK(parser, node, identifier.name, copy_previous(parser));
         }
         return node;
     }
     
     if (match(parser, TOKEN_LEFT_PAREN)) {
-        hyp_ast_node_t* expr = parse_expression(parser);
+        slot_t expr = parse_expression(parser);
         consume(parser, TOKEN_RIGHT_PAREN, "Expected ')' after expression");
         return expr;
     }
     
     if (match(parser, TOKEN_LEFT_BRACKET)) {
-        hyp_ast_node_t* node = create_node(parser, AST_ARRAY_LITERAL);
-        if (!node) return NULL;
-        
-        HYP_ARRAY_INIT(&node->array_literal.elements);
+        slot_t node = create_node(parser, AST_ARRAY_LITERAL);
+        if (!node) return 0;
         
+        size_t start = list_begin(parser);
         if (!check(parser, TOKEN_RIGHT_BRACKET)) {
             do {
-                hyp_ast_node_t* element = parse_expression(parser);
+                slot_t element = parse_expression(parser);
                 if (element) {
-                    HYP_ARRAY_PUSH(&node->array_literal.elements, element);
+                    list_push(parser, element);
                 }
             } while (match(parser, TOKEN_COMMA));
         }
+        LIST_END(parser, node, array_literal.elements, start, 1);
         
         consume(parser, TOKEN_RIGHT_BRACKET, "Expected ']' after array elements");
         return node;
     }
     
     if (match(parser, TOKEN_LEFT_BRACE)) {
-        hyp_ast_node_t* node = create_node(parser, AST_OBJECT_LITERAL);
-        if (!node) return NULL;
-        
-        HYP_ARRAY_INIT(&node->object_literal.properties);
+        slot_t node = create_node(parser, AST_OBJECT_LITERAL);
+        if (!node) return 0;
         
+        /* Entries are key, value pairs */
+        size_t start = list_begin(parser);
         if (!check(parser, TOKEN_RIGHT_BRACE)) {
             do {
-                hyp_object_property_t prop = {0};
-                
+                slot_t key;
                 if (match(parser, TOKEN_IDENTIFIER)) {
-                    prop.key = copy_string(parser, parser->previous.lexeme.data, parser->previous.lexeme.length);
+                    key = copy_previous(parser);
                 } else if (match(parser, TOKEN_STRING)) {
-                    prop.key = copy_string(parser, parser->previous.lexeme.data + 1, parser->previous.lexeme.length - 2);
+                    key = copy_string(parser, TOKEN_TEXT(parser, parser->previous) + 1, TOKEN_LENGTH(parser, parser->previous) - 2);
                 } else {
                     error(parser, "Expected property name");
                     break;
                 }
                 
                 consume(parser, TOKEN_COLON, "Expected ':' after property name");
-                prop.value = parse_expression(parser);
-                
-                HYP_ARRAY_PUSH(&node->object_literal.properties, prop);
+                list_push(parser, key);
+                list_push(parser, parse_expression(parser));
             } while (match(parser, TOKEN_COMMA));
         }
+        LIST_END(parser, node, object_literal.properties, start, 2);
         
         consume(parser, TOKEN_RIGHT_BRACE, "Expected '}' after object properties");
         return node;
     }
     
     error(parser, "Expected expression");
-    return NULL;
+    return 0;
+}
+
+/* Binding powers, weakest first. Every binary operator in
+ * hyp_binary_op_t has a level; operators on one level associate to the
+ * left unless their rule says otherwise. */
+typedef enum {
+    PREC_NONE,
+    PREC_ASSIGNMENT,   /* = += -= *= /= */
+    PREC_CONDITIONAL,  /* ?: */
+    PREC_PIPE,         /* |> */
+    PREC_OR,           /* || */
+    PREC_AND,          /* && */
+    PREC_BITWISE_OR,   /* | */
+    PREC_BITWISE_XOR,  /* ^ */
+    PREC_BITWISE_AND,  /* & */
+    PREC_EQUALITY,     /* == != */
+    PREC_COMPARISON,   /* < <= > >= */
+    PREC_SHIFT,        /* << >> */
+    PREC_TERM,         /* + - */
+    PREC_FACTOR,       /* * / % */
+    PREC_UNARY,        /* prefix ! - + ~ ++ -- */
+    PREC_POWER,        /* ** binds tighter than a prefix on its left: -2 ** 2 is -4 */
+    PREC_POSTFIX       /* () . [] and postfix ++ -- */
+} precedence_t;
+
+/* What an operator found after an operand builds */
+typedef enum {
+    INFIX_BINARY,
+    INFIX_ASSIGN,
+    INFIX_CONDITIONAL,
+    INFIX_CALL,
+    INFIX_MEMBER,
+    INFIX_INDEX,
+    INFIX_POSTFIX
+} infix_kind_t;
+
+typedef struct {
+    uint8_t precedence;  /* PREC_NONE if the token cannot follow an operand */
+    uint8_t kind;        /* infix_kind_t */
+    uint8_t op;          /* hyp_binary_op_t, hyp_assign_op_t or hyp_unary_op_t */
+    bool right;          /* Right-associative */
+} infix_rule_t;
+
+typedef struct {
+    bool valid;
+    uint8_t op;          /* hyp_unary_op_t */
+} prefix_rule_t;
+
+#define BINARY(precedence, op) { precedence, INFIX_BINARY, op, false }
+#define ASSIGN(op) { PREC_ASSIGNMENT, INFIX_ASSIGN, op, true }
+
+/* Indexed by token type; the lexer's aliases (TOKEN_STAR and
+ * TOKEN_MULTIPLY, ...) share a rule */
+static const infix_rule_t infix_rules[TOKEN_COMMENT + 1] = {
+    [TOKEN_ASSIGN]        = ASSIGN(ASSIGN_SIMPLE),
+    [TOKEN_PLUS_ASSIGN]   = ASSIGN(ASSIGN_ADD),
+    [TOKEN_MINUS_ASSIGN]  = ASSIGN(ASSIGN_SUB),
+    [TOKEN_MUL_ASSIGN]    = ASSIGN(ASSIGN_MUL),
+    [TOKEN_DIV_ASSIGN]    = ASSIGN(ASSIGN_DIV),
+    [TOKEN_PERCENT_EQUAL] = ASSIGN(ASSIGN_MOD),
+    [TOKEN_POWER_ASSIGN]  = ASSIGN(ASSIGN_POW),
+    [TOKEN_QUESTION]      = { PREC_CONDITIONAL, INFIX_CONDITIONAL, 0, true },
+    [TOKEN_PIPE]          = BINARY(PREC_PIPE, BINOP_PIPE),
+    [TOKEN_OR]            = BINARY(PREC_OR, BINOP_OR),
+    [TOKEN_AND]           = BINARY(PREC_AND, BINOP_AND),
+    [TOKEN_BITWISE_OR]    = BINARY(PREC_BITWISE_OR, BINOP_BITWISE_OR),
+    [TOKEN_CARET]         = BINARY(PREC_BITWISE_XOR, BINOP_BITWISE_XOR),
+    [TOKEN_BITWISE_XOR]   = BINARY(PREC_BITWISE_XOR, BINOP_BITWISE_XOR),
+    [TOKEN_AMPERSAND]     = BINARY(PREC_BITWISE_AND, BINOP_BITWISE_AND),
+    [TOKEN_BITWISE_AND]   = BINARY(PREC_BITWISE_AND, BINOP_BITWISE_AND),
+    [TOKEN_EQUAL]         = BINARY(PREC_EQUALITY, BINOP_EQ),
+    [TOKEN_NOT_EQUAL]     = BINARY(PREC_EQUALITY, BINOP_NE),
+    [TOKEN_LESS]          = BINARY(PREC_COMPARISON, BINOP_LT),
+    [TOKEN_LESS_EQUAL]    = BINARY(PREC_COMPARISON, BINOP_LE),
+    [TOKEN_GREATER]       = BINARY(PREC_COMPARISON, BINOP_GT),
+    [TOKEN_GREATER_EQUAL] = BINARY(PREC_COMPARISON, BINOP_GE),
+    [TOKEN_LEFT_SHIFT]    = BINARY(PREC_SHIFT, BINOP_LEFT_SHIFT),
+    [TOKEN_RIGHT_SHIFT]   = BINARY(PREC_SHIFT, BINOP_RIGHT_SHIFT),
+    [TOKEN_PLUS]          = BINARY(PREC_TERM, BINOP_ADD),
+    [TOKEN_MINUS]         = BINARY(PREC_TERM, BINOP_SUB),
+    [TOKEN_STAR]          = BINARY(PREC_FACTOR, BINOP_MUL),
+    [TOKEN_MULTIPLY]      = BINARY(PREC_FACTOR, BINOP_MUL),
+    [TOKEN_SLASH]         = BINARY(PREC_FACTOR, BINOP_DIV),
+    [TOKEN_DIVIDE]        = BINARY(PREC_FACTOR, BINOP_DIV),
+    [TOKEN_PERCENT]       = BINARY(PREC_FACTOR, BINOP_MOD),
+    [TOKEN_MODULO]        = BINARY(PREC_FACTOR, BINOP_MOD),
+    [TOKEN_POWER]         = { PREC_POWER, INFIX_BINARY, BINOP_POW, true },
+    [TOKEN_LEFT_PAREN]    = { PREC_POSTFIX, INFIX_CALL, 0, false },
+    [TOKEN_DOT]           = { PREC_POSTFIX, INFIX_MEMBER, 0, false },
+    [TOKEN_LEFT_BRACKET]  = { PREC_POSTFIX, INFIX_INDEX, 0, false },
+    [TOKEN_INCREMENT]     = { PREC_POSTFIX, INFIX_POSTFIX, UNOP_INCREMENT, false },
+    [TOKEN_DECREMENT]     = { PREC_POSTFIX, INFIX_POSTFIX, UNOP_DECREMENT, false },
+};
+
+static const prefix_rule_t prefix_rules[TOKEN_COMMENT + 1] = {
+    [TOKEN_NOT]         = { true, UNOP_NOT },
+    [TOKEN_MINUS]       = { true, UNOP_MINUS },
+    [TOKEN_PLUS]        = { true, UNOP_PLUS },
+    [TOKEN_TILDE]       = { true, UNOP_BITWISE_NOT },
+    [TOKEN_BITWISE_NOT] = { true, UNOP_BITWISE_NOT },
+    [TOKEN_INCREMENT]   = { true, UNOP_INCREMENT },
+    [TOKEN_DECREMENT]   = { true, UNOP_DECREMENT },
+};
+
+#undef BINARY
+#undef ASSIGN
+
+static slot_t parse_precedence(hyp_parser_t* parser, precedence_t min);
+
+static bool is_assignment_target(hyp_parser_t* parser, slot_t node) {
+    if (!node) return false;
+    uint16_t type = NODE(parser, node)->type;
+    return type == AST_IDENTIFIER || type == AST_MEMBER_ACCESS || type == AST_INDEX_ACCESS;
+}
+
+/* ++ and -- store into their operand */
+static void check_increment_target(hyp_parser_t* parser, hyp_unary_op_t op, slot_t operand) {
+    if ((op == UNOP_INCREMENT || op == UNOP_DECREMENT) && operand && !is_assignment_target(parser, operand)) {
+        error(parser, op == UNOP_INCREMENT ? "Invalid increment target" : "Invalid decrement target");
+    }
 }
 
-static hyp_ast_node_t* parse_call(hyp_parser_t* parser) {
-    hyp_ast_node_t* expr = parse_primary(parser);
+static slot_t parse_prefix(hyp_parser_t* parser) {
+    const prefix_rule_t* rule = &prefix_rules[TOKEN_TYPE(parser, parser->current)];
+    if (!rule->valid) {
+        return parse_primary(parser);
+    }
+    
+    advance(parser);
+    slot_t node = create_node(parser, AST_UNARY_OP);
+    if (!node) return 0;
     
-    while (true) {
-        if (match(parser, TOKEN_LEFT_PAREN)) {
-            hyp_ast_node_t* call = create_node(parser, AST_CALL);
-            if (!call) break;
+    NODE(parser, node)->unary_op.op = (hyp_unary_op_t)rule->op;
+    slot_t operand = parse_precedence(parser, PREC_UNARY);
+    check_increment_target(parser, (hyp_unary_op_t)rule->op, operand);
+    LINK(parser, node, unary_op.operand, operand);
+    return node;
+}
+
+/* Build the node for the operator just consumed, with left as its first operand */
+static slot_t parse_infix(hyp_parser_t* parser, const infix_rule_t* rule, slot_t left) {
+    /* Right operands of right-associative operators may hold the same operator again */
+    precedence_t next = (precedence_t)(rule->right ? rule->precedence : rule->precedence + 1);
+    slot_t node;
+    
+    switch ((infix_kind_t)rule->kind) {
+        case INFIX_BINARY:
+            node = create_node(parser, AST_BINARY_OP);
+            if (!node) return 0;
+            NODE(parser, node)->binary_op.op = (hyp_binary_op_t)rule->op;
+            LINK(parser, node, binary_op.left, left);
+            LINK(parser, node, binary_op.right, parse_precedence(parser, next));
+            return node;
+            
+        case INFIX_ASSIGN:
+            if (!is_assignment_target(parser, left)) {
+                error(parser, "Invalid assignment target");
+            }
+            node = create_node(parser, AST_ASSIGNMENT);
+            if (!node) return 0;
+            NODE(parser, node)->assignment.op = (hyp_assign_op_t)rule->op;
+            LINK(parser, node, assignment.target, left);
+            LINK(parser, node, assignment.value, parse_precedence(parser, next));
+            return node;
             
-            call->call.callee = expr;
-            HYP_ARRAY_INIT(&call->call.arguments);
+        case INFIX_CONDITIONAL:
+            node = create_node(parser, AST_CONDITIONAL);
+            if (!node) return 0;
+            LINK(parser, node, conditional.condition, left);
+            LINK(parser, node, conditional.then_expr, parse_precedence(parser, PREC_ASSIGNMENT));
+            consume(parser, TOKEN_COLON, "Expected ':' in conditional expression");
+            LINK(parser, node, conditional.else_expr, parse_precedence(parser, next));
+            return node;
             
+        case INFIX_CALL: {
+            node = create_node(parser, AST_CALL);
+            if (!node) return 0;
+            LINK(parser, node, call.callee, left);
+            
+            size_t start = list_begin(parser);
             if (!check(parser, TOKEN_RIGHT_PAREN)) {
                 do {
-                    hyp_ast_node_t* arg = parse_expression(parser);
+                    slot_t arg = parse_expression(parser);
                     if (arg) {
-                        HYP_ARRAY_PUSH(&call->call.arguments, arg);
+                        list_push(parser, arg);
                     }
                 } while (match(parser, TOKEN_COMMA));
             }
+            LIST_END(parser, node, call.arguments, start, 1);
             
             consume(parser, TOKEN_RIGHT_PAREN, "Expected ')' after arguments");
-            expr = call;
-        } else if (match(parser, TOKEN_DOT)) {
-            hyp_ast_node_t* member = create_node(parser, AST_MEMBER_ACCESS);
-            if (!member) break;
+            return node;
+        }
             
-            member->member_access.object = expr;
+        case INFIX_MEMBER:
+            node = create_node(parser, AST_MEMBER_ACCESS);
+            if (!node) return 0;
+            LINK(parser, node, member_access.object, left);
             consume(parser, TOKEN_IDENTIFIER, "Expected property name after '.'");
-            member->member_access.member = copy_string(parser, 
-                parser->previous.lexeme.data, parser->previous.lexeme.length);
-            
-            expr = member;
-        } else if (match(parser, TOKEN_LEFT_BRACKET)) {
-            hyp_ast_node_t* index = create_node(parser, AST_INDEX_ACCESS);
-            if (!index) break;
+            LINK(parser, node, member_access.member, copy_previous(parser));
+            return node;
             
-            index->index_access.object = expr;
-            index->index_access.index = parse_expression(parser);
+        case INFIX_INDEX:
+            node = create_node(parser, AST_INDEX_ACCESS);
+            if (!node) return 0;
+            LINK(parser, node, index_access.object, left);
+            LINK(parser, node, index_access.index, parse_expression(parser));
             consume(parser, TOKEN_RIGHT_BRACKET, "Expected ']' after index");
+            return node;
             
-            expr = index;
-        } else {
-            break;
-        }
-    }
-    
-    return expr;
-}
-
-static hyp_ast_node_t* parse_unary(hyp_parser_t* parser) {
-    if (match(parser, TOKEN_NOT) || match(parser, TOKEN_MINUS)) {
-        hyp_ast_node_t* node = create_node(parser, AST_UNARY_OP);
-        if (!node) return NULL;
-        
-        hyp_token_type_t op_type = parser->previous.type;
-         switch (op_type) {
-              case TOKEN_NOT: node->unary_op.op = UNOP_NOT; break;
-              case TOKEN_MINUS: node->unary_op.op = UNOP_MINUS; break;
-             default: break;
-         }
-         
-         node->unary_op.operand = parse_unary(parser);
-        return node;
+        case INFIX_POSTFIX:
+            check_increment_target(parser, (hyp_unary_op_t)rule->op, left);
+            node = create_node(parser, AST_UNARY_OP);
+            if (!node) return 0;
+            NODE(parser, node)->unary_op.op = (hyp_unary_op_t)rule->op;
+            NODE(parser, node)->unary_op.is_postfix = true;
+            LINK(parser, node, unary_op.operand, left);
+            return node;
     }
     
-    return parse_call(parser);
+    return 0;
 }
 
-static hyp_ast_node_t* parse_factor(hyp_parser_t* parser) {
-    hyp_ast_node_t* expr = parse_unary(parser);
-    
-    while (match(parser, TOKEN_DIVIDE) || match(parser, TOKEN_MULTIPLY) || match(parser, TOKEN_MODULO)) {
-        hyp_ast_node_t* binary = create_node(parser, AST_BINARY_OP);
-        if (!binary) break;
+/* Parse an expression whose operators all bind at least as tightly as
+ * min; one loop handles every level, so a leaf costs two calls rather
+ * than one per precedence level */
+static slot_t parse_precedence(hyp_parser_t* parser, precedence_t min) {
+    slot_t expr = parse_prefix(parser);
+    
+    while (!parser->panic_mode) {
+        const infix_rule_t* rule = &infix_rules[TOKEN_TYPE(parser, parser->current)];
+        if (rule->precedence == PREC_NONE || rule->precedence < min) break;
         
-        hyp_token_type_t op_type = parser->previous.type;
-        switch (op_type) {
-            case TOKEN_DIVIDE: binary->binary_op.op = BINOP_DIV; break;
-            case TOKEN_MULTIPLY: binary->binary_op.op = BINOP_MUL; break;
-            case TOKEN_MODULO: binary->binary_op.op = BINOP_MOD; break;
-            default: break;
-        }
-         
-        binary->binary_op.left = expr;
-        binary->binary_op.right = parse_unary(parser);
-        expr = binary;
-    }
-    
-    return expr;
-}
-
-static hyp_ast_node_t* parse_term(hyp_parser_t* parser) {
-    hyp_ast_node_t* expr = parse_factor(parser);
-    
-    while (match(parser, TOKEN_MINUS) || match(parser, TOKEN_PLUS)) {
-        hyp_ast_node_t* binary = create_node(parser, AST_BINARY_OP);
-        if (!binary) break;
-        
-        hyp_token_type_t op_type = parser->previous.type;
-        switch (op_type) {
-            case TOKEN_MINUS: binary->binary_op.op = BINOP_SUB; break;
-            case TOKEN_PLUS: binary->binary_op.op = BINOP_ADD; break;
-            default: break;
-        }
-         
-        binary->binary_op.left = expr;
-        binary->binary_op.right = parse_factor(parser);
-        expr = binary;
-    }
-    
-    return expr;
-}
-
-static hyp_ast_node_t* parse_comparison(hyp_parser_t* parser) {
-    hyp_ast_node_t* expr = parse_term(parser);
-    
-    while (match(parser, TOKEN_GREATER) || match(parser, TOKEN_GREATER_EQUAL) ||
-           match(parser, TOKEN_LESS) || match(parser, TOKEN_LESS_EQUAL)) {
-        hyp_ast_node_t* binary = create_node(parser, AST_BINARY_OP);
-        if (!binary) break;
-        
-        hyp_token_type_t op_type = parser->previous.type;
-        switch (op_type) {
-            case TOKEN_GREATER: binary->binary_op.op = BINOP_GT; break;
-            case TOKEN_GREATER_EQUAL: binary->binary_op.op = BINOP_GE; break;
-            case TOKEN_LESS: binary->binary_op.op = BINOP_LT; break;
-            case TOKEN_LESS_EQUAL: binary->binary_op.op = BINOP_LE; break;
-            default: break;
-        }
-         
-        binary->binary_op.left = expr;
-        binary->binary_op.right = parse_term(parser);
-        expr = binary;
-    }
-    
-    return expr;
-}
-
-static hyp_ast_node_t* parse_equality(hyp_parser_t* parser) {
-    hyp_ast_node_t* expr = parse_comparison(parser);
-    
-    while (match(parser, TOKEN_NOT_EQUAL) || match(parser, TOKEN_EQUAL)) {
-        hyp_ast_node_t* binary = create_node(parser, AST_BINARY_OP);
-        if (!binary) break;
-        
-        hyp_token_type_t op_type = parser->previous.type;
-        switch (op_type) {
-            case TOKEN_NOT_EQUAL: binary->binary_op.op = BINOP_NE; break;
-            case TOKEN_EQUAL: binary->binary_op.op = BINOP_EQ; break;
-            default: break;
-        }
-         
-        binary->binary_op.left = expr;
-        binary->binary_op.right = parse_comparison(parser);
-        expr = binary;
-    }
-    
-    return expr;
-}
-
-static hyp_ast_node_t* parse_logical_and(hyp_parser_t* parser) {
-    hyp_ast_node_t* expr = parse_equality(parser);
-    
-    while (match(parser, TOKEN_AND)) {
-         hyp_ast_node_t* binary = create_node(parser, AST_BINARY_OP);
-        if (!binary) break;
-        
-        binary->binary_op.op = BINOP_AND;
-        binary->binary_op.left = expr;
-        binary->binary_op.right = parse_equality(parser);
-        expr = binary;
-    }
-    
-    return expr;
-}
-
-static hyp_ast_node_t* parse_logical_or(hyp_parser_t* parser) {
-    hyp_ast_node_t* expr = parse_logical_and(parser);
-    
-    while (match(parser, TOKEN_OR)) {
-         hyp_ast_node_t* binary = create_node(parser, AST_BINARY_OP);
-        if (!binary) break;
-        
-        binary->binary_op.op = BINOP_OR;
-        binary->binary_op.left = expr;
-        binary->binary_op.right = parse_logical_and(parser);
-        expr = binary;
-    }
-    
-    return expr;
-}
-
-static hyp_ast_node_t* parse_assignment(hyp_parser_t* parser) {
-    hyp_ast_node_t* expr = parse_logical_or(parser);
-    
-    if (match(parser, TOKEN_EQUAL)) {
-        hyp_ast_node_t* assignment = create_node(parser, AST_ASSIGNMENT);
-        if (!assignment) return expr;
-        
-        assignment->assignment.op = ASSIGN_SIMPLE;
-        assignment->assignment.target = expr;
-        assignment->assignment.value = parse_assignment(parser);
-        return assignment;
+        advance(parser);
+        slot_t node = parse_infix(parser, rule, expr);
+        if (!node) break;
+        expr = node;
     }
     
     return expr;
 }
 
-static hyp_ast_node_t* parse_expression(hyp_parser_t* parser) {
-    return parse_assignment(parser);
+static slot_t parse_expression(hyp_parser_t* parser) {
+    return parse_precedence(parser, PREC_ASSIGNMENT);
 }
 
 /* Statement parsing */
-static hyp_ast_node_t* parse_expression_statement(hyp_parser_t* parser) {
-    hyp_ast_node_t* node = create_node(parser, AST_EXPRESSION_STMT);
-    if (!node) return NULL;
+static slot_t parse_expression_statement(hyp_parser_t* parser) {
+    slot_t node = create_node(parser, AST_EXPRESSION_STMT);
+    if (!node) return 0;
     
-    node->expression_stmt.expression = parse_expression(parser);
+    LINK(parser, node, expression_stmt.expression, parse_expression(parser));
     consume(parser, TOKEN_SEMICOLON, "Expected ';' after expression");
     
     return node;
 }
 
-static hyp_ast_node_t* parse_block_statement(hyp_parser_t* parser) {
-    hyp_ast_node_t* node = create_node(parser, AST_BLOCK_STMT);
-    if (!node) return NULL;
-    
-    HYP_ARRAY_INIT(&node->block_stmt.statements);
+static slot_t parse_block_statement(hyp_parser_t* parser) {
+    slot_t node = create_node(parser, AST_BLOCK_STMT);
+    if (!node) return 0;
     
+    size_t start = list_begin(parser);
     while (!check(parser, TOKEN_RIGHT_BRACE) && !check(parser, TOKEN_EOF)) {
-        hyp_ast_node_t* stmt = parse_declaration(parser);
+        size_t first = parser->current;
+        slot_t stmt = parse_declaration(parser);
         if (stmt) {
-            HYP_ARRAY_PUSH(&node->block_stmt.statements, stmt);
+            list_push(parser, stmt);
         }
+        if (parser->panic_mode && parser->current == first) advance(parser);
     }
+    LIST_END(parser, node, block_stmt.statements, start, 1);
     
     consume(parser, TOKEN_RIGHT_BRACE, "Expected '}' after block");
     return node;
 }
 
-static hyp_ast_node_t* parse_if_statement(hyp_parser_t* parser) {
-    hyp_ast_node_t* node = create_node(parser, AST_IF_STMT);
-    if (!node) return NULL;
+static slot_t parse_if_statement(hyp_parser_t* parser) {
+    slot_t node = create_node(parser, AST_IF_STMT);
+    if (!node) return 0;
     
     consume(parser, TOKEN_LEFT_PAREN, "Expected '(' after 'if'");
-    node->if_stmt.condition = parse_expression(parser);
+    LINK(parser, node, if_stmt.condition, parse_expression(parser));
     consume(parser, TOKEN_RIGHT_PAREN, "Expected ')' after if condition");
     
-    node->if_stmt.then_stmt = parse_statement(parser);
+    LINK(parser, node, if_stmt.then_stmt, parse_statement(parser));
     
     if (match(parser, TOKEN_ELSE)) {
-        node->if_stmt.else_stmt = parse_statement(parser);
+        LINK(parser, node, if_stmt.else_stmt, parse_statement(parser));
     }
     
     return node;
 }
 
-static hyp_ast_node_t* parse_while_statement(hyp_parser_t* parser) {
-    hyp_ast_node_t* node = create_node(parser, AST_WHILE_STMT);
-    if (!node) return NULL;
+static slot_t parse_while_statement(hyp_parser_t* parser) {
+    slot_t node = create_node(parser, AST_WHILE_STMT);
+    if (!node) return 0;
     
     consume(parser, TOKEN_LEFT_PAREN, "Expected '(' after 'while'");
-    node->while_stmt.condition = parse_expression(parser);
+    LINK(parser, node, while_stmt.condition, parse_expression(parser));
     consume(parser, TOKEN_RIGHT_PAREN, "Expected ')' after while condition");
     
-    node->while_stmt.body = parse_statement(parser);
+    LINK(parser, node, while_stmt.body, parse_statement(parser));
     
     return node;
 }
 
-static hyp_ast_node_t* parse_return_statement(hyp_parser_t* parser) {
-    hyp_ast_node_t* node = create_node(parser, AST_RETURN_STMT);
-    if (!node) return NULL;
+static slot_t parse_return_statement(hyp_parser_t* parser) {
+    slot_t node = create_node(parser, AST_RETURN_STMT);
+    if (!node) return 0;
     
     if (!check(parser, TOKEN_SEMICOLON)) {
-        node->return_stmt.value = parse_expression(parser);
+        LINK(parser, node, return_stmt.value, parse_expression(parser));
     }
     
     consume(parser, TOKEN_SEMICOLON, "Expected ';' after return value");
     return node;
 }
 
-static hyp_ast_node_t* parse_statement(hyp_parser_t* parser) {
+static slot_t parse_statement(hyp_parser_t* parser) {
     if (match(parser, TOKEN_IF)) {
         return parse_if_statement(parser);
     }
@@ -518,55 +753,116 @@ static hyp_ast_node_t* parse_statement(hyp_parser_t* parser) {
 }
 
 /* Declaration parsing */
-static hyp_ast_node_t* parse_variable_declaration(hyp_parser_t* parser, bool is_const) {
-    hyp_ast_node_t* node = create_node(parser, AST_VARIABLE_DECL);
-    if (!node) return NULL;
+static slot_t parse_variable_declaration(hyp_parser_t* parser, bool is_const) {
+    slot_t node = create_node(parser, AST_VARIABLE_DECL);
+    if (!node) return 0;
     
-    node->variable_decl.is_const = is_const;
+    NODE(parser, node)->variable_decl.is_const = is_const;
     
     consume(parser, TOKEN_IDENTIFIER, "Expected variable name");
-    node->variable_decl.name = copy_string(parser, parser->previous.lexeme.data, parser->previous.lexeme.length);
+    LINK(parser, node, variable_decl.name, copy_previous(parser));
     
-    if (match(parser, TOKEN_EQUAL)) {
-        node->variable_decl.initializer = parse_expression(parser);
+    if (match(parser, TOKEN_ASSIGN)) {
+        LINK(parser, node, variable_decl.initializer, parse_expression(parser));
     }
     
     consume(parser, TOKEN_SEMICOLON, "Expected ';' after variable declaration");
     return node;
 }
 
-static hyp_ast_node_t* parse_function_declaration(hyp_parser_t* parser) {
-    hyp_ast_node_t* node = create_node(parser, AST_FUNCTION_DECL);
-    if (!node) return NULL;
+static slot_t parse_function_declaration(hyp_parser_t* parser) {
+    slot_t node = create_node(parser, AST_FUNCTION_DECL);
+    if (!node) return 0;
     
     consume(parser, TOKEN_IDENTIFIER, "Expected function name");
-    node->function_decl.name = copy_string(parser, parser->previous.lexeme.data, parser->previous.lexeme.length);
+    LINK(parser, node, function_decl.name, copy_previous(parser));
     
     consume(parser, TOKEN_LEFT_PAREN, "Expected '(' after function name");
     
-    HYP_ARRAY_INIT(&node->function_decl.parameters);
-    
+    /* Entries are name, default value pairs; defaults are not parsed yet */
+    size_t start = list_begin(parser);
     if (!check(parser, TOKEN_RIGHT_PAREN)) {
         do {
-            hyp_parameter_t param = {0};
-            
             consume(parser, TOKEN_IDENTIFIER, "Expected parameter name");
-            param.name = copy_string(parser, parser->previous.lexeme.data, parser->previous.lexeme.length);
-            param.type = NULL; /* Type inference for now */
-            
-            HYP_ARRAY_PUSH(&node->function_decl.parameters, param);
+            list_push(parser, copy_previous(parser));
+            list_push(parser, 0);
         } while (match(parser, TOKEN_COMMA));
     }
+    LIST_END(parser, node, function_decl.parameters, start, 2);
     
     consume(parser, TOKEN_RIGHT_PAREN, "Expected ')' after parameters");
     consume(parser, TOKEN_LEFT_BRACE, "Expected '{' before function body");
     
-    node->function_decl.body = parse_block_statement(parser);
+    LINK(parser, node, function_decl.body, parse_block_statement(parser));
+    
+    return node;
+}
+
+/* Contextual keywords ('from', 'as') are lexed as identifiers */
+static bool match_word(hyp_parser_t* parser, const char* word) {
+    if (!check(parser, TOKEN_IDENTIFIER)) return false;
+    
+    size_t length = strlen(word);
+    if (TOKEN_LENGTH(parser, parser->current) != length ||
+        memcmp(TOKEN_TEXT(parser, parser->current), word, length) != 0) {
+        return false;
+    }
+    
+    advance(parser);
+    return true;
+}
+
+/*
+ * import "path";
+ * import Name from "path";
+ * import * as Name from "path";
+ * import { a, b } from "path";
+ */
+static slot_t parse_import_statement(hyp_parser_t* parser) {
+    slot_t node = create_node(parser, AST_IMPORT_STMT);
+    if (!node) return 0;
+    
+    if (!check(parser, TOKEN_STRING)) {
+        if (match(parser, TOKEN_STAR)) {
+            if (!match_word(parser, "as")) {
+                error_at_current(parser, "Expected 'as' after '*' in import");
+                return node;
+            }
+            consume(parser, TOKEN_IDENTIFIER, "Expected module alias");
+            LINK(parser, node, import_stmt.alias, copy_previous(parser));
+        } else if (match(parser, TOKEN_LEFT_BRACE)) {
+            size_t start = list_begin(parser);
+            if (!check(parser, TOKEN_RIGHT_BRACE)) {
+                do {
+                    consume(parser, TOKEN_IDENTIFIER, "Expected imported name");
+                    slot_t name = create_node(parser, AST_IDENTIFIER);
+                    if (!name) break;
+                    LINK(parser, name, identifier.name, copy_previous(parser));
+                    list_push(parser, name);
+                } while (match(parser, TOKEN_COMMA));
+            }
+            LIST_END(parser, node, import_stmt.imports, start, 1);
+            consume(parser, TOKEN_RIGHT_BRACE, "Expected '}' after imported names");
+        } else {
+            consume(parser, TOKEN_IDENTIFIER, "Expected module alias");
+            LINK(parser, node, import_stmt.alias, copy_previous(parser));
+        }
+        
+        if (!match_word(parser, "from")) {
+            error_at_current(parser, "Expected 'from' in import");
+            return node;
+        }
+    }
     
+    consume(parser, TOKEN_STRING, "Expected module path");
+    LINK(parser, node, import_stmt.module, copy_string_literal(parser,
+         TOKEN_TEXT(parser, parser->previous), TOKEN_LENGTH(parser, parser->previous)));
+    
+    consume(parser, TOKEN_SEMICOLON, "Expected ';' after import");
     return node;
 }
 
-static hyp_ast_node_t* parse_declaration(hyp_parser_t* parser) {
+static slot_t parse_declaration(hyp_parser_t* parser) {
     if (match(parser, TOKEN_LET)) {
         return parse_variable_declaration(parser, false);
     }
@@ -579,64 +875,559 @@ static hyp_ast_node_t* parse_declaration(hyp_parser_t* parser) {
         return parse_function_declaration(parser);
     }
     
+    if (match(parser, TOKEN_IMPORT)) {
+        return parse_import_statement(parser);
+    }
+    
     return parse_statement(parser);
 }
 
+/* Parse the top-level statement at the current token, recovering from
+ * errors in it, and note where it went */
+static slot_t parse_top_level(hyp_parser_t* parser, hyp_parser_decl_t* record) {
+    size_t first = parser->current;
+    bool had_error = parser->had_error;
+    parser->had_error = false;
+    
+    record->first_token = (uint32_t)first;
+    record->first_slot = parser->slot_count;
+    record->panic = parser->panic_mode;
+    
+    slot_t decl = parse_declaration(parser);
+    if (parser->panic_mode) {
+        synchronize(parser);
+        /* A statement that failed on its first token must still move on */
+        if (parser->current == first) advance(parser);
+    }
+    
+    record->end_token = (uint32_t)parser->current;
+    record->end_slot = parser->slot_count;
+    record->node = decl;
+    record->had_error = parser->had_error;
+    parser->had_error |= had_error;
+    return decl;
+}
+
+/* Point the program node at the recorded statements */
+static void link_program(hyp_parser_t* parser) {
+    memset(&NODE(parser, 0)->program.statements, 0, sizeof(hyp_ast_list_t));
+    
+    size_t start = list_begin(parser);
+    for (size_t i = 0; i < parser->decls.count; i++) {
+        if (parser->decls.data[i].node) list_push(parser, parser->decls.data[i].node);
+    }
+    LIST_END(parser, 0, program.statements, start, 1);
+}
+
+/* Move every line of a statement's nodes */
+static void shift_lines(hyp_parser_t* parser, const hyp_parser_decl_t* decl, ptrdiff_t lines) {
+    const uint64_t* marks = parser->node_marks;
+    for (uint32_t slot = decl->first_slot; slot < decl->end_slot; slot++) {
+        if (slot % 64 == 0 && marks[slot / 64] == 0) {
+            slot += 63;
+        } else if (MARKED(marks, slot)) {
+            hyp_ast_node_t* node = NODE(parser, slot);
+            node->line = (uint32_t)((ptrdiff_t)node->line + lines);
+        }
+    }
+}
+
+/* Copy the statements' slots, in order, into a new buffer, leaving out
+ * those of replaced statements and old program lists. Nothing changes
+ * if there is no memory for it. */
+static void compact_tree(hyp_parser_t* parser) {
+    size_t capacity = parser->slot_capacity;
+    hyp_ast_node_t* slots = HYP_MALLOC(capacity * SLOT_SIZE);
+    uint64_t* marks = HYP_CALLOC(capacity / 64, sizeof(uint64_t));
+    if (!slots || !marks) {
+        HYP_FREE(slots);
+        HYP_FREE(marks);
+        return;
+    }
+    
+    slots[0] = parser->slots[0];
+    uint32_t next = 1;
+    for (size_t i = 0; i < parser->decls.count; i++) {
+        hyp_parser_decl_t* decl = &parser->decls.data[i];
+        uint32_t length = decl->end_slot - decl->first_slot;
+        
+        /* Links inside a statement are relative, so its slots move as they are */
+        memcpy(slots + next, parser->slots + decl->first_slot, length * SLOT_SIZE);
+        for (uint32_t slot = 0; slot < length; slot++) {
+            if (MARKED(parser->node_marks, decl->first_slot + slot)) MARK(marks, next + slot);
+        }
+        
+        if (decl->node) decl->node = decl->node - decl->first_slot + next;
+        decl->first_slot = next;
+        decl->end_slot = next + length;
+        next += length;
+    }
+    
+    HYP_FREE(parser->slots);
+    HYP_FREE(parser->node_marks);
+    parser->slots = slots;
+    parser->node_marks = marks;
+    parser->slot_count = next;
+}
+
+/* Parallel parsing */
+
+/* Sources with fewer tokens per worker are parsed serially */
+#define PARALLEL_MIN_TOKENS (16 * 1024)
+
+/* Pieces per worker, so that uneven ones even out */
+#define PARALLEL_PIECES_PER_WORKER 4
+
+/* A run of top-level statements parsed on a worker, on the assumption
+ * that a statement begins at first_token out of panic mode. The worker
+ * has its own copy of the lexer, sharing its arrays but not its line
+ * cursor, and its own slots and messages. */
+typedef struct {
+    size_t first_token;
+    size_t end_token;            /* Statements start before this */
+    hyp_lexer_t lexer;
+    hyp_parser_t parser;
+    hyp_out_t messages;
+    HYP_ARRAY(size_t) message_starts;  /* Per statement, into messages */
+    
+    /* Slots taken into the tree, copied once every piece is placed */
+    uint32_t copy_from;
+    uint32_t copy_to;
+    uint32_t copy_length;
+    hyp_ast_node_t* tree;
+} parse_piece_t;
+
+/* Where advance() would have left previous with current at token */
+static size_t previous_before(hyp_parser_t* parser, size_t token) {
+    size_t previous = token ? token - 1 : 0;
+    while (previous > 0 && TOKEN_TYPE(parser, previous) == TOKEN_ERROR) previous--;
+    return previous;
+}
+
+static void parse_piece(void* context, size_t index, size_t worker) {
+    (void)worker;
+    parse_piece_t* piece = &((parse_piece_t*)context)[index];
+    hyp_parser_t* parser = &piece->parser;
+    
+    /* Slot 0 stays unused, so that 0 still means no node. Trees take
+     * a little under a slot per token. */
+    if (!reserve_slots(parser, piece->end_token - piece->first_token + 1)) return;
+    parser->slot_count = 1;
+    
+    parser->current = piece->first_token;
+    parser->previous = previous_before(parser, piece->first_token);
+    while (parser->current < piece->end_token && !check(parser, TOKEN_EOF)) {
+        hyp_parser_decl_t record;
+        HYP_ARRAY_PUSH(&piece->message_starts, piece->messages.length);
+        parse_top_level(parser, &record);
+        HYP_ARRAY_PUSH(&parser->decls, record);
+    }
+}
+
+/* Append a piece's statements from the index-th on to the tree, with
+ * their messages, and carry on from where the piece stopped. Their slots
+ * are set aside here and filled by copy_piece. */
+static bool take_piece(hyp_parser_t* parser, parse_piece_t* piece, size_t index) {
+    const hyp_parser_decl_t* decls = piece->parser.decls.data;
+    uint32_t first = decls[index].first_slot;
+    uint32_t length = piece->parser.slot_count - first;
+    if (!reserve_slots(parser, length)) return false;
+    
+    slot_t base = parser->slot_count;
+    parser->slot_count += length;
+    piece->copy_from = first;
+    piece->copy_to = base;
+    piece->copy_length = length;
+    
+    for (size_t i = index; i < piece->parser.decls.count; i++) {
+        if (decls[i].node) list_push(parser, decls[i].node - first + base);
+        parser->had_error |= decls[i].had_error;
+    }
+    
+    size_t start = piece->message_starts.data[index];
+    if (piece->messages.length > start) {
+        size_t size;
+        char* text = hyp_out_to_string(&piece->messages, &size);
+        if (text && parser->messages) {
+            hyp_out_write(parser->messages, text + start, size - start);
+        } else if (text) {
+            fwrite(text + start, 1, size - start, stderr);
+        }
+        HYP_FREE(text);
+    }
+    
+    parser->current = piece->parser.current;
+    parser->previous = piece->parser.previous;
+    parser->panic_mode = piece->parser.panic_mode;
+    return true;
+}
+
+static void copy_piece(void* context, size_t index, size_t worker) {
+    (void)worker;
+    parse_piece_t* piece = &((parse_piece_t*)context)[index];
+    if (!piece->copy_length) return;
+    memcpy(piece->tree + piece->copy_to, piece->parser.slots + piece->copy_from,
+           piece->copy_length * SLOT_SIZE);
+}
+
+/* Split the tokens from the current one on into about count pieces,
+ * each starting at a `let`, `const` or `func` outside any brackets.
+ * Returns the number of pieces. */
+static size_t split_tokens(hyp_parser_t* parser, parse_piece_t* pieces, size_t count) {
+    size_t first = parser->current;
+    size_t last = parser->lexer->tokens.count - 1;     /* TOKEN_EOF */
+    size_t share = (last - first) / count;
+    
+    size_t pieces_found = 1;
+    pieces[0].first_token = first;
+    
+    int depth = 0;
+    for (size_t i = first; i < last && pieces_found < count; i++) {
+        switch (TOKEN_TYPE(parser, i)) {
+            case TOKEN_LEFT_PAREN:
+            case TOKEN_LEFT_BRACE:
+            case TOKEN_LEFT_BRACKET:
+                depth++;
+                break;
+            case TOKEN_RIGHT_PAREN:
+            case TOKEN_RIGHT_BRACE:
+            case TOKEN_RIGHT_BRACKET:
+                if (depth > 0) depth--;
+                break;
+            case TOKEN_LET:
+            case TOKEN_CONST:
+            case TOKEN_FUNC:
+                if (depth == 0 && i >= first + share * pieces_found) {
+                    pieces[pieces_found - 1].end_token = i;
+                    pieces[pieces_found++].first_token = i;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    pieces[pieces_found - 1].end_token = last;
+    return pieces_found;
+}
+
+/* Parse the statements up to the end of the source on worker threads,
+ * then put their results together in order. Any piece that did not
+ * begin where the statements before it ended, in the same state, is
+ * parsed here until it lines up with one of its statements. Returns
+ * false, having done nothing, if the source is too small or resources
+ * are short; the caller then parses serially. */
+static bool parse_parallel(hyp_parser_t* parser) {
+    size_t workers = hyp_worker_count(parser->jobs);
+    size_t tokens = parser->lexer->tokens.count - parser->current;
+    if (tokens / PARALLEL_MIN_TOKENS < 2) return false;
+    if (workers > tokens / PARALLEL_MIN_TOKENS) workers = tokens / PARALLEL_MIN_TOKENS;
+    
+    /* Workers share the line index, so it must exist beforehand */
+    size_t line, column;
+    hyp_lexer_location(parser->lexer, 0, &line, &column);
+    if (parser->lexer->line_count == 0) return false;
+    
+    size_t count = workers * PARALLEL_PIECES_PER_WORKER;
+    parse_piece_t* pieces = HYP_CALLOC(count, sizeof(parse_piece_t));
+    if (!pieces) return false;
+    
+    count = split_tokens(parser, pieces, count);
+    for (size_t i = 0; i < count; i++) {
+        parse_piece_t* piece = &pieces[i];
+        piece->lexer = *parser->lexer;
+        piece->parser.lexer = &piece->lexer;
+        piece->parser.messages = &piece->messages;
+        hyp_out_init(&piece->messages, -1);
+    }
+    
+    /* The first piece starts where the parser is, perhaps in panic
+     * mode after error tokens at the start of the source */
+    pieces[0].parser.panic_mode = parser->panic_mode;
+    hyp_parallel_for(count, workers, parse_piece, pieces);
+    
+    /* Room for every piece, in case they all line up */
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) total += pieces[i].parser.slot_count;
+    reserve_slots(parser, total);
+    
+    bool taken = true;
+    for (size_t i = 0; i < count && taken; i++) {
+        parse_piece_t* piece = &pieces[i];
+        const hyp_parser_decl_t* decls = piece->parser.decls.data;
+        size_t next = 0;
+        
+        for (;;) {
+            while (next < piece->parser.decls.count && decls[next].first_token < parser->current) next++;
+            if (next < piece->parser.decls.count && decls[next].first_token == parser->current &&
+                decls[next].panic == parser->panic_mode) {
+                taken = take_piece(parser, piece, next);
+                break;
+            }
+            if (parser->current >= piece->end_token || check(parser, TOKEN_EOF)) break;
+            
+            hyp_parser_decl_t record;
+            slot_t decl = parse_top_level(parser, &record);
+            if (decl) list_push(parser, decl);
+        }
+    }
+    
+    for (size_t i = 0; i < count; i++) pieces[i].tree = parser->slots;
+    hyp_parallel_for(count, workers, copy_piece, pieces);
+    
+    for (size_t i = 0; i < count; i++) {
+        HYP_FREE(pieces[i].parser.slots);
+        HYP_ARRAY_FREE(&pieces[i].parser.entries);
+        HYP_ARRAY_FREE(&pieces[i].parser.decls);
+        HYP_ARRAY_FREE(&pieces[i].message_starts);
+        hyp_out_destroy(&pieces[i].messages);
+    }
+    HYP_FREE(pieces);
+    return true;
+}
+
 /* Public API */
 hyp_parser_t* hyp_parser_create(hyp_lexer_t* lexer) {
     if (!lexer) return NULL;
     
-    hyp_parser_t* parser = HYP_MALLOC(sizeof(hyp_parser_t));
+    hyp_parser_t* parser = HYP_CALLOC(1, sizeof(hyp_parser_t));
     if (!parser) return NULL;
     
     parser->lexer = lexer;
-    parser->had_error = false;
-    parser->panic_mode = false;
-    parser->arena = hyp_arena_create(16384); /* 16KB arena for AST nodes */
+    HYP_ARRAY_INIT(&parser->entries);
+    HYP_ARRAY_INIT(&parser->decls);
+    load_tokens(parser);
     
-    if (!parser->arena) {
-        HYP_FREE(parser);
-        return NULL;
-    }
+    return parser;
+}
+
+hyp_error_t hyp_parser_set_incremental(hyp_parser_t* parser) {
+    if (!parser) return HYP_ERROR_INVALID_ARG;
+    if (parser->incremental) return HYP_OK;
     
-    /* Prime the parser with the first token */
-    advance(parser);
+    if (parser->slot_capacity) {
+        parser->node_marks = HYP_CALLOC(parser->slot_capacity / 64, sizeof(uint64_t));
+        if (!parser->node_marks) return HYP_ERROR_MEMORY;
+    }
+    parser->incremental = true;
+    return HYP_OK;
+}
+
+void hyp_parser_reset(hyp_parser_t* parser, hyp_lexer_t* lexer) {
+    if (!parser || !lexer) return;
     
-    return parser;
+    parser->lexer = lexer;
+    parser->had_error = false;
+    parser->panic_mode = false;
+    load_tokens(parser);
 }
 
 void hyp_parser_destroy(hyp_parser_t* parser) {
     if (!parser) return;
     
-    if (parser->arena) {
-        hyp_arena_destroy(parser->arena);
-    }
+    HYP_FREE(parser->slots);
+    HYP_ARRAY_FREE(&parser->entries);
+    HYP_ARRAY_FREE(&parser->decls);
+    HYP_FREE(parser->node_marks);
     
     HYP_FREE(parser);
 }
 
-hyp_ast_node_t* hyp_parser_parse(hyp_parser_t* parser) {
-    if (!parser) return NULL;
+static hyp_ast_node_t* parse_program(hyp_parser_t* parser) {
+    if (!parser || parser->lexer->tokens.count == 0) return NULL;
+    
+    /* The program node takes slot 0 */
+    parser->slot_count = 0;
+    parser->entries.count = 0;
+    parser->decls.count = 0;
+    if (!reserve_slots(parser, 1)) return NULL;
+    parser->slot_count = 1;
+    memset(NODE(parser, 0), 0, SLOT_SIZE);
+    NODE(parser, 0)->type = AST_PROGRAM;
+    NODE(parser, 0)->line = 1;
+    NODE(parser, 0)->column = 1;
+    if (parser->node_marks) {
+        memset(parser->node_marks, 0, parser->slot_capacity / 64 * sizeof(uint64_t));
+    }
     
-    hyp_ast_node_t* program = create_node(parser, AST_PROGRAM);
-    if (!program) return NULL;
+    /* Error tokens before the first statement count as part of it */
+    bool leading_error = parser->had_error;
     
-    HYP_ARRAY_INIT(&program->program.statements);
+    size_t start = list_begin(parser);
+    if (parser->jobs > 1 && !parser->incremental) {
+        parse_parallel(parser);
+    }
     
+    /* Whatever is left, which is everything unless parsed in parallel */
     while (!match(parser, TOKEN_EOF)) {
-        hyp_ast_node_t* decl = parse_declaration(parser);
+        hyp_parser_decl_t record;
+        slot_t decl = parse_top_level(parser, &record);
         if (decl) {
-            HYP_ARRAY_PUSH(&program->program.statements, decl);
+            list_push(parser, decl);
         }
         
-        if (parser->panic_mode) {
-            synchronize(parser);
+        if (parser->incremental) {
+            if (parser->decls.count == 0) {
+                record.first_token = 0;
+                record.had_error |= leading_error;
+            }
+            HYP_ARRAY_PUSH(&parser->decls, record);
         }
     }
+    LIST_END(parser, 0, program.statements, start, 1);
     
-    return parser->had_error ? NULL : program;
+    if (parser->had_error) return NULL;
+    
+    parser->tree_size = (size_t)parser->slot_count * SLOT_SIZE;
+    return NODE(parser, 0);
+}
+
+hyp_ast_node_t* hyp_parser_parse(hyp_parser_t* parser) {
+    double started = hyp_wall_time();
+    hyp_ast_node_t* ast = parse_program(parser);
+    if (parser) {
+        hyp_metric_observe(&metric_parse, hyp_wall_time() - started);
+        hyp_metric_add(&metric_nodes, parser->slot_count);
+        if (parser->had_error) hyp_metric_add(&metric_errors, 1);
+    }
+    return ast;
+}
+
+static hyp_ast_node_t* update_program(hyp_parser_t* parser, const hyp_token_edit_t* edit) {
+    if (!parser || !edit || !parser->incremental || parser->slot_count == 0) return NULL;
+    
+    hyp_parser_decl_t* decls = parser->decls.data;
+    size_t count = parser->decls.count;
+    size_t changed = edit->first + edit->removed;  /* Old tokens from edit->first up to here changed */
+    ptrdiff_t shift = (ptrdiff_t)edit->inserted - (ptrdiff_t)edit->removed;
+    
+    /* Statements before the first that saw a changed token are kept as
+     * they are; statements are contiguous, so this is where parsing starts */
+    size_t keep = 0;
+    size_t high = count;
+    while (keep < high) {
+        size_t middle = keep + (high - keep) / 2;
+        if (decls[middle].end_token < edit->first) {
+            keep = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    
+    /* Later ones may be taken over if nothing they saw changed */
+    size_t next = keep;
+    while (next < count && decls[next].first_token < changed) next++;
+    
+    size_t edit_line, column;
+    hyp_lexer_location(parser->lexer, edit->end, &edit_line, &column);
+    
+    /* As advance() leaves them: previous is never an error token */
+    parser->current = keep ? decls[keep - 1].end_token : 0;
+    parser->previous = parser->current ? parser->current - 1 : 0;
+    while (parser->previous > 0 && TOKEN_TYPE(parser, parser->previous) == TOKEN_ERROR) parser->previous--;
+    parser->had_error = false;
+    parser->panic_mode = keep && keep < count ? decls[keep].panic : false;
+    parser->entries.count = 0;
+    if (parser->current == 0) skip_error_tokens(parser);
+    bool leading_error = parser->had_error;
+    
+    HYP_ARRAY(hyp_parser_decl_t) parsed;
+    HYP_ARRAY_INIT(&parsed);
+    size_t resume = count;
+    while (!check(parser, TOKEN_EOF)) {
+        hyp_parser_decl_t record;
+        parse_top_level(parser, &record);
+        if (parsed.count == 0 && keep == 0) {
+            record.first_token = 0;
+            record.had_error |= leading_error;
+        }
+        HYP_ARRAY_PUSH(&parsed, record);
+        
+        /* Take over from an old statement starting where this one ended
+         * in the same state, provided the token before it (which it may
+         * look at) was not rescanned and is on a line after the edit, so
+         * that nothing it holds has moved columns */
+        while (next < count && (ptrdiff_t)decls[next].first_token + shift < (ptrdiff_t)parser->current) next++;
+        if (next < count && (ptrdiff_t)decls[next].first_token + shift == (ptrdiff_t)parser->current &&
+            decls[next].panic == parser->panic_mode && parser->previous >= edit->first + edit->inserted) {
+            size_t line;
+            hyp_lexer_location(parser->lexer, TOKEN_START(parser, parser->previous), &line, &column);
+            if (line > edit_line) {
+                resume = next;
+                break;
+            }
+        }
+    }
+    
+    /* The program's list needs rewriting only if it gains or loses statements */
+    size_t replaced_nodes = 0;
+    size_t parsed_nodes = 0;
+    for (size_t i = keep; i < resume; i++) replaced_nodes += decls[i].node != 0;
+    for (size_t i = 0; i < parsed.count; i++) parsed_nodes += parsed.data[i].node != 0;
+    
+    for (size_t i = resume; i < count; i++) {
+        decls[i].first_token = (uint32_t)((ptrdiff_t)decls[i].first_token + shift);
+        decls[i].end_token = (uint32_t)((ptrdiff_t)decls[i].end_token + shift);
+        if (edit->lines) shift_lines(parser, &decls[i], edit->lines);
+    }
+    
+    /* Replace the statements from keep to resume with those just parsed */
+    size_t tail = count - resume;
+    size_t parsed_count = parsed.count;
+    size_t new_count = keep + parsed_count + tail;
+    if (new_count > parser->decls.capacity) {
+        decls = HYP_REALLOC(parser->decls.data, new_count * sizeof(hyp_parser_decl_t));
+        if (!decls) {
+            HYP_ARRAY_FREE(&parsed);
+            return NULL;
+        }
+        parser->decls.data = decls;
+        parser->decls.capacity = new_count;
+    }
+    memmove(decls + keep + parsed.count, decls + resume, tail * sizeof(hyp_parser_decl_t));
+    if (parsed.count) memcpy(decls + keep, parsed.data, parsed.count * sizeof(hyp_parser_decl_t));
+    parser->decls.count = new_count;
+    HYP_ARRAY_FREE(&parsed);
+    
+    /* Error tokens before the first statement count even with no statements */
+    bool had_error = leading_error;
+    size_t used = 1;
+    size_t entry = 0;  /* List entry of the first statement parsed */
+    for (size_t i = 0; i < new_count; i++) {
+        had_error |= decls[i].had_error;
+        used += decls[i].end_slot - decls[i].first_slot;
+        if (i < keep) entry += decls[i].node != 0;
+    }
+    
+    /* Compact once replaced statements take more slots than the tree */
+    bool compact = parser->slot_count > 2 * used + 1024;
+    if (compact) compact_tree(parser);
+    
+    if (compact || replaced_nodes != parsed_nodes) {
+        link_program(parser);
+    } else {
+        int32_t* items = (int32_t*)hyp_ast_items(&NODE(parser, 0)->program.statements);
+        for (size_t i = keep; i < keep + parsed_count; i++) {
+            if (!decls[i].node) continue;
+            items[entry] = (int32_t)((char*)NODE(parser, decls[i].node) - (char*)&items[entry]);
+            entry++;
+        }
+    }
+    
+    parser->had_error = had_error;
+    parser->tree_size = (size_t)parser->slot_count * SLOT_SIZE;
+    return had_error ? NULL : NODE(parser, 0);
+}
+
+hyp_ast_node_t* hyp_parser_update(hyp_parser_t* parser, const hyp_token_edit_t* edit) {
+    double started = hyp_wall_time();
+    hyp_ast_node_t* ast = update_program(parser, edit);
+    if (parser && parser->incremental) {
+        hyp_metric_observe(&metric_update, hyp_wall_time() - started);
+        if (parser->had_error) hyp_metric_add(&metric_errors, 1);
+    }
+    return ast;
 }
 
 bool hyp_parser_had_error(hyp_parser_t* parser) {
     return parser ? parser->had_error : true;
-}
\ No newline at end of file
+}
@@ -0,0 +1,724 @@
+/**
+ * Hyper Programming Language - Execution Profiles Implementation
+ *
+ * Sites are numbered in pre-order per kind within each function, so the
+ * numbering only depends on the function's own body. Binding walks the
+ * AST once and fills a pointer-keyed hash map, which keeps recording to a
+ * single probe per event.
+ */
+
+#include "../../include/profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+static void profile_error(hyp_profile_t* profile, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(profile->error_message, sizeof(profile->error_message), format, args);
+    va_end(args);
+    profile->has_error = true;
+}
+
+hyp_profile_t* hyp_profile_create(void) {
+    hyp_profile_t* profile = HYP_MALLOC(sizeof(hyp_profile_t));
+    if (!profile) return NULL;
+
+    memset(profile, 0, sizeof(hyp_profile_t));
+    HYP_ARRAY_INIT(&profile->functions);
+    return profile;
+}
+
+static void function_clear(hyp_profile_function_t* function) {
+    for (size_t i = 0; i < function->call_sites.count; i++) {
+        HYP_FREE(function->call_sites.data[i].target);
+    }
+    HYP_ARRAY_FREE(&function->branches);
+    HYP_ARRAY_FREE(&function->loops);
+    HYP_ARRAY_FREE(&function->call_sites);
+    HYP_ARRAY_FREE(&function->operands);
+    HYP_ARRAY_INIT(&function->branches);
+    HYP_ARRAY_INIT(&function->loops);
+    HYP_ARRAY_INIT(&function->call_sites);
+    HYP_ARRAY_INIT(&function->operands);
+    function->calls = 0;
+}
+
+void hyp_profile_destroy(hyp_profile_t* profile) {
+    if (!profile) return;
+
+    for (size_t i = 0; i < profile->functions.count; i++) {
+        function_clear(&profile->functions.data[i]);
+        HYP_FREE(profile->functions.data[i].name);
+    }
+    HYP_ARRAY_FREE(&profile->functions);
+    HYP_FREE(profile->sites);
+    HYP_FREE(profile);
+}
+
+static hyp_profile_function_t* find_function(const hyp_profile_t* profile, const char* name) {
+    for (size_t i = 0; i < profile->functions.count; i++) {
+        if (strcmp(profile->functions.data[i].name, name) == 0) {
+            return &profile->functions.data[i];
+        }
+    }
+    return NULL;
+}
+
+static hyp_profile_function_t* add_function(hyp_profile_t* profile, const char* name, uint64_t hash) {
+    hyp_profile_function_t function;
+    memset(&function, 0, sizeof(function));
+    function.name = hyp_strdup(name);
+    function.hash = hash;
+    if (!function.name) return NULL;
+
+    HYP_ARRAY_PUSH(&profile->functions, function);
+    return &profile->functions.data[profile->functions.count - 1];
+}
+
+/* Structural hashing */
+
+static uint64_t hash_node(const hyp_ast_node_t* node, uint64_t hash);
+
+static uint64_t hash_int(uint64_t value, uint64_t hash) {
+    return hyp_hash_bytes(&value, sizeof(value), hash);
+}
+
+static uint64_t hash_text(const char* text, uint64_t hash) {
+    return text ? hyp_hash_string(text, hash) : hash_int(0, hash);
+}
+
+static uint64_t hash_nodes(const hyp_ast_list_t* nodes, uint64_t hash) {
+    hash = hash_int(nodes->count, hash);
+    for (size_t i = 0; i < nodes->count; i++) {
+        hash = hash_node(hyp_ast_list_at(nodes, i), hash);
+    }
+    return hash;
+}
+
+/* Line and column are deliberately left out so edits elsewhere in the
+ * file do not invalidate a function */
+static uint64_t hash_node(const hyp_ast_node_t* node, uint64_t hash) {
+    if (!node) return hash_int(~0ULL, hash);
+
+    hash = hash_int((uint64_t)node->type, hash);
+    switch (node->type) {
+        case AST_NUMBER:
+            return hyp_hash_bytes(&node->number.value, sizeof(double), hash);
+        case AST_STRING:
+            return hash_text(HYP_AST_TEXT(node, string.value), hash);
+        case AST_BOOLEAN:
+            return hash_int(node->boolean.value, hash);
+        case AST_IDENTIFIER:
+            return hash_text(HYP_AST_TEXT(node, identifier.name), hash);
+        case AST_BINARY_OP:
+            hash = hash_int((uint64_t)node->binary_op.op, hash);
+            hash = hash_node(HYP_AST_CHILD(node, binary_op.left), hash);
+            return hash_node(HYP_AST_CHILD(node, binary_op.right), hash);
+        case AST_UNARY_OP:
+            hash = hash_int((uint64_t)node->unary_op.op, hash);
+            return hash_node(HYP_AST_CHILD(node, unary_op.operand), hash);
+        case AST_ASSIGNMENT:
+            hash = hash_int((uint64_t)node->assignment.op, hash);
+            hash = hash_node(HYP_AST_CHILD(node, assignment.target), hash);
+            return hash_node(HYP_AST_CHILD(node, assignment.value), hash);
+        case AST_CALL:
+            hash = hash_node(HYP_AST_CHILD(node, call.callee), hash);
+            return hash_nodes(&node->call.arguments, hash);
+        case AST_MEMBER_ACCESS:
+            hash = hash_node(HYP_AST_CHILD(node, member_access.object), hash);
+            return hash_text(HYP_AST_TEXT(node, member_access.member), hash);
+        case AST_INDEX_ACCESS:
+            hash = hash_node(HYP_AST_CHILD(node, index_access.object), hash);
+            return hash_node(HYP_AST_CHILD(node, index_access.index), hash);
+        case AST_CONDITIONAL:
+            hash = hash_node(HYP_AST_CHILD(node, conditional.condition), hash);
+            hash = hash_node(HYP_AST_CHILD(node, conditional.then_expr), hash);
+            return hash_node(HYP_AST_CHILD(node, conditional.else_expr), hash);
+        case AST_ARRAY_LITERAL:
+            return hash_nodes(&node->array_literal.elements, hash);
+        case AST_OBJECT_LITERAL: {
+            const hyp_object_property_t* properties = HYP_AST_PROPERTIES(&node->object_literal.properties);
+            hash = hash_int(node->object_literal.properties.count, hash);
+            for (size_t i = 0; i < node->object_literal.properties.count; i++) {
+                hash = hash_text(hyp_ast_text(&properties[i].key), hash);
+                hash = hash_node(hyp_ast_get(&properties[i].value), hash);
+            }
+            return hash;
+        }
+        case AST_EXPRESSION_STMT:
+            return hash_node(HYP_AST_CHILD(node, expression_stmt.expression), hash);
+        case AST_VARIABLE_DECL:
+            hash = hash_text(HYP_AST_TEXT(node, variable_decl.name), hash);
+            return hash_node(HYP_AST_CHILD(node, variable_decl.initializer), hash);
+        case AST_FUNCTION_DECL: {
+            const hyp_parameter_t* parameters = HYP_AST_PARAMETERS(&node->function_decl.parameters);
+            hash = hash_text(HYP_AST_TEXT(node, function_decl.name), hash);
+            hash = hash_int(node->function_decl.parameters.count, hash);
+            for (size_t i = 0; i < node->function_decl.parameters.count; i++) {
+                hash = hash_text(hyp_ast_text(&parameters[i].name), hash);
+            }
+            return hash_node(HYP_AST_CHILD(node, function_decl.body), hash);
+        }
+        case AST_IF_STMT:
+            hash = hash_node(HYP_AST_CHILD(node, if_stmt.condition), hash);
+            hash = hash_node(HYP_AST_CHILD(node, if_stmt.then_stmt), hash);
+            return hash_node(HYP_AST_CHILD(node, if_stmt.else_stmt), hash);
+        case AST_WHILE_STMT:
+            hash = hash_node(HYP_AST_CHILD(node, while_stmt.condition), hash);
+            return hash_node(HYP_AST_CHILD(node, while_stmt.body), hash);
+        case AST_RETURN_STMT:
+            return hash_node(HYP_AST_CHILD(node, return_stmt.value), hash);
+        case AST_BLOCK_STMT:
+            return hash_nodes(&node->block_stmt.statements, hash);
+        default:
+            return hash;
+    }
+}
+
+uint64_t hyp_profile_function_hash(const hyp_ast_node_t* function) {
+    return hash_node(function, HYP_HASH_SEED);
+}
+
+/* Top-level code outside functions forms the module pseudo-function */
+static uint64_t module_hash(const hyp_ast_node_t* program) {
+    uint64_t hash = HYP_HASH_SEED;
+    for (size_t i = 0; i < program->program.statements.count; i++) {
+        const hyp_ast_node_t* stmt = HYP_AST_AT(program, program.statements, i);
+        if (stmt->type != AST_FUNCTION_DECL) {
+            hash = hash_node(stmt, hash);
+        }
+    }
+    return hash;
+}
+
+/* Node -> site map */
+
+static size_t site_slot(const hyp_ast_node_t* node, size_t capacity) {
+    uint64_t key = (uint64_t)(uintptr_t)node;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key & (capacity - 1);
+}
+
+static const hyp_profile_site_t* site_find(const hyp_profile_t* profile, const hyp_ast_node_t* node) {
+    if (profile->site_capacity == 0) return NULL;
+
+    size_t slot = site_slot(node, profile->site_capacity);
+    while (profile->sites[slot].node) {
+        if (profile->sites[slot].node == node) {
+            return &profile->sites[slot];
+        }
+        slot = (slot + 1) & (profile->site_capacity - 1);
+    }
+    return NULL;
+}
+
+static bool site_insert_raw(hyp_profile_site_t* sites, size_t capacity, hyp_profile_site_t site) {
+    size_t slot = site_slot(site.node, capacity);
+    while (sites[slot].node) {
+        if (sites[slot].node == site.node) {
+            sites[slot] = site;
+            return false;
+        }
+        slot = (slot + 1) & (capacity - 1);
+    }
+    sites[slot] = site;
+    return true;
+}
+
+static bool site_insert(hyp_profile_t* profile, hyp_profile_site_t site) {
+    /* Keep the load factor below one half */
+    if ((profile->site_count + 1) * 2 > profile->site_capacity) {
+        size_t capacity = profile->site_capacity ? profile->site_capacity * 2 : 256;
+        hyp_profile_site_t* sites = HYP_MALLOC(sizeof(hyp_profile_site_t) * capacity);
+        if (!sites) return false;
+        memset(sites, 0, sizeof(hyp_profile_site_t) * capacity);
+
+        for (size_t i = 0; i < profile->site_capacity; i++) {
+            if (profile->sites[i].node) {
+                site_insert_raw(sites, capacity, profile->sites[i]);
+            }
+        }
+        HYP_FREE(profile->sites);
+        profile->sites = sites;
+        profile->site_capacity = capacity;
+    }
+
+    if (site_insert_raw(profile->sites, profile->site_capacity, site)) {
+        profile->site_count++;
+    }
+    return true;
+}
+
+/* Binding */
+
+typedef struct {
+    hyp_profile_t* profile;
+    uint32_t function;
+    uint32_t branches;
+    uint32_t loops;
+    uint32_t calls;
+    uint32_t operands;
+    size_t nodes;
+} bind_state_t;
+
+static void bind_site(bind_state_t* state, const hyp_ast_node_t* node, hyp_profile_site_kind_t kind, uint32_t index) {
+    hyp_profile_site_t site = { node, state->function, index, kind };
+    if (!site_insert(state->profile, site)) {
+        profile_error(state->profile, "Out of memory while binding profile");
+    }
+}
+
+static void bind_node(bind_state_t* state, const hyp_ast_node_t* node);
+
+static void bind_nodes(bind_state_t* state, const hyp_ast_list_t* nodes) {
+    for (size_t i = 0; i < nodes->count; i++) {
+        bind_node(state, hyp_ast_list_at(nodes, i));
+    }
+}
+
+static void bind_node(bind_state_t* state, const hyp_ast_node_t* node) {
+    if (!node) return;
+    state->nodes++;
+
+    switch (node->type) {
+        case AST_BINARY_OP:
+            if (node->binary_op.op != BINOP_AND && node->binary_op.op != BINOP_OR) {
+                bind_site(state, node, HYP_SITE_OPERANDS, state->operands++);
+            }
+            bind_node(state, HYP_AST_CHILD(node, binary_op.left));
+            bind_node(state, HYP_AST_CHILD(node, binary_op.right));
+            break;
+        case AST_UNARY_OP:
+            bind_node(state, HYP_AST_CHILD(node, unary_op.operand));
+            break;
+        case AST_ASSIGNMENT:
+            bind_node(state, HYP_AST_CHILD(node, assignment.target));
+            bind_node(state, HYP_AST_CHILD(node, assignment.value));
+            break;
+        case AST_CALL:
+            bind_site(state, node, HYP_SITE_CALL, state->calls++);
+            bind_node(state, HYP_AST_CHILD(node, call.callee));
+            bind_nodes(state, &node->call.arguments);
+            break;
+        case AST_MEMBER_ACCESS:
+            bind_node(state, HYP_AST_CHILD(node, member_access.object));
+            break;
+        case AST_INDEX_ACCESS:
+            bind_node(state, HYP_AST_CHILD(node, index_access.object));
+            bind_node(state, HYP_AST_CHILD(node, index_access.index));
+            break;
+        case AST_CONDITIONAL:
+            bind_node(state, HYP_AST_CHILD(node, conditional.condition));
+            bind_node(state, HYP_AST_CHILD(node, conditional.then_expr));
+            bind_node(state, HYP_AST_CHILD(node, conditional.else_expr));
+            break;
+        case AST_ARRAY_LITERAL:
+            bind_nodes(state, &node->array_literal.elements);
+            break;
+        case AST_OBJECT_LITERAL: {
+            const hyp_object_property_t* properties = HYP_AST_PROPERTIES(&node->object_literal.properties);
+            for (size_t i = 0; i < node->object_literal.properties.count; i++) {
+                bind_node(state, hyp_ast_get(&properties[i].value));
+            }
+            break;
+        }
+        case AST_EXPRESSION_STMT:
+            bind_node(state, HYP_AST_CHILD(node, expression_stmt.expression));
+            break;
+        case AST_VARIABLE_DECL:
+            bind_node(state, HYP_AST_CHILD(node, variable_decl.initializer));
+            break;
+        case AST_IF_STMT:
+            bind_site(state, node, HYP_SITE_BRANCH, state->branches++);
+            bind_node(state, HYP_AST_CHILD(node, if_stmt.condition));
+            bind_node(state, HYP_AST_CHILD(node, if_stmt.then_stmt));
+            bind_node(state, HYP_AST_CHILD(node, if_stmt.else_stmt));
+            break;
+        case AST_WHILE_STMT:
+            bind_site(state, node, HYP_SITE_LOOP, state->loops++);
+            bind_node(state, HYP_AST_CHILD(node, while_stmt.condition));
+            bind_node(state, HYP_AST_CHILD(node, while_stmt.body));
+            break;
+        case AST_RETURN_STMT:
+            bind_node(state, HYP_AST_CHILD(node, return_stmt.value));
+            break;
+        case AST_BLOCK_STMT:
+            bind_nodes(state, &node->block_stmt.statements);
+            break;
+        default:
+            break;
+    }
+}
+
+/* Grow a function's record arrays to the number of sites in its body */
+static void size_records(hyp_profile_function_t* function, const bind_state_t* state) {
+    while (function->branches.count < state->branches) {
+        hyp_profile_branch_t record = { 0, 0 };
+        HYP_ARRAY_PUSH(&function->branches, record);
+    }
+    while (function->loops.count < state->loops) {
+        hyp_profile_loop_t record = { 0, 0 };
+        HYP_ARRAY_PUSH(&function->loops, record);
+    }
+    while (function->call_sites.count < state->calls) {
+        hyp_profile_call_t record = { 0, NULL };
+        HYP_ARRAY_PUSH(&function->call_sites, record);
+    }
+    while (function->operands.count < state->operands) {
+        hyp_profile_operands_t record = { 0, 0 };
+        HYP_ARRAY_PUSH(&function->operands, record);
+    }
+}
+
+static void bind_function(hyp_profile_t* profile, const char* name, uint64_t hash,
+                          const hyp_ast_node_t* entry, const hyp_ast_node_t* const* body, size_t count) {
+    /* Only functions unchanged since the profile was written count as
+     * matched; changed and new ones start empty and get no hints */
+    hyp_profile_function_t* function = find_function(profile, name);
+    bool matched = function && function->hash == hash;
+    if (function && !matched) {
+        function_clear(function);
+        function->hash = hash;
+    } else if (!function) {
+        function = add_function(profile, name, hash);
+        if (!function) {
+            profile_error(profile, "Out of memory while binding profile");
+            return;
+        }
+    }
+    function->matched = matched;
+
+    bind_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.profile = profile;
+    state.function = (uint32_t)(function - profile->functions.data);
+
+    bind_site(&state, entry, HYP_SITE_FUNCTION, 0);
+    for (size_t i = 0; i < count; i++) {
+        bind_node(&state, body[i]);
+    }
+
+    /* Binding may have moved the array, so look the function up again */
+    function = &profile->functions.data[state.function];
+    function->node_count = state.nodes;
+    size_records(function, &state);
+}
+
+hyp_error_t hyp_profile_bind(hyp_profile_t* profile, hyp_ast_node_t* program) {
+    if (!profile || !program || program->type != AST_PROGRAM) return HYP_ERROR_INVALID_ARG;
+
+    profile->site_count = 0;
+    if (profile->sites) {
+        memset(profile->sites, 0, sizeof(hyp_profile_site_t) * profile->site_capacity);
+    }
+    for (size_t i = 0; i < profile->functions.count; i++) {
+        profile->functions.data[i].matched = false;
+    }
+
+    const hyp_ast_list_t* statements = &program->program.statements;
+    for (size_t i = 0; i < statements->count; i++) {
+        hyp_ast_node_t* stmt = hyp_ast_list_at(statements, i);
+        if (stmt->type == AST_FUNCTION_DECL) {
+            const hyp_ast_node_t* body = HYP_AST_CHILD(stmt, function_decl.body);
+            bind_function(profile, HYP_AST_TEXT(stmt, function_decl.name), hyp_profile_function_hash(stmt),
+                          body, &body, 1);
+        }
+    }
+
+    /* Everything else runs as part of module initialization */
+    HYP_ARRAY(const hyp_ast_node_t*) top_level;
+    HYP_ARRAY_INIT(&top_level);
+    for (size_t i = 0; i < statements->count; i++) {
+        const hyp_ast_node_t* stmt = hyp_ast_list_at(statements, i);
+        if (stmt->type != AST_FUNCTION_DECL) {
+            HYP_ARRAY_PUSH(&top_level, stmt);
+        }
+    }
+    bind_function(profile, HYP_PROFILE_MODULE_NAME, module_hash(program),
+                  program, top_level.data, top_level.count);
+    HYP_ARRAY_FREE(&top_level);
+
+    return profile->has_error ? HYP_ERROR_MEMORY : HYP_OK;
+}
+
+/* Recording */
+
+static hyp_profile_function_t* site_function(hyp_profile_t* profile, const hyp_ast_node_t* node,
+                                             hyp_profile_site_kind_t kind, uint32_t* index) {
+    const hyp_profile_site_t* site = site_find(profile, node);
+    if (!site || site->kind != kind) return NULL;
+
+    *index = site->index;
+    return &profile->functions.data[site->function];
+}
+
+void hyp_profile_record_call(hyp_profile_t* profile, const hyp_ast_node_t* body) {
+    uint32_t index;
+    hyp_profile_function_t* function = site_function(profile, body, HYP_SITE_FUNCTION, &index);
+    if (function) function->calls++;
+}
+
+void hyp_profile_record_branch(hyp_profile_t* profile, const hyp_ast_node_t* node, bool taken) {
+    uint32_t index;
+    hyp_profile_function_t* function = site_function(profile, node, HYP_SITE_BRANCH, &index);
+    if (!function) return;
+
+    if (taken) {
+        function->branches.data[index].taken++;
+    } else {
+        function->branches.data[index].not_taken++;
+    }
+}
+
+void hyp_profile_record_loop(hyp_profile_t* profile, const hyp_ast_node_t* node, uint64_t iterations) {
+    uint32_t index;
+    hyp_profile_function_t* function = site_function(profile, node, HYP_SITE_LOOP, &index);
+    if (!function) return;
+
+    function->loops.data[index].entries++;
+    function->loops.data[index].iterations += iterations;
+}
+
+void hyp_profile_record_call_site(hyp_profile_t* profile, const hyp_ast_node_t* node, const char* target) {
+    uint32_t index;
+    hyp_profile_function_t* function = site_function(profile, node, HYP_SITE_CALL, &index);
+    if (!function) return;
+
+    hyp_profile_call_t* call = &function->call_sites.data[index];
+    call->count++;
+    if (target && (!call->target || strcmp(call->target, target) != 0)) {
+        HYP_FREE(call->target);
+        call->target = hyp_strdup(target);
+    }
+}
+
+void hyp_profile_record_operands(hyp_profile_t* profile, const hyp_ast_node_t* node, uint32_t types) {
+    uint32_t index;
+    hyp_profile_function_t* function = site_function(profile, node, HYP_SITE_OPERANDS, &index);
+    if (!function) return;
+
+    function->operands.data[index].count++;
+    function->operands.data[index].types |= types;
+}
+
+/* Queries */
+
+static bool biased(uint64_t count, uint64_t total) {
+    return count * 100 >= total * HYP_PROFILE_BIAS_PERCENT;
+}
+
+int hyp_profile_branch_bias(const hyp_profile_t* profile, const hyp_ast_node_t* node) {
+    if (!profile) return 0;
+
+    const hyp_profile_site_t* site = site_find(profile, node);
+    if (!site) return 0;
+
+    const hyp_profile_function_t* function = &profile->functions.data[site->function];
+    uint64_t taken, not_taken;
+    if (site->kind == HYP_SITE_BRANCH) {
+        taken = function->branches.data[site->index].taken;
+        not_taken = function->branches.data[site->index].not_taken;
+    } else if (site->kind == HYP_SITE_LOOP) {
+        /* Each entry ends with exactly one failed condition check */
+        taken = function->loops.data[site->index].iterations;
+        not_taken = function->loops.data[site->index].entries;
+    } else {
+        return 0;
+    }
+
+    uint64_t total = taken + not_taken;
+    if (total < HYP_PROFILE_MIN_SAMPLES) return 0;
+    if (biased(taken, total)) return 1;
+    if (biased(not_taken, total)) return -1;
+    return 0;
+}
+
+uint32_t hyp_profile_operand_types(const hyp_profile_t* profile, const hyp_ast_node_t* node) {
+    if (!profile) return 0;
+
+    const hyp_profile_site_t* site = site_find(profile, node);
+    if (!site || site->kind != HYP_SITE_OPERANDS) return 0;
+
+    const hyp_profile_operands_t* record = &profile->functions.data[site->function].operands.data[site->index];
+    return record->count >= HYP_PROFILE_MIN_SAMPLES ? record->types : 0;
+}
+
+const hyp_profile_function_t* hyp_profile_function(const hyp_profile_t* profile, const char* name) {
+    if (!profile || !name) return NULL;
+
+    const hyp_profile_function_t* function = find_function(profile, name);
+    return function && function->matched ? function : NULL;
+}
+
+/* File format:
+ *
+ *   HPROF 1
+ *   fn <hash> <calls> <nodes> <name>
+ *   branch <id> <taken> <not-taken>
+ *   loop <id> <entries> <iterations>
+ *   call <id> <count> <target>
+ *   types <id> <count> <mask>
+ *   end
+ *
+ * Records with zero counts are omitted. Unknown lines are skipped so
+ * newer writers can add record kinds without breaking older readers. */
+
+hyp_error_t hyp_profile_write(hyp_profile_t* profile, const char* filename) {
+    if (!profile || !filename) return HYP_ERROR_INVALID_ARG;
+
+    /* Write to a temporary name so an interrupted run leaves the old profile intact */
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", filename);
+
+    FILE* file = fopen(temp_path, "w");
+    if (!file) {
+        profile_error(profile, "Could not open '%s' for writing", temp_path);
+        return HYP_ERROR_IO;
+    }
+
+    fprintf(file, "%s %d\n", HYP_PROFILE_MAGIC, HYP_PROFILE_VERSION);
+    for (size_t i = 0; i < profile->functions.count; i++) {
+        hyp_profile_function_t* function = &profile->functions.data[i];
+        fprintf(file, "fn %016llx %llu %zu %s\n", (unsigned long long)function->hash,
+                (unsigned long long)function->calls, function->node_count, function->name);
+
+        for (size_t j = 0; j < function->branches.count; j++) {
+            hyp_profile_branch_t* record = &function->branches.data[j];
+            if (record->taken || record->not_taken) {
+                fprintf(file, "branch %zu %llu %llu\n", j, (unsigned long long)record->taken,
+                        (unsigned long long)record->not_taken);
+            }
+        }
+        for (size_t j = 0; j < function->loops.count; j++) {
+            hyp_profile_loop_t* record = &function->loops.data[j];
+            if (record->entries) {
+                fprintf(file, "loop %zu %llu %llu\n", j, (unsigned long long)record->entries,
+                        (unsigned long long)record->iterations);
+            }
+        }
+        for (size_t j = 0; j < function->call_sites.count; j++) {
+            hyp_profile_call_t* record = &function->call_sites.data[j];
+            if (record->count) {
+                fprintf(file, "call %zu %llu %s\n", j, (unsigned long long)record->count,
+                        record->target ? record->target : "-");
+            }
+        }
+        for (size_t j = 0; j < function->operands.count; j++) {
+            hyp_profile_operands_t* record = &function->operands.data[j];
+            if (record->count) {
+                fprintf(file, "types %zu %llu %u\n", j, (unsigned long long)record->count, record->types);
+            }
+        }
+        fprintf(file, "end\n");
+    }
+
+    bool failed = ferror(file) != 0;
+    if (fclose(file) != 0) failed = true;
+    if (failed) {
+        remove(temp_path);
+        profile_error(profile, "Could not write '%s'", filename);
+        return HYP_ERROR_IO;
+    }
+
+#ifdef _WIN32
+    remove(filename);
+#endif
+    if (rename(temp_path, filename) != 0) {
+        remove(temp_path);
+        profile_error(profile, "Could not move profile to '%s'", filename);
+        return HYP_ERROR_IO;
+    }
+
+    return HYP_OK;
+}
+
+/* Upper bound on record ids accepted from a file */
+#define HYP_PROFILE_MAX_RECORDS (1u << 20)
+
+/* Make sure a record index exists, growing the array with zeroed records */
+#define ENSURE_RECORD(array, index, zero) \
+    do { \
+        while ((array)->count <= (index)) { \
+            HYP_ARRAY_PUSH((array), (zero)); \
+        } \
+    } while (0)
+
+hyp_error_t hyp_profile_load(const char* filename, hyp_profile_t** result) {
+    if (!filename || !result) return HYP_ERROR_INVALID_ARG;
+    *result = NULL;
+
+    FILE* file = fopen(filename, "r");
+    if (!file) return HYP_ERROR_NOT_FOUND;
+
+    hyp_profile_t* profile = hyp_profile_create();
+    if (!profile) {
+        fclose(file);
+        return HYP_ERROR_MEMORY;
+    }
+
+    char line[1024];
+    int version = 0;
+    char magic[16];
+    if (!fgets(line, sizeof(line), file) ||
+        sscanf(line, "%15s %d", magic, &version) != 2 ||
+        strcmp(magic, HYP_PROFILE_MAGIC) != 0) {
+        fclose(file);
+        hyp_profile_destroy(profile);
+        return HYP_ERROR_SYNTAX;
+    }
+    if (version != HYP_PROFILE_VERSION) {
+        /* Profiles from another format version are treated as absent */
+        fclose(file);
+        *result = profile;
+        return HYP_OK;
+    }
+
+    hyp_profile_function_t* function = NULL;
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long long hash, a, b;
+        size_t id, nodes;
+        unsigned int mask;
+        char name[512];
+
+        if (sscanf(line, "fn %llx %llu %zu %511s", &hash, &a, &nodes, name) == 4) {
+            function = find_function(profile, name) ? NULL : add_function(profile, name, hash);
+            if (function) {
+                function->calls = a;
+                function->node_count = nodes;
+            }
+        } else if (!function) {
+            continue;
+        } else if (sscanf(line, "branch %zu %llu %llu", &id, &a, &b) == 3 && id < HYP_PROFILE_MAX_RECORDS) {
+            hyp_profile_branch_t zero = { 0, 0 };
+            ENSURE_RECORD(&function->branches, id, zero);
+            function->branches.data[id].taken = a;
+            function->branches.data[id].not_taken = b;
+        } else if (sscanf(line, "loop %zu %llu %llu", &id, &a, &b) == 3 && id < HYP_PROFILE_MAX_RECORDS) {
+            hyp_profile_loop_t zero = { 0, 0 };
+            ENSURE_RECORD(&function->loops, id, zero);
+            function->loops.data[id].entries = a;
+            function->loops.data[id].iterations = b;
+        } else if (sscanf(line, "call %zu %llu %511s", &id, &a, name) == 3 && id < HYP_PROFILE_MAX_RECORDS) {
+            hyp_profile_call_t zero = { 0, NULL };
+            ENSURE_RECORD(&function->call_sites, id, zero);
+            function->call_sites.data[id].count = a;
+            HYP_FREE(function->call_sites.data[id].target);
+            function->call_sites.data[id].target = strcmp(name, "-") == 0 ? NULL : hyp_strdup(name);
+        } else if (sscanf(line, "types %zu %llu %u", &id, &a, &mask) == 3 && id < HYP_PROFILE_MAX_RECORDS) {
+            hyp_profile_operands_t zero = { 0, 0 };
+            ENSURE_RECORD(&function->operands, id, zero);
+            function->operands.data[id].count = a;
+            function->operands.data[id].types = mask;
+        } else if (strncmp(line, "end", 3) == 0) {
+            function = NULL;
+        }
+    }
+
+    fclose(file);
+    *result = profile;
+    return HYP_OK;
+}
@@ -5,8 +5,14 @@
  * Handles value management, function calls, garbage collection, and execution.
  */
 
+#define HYP_MEM_TAG HYP_MEM_RUNTIME
+
 #include "../../include/hyp_runtime.h"
 #include "../../include/hyp_common.h"
+#include "../../include/hyp_number.h"
+#include "../../include/profile.h"
+#include "../../include/hyp_metrics.h"
+#include "../../include/hyp_thread.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,6 +34,53 @@ typedef struct hyp_native_function {
 /* Forward declarations */
 hyp_object_t* hyp_object_create(void);
 
+/* Object, environment and function headers come from pools of the thread
+ * that makes them. A runtime runs on one thread, so they take no locks;
+ * slabs stay with the thread for the next runtime to reuse and are
+ * released when it exits. A runtime must not outlive its thread. */
+#ifdef HYP_HAVE_THREAD_LOCAL
+static HYP_THREAD_LOCAL hyp_pool_t object_pool;
+static HYP_THREAD_LOCAL hyp_pool_t environment_pool;
+static HYP_THREAD_LOCAL hyp_pool_t function_pool;
+
+static void release_pools(void) {
+    hyp_pool_destroy(&object_pool);
+    hyp_pool_destroy(&environment_pool);
+    hyp_pool_destroy(&function_pool);
+}
+
+static hyp_pool_t* header_pool(hyp_pool_t* pool, size_t size) {
+    if (!pool->block_size) {
+        hyp_pool_init(pool, size);
+        hyp_thread_at_exit(release_pools);
+    }
+    return pool;
+}
+
+#define OBJECT_ALLOC() hyp_pool_alloc(header_pool(&object_pool, sizeof(hyp_object_t)))
+#define OBJECT_FREE(object) hyp_pool_free(&object_pool, (object))
+#define ENVIRONMENT_ALLOC() hyp_pool_alloc(header_pool(&environment_pool, sizeof(hyp_environment_t)))
+#define ENVIRONMENT_FREE(env) hyp_pool_free(&environment_pool, (env))
+#define FUNCTION_ALLOC() hyp_pool_alloc(header_pool(&function_pool, sizeof(hyp_function_t)))
+
+void hyp_runtime_pool_stats(hyp_runtime_pool_stats_t* stats) {
+    hyp_pool_stats(&object_pool, &stats->objects);
+    hyp_pool_stats(&environment_pool, &stats->environments);
+    hyp_pool_stats(&function_pool, &stats->functions);
+}
+#else
+/* Pools would be shared by every thread; use the allocator instead */
+#define OBJECT_ALLOC() HYP_MALLOC(sizeof(hyp_object_t))
+#define OBJECT_FREE(object) HYP_FREE(object)
+#define ENVIRONMENT_ALLOC() HYP_MALLOC(sizeof(hyp_environment_t))
+#define ENVIRONMENT_FREE(env) HYP_FREE(env)
+#define FUNCTION_ALLOC() HYP_MALLOC(sizeof(hyp_function_t))
+
+void hyp_runtime_pool_stats(hyp_runtime_pool_stats_t* stats) {
+    memset(stats, 0, sizeof(hyp_runtime_pool_stats_t));
+}
+#endif
+
 /* Built-in function implementations */
 static hyp_value_t builtin_print(hyp_runtime_t* runtime, hyp_value_t* args, size_t arg_count) {
     (void)runtime; /* Suppress unused parameter warning */
@@ -40,9 +93,12 @@ static hyp_value_t builtin_print(hyp_runtime_t* runtime, hyp_value_t* args, size
             case HYP_VAL_BOOLEAN:
                 printf("%s", args[i].boolean ? "true" : "false");
                 break;
-            case HYP_VAL_NUMBER:
-                printf("%g", args[i].number);
+            case HYP_VAL_NUMBER: {
+                char buffer[HYP_NUMBER_BUFFER_SIZE];
+                hyp_number_format(args[i].number, buffer);
+                fputs(buffer, stdout);
                 break;
+            }
             case HYP_VAL_STRING:
                 printf("%s", args[i].string ? args[i].string : "(null)");
                 break;
@@ -116,6 +172,37 @@ static hyp_value_t builtin_len(hyp_runtime_t* runtime, hyp_value_t* args, size_t
     }
 }
 
+/* parseNumber(text): the number text spells, or NaN if it spells none.
+ * Surrounding whitespace is ignored and numbers are returned as they are. */
+hyp_value_t hyp_builtin_parse_number(hyp_runtime_t* runtime, hyp_value_t* args, size_t arg_count) {
+    if (arg_count != 1) {
+        runtime->has_error = true;
+        strcpy(runtime->error_message, "parseNumber expects exactly 1 argument");
+        return hyp_value_null();
+    }
+    
+    if (args[0].type == HYP_VAL_NUMBER) return args[0];
+    if (args[0].type != HYP_VAL_STRING) {
+        runtime->has_error = true;
+        strcpy(runtime->error_message, "parseNumber can only be called on strings or numbers");
+        return hyp_value_null();
+    }
+    
+    const char* text = args[0].string ? args[0].string : "";
+    while (*text == ' ' || *text == '\t' || *text == '\n' || *text == '\r') text++;
+    size_t length = strlen(text);
+    while (length > 0 && (text[length - 1] == ' ' || text[length - 1] == '\t' ||
+                          text[length - 1] == '\n' || text[length - 1] == '\r')) {
+        length--;
+    }
+    
+    double value;
+    if (length == 0 || hyp_number_parse(text, length, &value) != length) {
+        value = NAN;
+    }
+    return hyp_value_number(value);
+}
+
 /* Value creation functions */
 hyp_value_t hyp_value_null(void) {
     hyp_value_t value;
@@ -189,7 +276,7 @@ hyp_value_t hyp_value_native_function(const char* name, hyp_value_t (*fn)(hyp_ru
 
 /* Object functions */
 hyp_object_t* hyp_object_create(void) {
-    hyp_object_t* object = HYP_MALLOC(sizeof(hyp_object_t));
+    hyp_object_t* object = OBJECT_ALLOC();
     if (!object) return NULL;
     
     object->properties = NULL;
@@ -207,7 +294,7 @@ void hyp_object_destroy(hyp_object_t* object) {
     }
     
     HYP_FREE(object->properties);
-    HYP_FREE(object);
+    OBJECT_FREE(object);
 }
 
 void hyp_object_set(hyp_object_t* object, const char* key, hyp_value_t value) {
@@ -254,14 +341,12 @@ hyp_value_t hyp_object_get(hyp_object_t* object, const char* key) {
 
 /* Environment functions */
 hyp_environment_t* hyp_environment_create(hyp_environment_t* parent) {
-    hyp_environment_t* env = HYP_MALLOC(sizeof(hyp_environment_t));
+    hyp_environment_t* env = ENVIRONMENT_ALLOC();
     if (!env) return NULL;
     
     env->parent = parent;
-    env->variables.names = NULL;
-    env->variables.values = NULL;
-    env->variables.count = 0;
-    env->variables.capacity = 0;
+    env->captured = false;
+    HYP_SMALL_VECTOR_INIT(&env->variables);
     
     return env;
 }
@@ -269,66 +354,70 @@ hyp_environment_t* hyp_environment_create(hyp_environment_t* parent) {
 void hyp_environment_destroy(hyp_environment_t* env) {
     if (!env) return;
     
-    if (env->variables.names) {
-        for (size_t i = 0; i < env->variables.count; i++) {
-            HYP_FREE(env->variables.names[i]);
-        }
-        HYP_FREE(env->variables.names);
+    for (size_t i = 0; i < env->variables.count; i++) {
+        HYP_FREE(env->variables.data[i].name);
     }
-    if (env->variables.values) {
-        HYP_FREE(env->variables.values);
+    HYP_SMALL_VECTOR_FREE(&env->variables);
+    ENVIRONMENT_FREE(env);
+}
+
+/* A function declared in env can be called after env's scope is left,
+ * so env and every scope around it must outlive that scope */
+static void environment_capture(hyp_environment_t* env) {
+    for (; env && !env->captured; env = env->parent) {
+        env->captured = true;
     }
-    HYP_FREE(env);
 }
 
-void hyp_environment_define(hyp_environment_t* env, const char* name, hyp_value_t value) {
-    if (!env || !name) return;
+/* Leave a block or call scope: destroy it, or keep it for the functions
+ * that close over it */
+static void environment_leave(hyp_runtime_t* runtime, hyp_environment_t* env) {
+    if (!env) return;
     
-    /* Check if variable already exists */
-    for (size_t i = 0; i < env->variables.count; i++) {
-        if (strcmp(env->variables.names[i], name) == 0) {
-            env->variables.values[i] = value;
-            return;
-        }
+    if (!env->captured) {
+        hyp_environment_destroy(env);
+        return;
     }
     
-    /* Add new variable */
-    if (env->variables.count >= env->variables.capacity) {
-        size_t new_capacity = env->variables.capacity == 0 ? 8 : env->variables.capacity * 2;
-        char** new_names = HYP_REALLOC(env->variables.names, new_capacity * sizeof(char*));
-        hyp_value_t* new_values = HYP_REALLOC(env->variables.values, new_capacity * sizeof(hyp_value_t));
-        
-        if (!new_names || !new_values) {
-            return;
+    HYP_ARRAY_PUSH(&runtime->captured, env);
+}
+
+/* Binding of name in env itself, not its parents */
+static hyp_binding_t* environment_find(hyp_environment_t* env, const char* name) {
+    for (size_t i = 0; i < env->variables.count; i++) {
+        if (strcmp(env->variables.data[i].name, name) == 0) {
+            return &env->variables.data[i];
         }
-        
-        env->variables.names = new_names;
-        env->variables.values = new_values;
-        env->variables.capacity = new_capacity;
     }
+    return NULL;
+}
+
+void hyp_environment_define(hyp_environment_t* env, const char* name, hyp_value_t value) {
+    if (!env || !name) return;
     
-    env->variables.names[env->variables.count] = HYP_MALLOC(strlen(name) + 1);
-    if (!env->variables.names[env->variables.count]) {
+    /* Check if variable already exists */
+    hyp_binding_t* binding = environment_find(env, name);
+    if (binding) {
+        binding->value = value;
         return;
     }
-    strcpy(env->variables.names[env->variables.count], name);
-    env->variables.values[env->variables.count] = value;
-    env->variables.count++;
+    
+    /* Add new variable */
+    hyp_binding_t added = { hyp_strdup(name), value };
+    if (!added.name) return;
+    
+    size_t count = env->variables.count;
+    HYP_SMALL_VECTOR_PUSH(&env->variables, added);
+    if (env->variables.count == count) HYP_FREE(added.name);
 }
 
 hyp_value_t hyp_environment_get(hyp_environment_t* env, const char* name) {
-    if (!env || !name) return hyp_value_null();
+    if (!name) return hyp_value_null();
     
-    /* Search in current environment */
-    for (size_t i = 0; i < env->variables.count; i++) {
-        if (strcmp(env->variables.names[i], name) == 0) {
-            return env->variables.values[i];
-        }
-    }
-    
-    /* Search in parent environment */
-    if (env->parent) {
-        return hyp_environment_get(env->parent, name);
+    /* Search outwards from the current environment */
+    for (; env; env = env->parent) {
+        hyp_binding_t* binding = environment_find(env, name);
+        if (binding) return binding->value;
     }
     
     return hyp_value_null();
@@ -337,19 +426,15 @@ hyp_value_t hyp_environment_get(hyp_environment_t* env, const char* name) {
 hyp_error_t hyp_environment_assign(hyp_environment_t* env, const char* name, hyp_value_t value) {
     if (!env || !name) return HYP_ERROR_INVALID_ARG;
     
-    /* Check if variable exists in current environment */
-    for (size_t i = 0; i < env->variables.count; i++) {
-        if (strcmp(env->variables.names[i], name) == 0) {
-            env->variables.values[i] = value;
+    /* Check the current environment, then its parents */
+    for (hyp_environment_t* scope = env; scope; scope = scope->parent) {
+        hyp_binding_t* binding = environment_find(scope, name);
+        if (binding) {
+            binding->value = value;
             return HYP_OK;
         }
     }
     
-    /* Check parent environments */
-    if (env->parent) {
-        return hyp_environment_assign(env->parent, name, value);
-    }
-    
     /* Variable not found, define it in current environment */
     hyp_environment_define(env, name, value);
     return HYP_OK;
@@ -359,6 +444,7 @@ hyp_error_t hyp_environment_assign(hyp_environment_t* env, const char* name, hyp
 hyp_runtime_t* hyp_runtime_create(void) {
     hyp_runtime_t* runtime = HYP_MALLOC(sizeof(hyp_runtime_t));
     if (!runtime) return NULL;
+    memset(runtime, 0, sizeof(hyp_runtime_t));
     
     runtime->global_env = hyp_environment_create(NULL);
     if (!runtime->global_env) {
@@ -381,16 +467,13 @@ hyp_runtime_t* hyp_runtime_create(void) {
     runtime->error_message[0] = '\0';
     runtime->error_location = NULL;
     
-    /* Initialize modules */
-    runtime->modules.names = NULL;
-    runtime->modules.exports = NULL;
-    runtime->modules.count = 0;
-    runtime->modules.capacity = 0;
+    /* Initialize modules, built-ins and events */
+    HYP_MAP_INIT(&runtime->modules);
+    HYP_MAP_INIT(&runtime->builtins);
+    HYP_MAP_INIT(&runtime->events);
     
     /* Define built-in functions */
-    hyp_environment_define(runtime->global_env, "print", hyp_value_native_function("print", builtin_print));
-    hyp_environment_define(runtime->global_env, "typeof", hyp_value_native_function("typeof", builtin_typeof));
-    hyp_environment_define(runtime->global_env, "len", hyp_value_native_function("len", builtin_len));
+    hyp_runtime_register_builtins(runtime);
     
     return runtime;
 }
@@ -399,6 +482,10 @@ void hyp_runtime_destroy(hyp_runtime_t* runtime) {
     if (!runtime) return;
     
     hyp_environment_destroy(runtime->global_env);
+    for (size_t i = 0; i < runtime->captured.count; i++) {
+        hyp_environment_destroy(runtime->captured.data[i]);
+    }
+    HYP_ARRAY_FREE(&runtime->captured);
     
     /* Free stack and call stack */
     if (runtime->stack.data) {
@@ -408,20 +495,38 @@ void hyp_runtime_destroy(hyp_runtime_t* runtime) {
         HYP_FREE(runtime->call_stack.data);
     }
     
-    /* Free modules */
-    if (runtime->modules.names) {
-        for (size_t i = 0; i < runtime->modules.count; i++) {
-            HYP_FREE(runtime->modules.names[i]);
-        }
-        HYP_FREE(runtime->modules.names);
+    /* Free modules and event handlers, with the names they own */
+    for (size_t i = 0; i < HYP_MAP_CAPACITY(&runtime->modules); i++) {
+        if (HYP_MAP_KEY(&runtime->modules, i)) hyp_mem_free((char*)HYP_MAP_KEY(&runtime->modules, i));
     }
-    if (runtime->modules.exports) {
-        HYP_FREE(runtime->modules.exports);
+    HYP_MAP_FREE(&runtime->modules);
+    for (size_t i = 0; i < HYP_MAP_CAPACITY(&runtime->events); i++) {
+        if (!HYP_MAP_KEY(&runtime->events, i)) continue;
+        hyp_mem_free((char*)HYP_MAP_KEY(&runtime->events, i));
+        HYP_ARRAY_FREE(&HYP_MAP_VALUE(&runtime->events, i));
     }
+    HYP_MAP_FREE(&runtime->events);
+    HYP_MAP_FREE(&runtime->builtins);
     
     HYP_FREE(runtime);
 }
 
+/* Built-in registration: the table keeps the caller's name, and the
+ * global environment gets a binding of its own */
+void hyp_runtime_register_builtin(hyp_runtime_t* runtime, const char* name, hyp_native_fn_t fn) {
+    if (!runtime || !name || !fn) return;
+    
+    HYP_MAP_PUT(&runtime->builtins, name, fn);
+    hyp_environment_define(runtime->global_env, name, hyp_value_native_function(name, fn));
+}
+
+void hyp_runtime_register_builtins(hyp_runtime_t* runtime) {
+    hyp_runtime_register_builtin(runtime, "print", builtin_print);
+    hyp_runtime_register_builtin(runtime, "typeof", builtin_typeof);
+    hyp_runtime_register_builtin(runtime, "len", builtin_len);
+    hyp_runtime_register_builtin(runtime, "parseNumber", hyp_builtin_parse_number);
+}
+
 /* Value comparison */
 bool hyp_value_equals(hyp_value_t a, hyp_value_t b) {
     if (a.type != b.type) return false;
@@ -458,52 +563,84 @@ bool hyp_value_is_truthy(hyp_value_t value) {
     }
 }
 
-/* AST evaluation */
-static hyp_value_t evaluate_literal(hyp_runtime_t* runtime, hyp_ast_node_t* node) {
-    switch (node->type) {
-        case AST_NULL:
-            return hyp_value_null();
-        case AST_BOOLEAN:
-            return hyp_value_boolean(node->boolean.value);
-        case AST_NUMBER:
-            return hyp_value_number(node->number.value);
-        case AST_STRING:
-            return hyp_value_string(node->string.value);
+/* Value conversion */
+char* hyp_value_to_string(hyp_value_t value) {
+    char buffer[64];
+    
+    switch (value.type) {
+        case HYP_VAL_NULL:
+            return hyp_strdup("null");
+        case HYP_VAL_BOOLEAN:
+            return hyp_strdup(value.boolean ? "true" : "false");
+        case HYP_VAL_NUMBER:
+            hyp_number_format(value.number, buffer);
+            return hyp_strdup(buffer);
+        case HYP_VAL_STRING:
+            return hyp_strdup(value.string ? value.string : "");
+        case HYP_VAL_ARRAY:
+            return hyp_strdup("[Array]");
+        case HYP_VAL_OBJECT:
+            return hyp_strdup("[Object]");
+        case HYP_VAL_FUNCTION:
+            return hyp_strdup("[Function]");
+        case HYP_VAL_NATIVE_FUNCTION:
+            return hyp_strdup("[Native Function]");
         default:
-            runtime->has_error = true;
-            snprintf(runtime->error_message, sizeof(runtime->error_message), "Unknown literal type");
-            return hyp_value_null();
+            return hyp_strdup("[Unknown]");
     }
 }
 
-static hyp_value_t evaluate_identifier(hyp_runtime_t* runtime, hyp_ast_node_t* node) {
-    return hyp_environment_get(runtime->current_env, node->identifier.name);
+static hyp_value_t concat_values(hyp_value_t left, hyp_value_t right) {
+    char* left_str = hyp_value_to_string(left);
+    char* right_str = hyp_value_to_string(right);
+    hyp_value_t result = hyp_value_null();
+    
+    if (left_str && right_str) {
+        size_t left_len = strlen(left_str);
+        size_t right_len = strlen(right_str);
+        
+        result.type = HYP_VAL_STRING;
+        result.string = HYP_MALLOC(left_len + right_len + 1);
+        if (result.string) {
+            memcpy(result.string, left_str, left_len);
+            memcpy(result.string + left_len, right_str, right_len + 1);
+        }
+    }
+    
+    HYP_FREE(left_str);
+    HYP_FREE(right_str);
+    return result;
 }
 
-static hyp_value_t evaluate_binary(hyp_runtime_t* runtime, hyp_ast_node_t* node) {
-    hyp_value_t left = hyp_runtime_eval_expression(runtime, node->binary_op.left);
-    if (runtime->has_error) return hyp_value_null();
-    hyp_value_t right = hyp_runtime_eval_expression(runtime, node->binary_op.right);
-    if (runtime->has_error) return hyp_value_null();
+/* Bitwise operators work on 32-bit integers, wrapping as JavaScript does */
+static int32_t number_to_int32(double number) {
+    if (!isfinite(number)) return 0;
+    double wrapped = fmod(trunc(number), 4294967296.0);
+    if (wrapped < 0) wrapped += 4294967296.0;
+    return (int32_t)(uint32_t)wrapped;
+}
+
+/* Binary and unary operators */
+hyp_value_t hyp_value_binary_op(hyp_runtime_t* runtime, hyp_binary_op_t op, hyp_value_t left, hyp_value_t right) {
+    bool numeric = left.type == HYP_VAL_NUMBER && right.type == HYP_VAL_NUMBER;
     
-    switch (node->binary_op.op) {
+    switch (op) {
         case BINOP_ADD:
-            if (left.type == HYP_VAL_NUMBER && right.type == HYP_VAL_NUMBER) {
+            if (numeric) {
                 return hyp_value_number(left.number + right.number);
             }
+            if (left.type == HYP_VAL_STRING || right.type == HYP_VAL_STRING) {
+                return concat_values(left, right);
+            }
             break;
         case BINOP_SUB:
-            if (left.type == HYP_VAL_NUMBER && right.type == HYP_VAL_NUMBER) {
-                return hyp_value_number(left.number - right.number);
-            }
+            if (numeric) return hyp_value_number(left.number - right.number);
             break;
         case BINOP_MUL:
-            if (left.type == HYP_VAL_NUMBER && right.type == HYP_VAL_NUMBER) {
-                return hyp_value_number(left.number * right.number);
-            }
+            if (numeric) return hyp_value_number(left.number * right.number);
             break;
         case BINOP_DIV:
-            if (left.type == HYP_VAL_NUMBER && right.type == HYP_VAL_NUMBER) {
+            if (numeric) {
                 if (right.number == 0.0) {
                     runtime->has_error = true;
                     snprintf(runtime->error_message, sizeof(runtime->error_message), "Division by zero");
@@ -512,55 +649,255 @@ static hyp_value_t evaluate_binary(hyp_runtime_t* runtime, hyp_ast_node_t* node)
                 return hyp_value_number(left.number / right.number);
             }
             break;
+        case BINOP_MOD:
+            if (numeric) {
+                if (right.number == 0.0) {
+                    runtime->has_error = true;
+                    snprintf(runtime->error_message, sizeof(runtime->error_message), "Division by zero");
+                    return hyp_value_null();
+                }
+                return hyp_value_number(fmod(left.number, right.number));
+            }
+            break;
         case BINOP_EQ:
             return hyp_value_boolean(hyp_value_equals(left, right));
         case BINOP_NE:
             return hyp_value_boolean(!hyp_value_equals(left, right));
         case BINOP_LT:
-            if (left.type == HYP_VAL_NUMBER && right.type == HYP_VAL_NUMBER) {
-                return hyp_value_boolean(left.number < right.number);
-            }
+            if (numeric) return hyp_value_boolean(left.number < right.number);
             break;
         case BINOP_LE:
-            if (left.type == HYP_VAL_NUMBER && right.type == HYP_VAL_NUMBER) {
-                return hyp_value_boolean(left.number <= right.number);
-            }
+            if (numeric) return hyp_value_boolean(left.number <= right.number);
             break;
         case BINOP_GT:
-            if (left.type == HYP_VAL_NUMBER && right.type == HYP_VAL_NUMBER) {
-                return hyp_value_boolean(left.number > right.number);
-            }
+            if (numeric) return hyp_value_boolean(left.number > right.number);
             break;
         case BINOP_GE:
-            if (left.type == HYP_VAL_NUMBER && right.type == HYP_VAL_NUMBER) {
-                return hyp_value_boolean(left.number >= right.number);
-            }
+            if (numeric) return hyp_value_boolean(left.number >= right.number);
             break;
-            
         case BINOP_AND:
-            if (!hyp_value_is_truthy(left)) {
-                return left;
-            }
-            return right;
-            
+            return hyp_value_is_truthy(left) ? right : left;
         case BINOP_OR:
-            if (hyp_value_is_truthy(left)) {
-                return left;
+            return hyp_value_is_truthy(left) ? left : right;
+        case BINOP_POW:
+            if (numeric) return hyp_value_number(pow(left.number, right.number));
+            break;
+        case BINOP_BITWISE_AND:
+            if (numeric) return hyp_value_number(number_to_int32(left.number) & number_to_int32(right.number));
+            break;
+        case BINOP_BITWISE_OR:
+            if (numeric) return hyp_value_number(number_to_int32(left.number) | number_to_int32(right.number));
+            break;
+        case BINOP_BITWISE_XOR:
+            if (numeric) return hyp_value_number(number_to_int32(left.number) ^ number_to_int32(right.number));
+            break;
+        case BINOP_LEFT_SHIFT:
+            if (numeric) {
+                uint32_t shifted = (uint32_t)number_to_int32(left.number) << (number_to_int32(right.number) & 31);
+                return hyp_value_number((int32_t)shifted);
             }
-            return right;
-            
+            break;
+        case BINOP_RIGHT_SHIFT:
+            if (numeric) {
+                /* Arithmetic shift, without relying on >> of a negative int */
+                int32_t value = number_to_int32(left.number);
+                int shift = number_to_int32(right.number) & 31;
+                int32_t shifted = value >= 0 ? value >> shift : ~(~value >> shift);
+                return hyp_value_number(shifted);
+            }
+            break;
         default:
             runtime->has_error = true;
-            snprintf(runtime->error_message, sizeof(runtime->error_message), "Unknown binary operator: %d", node->binary_op.op);
+            snprintf(runtime->error_message, sizeof(runtime->error_message), "Unknown binary operator: %d", op);
             return hyp_value_null();
     }
     
-    // Fallback for unsupported operand types
+    /* Fallback for unsupported operand types */
     runtime->has_error = true;
     snprintf(runtime->error_message, sizeof(runtime->error_message), "Invalid operands for binary operator");
     return hyp_value_null();
 }
 
+hyp_value_t hyp_value_unary_op(hyp_runtime_t* runtime, hyp_unary_op_t op, hyp_value_t operand) {
+    switch (op) {
+        case UNOP_NOT:
+            return hyp_value_boolean(!hyp_value_is_truthy(operand));
+        case UNOP_MINUS:
+            if (operand.type == HYP_VAL_NUMBER) return hyp_value_number(-operand.number);
+            break;
+        case UNOP_PLUS:
+            if (operand.type == HYP_VAL_NUMBER) return operand;
+            break;
+        case UNOP_BITWISE_NOT:
+            if (operand.type == HYP_VAL_NUMBER) return hyp_value_number(~number_to_int32(operand.number));
+            break;
+        case UNOP_INCREMENT:
+            if (operand.type == HYP_VAL_NUMBER) return hyp_value_number(operand.number + 1);
+            break;
+        case UNOP_DECREMENT:
+            if (operand.type == HYP_VAL_NUMBER) return hyp_value_number(operand.number - 1);
+            break;
+        default:
+            break;
+    }
+    
+    runtime->has_error = true;
+    snprintf(runtime->error_message, sizeof(runtime->error_message), "Invalid operand for unary operator");
+    return hyp_value_null();
+}
+
+/* AST evaluation */
+static hyp_value_t evaluate_literal(hyp_runtime_t* runtime, hyp_ast_node_t* node) {
+    switch (node->type) {
+        case AST_NULL:
+            return hyp_value_null();
+        case AST_BOOLEAN:
+            return hyp_value_boolean(node->boolean.value);
+        case AST_NUMBER:
+            return hyp_value_number(node->number.value);
+        case AST_STRING:
+            return hyp_value_string(HYP_AST_TEXT(node, string.value));
+        default:
+            runtime->has_error = true;
+            snprintf(runtime->error_message, sizeof(runtime->error_message), "Unknown literal type");
+            return hyp_value_null();
+    }
+}
+
+static hyp_value_t evaluate_identifier(hyp_runtime_t* runtime, hyp_ast_node_t* node) {
+    return hyp_environment_get(runtime->current_env, HYP_AST_TEXT(node, identifier.name));
+}
+
+/* Operand type bit for profiling */
+static uint32_t profile_type(hyp_value_t value) {
+    switch (value.type) {
+        case HYP_VAL_NUMBER: return HYP_PROFILE_TYPE_NUMBER;
+        case HYP_VAL_STRING: return HYP_PROFILE_TYPE_STRING;
+        case HYP_VAL_BOOLEAN: return HYP_PROFILE_TYPE_BOOLEAN;
+        default: return HYP_PROFILE_TYPE_OTHER;
+    }
+}
+
+/* value |> function calls the function with the value as its only argument */
+static hyp_value_t evaluate_pipe(hyp_runtime_t* runtime, hyp_value_t value, hyp_value_t callee) {
+    if (callee.type == HYP_VAL_NATIVE_FUNCTION) {
+        return callee.native_function.native_fn(runtime, &value, 1);
+    }
+    if (callee.type == HYP_VAL_FUNCTION) {
+        return hyp_runtime_call_function(runtime, callee.function, &value, 1);
+    }
+    
+    runtime->has_error = true;
+    snprintf(runtime->error_message, sizeof(runtime->error_message), "Right side of '|>' is not a function");
+    return hyp_value_null();
+}
+
+static hyp_value_t evaluate_binary(hyp_runtime_t* runtime, hyp_ast_node_t* node) {
+    hyp_value_t left = hyp_runtime_eval_expression(runtime, HYP_AST_CHILD(node, binary_op.left));
+    if (runtime->has_error) return hyp_value_null();
+    
+    /* Logical operators short-circuit */
+    if (node->binary_op.op == BINOP_AND && !hyp_value_is_truthy(left)) {
+        return left;
+    }
+    if (node->binary_op.op == BINOP_OR && hyp_value_is_truthy(left)) {
+        return left;
+    }
+    
+    hyp_value_t right = hyp_runtime_eval_expression(runtime, HYP_AST_CHILD(node, binary_op.right));
+    if (runtime->has_error) return hyp_value_null();
+    
+    if (runtime->profile && node->binary_op.op != BINOP_AND && node->binary_op.op != BINOP_OR) {
+        hyp_profile_record_operands(runtime->profile, node, profile_type(left) | profile_type(right));
+    }
+    if (node->binary_op.op == BINOP_PIPE) {
+        return evaluate_pipe(runtime, left, right);
+    }
+    
+    return hyp_value_binary_op(runtime, node->binary_op.op, left, right);
+}
+
+/* ++x and --x store and return the new value, x++ and x-- return the old one */
+static hyp_value_t evaluate_increment(hyp_runtime_t* runtime, hyp_ast_node_t* node) {
+    hyp_ast_node_t* target = HYP_AST_CHILD(node, unary_op.operand);
+    if (target->type != AST_IDENTIFIER) {
+        runtime->has_error = true;
+        snprintf(runtime->error_message, sizeof(runtime->error_message), "Invalid %s target",
+                 node->unary_op.op == UNOP_INCREMENT ? "increment" : "decrement");
+        return hyp_value_null();
+    }
+    
+    hyp_value_t old_value = evaluate_identifier(runtime, target);
+    if (runtime->has_error) return hyp_value_null();
+    hyp_value_t new_value = hyp_value_unary_op(runtime, node->unary_op.op, old_value);
+    if (runtime->has_error) return hyp_value_null();
+    
+    const char* name = HYP_AST_TEXT(target, identifier.name);
+    if (hyp_environment_assign(runtime->current_env, name, new_value) != HYP_OK) {
+        runtime->has_error = true;
+        snprintf(runtime->error_message, sizeof(runtime->error_message), "Undefined variable '%s'", name);
+        return hyp_value_null();
+    }
+    return node->unary_op.is_postfix ? old_value : new_value;
+}
+
+static hyp_value_t evaluate_unary(hyp_runtime_t* runtime, hyp_ast_node_t* node) {
+    if (node->unary_op.op == UNOP_INCREMENT || node->unary_op.op == UNOP_DECREMENT) {
+        return evaluate_increment(runtime, node);
+    }
+    
+    hyp_value_t operand = hyp_runtime_eval_expression(runtime, HYP_AST_CHILD(node, unary_op.operand));
+    if (runtime->has_error) return hyp_value_null();
+    
+    return hyp_value_unary_op(runtime, node->unary_op.op, operand);
+}
+
+static hyp_value_t evaluate_call(hyp_runtime_t* runtime, hyp_ast_node_t* node) {
+    if (HYP_AST_CHILD(node, call.callee)->type != AST_IDENTIFIER) {
+        runtime->has_error = true;
+        snprintf(runtime->error_message, sizeof(runtime->error_message), "Only simple function calls supported");
+        return hyp_value_null();
+    }
+    
+    const char* name = HYP_AST_TEXT(HYP_AST_CHILD(node, call.callee), identifier.name);
+    hyp_value_t callee = hyp_environment_get(runtime->current_env, name);
+    if (callee.type != HYP_VAL_FUNCTION && callee.type != HYP_VAL_NATIVE_FUNCTION) {
+        runtime->has_error = true;
+        snprintf(runtime->error_message, sizeof(runtime->error_message), "Function '%s' not found", name);
+        return hyp_value_null();
+    }
+    
+    size_t arg_count = node->call.arguments.count;
+    hyp_value_t* args = NULL;
+    if (arg_count > 0) {
+        args = HYP_MALLOC(sizeof(hyp_value_t) * arg_count);
+        if (!args) {
+            runtime->has_error = true;
+            snprintf(runtime->error_message, sizeof(runtime->error_message), "Memory allocation failed");
+            return hyp_value_null();
+        }
+    }
+    
+    for (size_t i = 0; i < arg_count; i++) {
+        args[i] = hyp_runtime_eval_expression(runtime, HYP_AST_AT(node, call.arguments, i));
+        if (runtime->has_error) {
+            HYP_FREE(args);
+            return hyp_value_null();
+        }
+    }
+    
+    if (runtime->profile) {
+        hyp_profile_record_call_site(runtime->profile, node,
+                                     callee.type == HYP_VAL_FUNCTION ? callee.function->name : name);
+    }
+    
+    hyp_value_t result = callee.type == HYP_VAL_NATIVE_FUNCTION ?
+        callee.native_function.native_fn(runtime, args, arg_count) :
+        hyp_runtime_call_function(runtime, callee.function, args, arg_count);
+    HYP_FREE(args);
+    return result;
+}
+
 hyp_value_t hyp_runtime_eval_expression(hyp_runtime_t* runtime, hyp_ast_node_t* node) {
     if (!runtime || !node) {
         if (runtime) {
@@ -580,15 +917,43 @@ hyp_value_t hyp_runtime_eval_expression(hyp_runtime_t* runtime, hyp_ast_node_t*
             return evaluate_identifier(runtime, node);
         case AST_BINARY_OP:
             return evaluate_binary(runtime, node);
+        case AST_UNARY_OP:
+            return evaluate_unary(runtime, node);
+        case AST_CALL:
+            return evaluate_call(runtime, node);
+        case AST_CONDITIONAL: {
+            hyp_value_t condition = hyp_runtime_eval_expression(runtime, HYP_AST_CHILD(node, conditional.condition));
+            if (runtime->has_error) return hyp_value_null();
+            return hyp_runtime_eval_expression(runtime, hyp_value_is_truthy(condition) ?
+                                               HYP_AST_CHILD(node, conditional.then_expr) : HYP_AST_CHILD(node, conditional.else_expr));
+        }
         case AST_ASSIGNMENT: {
             // Handle assignments
-            if (node->assignment.target->type != AST_IDENTIFIER) {
+            if (HYP_AST_CHILD(node, assignment.target)->type != AST_IDENTIFIER) {
                 runtime->has_error = true;
                 snprintf(runtime->error_message, sizeof(runtime->error_message), "Invalid assignment target");
                 return hyp_value_null();
             }
-            hyp_value_t value = hyp_runtime_eval_expression(runtime, node->assignment.value);
-            hyp_environment_assign(runtime->global_env, node->assignment.target->identifier.name, value);
+            hyp_value_t value = hyp_runtime_eval_expression(runtime, HYP_AST_CHILD(node, assignment.value));
+            if (runtime->has_error) return hyp_value_null();
+            const char* name = HYP_AST_TEXT(HYP_AST_CHILD(node, assignment.target), identifier.name);
+            if (node->assignment.op != ASSIGN_SIMPLE) {
+                /* x op= y is x = x op y */
+                static const hyp_binary_op_t combine[] = {
+                    [ASSIGN_ADD] = BINOP_ADD, [ASSIGN_SUB] = BINOP_SUB,
+                    [ASSIGN_MUL] = BINOP_MUL, [ASSIGN_DIV] = BINOP_DIV,
+                    [ASSIGN_MOD] = BINOP_MOD, [ASSIGN_POW] = BINOP_POW
+                };
+                hyp_value_t old_value = evaluate_identifier(runtime, HYP_AST_CHILD(node, assignment.target));
+                if (runtime->has_error) return hyp_value_null();
+                value = hyp_value_binary_op(runtime, combine[node->assignment.op], old_value, value);
+                if (runtime->has_error) return hyp_value_null();
+            }
+            if (hyp_environment_assign(runtime->current_env, name, value) != HYP_OK) {
+                runtime->has_error = true;
+                snprintf(runtime->error_message, sizeof(runtime->error_message), "Undefined variable '%s'", name);
+                return hyp_value_null();
+            }
             return value;
         }
         default:
@@ -598,6 +963,16 @@ hyp_value_t hyp_runtime_eval_expression(hyp_runtime_t* runtime, hyp_ast_node_t*
     }
 }
 
+/* Blocks only need their own scope when they declare something */
+static bool block_declares(hyp_ast_node_t* node) {
+    for (size_t i = 0; i < node->block_stmt.statements.count; i++) {
+        if (HYP_AST_AT(node, block_stmt.statements, i)->type == AST_VARIABLE_DECL) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static hyp_value_t execute_statement(hyp_runtime_t* runtime, hyp_ast_node_t* node) {
     if (!runtime || !node) {
         if (runtime) {
@@ -609,117 +984,121 @@ static hyp_value_t execute_statement(hyp_runtime_t* runtime, hyp_ast_node_t* nod
     
     switch (node->type) {
         case AST_PROGRAM: {
+            if (runtime->profile) {
+                hyp_profile_record_call(runtime->profile, node);
+            }
             hyp_value_t result = hyp_value_null();
             for (size_t i = 0; i < node->program.statements.count; i++) {
-                result = execute_statement(runtime, node->program.statements.data[i]);
+                result = execute_statement(runtime, HYP_AST_AT(node, program.statements, i));
                 if (runtime->has_error) break;
             }
             return result;
         }
         case AST_FUNCTION_DECL: {
             // Register function in global environment
-            hyp_function_t* func = malloc(sizeof(hyp_function_t));
+            hyp_function_t* func = FUNCTION_ALLOC();
             if (!func) {
                 runtime->has_error = true;
                 snprintf(runtime->error_message, sizeof(runtime->error_message), "Memory allocation failed");
                 return hyp_value_null();
             }
-            func->name = _strdup(node->function_decl.name);
-            func->parameters = node->function_decl.parameters;
-            func->body = node->function_decl.body;
+            func->name = hyp_strdup(HYP_AST_TEXT(node, function_decl.name));
+            func->parameters = &node->function_decl.parameters;
+            func->body = HYP_AST_CHILD(node, function_decl.body);
             func->closure = runtime->current_env;
+            environment_capture(func->closure);
             
             hyp_value_t func_value = hyp_value_function(func);
-            hyp_environment_define(runtime->global_env, node->function_decl.name, func_value);
+            hyp_environment_define(runtime->global_env, HYP_AST_TEXT(node, function_decl.name), func_value);
             return func_value;
         }
-        case AST_CALL: {
-            // Look up function and call it
-            if (node->call.callee->type != AST_IDENTIFIER) {
-                runtime->has_error = true;
-                snprintf(runtime->error_message, sizeof(runtime->error_message), "Only simple function calls supported");
-                return hyp_value_null();
-            }
-            
-            hyp_value_t func_value = hyp_environment_get(runtime->global_env, node->call.callee->identifier.name);
-            if (func_value.type == HYP_VAL_NATIVE_FUNCTION) {
-                // Handle built-in functions
-                hyp_value_t* args = malloc(sizeof(hyp_value_t) * node->call.arguments.count);
-                for (size_t i = 0; i < node->call.arguments.count; i++) {
-                    args[i] = hyp_runtime_eval_expression(runtime, node->call.arguments.data[i]);
-                }
-                hyp_value_t result = func_value.native_function.native_fn(runtime, args, node->call.arguments.count);
-                free(args);
-                return result;
-            } else if (func_value.type == HYP_VAL_FUNCTION) {
-                // Handle user-defined functions
-                hyp_value_t* args = malloc(sizeof(hyp_value_t) * node->call.arguments.count);
-                for (size_t i = 0; i < node->call.arguments.count; i++) {
-                    args[i] = hyp_runtime_eval_expression(runtime, node->call.arguments.data[i]);
-                }
-                hyp_value_t result = hyp_runtime_call_function(runtime, func_value.function, args, node->call.arguments.count);
-                free(args);
-                return result;
-            }
-            runtime->has_error = true;
-            snprintf(runtime->error_message, sizeof(runtime->error_message), "Function '%s' not found", node->call.callee->identifier.name);
-            return hyp_value_null();
-        }
         case AST_VARIABLE_DECL: {
             // Handle variable declarations (let/const)
             hyp_value_t value = hyp_value_null();
-            if (node->variable_decl.initializer) {
-                value = hyp_runtime_eval_expression(runtime, node->variable_decl.initializer);
+            if (HYP_AST_CHILD(node, variable_decl.initializer)) {
+                value = hyp_runtime_eval_expression(runtime, HYP_AST_CHILD(node, variable_decl.initializer));
+                if (runtime->has_error) return hyp_value_null();
             }
-            hyp_environment_define(runtime->global_env, node->variable_decl.name, value);
+            hyp_environment_define(runtime->current_env, HYP_AST_TEXT(node, variable_decl.name), value);
             return value;
         }
         case AST_IF_STMT: {
             // Handle if statements
-            hyp_value_t condition = hyp_runtime_eval_expression(runtime, node->if_stmt.condition);
-            if (hyp_value_is_truthy(condition)) {
-                return execute_statement(runtime, node->if_stmt.then_stmt);
-            } else if (node->if_stmt.else_stmt) {
-                return execute_statement(runtime, node->if_stmt.else_stmt);
+            hyp_value_t condition = hyp_runtime_eval_expression(runtime, HYP_AST_CHILD(node, if_stmt.condition));
+            if (runtime->has_error) return hyp_value_null();
+            bool taken = hyp_value_is_truthy(condition);
+            if (runtime->profile) {
+                hyp_profile_record_branch(runtime->profile, node, taken);
+            }
+            if (taken) {
+                return execute_statement(runtime, HYP_AST_CHILD(node, if_stmt.then_stmt));
+            } else if (HYP_AST_CHILD(node, if_stmt.else_stmt)) {
+                return execute_statement(runtime, HYP_AST_CHILD(node, if_stmt.else_stmt));
             }
             return hyp_value_null();
         }
         case AST_WHILE_STMT: {
             // Handle while loops
             hyp_value_t result = hyp_value_null();
+            uint64_t iterations = 0;
             while (true) {
-                hyp_value_t condition = hyp_runtime_eval_expression(runtime, node->while_stmt.condition);
-                if (!hyp_value_is_truthy(condition)) {
+                hyp_value_t condition = hyp_runtime_eval_expression(runtime, HYP_AST_CHILD(node, while_stmt.condition));
+                if (runtime->has_error || !hyp_value_is_truthy(condition)) {
                     break;
                 }
-                result = execute_statement(runtime, node->while_stmt.body);
-                if (runtime->has_error) {
+                iterations++;
+                result = execute_statement(runtime, HYP_AST_CHILD(node, while_stmt.body));
+                if (runtime->has_error || runtime->returning) {
                     break;
                 }
             }
+            if (runtime->profile) {
+                hyp_profile_record_loop(runtime->profile, node, iterations);
+            }
             return result;
         }
         case AST_RETURN_STMT: {
             // Handle return statements
-            if (node->return_stmt.value) {
-                return hyp_runtime_eval_expression(runtime, node->return_stmt.value);
+            hyp_value_t value = hyp_value_null();
+            if (HYP_AST_CHILD(node, return_stmt.value)) {
+                value = hyp_runtime_eval_expression(runtime, HYP_AST_CHILD(node, return_stmt.value));
+                if (runtime->has_error) return hyp_value_null();
             }
-            return hyp_value_null();
+            runtime->returning = true;
+            runtime->return_value = value;
+            return value;
         }
         case AST_BLOCK_STMT: {
             // Handle block statements
+            hyp_environment_t* outer = runtime->current_env;
+            hyp_environment_t* scope = NULL;
+            if (block_declares(node)) {
+                scope = hyp_environment_create(outer);
+                if (!scope) {
+                    runtime->has_error = true;
+                    snprintf(runtime->error_message, sizeof(runtime->error_message), "Memory allocation failed");
+                    return hyp_value_null();
+                }
+                runtime->current_env = scope;
+            }
+            
             hyp_value_t result = hyp_value_null();
             for (size_t i = 0; i < node->block_stmt.statements.count; i++) {
-                result = execute_statement(runtime, node->block_stmt.statements.data[i]);
-                if (runtime->has_error) {
+                result = execute_statement(runtime, HYP_AST_AT(node, block_stmt.statements, i));
+                if (runtime->has_error || runtime->returning) {
                     break;
                 }
             }
+            
+            if (scope) {
+                runtime->current_env = outer;
+                environment_leave(runtime, scope);
+            }
             return result;
         }
         case AST_EXPRESSION_STMT: {
             // Handle expression statements
-            return hyp_runtime_eval_expression(runtime, node->expression_stmt.expression);
+            return hyp_runtime_eval_expression(runtime, HYP_AST_CHILD(node, expression_stmt.expression));
         }
         default:
             // Try to evaluate as expression
@@ -727,28 +1106,54 @@ static hyp_value_t execute_statement(hyp_runtime_t* runtime, hyp_ast_node_t* nod
     }
 }
 
+/* Allocations are read off the header pools around a run rather than
+ * counted as they happen, which would put an atomic add on every call */
+static hyp_metric_t metric_execute = HYP_HISTOGRAM("runtime.execute", "Time to run a program");
+static hyp_metric_t metric_objects = HYP_COUNTER("runtime.objects", "Objects created");
+static hyp_metric_t metric_environments = HYP_COUNTER("runtime.environments", "Environments (scopes and calls) created");
+static hyp_metric_t metric_functions = HYP_COUNTER("runtime.functions", "Function values created");
+static hyp_metric_t metric_pool_bytes = HYP_GAUGE("runtime.pool_bytes", "Bytes reserved by the running thread's header pools");
+static hyp_metric_t metric_failures = HYP_COUNTER("runtime.failures", "Programs stopped by a runtime error");
+
+static void record_execution(const hyp_runtime_pool_stats_t* before, double started, bool failed) {
+    hyp_runtime_pool_stats_t after;
+    hyp_runtime_pool_stats(&after);
+    
+    hyp_metric_observe(&metric_execute, hyp_wall_time() - started);
+    hyp_metric_add(&metric_objects, after.objects.allocations - before->objects.allocations);
+    hyp_metric_add(&metric_environments, after.environments.allocations - before->environments.allocations);
+    hyp_metric_add(&metric_functions, after.functions.allocations - before->functions.allocations);
+    hyp_metric_set(&metric_pool_bytes, (int64_t)(after.objects.reserved + after.environments.reserved +
+                                                 after.functions.reserved));
+    if (failed) hyp_metric_add(&metric_failures, 1);
+}
+
 hyp_error_t hyp_runtime_execute_ast(hyp_runtime_t* runtime, hyp_ast_node_t* ast) {
     if (!runtime || !ast) return HYP_ERROR_INVALID_ARG;
     
-    runtime->has_error = false;
+    hyp_runtime_pool_stats_t before;
+    hyp_runtime_pool_stats(&before);
+    double started = hyp_wall_time();
     
-    // Register built-in functions
-    hyp_value_t print_func = hyp_value_native_function("print", builtin_print);
-    hyp_environment_define(runtime->global_env, "print", print_func);
+    runtime->has_error = false;
+    runtime->returning = false;
+    runtime->exit_status = 0;
     
     // Execute the AST
-    hyp_value_t result = execute_statement(runtime, ast);
+    execute_statement(runtime, ast);
+    runtime->returning = false;
     
     // Look for and call main function if it exists
     hyp_value_t main_func = hyp_environment_get(runtime->global_env, "main");
-    if (main_func.type == HYP_VAL_FUNCTION) {
+    if (!runtime->has_error && main_func.type == HYP_VAL_FUNCTION) {
         // Call main function with no arguments
-        hyp_value_t main_result = hyp_runtime_call_function(runtime, main_func.function, NULL, 0);
-        if (runtime->has_error) {
-            return HYP_ERROR_RUNTIME;
-        }
+        hyp_value_t status = hyp_runtime_call_function(runtime, main_func.function, NULL, 0);
+        
+        /* The same status a native build of the program exits with (hyprt_shutdown) */
+        if (status.type == HYP_VAL_NUMBER) runtime->exit_status = (int)status.number;
     }
     
+    record_execution(&before, started, runtime->has_error);
     if (runtime->has_error) {
         return HYP_ERROR_RUNTIME;
     }
@@ -764,9 +1169,11 @@ hyp_value_t hyp_runtime_execute_bytecode(hyp_runtime_t* runtime, hyp_bytecode_t*
 }
 
 hyp_value_t hyp_runtime_load_module(hyp_runtime_t* runtime, const char* module_name) {
-    (void)runtime;
-    (void)module_name;
-    return hyp_value_null();
+    if (!runtime || !module_name) return hyp_value_null();
+    
+    /* Modules are loaded once; loading from module_paths is not implemented yet */
+    size_t slot = HYP_MAP_FIND(&runtime->modules, module_name);
+    return slot == HYP_MAP_NONE ? hyp_value_null() : HYP_MAP_VALUE(&runtime->modules, slot);
 }
 
 hyp_value_t hyp_runtime_call_function(hyp_runtime_t* runtime, hyp_function_t* function, hyp_value_t* args, size_t arg_count) {
@@ -774,28 +1181,67 @@ hyp_value_t hyp_runtime_call_function(hyp_runtime_t* runtime, hyp_function_t* fu
         return hyp_value_null();
     }
     
+    if (runtime->profile) {
+        hyp_profile_record_call(runtime->profile, function->body);
+    }
+    
     // Create new environment for function scope
     hyp_environment_t* prev_env = runtime->current_env;
     runtime->current_env = hyp_environment_create(function->closure);
     
-    // Bind parameters to arguments
-    size_t param_count = function->parameters.count;
-    for (size_t i = 0; i < param_count && i < arg_count; i++) {
+    // Bind parameters to arguments; missing arguments are null
+    size_t param_count = function->parameters->count;
+    const hyp_parameter_t* params = HYP_AST_PARAMETERS(function->parameters);
+    for (size_t i = 0; i < param_count; i++) {
         hyp_environment_define(runtime->current_env, 
-                             function->parameters.data[i].name, 
-                             args[i]);
+                             hyp_ast_text(&params[i].name), 
+                             i < arg_count ? args[i] : hyp_value_null());
     }
     
-    // Execute function body
-    hyp_value_t result = execute_statement(runtime, function->body);
+    // Execute function body; only an explicit return produces a value
+    execute_statement(runtime, function->body);
+    hyp_value_t result = runtime->returning ? runtime->return_value : hyp_value_null();
+    runtime->returning = false;
     
     // Restore previous environment
-    hyp_environment_destroy(runtime->current_env);
+    environment_leave(runtime, runtime->current_env);
     runtime->current_env = prev_env;
     
     return result;
 }
 
+hyp_value_t hyp_runtime_call_global(hyp_runtime_t* runtime, const char* name, hyp_value_t* args, size_t arg_count) {
+    if (!runtime || !name) return hyp_value_null();
+    
+    hyp_value_t callee = hyp_environment_get(runtime->global_env, name);
+    if (callee.type == HYP_VAL_NATIVE_FUNCTION) {
+        return callee.native_function.native_fn(runtime, args, arg_count);
+    }
+    if (callee.type == HYP_VAL_FUNCTION) {
+        return hyp_runtime_call_function(runtime, callee.function, args, arg_count);
+    }
+    
+    runtime->has_error = true;
+    snprintf(runtime->error_message, sizeof(runtime->error_message), "Function '%s' not found", name);
+    return hyp_value_null();
+}
+
+/* Stack operations */
+void hyp_stack_push(hyp_runtime_t* runtime, hyp_value_t value) {
+    if (!runtime) return;
+    HYP_ARRAY_PUSH(&runtime->stack, value);
+}
+
+hyp_value_t hyp_stack_pop(hyp_runtime_t* runtime) {
+    if (!runtime || runtime->stack.count == 0) return hyp_value_null();
+    return runtime->stack.data[--runtime->stack.count];
+}
+
+hyp_value_t hyp_stack_peek(hyp_runtime_t* runtime, size_t offset) {
+    if (!runtime || offset >= runtime->stack.count) return hyp_value_null();
+    return runtime->stack.data[runtime->stack.count - 1 - offset];
+}
+
 void hyp_runtime_collect_garbage(hyp_runtime_t* runtime) {
     /* TODO: Implement garbage collection */
 }
@@ -809,4 +1255,34 @@ void hyp_runtime_clear_error(hyp_runtime_t* runtime) {
         runtime->has_error = false;
         runtime->error_message[0] = '\0';
     }
-}
\ No newline at end of file
+}
+
+/* Event system */
+void hyp_runtime_on_event(hyp_runtime_t* runtime, const char* event_name, hyp_event_handler_t handler) {
+    if (!runtime || !event_name || !handler) return;
+    
+    size_t slot = HYP_MAP_FIND(&runtime->events, event_name);
+    if (slot == HYP_MAP_NONE) {
+        char* name = hyp_strdup(event_name);
+        if (!name) return;
+        slot = HYP_MAP_SLOT(&runtime->events, name, NULL);
+        if (slot == HYP_MAP_NONE) {
+            HYP_FREE(name);
+            return;
+        }
+        HYP_ARRAY_INIT(&HYP_MAP_VALUE(&runtime->events, slot));
+    }
+    HYP_ARRAY_PUSH(&HYP_MAP_VALUE(&runtime->events, slot), handler);
+}
+
+void hyp_runtime_emit_event(hyp_runtime_t* runtime, const char* event_name, hyp_value_t data) {
+    if (!runtime || !event_name) return;
+    
+    /* Handlers may register more handlers, which can move the table, so
+     * the event is looked up again before each call */
+    for (size_t i = 0;; i++) {
+        size_t slot = HYP_MAP_FIND(&runtime->events, event_name);
+        if (slot == HYP_MAP_NONE || i >= HYP_MAP_VALUE(&runtime->events, slot).count) break;
+        HYP_MAP_VALUE(&runtime->events, slot).data[i](data);
+    }
+}
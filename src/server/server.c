@@ -0,0 +1,721 @@
+/**
+ * Hyper Programming Language - Compiler Server Implementation
+ */
+
+#ifndef _WIN32
+    #define _XOPEN_SOURCE 700    /* POSIX.1-2008 plus realpath */
+#endif
+
+#include "../../include/server.h"
+#include "../../include/lexer.h"
+#include "../../include/transpiler.h"
+#include "../../include/profile.h"
+#include "../../include/hyp_thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#ifndef _WIN32
+    #include <errno.h>
+    #include <poll.h>
+    #include <signal.h>
+    #include <unistd.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+#endif
+
+#ifdef __linux__
+    #include <sys/inotify.h>
+    #define HYP_SERVER_WATCH_EVENTS (IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF)
+#endif
+
+/* Initial hash buckets; doubled whenever modules outnumber them */
+#define HYP_SERVER_BUCKETS 64
+
+/* How long a connected client may take to send its request, in ms */
+#define HYP_SERVER_READ_TIMEOUT 5000
+
+const char* hyp_server_socket_path(const char* requested) {
+    if (requested && *requested) return requested;
+
+    const char* env = getenv("HYP_SERVER_SOCKET");
+    return env && *env ? env : HYP_SERVER_DEFAULT_SOCKET;
+}
+
+#ifdef _WIN32
+
+hyp_error_t hyp_server_init(hyp_server_t* server, const char* socket_path, size_t memory_limit) {
+    (void)socket_path;
+    (void)memory_limit;
+    memset(server, 0, sizeof(hyp_server_t));
+    snprintf(server->error_message, sizeof(server->error_message),
+             "The compiler server needs UNIX domain sockets, which this platform lacks");
+    server->has_error = true;
+    return HYP_ERROR_IO;
+}
+
+hyp_error_t hyp_server_run(hyp_server_t* server) {
+    (void)server;
+    return HYP_ERROR_IO;
+}
+
+void hyp_server_destroy(hyp_server_t* server) {
+    (void)server;
+}
+
+hyp_error_t hyp_server_send(const char* socket_path, const char* request, char** response) {
+    (void)socket_path;
+    (void)request;
+    *response = NULL;
+    return HYP_ERROR_NOT_FOUND;
+}
+
+char* hyp_server_absolute_path(const char* path) {
+    return path ? hyp_strdup(path) : NULL;
+}
+
+#else
+
+static void server_error(hyp_server_t* server, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(server->error_message, sizeof(server->error_message), format, args);
+    va_end(args);
+    server->has_error = true;
+}
+
+char* hyp_server_absolute_path(const char* path) {
+    if (!path) return NULL;
+
+    char* resolved = realpath(path, NULL);
+    if (resolved) {
+        char* copy = hyp_strdup(resolved);
+        free(resolved);
+        return copy;
+    }
+    if (path[0] == '/') return hyp_strdup(path);
+
+    /* Not there yet (an output file): anchor it at the working directory */
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) return NULL;
+
+    char* absolute = HYP_MALLOC(strlen(cwd) + strlen(path) + 2);
+    if (!absolute) return NULL;
+    sprintf(absolute, "%s/%s", cwd, path);
+    return absolute;
+}
+
+static int connect_socket(const char* socket_path) {
+    struct sockaddr_un address;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) return -1;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+hyp_error_t hyp_server_send(const char* socket_path, const char* request, char** response) {
+    if (!socket_path || !request || !response) return HYP_ERROR_INVALID_ARG;
+    *response = NULL;
+
+    int fd = connect_socket(socket_path);
+    if (fd < 0) return HYP_ERROR_NOT_FOUND;
+
+    if (!write_all(fd, request, strlen(request))) {
+        close(fd);
+        return HYP_ERROR_IO;
+    }
+    shutdown(fd, SHUT_WR);
+
+    size_t capacity = 256;
+    size_t length = 0;
+    char* buffer = HYP_MALLOC(capacity);
+    while (buffer) {
+        if (length + 1 >= capacity) {
+            capacity *= 2;
+            char* grown = HYP_REALLOC(buffer, capacity);
+            if (!grown) {
+                HYP_FREE(buffer);
+                break;
+            }
+            buffer = grown;
+        }
+        ssize_t received = read(fd, buffer + length, capacity - length - 1);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) break;
+        length += (size_t)received;
+    }
+    close(fd);
+
+    if (!buffer) return HYP_ERROR_MEMORY;
+    buffer[length] = '\0';
+    if (length == 0) {
+        HYP_FREE(buffer);
+        return HYP_ERROR_IO;
+    }
+    *response = buffer;
+    return HYP_OK;
+}
+
+/* Module cache */
+
+static size_t cache_bucket(const hyp_server_t* server, const char* path) {
+    return (size_t)hyp_hash_string(path, HYP_HASH_SEED) & (server->bucket_count - 1);
+}
+
+static hyp_server_module_t* cache_find(const hyp_server_t* server, const char* path) {
+    hyp_server_module_t* module = server->buckets[cache_bucket(server, path)];
+    while (module && strcmp(module->path, path) != 0) {
+        module = module->next;
+    }
+    return module;
+}
+
+static void cache_grow(hyp_server_t* server) {
+    size_t old_count = server->bucket_count;
+    hyp_server_module_t** old_buckets = server->buckets;
+
+    hyp_server_module_t** buckets = HYP_CALLOC(old_count * 2, sizeof(hyp_server_module_t*));
+    if (!buckets) return;
+
+    server->buckets = buckets;
+    server->bucket_count = old_count * 2;
+    for (size_t i = 0; i < old_count; i++) {
+        hyp_server_module_t* module = old_buckets[i];
+        while (module) {
+            hyp_server_module_t* next = module->next;
+            size_t bucket = cache_bucket(server, module->path);
+            module->next = buckets[bucket];
+            buckets[bucket] = module;
+            module = next;
+        }
+    }
+    HYP_FREE(old_buckets);
+}
+
+static void lru_unlink(hyp_server_t* server, hyp_server_module_t* module) {
+    if (module->newer) module->newer->older = module->older;
+    else server->newest = module->older;
+    if (module->older) module->older->newer = module->newer;
+    else server->oldest = module->newer;
+    module->newer = NULL;
+    module->older = NULL;
+}
+
+static void lru_push(hyp_server_t* server, hyp_server_module_t* module) {
+    module->newer = NULL;
+    module->older = server->newest;
+    if (server->newest) server->newest->newer = module;
+    server->newest = module;
+    if (!server->oldest) server->oldest = module;
+}
+
+static void module_destroy(hyp_server_t* server, hyp_server_module_t* module) {
+#ifdef __linux__
+    if (module->watch >= 0 && server->watch_fd >= 0) {
+        inotify_rm_watch(server->watch_fd, module->watch);
+    }
+#else
+    (void)server;
+#endif
+    hyp_ast_image_release(&module->image);
+    for (size_t i = 0; i < module->imports.count; i++) HYP_FREE(module->imports.data[i]);
+    HYP_ARRAY_FREE(&module->imports);
+    HYP_FREE(module->path);
+    HYP_FREE(module);
+}
+
+static void cache_remove(hyp_server_t* server, hyp_server_module_t* module) {
+    hyp_server_module_t** link = &server->buckets[cache_bucket(server, module->path)];
+    while (*link && *link != module) {
+        link = &(*link)->next;
+    }
+    if (*link) *link = module->next;
+
+    lru_unlink(server, module);
+    server->module_count--;
+    server->memory_used -= module->memory;
+    module_destroy(server, module);
+}
+
+/* Drop least recently used modules until the cache fits, keeping `keep` */
+static void cache_evict(hyp_server_t* server, const hyp_server_module_t* keep) {
+    while (server->memory_used > server->memory_limit && server->oldest && server->oldest != keep) {
+        server->evictions++;
+        cache_remove(server, server->oldest);
+    }
+}
+
+/* A change to a watched file drops its module; it is reparsed on next use */
+static void server_read_events(hyp_server_t* server) {
+#ifdef __linux__
+    union {
+        struct inotify_event event;
+        char bytes[4096];
+    } buffer;
+
+    for (;;) {
+        ssize_t length = read(server->watch_fd, &buffer, sizeof(buffer));
+        if (length <= 0) return;
+
+        for (char* p = buffer.bytes; p < buffer.bytes + length; ) {
+            const struct inotify_event* event = (const struct inotify_event*)(void*)p;
+            for (hyp_server_module_t* module = server->newest; module; module = module->older) {
+                if (module->watch != event->wd) continue;
+
+                /* After IN_IGNORED the kernel has already dropped the watch */
+                if (event->mask & IN_IGNORED) module->watch = -1;
+                server->invalidations++;
+                cache_remove(server, module);
+                break;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+#else
+    (void)server;
+#endif
+}
+
+static void module_collect_imports(hyp_server_module_t* module) {
+    const hyp_ast_list_t* statements = &module->ast->program.statements;
+    for (size_t i = 0; i < statements->count; i++) {
+        const hyp_ast_node_t* stmt = hyp_ast_list_at(statements, i);
+        if (stmt->type != AST_IMPORT_STMT || !HYP_AST_TEXT(stmt, import_stmt.module)) continue;
+
+        char* path = hyp_build_resolve_import(module->path, HYP_AST_TEXT(stmt, import_stmt.module));
+        if (path) HYP_ARRAY_PUSH(&module->imports, path);
+    }
+}
+
+/* Parsed module for an absolute path, from the cache while it is current.
+ * Syntax errors are written to diagnostics. */
+static hyp_server_module_t* server_module(hyp_server_t* server, const char* path, bool* hit,
+                                          hyp_out_t* diagnostics, char* error, size_t error_size) {
+    hyp_server_module_t* module = cache_find(server, path);
+
+    /* Unwatched modules are only trusted if their content is unchanged */
+    if (module && module->watch < 0) {
+        hyp_source_t source;
+        bool current = hyp_source_load(&source, path) == HYP_OK &&
+                       hyp_hash_bytes(source.data, source.size, HYP_HASH_SEED) == module->content_hash;
+        hyp_source_release(&source);
+        if (!current) {
+            server->invalidations++;
+            cache_remove(server, module);
+            module = NULL;
+        }
+    }
+
+    if (module) {
+        lru_unlink(server, module);
+        lru_push(server, module);
+        server->hits++;
+        *hit = true;
+        return module;
+    }
+    server->misses++;
+    *hit = false;
+
+    /* Watch before reading, so a save while parsing is not missed */
+    int watch = -1;
+#ifdef __linux__
+    if (server->watch_fd >= 0) {
+        watch = inotify_add_watch(server->watch_fd, path, HYP_SERVER_WATCH_EVENTS);
+    }
+#endif
+
+    hyp_source_t source;
+    const char* text = hyp_source_load(&source, path) == HYP_OK ? source.data : NULL;
+    hyp_lexer_t* lexer = text ? hyp_lexer_create_with_length(text, source.size, path) : NULL;
+    hyp_ast_image_t image;
+    server->ast_cache.messages = diagnostics;
+    hyp_error_t parsed = lexer ? hyp_ast_cache_parse(&server->ast_cache, lexer, text, source.size, &image)
+                               : HYP_ERROR_MEMORY;
+    server->ast_cache.messages = NULL;
+
+    const char* failure = NULL;
+    if (!text) {
+        failure = "could not read file";
+    } else if (parsed == HYP_ERROR_SYNTAX) {
+        failure = "Parsing failed";
+    } else if (parsed != HYP_OK) {
+        failure = "out of memory";
+    } else {
+        module = HYP_CALLOC(1, sizeof(hyp_server_module_t));
+        if (module) module->path = hyp_strdup(path);
+        if (!module || !module->path) failure = "out of memory";
+    }
+
+    /* The AST holds its own copies of names and strings */
+    hyp_lexer_destroy(lexer);
+    size_t size = text ? source.size : 0;
+    uint64_t hash = text ? hyp_hash_bytes(text, size, HYP_HASH_SEED) : 0;
+    if (text) hyp_source_release(&source);
+
+    if (failure) {
+        snprintf(error, error_size, "%s", failure);
+        if (module) HYP_FREE(module);
+#ifdef __linux__
+        if (watch >= 0) inotify_rm_watch(server->watch_fd, watch);
+#endif
+        if (parsed == HYP_OK) hyp_ast_image_release(&image);
+        return NULL;
+    }
+
+    HYP_ARRAY_INIT(&module->imports);
+    module->image = image;
+    module->ast = image.root;
+    module->content_hash = hash;
+    module->interface_hash = hyp_build_interface_hash(module->ast);
+    module_collect_imports(module);
+    module->watch = watch;
+
+    size_t tree = image.parser ? (size_t)image.parser->slot_capacity * sizeof(hyp_ast_node_t) : image.size;
+    module->memory = sizeof(hyp_server_module_t) + strlen(path) + tree;
+
+    size_t bucket = cache_bucket(server, path);
+    module->next = server->buckets[bucket];
+    server->buckets[bucket] = module;
+    lru_push(server, module);
+    server->module_count++;
+    server->memory_used += module->memory;
+
+    if (server->module_count > server->bucket_count) {
+        cache_grow(server);
+    }
+    cache_evict(server, module);
+    return module;
+}
+
+/* Requests */
+
+/* Value of a "key value" line of a request, or NULL */
+static const char* request_value(char** lines, size_t count, const char* key) {
+    size_t length = strlen(key);
+    for (size_t i = 1; i < count; i++) {
+        if (strncmp(lines[i], key, length) == 0 && lines[i][length] == ' ') {
+            return lines[i] + length + 1;
+        }
+    }
+    return NULL;
+}
+
+static void server_compile(hyp_server_t* server, char** lines, size_t count, hyp_out_t* response) {
+    const char* version = request_value(lines, count, "version");
+    const char* input = request_value(lines, count, "input");
+    const char* output = request_value(lines, count, "output");
+    const char* target = request_value(lines, count, "target");
+    const char* optimize = request_value(lines, count, "optimize");
+    const char* debug = request_value(lines, count, "debug");
+    const char* jobs = request_value(lines, count, "jobs");
+    const char* profile_file = request_value(lines, count, "profile");
+
+    if (!version || strcmp(version, HYP_VERSION_STRING) != 0) {
+        hyp_out_printf(response, "error server runs hypc %s\n", HYP_VERSION_STRING);
+        return;
+    }
+    if (!input || !output) {
+        hyp_out_puts(response, "error compile needs an input and an output\n");
+        return;
+    }
+
+    double started = hyp_wall_time();
+    bool hit;
+    char error[256];
+    hyp_out_t diagnostics;
+    hyp_out_init(&diagnostics, -1);
+    hyp_server_module_t* module = server_module(server, input, &hit, &diagnostics, error, sizeof(error));
+    if (!module) {
+        /* Syntax errors read as they would from a local hypc */
+        if (diagnostics.length > 0) {
+            hyp_out_printf(response, "error %s\n", error);
+            char* text = hyp_out_to_string(&diagnostics, NULL);
+            if (text) hyp_out_puts(response, text);
+            HYP_FREE(text);
+        } else {
+            hyp_out_printf(response, "error %s: %s\n", input, error);
+        }
+        hyp_out_destroy(&diagnostics);
+        return;
+    }
+    hyp_out_destroy(&diagnostics);
+
+    /* Profiles are small and change between runs; they are not cached */
+    hyp_profile_t* profile = NULL;
+    if (profile_file && (hyp_profile_load(profile_file, &profile) != HYP_OK ||
+                         hyp_profile_bind(profile, module->ast) != HYP_OK)) {
+        hyp_profile_destroy(profile);
+        profile = NULL;
+    }
+
+    hyp_codegen_options_t options = {
+        .target = target ? (hyp_target_t)atoi(target) : TARGET_C,
+        .optimize = optimize && strcmp(optimize, "1") == 0,
+        .debug_info = debug && strcmp(debug, "1") == 0,
+        .profile = profile,
+        .jobs = jobs ? (size_t)strtoul(jobs, NULL, 10) : 0
+    };
+
+    int fd = hyp_create_file(output);
+    if (fd < 0) {
+        hyp_out_printf(response, "error could not open output file '%s'\n", output);
+        hyp_profile_destroy(profile);
+        return;
+    }
+
+    hyp_codegen_t codegen;
+    hyp_error_t result = hyp_codegen_init(&codegen, &options, NULL);
+    size_t bytes = 0;
+    if (result == HYP_OK) {
+        hyp_codegen_set_output_fd(&codegen, fd);
+        result = hyp_codegen_generate(&codegen, module->ast);
+        bytes = hyp_codegen_get_output_length(&codegen);
+        if (result != HYP_OK) {
+            hyp_out_printf(response, "error %s\n", codegen.has_error ? codegen.error_message : "code generation failed");
+        }
+        hyp_codegen_destroy(&codegen);
+    } else {
+        hyp_out_puts(response, "error could not initialize code generator\n");
+    }
+
+    if (hyp_close_file(fd) != HYP_OK && result == HYP_OK) {
+        hyp_out_printf(response, "error could not write output file '%s'\n", output);
+        result = HYP_ERROR_IO;
+    }
+    if (result != HYP_OK) {
+        remove(output);
+    } else {
+        double elapsed = hyp_wall_time() - started;
+        hyp_out_printf(response, "ok %zu %s %.3f\n", bytes, hit ? "hit" : "miss", elapsed * 1000.0);
+        if (server->verbose) {
+            printf("%s (%s, %.3f ms)\n", input, hit ? "cached" : "parsed", elapsed * 1000.0);
+            fflush(stdout);
+        }
+    }
+    hyp_profile_destroy(profile);
+}
+
+static void server_stats(hyp_server_t* server, hyp_out_t* response) {
+    hyp_out_puts(response, "ok\n");
+    hyp_out_printf(response, "modules %zu\n", server->module_count);
+    hyp_out_printf(response, "memory %zu\n", server->memory_used);
+    hyp_out_printf(response, "limit %zu\n", server->memory_limit);
+    hyp_out_printf(response, "requests %llu\n", (unsigned long long)server->requests);
+    hyp_out_printf(response, "hits %llu\n", (unsigned long long)server->hits);
+    hyp_out_printf(response, "misses %llu\n", (unsigned long long)server->misses);
+    hyp_out_printf(response, "invalidations %llu\n", (unsigned long long)server->invalidations);
+    hyp_out_printf(response, "evictions %llu\n", (unsigned long long)server->evictions);
+    hyp_out_printf(response, "ast-cache-hits %zu\n", server->ast_cache.hits);
+    hyp_out_printf(response, "watching %s\n", server->watch_fd >= 0 ? "inotify" : "hashes");
+}
+
+/* Read a request until the client closes its side (or sends a blank line) */
+static char* read_request(int fd) {
+    char* buffer = HYP_MALLOC(HYP_SERVER_MAX_REQUEST + 1);
+    if (!buffer) return NULL;
+
+    size_t length = 0;
+    while (length < HYP_SERVER_MAX_REQUEST) {
+        struct pollfd ready = { fd, POLLIN, 0 };
+        if (poll(&ready, 1, HYP_SERVER_READ_TIMEOUT) <= 0) break;
+
+        ssize_t received = read(fd, buffer + length, HYP_SERVER_MAX_REQUEST - length);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) break;
+        length += (size_t)received;
+
+        buffer[length] = '\0';
+        if (strstr(buffer, "\n\n")) break;
+    }
+    buffer[length] = '\0';
+    return buffer;
+}
+
+static void server_handle(hyp_server_t* server, int client) {
+    char* request = read_request(client);
+    if (!request) return;
+
+    /* Pick up saves that happened just before this request */
+    server_read_events(server);
+    server->requests++;
+
+    char* lines[32];
+    size_t count = 0;
+    for (char* line = request; line && *line && count < 32; ) {
+        char* next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        if (*line) lines[count++] = line;
+        line = next;
+    }
+
+    hyp_out_t response;
+    hyp_out_init(&response, client);
+    if (count == 0) {
+        hyp_out_puts(&response, "error empty request\n");
+    } else if (strcmp(lines[0], "compile") == 0) {
+        server_compile(server, lines, count, &response);
+    } else if (strcmp(lines[0], "stats") == 0) {
+        server_stats(server, &response);
+    } else if (strcmp(lines[0], "shutdown") == 0) {
+        server->running = false;
+        hyp_out_puts(&response, "ok\n");
+    } else {
+        hyp_out_printf(&response, "error unknown command '%s'\n", lines[0]);
+    }
+    hyp_out_flush(&response);
+    hyp_out_destroy(&response);
+    HYP_FREE(request);
+}
+
+static volatile sig_atomic_t server_signalled = 0;
+
+static void server_on_signal(int signal_number) {
+    (void)signal_number;
+    server_signalled = 1;
+}
+
+hyp_error_t hyp_server_init(hyp_server_t* server, const char* socket_path, size_t memory_limit) {
+    if (!server || !socket_path) return HYP_ERROR_INVALID_ARG;
+
+    memset(server, 0, sizeof(hyp_server_t));
+    server->listen_fd = -1;
+    server->watch_fd = -1;
+    server->memory_limit = memory_limit ? memory_limit : HYP_SERVER_DEFAULT_MEMORY;
+    server->socket_path = hyp_strdup(socket_path);
+    server->buckets = HYP_CALLOC(HYP_SERVER_BUCKETS, sizeof(hyp_server_module_t*));
+    server->bucket_count = HYP_SERVER_BUCKETS;
+    hyp_ast_cache_init(&server->ast_cache);
+    if (!server->socket_path || !server->buckets) {
+        server_error(server, "Out of memory");
+        return HYP_ERROR_MEMORY;
+    }
+
+    struct sockaddr_un address;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        server_error(server, "Socket path '%s' is too long", socket_path);
+        return HYP_ERROR_INVALID_ARG;
+    }
+
+    const char* slash = strrchr(socket_path, '/');
+    if (slash && slash != socket_path) {
+        char parent[sizeof(address.sun_path)];
+        snprintf(parent, sizeof(parent), "%.*s", (int)(slash - socket_path), socket_path);
+        hyp_make_directory(parent);
+    }
+
+    /* A socket file nobody answers on was left behind by a dead server */
+    int existing = connect_socket(socket_path);
+    if (existing >= 0) {
+        close(existing);
+        server_error(server, "A compiler server is already listening on '%s'", socket_path);
+        return HYP_ERROR_PERMISSION;
+    }
+    unlink(socket_path);
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 64) != 0) {
+        if (fd >= 0) close(fd);
+        server_error(server, "Could not listen on '%s': %s", socket_path, strerror(errno));
+        return HYP_ERROR_IO;
+    }
+    server->listen_fd = fd;
+
+#ifdef __linux__
+    server->watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+
+    /* A client that disconnects early must not take the server down */
+    signal(SIGPIPE, SIG_IGN);
+    return HYP_OK;
+}
+
+hyp_error_t hyp_server_run(hyp_server_t* server) {
+    if (!server || server->listen_fd < 0) return HYP_ERROR_INVALID_ARG;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = server_on_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    server->running = true;
+    server_signalled = 0;
+    while (server->running && !server_signalled) {
+        struct pollfd fds[2];
+        nfds_t count = 1;
+        fds[0].fd = server->listen_fd;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        if (server->watch_fd >= 0) {
+            fds[1].fd = server->watch_fd;
+            fds[1].events = POLLIN;
+            fds[1].revents = 0;
+            count = 2;
+        }
+
+        if (poll(fds, count, -1) < 0) {
+            if (errno == EINTR) continue;
+            server_error(server, "poll failed: %s", strerror(errno));
+            return HYP_ERROR_IO;
+        }
+
+        if (count > 1 && (fds[1].revents & POLLIN)) {
+            server_read_events(server);
+        }
+        if (fds[0].revents & POLLIN) {
+            int client = accept(server->listen_fd, NULL, NULL);
+            if (client >= 0) {
+                server_handle(server, client);
+                close(client);
+            }
+        }
+    }
+    return HYP_OK;
+}
+
+void hyp_server_destroy(hyp_server_t* server) {
+    if (!server) return;
+
+    while (server->oldest) {
+        cache_remove(server, server->oldest);
+    }
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        unlink(server->socket_path);
+    }
+    if (server->watch_fd >= 0) {
+        close(server->watch_fd);
+    }
+    HYP_FREE(server->buckets);
+    HYP_FREE(server->socket_path);
+}
+
+#endif
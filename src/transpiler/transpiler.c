@@ -5,68 +5,134 @@
  * Supports multiple output targets with optimizations and symbol management.
  */
 
+#define HYP_MEM_TAG HYP_MEM_CODEGEN
+
 #include "../../include/transpiler.h"
 #include "../../include/parser.h"
 #include "../../include/hyp_common.h"
-#include "../../include/hyp_runtime.h"
+#include "../../include/profile.h"
+#include "../../include/hyp_thread.h"
+#include "../../include/hyp_metrics.h"
 #include <string.h>
 #include <stdarg.h>
 
-/* Forward declaration */
+/* Forward declarations */
 void hyp_codegen_generate_node(hyp_codegen_t* codegen, hyp_ast_node_t* node);
+static size_t escape_c_size(const char* str);
+static void escape_c_into(char* result, const char* str);
+
+/* Index names[index] in a map from names to table positions; a later
+ * entry with the same name replaces the earlier one */
+static bool name_index_add(hyp_name_index_t* names_index, const char* const* names, size_t index) {
+    size_t slot = HYP_MAP_SLOT(names_index, names[index], NULL);
+    if (slot == HYP_MAP_NONE) return false;
+    HYP_MAP_VALUE(names_index, slot) = (uint32_t)index;
+    return true;
+}
+
+static int name_index_find(const hyp_name_index_t* names_index, const char* name) {
+    size_t slot = HYP_MAP_FIND(names_index, name);
+    return slot == HYP_MAP_NONE ? -1 : (int)HYP_MAP_VALUE(names_index, slot);
+}
 
 /* Symbol table implementation */
-static const char* symbol_table_lookup(hyp_codegen_t* codegen, const char* name) {
+static int symbol_table_find(hyp_codegen_t* codegen, const char* name) {
+    /* Search innermost scope first so locals shadow globals */
+    for (size_t i = codegen->symbols.count; i > codegen->global_count; i--) {
+        if (strcmp(codegen->symbols.names[i - 1], name) == 0) {
+            return (int)(i - 1);
+        }
+    }
+    
+    /* Top-level symbols are hashed once they are all declared */
+    return name_index_find(&codegen->global_index, name);
+}
+
+/* Hash the symbols declared so far as the top level */
+static bool symbol_table_index_globals(hyp_codegen_t* codegen) {
     for (size_t i = 0; i < codegen->symbols.count; i++) {
-        if (strcmp(codegen->symbols.names[i], name) == 0) {
-            return codegen->symbols.names[i];
+        if (!name_index_add(&codegen->global_index, (const char* const*)codegen->symbols.names, i)) {
+            return false;
         }
     }
-    return NULL;
+    codegen->global_count = codegen->symbols.count;
+    return true;
 }
 
-static void symbol_table_add(hyp_codegen_t* codegen, const char* name, hyp_type_t* type) {
+static void symbol_table_add(hyp_codegen_t* codegen, const char* name, hyp_type_t* type,
+                             hyp_symbol_kind_t kind, size_t arity) {
     if (codegen->symbols.count >= codegen->symbols.capacity) {
         size_t new_capacity = codegen->symbols.capacity ? codegen->symbols.capacity * 2 : 8;
-        codegen->symbols.names = realloc(codegen->symbols.names, new_capacity * sizeof(char*));
-        codegen->symbols.types = realloc(codegen->symbols.types, new_capacity * sizeof(hyp_type_t*));
+        codegen->symbols.names = HYP_REALLOC(codegen->symbols.names, new_capacity * sizeof(char*));
+        codegen->symbols.types = HYP_REALLOC(codegen->symbols.types, new_capacity * sizeof(hyp_type_t*));
+        codegen->symbols.kinds = HYP_REALLOC(codegen->symbols.kinds, new_capacity * sizeof(hyp_symbol_kind_t));
+        codegen->symbols.arities = HYP_REALLOC(codegen->symbols.arities, new_capacity * sizeof(size_t));
         codegen->symbols.capacity = new_capacity;
     }
     
     codegen->symbols.names[codegen->symbols.count] = (char*)name;
     codegen->symbols.types[codegen->symbols.count] = type;
+    codegen->symbols.kinds[codegen->symbols.count] = kind;
+    codegen->symbols.arities[codegen->symbols.count] = arity;
     codegen->symbols.count++;
 }
 
-/* Code emission helpers */
+/* Code emission helpers. Output goes to a chunked buffer (or straight to
+ * the output file); formatted text is written in place without a
+ * length limit, and the emit_text/emit_ident/emit_number/emit_size
+ * helpers skip formatting altogether for the common cases. */
 static void emit(hyp_codegen_t* codegen, const char* format, ...) {
     va_list args;
     va_start(args, format);
-    
-    char buffer[1024];
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    
-    hyp_string_append(&codegen->output, buffer);
-    
+    hyp_out_vprintf(&codegen->output, format, args);
     va_end(args);
 }
 
+#define emit_text(codegen, text) HYP_OUT_LITERAL(&(codegen)->output, text)
+
+static void emit_str(hyp_codegen_t* codegen, const char* text) {
+    hyp_out_puts(&codegen->output, text);
+}
+
+static void emit_size(hyp_codegen_t* codegen, size_t value) {
+    hyp_out_write_uint(&codegen->output, (uint64_t)value);
+}
+
+static void emit_number(hyp_codegen_t* codegen, double value) {
+    hyp_out_write_double(&codegen->output, value);
+}
+
+static void write_indent(hyp_codegen_t* codegen) {
+    static const char spaces[] = "                                                                ";
+    size_t width = (size_t)codegen->indent_level * 4;
+    while (width > 0) {
+        size_t part = width < sizeof(spaces) - 1 ? width : sizeof(spaces) - 1;
+        hyp_out_write(&codegen->output, spaces, part);
+        width -= part;
+    }
+}
+
 static void emit_line(hyp_codegen_t* codegen, const char* format, ...) {
-    /* Add indentation */
-    for (int i = 0; i < codegen->indent_level; i++) {
-        hyp_string_append(&codegen->output, "    ");
+    /* Add indentation (blank lines stay blank) */
+    if (format[0]) {
+        write_indent(codegen);
     }
     
     va_list args;
     va_start(args, format);
-    
-    char buffer[1024];
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    
-    hyp_string_append(&codegen->output, buffer);
-    hyp_string_append(&codegen->output, "\n");
-    
+    hyp_out_vprintf(&codegen->output, format, args);
     va_end(args);
+    
+    hyp_out_putc(&codegen->output, '\n');
+}
+
+/* Start a line that is completed with emit() calls and end_line() */
+static void begin_line(hyp_codegen_t* codegen) {
+    write_indent(codegen);
+}
+
+static void end_line(hyp_codegen_t* codegen) {
+    hyp_out_putc(&codegen->output, '\n');
 }
 
 static void emit_indent(hyp_codegen_t* codegen) {
@@ -79,238 +145,1211 @@ static void emit_dedent(hyp_codegen_t* codegen) {
     }
 }
 
-/* C code generation */
+/* C code generation
+ *
+ * Generated C links against libhyprt (include/hyprt.h) and never sees the
+ * interpreter. Every Hyper value is a hyprt_value_t; user identifiers get
+ * an "hyp_u_" prefix so they cannot collide with C keywords or runtime
+ * symbols. String literals and property keys are interned once at startup
+ * into the hyp_str table.
+ */
+#define HYP_C_PREFIX "hyp_u_"
+
+static void emit_ident(hyp_codegen_t* codegen, const char* name) {
+    emit_text(codegen, HYP_C_PREFIX);
+    emit_str(codegen, name);
+}
+
+static void generate_c_expression(hyp_codegen_t* codegen, hyp_ast_node_t* node);
+static void generate_c_statement(hyp_codegen_t* codegen, hyp_ast_node_t* node);
+static void generate_c_named_call(hyp_codegen_t* codegen, hyp_ast_node_t* node, const char* name);
+
+/* Builtins map straight onto libhyprt functions */
+static const char* c_builtin_function(const char* name) {
+    if (strcmp(name, "print") == 0) return "hyprt_builtin_print";
+    if (strcmp(name, "typeof") == 0) return "hyprt_builtin_typeof";
+    if (strcmp(name, "len") == 0) return "hyprt_builtin_len";
+    if (strcmp(name, "parseNumber") == 0) return "hyprt_builtin_parse_number";
+    return NULL;
+}
+
+static const char* c_binary_function(hyp_binary_op_t op) {
+    switch (op) {
+        case BINOP_ADD: return "hyprt_add";
+        case BINOP_SUB: return "hyprt_sub";
+        case BINOP_MUL: return "hyprt_mul";
+        case BINOP_DIV: return "hyprt_div";
+        case BINOP_MOD: return "hyprt_mod";
+        case BINOP_POW: return "hyprt_pow";
+        case BINOP_EQ: return "hyprt_eq";
+        case BINOP_NE: return "hyprt_ne";
+        case BINOP_LT: return "hyprt_lt";
+        case BINOP_LE: return "hyprt_le";
+        case BINOP_GT: return "hyprt_gt";
+        case BINOP_GE: return "hyprt_ge";
+        case BINOP_BITWISE_AND: return "hyprt_bitwise_and";
+        case BINOP_BITWISE_OR: return "hyprt_bitwise_or";
+        case BINOP_BITWISE_XOR: return "hyprt_bitwise_xor";
+        case BINOP_LEFT_SHIFT: return "hyprt_left_shift";
+        case BINOP_RIGHT_SHIFT: return "hyprt_right_shift";
+        default: return NULL;
+    }
+}
+
+/* Index of a string in the literal table, adding it if needed */
+static size_t c_literal_index(hyp_codegen_t* codegen, const char* value) {
+    int index = name_index_find(&codegen->literal_index, value);
+    if (index >= 0) return codegen->literal_base + (size_t)index;
+    
+    /* Workers share the table read-only; c_collect_literals fills it first */
+    if (codegen->is_worker) {
+        hyp_codegen_error(codegen, "Internal error: string literal '%s' was not interned", value);
+        return 0;
+    }
+    
+    HYP_ARRAY_PUSH(&codegen->literals, value);
+    if (!name_index_add(&codegen->literal_index, codegen->literals.data, codegen->literals.count - 1)) {
+        hyp_codegen_error(codegen, "Out of memory while interning string literal");
+    }
+    return codegen->literal_base + codegen->literals.count - 1;
+}
+
+/* Intern every string a subtree can reference, in generation order */
+static void c_collect_literals(hyp_codegen_t* codegen, hyp_ast_node_t* node);
+
+static void c_collect_literal_list(hyp_codegen_t* codegen, const hyp_ast_list_t* nodes) {
+    for (size_t i = 0; i < nodes->count; i++) {
+        c_collect_literals(codegen, hyp_ast_list_at(nodes, i));
+    }
+}
+
+static void c_collect_literals(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    if (!node) return;
+    
+    switch (node->type) {
+        case AST_STRING:
+            c_literal_index(codegen, HYP_AST_TEXT(node, string.value) ? HYP_AST_TEXT(node, string.value) : "");
+            break;
+        case AST_BINARY_OP:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, binary_op.left));
+            c_collect_literals(codegen, HYP_AST_CHILD(node, binary_op.right));
+            break;
+        case AST_UNARY_OP:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, unary_op.operand));
+            break;
+        case AST_ASSIGNMENT:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, assignment.target));
+            c_collect_literals(codegen, HYP_AST_CHILD(node, assignment.value));
+            break;
+        case AST_CALL:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, call.callee));
+            c_collect_literal_list(codegen, &node->call.arguments);
+            break;
+        case AST_MEMBER_ACCESS:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, member_access.object));
+            c_literal_index(codegen, HYP_AST_TEXT(node, member_access.member));
+            break;
+        case AST_INDEX_ACCESS:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, index_access.object));
+            c_collect_literals(codegen, HYP_AST_CHILD(node, index_access.index));
+            break;
+        case AST_CONDITIONAL:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, conditional.condition));
+            c_collect_literals(codegen, HYP_AST_CHILD(node, conditional.then_expr));
+            c_collect_literals(codegen, HYP_AST_CHILD(node, conditional.else_expr));
+            break;
+        case AST_ARRAY_LITERAL:
+            c_collect_literal_list(codegen, &node->array_literal.elements);
+            break;
+        case AST_OBJECT_LITERAL: {
+            const hyp_object_property_t* properties = HYP_AST_PROPERTIES(&node->object_literal.properties);
+            for (size_t i = 0; i < node->object_literal.properties.count; i++) {
+                c_literal_index(codegen, hyp_ast_text(&properties[i].key));
+            }
+            for (size_t i = 0; i < node->object_literal.properties.count; i++) {
+                c_collect_literals(codegen, hyp_ast_get(&properties[i].value));
+            }
+            break;
+        }
+        case AST_EXPRESSION_STMT:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, expression_stmt.expression));
+            break;
+        case AST_VARIABLE_DECL:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, variable_decl.initializer));
+            break;
+        case AST_IF_STMT:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, if_stmt.condition));
+            c_collect_literals(codegen, HYP_AST_CHILD(node, if_stmt.then_stmt));
+            c_collect_literals(codegen, HYP_AST_CHILD(node, if_stmt.else_stmt));
+            break;
+        case AST_WHILE_STMT:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, while_stmt.condition));
+            c_collect_literals(codegen, HYP_AST_CHILD(node, while_stmt.body));
+            break;
+        case AST_RETURN_STMT:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, return_stmt.value));
+            break;
+        case AST_BLOCK_STMT:
+            c_collect_literal_list(codegen, &node->block_stmt.statements);
+            break;
+        case AST_FUNCTION_DECL:
+            c_collect_literals(codegen, HYP_AST_CHILD(node, function_decl.body));
+            break;
+        default:
+            break;
+    }
+}
+
+static void generate_c_unsupported(hyp_codegen_t* codegen, hyp_ast_node_t* node, const char* what) {
+    hyp_codegen_error(codegen, "line %u: %s are not supported by the C target yet", node->line, what);
+    emit_text(codegen, "hyprt_null()");
+}
+
 static void generate_c_number(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    emit(codegen, "%.17g", node->number.value);
+    emit_text(codegen, "hyprt_number(");
+    emit_number(codegen, node->number.value);
+    emit_text(codegen, ")");
 }
 
 static void generate_c_string(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    emit(codegen, "\"%s\"", node->string.value ? node->string.value : "");
+    emit_text(codegen, "hyp_str[");
+    emit_size(codegen, c_literal_index(codegen, HYP_AST_TEXT(node, string.value) ? HYP_AST_TEXT(node, string.value) : ""));
+    emit_text(codegen, "]");
 }
 
 static void generate_c_boolean(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    emit(codegen, node->boolean.value ? "true" : "false");
+    if (node->boolean.value) {
+        emit_text(codegen, "hyprt_boolean(true)");
+    } else {
+        emit_text(codegen, "hyprt_boolean(false)");
+    }
+}
+
+/* Each module is compiled to C on its own and nothing links them
+ * together, so a name from another module has nothing to refer to */
+static void generate_c_imported(hyp_codegen_t* codegen, hyp_ast_node_t* node, const char* name) {
+    hyp_codegen_error(codegen, "line %u: '%s' is imported from another module, which the C target "
+                      "does not support yet (modules are compiled separately and not linked)",
+                      node->line, name);
+    emit_text(codegen, "hyprt_null()");
 }
 
 static void generate_c_identifier(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    emit(codegen, "%s", node->identifier.name ? node->identifier.name : "unknown");
+    const char* name = HYP_AST_TEXT(node, identifier.name) ? HYP_AST_TEXT(node, identifier.name) : "";
+    int index = symbol_table_find(codegen, name);
+    
+    if (index >= 0 && codegen->symbols.kinds[index] == HYP_SYMBOL_IMPORT) {
+        generate_c_imported(codegen, node, name);
+    } else if (index < 0) {
+        hyp_codegen_error(codegen, "line %u: undefined variable '%s'", node->line, name);
+        emit_text(codegen, "hyprt_null()");
+    } else if (codegen->symbols.kinds[index] == HYP_SYMBOL_FUNCTION) {
+        hyp_codegen_error(codegen, "line %u: function '%s' cannot be used as a value in the C target",
+                          node->line, name);
+        emit_text(codegen, "hyprt_null()");
+    } else {
+        emit_ident(codegen, name);
+    }
 }
 
 static void generate_c_binary(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    emit(codegen, "(");
-    hyp_codegen_generate_node(codegen, node->binary_op.left);
+    hyp_binary_op_t op = node->binary_op.op;
     
-    switch (node->binary_op.op) {
-        case BINOP_ADD: emit(codegen, " + "); break;
-        case BINOP_SUB: emit(codegen, " - "); break;
-        case BINOP_MUL: emit(codegen, " * "); break;
-        case BINOP_DIV: emit(codegen, " / "); break;
-        case BINOP_MOD: emit(codegen, " %% "); break;
-        case BINOP_EQ: emit(codegen, " == "); break;
-        case BINOP_NE: emit(codegen, " != "); break;
-        case BINOP_LT: emit(codegen, " < "); break;
-        case BINOP_LE: emit(codegen, " <= "); break;
-        case BINOP_GT: emit(codegen, " > "); break;
-        case BINOP_GE: emit(codegen, " >= "); break;
-        case BINOP_AND: emit(codegen, " && "); break;
-        case BINOP_OR: emit(codegen, " || "); break;
-        default: emit(codegen, " ? "); break;
+    /* Logical operators short-circuit and yield an operand, so the left
+     * value is parked in a temporary slot indexed by nesting depth */
+    if (op == BINOP_AND || op == BINOP_OR) {
+        int slot = codegen->temp_depth++;
+        if (codegen->temp_depth > codegen->temp_max) {
+            codegen->temp_max = codegen->temp_depth;
+        }
+        
+        emit(codegen, "(hyp_tmp[%d] = ", slot);
+        generate_c_expression(codegen, HYP_AST_CHILD(node, binary_op.left));
+        emit(codegen, op == BINOP_AND ? ", hyprt_truthy(hyp_tmp[%d]) ? " : ", !hyprt_truthy(hyp_tmp[%d]) ? ", slot);
+        codegen->temp_depth--;
+        generate_c_expression(codegen, HYP_AST_CHILD(node, binary_op.right));
+        emit(codegen, " : hyp_tmp[%d])", slot);
+        return;
     }
     
-    hyp_codegen_generate_node(codegen, node->binary_op.right);
-    emit(codegen, ")");
+    /* Functions are not values in the C target, so `value |> f` is only
+     * compiled when f names one, as the call f(value) */
+    if (op == BINOP_PIPE) {
+        hyp_ast_node_t* callee = HYP_AST_CHILD(node, binary_op.right);
+        if (!callee || callee->type != AST_IDENTIFIER) {
+            generate_c_unsupported(codegen, node, "pipes into computed functions");
+            return;
+        }
+        generate_c_named_call(codegen, node, HYP_AST_TEXT(callee, identifier.name));
+        return;
+    }
+    
+    const char* function = c_binary_function(op);
+    if (!function) {
+        hyp_codegen_error(codegen, "line %u: unknown binary operator %d", node->line, (int)op);
+        emit_text(codegen, "hyprt_null()");
+        return;
+    }
+    
+    /* Additions that only ever saw strings skip the numeric check */
+    uint32_t types = hyp_profile_operand_types(codegen->profile, node);
+    if (op == BINOP_ADD && types && !(types & HYP_PROFILE_TYPE_NUMBER)) {
+        emit_text(codegen, "hyprt_binary_slow(HYPRT_OP_ADD, ");
+    } else {
+        emit_str(codegen, function);
+        emit_text(codegen, "(");
+    }
+    generate_c_expression(codegen, HYP_AST_CHILD(node, binary_op.left));
+    emit_text(codegen, ", ");
+    generate_c_expression(codegen, HYP_AST_CHILD(node, binary_op.right));
+    emit_text(codegen, ")");
+}
+
+/* ++x and --x store and yield the new value; x++ and x-- park the old
+ * one in a temporary slot to yield it after the store */
+static void generate_c_increment(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    hyp_ast_node_t* target = HYP_AST_CHILD(node, unary_op.operand);
+    const char* function = node->unary_op.op == UNOP_INCREMENT ? "hyprt_increment" : "hyprt_decrement";
+    
+    if (!target || target->type != AST_IDENTIFIER) {
+        hyp_codegen_error(codegen, "line %u: invalid %s target", node->line,
+                          node->unary_op.op == UNOP_INCREMENT ? "increment" : "decrement");
+        emit_text(codegen, "hyprt_null()");
+        return;
+    }
+    
+    const char* name = HYP_AST_TEXT(target, identifier.name);
+    int index = symbol_table_find(codegen, name);
+    if (index >= 0 && codegen->symbols.kinds[index] == HYP_SYMBOL_IMPORT) {
+        generate_c_imported(codegen, node, name);
+        return;
+    }
+    if (index < 0 || codegen->symbols.kinds[index] == HYP_SYMBOL_FUNCTION) {
+        hyp_codegen_error(codegen, "line %u: assignment to undeclared variable '%s'", node->line, name);
+        emit_text(codegen, "hyprt_null()");
+        return;
+    }
+    
+    if (!node->unary_op.is_postfix) {
+        emit_text(codegen, "(");
+        emit_ident(codegen, name);
+        emit_text(codegen, " = ");
+        emit_str(codegen, function);
+        emit_text(codegen, "(");
+        emit_ident(codegen, name);
+        emit_text(codegen, "))");
+        return;
+    }
+    
+    int slot = codegen->temp_depth;
+    if (slot + 1 > codegen->temp_max) {
+        codegen->temp_max = slot + 1;
+    }
+    emit(codegen, "(hyp_tmp[%d] = ", slot);
+    emit_ident(codegen, name);
+    emit_text(codegen, ", ");
+    emit_ident(codegen, name);
+    emit_text(codegen, " = ");
+    emit_str(codegen, function);
+    emit(codegen, "(hyp_tmp[%d]), hyp_tmp[%d])", slot, slot);
 }
 
 static void generate_c_unary(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
     switch (node->unary_op.op) {
-        case UNOP_NOT:
-            emit(codegen, "!");
+        case UNOP_NOT: emit_text(codegen, "hyprt_not("); break;
+        case UNOP_MINUS: emit_text(codegen, "hyprt_negate("); break;
+        case UNOP_PLUS: emit_text(codegen, "hyprt_plus("); break;
+        case UNOP_BITWISE_NOT: emit_text(codegen, "hyprt_bitwise_not("); break;
+        case UNOP_INCREMENT:
+        case UNOP_DECREMENT:
+            generate_c_increment(codegen, node);
+            return;
+        default:
+            hyp_codegen_error(codegen, "line %u: unknown unary operator %d", node->line, (int)node->unary_op.op);
+            emit_text(codegen, "hyprt_null()");
+            return;
+    }
+    generate_c_expression(codegen, HYP_AST_CHILD(node, unary_op.operand));
+    emit_text(codegen, ")");
+}
+
+/* Emit `(hyprt_value_t[]){a, b, c}`, or NULL for an empty list */
+static void generate_c_value_list(hyp_codegen_t* codegen, const hyp_ast_list_t* values) {
+    if (values->count == 0) {
+        emit_text(codegen, "NULL");
+        return;
+    }
+    
+    emit_text(codegen, "(hyprt_value_t[]){");
+    for (size_t i = 0; i < values->count; i++) {
+        if (i > 0) emit_text(codegen, ", ");
+        generate_c_expression(codegen, hyp_ast_list_at(values, i));
+    }
+    emit_text(codegen, "}");
+}
+
+/* Argument i of a call; `value |> f` passes the piped value as the only one */
+static void generate_c_argument(hyp_codegen_t* codegen, hyp_ast_node_t* node, size_t i) {
+    if (node->type == AST_BINARY_OP) {
+        generate_c_expression(codegen, HYP_AST_CHILD(node, binary_op.left));
+    } else {
+        generate_c_expression(codegen, HYP_AST_AT(node, call.arguments, i));
+    }
+}
+
+/* Call a function or builtin by name, for a call or a pipe */
+static void generate_c_named_call(hyp_codegen_t* codegen, hyp_ast_node_t* node, const char* name) {
+    int index = symbol_table_find(codegen, name);
+    size_t arg_count = node->type == AST_BINARY_OP ? 1 : node->call.arguments.count;
+    
+    if (index >= 0 && codegen->symbols.kinds[index] == HYP_SYMBOL_IMPORT) {
+        generate_c_imported(codegen, node, name);
+        return;
+    }
+    
+    if (index >= 0 && codegen->symbols.kinds[index] == HYP_SYMBOL_FUNCTION) {
+        /* Direct call; missing arguments are null, extra arguments are dropped */
+        size_t arity = codegen->symbols.arities[index];
+        emit_ident(codegen, name);
+        emit_text(codegen, "(");
+        for (size_t i = 0; i < arity; i++) {
+            if (i > 0) emit_text(codegen, ", ");
+            if (i < arg_count) {
+                generate_c_argument(codegen, node, i);
+            } else {
+                emit_text(codegen, "hyprt_null()");
+            }
+        }
+        emit_text(codegen, ")");
+        return;
+    }
+    
+    const char* builtin = index < 0 ? c_builtin_function(name) : NULL;
+    if (!builtin) {
+        hyp_codegen_error(codegen, "line %u: '%s' is not a function", node->line, name);
+        emit_text(codegen, "hyprt_null()");
+        return;
+    }
+    
+    emit_str(codegen, builtin);
+    emit_text(codegen, "(");
+    if (node->type == AST_BINARY_OP) {
+        emit_text(codegen, "(hyprt_value_t[]){");
+        generate_c_argument(codegen, node, 0);
+        emit_text(codegen, "}");
+    } else {
+        generate_c_value_list(codegen, &node->call.arguments);
+    }
+    emit_text(codegen, ", ");
+    emit_size(codegen, arg_count);
+    emit_text(codegen, ")");
+}
+
+static void generate_c_call(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    hyp_ast_node_t* callee = HYP_AST_CHILD(node, call.callee);
+    
+    /* alias.function(...) through `import alias from "module"` */
+    hyp_ast_node_t* object = callee && callee->type == AST_MEMBER_ACCESS ?
+                             HYP_AST_CHILD(callee, member_access.object) : NULL;
+    if (object && object->type == AST_IDENTIFIER) {
+        int index = symbol_table_find(codegen, HYP_AST_TEXT(object, identifier.name));
+        if (index >= 0 && codegen->symbols.kinds[index] == HYP_SYMBOL_IMPORT) {
+            generate_c_imported(codegen, node, HYP_AST_TEXT(object, identifier.name));
+            return;
+        }
+    }
+    
+    if (!callee || callee->type != AST_IDENTIFIER) {
+        generate_c_unsupported(codegen, node, "calls through expressions");
+        return;
+    }
+    
+    generate_c_named_call(codegen, node, HYP_AST_TEXT(callee, identifier.name));
+}
+
+static void generate_c_array(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    emit(codegen, "hyprt_array_of(%zu, ", node->array_literal.elements.count);
+    generate_c_value_list(codegen, &node->array_literal.elements);
+    emit_text(codegen, ")");
+}
+
+static void generate_c_object(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    size_t count = node->object_literal.properties.count;
+    const hyp_object_property_t* properties = HYP_AST_PROPERTIES(&node->object_literal.properties);
+    
+    if (count == 0) {
+        emit_text(codegen, "hyprt_object_of(0, NULL, NULL)");
+        return;
+    }
+    
+    emit(codegen, "hyprt_object_of(%zu, (hyprt_value_t[]){", count);
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) emit_text(codegen, ", ");
+        emit_text(codegen, "hyp_str[");
+        emit_size(codegen, c_literal_index(codegen, hyp_ast_text(&properties[i].key)));
+        emit_text(codegen, "]");
+    }
+    emit_text(codegen, "}, (hyprt_value_t[]){");
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) emit_text(codegen, ", ");
+        generate_c_expression(codegen, hyp_ast_get(&properties[i].value));
+    }
+    emit_text(codegen, "})");
+}
+
+static void generate_c_member(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    emit_text(codegen, "hyprt_get_member(");
+    generate_c_expression(codegen, HYP_AST_CHILD(node, member_access.object));
+    emit_text(codegen, ", hyp_str[");
+    emit_size(codegen, c_literal_index(codegen, HYP_AST_TEXT(node, member_access.member)));
+    emit_text(codegen, "])");
+}
+
+static void generate_c_index(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    emit_text(codegen, "hyprt_get_index(");
+    generate_c_expression(codegen, HYP_AST_CHILD(node, index_access.object));
+    emit_text(codegen, ", ");
+    generate_c_expression(codegen, HYP_AST_CHILD(node, index_access.index));
+    emit_text(codegen, ")");
+}
+
+static void generate_c_conditional(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    emit_text(codegen, "(hyprt_truthy(");
+    generate_c_expression(codegen, HYP_AST_CHILD(node, conditional.condition));
+    emit_text(codegen, ") ? ");
+    generate_c_expression(codegen, HYP_AST_CHILD(node, conditional.then_expr));
+    emit_text(codegen, " : ");
+    generate_c_expression(codegen, HYP_AST_CHILD(node, conditional.else_expr));
+    emit_text(codegen, ")");
+}
+
+/* Right-hand side of an assignment, combining with the old value for `op=` */
+static void generate_c_assigned_value(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    const char* function = NULL;
+    switch (node->assignment.op) {
+        case ASSIGN_ADD: function = "hyprt_add"; break;
+        case ASSIGN_SUB: function = "hyprt_sub"; break;
+        case ASSIGN_MUL: function = "hyprt_mul"; break;
+        case ASSIGN_DIV: function = "hyprt_div"; break;
+        case ASSIGN_MOD: function = "hyprt_mod"; break;
+        case ASSIGN_POW: function = "hyprt_pow"; break;
+        default: break;
+    }
+    
+    if (!function) {
+        generate_c_expression(codegen, HYP_AST_CHILD(node, assignment.value));
+        return;
+    }
+    
+    emit_str(codegen, function);
+    emit_text(codegen, "(");
+    generate_c_expression(codegen, HYP_AST_CHILD(node, assignment.target));
+    emit_text(codegen, ", ");
+    generate_c_expression(codegen, HYP_AST_CHILD(node, assignment.value));
+    emit_text(codegen, ")");
+}
+
+static void generate_c_assignment(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    hyp_ast_node_t* target = HYP_AST_CHILD(node, assignment.target);
+    
+    if (target && target->type == AST_IDENTIFIER) {
+        int index = symbol_table_find(codegen, HYP_AST_TEXT(target, identifier.name));
+        if (index >= 0 && codegen->symbols.kinds[index] == HYP_SYMBOL_IMPORT) {
+            generate_c_imported(codegen, node, HYP_AST_TEXT(target, identifier.name));
+            return;
+        }
+        if (index < 0 || codegen->symbols.kinds[index] == HYP_SYMBOL_FUNCTION) {
+            hyp_codegen_error(codegen, "line %u: assignment to undeclared variable '%s'",
+                              node->line, HYP_AST_TEXT(target, identifier.name));
+            emit_text(codegen, "hyprt_null()");
+            return;
+        }
+        
+        emit_text(codegen, "(");
+        emit_ident(codegen, HYP_AST_TEXT(target, identifier.name));
+        emit_text(codegen, " = ");
+        generate_c_assigned_value(codegen, node);
+        emit_text(codegen, ")");
+        return;
+    }
+    
+    if (!target || (target->type != AST_MEMBER_ACCESS && target->type != AST_INDEX_ACCESS)) {
+        hyp_codegen_error(codegen, "line %u: invalid assignment target", node->line);
+        emit_text(codegen, "hyprt_null()");
+        return;
+    }
+    
+    /* Compound assignment re-reads the container, so it must be side-effect free */
+    hyp_ast_node_t* object = target->type == AST_MEMBER_ACCESS ?
+        HYP_AST_CHILD(target, member_access.object) : HYP_AST_CHILD(target, index_access.object);
+    if (node->assignment.op != ASSIGN_SIMPLE && object->type != AST_IDENTIFIER) {
+        generate_c_unsupported(codegen, node, "compound assignments to computed containers");
+        return;
+    }
+    
+    if (target->type == AST_MEMBER_ACCESS) {
+        emit_text(codegen, "hyprt_set_member(");
+        generate_c_expression(codegen, object);
+        emit_text(codegen, ", hyp_str[");
+        emit_size(codegen, c_literal_index(codegen, HYP_AST_TEXT(target, member_access.member)));
+        emit_text(codegen, "], ");
+    } else {
+        hyp_ast_node_type_t index_type = HYP_AST_CHILD(target, index_access.index)->type;
+        if (node->assignment.op != ASSIGN_SIMPLE &&
+            index_type != AST_IDENTIFIER && index_type != AST_NUMBER && index_type != AST_STRING) {
+            generate_c_unsupported(codegen, node, "compound assignments with computed indices");
+            return;
+        }
+        emit_text(codegen, "hyprt_set_index(");
+        generate_c_expression(codegen, object);
+        emit_text(codegen, ", ");
+        generate_c_expression(codegen, HYP_AST_CHILD(target, index_access.index));
+        emit_text(codegen, ", ");
+    }
+    generate_c_assigned_value(codegen, node);
+    emit_text(codegen, ")");
+}
+
+static void generate_c_expression(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    if (!node) {
+        emit_text(codegen, "hyprt_null()");
+        return;
+    }
+    
+    switch (node->type) {
+        case AST_NUMBER: generate_c_number(codegen, node); break;
+        case AST_STRING: generate_c_string(codegen, node); break;
+        case AST_BOOLEAN: generate_c_boolean(codegen, node); break;
+        case AST_NULL: emit_text(codegen, "hyprt_null()"); break;
+        case AST_IDENTIFIER: generate_c_identifier(codegen, node); break;
+        case AST_BINARY_OP: generate_c_binary(codegen, node); break;
+        case AST_UNARY_OP: generate_c_unary(codegen, node); break;
+        case AST_CALL: generate_c_call(codegen, node); break;
+        case AST_ASSIGNMENT: generate_c_assignment(codegen, node); break;
+        case AST_ARRAY_LITERAL: generate_c_array(codegen, node); break;
+        case AST_OBJECT_LITERAL: generate_c_object(codegen, node); break;
+        case AST_MEMBER_ACCESS: generate_c_member(codegen, node); break;
+        case AST_INDEX_ACCESS: generate_c_index(codegen, node); break;
+        case AST_CONDITIONAL: generate_c_conditional(codegen, node); break;
+        default:
+            hyp_codegen_error(codegen, "line %u: %s expressions are not supported by the C target yet",
+                              node->line, hyp_ast_node_type_name(node->type));
+            emit_text(codegen, "hyprt_null()");
             break;
-        case UNOP_MINUS:
-            emit(codegen, "-");
+    }
+}
+
+/* Emit the statements of a body; blocks open their own symbol scope */
+static void generate_c_body(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    if (!node) return;
+    
+    if (node->type != AST_BLOCK_STMT) {
+        generate_c_statement(codegen, node);
+        return;
+    }
+    
+    size_t scope = codegen->symbols.count;
+    for (size_t i = 0; i < node->block_stmt.statements.count; i++) {
+        generate_c_statement(codegen, HYP_AST_AT(node, block_stmt.statements, i));
+    }
+    codegen->symbols.count = scope;
+}
+
+static void generate_c_var_decl(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    const char* name = HYP_AST_TEXT(node, variable_decl.name);
+    bool is_global = codegen->function_ctx.current_function == NULL;
+    
+    begin_line(codegen);
+    if (is_global) {
+        /* Globals are declared at file scope and initialized in module order */
+        emit_ident(codegen, name);
+        emit_text(codegen, " = ");
+    } else {
+        emit_text(codegen, "hyprt_value_t ");
+        emit_ident(codegen, name);
+        emit_text(codegen, " = ");
+    }
+    
+    if (HYP_AST_CHILD(node, variable_decl.initializer)) {
+        generate_c_expression(codegen, HYP_AST_CHILD(node, variable_decl.initializer));
+    } else {
+        emit_text(codegen, "hyprt_null()");
+    }
+    emit_text(codegen, ";");
+    end_line(codegen);
+    
+    /* Declared after the initializer so `let x = x` sees the outer binding */
+    if (!is_global) {
+        symbol_table_add(codegen, name, NULL, HYP_SYMBOL_LOCAL, 0);
+    }
+}
+
+/* Comparisons with a C bool variant, for conditions that saw only numbers */
+static const char* c_condition_function(hyp_binary_op_t op) {
+    switch (op) {
+        case BINOP_EQ: return "hyprt_eq_bool";
+        case BINOP_NE: return "hyprt_ne_bool";
+        case BINOP_LT: return "hyprt_lt_bool";
+        case BINOP_LE: return "hyprt_le_bool";
+        case BINOP_GT: return "hyprt_gt_bool";
+        case BINOP_GE: return "hyprt_ge_bool";
+        default: return NULL;
+    }
+}
+
+/* Emit a condition as a C boolean. With a profile, biased branches get
+ * hints and numeric comparisons skip boxing their result. `negate` flips
+ * the test, used when the else branch is laid out first. */
+static void generate_c_condition(hyp_codegen_t* codegen, hyp_ast_node_t* condition, int bias, bool negate) {
+    if (bias > 0) emit_text(codegen, "HYPRT_LIKELY(");
+    if (bias < 0) emit_text(codegen, "HYPRT_UNLIKELY(");
+    if (negate) emit_text(codegen, "!");
+    
+    const char* function = NULL;
+    if (condition->type == AST_BINARY_OP &&
+        hyp_profile_operand_types(codegen->profile, condition) == HYP_PROFILE_TYPE_NUMBER) {
+        function = c_condition_function(condition->binary_op.op);
+    }
+    
+    if (function) {
+        emit_str(codegen, function);
+        emit_text(codegen, "(");
+        generate_c_expression(codegen, HYP_AST_CHILD(condition, binary_op.left));
+        emit_text(codegen, ", ");
+        generate_c_expression(codegen, HYP_AST_CHILD(condition, binary_op.right));
+        emit_text(codegen, ")");
+    } else {
+        emit_text(codegen, "hyprt_truthy(");
+        generate_c_expression(codegen, condition);
+        emit_text(codegen, ")");
+    }
+    
+    if (bias != 0) emit_text(codegen, ")");
+}
+
+static void generate_c_if(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    hyp_ast_node_t* then_stmt = HYP_AST_CHILD(node, if_stmt.then_stmt);
+    hyp_ast_node_t* else_stmt = HYP_AST_CHILD(node, if_stmt.else_stmt);
+    int bias = hyp_profile_branch_bias(codegen->profile, node);
+    
+    /* Lay out the hot path first: a rarely taken then-branch with an
+     * else is emitted as `if (likely(!cond)) else-branch else then-branch` */
+    bool invert = bias < 0 && else_stmt;
+    if (invert) {
+        hyp_ast_node_t* swap = then_stmt;
+        then_stmt = else_stmt;
+        else_stmt = swap;
+        bias = 1;
+    }
+    
+    begin_line(codegen);
+    emit_text(codegen, "if (");
+    generate_c_condition(codegen, HYP_AST_CHILD(node, if_stmt.condition), bias, invert);
+    emit_text(codegen, ") {");
+    end_line(codegen);
+    
+    emit_indent(codegen);
+    generate_c_body(codegen, then_stmt);
+    emit_dedent(codegen);
+    
+    if (else_stmt) {
+        emit_line(codegen, "} else {");
+        emit_indent(codegen);
+        generate_c_body(codegen, else_stmt);
+        emit_dedent(codegen);
+    }
+    
+    emit_line(codegen, "}");
+}
+
+static void generate_c_while(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    begin_line(codegen);
+    emit_text(codegen, "while (");
+    generate_c_condition(codegen, HYP_AST_CHILD(node, while_stmt.condition),
+                         hyp_profile_branch_bias(codegen->profile, node), false);
+    emit_text(codegen, ") {");
+    end_line(codegen);
+    
+    bool was_in_loop = codegen->function_ctx.in_loop;
+    codegen->function_ctx.in_loop = true;
+    codegen->function_ctx.loop_depth++;
+    
+    emit_indent(codegen);
+    emit_line(codegen, "hyprt_safepoint();");
+    generate_c_body(codegen, HYP_AST_CHILD(node, while_stmt.body));
+    emit_dedent(codegen);
+    
+    codegen->function_ctx.loop_depth--;
+    codegen->function_ctx.in_loop = was_in_loop;
+    
+    emit_line(codegen, "}");
+}
+
+static void generate_c_return(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    if (!codegen->function_ctx.current_function) {
+        hyp_codegen_error(codegen, "line %u: 'return' outside of a function", node->line);
+        return;
+    }
+    
+    begin_line(codegen);
+    emit_text(codegen, "return ");
+    generate_c_expression(codegen, HYP_AST_CHILD(node, return_stmt.value));
+    emit_text(codegen, ";");
+    end_line(codegen);
+}
+
+static void generate_c_expression_stmt(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    begin_line(codegen);
+    emit_text(codegen, "(void)");
+    generate_c_expression(codegen, HYP_AST_CHILD(node, expression_stmt.expression));
+    emit_text(codegen, ";");
+    end_line(codegen);
+}
+
+static void generate_c_statement(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    if (!node) return;
+    
+    switch (node->type) {
+        case AST_VARIABLE_DECL: generate_c_var_decl(codegen, node); break;
+        case AST_IF_STMT: generate_c_if(codegen, node); break;
+        case AST_WHILE_STMT: generate_c_while(codegen, node); break;
+        case AST_RETURN_STMT: generate_c_return(codegen, node); break;
+        case AST_EXPRESSION_STMT: generate_c_expression_stmt(codegen, node); break;
+        case AST_BLOCK_STMT:
+            emit_line(codegen, "{");
+            emit_indent(codegen);
+            generate_c_body(codegen, node);
+            emit_dedent(codegen);
+            emit_line(codegen, "}");
+            break;
+        case AST_BREAK_STMT:
+            emit_line(codegen, "break;");
+            break;
+        case AST_CONTINUE_STMT:
+            emit_line(codegen, "continue;");
             break;
-        case UNOP_PLUS:
-            emit(codegen, "+");
+        case AST_IMPORT_STMT:
+            /* Modules are compiled separately; imports only order the build */
+            break;
+        case AST_FUNCTION_DECL:
+            hyp_codegen_error(codegen, "line %u: nested function '%s' is not supported by the C target",
+                              node->line, HYP_AST_TEXT(node, function_decl.name));
             break;
         default:
+            hyp_codegen_error(codegen, "line %u: %s statements are not supported by the C target yet",
+                              node->line, hyp_ast_node_type_name(node->type));
             break;
     }
+}
+
+/* Largest function body (in AST nodes) that a profile may mark inline */
+#define HYP_C_INLINE_NODES 64
+
+/* Functions called from themselves are never worth forcing inline */
+static bool c_profile_recursive(const hyp_profile_function_t* function) {
+    for (size_t i = 0; i < function->call_sites.count; i++) {
+        const char* target = function->call_sites.data[i].target;
+        if (target && strcmp(target, function->name) == 0) return true;
+    }
+    return false;
+}
+
+/* Storage class and attributes from the profile: small hot functions are
+ * inlined, functions that never ran are moved out of the hot text */
+static const char* c_function_attributes(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    const hyp_profile_function_t* function = hyp_profile_function(codegen->profile, HYP_AST_TEXT(node, function_decl.name));
+    if (!function) return "static ";
     
-    emit(codegen, "(");
-    hyp_codegen_generate_node(codegen, node->unary_op.operand);
-    emit(codegen, ")");
+    if (function->calls == 0) return "static HYPRT_COLD ";
+    if (function->calls >= HYP_PROFILE_MIN_SAMPLES && function->node_count <= HYP_C_INLINE_NODES &&
+        !c_profile_recursive(function)) {
+        return "static inline HYPRT_HOT ";
+    }
+    if (function->calls >= HYP_PROFILE_MIN_SAMPLES) return "static HYPRT_HOT ";
+    return "static ";
+}
+
+static void generate_c_function_signature(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    emit(codegen, "%shyprt_value_t " HYP_C_PREFIX "%s(", c_function_attributes(codegen, node),
+         HYP_AST_TEXT(node, function_decl.name));
+    
+    if (node->function_decl.parameters.count == 0) {
+        emit_text(codegen, "void");
+    }
+    const hyp_parameter_t* params = HYP_AST_PARAMETERS(&node->function_decl.parameters);
+    for (size_t i = 0; i < node->function_decl.parameters.count; i++) {
+        if (i > 0) emit_text(codegen, ", ");
+        emit_text(codegen, "hyprt_value_t ");
+        emit_ident(codegen, hyp_ast_text(&params[i].name));
+    }
+    
+    emit_text(codegen, ")");
+}
+
+static void generate_c_function(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+    size_t scope = codegen->symbols.count;
+    codegen->function_ctx.current_function = HYP_AST_TEXT(node, function_decl.name);
+    codegen->function_ctx.return_type = NULL;
+    
+    const hyp_parameter_t* params = HYP_AST_PARAMETERS(&node->function_decl.parameters);
+    for (size_t i = 0; i < node->function_decl.parameters.count; i++) {
+        symbol_table_add(codegen, hyp_ast_text(&params[i].name), NULL, HYP_SYMBOL_LOCAL, 0);
+    }
+    
+    generate_c_function_signature(codegen, node);
+    emit_text(codegen, " {\n");
+    emit_indent(codegen);
+    
+    emit_line(codegen, "hyprt_safepoint();");
+    generate_c_body(codegen, HYP_AST_CHILD(node, function_decl.body));
+    emit_line(codegen, "return hyprt_null();");
+    
+    emit_dedent(codegen);
+    emit_line(codegen, "}");
+    emit_line(codegen, "");
+    
+    codegen->function_ctx.current_function = NULL;
+    codegen->function_ctx.return_type = NULL;
+    codegen->symbols.count = scope;
 }
 
+/* Modules with fewer functions are not worth starting threads for */
+#define HYP_C_PARALLEL_MIN_FUNCTIONS 32
 
+/* One function body generated into its own buffer */
+typedef struct {
+    hyp_ast_node_t* function;
+    hyp_out_t output;
+    char* error;
+} c_function_job_t;
 
-static void generate_c_call(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    hyp_codegen_generate_node(codegen, node->call.callee);
-    emit(codegen, "(");
+typedef struct {
+    hyp_codegen_t* workers;
+    c_function_job_t* jobs;
+} c_parallel_t;
+
+/* A worker shares the literal table, global symbols and profile with the
+ * main generator read-only. It owns its output, error state, temporary
+ * count and a copy of the global symbols that locals are pushed onto. */
+static bool c_worker_init(hyp_codegen_t* worker, const hyp_codegen_t* codegen) {
+    *worker = *codegen;
+    worker->is_worker = true;
+    worker->arena = NULL;        /* Arenas are not shared between threads */
+    worker->owns_arena = false;
+    worker->output_text = NULL;
+    worker->temp_max = 0;
+    worker->has_error = false;
+    hyp_out_init(&worker->output, -1);
     
-    for (size_t i = 0; i < node->call.arguments.count; i++) {
-        if (i > 0) emit(codegen, ", ");
-        hyp_codegen_generate_node(codegen, node->call.arguments.data[i]);
+    size_t count = codegen->symbols.count;
+    size_t capacity = count + 16;
+    worker->symbols.names = HYP_MALLOC(capacity * sizeof(char*));
+    worker->symbols.types = HYP_MALLOC(capacity * sizeof(hyp_type_t*));
+    worker->symbols.kinds = HYP_MALLOC(capacity * sizeof(hyp_symbol_kind_t));
+    worker->symbols.arities = HYP_MALLOC(capacity * sizeof(size_t));
+    worker->symbols.capacity = capacity;
+    if (!worker->symbols.names || !worker->symbols.types ||
+        !worker->symbols.kinds || !worker->symbols.arities) {
+        return false;
     }
     
-    emit(codegen, ")");
+    memcpy(worker->symbols.names, codegen->symbols.names, count * sizeof(char*));
+    memcpy(worker->symbols.types, codegen->symbols.types, count * sizeof(hyp_type_t*));
+    memcpy(worker->symbols.kinds, codegen->symbols.kinds, count * sizeof(hyp_symbol_kind_t));
+    memcpy(worker->symbols.arities, codegen->symbols.arities, count * sizeof(size_t));
+    return true;
 }
 
-static void generate_c_assignment(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    hyp_codegen_generate_node(codegen, node->assignment.target);
+static void c_worker_destroy(hyp_codegen_t* worker) {
+    HYP_FREE(worker->symbols.names);
+    HYP_FREE(worker->symbols.types);
+    HYP_FREE(worker->symbols.kinds);
+    HYP_FREE(worker->symbols.arities);
+    hyp_out_destroy(&worker->output);
+}
+
+static void generate_c_function_job(void* context, size_t index, size_t worker) {
+    c_parallel_t* parallel = context;
+    hyp_codegen_t* codegen = &parallel->workers[worker];
+    c_function_job_t* job = &parallel->jobs[index];
     
-    switch (node->assignment.op) {
-        case ASSIGN_SIMPLE: emit(codegen, " = "); break;
-        case ASSIGN_ADD: emit(codegen, " += "); break;
-        case ASSIGN_SUB: emit(codegen, " -= "); break;
-        case ASSIGN_MUL: emit(codegen, " *= "); break;
-        case ASSIGN_DIV: emit(codegen, " /= "); break;
-    }
+    hyp_out_init(&codegen->output, -1);
+    codegen->has_error = false;
+    generate_c_function(codegen, job->function);
     
-    hyp_codegen_generate_node(codegen, node->assignment.value);
+    job->output = codegen->output;
+    hyp_out_init(&codegen->output, -1);
+    if (codegen->has_error) {
+        job->error = hyp_strdup(codegen->error_message);
+    }
 }
 
-static void generate_c_var_decl(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    /* Add to symbol table */
-    symbol_table_add(codegen, node->variable_decl.name, NULL);
+/* Generate function bodies on worker threads and splice the buffers in
+ * source order, so the result is byte-identical to serial generation.
+ * Returns false (having emitted nothing) if the workers cannot be set up. */
+static bool generate_c_functions_parallel(hyp_codegen_t* codegen, const hyp_ast_list_t* statements,
+                                          size_t count, size_t workers) {
+    c_parallel_t parallel;
+    parallel.jobs = HYP_CALLOC(count, sizeof(c_function_job_t));
+    parallel.workers = HYP_CALLOC(workers, sizeof(hyp_codegen_t));
+    if (!parallel.jobs || !parallel.workers) {
+        HYP_FREE(parallel.jobs);
+        HYP_FREE(parallel.workers);
+        return false;
+    }
     
-    if (node->variable_decl.is_const) {
-        emit_line(codegen, "const hyp_value_t %s", node->variable_decl.name);
-    } else {
-        emit_line(codegen, "hyp_value_t %s", node->variable_decl.name);
+    bool ready = true;
+    for (size_t i = 0; i < workers && ready; i++) {
+        ready = c_worker_init(&parallel.workers[i], codegen);
     }
     
-    if (node->variable_decl.initializer) {
-        emit(codegen, " = ");
-        hyp_codegen_generate_node(codegen, node->variable_decl.initializer);
-    } else {
-        emit(codegen, " = hyp_value_null()");
+    if (ready) {
+        size_t job = 0;
+        for (size_t i = 0; i < statements->count; i++) {
+            if (hyp_ast_list_at(statements, i)->type == AST_FUNCTION_DECL) {
+                parallel.jobs[job].function = hyp_ast_list_at(statements, i);
+                hyp_out_init(&parallel.jobs[job].output, -1);
+                job++;
+            }
+        }
+        
+        hyp_parallel_for(count, workers, generate_c_function_job, &parallel);
+        
+        for (size_t i = 0; i < count; i++) {
+            c_function_job_t* job_result = &parallel.jobs[i];
+            hyp_out_append(&codegen->output, &job_result->output);
+            hyp_out_destroy(&job_result->output);
+            if (job_result->error) {
+                hyp_codegen_error(codegen, "%s", job_result->error);
+                HYP_FREE(job_result->error);
+            }
+        }
+        for (size_t i = 0; i < workers; i++) {
+            if (parallel.workers[i].temp_max > codegen->temp_max) {
+                codegen->temp_max = parallel.workers[i].temp_max;
+            }
+        }
     }
     
-    emit(codegen, ";");
+    for (size_t i = 0; i < workers; i++) {
+        c_worker_destroy(&parallel.workers[i]);
+    }
+    HYP_FREE(parallel.workers);
+    HYP_FREE(parallel.jobs);
+    return ready;
 }
 
-static void generate_c_function(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    /* Add to symbol table */
-    symbol_table_add(codegen, node->function_decl.name, NULL);
-    
-    emit_line(codegen, "hyp_value_t %s(", node->function_decl.name);
-    
-    /* Parameters */
-    for (size_t i = 0; i < node->function_decl.parameters.count; i++) {
-        if (i > 0) emit(codegen, ", ");
-        hyp_parameter_t* param = &node->function_decl.parameters.data[i];
-        emit(codegen, "hyp_value_t %s", param->name);
+static void generate_c_functions(hyp_codegen_t* codegen, const hyp_ast_list_t* statements) {
+    size_t count = 0;
+    for (size_t i = 0; i < statements->count; i++) {
+        if (hyp_ast_list_at(statements, i)->type == AST_FUNCTION_DECL) count++;
     }
     
-    emit(codegen, ") {");
-    emit_indent(codegen);
-    
-    /* Function body */
-    codegen->function_ctx.loop_depth++;
-    hyp_codegen_generate_node(codegen, node->function_decl.body);
-    codegen->function_ctx.loop_depth--;
+    size_t workers = codegen->jobs > 1 ? hyp_worker_count(codegen->jobs) : 1;
+    if (workers > 1 && count >= HYP_C_PARALLEL_MIN_FUNCTIONS &&
+        generate_c_functions_parallel(codegen, statements, count, workers)) {
+        return;
+    }
     
-    emit_dedent(codegen);
-    emit_line(codegen, "}");
+    for (size_t i = 0; i < statements->count; i++) {
+        if (hyp_ast_list_at(statements, i)->type == AST_FUNCTION_DECL) {
+            generate_c_function(codegen, hyp_ast_list_at(statements, i));
+        }
+    }
 }
 
-static void generate_c_if(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    emit_line(codegen, "if (hyp_value_is_truthy(");
-    hyp_codegen_generate_node(codegen, node->if_stmt.condition);
-    emit(codegen, ")) {");
+static void generate_c_prelude(hyp_codegen_t* codegen) {
+    codegen->literals.count = 0;
+    codegen->literal_base = 0;
+    codegen->temp_depth = 0;
+    codegen->temp_max = 0;
     
-    emit_indent(codegen);
-    hyp_codegen_generate_node(codegen, node->if_stmt.then_stmt);
-    emit_dedent(codegen);
+    emit_line(codegen, "/* Generated by hypc %s. Do not edit. */", HYP_VERSION_STRING);
+    emit_line(codegen, "#include <stdbool.h>");
+    emit_line(codegen, "#include <stddef.h>");
+    emit_line(codegen, "#include \"hyprt.h\"");
+    emit_line(codegen, "");
     
-    if (node->if_stmt.else_stmt) {
-        emit_line(codegen, "} else {");
-        emit_indent(codegen);
-        hyp_codegen_generate_node(codegen, node->if_stmt.else_stmt);
-        emit_dedent(codegen);
+    /* The literal and temporary tables are only sized once the whole
+     * program has been generated; declaring them incomplete here lets
+     * the output be written front to back without buffering */
+    emit_line(codegen, "hyprt_value_t hyp_str[];");
+    emit_line(codegen, "hyprt_value_t hyp_tmp[];");
+    emit_line(codegen, "");
+}
+
+/* Declare a top-level function or global under the given name */
+static void generate_c_declaration(hyp_codegen_t* codegen, hyp_ast_node_t* stmt, const char* name) {
+    if (stmt->type == AST_FUNCTION_DECL) {
+        symbol_table_add(codegen, name, NULL,
+                         HYP_SYMBOL_FUNCTION, stmt->function_decl.parameters.count);
+        generate_c_function_signature(codegen, stmt);
+        emit_text(codegen, ";\n");
+    } else if (stmt->type == AST_VARIABLE_DECL) {
+        symbol_table_add(codegen, name, NULL, HYP_SYMBOL_GLOBAL, 0);
+        emit_line(codegen, "static hyprt_value_t " HYP_C_PREFIX "%s;", name);
     }
-    
-    emit_line(codegen, "}");
 }
 
-static void generate_c_while(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    emit_line(codegen, "while (hyp_value_is_truthy(");
-    hyp_codegen_generate_node(codegen, node->while_stmt.condition);
-    emit(codegen, ")) {");
-    
-    emit_indent(codegen);
-    hyp_codegen_generate_node(codegen, node->while_stmt.body);
-    emit_dedent(codegen);
-    
-    emit_line(codegen, "}");
+/* Note the names an import brings in, so using one reports the import
+ * rather than an undefined name; copies them to the arena when the
+ * statement does not outlive declaration (streaming) */
+static void declare_c_imports(hyp_codegen_t* codegen, hyp_ast_node_t* stmt, bool copy) {
+    size_t count = stmt->import_stmt.imports.count;
+    for (size_t i = 0; i <= count; i++) {
+        const char* name = i < count ? HYP_AST_TEXT(HYP_AST_AT(stmt, import_stmt.imports, i), identifier.name) :
+                                       HYP_AST_TEXT(stmt, import_stmt.alias);
+        if (!name) continue;
+        
+        char* stored = copy ? hyp_arena_strdup(codegen->arena, name) : (char*)name;
+        if (!stored) {
+            hyp_codegen_error(codegen, "Out of memory while declaring '%s'", name);
+            return;
+        }
+        symbol_table_add(codegen, stored, NULL, HYP_SYMBOL_IMPORT, 0);
+    }
 }
 
-static void generate_c_return(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    emit_line(codegen, "return ");
-    
-    if (node->return_stmt.value) {
-        hyp_codegen_generate_node(codegen, node->return_stmt.value);
-    } else {
-        emit(codegen, "hyp_value_null()");
+/* Intern every literal of a list of top-level statements, functions first */
+static void c_collect_program_literals(hyp_codegen_t* codegen, const hyp_ast_list_t* statements) {
+    for (size_t i = 0; i < statements->count; i++) {
+        if (hyp_ast_list_at(statements, i)->type == AST_FUNCTION_DECL) {
+            c_collect_literals(codegen, hyp_ast_list_at(statements, i));
+        }
+    }
+    for (size_t i = 0; i < statements->count; i++) {
+        if (hyp_ast_list_at(statements, i)->type != AST_FUNCTION_DECL) {
+            c_collect_literals(codegen, hyp_ast_list_at(statements, i));
+        }
     }
-    
-    emit(codegen, ";");
 }
 
-static void generate_c_block(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    codegen->function_ctx.loop_depth++;
-    
-    for (size_t i = 0; i < node->block_stmt.statements.count; i++) {
-        hyp_codegen_generate_node(codegen, node->block_stmt.statements.data[i]);
+/* Statements that build the interned literals of the current table */
+static void generate_c_literal_inits(hyp_codegen_t* codegen) {
+    hyp_arena_mark_t mark = hyp_arena_mark(codegen->arena);
+    for (size_t i = 0; i < codegen->literals.count; i++) {
+        const char* value = codegen->literals.data[i];
+        char* escaped = hyp_arena_alloc(codegen->arena, escape_c_size(value));
+        if (!escaped) {
+            hyp_codegen_error(codegen, "Out of memory while escaping string literal");
+            break;
+        }
+        escape_c_into(escaped, value);
+        begin_line(codegen);
+        emit_text(codegen, "hyp_str[");
+        emit_size(codegen, codegen->literal_base + i);
+        emit_text(codegen, "] = hyprt_string_literal(\"");
+        emit_str(codegen, escaped);
+        emit_text(codegen, "\", ");
+        emit_size(codegen, strlen(value));
+        emit_text(codegen, ");");
+        end_line(codegen);
+        hyp_arena_rewind(codegen->arena, mark);
     }
-    
-    codegen->function_ctx.loop_depth--;
 }
 
-static void generate_c_expression_stmt(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
+static void generate_c_gc_roots(hyp_codegen_t* codegen) {
+    for (size_t i = 0; i < codegen->symbols.count; i++) {
+        if (codegen->symbols.kinds[i] == HYP_SYMBOL_GLOBAL) {
+            emit_line(codegen, "hyprt_gc_root(&" HYP_C_PREFIX "%s);", codegen->symbols.names[i]);
+        }
+    }
+}
+
+static void generate_c_tables(hyp_codegen_t* codegen, size_t literal_count) {
+    emit_line(codegen, "hyprt_value_t hyp_str[%zu];", literal_count > 0 ? literal_count : 1);
+    emit_line(codegen, "hyprt_value_t hyp_tmp[%d];", codegen->temp_max > 0 ? codegen->temp_max : 1);
     emit_line(codegen, "");
-    hyp_codegen_generate_node(codegen, node->expression_stmt.expression);
-    emit(codegen, ";");
+}
+
+/* Process entry point */
+static void generate_c_main(hyp_codegen_t* codegen) {
+    int main_index = symbol_table_find(codegen, "main");
+    bool has_main = main_index >= 0 && codegen->symbols.kinds[main_index] == HYP_SYMBOL_FUNCTION;
+    
+    emit_line(codegen, "int main(int argc, char* argv[]) {");
+    emit_indent(codegen);
+    emit_line(codegen, "hyprt_init(argc, argv, &argc);");
+    emit_line(codegen, "hyp_strings_init();");
+    emit_line(codegen, "hyp_module_init();");
+    if (has_main) {
+        begin_line(codegen);
+        emit(codegen, "return hyprt_shutdown(" HYP_C_PREFIX "main(");
+        for (size_t i = 0; i < codegen->symbols.arities[main_index]; i++) {
+            emit(codegen, i > 0 ? ", hyprt_null()" : "hyprt_null()");
+        }
+        emit_text(codegen, "));");
+        end_line(codegen);
+    } else {
+        emit_line(codegen, "return hyprt_shutdown(hyprt_null());");
+    }
+    emit_dedent(codegen);
+    emit_line(codegen, "}");
 }
 
 static void generate_c_program(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    /* Generate includes */
-    emit_line(codegen, "#include <stdio.h>");
-    emit_line(codegen, "#include <stdlib.h>");
-    emit_line(codegen, "#include <stdbool.h>");
-    emit_line(codegen, "#include <string.h>");
-    emit_line(codegen, "#include \"hyp_runtime.h\"");
+    const hyp_ast_list_t* statements = &node->program.statements;
+    
+    generate_c_prelude(codegen);
+    
+    /* Declare every top-level function and global first so order does not matter */
+    for (size_t i = 0; i < statements->count; i++) {
+        hyp_ast_node_t* stmt = hyp_ast_list_at(statements, i);
+        if (stmt->type == AST_FUNCTION_DECL) {
+            generate_c_declaration(codegen, stmt, HYP_AST_TEXT(stmt, function_decl.name));
+        } else if (stmt->type == AST_VARIABLE_DECL) {
+            generate_c_declaration(codegen, stmt, HYP_AST_TEXT(stmt, variable_decl.name));
+        } else if (stmt->type == AST_IMPORT_STMT) {
+            declare_c_imports(codegen, stmt, false);
+        }
+    }
     emit_line(codegen, "");
     
-    /* Generate statements */
-    for (size_t i = 0; i < node->program.statements.count; i++) {
-        hyp_codegen_generate_node(codegen, node->program.statements.data[i]);
-        emit_line(codegen, "");
+    /* Intern every literal and index the top-level names up front; from
+     * here on both tables are read-only, which lets function bodies be
+     * generated in parallel with the same numbering as a serial run */
+    c_collect_program_literals(codegen, statements);
+    if (!symbol_table_index_globals(codegen)) {
+        hyp_codegen_error(codegen, "Out of memory while indexing symbols");
+        return;
     }
     
-    /* Generate main function if not present */
-    if (!symbol_table_lookup(codegen, "main")) {
-        emit_line(codegen, "int main(int argc, char* argv[]) {");
-        emit_indent(codegen);
-        emit_line(codegen, "hyp_runtime_t* runtime = hyp_runtime_create();");
-        emit_line(codegen, "if (!runtime) return 1;");
-        emit_line(codegen, "");
-        emit_line(codegen, "/* Call user code here */");
-        emit_line(codegen, "");
-        emit_line(codegen, "hyp_runtime_destroy(runtime);");
-        emit_line(codegen, "return 0;");
-        emit_dedent(codegen);
-        emit_line(codegen, "}");
+    /* Function definitions */
+    generate_c_functions(codegen, statements);
+    
+    /* Top-level statements run once, in source order, before main */
+    emit_line(codegen, "static void hyp_module_init(void) {");
+    emit_indent(codegen);
+    generate_c_gc_roots(codegen);
+    for (size_t i = 0; i < statements->count; i++) {
+        if (hyp_ast_list_at(statements, i)->type != AST_FUNCTION_DECL) {
+            generate_c_statement(codegen, hyp_ast_list_at(statements, i));
+        }
     }
+    emit_dedent(codegen);
+    emit_line(codegen, "}");
+    emit_line(codegen, "");
+    
+    generate_c_tables(codegen, codegen->literals.count);
+    
+    /* Intern literals before any user code runs */
+    emit_line(codegen, "static void hyp_strings_init(void) {");
+    emit_indent(codegen);
+    generate_c_literal_inits(codegen);
+    emit_dedent(codegen);
+    emit_line(codegen, "}");
+    emit_line(codegen, "");
+    
+    generate_c_main(codegen);
 }
 
 /* JavaScript code generation */
 static void generate_js_number(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    emit(codegen, "%.17g", node->number.value);
+    emit_number(codegen, node->number.value);
 }
 
 static void generate_js_string(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    emit(codegen, "\"%s\"", node->string.value ? node->string.value : "");
+    emit(codegen, "\"%s\"", HYP_AST_TEXT(node, string.value) ? HYP_AST_TEXT(node, string.value) : "");
 }
 
 static void generate_js_boolean(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
@@ -318,12 +1357,12 @@ static void generate_js_boolean(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
 }
 
 static void generate_js_identifier(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    emit(codegen, "%s", node->identifier.name ? node->identifier.name : "unknown");
+    emit(codegen, "%s", HYP_AST_TEXT(node, identifier.name) ? HYP_AST_TEXT(node, identifier.name) : "unknown");
 }
 
 static void generate_js_binary(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
     emit(codegen, "(");
-    hyp_codegen_generate_node(codegen, node->binary_op.left);
+    hyp_codegen_generate_node(codegen, HYP_AST_CHILD(node, binary_op.left));
     
     switch (node->binary_op.op) {
         case BINOP_ADD: emit(codegen, " + "); break;
@@ -342,25 +1381,25 @@ static void generate_js_binary(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
         default: emit(codegen, " ? "); break;
     }
     
-    hyp_codegen_generate_node(codegen, node->binary_op.right);
+    hyp_codegen_generate_node(codegen, HYP_AST_CHILD(node, binary_op.right));
     emit(codegen, ")");
 }
 
 static void generate_js_function(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
-    emit_line(codegen, "function %s(", node->function_decl.name);
+    emit_line(codegen, "function %s(", HYP_AST_TEXT(node, function_decl.name));
     
     /* Parameters */
+    const hyp_parameter_t* params = HYP_AST_PARAMETERS(&node->function_decl.parameters);
     for (size_t i = 0; i < node->function_decl.parameters.count; i++) {
         if (i > 0) emit(codegen, ", ");
-        hyp_parameter_t* param = &node->function_decl.parameters.data[i];
-        emit(codegen, "%s", param->name);
+        emit(codegen, "%s", hyp_ast_text(&params[i].name));
     }
     
     emit(codegen, ") {");
     emit_indent(codegen);
     
     /* Function body */
-    hyp_codegen_generate_node(codegen, node->function_decl.body);
+    hyp_codegen_generate_node(codegen, HYP_AST_CHILD(node, function_decl.body));
     
     emit_dedent(codegen);
     emit_line(codegen, "}");
@@ -372,61 +1411,32 @@ void hyp_codegen_generate_node(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
     
     switch (codegen->target) {
         case TARGET_C:
-            switch (node->type) {
-                case AST_NUMBER:
-                    emit(codegen, "%.17g", node->number.value);
-                    break;
-                case AST_BINARY_OP:
-                    hyp_codegen_generate_node(codegen, node->binary_op.left);
-                    emit(codegen, " %s ", hyp_binary_op_to_c(node->binary_op.op));
-                    hyp_codegen_generate_node(codegen, node->binary_op.right);
-                    break;
-                case AST_UNARY_OP:
-                    emit(codegen, "%s", hyp_unary_op_to_c(node->unary_op.op));
-                    hyp_codegen_generate_node(codegen, node->unary_op.operand);
-                    break;
-                case AST_IDENTIFIER:
-                    emit(codegen, "%s", node->identifier.name);
-                    break;
-                case AST_STRING:
-                    emit(codegen, "\"%s\"", node->string.value);
-                    break;
-                case AST_BOOLEAN:
-                    emit(codegen, "%s", node->boolean.value ? "true" : "false");
-                    break;
-                case AST_CALL:
-                case AST_ASSIGNMENT:
-                case AST_VARIABLE_DECL:
-                case AST_FUNCTION_DECL:
-                case AST_IF_STMT:
-                case AST_WHILE_STMT:
-                case AST_RETURN_STMT:
-                case AST_BLOCK_STMT:
-                case AST_EXPRESSION_STMT:
-                case AST_PROGRAM:
-                    /* TODO: Implement these cases */
-                    emit(codegen, "/* TODO: %s */", hyp_ast_node_type_name(node->type));
-                    break;
-                default:
-                    break;
+            if (node->type == AST_PROGRAM) {
+                generate_c_program(codegen, node);
+            } else if (node->type == AST_FUNCTION_DECL) {
+                generate_c_function(codegen, node);
+            } else if (node->type >= AST_EXPRESSION_STMT) {
+                generate_c_statement(codegen, node);
+            } else {
+                generate_c_expression(codegen, node);
             }
             break;
             
         case TARGET_JAVASCRIPT:
             switch (node->type) {
                 case AST_NUMBER:
-                    emit(codegen, "%.17g", node->number.value);
+                    emit_number(codegen, node->number.value);
                     break;
                 case AST_BINARY_OP:
-                    hyp_codegen_generate_node(codegen, node->binary_op.left);
+                    hyp_codegen_generate_node(codegen, HYP_AST_CHILD(node, binary_op.left));
                     emit(codegen, " %s ", hyp_binary_op_to_js(node->binary_op.op));
-                    hyp_codegen_generate_node(codegen, node->binary_op.right);
+                    hyp_codegen_generate_node(codegen, HYP_AST_CHILD(node, binary_op.right));
                     break;
                 case AST_IDENTIFIER:
-                    emit(codegen, "%s", node->identifier.name);
+                    emit(codegen, "%s", HYP_AST_TEXT(node, identifier.name));
                     break;
                 case AST_STRING:
-                    emit(codegen, "\"%s\"", node->string.value);
+                    emit(codegen, "\"%s\"", HYP_AST_TEXT(node, string.value));
                     break;
                 case AST_BOOLEAN:
                     emit(codegen, "%s", node->boolean.value ? "true" : "false");
@@ -444,33 +1454,27 @@ void hyp_codegen_generate_node(hyp_codegen_t* codegen, hyp_ast_node_t* node) {
 }
 
 /* Public API */
+static hyp_metric_t metric_generate = HYP_HISTOGRAM("codegen.generate", "Time to generate a module or a streamed batch");
+static hyp_metric_t metric_output = HYP_COUNTER("codegen.output_bytes", "Bytes of code generated");
+static hyp_metric_t metric_failures = HYP_COUNTER("codegen.failures", "Modules whose generation failed");
+
+/* The names themselves live in the arena */
+static void stream_names_free(hyp_codegen_t* codegen) {
+    HYP_ARRAY_FREE(&codegen->stream_names);
+    codegen->stream_inits = 0;
+    codegen->stream_strings = 0;
+    codegen->stream_defining = false;
+}
+
 hyp_codegen_t* hyp_codegen_create(hyp_target_t target, hyp_codegen_options_t* options) {
     hyp_codegen_t* codegen = HYP_MALLOC(sizeof(hyp_codegen_t));
     if (!codegen) return NULL;
     
-    codegen->target = target;
-    if (options) {
-        codegen->optimize = options->optimize;
-        codegen->debug_info = options->debug_info;
-    } else {
-        codegen->optimize = false;
-        codegen->debug_info = false;
-    }
-    codegen->output = hyp_string_create("");
-    codegen->indent_level = 0;
-    codegen->function_ctx.loop_depth = 0;
-    codegen->function_ctx.current_function = NULL;
-    codegen->function_ctx.return_type = NULL;
-    codegen->function_ctx.in_loop = false;
-    
-    codegen->symbols.names = NULL;
-    codegen->symbols.types = NULL;
-    codegen->symbols.count = 0;
-    codegen->symbols.capacity = 0;
+    hyp_codegen_options_t defaults = {0};
+    if (!options) options = &defaults;
+    options->target = target;
     
-    codegen->arena = hyp_arena_create(8192);
-    if (!codegen->arena) {
-        hyp_string_destroy(&codegen->output);
+    if (hyp_codegen_init(codegen, options, NULL) != HYP_OK) {
         HYP_FREE(codegen);
         return NULL;
     }
@@ -481,35 +1485,232 @@ hyp_codegen_t* hyp_codegen_create(hyp_target_t target, hyp_codegen_options_t* op
 void hyp_codegen_destroy(hyp_codegen_t* codegen) {
     if (!codegen) return;
     
-    hyp_string_destroy(&codegen->output);
+    /* Releases the generator's internals; the struct itself belongs to the caller */
+    hyp_out_destroy(&codegen->output);
+    HYP_FREE(codegen->output_text);
+    codegen->output_text = NULL;
+    
+    HYP_FREE(codegen->symbols.names);
+    HYP_FREE(codegen->symbols.types);
+    HYP_FREE(codegen->symbols.kinds);
+    HYP_FREE(codegen->symbols.arities);
+    HYP_ARRAY_FREE(&codegen->literals);
+    HYP_MAP_FREE(&codegen->literal_index);
+    HYP_MAP_FREE(&codegen->global_index);
+    stream_names_free(codegen);
+    codegen->symbols.count = 0;
+    codegen->symbols.capacity = 0;
     
-    if (codegen->arena) {
+    if (codegen->arena && codegen->owns_arena) {
         hyp_arena_destroy(codegen->arena);
     }
-    
-    HYP_FREE(codegen);
+    codegen->arena = NULL;
 }
 
-hyp_error_t hyp_codegen_generate(hyp_codegen_t* codegen, hyp_ast_node_t* ast) {
-    if (!codegen || !ast) return HYP_ERROR_INVALID_ARG;
-    
-    /* Reset output */
-    hyp_string_destroy(&codegen->output);
-    codegen->output = hyp_string_create("");
+/* Start a new output, keeping its destination */
+static void codegen_reset(hyp_codegen_t* codegen) {
+    /* Reset output, keeping the destination */
+    int fd = codegen->output.fd;
+    hyp_out_destroy(&codegen->output);
+    hyp_out_init(&codegen->output, fd);
+    HYP_FREE(codegen->output_text);
+    codegen->output_text = NULL;
     codegen->indent_level = 0;
     codegen->function_ctx.loop_depth = 0;
+    codegen->function_ctx.current_function = NULL;
+    codegen->has_error = false;
+    codegen->error_message[0] = '\0';
     
-    /* Clear symbol table */
+    /* Clear symbol table and name indexes */
     codegen->symbols.count = 0;
+    codegen->global_count = 0;
+    HYP_MAP_FREE(&codegen->literal_index);
+    HYP_MAP_FREE(&codegen->global_index);
+    stream_names_free(codegen);
+    
+    /* A caller's arena is the caller's to clear */
+    if (codegen->owns_arena) hyp_arena_reset(codegen->arena);
+}
+
+/* Flush buffered output to the file, if there is one */
+static hyp_error_t codegen_finish(hyp_codegen_t* codegen) {
+    if (codegen->has_error) {
+        hyp_metric_add(&metric_failures, 1);
+        return HYP_ERROR_SEMANTIC;
+    }
+    
+    if (hyp_out_flush(&codegen->output) != HYP_OK) {
+        hyp_codegen_error(codegen, "Could not write generated code");
+        hyp_metric_add(&metric_failures, 1);
+        return HYP_ERROR_IO;
+    }
+    hyp_metric_add(&metric_output, codegen->output.length);
+    return HYP_OK;
+}
+
+hyp_error_t hyp_codegen_generate(hyp_codegen_t* codegen, hyp_ast_node_t* ast) {
+    if (!codegen || !ast) return HYP_ERROR_INVALID_ARG;
+    
+    double started = hyp_wall_time();
+    codegen_reset(codegen);
     
     /* Generate code */
     hyp_codegen_generate_node(codegen, ast);
     
-    return HYP_OK;
+    /* Push whatever is still buffered to the output file */
+    hyp_error_t result = codegen_finish(codegen);
+    hyp_metric_observe(&metric_generate, hyp_wall_time() - started);
+    return result;
+}
+
+/* Streaming generation. Declarations are emitted in the first pass; in
+ * the second, every batch gets its functions, then its top-level
+ * statements wrapped in hyp_init_<n> and its literals in hyp_strings_<n>
+ * (numbered after those of earlier batches), and the module and string
+ * initializers generated at the end call those in order. */
+hyp_error_t hyp_codegen_stream_begin(hyp_codegen_t* codegen) {
+    if (!codegen) return HYP_ERROR_INVALID_ARG;
+    
+    codegen_reset(codegen);
+    if (codegen->target != TARGET_C) {
+        hyp_codegen_error(codegen, "Streaming compilation supports the C target only");
+        return HYP_ERROR_INVALID_ARG;
+    }
+    
+    generate_c_prelude(codegen);
+    return codegen->has_error ? HYP_ERROR_SEMANTIC : HYP_OK;
+}
+
+hyp_error_t hyp_codegen_stream_declare(hyp_codegen_t* codegen, hyp_ast_node_t* batch) {
+    if (!codegen || !batch || batch->type != AST_PROGRAM) return HYP_ERROR_INVALID_ARG;
+    if (codegen->stream_defining) return HYP_ERROR_INVALID_ARG;
+    
+    const hyp_ast_list_t* statements = &batch->program.statements;
+    for (size_t i = 0; i < statements->count; i++) {
+        hyp_ast_node_t* stmt = hyp_ast_list_at(statements, i);
+        if (stmt->type == AST_IMPORT_STMT) {
+            declare_c_imports(codegen, stmt, true);
+            continue;
+        }
+        const char* name = stmt->type == AST_FUNCTION_DECL ? HYP_AST_TEXT(stmt, function_decl.name) :
+                           stmt->type == AST_VARIABLE_DECL ? HYP_AST_TEXT(stmt, variable_decl.name) : NULL;
+        if (!name) continue;
+        
+        char* copy = hyp_arena_strdup(codegen->arena, name);
+        if (!copy) {
+            hyp_codegen_error(codegen, "Out of memory while declaring '%s'", name);
+            break;
+        }
+        HYP_ARRAY_PUSH(&codegen->stream_names, copy);
+        generate_c_declaration(codegen, stmt, copy);
+    }
+    return codegen->has_error ? HYP_ERROR_SEMANTIC : HYP_OK;
+}
+
+/* Switch from declaring to defining */
+static bool stream_start_definitions(hyp_codegen_t* codegen) {
+    if (codegen->stream_defining) return true;
+    
+    emit_line(codegen, "");
+    codegen->stream_defining = true;
+    if (!symbol_table_index_globals(codegen)) {
+        hyp_codegen_error(codegen, "Out of memory while indexing symbols");
+        return false;
+    }
+    return true;
+}
+
+hyp_error_t hyp_codegen_stream_define(hyp_codegen_t* codegen, hyp_ast_node_t* batch) {
+    if (!codegen || !batch || batch->type != AST_PROGRAM) return HYP_ERROR_INVALID_ARG;
+    if (!stream_start_definitions(codegen)) return HYP_ERROR_MEMORY;
+    
+    double started = hyp_wall_time();
+    const hyp_ast_list_t* statements = &batch->program.statements;
+    
+    /* The literal table only covers this batch */
+    codegen->literals.count = 0;
+    HYP_MAP_FREE(&codegen->literal_index);
+    c_collect_program_literals(codegen, statements);
+    
+    generate_c_functions(codegen, statements);
+    
+    bool has_statements = false;
+    for (size_t i = 0; i < statements->count && !has_statements; i++) {
+        has_statements = hyp_ast_list_at(statements, i)->type != AST_FUNCTION_DECL;
+    }
+    if (has_statements) {
+        emit_line(codegen, "static void hyp_init_%zu(void) {", codegen->stream_inits++);
+        emit_indent(codegen);
+        for (size_t i = 0; i < statements->count; i++) {
+            if (hyp_ast_list_at(statements, i)->type != AST_FUNCTION_DECL) {
+                generate_c_statement(codegen, hyp_ast_list_at(statements, i));
+            }
+        }
+        emit_dedent(codegen);
+        emit_line(codegen, "}");
+        emit_line(codegen, "");
+    }
+    
+    if (codegen->literals.count > 0) {
+        emit_line(codegen, "static void hyp_strings_%zu(void) {", codegen->stream_strings++);
+        emit_indent(codegen);
+        generate_c_literal_inits(codegen);
+        emit_dedent(codegen);
+        emit_line(codegen, "}");
+        emit_line(codegen, "");
+        codegen->literal_base += codegen->literals.count;
+    }
+    
+    /* The literals point into the batch, which the caller frees next */
+    codegen->literals.count = 0;
+    HYP_MAP_FREE(&codegen->literal_index);
+    
+    hyp_metric_observe(&metric_generate, hyp_wall_time() - started);
+    return codegen->has_error ? HYP_ERROR_SEMANTIC : HYP_OK;
+}
+
+hyp_error_t hyp_codegen_stream_end(hyp_codegen_t* codegen) {
+    if (!codegen) return HYP_ERROR_INVALID_ARG;
+    if (!stream_start_definitions(codegen)) return HYP_ERROR_MEMORY;
+    
+    emit_line(codegen, "static void hyp_module_init(void) {");
+    emit_indent(codegen);
+    generate_c_gc_roots(codegen);
+    for (size_t i = 0; i < codegen->stream_inits; i++) {
+        emit_line(codegen, "hyp_init_%zu();", i);
+    }
+    emit_dedent(codegen);
+    emit_line(codegen, "}");
+    emit_line(codegen, "");
+    
+    generate_c_tables(codegen, codegen->literal_base);
+    
+    emit_line(codegen, "static void hyp_strings_init(void) {");
+    emit_indent(codegen);
+    for (size_t i = 0; i < codegen->stream_strings; i++) {
+        emit_line(codegen, "hyp_strings_%zu();", i);
+    }
+    emit_dedent(codegen);
+    emit_line(codegen, "}");
+    emit_line(codegen, "");
+    
+    generate_c_main(codegen);
+    return codegen_finish(codegen);
 }
 
 const char* hyp_codegen_get_output(hyp_codegen_t* codegen) {
-    return codegen ? codegen->output.data : NULL;
+    if (!codegen || codegen->output.fd >= 0) return NULL;
+    
+    /* Joined lazily; most callers stream or write the chunks directly */
+    if (!codegen->output_text) {
+        codegen->output_text = hyp_out_to_string(&codegen->output, NULL);
+    }
+    return codegen->output_text;
+}
+
+void hyp_codegen_set_output_fd(hyp_codegen_t* codegen, int fd) {
+    if (!codegen) return;
+    codegen->output.fd = fd;
 }
 
 size_t hyp_codegen_get_output_length(hyp_codegen_t* codegen) {
@@ -531,26 +1732,92 @@ const char* hyp_target_name(hyp_target_t target) {
 hyp_error_t hyp_codegen_write_to_file(hyp_codegen_t* codegen, const char* filename) {
     if (!codegen || !filename) return HYP_ERROR_INVALID_ARG;
     
-    return hyp_write_file(filename, codegen->output.data, codegen->output.length);
+    FILE* file = fopen(filename, "wb");
+    if (!file) return HYP_ERROR_IO;
+    
+    bool ok = true;
+    for (hyp_out_chunk_t* chunk = codegen->output.head; chunk && ok; chunk = chunk->next) {
+        ok = fwrite(chunk->data, 1, chunk->length, file) == chunk->length;
+    }
+    if (fclose(file) != 0) ok = false;
+    
+    return ok ? HYP_OK : HYP_ERROR_IO;
 }
 
 /* Initialize code generator */
-hyp_error_t hyp_codegen_init(hyp_codegen_t* codegen, hyp_target_t target) {
-    if (!codegen) return HYP_ERROR_INVALID_ARG;
+hyp_error_t hyp_codegen_init(hyp_codegen_t* codegen, const hyp_codegen_options_t* options, hyp_arena_t* arena) {
+    if (!codegen || !options) return HYP_ERROR_INVALID_ARG;
     
     memset(codegen, 0, sizeof(hyp_codegen_t));
-    codegen->target = target;
-    codegen->indent_level = 0;
-    codegen->symbols.capacity = 0;
-    codegen->symbols.count = 0;
-    codegen->symbols.names = NULL;
-    codegen->symbols.types = NULL;
+    codegen->target = options->target;
+    codegen->optimize = options->optimize;
+    codegen->debug_info = options->debug_info;
+    codegen->profile = options->optimize ? options->profile : NULL;
+    codegen->jobs = options->jobs;
+    
+    codegen->arena = arena;
+    if (!codegen->arena) {
+        codegen->arena = hyp_arena_create(8192);
+        if (!codegen->arena) return HYP_ERROR_MEMORY;
+        codegen->owns_arena = true;
+    }
     
-    codegen->output = hyp_string_create("");
+    hyp_out_init(&codegen->output, -1);
     
     return HYP_OK;
 }
 
+void hyp_codegen_error(hyp_codegen_t* codegen, const char* format, ...) {
+    if (!codegen) return;
+    
+    /* Keep the first error; later ones are usually consequences of it */
+    if (codegen->has_error) return;
+    
+    va_list args;
+    va_start(args, format);
+    vsnprintf(codegen->error_message, sizeof(codegen->error_message), format, args);
+    va_end(args);
+    
+    codegen->has_error = true;
+}
+
+/* Escape a string for use inside a C string literal, into room for
+ * escape_c_size(str) bytes */
+static size_t escape_c_size(const char* str) {
+    /* Worst case every byte becomes a 4-character octal escape */
+    return strlen(str) * 4 + 1;
+}
+
+static void escape_c_into(char* result, const char* str) {
+    char* out = result;
+    for (const unsigned char* p = (const unsigned char*)str; *p; p++) {
+        switch (*p) {
+            case '\\': *out++ = '\\'; *out++ = '\\'; break;
+            case '"':  *out++ = '\\'; *out++ = '"'; break;
+            case '\n': *out++ = '\\'; *out++ = 'n'; break;
+            case '\t': *out++ = '\\'; *out++ = 't'; break;
+            case '\r': *out++ = '\\'; *out++ = 'r'; break;
+            case '?':  *out++ = '\\'; *out++ = '?'; break;  /* Avoid trigraphs */
+            default:
+                if (*p < 0x20 || *p == 0x7f) {
+                    out += sprintf(out, "\\%03o", *p);
+                } else {
+                    *out++ = (char)*p;
+                }
+                break;
+        }
+    }
+    *out = '\0';
+}
+
+char* hyp_escape_string_c(const char* str) {
+    if (!str) return NULL;
+    
+    char* result = HYP_MALLOC(escape_c_size(str));
+    if (result) escape_c_into(result, str);
+    return result;
+}
+
 /* Get AST node type name */
 const char* hyp_ast_node_type_name(hyp_ast_node_type_t type) {
     switch (type) {
@@ -619,6 +1886,7 @@ const char* hyp_binary_op_to_js(hyp_binary_op_t op) {
         case BINOP_MUL: return "*";
         case BINOP_DIV: return "/";
         case BINOP_MOD: return "%";
+        case BINOP_POW: return "**";
         case BINOP_EQ: return "===";
         case BINOP_NE: return "!==";
         case BINOP_LT: return "<";
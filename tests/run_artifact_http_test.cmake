@@ -0,0 +1,100 @@
+# Build a project through an HTTP artifact cache served by a stand-in
+# server, and check stores, hits, misses, and responses that are cut
+# off, damaged or refused. The server runs as the first command of a
+# pipeline, so it lives exactly as long as this test; the client side
+# (this script again, with CLIENT set) waits for its port, builds, and
+# stops the server whatever happened.
+#
+#   HYPC      The compiler
+#   SERVER    The stand-in server (tests/tools/artifact_server.c)
+#   PROJECT   Project to copy into WORK_DIR and build
+#   WORK_DIR  Directory to build in (created)
+
+set(port_file "${WORK_DIR}/port")
+
+if(NOT CLIENT)
+    file(REMOVE_RECURSE "${WORK_DIR}")
+    file(MAKE_DIRECTORY "${WORK_DIR}")
+    file(COPY "${PROJECT}/" DESTINATION "${WORK_DIR}")
+    execute_process(
+        COMMAND "${SERVER}" "${port_file}"
+        COMMAND "${CMAKE_COMMAND}" -DCLIENT=ON -DHYPC=${HYPC} -DWORK_DIR=${WORK_DIR}
+                -P "${CMAKE_CURRENT_LIST_FILE}"
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULTS_VARIABLE statuses
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE output
+        TIMEOUT 60
+    )
+    list(GET statuses 1 client_status)
+    if(NOT client_status EQUAL 0)
+        message(FATAL_ERROR "${output}")
+    endif()
+    return()
+endif()
+
+foreach(attempt RANGE 100)
+    if(EXISTS "${port_file}")
+        break()
+    endif()
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E sleep 0.1)
+endforeach()
+file(READ "${port_file}" port)
+set(server "http://127.0.0.1:${port}")
+
+# Build with --force through the server under one behaviour, and check
+# the summary; failures are collected so the server is always stopped
+set(failures "")
+function(build_expect run behaviour pattern)
+    execute_process(
+        COMMAND "${HYPC}" build --force --artifact-cache "${server}/${behaviour}" .
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE status
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE output
+    )
+    if(NOT status EQUAL 0 OR NOT output MATCHES "${pattern}")
+        set(failures "${failures}${run}: exit status ${status}, output does not match '${pattern}'\n${output}\n"
+            PARENT_SCOPE)
+    endif()
+    set(output "${output}" PARENT_SCOPE)
+endfunction()
+
+function(expect_compiled run)
+    file(READ "${WORK_DIR}/build/main.c" recompiled)
+    if(output MATCHES "from cache" OR NOT recompiled STREQUAL compiled)
+        set(failures "${failures}${run}: the response was used\n${output}\n" PARENT_SCOPE)
+    endif()
+endfunction()
+
+# Miss, then store
+build_expect("Miss" store "Compiled 1 of 1 modules into")
+if(output MATCHES "from cache|warning")
+    set(failures "${failures}Miss: unexpected cache result\n${output}\n")
+endif()
+file(READ "${WORK_DIR}/build/main.c" compiled)
+
+# Hit
+build_expect("Hit" store "\\(1 from cache\\)")
+
+# A body shorter than its Content-Length is a failed request, caught
+# before the entry is even verified
+build_expect("Truncated" truncate "the artifact cache failed 1 request")
+if(output MATCHES "failed verification")
+    set(failures "${failures}Truncated: the cut-off body was read as an entry\n${output}\n")
+endif()
+expect_compiled("Truncated")
+
+# A damaged body fails verification
+build_expect("Corrupt" corrupt "1 artifact cache entry failed verification")
+expect_compiled("Corrupt")
+
+# A server error is a failed request, and the build goes on without it
+build_expect("Failed" fail "the artifact cache failed [0-9]+ requests?")
+expect_compiled("Failed")
+
+file(DOWNLOAD "${server}/quit" "${WORK_DIR}/quit" STATUS quit_status)
+
+if(failures)
+    message(FATAL_ERROR "${failures}")
+endif()
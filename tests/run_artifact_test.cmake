@@ -0,0 +1,53 @@
+# Build a project through a directory artifact cache and check that a
+# damaged entry is rejected and recompiled rather than used.
+#
+#   HYPC      The compiler
+#   PROJECT   Project to copy into WORK_DIR and build
+#   WORK_DIR  Directory to build in (created)
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(COPY "${PROJECT}/" DESTINATION "${WORK_DIR}")
+
+# Build with --force, so every run goes to the cache, and check the summary
+function(build_expect run pattern)
+    execute_process(
+        COMMAND "${HYPC}" build --force --artifact-cache cache .
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE status
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE output
+    )
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "${run}: exit status ${status}\n${output}")
+    endif()
+    if(NOT output MATCHES "${pattern}")
+        message(FATAL_ERROR "${run}: output does not match '${pattern}'\n${output}")
+    endif()
+    set(output "${output}" PARENT_SCOPE)
+endfunction()
+
+build_expect("Compile" "Compiled 1 of 1 modules into")
+file(READ "${WORK_DIR}/build/main.c" compiled)
+build_expect("Fetch" "\\(1 from cache\\)")
+
+file(GLOB entries "${WORK_DIR}/cache/*/*")
+list(LENGTH entries count)
+if(NOT count EQUAL 1)
+    message(FATAL_ERROR "Expected one cache entry, found ${count}: ${entries}")
+endif()
+file(READ "${entries}" entry)
+string(REPLACE "cached" "CACHED" entry "${entry}")
+file(WRITE "${entries}" "${entry}")
+
+build_expect("Damaged" "Compiled 1 of 1 modules into")
+if(output MATCHES "from cache" OR NOT output MATCHES "1 artifact cache entry failed verification")
+    message(FATAL_ERROR "Damaged: the entry was not rejected\n${output}")
+endif()
+file(READ "${WORK_DIR}/build/main.c" recompiled)
+if(NOT recompiled STREQUAL compiled)
+    message(FATAL_ERROR "Damaged: output differs from the first build")
+endif()
+
+# The recompiled unit replaced the entry
+build_expect("Restored" "\\(1 from cache\\)")
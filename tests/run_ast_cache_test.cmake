@@ -0,0 +1,60 @@
+# Run a program whose syntax tree was cached, after damaging the cached
+# entry, and check that the entry is parsed again rather than used.
+#
+#   HYPRUN    The interpreter
+#   DAMAGE    Tool inverting one byte of a file
+#   INPUT     Program to run
+#   EXPECTED  File holding its expected output
+#   WORK_DIR  Directory to run in (created); XDG_CACHE_HOME should point
+#             into it, and the cache must land there, not in WORK_DIR
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(READ "${EXPECTED}" expected)
+
+function(run_expect run)
+    execute_process(
+        COMMAND "${HYPRUN}" --interpret "${INPUT}"
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE status
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE output
+    )
+    if(NOT status EQUAL 0 OR NOT output STREQUAL expected)
+        message(FATAL_ERROR "${run}: exit status ${status}\n--- expected\n${expected}--- actual\n${output}")
+    endif()
+endfunction()
+
+run_expect("Parse")
+if(EXISTS "${WORK_DIR}/.hypkg")
+    message(FATAL_ERROR "The cache was written into the working directory")
+endif()
+file(GLOB entries "$ENV{XDG_CACHE_HOME}/hyper/ast/*.ast")
+list(LENGTH entries count)
+if(NOT count EQUAL 1)
+    message(FATAL_ERROR "Expected one cache entry, found ${count}: ${entries}")
+endif()
+execute_process(COMMAND "${CMAKE_COMMAND}" -E copy "${entries}" "${WORK_DIR}/intact.ast")
+
+# Each of these is a different byte of the tree behind the 64-byte
+# header: the root's line number, a node further in, the last byte
+foreach(offset 68 200 -1)
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E copy "${WORK_DIR}/intact.ast" "${entries}")
+    if(offset LESS 0)
+        file(SIZE "${entries}" size)
+        math(EXPR offset "${size} + ${offset}")
+    endif()
+    execute_process(COMMAND "${DAMAGE}" "${entries}" ${offset} RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "Could not damage ${entries}")
+    endif()
+
+    run_expect("Damaged at ${offset}")
+
+    # The damaged entry was replaced by a fresh one
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${entries}" "${WORK_DIR}/intact.ast"
+                    RESULT_VARIABLE different)
+    if(different)
+        message(FATAL_ERROR "Damaged at ${offset}: the entry was not replaced")
+    endif()
+endforeach()
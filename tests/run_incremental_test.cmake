@@ -0,0 +1,61 @@
+# Build a project, then change it one step at a time and check that
+# each rebuild compiles exactly the modules the change reaches.
+#
+#   HYPC      The compiler
+#   PROJECT   Project to copy into WORK_DIR and build (main imports util;
+#             other stands alone)
+#   WORK_DIR  Directory to build in (created)
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(COPY "${PROJECT}/" DESTINATION "${WORK_DIR}")
+
+# Build without the artifact cache, so only the build database decides
+function(build_expect run pattern)
+    execute_process(
+        COMMAND "${HYPC}" build --artifact-cache "" .
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE status
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE output
+    )
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "${run}: exit status ${status}\n${output}")
+    endif()
+    if(NOT output MATCHES "${pattern}")
+        message(FATAL_ERROR "${run}: output does not match '${pattern}'\n${output}")
+    endif()
+endfunction()
+
+build_expect("Full build" "Compiled 3 of 3 modules into")
+file(READ "${WORK_DIR}/build/main.c" main_c)
+
+build_expect("No-op rebuild" "Compiled 0 of 3 modules \\(3 up to date\\)")
+
+# Sources are compared by content, not by time
+file(TOUCH "${WORK_DIR}/src/other.hxp")
+build_expect("Touched" "Compiled 0 of 3 modules \\(3 up to date\\)")
+
+file(WRITE "${WORK_DIR}/src/other.hxp" "fn other() { return 2; }\n")
+build_expect("Edited" "Compiled 1 of 3 modules \\(2 up to date\\)")
+file(READ "${WORK_DIR}/build/other.c" other_c)
+if(NOT other_c MATCHES "hyprt_number\\(2\\)|return 2")
+    message(FATAL_ERROR "Edited: build/other.c was not regenerated\n${other_c}")
+endif()
+
+# A body-only change to util leaves main alone; a new parameter does not
+file(WRITE "${WORK_DIR}/src/util.hxp" "fn twice(x) { return x + x; }\n")
+build_expect("Body changed" "Compiled 1 of 3 modules \\(2 up to date\\)")
+file(WRITE "${WORK_DIR}/src/util.hxp" "fn twice(x, y) { return x * 2; }\n")
+build_expect("Interface changed" "Compiled 2 of 3 modules \\(1 up to date\\)")
+file(READ "${WORK_DIR}/build/main.c" rebuilt_main_c)
+if(NOT rebuilt_main_c STREQUAL main_c)
+    message(FATAL_ERROR "Interface changed: main.c differs from the first build")
+endif()
+
+# A missing output is written again
+file(REMOVE "${WORK_DIR}/build/other.c")
+build_expect("Output removed" "Compiled 1 of 3 modules \\(2 up to date\\)")
+if(NOT EXISTS "${WORK_DIR}/build/other.c")
+    message(FATAL_ERROR "Output removed: build/other.c was not written again")
+endif()
@@ -0,0 +1,67 @@
+# Compile a generated module serially and on several threads, and check
+# that both runs print the same messages, exit the same way and write
+# byte-identical C. The module is large enough to be generated and
+# parsed in parallel; --force keeps the AST cache from standing in for
+# the parser.
+#
+#   HYPC      The compiler
+#   WORK_DIR  Directory to compile in (created)
+#   ERRORS    none, codegen (undefined names in several functions) or
+#             syntax (malformed statements spread through the file)
+#   JOBS      Threads for the parallel run (default 8)
+
+if(NOT DEFINED JOBS)
+    set(JOBS 8)
+endif()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+# About 60k tokens: past the parallel parser's minimum several times over
+set(source "// Generated by run_jobs_test.cmake\nlet total = 0;\n")
+foreach(i RANGE 1 3000)
+    string(APPEND source
+        "fn f${i}(x, y) {\n"
+        "    let s = \"item ${i}\";\n"
+        "    if (x > ${i}) { return x + y * ${i}.5; }\n"
+        "    return s + (x - y);\n"
+        "}\n")
+    math(EXPR every_500 "${i} % 500")
+    if(every_500 EQUAL 0 AND ERRORS STREQUAL "codegen")
+        string(APPEND source "fn broken${i}() { return missing${i} + 1; }\n")
+    elseif(every_500 EQUAL 0 AND ERRORS STREQUAL "syntax")
+        string(APPEND source "let = ${i};\nfn (a, { return; }\n")
+    endif()
+endforeach()
+string(APPEND source "fn main() {\n    print(f1(2, 3), f3000(4000, 1));\n    return 0;\n}\n")
+file(WRITE "${WORK_DIR}/module.hxp" "${source}")
+
+foreach(jobs 1 ${JOBS})
+    execute_process(
+        COMMAND "${HYPC}" --force -j ${jobs} module.hxp -o module_${jobs}.c
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE status_${jobs}
+        OUTPUT_VARIABLE output_${jobs}
+        ERROR_VARIABLE output_${jobs}
+    )
+endforeach()
+
+if(ERRORS STREQUAL "none" AND NOT status_1 EQUAL 0)
+    message(FATAL_ERROR "Serial run: exit status ${status_1}\n${output_1}")
+endif()
+if(NOT ERRORS STREQUAL "none" AND status_1 EQUAL 0)
+    message(FATAL_ERROR "Serial run: the errors were not reported\n${output_1}")
+endif()
+if(NOT status_1 STREQUAL status_${JOBS} OR NOT output_1 STREQUAL output_${JOBS})
+    message(FATAL_ERROR "-j 1 and -j ${JOBS} differ:\n"
+                        "--- -j 1 (exit status ${status_1})\n${output_1}"
+                        "--- -j ${JOBS} (exit status ${status_${JOBS}})\n${output_${JOBS}}")
+endif()
+
+if(ERRORS STREQUAL "none")
+    file(READ "${WORK_DIR}/module_1.c" serial)
+    file(READ "${WORK_DIR}/module_${JOBS}.c" parallel)
+    if(NOT serial STREQUAL parallel)
+        message(FATAL_ERROR "-j 1 and -j ${JOBS} generated different C")
+    endif()
+endif()
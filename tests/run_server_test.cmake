@@ -0,0 +1,54 @@
+# Compile a file through a compiler server and check what the client
+# printed. The server runs as the first command of a pipeline, so it
+# lives exactly as long as this test; the client side (this script
+# again, with CLIENT set) waits for the socket, compiles, and shuts the
+# server down whatever happened.
+#
+#   HYPC      Path of hypc
+#   INPUT     File to compile
+#   WORK_DIR  Directory to run in (created)
+#   EXPECTED  File holding the client's expected output
+
+set(socket "${WORK_DIR}/hypc.sock")
+
+if(NOT CLIENT)
+    file(REMOVE_RECURSE "${WORK_DIR}")
+    file(MAKE_DIRECTORY "${WORK_DIR}")
+    execute_process(
+        COMMAND "${HYPC}" --server --socket "${socket}"
+        COMMAND "${CMAKE_COMMAND}" -DCLIENT=ON -DHYPC=${HYPC} -DINPUT=${INPUT}
+                -DWORK_DIR=${WORK_DIR} -DEXPECTED=${EXPECTED} -P "${CMAKE_CURRENT_LIST_FILE}"
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULTS_VARIABLE statuses
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE output
+        TIMEOUT 60
+    )
+    list(GET statuses 1 client_status)
+    if(NOT client_status EQUAL 0)
+        message(FATAL_ERROR "${output}")
+    endif()
+    return()
+endif()
+
+foreach(attempt RANGE 100)
+    if(EXISTS "${socket}")
+        break()
+    endif()
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E sleep 0.1)
+endforeach()
+
+execute_process(
+    COMMAND "${HYPC}" --client --socket "${socket}" "${INPUT}" -o out.c
+    WORKING_DIRECTORY "${WORK_DIR}"
+    RESULT_VARIABLE status
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output
+)
+execute_process(COMMAND "${HYPC}" --server-stop --socket "${socket}" WORKING_DIRECTORY "${WORK_DIR}")
+
+file(READ "${EXPECTED}" expected)
+if(NOT output STREQUAL expected)
+    message(FATAL_ERROR "Client output differs from ${EXPECTED}\n"
+                        "--- expected\n${expected}--- actual (exit status ${status})\n${output}")
+endif()
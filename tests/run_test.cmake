@@ -0,0 +1,47 @@
+# Run one test command and check what it did.
+#
+#   COMMAND      The command, its arguments separated by '|'
+#   WORK_DIR     Directory to run it in (created; caches land here)
+#   EXIT_STATUS  Expected exit status (default 0)
+#   EXPECTED     File holding the expected output, stdout and stderr
+#                together (optional)
+#   MATCH        Regular expression the output must contain (optional)
+#   REPEAT       Run the command this many times, checking each run
+#                (default 1; a second run exercises the on-disk caches)
+
+string(REPLACE "|" ";" COMMAND "${COMMAND}")
+if(NOT DEFINED EXIT_STATUS)
+    set(EXIT_STATUS 0)
+endif()
+if(NOT DEFINED REPEAT)
+    set(REPEAT 1)
+endif()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+foreach(run RANGE 1 ${REPEAT})
+    execute_process(
+        COMMAND ${COMMAND}
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE status
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE output
+    )
+
+    if(NOT "${status}" STREQUAL "${EXIT_STATUS}")
+        message(FATAL_ERROR "Run ${run}: exit status ${status}, expected ${EXIT_STATUS}\n${output}")
+    endif()
+
+    if(DEFINED EXPECTED)
+        file(READ "${EXPECTED}" expected)
+        if(NOT output STREQUAL expected)
+            message(FATAL_ERROR "Run ${run}: output differs from ${EXPECTED}\n"
+                                "--- expected\n${expected}--- actual\n${output}")
+        endif()
+    endif()
+
+    if(DEFINED MATCH AND NOT output MATCHES "${MATCH}")
+        message(FATAL_ERROR "Run ${run}: output does not match '${MATCH}'\n${output}")
+    endif()
+endforeach()
@@ -0,0 +1,204 @@
+/**
+ * Run the allocator $HYP_ALLOCATOR picks through random allocations,
+ * zeroed allocations, reallocs and frees charged to every subsystem, then
+ * through blocks made on worker threads and freed on the main one. Every
+ * block must be aligned and keep its contents, and when the allocator
+ * counts, the per-subsystem figures must match what was done and come
+ * back to where they started once everything is freed.
+ *
+ * Usage: hyp_allocators (with HYP_ALLOCATOR and HYP_MEM_REPORT as wanted)
+ */
+
+#include "../../include/hyp_common.h"
+#include "../../include/hyp_thread.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BLOCKS 4000
+#define THREAD_TASKS 8
+#define THREAD_BLOCKS 2000
+
+/* Blocks are aligned for any type */
+#define BLOCK_ALIGN 16
+
+typedef struct {
+    unsigned char* data;
+    size_t size;
+    hyp_mem_tag_t tag;
+    unsigned char fill;
+} block_t;
+
+static block_t blocks[BLOCKS];
+static block_t* thread_blocks[THREAD_TASKS];
+
+/* What the counts should show, per subsystem */
+static hyp_mem_counts_t model[HYP_MEM_TAG_COUNT];
+static hyp_mem_stats_t start;
+static bool counted;
+
+static size_t failures;
+static unsigned seed = 77;
+
+static void fail(const char* what, size_t step) {
+    if (failures++ < 20) printf("step %zu: %s\n", step, what);
+}
+
+static unsigned next_random(void) {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/* Mostly small blocks across the slab classes, some larger than any */
+static size_t random_size(void) {
+    unsigned kind = next_random() % 100;
+    if (kind < 70) return 1 + next_random() % 256;
+    if (kind < 97) return 1 + next_random() % 5000;
+    return 4096 + next_random() % 200000;
+}
+
+static bool holds(const block_t* block, unsigned char fill, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (block->data[i] != fill) return false;
+    }
+    return true;
+}
+
+static void check_counts(size_t step) {
+    if (!counted) return;
+
+    hyp_mem_stats_t stats;
+    hyp_mem_stats(&stats);
+    for (int tag = 0; tag < HYP_MEM_TAG_COUNT; tag++) {
+        const hyp_mem_counts_t* now = &stats.tags[tag];
+        const hyp_mem_counts_t* before = &start.tags[tag];
+        if (now->allocations - before->allocations != model[tag].allocations ||
+            now->reallocs - before->reallocs != model[tag].reallocs ||
+            now->frees - before->frees != model[tag].frees ||
+            now->bytes - before->bytes != model[tag].bytes ||
+            now->live - before->live != model[tag].live) {
+            fail(hyp_mem_tag_name((hyp_mem_tag_t)tag), step);
+        }
+        if (now->peak < now->live) fail("peak below live", step);
+    }
+}
+
+/* One random operation on a random slot */
+static void step_once(size_t step) {
+    block_t* block = &blocks[next_random() % BLOCKS];
+    unsigned op = next_random() % 4;
+
+    if (!block->data) {
+        hyp_mem_tag_t tag = (hyp_mem_tag_t)(next_random() % HYP_MEM_TAG_COUNT);
+        size_t size = random_size();
+        bool zeroed = op == 0;
+        block->data = zeroed ? hyp_mem_calloc(1, size, tag) : hyp_mem_alloc(size, tag);
+        if (!block->data) {
+            fail("allocation failed", step);
+            return;
+        }
+        if ((uintptr_t)block->data % BLOCK_ALIGN != 0) fail("misaligned block", step);
+        if (zeroed && !holds(block, 0, size)) fail("calloc did not zero", step);
+
+        block->size = size;
+        block->tag = tag;
+        block->fill = (unsigned char)(1 + step % 255);
+        memset(block->data, block->fill, size);
+        model[tag].allocations++;
+        model[tag].bytes += size;
+        model[tag].live += size;
+    } else if (op == 0) {
+        /* Grown or shrunk, the block stays with the subsystem that made
+         * it; only growth counts as bytes asked for */
+        size_t size = random_size();
+        size_t kept = size < block->size ? size : block->size;
+        unsigned char* data = hyp_mem_realloc(block->data, size, (hyp_mem_tag_t)(next_random() % HYP_MEM_TAG_COUNT));
+        if (!data) {
+            fail("realloc failed", step);
+            return;
+        }
+        block->data = data;
+        if ((uintptr_t)data % BLOCK_ALIGN != 0) fail("misaligned block", step);
+        if (!holds(block, block->fill, kept)) fail("realloc lost the contents", step);
+
+        model[block->tag].reallocs++;
+        if (size > block->size) model[block->tag].bytes += size - block->size;
+        model[block->tag].live += size;
+        model[block->tag].live -= block->size;
+        block->size = size;
+        memset(block->data, block->fill, size);
+    } else {
+        if (!holds(block, block->fill, block->size)) fail("a block was overwritten", step);
+        hyp_mem_free(block->data);
+        model[block->tag].frees++;
+        model[block->tag].live -= block->size;
+        block->data = NULL;
+    }
+}
+
+/* Each task makes its blocks, frees every other one and leaves the rest
+ * for the main thread */
+static void thread_task(void* context, size_t index, size_t worker) {
+    (void)context;
+    (void)worker;
+    block_t* made = thread_blocks[index];
+    for (size_t i = 0; i < THREAD_BLOCKS; i++) {
+        made[i].size = 1 + (i * 37 + index) % 3000;
+        made[i].fill = (unsigned char)(index + 1);
+        made[i].data = hyp_mem_alloc(made[i].size, HYP_MEM_PARSER);
+        if (made[i].data) memset(made[i].data, made[i].fill, made[i].size);
+    }
+    for (size_t i = 0; i < THREAD_BLOCKS; i += 2) {
+        hyp_mem_free(made[i].data);
+        made[i].data = NULL;
+    }
+}
+
+int main(void) {
+    hyp_mem_init();
+    hyp_mem_stats(&start);
+    counted = start.tracked;
+    printf("allocator: %s, counted: %s\n", start.allocator, counted ? "yes" : "no");
+
+    size_t steps = 200000;
+    for (size_t step = 1; step <= steps; step++) {
+        step_once(step);
+        if (step % 1000 == 0) check_counts(step);
+    }
+    for (size_t i = 0; i < BLOCKS; i++) {
+        if (!blocks[i].data) continue;
+        if (!holds(&blocks[i], blocks[i].fill, blocks[i].size)) fail("a block was overwritten", steps);
+        hyp_mem_free(blocks[i].data);
+        model[blocks[i].tag].frees++;
+        model[blocks[i].tag].live -= blocks[i].size;
+    }
+    check_counts(steps);
+
+    /* Made on workers, freed on the main thread */
+    static block_t made[THREAD_TASKS][THREAD_BLOCKS];
+    for (size_t t = 0; t < THREAD_TASKS; t++) thread_blocks[t] = made[t];
+    hyp_parallel_for(THREAD_TASKS, 4, thread_task, NULL);
+    for (size_t t = 0; t < THREAD_TASKS; t++) {
+        for (size_t i = 1; i < THREAD_BLOCKS; i += 2) {
+            if (!made[t][i].data || !holds(&made[t][i], made[t][i].fill, made[t][i].size)) {
+                fail("a worker's block was lost", steps + 1);
+            }
+            hyp_mem_free(made[t][i].data);
+        }
+    }
+
+    /* Everything made has been freed */
+    if (counted) {
+        hyp_mem_stats_t end;
+        hyp_mem_stats(&end);
+        for (int tag = 0; tag < HYP_MEM_TAG_COUNT; tag++) {
+            if (end.tags[tag].live != start.tags[tag].live) fail("bytes left live", steps + 1);
+            if (end.tags[tag].allocations - start.tags[tag].allocations !=
+                end.tags[tag].frees - start.tags[tag].frees) {
+                fail("allocations and frees do not pair up", steps + 1);
+            }
+        }
+    }
+
+    printf("%zu operations and %d worker blocks, %zu failures\n", steps, THREAD_TASKS * THREAD_BLOCKS, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,259 @@
+/**
+ * Drive the arena with random allocations, nested marks, rewinds and
+ * resets, and check it against a model of what should be live: blocks
+ * are aligned, never overlap and keep their contents; the stats add up;
+ * chunks are power-of-two size classes, mapped when asked for and large;
+ * a rewind or reset hands the same memory out again, and free chunks
+ * are reused before new ones are made. Plain and mapped chunks both.
+ *
+ * Usage: hyp_arena
+ */
+
+#include "../../include/hyp_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LIVE 20000
+
+/* Chunk headers take this much of each size class, as the arena lays
+ * chunks out; chunks from 64 KB up are mapped when flags ask for it */
+#define CHUNK_HEADER ((sizeof(hyp_arena_chunk_t) + HYP_ARENA_ALIGN - 1) & ~(size_t)(HYP_ARENA_ALIGN - 1))
+#define MIN_MAPPED (64 * 1024)
+
+#define MAX_MARKS 16
+
+typedef struct {
+    unsigned char* data;
+    size_t size;
+    unsigned char fill;
+} block_t;
+
+static block_t live[MAX_LIVE];
+static size_t live_count;
+
+static struct {
+    hyp_arena_mark_t mark;
+    size_t live_count;
+    size_t used;
+    void* next;                  /* Where the first block after the mark went */
+    size_t next_size;
+} marks[MAX_MARKS];
+static size_t mark_count;
+
+static size_t failures;
+static unsigned seed = 2024;
+
+static void fail(const char* what, size_t step) {
+    if (failures++ < 20) printf("step %zu: %s\n", step, what);
+}
+
+static unsigned next_random(void) {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static size_t aligned(size_t size) {
+    return (size + HYP_ARENA_ALIGN - 1) & ~(size_t)(HYP_ARENA_ALIGN - 1);
+}
+
+static int by_address(const void* a, const void* b) {
+    const block_t* x = a;
+    const block_t* y = b;
+    return x->data < y->data ? -1 : x->data > y->data;
+}
+
+/* Every live block still holds its fill, and none overlaps the next */
+static void check_blocks(size_t step) {
+    static block_t sorted[MAX_LIVE];
+    memcpy(sorted, live, live_count * sizeof(block_t));
+    qsort(sorted, live_count, sizeof(block_t), by_address);
+    for (size_t i = 0; i < live_count; i++) {
+        for (size_t j = 0; j < sorted[i].size; j++) {
+            if (sorted[i].data[j] != sorted[i].fill) {
+                fail("a block was overwritten", step);
+                return;
+            }
+        }
+        if (i + 1 < live_count && sorted[i].data + sorted[i].size > sorted[i + 1].data) {
+            fail("blocks overlap", step);
+            return;
+        }
+    }
+}
+
+/* The stats against the model and against the chunks themselves */
+static void check_stats(const hyp_arena_t* arena, size_t step) {
+    size_t used = 0;
+    for (size_t i = 0; i < live_count; i++) used += aligned(live[i].size);
+
+    hyp_arena_stats_t stats;
+    hyp_arena_stats(arena, &stats);
+    if (stats.used != used) fail("used differs from the live blocks", step);
+
+    size_t reserved = 0;
+    size_t chunks = 0;
+    size_t free_space = arena->current->size - arena->current->used;
+    for (const hyp_arena_chunk_t* chunk = arena->first; chunk; chunk = chunk->next) {
+        reserved += chunk->size;
+        chunks++;
+    }
+    for (const hyp_arena_chunk_t* chunk = arena->current->next; chunk; chunk = chunk->next) {
+        free_space += chunk->size;
+    }
+    if (stats.reserved != reserved || stats.chunks != chunks) fail("reserved or chunks miscounted", step);
+    if (stats.used + stats.wasted + free_space != stats.reserved) fail("used, wasted and free do not add up", step);
+}
+
+/* Chunks with their headers are powers of two, no smaller than the
+ * first, and mapped if they should be */
+static void check_size_classes(const hyp_arena_t* arena, size_t first_total, size_t step) {
+    for (const hyp_arena_chunk_t* chunk = arena->first; chunk; chunk = chunk->next) {
+        size_t total = chunk->size + CHUNK_HEADER;
+        if ((total & (total - 1)) != 0 || total < first_total) {
+            fail("a chunk is not a size class", step);
+            return;
+        }
+#ifndef _WIN32
+        if (chunk->mapped != (arena->flags && total >= MIN_MAPPED)) {
+            fail(chunk->mapped ? "a chunk is mapped" : "a chunk is not mapped", step);
+            return;
+        }
+#endif
+    }
+}
+
+static void* allocate(hyp_arena_t* arena, size_t size, size_t step) {
+    unsigned char* data = hyp_arena_alloc(arena, size);
+    if (!data) {
+        fail("allocation failed", step);
+        return NULL;
+    }
+    if ((uintptr_t)data % HYP_ARENA_ALIGN != 0) fail("misaligned block", step);
+
+    unsigned char fill = (unsigned char)(1 + step % 255);
+    memset(data, fill, size);
+    if (live_count < MAX_LIVE) {
+        live[live_count].data = data;
+        live[live_count].size = size;
+        live[live_count].fill = fill;
+        live_count++;
+    }
+
+    /* The first block after each open mark, however deeply nested */
+    for (size_t i = 0; i < mark_count; i++) {
+        if (!marks[i].next) {
+            marks[i].next = data;
+            marks[i].next_size = size;
+        }
+    }
+    return data;
+}
+
+/* Mostly small blocks, some spanning pages, now and then one larger
+ * than any chunk so far */
+static size_t random_size(void) {
+    unsigned kind = next_random() % 100;
+    if (kind < 80) return next_random() % 200;
+    if (kind < 99) return next_random() % 20000;
+    return 100000 + next_random() % 1000000;
+}
+
+static void run(unsigned flags, size_t steps) {
+    hyp_arena_t* arena = hyp_arena_create_with(1000, flags);
+    if (!arena) {
+        fail("arena not created", 0);
+        return;
+    }
+    size_t first_total = 1024;
+    while (first_total < 1000 + CHUNK_HEADER) first_total *= 2;
+    if (arena->first->size + CHUNK_HEADER != first_total) fail("the first chunk is the wrong size", 0);
+    live_count = 0;
+    mark_count = 0;
+
+    for (size_t step = 1; step <= steps; step++) {
+        unsigned op = next_random() % 1000;
+        if (op < 30 && mark_count < MAX_MARKS) {
+            hyp_arena_stats_t stats;
+            hyp_arena_stats(arena, &stats);
+            marks[mark_count].mark = hyp_arena_mark(arena);
+            marks[mark_count].live_count = live_count;
+            marks[mark_count].used = stats.used;
+            marks[mark_count].next = NULL;
+            mark_count++;
+        } else if (op < 55 && mark_count > 0) {
+            /* Rewound, the first block after the mark comes back */
+            mark_count--;
+            hyp_arena_rewind(arena, marks[mark_count].mark);
+            live_count = marks[mark_count].live_count;
+            hyp_arena_stats_t stats;
+            hyp_arena_stats(arena, &stats);
+            if (stats.used != marks[mark_count].used) fail("rewind did not restore used", step);
+            if (marks[mark_count].next &&
+                allocate(arena, marks[mark_count].next_size, step) != marks[mark_count].next) {
+                fail("rewind did not free the memory after the mark", step);
+            }
+        } else if (op < 57) {
+            /* The same blocks again after a reset land where they did and
+             * need no new chunk */
+            hyp_arena_reset(arena);
+            live_count = 0;
+            mark_count = 0;
+            hyp_arena_stats_t before;
+            hyp_arena_stats(arena, &before);
+            if (before.used != 0 || before.wasted != 0) fail("reset left space in use", step);
+
+            unsigned saved = seed;
+            void* first[8];
+            for (int i = 0; i < 8; i++) first[i] = allocate(arena, random_size(), step);
+            hyp_arena_reset(arena);
+            live_count = 0;
+            seed = saved;
+            for (int i = 0; i < 8; i++) {
+                if (allocate(arena, random_size(), step) != first[i]) fail("reset did not reuse memory", step);
+            }
+            hyp_arena_stats_t after;
+            hyp_arena_stats(arena, &after);
+            if (after.chunks != before.chunks || after.reserved != before.reserved) {
+                fail("reused chunks were not used again", step);
+            }
+        } else {
+            allocate(arena, random_size(), step);
+        }
+
+        check_stats(arena, step);
+        if (step % 500 == 0) {
+            check_blocks(step);
+            check_size_classes(arena, first_total, step);
+        }
+    }
+
+    /* A free chunk with room is taken before a new one is made */
+    hyp_arena_reset(arena);
+    live_count = 0;
+    hyp_arena_stats_t before;
+    hyp_arena_stats(arena, &before);
+    size_t largest = 0;
+    for (const hyp_arena_chunk_t* chunk = arena->first; chunk; chunk = chunk->next) {
+        if (chunk->size > largest) largest = chunk->size;
+    }
+    allocate(arena, largest, steps + 1);
+    hyp_arena_stats_t after;
+    hyp_arena_stats(arena, &after);
+    if (after.chunks != before.chunks) fail("a free chunk with room was not reused", steps + 1);
+
+    char* copy = hyp_arena_strdup(arena, "copied into the arena");
+    if (!copy || strcmp(copy, "copied into the arena") != 0) fail("strdup", steps + 2);
+
+    check_blocks(steps + 2);
+    check_size_classes(arena, first_total, steps + 2);
+    hyp_arena_destroy(arena);
+}
+
+int main(void) {
+    hyp_mem_init();
+    run(0, 20000);
+    run(HYP_ARENA_POPULATE, 5000);
+    printf("plain and mapped arenas checked, %zu failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+/**
+ * Stand-in for an HTTP artifact cache, for tests of the HTTP backend
+ *
+ * Usage: hyp_artifact_server <port-file>
+ *
+ * Listens on 127.0.0.1 on a free port, writes the port to <port-file>
+ * once it accepts connections, and keeps entries in memory. The first
+ * path component picks how the server behaves; the last one names the
+ * entry, so every behaviour sees the same entries:
+ *
+ *   /store/<key>     GET returns the entry or 404
+ *   /truncate/<key>  GET announces the entry's length but sends half
+ *   /corrupt/<key>   GET returns the entry with one byte inverted
+ *   /fail/<key>      every request gets 500
+ *   /quit            stops the server
+ *
+ * PUT stores the entry under every behaviour but fail.
+ *
+ * Each request is logged to stdout. The server gives up after a minute
+ * so a test that dies never leaves it behind.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define MAX_ENTRIES 64
+#define MAX_REQUEST (16 * 1024 * 1024)
+
+typedef struct {
+    char key[128];
+    char* data;
+    size_t size;
+} entry_t;
+
+static entry_t entries[MAX_ENTRIES];
+static size_t entry_count;
+
+static entry_t* find_entry(const char* key) {
+    for (size_t i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].key, key) == 0) return &entries[i];
+    }
+    return NULL;
+}
+
+static void send_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t count = send(fd, data, size, 0);
+        if (count <= 0) return;
+        data += count;
+        size -= (size_t)count;
+    }
+}
+
+/* Status line and headers; body_size is what Content-Length announces */
+static void respond(int fd, int status, size_t body_size) {
+    char header[256];
+    int length = snprintf(header, sizeof(header), "HTTP/1.0 %d %s\r\nContent-Length: %zu\r\n\r\n",
+                          status, status == 200 ? "OK" : status == 201 ? "Created" :
+                          status == 404 ? "Not Found" : "Error", body_size);
+    send_all(fd, header, (size_t)length);
+}
+
+/* Read one request: headers, then as much body as Content-Length says */
+static char* read_request(int fd, size_t* size, char** body) {
+    size_t capacity = 4096;
+    size_t length = 0;
+    char* request = malloc(capacity + 1);
+    size_t expected = 0;
+    *body = NULL;
+
+    while (request) {
+        if (!*body) {
+            request[length] = '\0';
+            char* end = strstr(request, "\r\n\r\n");
+            if (end) {
+                *body = end + 4;
+                const char* announced = strstr(request, "Content-Length:");
+                expected = (size_t)(*body - request) + (announced ? strtoull(announced + 15, NULL, 10) : 0);
+                if (expected > MAX_REQUEST) break;
+            }
+        }
+        if (*body && length >= expected) {
+            *size = length - (size_t)(*body - request);
+            return request;
+        }
+        if (length == capacity) {
+            size_t offset = *body ? (size_t)(*body - request) : 0;
+            char* grown = realloc(request, capacity * 2 + 1);
+            if (!grown) break;
+            request = grown;
+            capacity *= 2;
+            if (*body) *body = request + offset;
+        }
+        ssize_t count = recv(fd, request + length, capacity - length, 0);
+        if (count <= 0) break;
+        length += (size_t)count;
+    }
+    free(request);
+    return NULL;
+}
+
+/* Serve one connection; false once asked to quit */
+static bool serve(int fd) {
+    size_t body_size = 0;
+    char* body;
+    char* request = read_request(fd, &body_size, &body);
+    if (!request) return true;
+
+    char method[8] = "";
+    char path[256] = "";
+    sscanf(request, "%7s %255s", method, path);
+
+    const char* key = strrchr(path, '/');
+    key = key ? key + 1 : path;
+    bool quit = strcmp(path, "/quit") == 0;
+    int status = 400;
+    entry_t* entry = find_entry(key);
+
+    if (quit) {
+        status = 200;
+        respond(fd, status, 0);
+    } else if (strncmp(path, "/fail/", 6) == 0) {
+        status = 500;
+        respond(fd, status, 0);
+    } else if (strcmp(method, "PUT") == 0 && strlen(key) < sizeof(entry->key)) {
+        if (!entry && entry_count < MAX_ENTRIES) {
+            entry = &entries[entry_count++];
+            strcpy(entry->key, key);
+        }
+        char* data = entry ? malloc(body_size ? body_size : 1) : NULL;
+        if (data) {
+            memcpy(data, body, body_size);
+            free(entry->data);
+            entry->data = data;
+            entry->size = body_size;
+            status = 201;
+        } else {
+            status = 500;
+        }
+        respond(fd, status, 0);
+    } else if (strcmp(method, "GET") == 0 && !entry) {
+        status = 404;
+        respond(fd, status, 0);
+    } else if (strcmp(method, "GET") == 0 && strncmp(path, "/store/", 7) == 0) {
+        status = 200;
+        respond(fd, status, entry->size);
+        send_all(fd, entry->data, entry->size);
+    } else if (strcmp(method, "GET") == 0 && strncmp(path, "/truncate/", 10) == 0) {
+        status = 200;
+        respond(fd, status, entry->size);
+        send_all(fd, entry->data, entry->size / 2);
+    } else if (strcmp(method, "GET") == 0 && strncmp(path, "/corrupt/", 9) == 0) {
+        status = 200;
+        respond(fd, status, entry->size);
+        if (entry->size > 0) entry->data[entry->size - 1] ^= 0xff;
+        send_all(fd, entry->data, entry->size);
+        if (entry->size > 0) entry->data[entry->size - 1] ^= 0xff;
+    } else {
+        respond(fd, status, 0);
+    }
+
+    printf("%s %s %d\n", method, path, status);
+    fflush(stdout);
+    free(request);
+    return !quit;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <port-file>\n", argv[0]);
+        return 2;
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_size = sizeof(address);
+    if (listener < 0 || bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(listener, 16) != 0 || getsockname(listener, (struct sockaddr*)&address, &address_size) != 0) {
+        fprintf(stderr, "Error: Could not listen on 127.0.0.1\n");
+        return 1;
+    }
+
+    /* Write the port under a temporary name, so it is never read half written */
+    char temp_path[4096];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", argv[1]);
+    FILE* port_file = fopen(temp_path, "w");
+    if (!port_file || fprintf(port_file, "%d", ntohs(address.sin_port)) < 0 ||
+        fclose(port_file) != 0 || rename(temp_path, argv[1]) != 0) {
+        fprintf(stderr, "Error: Could not write '%s'\n", argv[1]);
+        return 1;
+    }
+
+    alarm(60);
+    bool running = true;
+    while (running) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) continue;
+        running = serve(fd);
+        close(fd);
+    }
+
+    close(listener);
+    for (size_t i = 0; i < entry_count; i++) free(entries[i].data);
+    return 0;
+}
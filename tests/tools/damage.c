@@ -0,0 +1,31 @@
+/**
+ * Invert one byte of a file in place, for tests of damaged caches
+ *
+ * Usage: hyp_damage <file> <offset>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <file> <offset>\n", argv[0]);
+        return 2;
+    }
+
+    FILE* file = fopen(argv[1], "r+b");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open '%s'\n", argv[1]);
+        return 1;
+    }
+
+    long offset = strtol(argv[2], NULL, 10);
+    int byte = fseek(file, offset, SEEK_SET) == 0 ? fgetc(file) : EOF;
+    bool ok = byte != EOF && fseek(file, offset, SEEK_SET) == 0 && fputc(byte ^ 0xff, file) != EOF;
+    if (fclose(file) != 0 || !ok) {
+        fprintf(stderr, "Error: Could not change byte %ld of '%s'\n", offset, argv[1]);
+        return 1;
+    }
+    return 0;
+}
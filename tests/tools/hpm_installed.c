@@ -0,0 +1,68 @@
+/**
+ * Write a lock file, load it into hpm's installed-packages map and look
+ * packages up, for the test of the map
+ *
+ * Usage: hyp_hpm_installed (in an empty directory)
+ */
+
+#include "../../include/hpm.h"
+#include <stdio.h>
+
+static void show(hpm_context_t* hpm, const char* name) {
+    const hpm_installed_t* installed = hpm_find_installed(hpm, name);
+    if (!installed) {
+        printf("%s: not installed\n", name);
+        return;
+    }
+    char* version = hpm_version_to_string(&installed->version);
+    printf("%s: %s in %s\n", name, version, installed->path);
+    HYP_FREE(version);
+}
+
+int main(void) {
+    hyp_mem_init();
+
+    /* A later line for a name replaces an earlier one; enough packages
+     * to grow the table several times */
+    FILE* lock = fopen("package-lock.yml", "w");
+    if (!lock) {
+        fprintf(stderr, "Error: Could not write package-lock.yml\n");
+        return 1;
+    }
+    fprintf(lock, "# Installed packages\npackages:\n");
+    fprintf(lock, "  http: 4.17.0\n  zlib: \"1.3.1\"\n  alpha: 2.0.0-beta.1+exp  # pinned\n");
+    for (int i = 0; i < 200; i++) fprintf(lock, "  pkg-%d: 1.%d.0\n", i, i);
+    fprintf(lock, "  http: 4.18.0\n\nnot a package\n");
+    fclose(lock);
+
+    hpm_context_t* hpm = hpm_create();
+    if (!hpm || hpm_load_lock(hpm, NULL) != HYP_OK) {
+        fprintf(stderr, "Error: %s\n", hpm ? hpm_get_error(hpm) : "Could not create the package manager");
+        return 1;
+    }
+
+    printf("%zu packages\n", HYP_MAP_COUNT(&hpm->installed));
+    show(hpm, "http");
+    show(hpm, "alpha");
+    show(hpm, "pkg-0");
+    show(hpm, "pkg-199");
+    show(hpm, "pkg-200");
+    show(hpm, "packages");
+
+    /* Listing reads the lock file again; nothing is added twice */
+    remove("package-lock.yml");
+    lock = fopen("package-lock.yml", "w");
+    if (!lock) return 1;
+    fprintf(lock, "zlib: 1.3.2\nhttp: 4.18.0\n");
+    fclose(lock);
+    hpm_destroy(hpm);
+
+    hpm = hpm_create();
+    if (!hpm || hpm_list(hpm, false) != HYP_OK) return 1;
+    printf("%zu packages\n", HYP_MAP_COUNT(&hpm->installed));
+    hpm_list(hpm, false);
+    printf("%zu packages\n", HYP_MAP_COUNT(&hpm->installed));
+
+    hpm_destroy(hpm);
+    return 0;
+}
@@ -0,0 +1,42 @@
+/**
+ * Record more runs than hpx keeps and print the history, for the test
+ * of its bounded deque
+ *
+ * Usage: hyp_hpx_history
+ */
+
+#include "../../include/hpx.h"
+#include <stdio.h>
+
+int main(void) {
+    hyp_mem_init();
+
+    hpx_context_t* hpx = hpx_create();
+    if (!hpx) {
+        fprintf(stderr, "Error: Could not create the package executor\n");
+        return 1;
+    }
+
+    /* Enough runs to wrap the ring, some without a command */
+    char package[32];
+    for (int i = 1; i <= HPX_HISTORY_LIMIT + 8; i++) {
+        snprintf(package, sizeof(package), "tool-%d", i);
+        if (hpx_add_to_history(hpx, package, i % 3 ? "build" : NULL, i % 5) != HYP_OK) {
+            fprintf(stderr, "Error: Could not record run %d\n", i);
+            return 1;
+        }
+    }
+
+    printf("All %zu runs:\n", hpx->history.count);
+    hpx_show_history(hpx, 0);
+    printf("Last 3:\n");
+    hpx_show_history(hpx, 3);
+
+    hpx_clear_history(hpx);
+    printf("After clearing: %zu\n", hpx->history.count);
+    hpx_add_to_history(hpx, "again", "start", 0);
+    hpx_show_history(hpx, 0);
+
+    hpx_destroy(hpx);
+    return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * Check the lexer's keyword hash against the language's keyword list:
+ * every keyword is found, both by lookup and when scanned, and every
+ * other word is an identifier. Words are every string of up to four
+ * letters, plus each keyword cut short, extended and with each
+ * character changed.
+ *
+ * Usage: hyp_keywords
+ */
+
+#include "../../include/lexer.h"
+#include <stdio.h>
+#include <string.h>
+
+static const struct {
+    const char* word;
+    hyp_token_type_t type;
+} keywords[] = {
+    {"let", TOKEN_LET}, {"const", TOKEN_CONST}, {"fn", TOKEN_FUNC}, {"if", TOKEN_IF},
+    {"else", TOKEN_ELSE}, {"while", TOKEN_WHILE}, {"for", TOKEN_FOR}, {"in", TOKEN_IN},
+    {"return", TOKEN_RETURN}, {"break", TOKEN_BREAK}, {"continue", TOKEN_CONTINUE},
+    {"import", TOKEN_IMPORT}, {"export", TOKEN_EXPORT}, {"struct", TOKEN_STRUCT},
+    {"enum", TOKEN_ENUM}, {"match", TOKEN_MATCH}, {"case", TOKEN_CASE},
+    {"default", TOKEN_DEFAULT}, {"module", TOKEN_MODULE}, {"true", TOKEN_TRUE},
+    {"false", TOKEN_FALSE}, {"null", TOKEN_NULL}, {"throw", TOKEN_THROW},
+    {"async", TOKEN_ASYNC}, {"await", TOKEN_AWAIT}, {"try", TOKEN_TRY},
+    {"catch", TOKEN_CATCH}, {"finally", TOKEN_FINALLY}, {"state", TOKEN_STATE},
+    {"and", TOKEN_AND}, {"or", TOKEN_OR}, {"not", TOKEN_NOT},
+};
+
+#define KEYWORD_COUNT (sizeof(keywords) / sizeof(keywords[0]))
+
+static size_t checked;
+static size_t failures;
+
+static hyp_token_type_t expected_type(const char* word) {
+    for (size_t i = 0; i < KEYWORD_COUNT; i++) {
+        if (strcmp(keywords[i].word, word) == 0) return keywords[i].type;
+    }
+    return TOKEN_IDENTIFIER;
+}
+
+/* Look the word up, and scan it as the only token of a source */
+static void check(const char* word) {
+    hyp_token_type_t expected = expected_type(word);
+    hyp_token_type_t looked_up = hyp_lexer_lookup_keyword(word);
+
+    hyp_lexer_t* lexer = hyp_lexer_create(word, "keywords");
+    hyp_token_t token = hyp_lexer_next_token(lexer);
+    hyp_token_type_t scanned = token.type;
+    hyp_lexer_destroy(lexer);
+
+    checked++;
+    if (looked_up != expected || scanned != expected) {
+        if (failures++ < 20) {
+            printf("'%s': expected %d, looked up %d, scanned %d\n", word, (int)expected,
+                   (int)looked_up, (int)scanned);
+        }
+    }
+}
+
+/* Every word of the given length over a-z */
+static void check_all(char* word, size_t position, size_t length) {
+    if (position == length) {
+        word[length] = '\0';
+        check(word);
+        return;
+    }
+    for (char c = 'a'; c <= 'z'; c++) {
+        word[position] = c;
+        check_all(word, position + 1, length);
+    }
+}
+
+int main(void) {
+    hyp_mem_init();
+    char word[16];
+
+    for (size_t length = 1; length <= 4; length++) {
+        check_all(word, 0, length);
+    }
+
+    static const char replacements[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+    for (size_t i = 0; i < KEYWORD_COUNT; i++) {
+        const char* keyword = keywords[i].word;
+        size_t length = strlen(keyword);
+
+        for (size_t cut = 1; cut < length; cut++) {
+            memcpy(word, keyword, cut);
+            word[cut] = '\0';
+            check(word);
+        }
+        for (size_t r = 0; r < sizeof(replacements) - 1; r++) {
+            snprintf(word, sizeof(word), "%s%c", keyword, replacements[r]);
+            check(word);
+            for (size_t at = 0; at < length; at++) {
+                /* A digit cannot start an identifier */
+                if (at == 0 && replacements[r] >= '0' && replacements[r] <= '9') continue;
+                strcpy(word, keyword);
+                word[at] = replacements[r];
+                check(word);
+            }
+        }
+    }
+
+    printf("%zu keywords, %zu words checked, %zu failures\n", KEYWORD_COUNT, checked, failures);
+    return failures == 0 ? 0 : 1;
+}
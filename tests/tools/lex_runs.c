@@ -0,0 +1,179 @@
+/**
+ * Check the lexer's wide scans against positions worked out by hand.
+ * Runs of whitespace, comment text, string contents and identifier
+ * characters of every length up to a few vectors are placed at every
+ * alignment, and the token after each run must start where the run ends
+ * with the right line and column, both from hyp_lexer_next_token and
+ * from hyp_lexer_tokenize. Each run is also placed at the very end of
+ * the source, where the scan has to stop at the terminator.
+ *
+ * Usage: hyp_lex_runs
+ */
+
+#include "../../include/lexer.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_RUN 100
+#define MAX_SHIFT 34
+
+/* Character i of a repeating pattern */
+#define PATTERN(text, i) ((text)[(i) % (sizeof(text) - 1)])
+
+typedef enum {
+    RUN_WHITESPACE,
+    RUN_LINE_COMMENT,
+    RUN_BLOCK_COMMENT,
+    RUN_STRING,
+    RUN_IDENTIFIER,
+    RUN_KINDS
+} run_kind_t;
+
+static const char* kind_names[RUN_KINDS] = {
+    "whitespace", "line comment", "block comment", "string", "identifier"
+};
+
+static size_t checked;
+static size_t failures;
+
+static void fail(run_kind_t kind, size_t length, size_t shift, bool at_end, const char* what) {
+    if (failures++ < 20) {
+        printf("%s of %zu bytes after %zu%s: %s\n", kind_names[kind], length, shift,
+               at_end ? " at the end" : "", what);
+    }
+}
+
+/* Build the run's source text; returns where the token after it starts */
+static size_t build(char* source, run_kind_t kind, size_t length, size_t shift, bool at_end) {
+    /* Semicolons shift the run without joining it */
+    size_t n = 0;
+    for (size_t i = 0; i < shift; i++) source[n++] = ';';
+
+    switch (kind) {
+        case RUN_WHITESPACE:
+            for (size_t i = 0; i < length; i++) source[n++] = PATTERN(" \t \n  \r\n ", i);
+            break;
+        case RUN_LINE_COMMENT:
+            source[n++] = '/';
+            source[n++] = '/';
+            for (size_t i = 0; i < length; i++) source[n++] = PATTERN("text, /* */ \"x\" 42\t", i);
+            if (!at_end) source[n++] = '\n';
+            break;
+        case RUN_BLOCK_COMMENT:
+            source[n++] = '/';
+            source[n++] = '*';
+            for (size_t i = 0; i < length; i++) source[n++] = PATTERN("a * /\nb// \" *", i);
+            source[n++] = '*';
+            source[n++] = '/';
+            break;
+        case RUN_STRING:
+            source[n++] = '"';
+            for (size_t i = 0; i < length; i++) source[n++] = PATTERN("words and // /* */ 'q'", i);
+            source[n++] = '"';
+            break;
+        case RUN_IDENTIFIER:
+            for (size_t i = 0; i < length; i++) source[n++] = PATTERN("n_ame9Z", i);
+            if (!at_end) source[n++] = ' ';
+            break;
+        default:
+            break;
+    }
+
+    /* Newlines after the token keep a scan that overshoots from going
+     * unnoticed */
+    size_t after = n;
+    if (!at_end) {
+        memcpy(source + n, "end\n;\n", 7);
+        n += 7;
+    }
+    source[n] = '\0';
+    return after;
+}
+
+/* Line of an offset, and the offset its line starts at */
+static size_t line_of(const char* source, size_t offset, size_t* line_start) {
+    size_t line = 1;
+    *line_start = 0;
+    for (size_t i = 0; i < offset; i++) {
+        if (source[i] == '\n') {
+            line++;
+            *line_start = i + 1;
+        }
+    }
+    return line;
+}
+
+static void check(run_kind_t kind, size_t length, size_t shift, bool at_end) {
+    static char source[MAX_SHIFT + MAX_RUN + 32];
+    size_t after = build(source, kind, length, shift, at_end);
+    size_t source_length = strlen(source);
+    size_t line_start;
+    size_t line = line_of(source, after, &line_start);
+    checked++;
+
+    /* One token at a time: the token's column is the one just past it */
+    hyp_lexer_t* lexer = hyp_lexer_create(source, "runs");
+    hyp_token_t token;
+    size_t run_token_start = SIZE_MAX;
+    do {
+        token = hyp_lexer_next_token(lexer);
+        if (kind >= RUN_STRING && token.position == shift) run_token_start = token.position;
+    } while (token.type != TOKEN_EOF && token.type != TOKEN_ERROR &&
+             (at_end || token.type != TOKEN_IDENTIFIER || token.position != after ||
+              strncmp(token.lexeme.data, "end", 3) != 0));
+
+    if (token.type == TOKEN_ERROR) {
+        fail(kind, length, shift, at_end, "error token");
+    } else if (at_end && token.type != TOKEN_EOF) {
+        fail(kind, length, shift, at_end, "no end of input");
+    } else if (!at_end && (token.line != line || token.column != after + 3 - line_start + 1)) {
+        fail(kind, length, shift, at_end, "wrong line or column after the run");
+    } else if (kind >= RUN_STRING && length > 0 && run_token_start != shift) {
+        fail(kind, length, shift, at_end, "the run is not one token");
+    }
+    hyp_lexer_destroy(lexer);
+
+    /* Whole source at once: offsets and lengths, and the location lookup */
+    lexer = hyp_lexer_create_with_length(source, source_length, "runs");
+    if (!lexer || hyp_lexer_tokenize(lexer) != HYP_OK) {
+        fail(kind, length, shift, at_end, "tokenize failed");
+        hyp_lexer_destroy(lexer);
+        return;
+    }
+    const hyp_token_array_t* tokens = &lexer->tokens;
+    size_t last = tokens->count - 1;
+    size_t run_index = shift;   /* One token per semicolon before it */
+    size_t expected_length = kind == RUN_STRING ? length + 2 : length;
+    if ((kind == RUN_STRING || (kind == RUN_IDENTIFIER && length > 0)) &&
+        (hyp_token_start(tokens, run_index) != shift || tokens->lengths[run_index] != expected_length)) {
+        fail(kind, length, shift, at_end, "tokenize: wrong run token");
+    }
+    if (tokens->types[last] != TOKEN_EOF) {
+        fail(kind, length, shift, at_end, "tokenize: no end of input");
+    } else if (!at_end) {
+        size_t found_line = 0;
+        size_t found_column = 0;
+        hyp_lexer_location(lexer, hyp_token_start(tokens, last - 2), &found_line, &found_column);
+        if (hyp_token_start(tokens, last - 2) != after || found_line != line ||
+            found_column != after - line_start + 1) {
+            fail(kind, length, shift, at_end, "tokenize: wrong location after the run");
+        }
+    }
+    hyp_lexer_destroy(lexer);
+}
+
+int main(void) {
+    hyp_mem_init();
+
+    for (int kind = 0; kind < RUN_KINDS; kind++) {
+        for (size_t length = 0; length <= MAX_RUN; length++) {
+            for (size_t shift = 0; shift <= MAX_SHIFT; shift++) {
+                check((run_kind_t)kind, length, shift, false);
+                check((run_kind_t)kind, length, shift, true);
+            }
+        }
+    }
+
+    printf("%zu runs checked, %zu failures\n", checked, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+/**
+ * Check number parsing and formatting against the C library. Formatted
+ * numbers must read back through strtod as the same bits and be as
+ * short as that allows; parsed decimals must be the double strtod gives
+ * and consume the same text. Doubles are drawn from every exponent,
+ * decimals from every digit count and exponent the format can reach,
+ * and a table of edge cases covers halfway ties, subnormals, the ends
+ * of the range and where parsing stops.
+ *
+ * Usage: hyp_number_round_trip
+ */
+
+#include "../../include/hyp_number.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+static size_t failures;
+
+static void fail(const char* what, const char* text) {
+    if (failures++ < 20) printf("%s: %s\n", what, text);
+}
+
+static bool same_bits(double a, double b) {
+    return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+/* 64 random bits */
+static uint64_t next_random(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/* Significant digits in formatted text */
+static int count_digits(const char* text) {
+    int digits = 0;
+    bool leading = true;
+    for (const char* p = text; *p && *p != 'e'; p++) {
+        if (*p < '0' || *p > '9') continue;
+        if (*p != '0') leading = false;
+        if (!leading) digits++;
+    }
+    /* Trailing zeros of an integer are layout, not digits */
+    if (!strchr(text, '.') && !strchr(text, 'e')) {
+        for (size_t n = strlen(text); n > 0 && text[n - 1] == '0' && digits > 1; n--) digits--;
+    }
+    return digits;
+}
+
+/* Format, read back and try one digit fewer */
+static void check_format(double value) {
+    char text[HYP_NUMBER_BUFFER_SIZE];
+    size_t length = hyp_number_format(value, text);
+    if (length != strlen(text) || length >= HYP_NUMBER_BUFFER_SIZE) {
+        fail("format length", text);
+        return;
+    }
+
+    double read = strtod(text, NULL);
+    if (!same_bits(read, value) && !(value == 0 && read == 0)) {
+        fail("format does not read back", text);
+        return;
+    }
+
+    int digits = count_digits(text);
+    if (digits > 1) {
+        char shorter[64];
+        snprintf(shorter, sizeof(shorter), "%.*e", digits - 2, value);
+        if (strtod(shorter, NULL) == value) fail("format is not the shortest", text);
+    }
+}
+
+/* Parse against strtod, for the whole text and cut short */
+static void check_parse(const char* text) {
+    size_t length = strlen(text);
+    double value = 0;
+    size_t consumed = hyp_number_parse(text, length, &value);
+    char* end = NULL;
+    double expected = strtod(text, &end);
+    if (consumed != (size_t)(end - text)) {
+        fail("parse stops in the wrong place", text);
+    } else if (consumed && !same_bits(value, expected)) {
+        fail("parse differs from strtod", text);
+    }
+
+    /* The text need not be terminated: a prefix parses as itself */
+    if (length > 1) {
+        char prefix[1024];
+        size_t cut = length / 2;
+        memcpy(prefix, text, cut);
+        prefix[cut] = '\0';
+        consumed = hyp_number_parse(text, cut, &value);
+        expected = strtod(prefix, &end);
+        if (consumed != (size_t)(end - prefix) || (consumed && !same_bits(value, expected))) {
+            fail("parse reads past its length", text);
+        }
+    }
+}
+
+int main(void) {
+    /* How the fixed layout prints */
+    static const struct {
+        const char* name;
+        double value;
+    } shown[] = {
+        {"0", 0.0}, {"-0", -0.0}, {"0.1", 0.1}, {"1e-6", 0.000001}, {"1e-7", 1e-7}, {"1.5e-7", 1.5e-7},
+        {"100", 100}, {"1e20", 1e20}, {"1e21", 1e21}, {"123456789012345678", 123456789012345678.0},
+        {"-2.5", -2.5}, {"smallest subnormal", 5e-324}, {"smallest normal", 2.2250738585072014e-308},
+        {"largest", 1.7976931348623157e308}, {"NaN", NAN}, {"infinity", INFINITY}, {"-infinity", -INFINITY},
+    };
+    for (size_t i = 0; i < sizeof(shown) / sizeof(shown[0]); i++) {
+        char text[HYP_NUMBER_BUFFER_SIZE];
+        hyp_number_format(shown[i].value, text);
+        printf("%s: %s\n", shown[i].name, text);
+        if (isfinite(shown[i].value)) check_format(shown[i].value);
+    }
+
+    static const char* const edges[] = {
+        "0", "-0", "+1", "00012", ".5", "5.", "1e", "1e+", "1e5x", "-", "-.e1", "1.2.3", "1_000",
+        "9007199254740993", "9007199254740995", "4.9406564584124654e-324", "2.4703282292062327e-324",
+        "2.4703282292062328e-324", "2.2250738585072011e-308", "2.2250738585072012e-308",
+        "1.7976931348623157e308", "1.7976931348623158e308", "1.8e308", "1e-400", "1e400",
+        "1.00000000000000011102230246251565404236316680908203125",
+        "1.00000000000000011102230246251565404236316680908203126",
+        "0.000000000000000000000000000000000000000000000000000000000000000000000000000001",
+        "123456789012345678901234567890123456789012345678901234567890e-30",
+        "7.2057594037927933e16", "1e23", "8.98846567431158e307",
+    };
+    size_t checked = 0;
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++, checked++) check_parse(edges[i]);
+
+    uint64_t state = 0x9e3779b97f4a7c15u;
+    for (int i = 0; i < 300000; i++, checked++) {
+        /* Any finite double, every exponent equally likely */
+        uint64_t bits = next_random(&state);
+        double value;
+        memcpy(&value, &bits, sizeof(double));
+        if (isfinite(value)) check_format(value);
+
+        /* Decimals of up to 25 digits with a point anywhere in them */
+        char text[64];
+        int digits = 1 + (int)(next_random(&state) % 25);
+        int point = (int)(next_random(&state) % (uint64_t)(digits + 1));
+        size_t n = 0;
+        if (next_random(&state) % 2) text[n++] = '-';
+        for (int d = 0; d < digits; d++) {
+            if (d == point && d > 0) text[n++] = '.';
+            text[n++] = (char)('0' + next_random(&state) % 10);
+        }
+        snprintf(text + n, sizeof(text) - n, "e%d", (int)(next_random(&state) % 700) - 350);
+        check_parse(text);
+
+        /* Parsed text that was formatted reads back the same */
+        char formatted[HYP_NUMBER_BUFFER_SIZE];
+        double parsed = 0;
+        if (isfinite(value)) {
+            size_t length = hyp_number_format(value, formatted);
+            if (hyp_number_parse(formatted, length, &parsed) != length ||
+                (!same_bits(parsed, value) && !(value == 0 && parsed == 0))) {
+                fail("formatted text parses differently", formatted);
+            }
+        }
+    }
+
+    printf("%zu values formatted and parsed, %zu failures\n", checked, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/**
+ * Drive the chunked output buffer with writes of every size, kept in
+ * memory, streamed to a file and appended from one buffer to another,
+ * and check each result against the same text built with plain C
+ *
+ * Usage: hyp_out_writer (in an empty directory)
+ */
+
+#include "../../include/hyp_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+    #define O_BINARY 0
+#endif
+
+/* The expected text */
+static char* reference;
+static size_t reference_length;
+
+static void reference_write(const char* data, size_t size) {
+    memcpy(reference + reference_length, data, size);
+    reference_length += size;
+}
+
+/* Numbers with the text the generator must write for them */
+static const struct {
+    double value;
+    const char* text;
+} numbers[] = {
+    { 0.0, "0" }, { 3.0, "3" }, { 0.1, "0.1" }, { 1.5e-7, "1.5e-7" }, { 1e21, "1e+21" },
+    { 123456789012345678.0, "123456789012345680.0" }, { -2.5, "-2.5" }, { INFINITY, "(1e308 * 10)" },
+};
+
+/* The same mix of writes each time: small literals, printf, integers,
+ * numbers, blocks up to past the largest chunk, and formatted text sized
+ * to end just before, at or just after the end of the current chunk.
+ * Chunk boundaries differ between memory and file output, so the
+ * expected text is rebuilt on every call */
+static void write_all(hyp_out_t* out) {
+    unsigned seed = 12345;
+    reference_length = 0;
+    static char block[HYP_OUT_MAX_CHUNK + 1000];
+    for (size_t i = 0; i < sizeof(block); i++) block[i] = (char)('a' + i % 26);
+
+    for (int i = 0; i < 3000; i++) {
+        seed = seed * 1103515245 + 12345;
+        char text[64];
+        switch ((seed >> 16) % 6) {
+            case 0:
+                HYP_OUT_LITERAL(out, "hyprt_value_t ");
+                reference_write("hyprt_value_t ", 14);
+                break;
+            case 1:
+                hyp_out_printf(out, "hyp_tmp[%d] = %s;\n", i, "x");
+                reference_write(text, (size_t)snprintf(text, sizeof(text), "hyp_tmp[%d] = %s;\n", i, "x"));
+                break;
+            case 2:
+                hyp_out_write_uint(out, (uint64_t)seed * seed);
+                reference_write(text, (size_t)snprintf(text, sizeof(text), "%llu",
+                                                                   (unsigned long long)((uint64_t)seed * seed)));
+                break;
+            case 3: {
+                size_t n = (seed >> 8) % (sizeof(numbers) / sizeof(numbers[0]));
+                hyp_out_write_double(out, numbers[n].value);
+                reference_write(numbers[n].text, strlen(numbers[n].text));
+                break;
+            }
+            case 4: {
+                /* Mostly short blocks, now and then one larger than a chunk */
+                size_t size = (seed >> 4) % 97 == 0 ? sizeof(block) - (seed % 500) : (seed >> 4) % 5000;
+                hyp_out_write(out, block, size);
+                reference_write(block, size);
+                break;
+            }
+            default: {
+                size_t space = out->tail ? out->tail->capacity - out->tail->length : 0;
+                int size = (int)(space % 4000) + (int)(seed >> 4) % 3 - 1;
+                if (size < 0) size = 0;
+                hyp_out_printf(out, "%.*s", size, block);
+                reference_write(block, (size_t)size);
+                break;
+            }
+        }
+    }
+}
+
+static bool check(const char* what, const char* text, size_t length) {
+    bool same = length == reference_length && memcmp(text, reference, length) == 0;
+    printf("%s: %s\n", what, same ? "same" : "differs");
+    return same;
+}
+
+int main(void) {
+    hyp_mem_init();
+    reference = malloc(64 * 1024 * 1024);
+    if (!reference) return 1;
+    bool ok = true;
+
+    /* In memory */
+    hyp_out_t memory;
+    hyp_out_init(&memory, -1);
+    write_all(&memory);
+    size_t length = 0;
+    char* text = hyp_out_to_string(&memory, &length);
+    ok &= text && check("memory", text, length) && memory.length == reference_length;
+    HYP_FREE(text);
+
+    /* Streamed to a file as chunks fill */
+    int fd = open("out.c", O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+    hyp_out_t file;
+    hyp_out_init(&file, fd);
+    write_all(&file);
+    ok &= hyp_out_flush(&file) == HYP_OK && file.length == reference_length;
+    close(fd);
+    hyp_out_destroy(&file);
+    text = hyp_read_file("out.c", &length);
+    ok &= text && check("file", text, length);
+    HYP_FREE(text);
+
+    /* Appended: a worker's buffer spliced into memory and into a file */
+    hyp_out_t worker;
+    hyp_out_t combined;
+    hyp_out_init(&worker, -1);
+    hyp_out_init(&combined, -1);
+    write_all(&worker);
+    hyp_out_append(&combined, &worker);
+    text = hyp_out_to_string(&combined, &length);
+    ok &= text && check("appended in memory", text, length) && worker.head == NULL;
+    HYP_FREE(text);
+    hyp_out_destroy(&combined);
+
+    fd = open("appended.c", O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+    hyp_out_init(&worker, -1);
+    hyp_out_init(&combined, fd);
+    write_all(&worker);
+    hyp_out_append(&combined, &worker);
+    ok &= hyp_out_flush(&combined) == HYP_OK;
+    close(fd);
+    hyp_out_destroy(&combined);
+    text = hyp_read_file("appended.c", &length);
+    ok &= text && check("appended to a file", text, length);
+    HYP_FREE(text);
+
+    /* A descriptor that cannot be written fails the buffer */
+    hyp_out_t broken;
+    hyp_out_init(&broken, 1000);
+    write_all(&broken);
+    printf("unwritable: %s\n", hyp_out_flush(&broken) == HYP_ERROR_IO ? "failed" : "not reported");
+    hyp_out_destroy(&broken);
+
+    hyp_out_destroy(&memory);
+    free(reference);
+    return ok ? 0 : 1;
+}
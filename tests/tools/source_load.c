@@ -0,0 +1,168 @@
+/**
+ * Load sources of sizes around a page and around the size from which
+ * files are mapped, and check that each comes back byte for byte with a
+ * zero byte after its end, mapped only if it is large enough, and that
+ * the lexer scans it exactly as it scans a copy. Standard input is read
+ * both from a file and from a pipe, and a missing file is reported.
+ *
+ * Usage: hyp_source_load (in an empty directory)
+ */
+
+#include "../../include/lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+    #define O_BINARY 0
+#endif
+
+/* The loader maps regular files from this size up */
+#define MAP_THRESHOLD (64 * 1024)
+
+static size_t failures;
+
+static void fail(const char* what, size_t size, const char* why) {
+    if (failures++ < 20) printf("%s of %zu bytes: %s\n", what, size, why);
+}
+
+/* Source text with lines, strings, numbers and a NUL byte inside a string */
+static char* generate(size_t size) {
+    static const char pattern[] = "let word_1 = 12.5;\n\"a\0b\" + x // note\n/* c */ y\t";
+    char* text = malloc(size + 1);
+    if (!text) return NULL;
+    for (size_t i = 0; i < size; i++) text[i] = pattern[i % (sizeof(pattern) - 1)];
+    text[size] = '\0';
+    return text;
+}
+
+/* Number of tokens, or SIZE_MAX if the lexer does not end where the text does */
+static size_t count_tokens(const char* text, size_t size) {
+    hyp_lexer_t* lexer = hyp_lexer_create_with_length(text, size, "source");
+    if (!lexer || hyp_lexer_tokenize(lexer) != HYP_OK) {
+        hyp_lexer_destroy(lexer);
+        return SIZE_MAX;
+    }
+    const hyp_token_array_t* tokens = &lexer->tokens;
+    size_t last = tokens->count - 1;
+    size_t count = tokens->types[last] == TOKEN_EOF && hyp_token_start(tokens, last) == size ? tokens->count : SIZE_MAX;
+    hyp_lexer_destroy(lexer);
+    return count;
+}
+
+static void check(const char* what, hyp_source_t* source, const char* expected, size_t size, bool mapped) {
+    /* The copy has its own terminator, as a read source does */
+    char* copy = malloc(size + 1);
+    if (copy) {
+        memcpy(copy, expected, size);
+        copy[size] = '\0';
+    }
+
+    if (!copy) {
+        fail(what, size, "out of memory");
+    } else if (source->size != size) {
+        fail(what, size, "wrong size");
+    } else if (memcmp(source->data, expected, size) != 0) {
+        fail(what, size, "different bytes");
+    } else if (source->mapping && source->mapping_size <= size) {
+        fail(what, size, "the mapping ends with the text");
+    } else if (source->data[size] != '\0') {
+        fail(what, size, "no zero byte after the end");
+    } else if ((source->mapping != NULL) != mapped) {
+        fail(what, size, mapped ? "read, not mapped" : "mapped, not read");
+    } else if (count_tokens(source->data, size) != count_tokens(copy, size)) {
+        fail(what, size, "lexed differently from a copy");
+    }
+    free(copy);
+
+    hyp_source_release(source);
+    if (source->data || source->size || source->mapping) fail(what, size, "not cleared on release");
+}
+
+int main(void) {
+    hyp_mem_init();
+
+    /* Empty, around a page, around the threshold, and ending on page
+     * boundaries beyond it */
+    static const size_t sizes[] = {
+        0, 1, 4095, 4096, 4097, MAP_THRESHOLD - 1, MAP_THRESHOLD, MAP_THRESHOLD + 1,
+        3 * MAP_THRESHOLD, 3 * MAP_THRESHOLD + 4096, 3 * MAP_THRESHOLD + 1, 1024 * 1024,
+    };
+    size_t count = sizeof(sizes) / sizeof(sizes[0]);
+    size_t mapped = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t size = sizes[i];
+        char* text = generate(size);
+        if (!text || hyp_write_file("source.hxp", text, size) != HYP_OK) {
+            fail("file", size, "could not be written");
+            free(text);
+            continue;
+        }
+
+        hyp_source_t source;
+        if (hyp_source_load(&source, "source.hxp") != HYP_OK) {
+            fail("file", size, "load failed");
+        } else {
+#ifdef _WIN32
+            bool map = false;
+#else
+            bool map = size >= MAP_THRESHOLD;
+#endif
+            if (source.mapping) mapped++;
+            check("file", &source, text, size, map);
+        }
+        free(text);
+    }
+
+    /* Standard input redirected from a file larger than the first read */
+    size_t stdin_size = 200000;
+    char* text = generate(stdin_size);
+    int saved = dup(0);
+    int fd = -1;
+    if (text && hyp_write_file("stdin.hxp", text, stdin_size) == HYP_OK) {
+        fd = open("stdin.hxp", O_RDONLY | O_BINARY);
+    }
+    hyp_source_t source;
+    if (fd < 0 || dup2(fd, 0) < 0) {
+        fail("standard input", stdin_size, "could not be redirected");
+    } else if (hyp_source_load(&source, "-") != HYP_OK) {
+        fail("standard input", stdin_size, "load failed");
+    } else {
+        check("standard input", &source, text, stdin_size, false);
+    }
+    if (fd >= 0) close(fd);
+
+    /* Standard input from a pipe, which has no size to go by */
+    size_t pipe_size = 3000;
+    int fds[2];
+#ifdef _WIN32
+    int piped = _pipe(fds, 4096, O_BINARY);
+#else
+    int piped = pipe(fds);
+#endif
+    if (piped != 0 || write(fds[1], text, pipe_size) != (long)pipe_size || close(fds[1]) != 0 || dup2(fds[0], 0) < 0) {
+        fail("pipe", pipe_size, "could not be set up");
+    } else if (hyp_source_load(&source, "-") != HYP_OK) {
+        fail("pipe", pipe_size, "load failed");
+    } else {
+        check("pipe", &source, text, pipe_size, false);
+    }
+    if (piped == 0) close(fds[0]);
+    dup2(saved, 0);
+    close(saved);
+    free(text);
+
+    if (hyp_source_load(&source, "missing.hxp") != HYP_ERROR_NOT_FOUND) {
+        fail("missing file", 0, "not reported as not found");
+    }
+
+    printf("%zu files (%zu mapped), standard input and a pipe loaded, %zu failures\n", count, mapped, failures);
+    return failures == 0 ? 0 : 1;
+}
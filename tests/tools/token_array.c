@@ -0,0 +1,177 @@
+/**
+ * Check the token arrays against the one-token-at-a-time scanner: a
+ * generated source spanning many token blocks is tokenized whole, and
+ * every token's type, offset, length and literal must match what
+ * hyp_lexer_next_token reports. Locations, looked up both in order and
+ * out of order, must match lines and columns counted from the text. The
+ * source is then edited in place, with and without changing the number
+ * of tokens, and the edited arrays must pass the same checks against the
+ * new text.
+ *
+ * Usage: hyp_token_array
+ */
+
+#include "../../include/lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t failures;
+static const char* phase = "tokenized";
+
+static void fail(const char* what, size_t index) {
+    if (failures++ < 20) printf("%s: token %zu: %s\n", phase, index, what);
+}
+
+/* Identifiers, numbers, strings, operators, comments spanning lines and
+ * the odd character the lexer rejects */
+static char* generate(size_t pieces, size_t* length) {
+    static const char* const parts[] = {
+        "alpha", " ", "12", "\n", "\"a string\"", "+=", "0.5e3", "(", ")", "/* one\ntwo */",
+        "beta_2", "\t", "**=", "1e21", "|>", "// note\n", "let", "{", "}", "@", "3.25", ";",
+    };
+    size_t count = sizeof(parts) / sizeof(parts[0]);
+    char* source = malloc(pieces * 16 + 1);
+    if (!source) return NULL;
+
+    size_t n = 0;
+    unsigned seed = 7;
+    for (size_t i = 0; i < pieces; i++) {
+        seed = seed * 1103515245 + 12345;
+        const char* part = parts[(seed >> 16) % count];
+        size_t size = strlen(part);
+        memcpy(source + n, part, size);
+        n += size;
+        source[n++] = ' ';
+    }
+    source[n] = '\0';
+    *length = n;
+    return source;
+}
+
+/* The arrays of a tokenized lexer against the scanner over the same
+ * text, and locations against lines and columns counted from the text */
+static size_t compare_with_scanner(hyp_lexer_t* lexer, const char* source, size_t length) {
+    const hyp_token_array_t* tokens = &lexer->tokens;
+    hyp_lexer_t* scanner = hyp_lexer_create_with_length(source, length, "scanner");
+    size_t* lines = malloc((length + 1) * sizeof(size_t));
+    size_t* columns = malloc((length + 1) * sizeof(size_t));
+    if (!scanner || !lines || !columns) {
+        fail("out of memory", 0);
+        return 0;
+    }
+    for (size_t i = 0, line = 1, column = 1; i <= length; i++) {
+        lines[i] = line;
+        columns[i] = column++;
+        if (source[i] == '\n') {
+            line++;
+            column = 1;
+        }
+    }
+
+    size_t index = 0;
+    for (;; index++) {
+        hyp_token_t token = hyp_lexer_next_token(scanner);
+        if (index >= tokens->count) {
+            fail("the arrays end early", index);
+            break;
+        }
+
+        const hyp_token_literal_t* literal = hyp_lexer_token_literal(lexer, index);
+        if (tokens->types[index] != token.type) fail("type", index);
+        if (hyp_token_start(tokens, index) != token.position) fail("offset", index);
+        /* An error token's text is its message, not the source */
+        bool error = token.type == TOKEN_ERROR;
+        if (!error && tokens->lengths[index] != token.lexeme.length) fail("length", index);
+        if (token.type == TOKEN_NUMBER && (!literal || literal->value.number != token.value.number)) {
+            fail("number value", index);
+        }
+        if (error && (!literal || !literal->value.message || strcmp(literal->value.message, token.lexeme.data) != 0)) {
+            fail("error message", index);
+        }
+        if (token.type != TOKEN_NUMBER && !error && literal) fail("stray literal", index);
+
+        size_t start = hyp_token_start(tokens, index);
+        size_t line = 0;
+        size_t column = 0;
+        hyp_lexer_location(lexer, start, &line, &column);
+        if (start > length || line != lines[start] || column != columns[start]) fail("location in order", index);
+
+        if (token.type == TOKEN_EOF) break;
+    }
+    if (index + 1 != tokens->count) fail("token count", index);
+
+    /* Jumping about has to find the same lines and columns */
+    unsigned seed = 99;
+    for (size_t i = 0; i < tokens->count && i <= index; i++) {
+        seed = seed * 1103515245 + 12345;
+        size_t at = (seed >> 8) % (index + 1);
+        size_t start = hyp_token_start(tokens, at);
+        size_t line = 0;
+        size_t column = 0;
+        hyp_lexer_location(lexer, start, &line, &column);
+        if (start > length || line != lines[start] || column != columns[start]) fail("location out of order", at);
+    }
+
+    free(lines);
+    free(columns);
+    hyp_lexer_destroy(scanner);
+    return index + 1;
+}
+
+/* Replace removed bytes at offset with text, then check the edited arrays */
+static char* edit(const char* name, hyp_lexer_t* lexer, char* source, size_t* length, size_t offset,
+                  size_t removed, const char* text) {
+    size_t inserted = strlen(text);
+    size_t new_length = *length - removed + inserted;
+    char* edited = malloc(new_length + 1);
+    if (!edited) return source;
+    memcpy(edited, source, offset);
+    memcpy(edited + offset, text, inserted);
+    memcpy(edited + offset + inserted, source + offset + removed, *length - offset - removed + 1);
+
+    phase = name;
+    hyp_token_edit_t change;
+    if (hyp_lexer_edit(lexer, edited, new_length, offset, removed, inserted, &change) != HYP_OK) {
+        fail("edit refused", offset);
+    }
+    free(source);
+    *length = new_length;
+    compare_with_scanner(lexer, edited, new_length);
+    return edited;
+}
+
+int main(void) {
+    hyp_mem_init();
+
+    size_t length = 0;
+    char* source = generate(20000, &length);
+    hyp_lexer_t* lexer = source ? hyp_lexer_create_with_length(source, length, "tokens") : NULL;
+    if (!lexer || hyp_lexer_tokenize(lexer) != HYP_OK) {
+        printf("Could not tokenize the generated source\n");
+        return 1;
+    }
+
+    size_t count = compare_with_scanner(lexer, source, length);
+    size_t blocks = (count + HYP_TOKEN_BLOCK - 1) / HYP_TOKEN_BLOCK;
+
+    /* Edits near the start, in the middle and at the end move the tokens
+     * after them, block bases and all */
+    source = edit("insert near the start", lexer, source, &length, 10, 0, "let inserted = 42;\n");
+    source = edit("remove from the middle", lexer, source, &length, length / 2, 40, "");
+    source = edit("replace with lines", lexer, source, &length, length / 3, 5, "/* a comment\nover lines */ 1.5 ");
+    source = edit("append", lexer, source, &length, length, 0, "\nlast 7");
+
+    /* Growing one number keeps the token count, so only the offsets of
+     * the tokens after it move */
+    const hyp_token_array_t* tokens = &lexer->tokens;
+    size_t number = tokens->count / 4;
+    while (tokens->types[number] != TOKEN_NUMBER) number++;
+    source = edit("grow a number", lexer, source, &length, hyp_token_start(tokens, number),
+                  tokens->lengths[number], "98765.25");
+
+    printf("%zu tokens in %zu blocks, 5 edits, %zu failures\n", count, blocks, failures);
+    hyp_lexer_destroy(lexer);
+    free(source);
+    return failures == 0 ? 0 : 1;
+}